@@ -31,10 +31,12 @@ class libhal_micromod_conan(ConanFile):
     options = {
         "platform": ["ANY"],
         "micromod_board": ["ANY"],
+        "eager_initialization": [True, False],
     }
     default_options = {
         "platform": "unspecified",
         "micromod_board": "unspecified",
+        "eager_initialization": False,
     }
 
     python_requires = "libhal-bootstrap/[>=4.3.0 <5]"
@@ -48,13 +50,22 @@ class libhal_micromod_conan(ConanFile):
                 micromod_board == "mod-stm32f1-v4" or
                 micromod_board == "mod-stm32f1-v5"):
             platform_library = "arm-mcu"
+        elif micromod_board == "mod-linux-host":
+            # The host board only needs the interfaces & utilities which are
+            # already provided by the bootstrap library requirements.
+            platform_library = "util"
 
         cmake.configure(variables={
             "LIBHAL_MICROMOD_BOARD": str(self.options.micromod_board),
-            "LIBHAL_PLATFORM_LIBRARY": platform_library
+            "LIBHAL_PLATFORM_LIBRARY": platform_library,
+            "LIBHAL_MICROMOD_EAGER_INIT": bool(
+                self.options.eager_initialization),
         })
 
         cmake.build()
+        if micromod_board == "mod-linux-host":
+            # Unit tests run on the host, see tests/
+            cmake.test()
 
     def requirements(self):
         bootstrap = self.python_requires["libhal-bootstrap"]
@@ -64,6 +75,8 @@ class libhal_micromod_conan(ConanFile):
         micromod_board = str(self.options.micromod_board)
         if micromod_board in arm_mcu_platform:
             self.requires("libhal-arm-mcu/[^1.4.0]", transitive_headers=True)
+        elif micromod_board == "mod-linux-host":
+            pass
         else:
             raise ConanInvalidConfiguration(
                 f"MicroMod Board '{micromod_board}' not supported!")
@@ -71,6 +84,9 @@ class libhal_micromod_conan(ConanFile):
     def package_info(self):
         self.cpp_info.libs = ["libhal-micromod"]
         self.cpp_info.set_property("cmake_target_name", "libhal::micromod")
+        # Selects the board's accessors in <libhal-micromod/concrete.hpp>
+        board_define = str(self.options.micromod_board).upper().replace("-", "_")
+        self.cpp_info.defines = [f"LIBHAL_MICROMOD_BOARD_{board_define}"]
         self.buildenv_info.define("LIBHAL_PLATFORM", "micromod")
         self.buildenv_info.define("LIBHAL_PLATFORM_LIBRARY", "micromod")
 
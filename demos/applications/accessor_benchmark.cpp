@@ -0,0 +1,68 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal-util/steady_clock.hpp>
+
+namespace {
+constexpr std::size_t calls = 10'000;
+
+template<class accessor_t>
+float measure_ticks_per_call(hal::steady_clock& p_clock, accessor_t p_accessor)
+{
+  auto const start = p_clock.uptime();
+  for (std::size_t i = 0; i < calls; i++) {
+    auto& driver = p_accessor();
+    // Prevent the call from being hoisted out of the loop
+    asm volatile("" : : "r"(&driver) : "memory");
+  }
+  auto const ticks = p_clock.uptime() - start;
+  return static_cast<float>(ticks) / static_cast<float>(calls);
+}
+}  // namespace
+
+/**
+ * Measures the cost of calling a board accessor. Build the library with and
+ * without the `eager_initialization` option to compare the static guard check
+ * against eager initialization.
+ */
+void application()
+{
+  using namespace std::chrono_literals;
+  using namespace hal::micromod::v1;
+
+  // Required in eager mode, constructs the pin early otherwise
+  initialize_board<eager_driver::output_g0>();
+
+  auto& clock = uptime_clock();
+  auto& console = hal::micromod::v1::console(hal::buffer<16>);
+  auto const ticks_per_microsecond = clock.frequency() / 1'000'000.0f;
+
+  hal::print(console, "Accessor call benchmark\n");
+
+  while (true) {
+    auto const led_ticks = measure_ticks_per_call(clock, led);
+    auto const gpio_ticks = measure_ticks_per_call(clock, output_g0);
+
+    hal::print<96>(console,
+                   "led() = %lu ticks/call, output_g0() = %lu ticks/call "
+                   "(%lu ticks/us)\n",
+                   static_cast<unsigned long>(led_ticks),
+                   static_cast<unsigned long>(gpio_ticks),
+                   static_cast<unsigned long>(ticks_per_microsecond));
+
+    hal::delay(clock, 1s);
+  }
+}
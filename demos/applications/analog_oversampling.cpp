@@ -0,0 +1,177 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal-util/steady_clock.hpp>
+
+namespace {
+using hal::micromod::analog_channel;
+
+/// Results gathered at each oversampling setting, over at least 32 blocks
+constexpr std::size_t results_wanted = 128;
+
+struct measurement
+{
+  /// Results the hardware produced per second
+  double rate = 0;
+  double mean = 0;
+  /// Standard deviation of the results, in LSBs of the oversampled result
+  double noise = 0;
+  /// Blocks overwritten before they were decimated
+  hal::u32 lost = 0;
+};
+
+/// Decimate blocks of the battery input until enough results are gathered
+measurement measure(hal::steady_clock& p_clock,
+                    hal::micromod::analog_stream& p_inputs)
+{
+  std::array<hal::u32, 64> results{};
+  measurement result;
+  double sum = 0;
+  double sum_of_squares = 0;
+  std::size_t count = 0;
+  hal::u32 first_sequence = 0;
+  hal::u32 last_sequence = 0;
+  hal::u64 first_taken = 0;
+  hal::u64 last_taken = 0;
+
+  // Skip the block that completed before the setting changed
+  static_cast<void>(p_inputs.take());
+  auto const dropped = p_inputs.statistics().dropped;
+  while (count < results_wanted || last_sequence - first_sequence < 32) {
+    auto const block = p_inputs.take();
+    if (block.samples.empty()) {
+      continue;
+    }
+    // Blocks are taken as they complete, so the time between the first & last
+    // one taken spans the blocks completed in between.
+    last_taken = p_clock.uptime();
+    last_sequence = block.sequence;
+    if (first_taken == 0) {
+      first_taken = last_taken;
+      first_sequence = last_sequence;
+    }
+    auto const decimated = hal::micromod::decimate(block,
+                                                   analog_channel::battery,
+                                                   p_inputs.oversampling(),
+                                                   results);
+    if (not p_inputs.intact(block)) {
+      result.lost++;
+      continue;
+    }
+    for (auto const value : std::span(results).first(decimated)) {
+      sum += value;
+      sum_of_squares += static_cast<double>(value) * value;
+    }
+    count += decimated;
+  }
+
+  auto const elapsed = static_cast<double>(last_taken - first_taken) /
+                       static_cast<double>(p_clock.frequency());
+  auto const frames = static_cast<double>(last_sequence - first_sequence) *
+                      static_cast<double>(p_inputs.block_frames());
+  auto const group = static_cast<double>(1U << (2 * p_inputs.oversampling()));
+  result.rate = frames / group / elapsed;
+  result.lost += p_inputs.statistics().dropped - dropped;
+  result.mean = sum / static_cast<double>(count);
+  result.noise = std::sqrt(std::max(
+    (sum_of_squares / static_cast<double>(count)) - (result.mean * result.mean),
+    0.0));
+  return result;
+}
+
+/// Split a value into whole & hundredths for printing without %f
+struct hundredths
+{
+  explicit hundredths(double p_value)
+    : whole(static_cast<unsigned long>(std::lround(p_value * 100.0)) / 100)
+    , fraction(static_cast<unsigned long>(std::lround(p_value * 100.0)) % 100)
+  {
+  }
+
+  unsigned long whole;
+  unsigned long fraction;
+};
+}  // namespace
+
+/**
+ * Steps the analog stream through each oversampling setting & prints the rate
+ * results come at, the noise on the battery input & the effective number of
+ * bits (ENOB) that noise leaves, log2 of full scale over the RMS noise of an
+ * ideal quantizer. The battery input is used as it holds steady where an
+ * unconnected A0 would float; on the STM32F1 boards it is the internal
+ * reference. Oversampling only gains resolution while the input carries at
+ * least an LSB of noise, so ENOB stops growing with the extra bits on a quiet
+ * input.
+ */
+void application()
+{
+  using namespace std::chrono_literals;
+  using namespace hal::micromod;
+
+  auto& clock = v1::uptime_clock();
+  auto& console = v1::console(hal::buffer<16>);
+  auto& inputs = v1::analog_inputs();
+
+  hal::print<96>(console,
+                 "Analog oversampling, %lu frames/s, up to %u extra bits\n",
+                 static_cast<unsigned long>(inputs.frame_rate()),
+                 static_cast<unsigned>(inputs.maximum_oversampling()));
+
+  while (true) {
+    for (hal::u8 bits = 0; bits <= inputs.maximum_oversampling(); bits++) {
+      inputs.oversampling(bits);
+      auto const result = measure(clock, inputs);
+
+      auto const resolution = 12.0 + bits;
+      // Noise under that of the quantizer cannot be resolved
+      auto const enob = std::min(
+        resolution - std::log2(std::max(result.noise * std::sqrt(12.0), 1.0)),
+        resolution);
+      auto const mean = hundredths(result.mean);
+      auto const noise = hundredths(result.noise);
+      auto const bits_effective = hundredths(enob);
+      hal::print<160>(console,
+                      "%u extra bits: %lu results/s (expected %lu), mean "
+                      "%lu.%02lu of %lu, noise %lu.%02lu LSB, ENOB "
+                      "%lu.%02lu, %lu blocks lost\n",
+                      static_cast<unsigned>(bits),
+                      static_cast<unsigned long>(std::lround(result.rate)),
+                      static_cast<unsigned long>(inputs.oversampled_rate()),
+                      mean.whole,
+                      mean.fraction,
+                      static_cast<unsigned long>(
+                        analog_full_scale_oversampled(bits)),
+                      noise.whole,
+                      noise.fraction,
+                      bits_effective.whole,
+                      bits_effective.fraction,
+                      static_cast<unsigned long>(result.lost));
+    }
+    hal::print<64>(console,
+                   "a0() at %u extra bits reads %lu/1000\n\n",
+                   static_cast<unsigned>(inputs.oversampling()),
+                   static_cast<unsigned long>(
+                     std::lround(v1::a0().read() * 1000.0f)));
+    inputs.oversampling(0);
+    hal::delay(clock, 1s);
+  }
+}
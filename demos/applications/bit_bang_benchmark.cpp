@@ -0,0 +1,97 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-util/bit_bang_spi.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal-util/steady_clock.hpp>
+
+namespace {
+unsigned long measure_kbps(hal::steady_clock& p_clock,
+                           hal::spi& p_spi,
+                           std::span<hal::byte const> p_data_out,
+                           std::span<hal::byte> p_data_in)
+{
+  auto const start = p_clock.uptime();
+  p_spi.transfer(p_data_out, p_data_in);
+  auto const ticks = p_clock.uptime() - start;
+  auto const seconds = static_cast<float>(ticks) / p_clock.frequency();
+  auto const bits = static_cast<float>(p_data_out.size() * 8);
+  return static_cast<unsigned long>(bits / seconds / 1000.0f);
+}
+}  // namespace
+
+/**
+ * Compares the generic hal::bit_bang_spi, driving the G5 (SCK), G7 (COPI) & G6
+ * (CIPO) pins through their pin drivers, against the board's spi1() driver.
+ * On boards where spi1() is bit-banged on those same pins, this measures the
+ * speed up of the board's register level bit-bang engine.
+ */
+void application()
+{
+  using namespace std::chrono_literals;
+  using namespace hal::literals;
+
+  auto& clock = hal::micromod::v1::uptime_clock();
+  auto& console = hal::micromod::v1::console(hal::buffer<16>);
+
+  static std::array<hal::byte, 256> data_out{};
+  static std::array<hal::byte, 256> data_in{};
+  for (std::size_t i = 0; i < data_out.size(); i++) {
+    data_out[i] = static_cast<hal::byte>(i);
+  }
+
+  constexpr std::array clock_rates = {
+    100.0_kHz,
+    1.0_MHz,
+    10.0_MHz,
+  };
+
+  hal::print(console, "Bit-bang SPI benchmark\n");
+
+  {
+    hal::bit_bang_spi generic_spi(
+      hal::bit_bang_spi::pins{
+        .sck = &hal::micromod::v1::output_g5(),
+        .copi = &hal::micromod::v1::output_g7(),
+        .cipo = &hal::micromod::v1::input_g6(),
+      },
+      clock);
+
+    for (auto const clock_rate : clock_rates) {
+      generic_spi.configure({ .clock_rate = clock_rate });
+      hal::print<64>(console,
+                     "generic: requested = %lu kHz, actual = %lu kbit/s\n",
+                     static_cast<unsigned long>(clock_rate / 1000.0f),
+                     measure_kbps(clock, generic_spi, data_out, data_in));
+    }
+  }
+
+  auto& spi1 = hal::micromod::v1::spi1();
+
+  while (true) {
+    for (auto const clock_rate : clock_rates) {
+      spi1.configure({ .clock_rate = clock_rate });
+      hal::print<64>(console,
+                     "spi1: requested = %lu kHz, actual = %lu kbit/s\n",
+                     static_cast<unsigned long>(clock_rate / 1000.0f),
+                     measure_kbps(clock, spi1, data_out, data_in));
+    }
+
+    hal::print(console, "\n");
+    hal::delay(clock, 1s);
+  }
+}
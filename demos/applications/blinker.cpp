@@ -14,20 +14,18 @@
 
 #include <libhal-micromod/micromod.hpp>
 #include <libhal-util/serial.hpp>
-#include <libhal-util/steady_clock.hpp>
 
 void application()
 {
   using namespace std::chrono_literals;
   using namespace hal::literals;
 
-  auto& clock = hal::micromod::v1::uptime_clock();
   auto& led = hal::micromod::v1::led();
 
   while (true) {
     led.level(true);
-    hal::delay(clock, 500ms);
+    hal::micromod::v1::sleep_for(500ms);
     led.level(false);
-    hal::delay(clock, 500ms);
+    hal::micromod::v1::sleep_for(500ms);
   }
 }
@@ -0,0 +1,55 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <array>
+#include <chrono>
+
+#include <libhal-micromod/can_statistics.hpp>
+#include <libhal-micromod/micromod.hpp>
+#include <libhal/units.hpp>
+
+/**
+ * Listens to every message on a 500kbit/s CAN bus, sends a heartbeat every
+ * 100ms and prints the bus statistics once a second, e.g.:
+ *
+ *   can: rx 1204/s, tx 10/s, load 31.8%, tec 0, rec 0, bus off 0, overflow 0
+ */
+void application()
+{
+  using namespace std::chrono_literals;
+
+  auto& console = hal::micromod::v1::console(hal::buffer<128>);
+  auto& clock = hal::micromod::v1::uptime_clock();
+
+  auto& bus_manager = hal::micromod::v1::can_bus_manager();
+  bus_manager.baud_rate(500'000);
+  bus_manager.filter_mode(hal::can_bus_manager::accept::all);
+
+  static std::array<hal::can_message, 32> receive_buffer{};
+  auto& transceiver = hal::micromod::v1::can_transceiver(receive_buffer);
+  bus_manager.bus_on();
+
+  hal::micromod::can_statistics_report report(console, clock, 1s);
+  hal::can_message heartbeat{ .id = 0x700, .length = 1, .payload = { 0x05 } };
+  int tick = 0;
+
+  while (true) {
+    if (tick++ % 10 == 0) {
+      transceiver.send(heartbeat);
+    }
+    report.poll(hal::micromod::v1::can_statistics());
+    hal::micromod::v1::sleep_for(10ms);
+  }
+}
@@ -0,0 +1,109 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+#include <chrono>
+
+#include <libhal-micromod/can_filter_plan.hpp>
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal-util/steady_clock.hpp>
+
+namespace {
+using hal::micromod::can_id_range;
+
+// Messages a body controller listens to on a mixed vehicle bus
+constexpr std::array wanted{
+  can_id_range{ .first = 0x0C0, .last = 0x0C7 },
+  can_id_range{ .first = 0x100, .last = 0x100 },
+  can_id_range{ .first = 0x120, .last = 0x13F },
+  can_id_range{ .first = 0x1A0, .last = 0x1A5 },
+  can_id_range{ .first = 0x244, .last = 0x244 },
+  can_id_range{ .first = 0x3E8, .last = 0x3EF },
+  can_id_range{ .first = 0x510, .last = 0x51A },
+  can_id_range{ .first = 0x7DF, .last = 0x7DF },
+  can_id_range{ .first = 0x7E8, .last = 0x7EF },
+  can_id_range{ .first = 0x18FE'F100, .last = 0x18FE'F1FF, .extended = true },
+  can_id_range{ .first = 0x18FE'EE00, .last = 0x18FE'EE00, .extended = true },
+  can_id_range{ .first = 0x0CF0'0400, .last = 0x0CF0'0403, .extended = true },
+};
+
+// Planned by the compiler, only the filter settings end up in the binary
+constexpr auto plan = hal::micromod::plan_can_filters(wanted);
+static_assert(plan.fits, "wanted identifiers do not fit the CAN filters");
+}  // namespace
+
+/**
+ * Programs the CAN filters from a plan computed at compile time & prints the
+ * plan's report: the settings of each filter, how many unwanted identifiers
+ * each mask filter lets through & the filter banks used.
+ */
+void application()
+{
+  using namespace std::chrono_literals;
+
+  auto& console = hal::micromod::v1::console(hal::buffer<64>);
+  auto& clock = hal::micromod::v1::uptime_clock();
+
+  hal::micromod::v1::can_bus_manager().baud_rate(500'000);
+  hal::micromod::apply_can_filter_plan(plan);
+
+  while (true) {
+    hal::print(console, "CAN filter plan\n");
+    for (std::size_t i = 0; i < plan.identifiers.size(); i++) {
+      if (plan.identifiers[i]) {
+        hal::print<48>(console,
+                       "  id[%u] = 0x%03X\n",
+                       static_cast<unsigned>(i),
+                       unsigned{ *plan.identifiers[i] });
+      }
+    }
+    for (std::size_t i = 0; i < plan.masks.size(); i++) {
+      if (auto const& mask = plan.masks[i]) {
+        hal::print<80>(
+          console,
+          "  mask[%u] = 0x%03X/0x%03X, %lu false positives\n",
+          static_cast<unsigned>(i),
+          unsigned{ mask->id },
+          unsigned{ mask->mask },
+          static_cast<unsigned long>(plan.mask_false_positives[i]));
+      }
+    }
+    for (std::size_t i = 0; i < plan.extended_identifiers.size(); i++) {
+      if (plan.extended_identifiers[i]) {
+        hal::print<48>(
+          console,
+          "  ext_id[%u] = 0x%08lX\n",
+          static_cast<unsigned>(i),
+          static_cast<unsigned long>(*plan.extended_identifiers[i]));
+      }
+    }
+    for (std::size_t i = 0; i < plan.extended_masks.size(); i++) {
+      if (auto const& mask = plan.extended_masks[i]) {
+        hal::print<96>(
+          console,
+          "  ext_mask[%u] = 0x%08lX/0x%08lX, %lu false positives\n",
+          static_cast<unsigned>(i),
+          static_cast<unsigned long>(mask->id),
+          static_cast<unsigned long>(mask->mask),
+          static_cast<unsigned long>(plan.extended_mask_false_positives[i]));
+      }
+    }
+    hal::print<64>(console,
+                   "%u banks, at most %lu false positives\n\n",
+                   static_cast<unsigned>(plan.banks),
+                   static_cast<unsigned long>(plan.false_positives));
+    hal::delay(clock, 5s);
+  }
+}
@@ -0,0 +1,354 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <optional>
+
+#include <libhal-micromod/can_statistics.hpp>
+#include <libhal-micromod/can_transmit_queue.hpp>
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal-util/steady_clock.hpp>
+
+namespace {
+using hal::micromod::can_mailbox_count;
+
+constexpr hal::u32 bus_baud_rate = 500'000;
+constexpr hal::u32 simulated_frames = 20'000;
+/// Low priority messages sent back to back every burst period
+constexpr std::size_t burst_size = 10;
+/// Bit times between bursts, ~60% bus load
+constexpr hal::u64 burst_period = 20 * 135;
+/// Average bit times between urgent messages, ~10% bus load
+constexpr hal::u64 urgent_period = 1200;
+constexpr std::size_t queue_size = 16;
+
+/// The simulation is single threaded, "interrupts" run between steps
+class simulation_lock final : public hal::basic_lock
+{
+private:
+  void os_lock() override
+  {
+  }
+
+  void os_unlock() override
+  {
+  }
+};
+
+/// Clock counting bit times on the simulated bus
+class bit_clock final : public hal::steady_clock
+{
+public:
+  hal::u64 now = 0;
+
+private:
+  hal::hertz driver_frequency() override
+  {
+    return static_cast<hal::hertz>(bus_baud_rate);
+  }
+
+  hal::u64 driver_uptime() override
+  {
+    return now;
+  }
+};
+
+/// Transmit mailboxes of a bxCAN controller with TXFP cleared
+struct mailbox_bank
+{
+  [[nodiscard]] std::optional<std::size_t> free() const
+  {
+    for (std::size_t i = 0; i < loaded.size(); i++) {
+      if (not loaded[i]) {
+        return i;
+      }
+    }
+    return std::nullopt;
+  }
+
+  /// Mailbox that wins arbitration, the lowest identifier
+  [[nodiscard]] std::optional<std::size_t> most_urgent() const
+  {
+    std::optional<std::size_t> winner;
+    for (std::size_t i = 0; i < loaded.size(); i++) {
+      if (loaded[i] &&
+          (not winner || hal::micromod::can_arbitration_key(*loaded[i]) <
+                           hal::micromod::can_arbitration_key(
+                             *loaded[*winner]))) {
+        winner = i;
+      }
+    }
+    return winner;
+  }
+
+  std::array<std::optional<hal::can_message>, can_mailbox_count> loaded{};
+  std::array<bool, can_mailbox_count> abort_requested{};
+};
+
+class simulated_transmitter final : public hal::micromod::can_transmit_queue
+{
+public:
+  simulated_transmitter(std::span<hal::micromod::can_queued_message> p_storage,
+                        hal::steady_clock& p_clock,
+                        hal::basic_lock& p_lock,
+                        mailbox_bank& p_bank)
+    : can_transmit_queue(p_storage, p_clock, p_lock)
+    , m_bank(&p_bank)
+  {
+  }
+
+  /**
+   * @brief Run the transmit interrupt for the aborts requested
+   *
+   * Aborting a mailbox completes at once, unless it is being sent, in which
+   * case the transmission goes on & completes normally.
+   */
+  void complete_aborts(std::optional<std::size_t> p_sending)
+  {
+    bool completed = true;
+    while (completed) {
+      completed = false;
+      for (std::size_t i = 0; i < can_mailbox_count; i++) {
+        if (m_bank->abort_requested[i] && i != p_sending) {
+          m_bank->abort_requested[i] = false;
+          m_bank->loaded[i].reset();
+          mailbox_complete(i, false);
+          completed = true;
+        }
+      }
+    }
+  }
+
+  /// Run the transmit interrupt for a mailbox that was sent
+  void complete_transmission(std::size_t p_mailbox)
+  {
+    m_bank->abort_requested[p_mailbox] = false;
+    m_bank->loaded[p_mailbox].reset();
+    mailbox_complete(p_mailbox, true);
+  }
+
+private:
+  void load_mailbox(std::size_t p_mailbox,
+                    hal::can_message const& p_message) override
+  {
+    m_bank->loaded[p_mailbox] = p_message;
+  }
+
+  void abort_mailbox(std::size_t p_mailbox) override
+  {
+    m_bank->abort_requested[p_mailbox] = true;
+  }
+
+  mailbox_bank* m_bank;
+};
+
+/// Message the application has asked to send, but was not sent yet
+struct outstanding_message
+{
+  hal::can_message message{};
+  hal::u64 arrival = 0;
+  bool urgent = false;
+  /// Handed to the driver, the application is no longer waiting on it
+  bool issued = false;
+};
+
+struct outcome
+{
+  hal::u64 inversions = 0;
+  hal::u64 worst_urgent_latency = 0;
+  hal::micromod::can_transmit_statistics statistics{};
+};
+
+/**
+ * @brief Simulate an application sending bursts of low priority messages &
+ * sporadic urgent ones
+ *
+ * The application sends each message in the order it was asked to, waiting
+ * while the driver has no room for it. A priority inversion is counted each
+ * time a frame wins the bus while a more urgent message is waiting, either in
+ * the driver or in the application.
+ *
+ * @param p_queued - true to send through a can_transmit_queue, false to load
+ * the mailboxes directly
+ */
+outcome simulate(bool p_queued)
+{
+  bit_clock clock;
+  simulation_lock lock;
+  mailbox_bank bank;
+  std::array<hal::micromod::can_queued_message, queue_size> storage{};
+  simulated_transmitter queue(storage, clock, lock, bank);
+
+  std::array<outstanding_message, 64> outstanding{};
+  std::size_t outstanding_count = 0;
+  hal::u32 serial = 0;
+  hal::u32 random = 0x1234'5678;
+  hal::u64 next_burst = 0;
+  hal::u64 next_urgent = urgent_period;
+  hal::u64 sent = 0;
+  outcome result{};
+
+  auto const next_random = [&random]() {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return random;
+  };
+
+  auto const ask = [&](hal::u32 p_id, bool p_urgent) {
+    if (outstanding_count == outstanding.size()) {
+      return;
+    }
+    hal::can_message message{ .id = p_id, .length = 8 };
+    // Tag each message so it can be found once sent
+    for (std::size_t i = 0; i < 4; i++) {
+      message.payload[i] = static_cast<hal::byte>(serial >> (8 * i));
+    }
+    serial++;
+    outstanding[outstanding_count++] = { .message = message,
+                                         .arrival = clock.now,
+                                         .urgent = p_urgent };
+  };
+
+  auto const arrive = [&]() {
+    while (next_burst <= clock.now || next_urgent <= clock.now) {
+      if (next_burst <= next_urgent) {
+        for (std::size_t i = 0; i < burst_size; i++) {
+          ask(0x300 + (serial % 0x100), false);
+        }
+        next_burst += burst_period;
+      } else {
+        ask(0x010 + (next_random() % 0x10), true);
+        next_urgent += 1 + (next_random() % (2 * urgent_period));
+      }
+    }
+  };
+
+  auto const issue = [&]() {
+    for (std::size_t i = 0; i < outstanding_count; i++) {
+      auto& entry = outstanding[i];
+      if (entry.issued) {
+        continue;
+      }
+      if (p_queued) {
+        entry.issued = queue.push(entry.message);
+      } else if (auto const mailbox = bank.free()) {
+        bank.loaded[*mailbox] = entry.message;
+        entry.issued = true;
+      }
+      if (not entry.issued) {
+        return;
+      }
+    }
+  };
+
+  while (sent < simulated_frames) {
+    arrive();
+    issue();
+    if (p_queued) {
+      queue.complete_aborts(std::nullopt);
+    }
+
+    auto const winner = bank.most_urgent();
+    if (not winner) {
+      clock.now = std::min(next_burst, next_urgent);
+      continue;
+    }
+    auto const message = *bank.loaded[*winner];
+    auto const key = hal::micromod::can_arbitration_key(message);
+    auto const waiting = std::span(outstanding).first(outstanding_count);
+    if (std::ranges::any_of(waiting, [key](auto const& p_entry) {
+          return hal::micromod::can_arbitration_key(p_entry.message) < key;
+        })) {
+      result.inversions++;
+    }
+
+    clock.now += hal::micromod::can_frame_bits(message);
+    // Messages asked for during the frame are issued before the transmit
+    // complete interrupt runs
+    arrive();
+    issue();
+    if (p_queued) {
+      queue.complete_aborts(winner);
+      queue.complete_transmission(*winner);
+    } else {
+      bank.loaded[*winner].reset();
+    }
+    sent++;
+
+    auto const asked = std::span(outstanding).first(outstanding_count);
+    auto const found = std::ranges::find_if(asked, [&message](auto& p_entry) {
+      return p_entry.message.payload == message.payload;
+    });
+    if (found->urgent) {
+      result.worst_urgent_latency =
+        std::max(result.worst_urgent_latency, clock.now - found->arrival);
+    }
+    std::ranges::move(found + 1, asked.end(), found);
+    outstanding_count--;
+  }
+
+  result.statistics = queue.statistics();
+  return result;
+}
+}  // namespace
+
+/**
+ * Simulates a bxCAN controller's three transmit mailboxes fed either directly
+ * or through hal::micromod::can_transmit_queue, with bursts of low priority
+ * messages & sporadic urgent ones at 500kbit/s. Loading the mailboxes directly
+ * leaves urgent messages waiting behind a burst, the queue sends them as soon
+ * as the frame on the bus is done, with no priority inversion. Runs on every
+ * board, build it for mod-linux-host to run it on the host.
+ */
+void application()
+{
+  using namespace std::chrono_literals;
+
+  auto& clock = hal::micromod::v1::uptime_clock();
+  auto& console = hal::micromod::v1::console(hal::buffer<16>);
+  constexpr auto microseconds_per_bit = 1'000'000 / bus_baud_rate;
+
+  hal::print(console, "CAN transmit priority simulation\n");
+  while (true) {
+    auto const direct = simulate(false);
+    auto const queued = simulate(true);
+
+    hal::print<96>(
+      console,
+      "direct mailboxes: %lu priority inversions, worst urgent latency %luus\n",
+      static_cast<unsigned long>(direct.inversions),
+      static_cast<unsigned long>(direct.worst_urgent_latency *
+                                 microseconds_per_bit));
+    hal::print<96>(
+      console,
+      "priority queue:   %lu priority inversions, worst urgent latency %luus\n",
+      static_cast<unsigned long>(queued.inversions),
+      static_cast<unsigned long>(queued.worst_urgent_latency *
+                                 microseconds_per_bit));
+    hal::print<96>(
+      console,
+      "queue: %lu sent, %lu preempted, peak depth %u, mean latency %luus\n\n",
+      static_cast<unsigned long>(queued.statistics.sent),
+      static_cast<unsigned long>(queued.statistics.preempted),
+      static_cast<unsigned>(queued.statistics.peak_depth),
+      static_cast<unsigned long>(
+        queued.statistics.total_latency * microseconds_per_bit /
+        std::max<hal::u64>(queued.statistics.sent, 1)));
+    hal::delay(clock, 5s);
+  }
+}
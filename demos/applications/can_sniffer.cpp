@@ -12,33 +12,43 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <array>
+#include <chrono>
+
+#include <libhal-micromod/can_capture.hpp>
 #include <libhal-micromod/micromod.hpp>
-#include <libhal-util/serial.hpp>
 #include <libhal/units.hpp>
 
+/**
+ * Captures every message on the CAN bus & streams them over the console at
+ * 1Mbit/s in can_capture's binary format, which keeps up with a fully loaded
+ * 500kbit/s bus. Convert the output to a candump log with:
+ *
+ *   stty -F /dev/ttyUSB0 1000000 raw
+ *   python3 tools/can_capture_decoder.py /dev/ttyUSB0
+ *
+ * Use hal::micromod::can_capture_format::candump for text output at lighter
+ * bus loads.
+ */
 void application()
 {
   using namespace std::chrono_literals;
-  using namespace hal::literals;
 
-  auto& can = hal::micromod::v1::can();
   auto& console = hal::micromod::v1::console(hal::buffer<64>);
+  console.configure({ .baud_rate = 1'000'000 });
 
-  hal::print(console, "Waiting for CAN messages...\n");
+  auto& bus_manager = hal::micromod::v1::can_bus_manager();
+  bus_manager.baud_rate(500'000);
+  bus_manager.filter_mode(hal::can_bus_manager::accept::all);
 
-  can.on_receive([&console](hal::can::message_t const& p_message) {
-    hal::print<64>(console, "{ ");
-    hal::print<64>(console, "id = %lu, ", p_message.id);
-    hal::print<64>(console, "length = %lu, ", p_message.length);
-    hal::print(console, "payload = { ");
-    for (auto const& data : std::span<hal::byte const>(p_message.payload)
-                              .first(p_message.length)) {
-      hal::print<8>(console, "0x%02X, ", data);
-    }
-    hal::print<64>(console, "}\n");
-  });
+  static std::array<hal::micromod::can_capture_record, 128> records{};
+  hal::micromod::can_capture capture(hal::micromod::v1::can_interrupt(),
+                                     hal::micromod::v1::uptime_clock(),
+                                     records);
+  bus_manager.bus_on();
 
   while (true) {
-    continue;
+    capture.drain(console, hal::micromod::can_capture_format::binary);
+    hal::micromod::v1::sleep_for(1ms);
   }
 }
@@ -0,0 +1,131 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <limits>
+#include <optional>
+
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-micromod/spsc_ring.hpp>
+#include <libhal-micromod/tick_converter.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal/units.hpp>
+
+namespace {
+/// Identifier of the periodic message to time
+constexpr hal::u32 periodic_id = 0x100;
+
+struct timestamps
+{
+  /// can_receive_timestamp(), the start of frame
+  hal::u64 hardware;
+  /// Uptime when the receive handler ran
+  hal::u64 software;
+};
+
+/// Smallest & largest interval between two consecutive messages
+struct spread
+{
+  void add(hal::u64 p_interval)
+  {
+    shortest = std::min(shortest, p_interval);
+    longest = std::max(longest, p_interval);
+  }
+
+  [[nodiscard]] hal::u64 jitter() const
+  {
+    return longest >= shortest ? longest - shortest : 0;
+  }
+
+  hal::u64 shortest = std::numeric_limits<hal::u64>::max();
+  hal::u64 longest = 0;
+};
+}  // namespace
+
+/**
+ * Timestamps a periodic message two ways, with can_receive_timestamp() and
+ * with the uptime at which the receive handler ran, and prints once a second
+ * how much the interval between messages varies with each. The STM32F1
+ * boards capture the start of frame in hardware, so only the sender's own
+ * jitter remains, while the software timestamps also vary with the interrupt
+ * latency & bit stuffing. Another node must send message 0x100 periodically,
+ * for example with SocketCAN:
+ *
+ *   cangen can0 -g 10 -I 100 -L 8 -D r
+ */
+void application()
+{
+  using namespace std::chrono_literals;
+
+  auto& clock = hal::micromod::v1::uptime_clock();
+  auto& console = hal::micromod::v1::console(hal::buffer<128>);
+  hal::micromod::tick_converter const to_time(clock.frequency());
+
+  auto& bus_manager = hal::micromod::v1::can_bus_manager();
+  bus_manager.baud_rate(500'000);
+  bus_manager.filter_mode(hal::can_bus_manager::accept::all);
+
+  static std::array<timestamps, 32> buffer{};
+  hal::micromod::spsc_ring<timestamps> ring(buffer);
+  auto& interrupt = hal::micromod::v1::can_interrupt();
+  interrupt.on_receive([&ring, &clock](hal::can_interrupt::on_receive_tag,
+                                       hal::can_message const& p_message) {
+    auto const software = clock.uptime();
+    if (p_message.id == periodic_id && not p_message.extended) {
+      (void)ring.push({ .hardware = hal::micromod::v1::can_receive_timestamp(),
+                        .software = software });
+    }
+  });
+  bus_manager.bus_on();
+
+  hal::print(console, "CAN timestamp jitter, waiting for message 0x100\n");
+  std::optional<timestamps> previous;
+  spread hardware;
+  spread software;
+  hal::u32 messages = 0;
+  auto next_report = clock.uptime() + static_cast<hal::u64>(clock.frequency());
+
+  while (true) {
+    while (auto const* entry = ring.front()) {
+      if (previous) {
+        hardware.add(entry->hardware - previous->hardware);
+        software.add(entry->software - previous->software);
+        messages++;
+      }
+      previous = *entry;
+      ring.pop();
+    }
+
+    if (clock.uptime() < next_report) {
+      continue;
+    }
+    next_report += static_cast<hal::u64>(clock.frequency());
+    if (messages == 0) {
+      continue;
+    }
+    hal::print<128>(
+      console,
+      "%lu intervals, shortest %luns, jitter: hardware %luns, software %luns\n",
+      static_cast<unsigned long>(messages),
+      static_cast<unsigned long>(to_time.nanoseconds(hardware.shortest)),
+      static_cast<unsigned long>(to_time.nanoseconds(hardware.jitter())),
+      static_cast<unsigned long>(to_time.nanoseconds(software.jitter())));
+    hardware = {};
+    software = {};
+    messages = 0;
+  }
+}
@@ -0,0 +1,291 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <optional>
+
+#include <libhal-micromod/clock_sync.hpp>
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal-util/steady_clock.hpp>
+
+namespace {
+/// Skew of each node's oscillator in parts per million, the first is the
+/// master. Edit to try other oscillators.
+constexpr std::array<double, 5> skews{ 20.0, 150.0, -200.0, 80.0, -450.0 };
+constexpr std::size_t node_count = skews.size();
+constexpr double clock_frequency = 64e6;
+constexpr hal::u32 sync_id = 0x080;
+constexpr hal::u64 sync_period = 100'000'000;
+constexpr hal::u64 step_period = 10'000'000;
+constexpr hal::u64 simulated_time = 60'000'000'000;
+/// Bit time of a 500kbit/s bus, the resolution of hardware timestamps
+constexpr hal::u64 bit_time = 2'000;
+
+/// Nanoseconds of true time, advanced by the simulation
+hal::u64 true_time = 0;
+
+/// Deterministic pseudo random numbers, 0 to p_range - 1
+hal::u64 random(hal::u64 p_range)
+{
+  static hal::u32 state = 1;
+  state = (state * 1'103'515'245U) + 12'345U;
+  return (state >> 8) % p_range;
+}
+
+/// Free running oscillator with a skew & a power up time of its own
+class skewed_clock final : public hal::steady_clock
+{
+public:
+  skewed_clock(double p_skew, hal::u64 p_power_up)
+    : m_skew(p_skew)
+    , m_power_up(p_power_up)
+  {
+  }
+
+  [[nodiscard]] hal::u64 ticks_at(hal::u64 p_true_time) const
+  {
+    auto const elapsed =
+      static_cast<double>(p_true_time) + static_cast<double>(m_power_up);
+    return static_cast<hal::u64>(elapsed * (1.0 + (m_skew * 1e-6)) *
+                                 (clock_frequency / 1e9));
+  }
+
+private:
+  hal::hertz driver_frequency() override
+  {
+    return static_cast<hal::hertz>(clock_frequency);
+  }
+
+  hal::u64 driver_uptime() override
+  {
+    return ticks_at(true_time);
+  }
+
+  double m_skew;
+  hal::u64 m_power_up;
+};
+
+/// Bus node, every frame sent reaches the other nodes at once
+class virtual_node final
+  : public hal::can_transceiver
+  , public hal::can_interrupt
+{
+public:
+  std::array<virtual_node*, node_count>* bus = nullptr;
+  skewed_clock const* clock = nullptr;
+  /// True time at the start of the frame being received or sent
+  hal::u64 start_of_frame = 0;
+  /// Timestamps of the messages sent are taken like those received
+  bool hardware_timestamps = true;
+  hal::micromod::optional_can_transmit_handler on_transmit;
+
+  /// Local clock ticks a receive timestamp reads for the frame
+  [[nodiscard]] hal::u64 timestamp(bool p_hardware) const
+  {
+    if (p_hardware) {
+      // The start of frame, to the nearest bit time before
+      return clock->ticks_at(start_of_frame / bit_time * bit_time);
+    }
+    // The end of a SYNC frame & the interrupt latency
+    return clock->ticks_at(start_of_frame + 100'000 + 1'000 + random(20'000));
+  }
+
+private:
+  hal::u32 driver_baud_rate() override
+  {
+    return 500'000;
+  }
+
+  void driver_send(hal::can_message const& p_message) override
+  {
+    // The frame waits up to 1ms behind others in the transmit queue
+    auto const start = true_time + 3'000 + random(1'000'000);
+    for (auto* node : *bus) {
+      node->start_of_frame = start;
+      if (node != this && node->m_handler) {
+        (*node->m_handler)(on_receive_tag{}, p_message);
+      }
+    }
+    if (on_transmit) {
+      (*on_transmit)(p_message, timestamp(hardware_timestamps));
+    }
+  }
+
+  std::span<hal::can_message const> driver_receive_buffer() override
+  {
+    return {};
+  }
+
+  std::size_t driver_receive_cursor() override
+  {
+    return 0;
+  }
+
+  void driver_on_receive(optional_receive_handler const& p_handler) override
+  {
+    m_handler = p_handler;
+  }
+
+  optional_receive_handler m_handler;
+};
+
+struct residual
+{
+  double largest = 0;
+  double sum = 0;
+  double sum_of_squares = 0;
+  hal::u32 count = 0;
+  hal::micromod::clock_sync_statistics statistics{};
+};
+
+/**
+ * Runs a master & followers for the simulated time, timestamping SYNC as it is
+ * sent & received at the start of frame like the STM32F1 hardware, or with
+ * interrupt latency jitter like software timestamps, and measures each
+ * follower's error against the master over the second half.
+ */
+std::array<residual, node_count> simulate(bool p_hardware_timestamps)
+{
+  true_time = 0;
+  std::array<skewed_clock, node_count> clocks{
+    skewed_clock(skews[0], 5'000'000'000), skewed_clock(skews[1], 0),
+    skewed_clock(skews[2], 750'000'000),   skewed_clock(skews[3], 2'000),
+    skewed_clock(skews[4], 42'000'000'000),
+  };
+  std::array<virtual_node, node_count> nodes{};
+  std::array<virtual_node*, node_count> bus{};
+  for (std::size_t i = 0; i < node_count; i++) {
+    nodes[i].bus = &bus;
+    nodes[i].clock = &clocks[i];
+    bus[i] = &nodes[i];
+  }
+  std::array<hal::micromod::synchronized_clock, node_count> synchronized{
+    hal::micromod::synchronized_clock(clocks[0]),
+    hal::micromod::synchronized_clock(clocks[1]),
+    hal::micromod::synchronized_clock(clocks[2]),
+    hal::micromod::synchronized_clock(clocks[3]),
+    hal::micromod::synchronized_clock(clocks[4]),
+  };
+
+  hal::micromod::clock_sync_master master(nodes[0], clocks[0], sync_id);
+  nodes[0].hardware_timestamps = p_hardware_timestamps;
+  nodes[0].on_transmit = [&master](hal::can_message const& p_message,
+                                   hal::u64 p_start_of_frame) {
+    master.transmitted(p_message, p_start_of_frame);
+  };
+  std::array<std::array<hal::micromod::can_capture_record, 4>, node_count>
+    records{};
+  std::array<std::optional<hal::micromod::clock_sync_follower>, node_count>
+    followers{};
+  for (std::size_t i = 1; i < node_count; i++) {
+    followers[i].emplace(
+      nodes[i],
+      synchronized[i],
+      [node = &nodes[i], p_hardware_timestamps] {
+        return node->timestamp(p_hardware_timestamps);
+      },
+      sync_id,
+      records[i]);
+  }
+
+  std::array<residual, node_count> residuals{};
+  hal::micromod::tick_converter const to_time(
+    static_cast<hal::hertz>(clock_frequency));
+  for (; true_time < simulated_time; true_time += step_period) {
+    // Measured before this step's frames, whose timestamps lie a frame ahead
+    // of the simulation's time
+    auto const master_time = to_time.nanoseconds(clocks[0].uptime());
+    for (std::size_t i = 1; i < node_count; i++) {
+      auto const error = static_cast<double>(
+        static_cast<std::int64_t>(synchronized[i].uptime() - master_time));
+      if (true_time >= simulated_time / 2) {
+        auto& result = residuals[i];
+        result.largest = std::max(result.largest, std::abs(error));
+        result.sum += error;
+        result.sum_of_squares += error * error;
+        result.count++;
+      }
+    }
+    if (true_time % sync_period == 0) {
+      master.sync();
+    }
+    master.poll();
+    for (std::size_t i = 1; i < node_count; i++) {
+      followers[i]->poll();
+    }
+  }
+
+  for (std::size_t i = 1; i < node_count; i++) {
+    residuals[i].statistics = synchronized[i].statistics();
+  }
+  return residuals;
+}
+
+void report(hal::serial& p_console,
+            std::array<residual, node_count> const& p_residuals)
+{
+  for (std::size_t i = 1; i < node_count; i++) {
+    auto const& result = p_residuals[i];
+    auto const relative_skew = skews[i] - skews[0];
+    auto const count = static_cast<double>(std::max<hal::u32>(result.count, 1));
+    auto const mean = result.sum / count;
+    auto const deviation =
+      std::sqrt(std::max(0.0, (result.sum_of_squares / count) - (mean * mean)));
+    hal::print<128>(
+      p_console,
+      "  node %u: skew %ldppm, drift measured %ldppm, error mean %ldns, "
+      "deviation %ldns, max %ldns\n",
+      static_cast<unsigned>(i),
+      static_cast<long>(std::lround(relative_skew)),
+      static_cast<long>(std::lround(
+        -static_cast<double>(result.statistics.drift) / 1000.0)),
+      static_cast<long>(std::lround(mean)),
+      static_cast<long>(std::lround(deviation)),
+      static_cast<long>(std::lround(result.largest)));
+  }
+}
+}  // namespace
+
+/**
+ * Simulates a master & four followers with skewed oscillators on one CAN bus,
+ * the master sending its time every 100ms with SYNC waiting up to 1ms in its
+ * transmit queue, and prints how far each follower's synchronized_clock is
+ * from the master over the last 30s of a minute, once with start of frame
+ * timestamps like the STM32F1 boards capture in hardware and once with
+ * software timestamps taken in the transmit & receive interrupts. Runs on
+ * every board, build it for mod-linux-host to run it on the host.
+ */
+void application()
+{
+  using namespace std::chrono_literals;
+
+  auto& clock = hal::micromod::v1::uptime_clock();
+  auto& console = hal::micromod::v1::console(hal::buffer<16>);
+
+  hal::print(console, "CAN clock synchronization simulation\n");
+  while (true) {
+    hal::print(console, "hardware timestamps:\n");
+    report(console, simulate(true));
+    hal::print(console, "software timestamps:\n");
+    report(console, simulate(false));
+    hal::print(console, "\n");
+    hal::delay(clock, 5s);
+  }
+}
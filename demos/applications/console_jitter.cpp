@@ -0,0 +1,103 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <limits>
+#include <string_view>
+
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-util/serial.hpp>
+
+namespace {
+constexpr hal::u32 iterations = 500;
+constexpr std::string_view line = "console jitter: 0123456789abcdef\n";
+
+struct phase
+{
+  char const* name;
+  hal::micromod::overflow_policy policy;
+  hal::time_duration period;
+};
+
+void run_phase(phase const& p_phase)
+{
+  auto& clock = hal::micromod::v1::uptime_clock();
+  auto& console = hal::micromod::v1::console(hal::buffer<16>);
+  auto const ticks_per_microsecond = clock.frequency() / 1'000'000.0f;
+  auto const period_ticks = static_cast<hal::u64>(
+    clock.frequency() * std::chrono::duration<float>(p_phase.period).count());
+
+  hal::micromod::v1::console_overflow_policy(p_phase.policy);
+  auto const before = hal::micromod::v1::console_statistics();
+
+  auto minimum = std::numeric_limits<hal::u64>::max();
+  hal::u64 maximum = 0;
+  auto deadline = clock.uptime();
+  for (hal::u32 i = 0; i < iterations; i++) {
+    deadline += period_ticks;
+    auto const start = clock.uptime();
+    hal::print(console, line);
+    auto const write_ticks = clock.uptime() - start;
+    minimum = std::min(minimum, write_ticks);
+    maximum = std::max(maximum, write_ticks);
+    hal::micromod::v1::sleep_until(deadline);
+  }
+
+  auto const after = hal::micromod::v1::console_statistics();
+
+  // Report with the blocking policy so the results are never dropped
+  hal::micromod::v1::console_overflow_policy(
+    hal::micromod::overflow_policy::block);
+  hal::print<160>(
+    console,
+    "\n%s: write() min = %lu us, max = %lu us, dropped = %lu B, "
+    "peak = %lu B\n",
+    p_phase.name,
+    static_cast<unsigned long>(minimum / ticks_per_microsecond),
+    static_cast<unsigned long>(maximum / ticks_per_microsecond),
+    static_cast<unsigned long>(after.dropped - before.dropped),
+    static_cast<unsigned long>(after.peak));
+}
+}  // namespace
+
+/**
+ * Measures how long console writes stall the calling loop. A line is written
+ * on a fixed period, first slower than the UART can send it, then faster. With
+ * the blocking policy, writes only stall once the transmit buffer fills. With
+ * drop_newest they never stall and the excess is counted as dropped.
+ */
+void application()
+{
+  using namespace std::chrono_literals;
+
+  constexpr std::array<phase, 3> phases{
+    phase{ "block, below bandwidth",
+           hal::micromod::overflow_policy::block,
+           10ms },
+    phase{ "block, above bandwidth",
+           hal::micromod::overflow_policy::block,
+           1ms },
+    phase{ "drop_newest, above bandwidth",
+           hal::micromod::overflow_policy::drop_newest,
+           1ms },
+  };
+
+  while (true) {
+    for (auto const& phase : phases) {
+      run_phase(phase);
+    }
+  }
+}
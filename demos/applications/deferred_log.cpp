@@ -0,0 +1,138 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+#include <chrono>
+
+#include <libhal-micromod/deferred_log.hpp>
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-util/serial.hpp>
+
+namespace {
+constexpr hal::u32 iterations = 1000;
+
+/// Counts the bytes written to it and discards them
+class counting_serial final : public hal::serial
+{
+public:
+  [[nodiscard]] hal::u64 written() const
+  {
+    return m_written;
+  }
+
+private:
+  void driver_configure(settings const&) override
+  {
+  }
+
+  write_t driver_write(std::span<hal::byte const> p_data) override
+  {
+    m_written += p_data.size();
+    return { .data = p_data };
+  }
+
+  read_t driver_read(std::span<hal::byte> p_data) override
+  {
+    return { .data = p_data.first(0), .available = 0, .capacity = 0 };
+  }
+
+  void driver_flush() override
+  {
+  }
+
+  hal::u64 m_written = 0;
+};
+
+struct cost
+{
+  hal::u64 bytes;
+  hal::u64 ticks;
+};
+
+template<class log_function>
+cost measure(log_function p_log)
+{
+  auto& clock = hal::micromod::v1::uptime_clock();
+  counting_serial serial;
+  auto const start = clock.uptime();
+  for (hal::u32 i = 0; i < iterations; i++) {
+    p_log(serial, i);
+  }
+  return { .bytes = serial.written(), .ticks = clock.uptime() - start };
+}
+}  // namespace
+
+/**
+ * Compares the bytes sent & time taken to log a CAN message as formatted text
+ * and as a deferred log frame, then logs the results as frames. Decode the
+ * console output with `tools/deferred_log_decoder.py` and the demo's ELF file.
+ */
+void application()
+{
+  using namespace std::chrono_literals;
+
+  auto& clock = hal::micromod::v1::uptime_clock();
+  auto& console = hal::micromod::v1::console(hal::buffer<16>);
+  auto const ticks_per_nanosecond = clock.frequency() / 1e9f;
+  constexpr std::array<hal::byte, 8> payload{ 0xDE, 0xAD, 0xBE, 0xEF,
+                                              0x00, 0x11, 0x22, 0x33 };
+
+  while (true) {
+    auto const text = measure([&payload](hal::serial& p_serial, hal::u32 p_id) {
+      hal::print<64>(p_serial,
+                     "id = %lu, length = %u, payload = { %02X %02X %02X "
+                     "%02X %02X %02X %02X %02X }\n",
+                     static_cast<unsigned long>(p_id),
+                     static_cast<unsigned>(payload.size()),
+                     payload[0],
+                     payload[1],
+                     payload[2],
+                     payload[3],
+                     payload[4],
+                     payload[5],
+                     payload[6],
+                     payload[7]);
+    });
+
+    auto const binary =
+      measure([&payload](hal::serial& p_serial, hal::u32 p_id) {
+        LIBHAL_MICROMOD_LOG(p_serial,
+                            "id = %lu, length = %u, payload = { %02hhX "
+                            "%02hhX %02hhX %02hhX %02hhX %02hhX %02hhX "
+                            "%02hhX }",
+                            p_id,
+                            payload.size(),
+                            payload[0],
+                            payload[1],
+                            payload[2],
+                            payload[3],
+                            payload[4],
+                            payload[5],
+                            payload[6],
+                            payload[7]);
+      });
+
+    LIBHAL_MICROMOD_LOG(console,
+                        "formatted: %lu bytes, %lu ns per message",
+                        text.bytes / iterations,
+                        static_cast<hal::u64>(text.ticks / iterations /
+                                              ticks_per_nanosecond));
+    LIBHAL_MICROMOD_LOG(console,
+                        "deferred: %lu bytes, %lu ns per message",
+                        binary.bytes / iterations,
+                        static_cast<hal::u64>(binary.ticks / iterations /
+                                              ticks_per_nanosecond));
+    hal::micromod::v1::sleep_for(1s);
+  }
+}
@@ -0,0 +1,191 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <exception>
+
+#include <libhal-micromod/dsp.hpp>
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal-util/steady_clock.hpp>
+
+namespace {
+using hal::micromod::q15;
+
+constexpr std::size_t block_size = 256;
+constexpr std::size_t blocks = 16;
+
+/// 31 tap Hamming windowed low pass, cut off at 1/8th of the sample rate
+constexpr std::array<q15, 31> fir_taps{
+  -39,  -67,   -68,  0,    156,   324,  327,  0,    -621, -1189, -1139,
+  0,    2249,  5022, 7322, 8216,  7322, 5022, 2249, 0,    -1139, -1189,
+  -621, 0,     327,  324,  156,   0,    -68,  -67,  -39,
+};
+
+/// 4th order Butterworth low pass, cut off at 1/20th of the sample rate
+constexpr std::array<hal::micromod::biquad_coefficients, 2> biquad_stages{ {
+  { .b0 = 312, .b1 = 624, .b2 = 312, .a1 = -24243, .a2 = 9107 },
+  { .b0 = 359, .b1 = 717, .b2 = 359, .a1 = -27869, .a2 = 12919 },
+} };
+
+/// Taps - 1 samples of history followed by a block
+constexpr std::size_t fir_state_size = fir_taps.size() - 1 + block_size;
+
+/// Noise riding on a square wave, the same for the same block number
+void fill_input(std::span<q15> p_block, std::size_t p_number)
+{
+  auto state = static_cast<hal::u32>(p_number) + 1;
+  for (std::size_t i = 0; i < p_block.size(); i++) {
+    state = (state * 1'103'515'245U) + 12'345U;
+    auto const noise = static_cast<int>((state >> 16) & 0x1FFF) - 0x1000;
+    auto const square = (i / 32) % 2 == 0 ? 24'000 : -24'000;
+    p_block[i] = static_cast<q15>(square + noise);
+  }
+}
+
+struct measurement
+{
+  hal::u64 ticks = 0;
+  std::array<q15, block_size> last_output{};
+};
+
+/// Run a block filter over the same input blocks, timing only the filter
+template<class filter_t>
+measurement measure(hal::steady_clock& p_clock, filter_t p_filter)
+{
+  measurement result;
+  std::array<q15, block_size> input{};
+  for (std::size_t i = 0; i < blocks; i++) {
+    fill_input(input, i);
+    auto const start = p_clock.uptime();
+    p_filter(std::span<q15 const>(input), std::span(result.last_output));
+    result.ticks += p_clock.uptime() - start;
+  }
+  return result;
+}
+
+unsigned long per_sample(hal::u64 p_ticks)
+{
+  return static_cast<unsigned long>(p_ticks / (block_size * blocks));
+}
+
+/// Time both kernels of a filter, block by block on two filters of the same
+/// kind, halting on the first output sample where they differ
+template<class make_t>
+void compare_kernels(hal::serial& p_console,
+                     hal::steady_clock& p_clock,
+                     char const* p_name,
+                     make_t p_make)
+{
+  using hal::micromod::dsp_kernel;
+
+  auto scalar = p_make(0);
+  auto dual_mac = p_make(1);
+  std::array<q15, block_size> input{};
+  std::array<q15, block_size> scalar_output{};
+  std::array<q15, block_size> dual_mac_output{};
+  hal::u64 scalar_ticks = 0;
+  hal::u64 dual_mac_ticks = 0;
+
+  for (std::size_t i = 0; i < blocks; i++) {
+    fill_input(input, i);
+    auto start = p_clock.uptime();
+    scalar.process(input, scalar_output, dsp_kernel::scalar);
+    scalar_ticks += p_clock.uptime() - start;
+    start = p_clock.uptime();
+    dual_mac.process(input, dual_mac_output, dsp_kernel::dual_mac);
+    dual_mac_ticks += p_clock.uptime() - start;
+
+    auto const [differs, unused] =
+      std::ranges::mismatch(scalar_output, dual_mac_output);
+    if (differs != scalar_output.end()) {
+      auto const sample = differs - scalar_output.begin();
+      hal::print<128>(p_console,
+                      "%s: MISMATCH in block %u at sample %u, scalar %d, "
+                      "dual_mac %d\n",
+                      p_name,
+                      static_cast<unsigned>(i),
+                      static_cast<unsigned>(sample),
+                      static_cast<int>(*differs),
+                      static_cast<int>(dual_mac_output[sample]));
+      std::terminate();
+    }
+  }
+
+  hal::print<128>(p_console,
+                  "%s: scalar %lu, dual_mac %lu ticks/sample, identical\n",
+                  p_name,
+                  per_sample(scalar_ticks),
+                  per_sample(dual_mac_ticks));
+}
+}  // namespace
+
+/**
+ * Measures the cost per sample of each DSP filter on blocks of 256 samples,
+ * running the FIR & biquad filters with both kernels and halting with a
+ * MISMATCH report unless every output sample is the same. On the
+ * microcontrollers the uptime clock counts cpu cycles, so ticks are cycles;
+ * dual_mac uses the SMLALD family on the lpc40's Cortex-M4 and is emulated on
+ * the stm32f1's Cortex-M3 & the host.
+ */
+void application()
+{
+  using namespace std::chrono_literals;
+  using namespace hal::micromod;
+
+  auto& clock = v1::uptime_clock();
+  auto& console = v1::console(hal::buffer<16>);
+  auto const ticks_per_microsecond = clock.frequency() / 1'000'000.0f;
+
+  hal::print<64>(console,
+                 "DSP benchmark, native kernel %s (%lu ticks/us)\n",
+                 native_dsp_kernel == dsp_kernel::dual_mac ? "dual_mac"
+                                                           : "scalar",
+                 static_cast<unsigned long>(ticks_per_microsecond));
+
+  while (true) {
+    compare_kernels(
+      console, clock, "fir 31 taps", [](std::size_t p_index) {
+        static std::array<std::array<q15, fir_state_size>, 2> state{};
+        return fir_filter(fir_taps, state[p_index]);
+      });
+    compare_kernels(
+      console, clock, "biquad 2 stages", [](std::size_t p_index) {
+        static std::array<std::array<biquad_state, biquad_stages.size()>, 2>
+          state{};
+        return biquad_cascade(biquad_stages, state[p_index]);
+      });
+
+    static std::array<q15, 16> window{};
+    moving_average average(window);
+    auto const averaged =
+      measure(clock, [&average](auto p_input, auto p_output) {
+        average.process(p_input, p_output);
+      });
+    cic_decimator decimator(3, 8);
+    auto const decimated =
+      measure(clock, [&decimator](auto p_input, auto p_output) {
+        static_cast<void>(decimator.process(p_input, p_output));
+      });
+    hal::print<96>(console,
+                   "moving average 16: %lu, cic 3rd order /8: %lu "
+                   "ticks/sample\n\n",
+                   per_sample(averaged.ticks),
+                   per_sample(decimated.ticks));
+
+    hal::delay(clock, 1s);
+  }
+}
@@ -0,0 +1,63 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/concrete.hpp>
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal-util/steady_clock.hpp>
+
+namespace {
+constexpr std::size_t toggles = 100'000;
+
+template<class output_pin_t>
+unsigned long measure_toggles_per_second(hal::steady_clock& p_clock,
+                                         output_pin_t& p_pin)
+{
+  auto const start = p_clock.uptime();
+  for (std::size_t i = 0; i < toggles; i += 2) {
+    p_pin.level(true);
+    p_pin.level(false);
+  }
+  auto const ticks = p_clock.uptime() - start;
+  auto const seconds = static_cast<float>(ticks) / p_clock.frequency();
+  return static_cast<unsigned long>(static_cast<float>(toggles) / seconds);
+}
+}  // namespace
+
+void application()
+{
+  using namespace std::chrono_literals;
+
+  auto& clock = hal::micromod::v1::uptime_clock();
+  auto& console = hal::micromod::v1::console(hal::buffer<16>);
+  // Both return the same driver, one typed as the interface and the other as
+  // the board's concrete driver class.
+  hal::output_pin& interface_pin = hal::micromod::v1::output_g0();
+  auto& concrete_pin = hal::micromod::v1::concrete::output_g0();
+
+  hal::print(console, "GPIO toggle benchmark\n");
+
+  while (true) {
+    auto const interface_rate =
+      measure_toggles_per_second(clock, interface_pin);
+    auto const concrete_rate = measure_toggles_per_second(clock, concrete_pin);
+
+    hal::print<96>(console,
+                   "interface = %lu toggles/s, concrete = %lu toggles/s\n",
+                   interface_rate,
+                   concrete_rate);
+
+    hal::delay(clock, 1s);
+  }
+}
@@ -0,0 +1,67 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-util/i2c.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal-util/steady_clock.hpp>
+
+void application()
+{
+  using namespace std::chrono_literals;
+  using namespace hal::literals;
+
+  // Change this to the address of a device on your bus. The first register of
+  // the device is read with a write-then-read transaction.
+  constexpr hal::byte device_address = 0x68;
+  constexpr std::array clock_rates = { 100.0_kHz, 400.0_kHz };
+
+  auto& clock = hal::micromod::v1::uptime_clock();
+  auto& console = hal::micromod::v1::console(hal::buffer<16>);
+  auto& i2c = hal::micromod::v1::i2c();
+
+  hal::print(console, "I2C transactions per second benchmark\n");
+
+  while (true) {
+    if (not hal::probe(i2c, device_address)) {
+      hal::print<48>(
+        console, "No device found at address 0x%02X\n", device_address);
+      hal::delay(clock, 1s);
+      continue;
+    }
+
+    for (auto const clock_rate : clock_rates) {
+      i2c.configure({ .clock_rate = clock_rate });
+
+      std::array<hal::byte, 1> const register_address{ 0x00 };
+      std::array<hal::byte, 2> data{};
+      std::uint32_t transactions = 0;
+      auto const deadline = hal::future_deadline(clock, 1s);
+
+      while (clock.uptime() < deadline) {
+        hal::write_then_read(i2c, device_address, register_address, data);
+        transactions++;
+      }
+
+      hal::print<64>(console,
+                     "%lu kHz: %lu transactions/s\n",
+                     static_cast<unsigned long>(clock_rate / 1000.0f),
+                     static_cast<unsigned long>(transactions));
+    }
+
+    hal::delay(clock, 1s);
+  }
+}
@@ -0,0 +1,281 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <optional>
+
+#include <libhal-micromod/can_statistics.hpp>
+#include <libhal-micromod/isotp.hpp>
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-micromod/tick_converter.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal-util/steady_clock.hpp>
+
+namespace {
+using namespace std::chrono_literals;
+
+constexpr hal::u32 bus_baud_rate = 500'000;
+/// Bit times the simulation advances by when no frame was sent
+constexpr hal::u64 idle_bits = 5;
+/// Bit times a transfer may take before the simulation gives up, 10s
+constexpr hal::u64 simulation_limit = 10 * bus_baud_rate;
+/// Sent from node A to node B, fits the 12-bit first frame length
+constexpr std::size_t configuration_size = 1500;
+/// Sent from node B to node A, needs the 32-bit first frame length
+constexpr std::size_t log_size = 4100;
+
+/// Test pattern both messages are sent from, kept in flash
+constexpr auto pattern = [] {
+  std::array<hal::byte, log_size> bytes{};
+  for (std::size_t i = 0; i < bytes.size(); i++) {
+    bytes[i] = static_cast<hal::byte>((i * 31) + (i >> 8) + 7);
+  }
+  return bytes;
+}();
+
+/// Clock counting bit times on the simulated bus
+class bit_clock final : public hal::steady_clock
+{
+public:
+  hal::u64 now = 0;
+
+private:
+  hal::hertz driver_frequency() override
+  {
+    return static_cast<hal::hertz>(bus_baud_rate);
+  }
+
+  hal::u64 driver_uptime() override
+  {
+    return now;
+  }
+};
+
+class virtual_node;
+
+/// Bus with two nodes, a frame is delivered as soon as it is sent
+class virtual_bus
+{
+public:
+  explicit virtual_bus(bit_clock& p_clock)
+    : m_clock(&p_clock)
+  {
+  }
+
+  void attach(virtual_node& p_node)
+  {
+    m_nodes[m_count++] = &p_node;
+  }
+
+  void send(virtual_node const& p_sender, hal::can_message const& p_message);
+
+  /// Bit times frames were on the bus
+  hal::u64 busy = 0;
+
+private:
+  bit_clock* m_clock;
+  std::array<virtual_node*, 2> m_nodes{};
+  std::size_t m_count = 0;
+};
+
+class virtual_node final
+  : public hal::can_transceiver
+  , public hal::can_interrupt
+{
+public:
+  explicit virtual_node(virtual_bus& p_bus)
+    : m_bus(&p_bus)
+  {
+    m_bus->attach(*this);
+  }
+
+  void deliver(hal::can_message const& p_message)
+  {
+    if (m_handler) {
+      (*m_handler)(on_receive_tag{}, p_message);
+    }
+  }
+
+private:
+  hal::u32 driver_baud_rate() override
+  {
+    return bus_baud_rate;
+  }
+
+  void driver_send(hal::can_message const& p_message) override
+  {
+    m_bus->send(*this, p_message);
+  }
+
+  std::span<hal::can_message const> driver_receive_buffer() override
+  {
+    return {};
+  }
+
+  std::size_t driver_receive_cursor() override
+  {
+    return 0;
+  }
+
+  void driver_on_receive(optional_receive_handler const& p_handler) override
+  {
+    m_handler = p_handler;
+  }
+
+  virtual_bus* m_bus;
+  optional_receive_handler m_handler;
+};
+
+void virtual_bus::send(virtual_node const& p_sender,
+                       hal::can_message const& p_message)
+{
+  auto const bits = hal::micromod::can_frame_bits(p_message);
+  m_clock->now += bits;
+  busy += bits;
+  for (auto* node : std::span(m_nodes).first(m_count)) {
+    if (node != &p_sender) {
+      node->deliver(p_message);
+    }
+  }
+}
+
+struct outcome
+{
+  /// Bit times from the first frame to the end of both transfers
+  hal::u64 bus_time = 0;
+  hal::u64 bus_busy = 0;
+  hal::u32 frames = 0;
+  bool intact = false;
+};
+
+/**
+ * Sends a configuration from node A to node B while node B sends a log to
+ * node A, each over its own ISO-TP channel, with the given receiver settings.
+ */
+outcome simulate(hal::micromod::isotp_settings const& p_settings)
+{
+  using hal::micromod::isotp_channel;
+  using hal::micromod::isotp_status;
+
+  bit_clock clock;
+  virtual_bus bus(clock);
+  virtual_node node_a(bus);
+  virtual_node node_b(bus);
+
+  isotp_channel a_configuration({ .transmit_id = 0x7E0, .receive_id = 0x7E8 },
+                                p_settings);
+  isotp_channel a_log({ .transmit_id = 0x7E1, .receive_id = 0x7E9 },
+                      p_settings);
+  isotp_channel b_configuration({ .transmit_id = 0x7E8, .receive_id = 0x7E0 },
+                                p_settings);
+  isotp_channel b_log({ .transmit_id = 0x7E9, .receive_id = 0x7E1 },
+                      p_settings);
+  std::array<isotp_channel*, 2> const a_channels{ &a_configuration, &a_log };
+  std::array<isotp_channel*, 2> const b_channels{ &b_configuration, &b_log };
+
+  std::array<hal::can_message, 8> a_ring{};
+  std::array<hal::can_message, 8> b_ring{};
+  hal::micromod::isotp_router router_a(
+    node_a, node_a, clock, a_channels, a_ring);
+  hal::micromod::isotp_router router_b(
+    node_b, node_b, clock, b_channels, b_ring);
+
+  static std::array<hal::byte, configuration_size> configuration{};
+  static std::array<hal::byte, log_size> log{};
+  b_configuration.receive(configuration);
+  a_log.receive(log);
+  (void)a_configuration.send(std::span(pattern).first(configuration_size));
+  (void)b_log.send(pattern);
+
+  auto const busy = [](isotp_channel const& p_channel) {
+    return p_channel.transmit_status() == isotp_status::busy ||
+           p_channel.receive_status() == isotp_status::busy;
+  };
+  while ((busy(a_configuration) || busy(a_log) || busy(b_configuration) ||
+          busy(b_log)) &&
+         clock.now < simulation_limit) {
+    auto const before = clock.now;
+    router_a.poll();
+    router_b.poll();
+    if (clock.now == before) {
+      clock.now += idle_bits;
+    }
+  }
+
+  return {
+    .bus_time = clock.now,
+    .bus_busy = bus.busy,
+    .frames = router_a.statistics().sent + router_b.statistics().sent,
+    .intact =
+      std::ranges::equal(b_configuration.received(),
+                         std::span(pattern).first(configuration_size)) &&
+      std::ranges::equal(a_log.received(), pattern),
+  };
+}
+}  // namespace
+
+/**
+ * Moves a 1500 byte configuration one way and a 4100 byte log the other way
+ * over two concurrent ISO-TP channels on a simulated 500kbit/s bus, for a few
+ * flow control settings, and prints the payload throughput and bus load each
+ * reaches. Also prints how long the simulation took, the processor time the
+ * ISO-TP stack spends on the frames. Runs on every board, build it for
+ * mod-linux-host to run it on the host.
+ */
+void application()
+{
+  auto& clock = hal::micromod::v1::uptime_clock();
+  auto& console = hal::micromod::v1::console(hal::buffer<16>);
+  hal::micromod::tick_converter const to_time(clock.frequency());
+  constexpr auto microseconds_per_bit = 1'000'000 / bus_baud_rate;
+  constexpr auto payload = configuration_size + log_size;
+
+  constexpr std::array<hal::micromod::isotp_settings, 4> settings{ {
+    { .block_size = 0, .separation_time = 0us },
+    { .block_size = 8, .separation_time = 0us },
+    { .block_size = 8, .separation_time = 500us },
+    { .block_size = 0, .separation_time = 1ms },
+  } };
+
+  hal::print(console, "ISO-TP throughput simulation\n");
+  while (true) {
+    for (auto const& setting : settings) {
+      auto const start = clock.uptime();
+      auto const result = simulate(setting);
+      auto const cpu = to_time.microseconds(clock.uptime() - start);
+      auto const bus_time = result.bus_time * microseconds_per_bit;
+
+      hal::print<128>(
+        console,
+        "bs %u, stmin %luus: %lu bytes in %luus, %lu bytes/s, bus load %lu%%, "
+        "%lu frames, %luus of cpu, %s\n",
+        static_cast<unsigned>(setting.block_size),
+        static_cast<unsigned long>(setting.separation_time.count()),
+        static_cast<unsigned long>(payload),
+        static_cast<unsigned long>(bus_time),
+        static_cast<unsigned long>(payload * 1'000'000 /
+                                   std::max<hal::u64>(bus_time, 1)),
+        static_cast<unsigned long>(result.bus_busy * 100 /
+                                   std::max<hal::u64>(result.bus_time, 1)),
+        static_cast<unsigned long>(result.frames),
+        static_cast<unsigned long>(cpu),
+        result.intact ? "intact" : "CORRUPTED");
+    }
+    hal::print(console, "\n");
+    hal::delay(clock, 5s);
+  }
+}
@@ -0,0 +1,86 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+#include <chrono>
+
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal-util/steady_clock.hpp>
+
+namespace {
+constexpr std::size_t updates = 10'000;
+
+/// PWM frequencies measured, a 20kHz motor drive among them
+constexpr std::array<hal::hertz, 3> frequencies{ 1'000.0f,
+                                                 20'000.0f,
+                                                 100'000.0f };
+
+/// Average ticks taken by each of a number of calls
+template<class call_t>
+unsigned long ticks_per_call(hal::steady_clock& p_clock, call_t p_call)
+{
+  auto const start = p_clock.uptime();
+  for (std::size_t i = 0; i < updates; i++) {
+    p_call(i);
+  }
+  return static_cast<unsigned long>((p_clock.uptime() - start) / updates);
+}
+}  // namespace
+
+/**
+ * Measures the latency of a duty cycle update on pwm0: the time the
+ * duty_cycle() call takes, plus the time until the new duty cycle reaches the
+ * output. Duty cycles are written to preloaded registers, which the timer
+ * loads at the end of the current period, so the second part is at most one
+ * period; it is printed as that bound. Also times frequency() calls, which
+ * rescale every channel of the timer.
+ */
+void application()
+{
+  using namespace std::chrono_literals;
+
+  auto& clock = hal::micromod::v1::uptime_clock();
+  auto& console = hal::micromod::v1::console(hal::buffer<16>);
+  auto& pwm = hal::micromod::v1::pwm0();
+  auto const ticks_per_microsecond = clock.frequency() / 1'000'000.0f;
+
+  hal::print<64>(console,
+                 "PWM benchmark (%lu ticks/us)\n",
+                 static_cast<unsigned long>(ticks_per_microsecond));
+
+  while (true) {
+    for (auto const frequency : frequencies) {
+      pwm.frequency(frequency);
+      auto const duty_ticks = ticks_per_call(clock, [&pwm](std::size_t p_i) {
+        pwm.duty_cycle(static_cast<float>(p_i % 100) / 100.0f);
+      });
+      auto const frequency_ticks =
+        ticks_per_call(clock, [&pwm, frequency](std::size_t p_i) {
+          pwm.frequency(p_i % 2 == 0 ? frequency : frequency * 0.5f);
+        });
+      pwm.frequency(frequency);
+      hal::print<128>(
+        console,
+        "%lu Hz: duty_cycle() %lu ticks, applied within %lu us, "
+        "frequency() %lu ticks\n",
+        static_cast<unsigned long>(frequency),
+        duty_ticks,
+        static_cast<unsigned long>(1'000'000.0f / frequency),
+        frequency_ticks);
+    }
+    hal::print(console, "\n");
+    hal::delay(clock, 1s);
+  }
+}
@@ -0,0 +1,90 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <limits>
+
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-util/serial.hpp>
+
+namespace {
+constexpr hal::u32 samples_per_duration = 20;
+}  // namespace
+
+/**
+ * Measures how late sleep_for() wakes up for a range of durations, and the
+ * fraction of the time the processor spent asleep while doing so. Measure the
+ * board's supply current while this runs to see the idle current reduction.
+ */
+void application()
+{
+  using namespace std::chrono_literals;
+
+  auto& clock = hal::micromod::v1::uptime_clock();
+  auto& console = hal::micromod::v1::console(hal::buffer<16>);
+  auto const ticks_per_microsecond = clock.frequency() / 1'000'000.0f;
+
+  constexpr std::array<hal::time_duration, 5> durations{
+    1ms, 5ms, 20ms, 100ms, 500ms
+  };
+
+  hal::print(console, "Sleep wake latency benchmark\n");
+
+  while (true) {
+    for (auto const duration : durations) {
+      auto const duration_ticks = static_cast<hal::u64>(
+        clock.frequency() * std::chrono::duration<float>(duration).count());
+      auto const statistics_before =
+        hal::micromod::v1::power_saving_statistics();
+      auto const run_start = clock.uptime();
+
+      auto minimum = std::numeric_limits<hal::u64>::max();
+      hal::u64 maximum = 0;
+      hal::u64 total = 0;
+      for (hal::u32 i = 0; i < samples_per_duration; i++) {
+        auto const deadline = clock.uptime() + duration_ticks;
+        hal::micromod::v1::sleep_until(deadline);
+        auto const latency = clock.uptime() - deadline;
+        minimum = std::min(minimum, latency);
+        maximum = std::max(maximum, latency);
+        total += latency;
+      }
+
+      auto const run_ticks = clock.uptime() - run_start;
+      auto const statistics = hal::micromod::v1::power_saving_statistics();
+      auto const asleep_ticks =
+        statistics.asleep_ticks - statistics_before.asleep_ticks;
+      auto const sleeps = statistics.sleeps - statistics_before.sleeps;
+      auto const asleep_percent =
+        (100.0f * static_cast<float>(asleep_ticks)) /
+        static_cast<float>(std::max<hal::u64>(run_ticks, 1));
+
+      hal::print<128>(
+        console,
+        "%5lu ms: latency min = %lu us, max = %lu us, avg = %lu us, "
+        "asleep = %u%% over %lu sleeps\n",
+        static_cast<unsigned long>(
+          std::chrono::duration_cast<std::chrono::milliseconds>(duration)
+            .count()),
+        static_cast<unsigned long>(minimum / ticks_per_microsecond),
+        static_cast<unsigned long>(maximum / ticks_per_microsecond),
+        static_cast<unsigned long>((total / samples_per_duration) /
+                                   ticks_per_microsecond),
+        static_cast<unsigned>(asleep_percent),
+        static_cast<unsigned long>(sleeps));
+    }
+  }
+}
@@ -0,0 +1,86 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal-util/steady_clock.hpp>
+
+void application()
+{
+  using namespace std::chrono_literals;
+  using namespace hal::literals;
+
+  auto& clock = hal::micromod::v1::uptime_clock();
+  auto& console = hal::micromod::v1::console(hal::buffer<16>);
+  auto& spi = hal::micromod::v1::spi();
+  auto& chip_select = hal::micromod::v1::spi_chip_select();
+
+  static std::array<hal::byte, 1024> data_out{};
+  static std::array<hal::byte, 1024> data_in{};
+  for (std::size_t i = 0; i < data_out.size(); i++) {
+    data_out[i] = static_cast<hal::byte>(i);
+  }
+
+  constexpr std::array clock_rates = {
+    100.0_kHz,
+    500.0_kHz,
+    1.0_MHz,
+    2.0_MHz,
+    4.0_MHz,
+  };
+
+  hal::print(console, "SPI throughput benchmark\n");
+  chip_select.level(true);
+
+  while (true) {
+    for (auto const clock_rate : clock_rates) {
+      spi.configure({ .clock_rate = clock_rate });
+
+      // Full duplex transfer
+      chip_select.level(false);
+      auto start = clock.uptime();
+      spi.transfer(data_out, data_in);
+      auto const full_duplex_ticks = clock.uptime() - start;
+      chip_select.level(true);
+
+      // Read only transfer, the driver sends filler bytes
+      chip_select.level(false);
+      start = clock.uptime();
+      spi.transfer({}, data_in);
+      auto const read_only_ticks = clock.uptime() - start;
+      chip_select.level(true);
+
+      auto const ticks_per_second = clock.frequency();
+      auto const bits = static_cast<float>(data_out.size() * 8);
+      auto const full_duplex_kbps =
+        bits / (static_cast<float>(full_duplex_ticks) / ticks_per_second) /
+        1000.0f;
+      auto const read_only_kbps =
+        bits / (static_cast<float>(read_only_ticks) / ticks_per_second) /
+        1000.0f;
+
+      hal::print<96>(console,
+                     "requested = %lu kHz, full duplex = %lu kbit/s, "
+                     "read only = %lu kbit/s\n",
+                     static_cast<unsigned long>(clock_rate / 1000.0f),
+                     static_cast<unsigned long>(full_duplex_kbps),
+                     static_cast<unsigned long>(read_only_kbps));
+    }
+
+    hal::print(console, "\n");
+    hal::delay(clock, 1s);
+  }
+}
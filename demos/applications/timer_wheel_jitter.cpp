@@ -0,0 +1,100 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
+#include <optional>
+
+#include <libhal-micromod/micromod.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal-util/steady_clock.hpp>
+
+namespace {
+constexpr auto probe_period = std::chrono::milliseconds(10);
+constexpr std::size_t load_count = 200;
+
+struct jitter_stats
+{
+  std::atomic<hal::u64> minimum = std::numeric_limits<hal::u64>::max();
+  std::atomic<hal::u64> maximum = 0;
+  std::atomic<hal::u64> total = 0;
+  std::atomic<hal::u32> samples = 0;
+};
+}  // namespace
+
+/**
+ * Measures how late a 10ms periodic timeout runs while 200 other timeouts with
+ * periods from 1ms to 2s are multiplexed onto the same system timer.
+ */
+void application()
+{
+  using namespace std::chrono_literals;
+
+  auto& clock = hal::micromod::v1::uptime_clock();
+  auto& console = hal::micromod::v1::console(hal::buffer<16>);
+  auto& wheel = hal::micromod::v1::system_timer_wheel();
+
+  auto const ticks_per_period = static_cast<hal::u64>(
+    clock.frequency() * std::chrono::duration<float>(probe_period).count());
+  auto const ticks_per_microsecond = clock.frequency() / 1'000'000.0f;
+
+  static jitter_stats stats;
+  static hal::u64 expected = 0;
+  static hal::micromod::timeout probe([&clock, &wheel, ticks_per_period]() {
+    auto const now = clock.uptime();
+    auto const lateness = now > expected ? now - expected : 0;
+    stats.minimum = std::min(stats.minimum.load(), lateness);
+    stats.maximum = std::max(stats.maximum.load(), lateness);
+    stats.total += lateness;
+    stats.samples++;
+    expected += ticks_per_period;
+    wheel.reschedule(probe, probe_period);
+  });
+
+  static std::array<hal::u32, load_count> load_counts{};
+  static std::array<std::optional<hal::micromod::timeout>, load_count> loads;
+  for (std::size_t i = 0; i < load_count; i++) {
+    // Spread the periods across all levels of the wheel
+    auto const period = std::chrono::milliseconds(1 + ((i * 37) % 2000));
+    loads[i].emplace([i, period, &wheel]() {
+      load_counts[i]++;
+      wheel.reschedule(*loads[i], period);
+    });
+    wheel.schedule(*loads[i], period);
+  }
+
+  hal::print(console, "Timer wheel jitter benchmark\n");
+
+  expected = clock.uptime() + ticks_per_period;
+  wheel.schedule(probe, probe_period);
+
+  while (true) {
+    hal::delay(clock, 1s);
+
+    auto const samples = std::max<hal::u32>(stats.samples.exchange(0), 1);
+    auto const minimum =
+      stats.minimum.exchange(std::numeric_limits<hal::u64>::max());
+    auto const maximum = stats.maximum.exchange(0);
+    auto const total = stats.total.exchange(0);
+
+    hal::print<96>(console,
+                   "lateness: min = %lu us, max = %lu us, avg = %lu us\n",
+                   static_cast<unsigned long>(minimum / ticks_per_microsecond),
+                   static_cast<unsigned long>(maximum / ticks_per_microsecond),
+                   static_cast<unsigned long>(
+                     (total / samples) / ticks_per_microsecond));
+  }
+}
@@ -0,0 +1,275 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <span>
+
+#include <libhal/adc.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::micromod {
+/**
+ * @brief Board analog inputs, in the order a frame holds their samples
+ */
+enum class analog_channel : hal::u8
+{
+  a0,
+  a1,
+  battery,
+};
+
+/// Samples in each frame of an analog_stream, one per analog_channel
+constexpr std::size_t analog_channels = 3;
+
+/// Largest sample value, the ADCs of the boards are 12-bit
+constexpr hal::u16 analog_full_scale = 0xFFF;
+
+/**
+ * @brief Get the largest oversampled value
+ *
+ * @param p_extra_bits - bits of resolution gained by oversampling
+ * @return hal::u32 - largest result of decimating 4^p_extra_bits samples
+ */
+constexpr hal::u32 analog_full_scale_oversampled(hal::u8 p_extra_bits)
+{
+  return hal::u32{ analog_full_scale } << p_extra_bits;
+}
+
+/**
+ * @brief Frames filled by an analog_stream, taken with analog_stream::take()
+ */
+struct analog_block
+{
+  /// Frames of analog_channels samples, in analog_channel order, empty if no
+  /// block was ready
+  std::span<hal::u16 const> samples;
+  /// Blocks completed before this one, including those never taken
+  hal::u32 sequence = 0;
+
+  [[nodiscard]] std::size_t frames() const
+  {
+    return samples.size() / analog_channels;
+  }
+
+  [[nodiscard]] hal::u16 sample(std::size_t p_frame,
+                                analog_channel p_channel) const
+  {
+    return samples[(p_frame * analog_channels) +
+                   static_cast<std::size_t>(p_channel)];
+  }
+};
+
+/**
+ * @brief Counters kept by an analog_stream
+ */
+struct analog_stream_statistics
+{
+  /// Blocks completed by the hardware
+  hal::u32 completed = 0;
+  /// Blocks overwritten before take() returned them
+  hal::u32 dropped = 0;
+};
+
+/**
+ * @brief Fixed rate frames sampling every board analog input at once
+ *
+ * The hardware converts the inputs in the background and writes each frame
+ * into a buffer of two blocks, one filled while the other is read. Reading the
+ * latest sample of an input is a memory load, and take() hands out each
+ * completed block. A block stays intact for one block period after it
+ * completes, until the hardware wraps around to it again, so it must be
+ * processed in that time; intact() tells whether it was.
+ *
+ * Oversampling trades rate for resolution: the sum of each group of 4^n
+ * consecutive frames, shifted right by n bits, is a sample with n extra bits
+ * once the input carries at least an LSB of noise. Groups start on multiples
+ * of 4^n frames from the start of the buffer, so results come at exactly
+ * frame_rate() / 4^n.
+ *
+ * The platform derived class reports the samples written into the current
+ * pass over the buffer in written() and calls block_complete() from its
+ * interrupt each time a half of the buffer is full.
+ */
+class analog_stream
+{
+public:
+  /**
+   * @brief Construct a new analog stream object
+   *
+   * @param p_buffer - two blocks of whole frames, must outlive the stream
+   * @param p_frame_rate - frames converted per second
+   */
+  analog_stream(std::span<hal::u16> p_buffer, hal::hertz p_frame_rate);
+
+  analog_stream(analog_stream const&) = delete;
+  analog_stream& operator=(analog_stream const&) = delete;
+  analog_stream(analog_stream&&) = delete;
+  analog_stream& operator=(analog_stream&&) = delete;
+  virtual ~analog_stream() = default;
+
+  /**
+   * @brief Get the rate frames are converted at
+   *
+   * @return hal::hertz - frames per second
+   */
+  [[nodiscard]] hal::hertz frame_rate() const;
+
+  /**
+   * @brief Get the number of frames in a block
+   *
+   * @return std::size_t - frames per block, half of the buffer
+   */
+  [[nodiscard]] std::size_t block_frames() const;
+
+  /**
+   * @brief Get the latest converted sample of an input
+   *
+   * @param p_channel - input to read
+   * @return hal::u16 - sample from the last complete frame, 0 to
+   * analog_full_scale
+   */
+  [[nodiscard]] hal::u16 latest(analog_channel p_channel);
+
+  /**
+   * @brief Take the most recently completed block
+   *
+   * Blocks that completed since the last call but were never taken are
+   * counted as dropped.
+   *
+   * @return analog_block - the block, with empty samples if none completed
+   * since the last call
+   */
+  [[nodiscard]] analog_block take();
+
+  /**
+   * @brief Determine if a block has not been overwritten yet
+   *
+   * @param p_block - block returned by take()
+   * @return true - the hardware has not wrapped around to the block yet
+   */
+  [[nodiscard]] bool intact(analog_block const& p_block) const;
+
+  /**
+   * @brief Get the stream's counters
+   *
+   * @return analog_stream_statistics - counters since construction
+   */
+  [[nodiscard]] analog_stream_statistics statistics() const;
+
+  /**
+   * @brief Set the extra bits of resolution oversampled() decimates to
+   *
+   * Applies to the inputs read through analog_stream_adc, such as a0(), a1()
+   * and battery(), which read the latest sample when it is 0.
+   *
+   * @param p_extra_bits - n, each result sums 4^n frames, clamped to
+   * maximum_oversampling()
+   */
+  void oversampling(hal::u8 p_extra_bits);
+  [[nodiscard]] hal::u8 oversampling() const;
+
+  /**
+   * @brief Get the most extra bits the buffer allows
+   *
+   * @return hal::u8 - largest n for which 4^n frames evenly divide a block
+   */
+  [[nodiscard]] hal::u8 maximum_oversampling() const;
+
+  /**
+   * @brief Get the rate oversampled results are produced at
+   *
+   * @return hal::hertz - frame_rate() / 4^oversampling()
+   */
+  [[nodiscard]] hal::hertz oversampled_rate() const;
+
+  /**
+   * @brief Get the latest oversampled result of an input
+   *
+   * Sums the last complete group of frames, a group before the one the
+   * hardware is writing, so a sum never races the hardware.
+   *
+   * @param p_channel - input to read
+   * @return hal::u32 - result from 0 to
+   * analog_full_scale_oversampled(oversampling())
+   */
+  [[nodiscard]] hal::u32 oversampled(analog_channel p_channel);
+
+protected:
+  /// Buffer the hardware writes into, trimmed to two blocks of whole frames
+  [[nodiscard]] std::span<hal::u16> buffer() const;
+
+  /**
+   * @brief Call from the interrupt once a half of the buffer is full
+   *
+   * @param p_half - 0 for the first half, 1 for the second
+   */
+  void block_complete(std::size_t p_half);
+
+private:
+  /// Samples written since the hardware last wrapped around to the start
+  virtual std::size_t written() = 0;
+
+  std::span<hal::u16> m_buffer;
+  hal::hertz m_frame_rate;
+  /// Blocks completed, the last one is in half (m_completed - 1) % 2
+  std::atomic<hal::u32> m_completed = 0;
+  hal::u32 m_taken = 0;
+  hal::u32 m_dropped = 0;
+  hal::u8 m_extra_bits = 0;
+};
+
+/**
+ * @brief Oversample an input over a block taken from an analog_stream
+ *
+ * Produces every result an oversampling stream would, for processing all of
+ * them rather than the latest.
+ *
+ * @param p_block - block returned by analog_stream::take()
+ * @param p_channel - input to decimate
+ * @param p_extra_bits - n, each result sums 4^n frames, 4^n must divide the
+ * block's frames
+ * @param p_output - results, from 0 to
+ * analog_full_scale_oversampled(p_extra_bits)
+ * @return std::size_t - results written, the block's groups of 4^n frames up
+ * to the size of p_output
+ */
+std::size_t decimate(analog_block const& p_block,
+                     analog_channel p_channel,
+                     hal::u8 p_extra_bits,
+                     std::span<hal::u32> p_output);
+
+/**
+ * @brief Reads an input from an analog_stream, oversampled if the stream is
+ */
+class analog_stream_adc final : public hal::adc
+{
+public:
+  /**
+   * @brief Construct a new analog stream adc object
+   *
+   * @param p_stream - stream converting the input, must outlive the adc
+   * @param p_channel - input read
+   */
+  analog_stream_adc(analog_stream& p_stream, analog_channel p_channel);
+
+private:
+  float driver_read() override;
+
+  analog_stream* m_stream;
+  analog_channel m_channel;
+};
+}  // namespace hal::micromod
@@ -0,0 +1,149 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+
+#include <libhal/can.hpp>
+#include <libhal/serial.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include "spsc_ring.hpp"
+#include "tick_converter.hpp"
+
+namespace hal::micromod {
+/**
+ * @brief A received CAN message with its capture time
+ */
+struct can_capture_record
+{
+  /// Uptime clock ticks when the receive interrupt ran
+  hal::u64 timestamp = 0;
+  /// Count of messages received before this one, including dropped ones
+  hal::u32 sequence = 0;
+  hal::can_message message{};
+};
+
+/**
+ * @brief How can_capture sends records over a serial port
+ */
+enum class can_capture_format : std::uint8_t
+{
+  /**
+   * Batches of records, each a COBS frame ending in a zero byte, decoded by
+   * `tools/can_capture_decoder.py`. A batch holds consecutive records:
+   *
+   * - varint: sequence number of the first record
+   * - varint: messages dropped since capture started
+   * - varint: timestamp of the first record in microseconds
+   * - records, each:
+   *   - byte: length in bits 0-3, extended in bit 4, remote request in bit 5
+   *   - identifier: 2 bytes, 4 if extended, little endian
+   *   - payload: length bytes, none for remote requests
+   *   - varint: microseconds since the previous record of the batch
+   */
+  binary,
+  /**
+   * candump log lines, `(seconds.microseconds) can0 123#DEADBEEF`, which
+   * canplayer & SocketCAN tools can replay. Gaps in the sequence are reported
+   * with a comment line, `# dropped N`.
+   */
+  candump,
+};
+
+/**
+ * @brief Counters kept by can_capture
+ */
+struct can_capture_statistics
+{
+  /// Messages received by the interrupt, including dropped ones
+  hal::u32 received = 0;
+  /// Messages dropped because the ring was full
+  hal::u32 dropped = 0;
+  /// Largest number of records held by the ring at once
+  std::size_t peak = 0;
+};
+
+/**
+ * @brief Captures CAN messages in the receive interrupt & streams them out
+ *
+ * The receive interrupt only timestamps each message and pushes it into a
+ * lock free ring. drain(), called from the main loop, encodes the records &
+ * writes them to a serial port, so a slow port stalls the main loop but never
+ * the interrupt. Messages arriving while the ring is full are counted and
+ * dropped, and the sequence numbers show where.
+ *
+ * The serial port must be fast enough for the bus. A 500kbit/s bus at full
+ * load carries up to about 4400 8 byte messages or 10000 empty messages a
+ * second. The binary format keeps up with that at 1Mbit/s, candump needs over
+ * 3Mbit/s. Calling drain() every millisecond or so, rather than in a tight
+ * loop, lets records accumulate into larger batches.
+ */
+class can_capture
+{
+public:
+  /**
+   * @brief Construct a new can capture object & register its receive handler
+   *
+   * @param p_interrupt - receive interrupt of the bus to capture
+   * @param p_clock - clock used to timestamp messages
+   * @param p_buffer - storage for the ring, must outlive the capture
+   */
+  can_capture(hal::can_interrupt& p_interrupt,
+              hal::steady_clock& p_clock,
+              std::span<can_capture_record> p_buffer);
+
+  can_capture(can_capture const&) = delete;
+  can_capture& operator=(can_capture const&) = delete;
+  can_capture(can_capture&&) = delete;
+  can_capture& operator=(can_capture&&) = delete;
+  ~can_capture();
+
+  /**
+   * @brief Write the captured records to a serial port
+   *
+   * @param p_serial - serial port to write to
+   * @param p_format - encoding of the records
+   * @return std::size_t - number of records written
+   */
+  std::size_t drain(hal::serial& p_serial, can_capture_format p_format);
+
+  /**
+   * @brief Get the capture's counters
+   *
+   * @return can_capture_statistics - counters since construction
+   */
+  [[nodiscard]] can_capture_statistics statistics() const;
+
+private:
+  void capture(hal::can_message const& p_message);
+  std::size_t drain_binary(hal::serial& p_serial);
+  std::size_t drain_candump(hal::serial& p_serial);
+
+  hal::can_interrupt* m_interrupt;
+  hal::steady_clock* m_clock;
+  tick_converter m_to_time;
+  spsc_ring<can_capture_record> m_ring;
+  /// Written by the interrupt only
+  std::atomic<hal::u32> m_received = 0;
+  std::atomic<hal::u32> m_dropped = 0;
+  std::atomic<std::size_t> m_peak = 0;
+  /// Sequence number after the last record drained, to find gaps
+  hal::u32 m_next_sequence = 0;
+};
+}  // namespace hal::micromod
@@ -0,0 +1,603 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include <libhal/can.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::micromod {
+/// Number of filters of each kind provided by the board
+constexpr std::size_t can_filter_slots = 8;
+
+/**
+ * @brief Identifiers an application wants to receive, first to last inclusive
+ */
+struct can_id_range
+{
+  hal::u32 first = 0;
+  hal::u32 last = 0;
+  bool extended = false;
+};
+
+/**
+ * @brief Filters available to the planner & how they share hardware banks
+ *
+ * The defaults describe the STM32F1 boards, where each filter accessor draws
+ * from the 14 bxCAN filter banks: a bank holds 4 identifier filters, 2 mask
+ * filters, 2 extended identifier filters or 1 extended mask filter. Boards
+ * without banks, like the LPC40, only limit the number of filters of each
+ * kind, which is what `can_filter_budget{ .banks = 32 }` models.
+ */
+struct can_filter_budget
+{
+  std::size_t identifiers = can_filter_slots;
+  std::size_t masks = can_filter_slots;
+  std::size_t extended_identifiers = can_filter_slots;
+  std::size_t extended_masks = can_filter_slots;
+  std::size_t identifiers_per_bank = 4;
+  std::size_t masks_per_bank = 2;
+  std::size_t extended_identifiers_per_bank = 2;
+  std::size_t extended_masks_per_bank = 1;
+  std::size_t banks = 14;
+};
+
+/**
+ * @brief Filter settings computed by plan_can_filters()
+ *
+ * Filters are used in order, filter 0 first, & unused filters are
+ * std::nullopt. The false positive counts are the number of identifiers a
+ * filter accepts that were not asked for.
+ */
+struct can_filter_plan
+{
+  std::array<std::optional<hal::u16>, can_filter_slots> identifiers{};
+  std::array<std::optional<hal::can_mask_filter::pair>, can_filter_slots>
+    masks{};
+  std::array<std::optional<hal::u32>, can_filter_slots> extended_identifiers{};
+  std::array<std::optional<hal::can_extended_mask_filter::pair>,
+             can_filter_slots>
+    extended_masks{};
+  std::array<hal::u32, can_filter_slots> mask_false_positives{};
+  std::array<hal::u32, can_filter_slots> extended_mask_false_positives{};
+  /**
+   * Sum of the false positives of every filter, an upper bound of the
+   * unwanted identifiers accepted as filters widened to fit can overlap
+   */
+  hal::u64 false_positives = 0;
+  /// Hardware banks used, by the budget's bank sizes
+  std::size_t banks = 0;
+  /**
+   * false if the budget cannot hold one filter per frame format, or if more
+   * than 128 disjoint ranges were asked for
+   */
+  bool fits = false;
+};
+
+namespace detail {
+/// Largest number of patterns or wanted ranges the planner works with
+constexpr std::size_t can_plan_capacity = 128;
+/// Most patterns an extended range is split into, 2 per identifier bit
+constexpr std::size_t can_range_patterns = 58;
+/// Patterns, in identifier order, considered for merging with each pattern
+constexpr std::size_t can_merge_window = 4;
+
+/// Identifiers x accepted when (x & mask) == (id & mask)
+struct can_pattern
+{
+  hal::u32 id = 0;
+  hal::u32 mask = 0;
+  bool extended = false;
+  /// Identifiers accepted that were not asked for
+  hal::u64 unwanted = 0;
+};
+
+struct can_pattern_list
+{
+  std::array<can_pattern, can_plan_capacity> items{};
+  std::size_t size = 0;
+
+  constexpr void erase(std::size_t p_index)
+  {
+    items[p_index] = items[--size];
+  }
+};
+
+/// Wanted ranges, sorted & with overlapping or touching ranges merged
+struct can_range_list
+{
+  std::array<can_id_range, can_plan_capacity> items{};
+  std::size_t size = 0;
+
+  /// @return false - the list is full
+  constexpr bool add(can_id_range const& p_range)
+  {
+    if (size == items.size()) {
+      return false;
+    }
+    items[size++] = p_range;
+    auto const used = std::span(items).first(size);
+    std::ranges::sort(used, [](auto const& p_a, auto const& p_b) {
+      return p_a.extended == p_b.extended ? p_a.first < p_b.first
+                                          : p_b.extended;
+    });
+    std::size_t merged = 0;
+    for (auto const& range : used) {
+      if (merged > 0 && items[merged - 1].extended == range.extended &&
+          hal::u64{ range.first } <= hal::u64{ items[merged - 1].last } + 1) {
+        items[merged - 1].last = std::max(items[merged - 1].last, range.last);
+      } else {
+        items[merged++] = range;
+      }
+    }
+    size = merged;
+    return true;
+  }
+
+  [[nodiscard]] constexpr std::span<can_id_range const> view() const
+  {
+    return std::span(items).first(size);
+  }
+};
+
+/// How many patterns of each kind go into identifier filters & mask filters
+struct can_assignment
+{
+  std::size_t identifiers = 0;
+  std::size_t masks = 0;
+  std::size_t extended_identifiers = 0;
+  std::size_t extended_masks = 0;
+  std::size_t banks = 0;
+};
+
+constexpr hal::u32 can_id_mask(bool p_extended)
+{
+  return p_extended ? 0x1FFF'FFFF : 0x7FF;
+}
+
+constexpr std::size_t divide_rounding_up(std::size_t p_value,
+                                         std::size_t p_divisor)
+{
+  return (p_value + p_divisor - 1) / p_divisor;
+}
+
+/// Count the identifiers below p_end accepted by a pattern
+constexpr hal::u64 count_below(hal::u64 p_end, can_pattern const& p_pattern)
+{
+  auto const id_mask = can_id_mask(p_pattern.extended);
+  auto const width = static_cast<int>(std::bit_width(id_mask));
+  auto const mask = p_pattern.mask & id_mask;
+  auto const id = p_pattern.id & mask;
+  hal::u64 count = 0;
+
+  if (p_end > id_mask) {
+    return hal::u64{ 1 } << std::popcount(~mask & id_mask);
+  }
+
+  // Walk down the bits of p_end, counting the identifiers that share its
+  // upper bits & have a 0 where it has a 1.
+  for (int bit = width - 1; bit >= 0; bit--) {
+    auto const end_bit = (p_end >> bit) & 1U;
+    auto const compared = (mask >> bit) & 1U;
+    auto const wanted = (id >> bit) & 1U;
+    if (end_bit == 1 && (compared == 0 || wanted == 0)) {
+      auto const lower_mask = (hal::u32{ 1 } << bit) - 1;
+      auto const free_bits = std::popcount(~mask & lower_mask);
+      count += hal::u64{ 1 } << free_bits;
+    }
+    if (compared == 1 && wanted != end_bit) {
+      return count;
+    }
+  }
+  return count;
+}
+
+constexpr hal::u64 accepted_count(can_pattern const& p_pattern)
+{
+  auto const id_mask = can_id_mask(p_pattern.extended);
+  return hal::u64{ 1 } << std::popcount(~p_pattern.mask & id_mask);
+}
+
+/// Count the identifiers a pattern accepts outside of the wanted ranges
+constexpr hal::u64 false_positives(can_pattern const& p_pattern,
+                                   std::span<can_id_range const> p_wanted)
+{
+  hal::u64 wanted = 0;
+  for (auto const& range : p_wanted) {
+    if (range.extended == p_pattern.extended) {
+      wanted += count_below(hal::u64{ range.last } + 1, p_pattern) -
+                count_below(range.first, p_pattern);
+    }
+  }
+  return accepted_count(p_pattern) - wanted;
+}
+
+/// true if every identifier accepted by p_inner is accepted by p_outer
+constexpr bool covers(can_pattern const& p_outer, can_pattern const& p_inner)
+{
+  return p_outer.extended == p_inner.extended &&
+         (p_outer.mask & ~p_inner.mask) == 0 &&
+         ((p_outer.id ^ p_inner.id) & p_outer.mask) == 0;
+}
+
+/// Smallest pattern accepting everything two patterns accept
+constexpr can_pattern combine(can_pattern const& p_a, can_pattern const& p_b)
+{
+  auto const mask = p_a.mask & p_b.mask & ~(p_a.id ^ p_b.id);
+  return { .id = p_a.id & mask, .mask = mask, .extended = p_a.extended };
+}
+
+/// @return std::size_t - index of the covering pattern after removals
+constexpr std::size_t remove_covered(can_pattern_list& p_list,
+                                     std::size_t p_index)
+{
+  for (std::size_t i = 0; i < p_list.size;) {
+    if (i != p_index && covers(p_list.items[p_index], p_list.items[i])) {
+      p_list.erase(i);
+      if (p_index == p_list.size) {
+        p_index = i;
+      }
+    } else {
+      i++;
+    }
+  }
+  return p_index;
+}
+
+/// Merge pairs of patterns whose union is exactly a pattern
+constexpr void merge_exact(can_pattern_list& p_list)
+{
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (std::size_t i = 0; i < p_list.size; i++) {
+      for (std::size_t j = i + 1; j < p_list.size;) {
+        auto const& a = p_list.items[i];
+        auto const& b = p_list.items[j];
+        if (a.extended != b.extended || a.mask != b.mask ||
+            std::popcount((a.id ^ b.id) & a.mask) != 1) {
+          j++;
+          continue;
+        }
+        // The two patterns are disjoint, so are their unwanted identifiers
+        auto combined = combine(a, b);
+        combined.unwanted = a.unwanted + b.unwanted;
+        p_list.items[i] = combined;
+        p_list.erase(j);
+        i = remove_covered(p_list, i);
+        j = i + 1;
+        merged = true;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Merge the two nearby patterns that admit the fewest new false
+ * positives
+ *
+ * Only patterns close in identifier order are considered, which keeps
+ * planning fast enough for the compiler & rarely misses a better merge, as
+ * distant patterns merge into masks with many don't care bits.
+ *
+ * This is a greedy heuristic: each call takes the cheapest merge within the
+ * window of `can_merge_window` patterns, without looking ahead. Repeated
+ * calls do not find the assignment with the fewest false positives, only a
+ * good one.
+ *
+ * @param p_list - patterns
+ * @param p_wanted - wanted identifiers
+ * @param p_extended - frame format to merge, std::nullopt for either
+ * @return false - no two patterns of the frame format are left
+ */
+constexpr bool merge_closest(can_pattern_list& p_list,
+                             std::span<can_id_range const> p_wanted,
+                             std::optional<bool> p_extended = std::nullopt)
+{
+  std::ranges::sort(std::span(p_list.items).first(p_list.size),
+                    [](auto const& p_a, auto const& p_b) {
+                      return p_a.extended == p_b.extended ? p_a.id < p_b.id
+                                                          : p_b.extended;
+                    });
+
+  std::optional<std::int64_t> best_cost;
+  std::size_t best_i = 0;
+  std::size_t best_j = 0;
+  can_pattern best{};
+
+  for (std::size_t i = 0; i < p_list.size; i++) {
+    auto const end = std::min(p_list.size, i + 1 + can_merge_window);
+    for (std::size_t j = i + 1; j < end; j++) {
+      auto const& a = p_list.items[i];
+      auto const& b = p_list.items[j];
+      if (a.extended != b.extended ||
+          (p_extended && a.extended != *p_extended)) {
+        continue;
+      }
+      auto combined = combine(a, b);
+      combined.unwanted = false_positives(combined, p_wanted);
+      // The merged pattern replaces every pattern it covers
+      hal::u64 removed_unwanted = 0;
+      for (std::size_t k = 0; k < p_list.size; k++) {
+        if (covers(combined, p_list.items[k])) {
+          removed_unwanted += p_list.items[k].unwanted;
+        }
+      }
+      // Signed, as overlapping patterns can share false positives
+      auto const cost = static_cast<std::int64_t>(combined.unwanted) -
+                        static_cast<std::int64_t>(removed_unwanted);
+      if (not best_cost || cost < *best_cost) {
+        best_cost = cost;
+        best_i = i;
+        best_j = j;
+        best = combined;
+      }
+    }
+  }
+
+  if (not best_cost) {
+    return false;
+  }
+  p_list.items[best_i] = best;
+  // best_i < best_j, so erasing best_j never moves best_i
+  p_list.erase(best_j);
+  remove_covered(p_list, best_i);
+  return true;
+}
+
+/// Place patterns in filters with the fewest banks, if they fit the budget
+constexpr std::optional<can_assignment> assign(
+  can_pattern_list const& p_list,
+  can_filter_budget const& p_budget)
+{
+  std::size_t singles = 0;
+  std::size_t multiples = 0;
+  std::size_t extended_singles = 0;
+  std::size_t extended_multiples = 0;
+  for (std::size_t i = 0; i < p_list.size; i++) {
+    auto const& pattern = p_list.items[i];
+    bool const single = pattern.mask == can_id_mask(pattern.extended);
+    if (pattern.extended) {
+      (single ? extended_singles : extended_multiples)++;
+    } else {
+      (single ? singles : multiples)++;
+    }
+  }
+
+  // A single identifier fits either kind of filter. Try every split, as
+  // filling a bank's spare mask filter can beat starting a new bank.
+  std::optional<can_assignment> best;
+  for (std::size_t ids = 0; ids <= std::min(singles, p_budget.identifiers);
+       ids++) {
+    auto const masks = multiples + singles - ids;
+    if (masks > p_budget.masks) {
+      continue;
+    }
+    for (std::size_t extended_ids = 0;
+         extended_ids <=
+         std::min(extended_singles, p_budget.extended_identifiers);
+         extended_ids++) {
+      auto const extended_masks =
+        extended_multiples + extended_singles - extended_ids;
+      if (extended_masks > p_budget.extended_masks) {
+        continue;
+      }
+      auto const banks =
+        divide_rounding_up(ids, p_budget.identifiers_per_bank) +
+        divide_rounding_up(masks, p_budget.masks_per_bank) +
+        divide_rounding_up(extended_ids,
+                           p_budget.extended_identifiers_per_bank) +
+        divide_rounding_up(extended_masks, p_budget.extended_masks_per_bank);
+      if (banks <= p_budget.banks && (not best || banks < best->banks)) {
+        best = can_assignment{ .identifiers = ids,
+                               .masks = masks,
+                               .extended_identifiers = extended_ids,
+                               .extended_masks = extended_masks,
+                               .banks = banks };
+      }
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief Find a frame format with more patterns than filters
+ *
+ * @return std::optional<bool> - true for extended, std::nullopt if both fit
+ */
+constexpr std::optional<bool> overflowing_format(
+  can_pattern_list const& p_list,
+  can_filter_budget const& p_budget)
+{
+  std::size_t standard = 0;
+  std::size_t standard_multiples = 0;
+  std::size_t extended = 0;
+  std::size_t extended_multiples = 0;
+  for (std::size_t i = 0; i < p_list.size; i++) {
+    auto const& pattern = p_list.items[i];
+    bool const single = pattern.mask == can_id_mask(pattern.extended);
+    (pattern.extended ? extended : standard)++;
+    if (not single) {
+      (pattern.extended ? extended_multiples : standard_multiples)++;
+    }
+  }
+  if (standard > p_budget.identifiers + p_budget.masks ||
+      standard_multiples > p_budget.masks) {
+    return false;
+  }
+  if (extended > p_budget.extended_identifiers + p_budget.extended_masks ||
+      extended_multiples > p_budget.extended_masks) {
+    return true;
+  }
+  return std::nullopt;
+}
+
+/// Add the patterns that exactly cover a range, largest aligned blocks first
+constexpr void add_range(can_pattern_list& p_list, can_id_range const& p_range)
+{
+  auto const id_mask = can_id_mask(p_range.extended);
+  hal::u64 first = p_range.first;
+  hal::u64 const end = hal::u64{ p_range.last } + 1;
+  while (first < end) {
+    hal::u64 size = first == 0 ? hal::u64{ id_mask } + 1 : first & -first;
+    while (first + size > end) {
+      size >>= 1;
+    }
+    auto const mask = id_mask & ~static_cast<hal::u32>(size - 1);
+    p_list.items[p_list.size++] = { .id = static_cast<hal::u32>(first),
+                                    .mask = mask,
+                                    .extended = p_range.extended };
+    first += size;
+  }
+}
+}  // namespace detail
+
+/**
+ * @brief Plan filters that accept the wanted identifiers
+ *
+ * Each range is first covered exactly by patterns, which are merged wherever
+ * the result is still exact. Single identifiers go to identifier filters &
+ * the rest to mask filters, in the split needing the fewest banks. While the
+ * patterns do not fit the budget, the two nearby patterns whose merge admits
+ * the fewest unwanted identifiers are merged. The merging is greedy, so the
+ * plan is not guaranteed to have the fewest false positives possible.
+ *
+ * Intended to run at compile time:
+ *
+ *     constexpr std::array wanted{
+ *       hal::micromod::can_id_range{ .first = 0x0C0, .last = 0x0C7 },
+ *       hal::micromod::can_id_range{ .first = 0x18FE'F100,
+ *                                    .last = 0x18FE'F1FF,
+ *                                    .extended = true },
+ *     };
+ *     constexpr auto plan = hal::micromod::plan_can_filters(wanted);
+ *     static_assert(plan.fits && plan.false_positives == 0);
+ *
+ * Planning is quadratic in the number of patterns, large inputs slow down the
+ * compiler noticeably.
+ *
+ * @param p_wanted - identifiers to accept, ranges may overlap
+ * @param p_budget - filters & banks available
+ * @return can_filter_plan - settings for the filters
+ */
+constexpr can_filter_plan plan_can_filters(
+  std::span<can_id_range const> p_wanted,
+  can_filter_budget const& p_budget = {})
+{
+  detail::can_range_list wanted;
+  for (auto range : p_wanted) {
+    auto const id_mask = detail::can_id_mask(range.extended);
+    if (range.first > range.last) {
+      std::swap(range.first, range.last);
+    }
+    if (range.first > id_mask) {
+      continue;
+    }
+    range.last = std::min(range.last, id_mask);
+    if (not wanted.add(range)) {
+      return {};
+    }
+  }
+
+  detail::can_pattern_list list;
+  for (auto const& range : wanted.view()) {
+    if (list.size + detail::can_range_patterns > list.items.size()) {
+      detail::merge_exact(list);
+      while (list.size + detail::can_range_patterns > list.items.size() &&
+             detail::merge_closest(list, wanted.view())) {
+        continue;
+      }
+    }
+    detail::add_range(list, range);
+  }
+  detail::merge_exact(list);
+
+  // Merge within a frame format that has more patterns than filters first,
+  // then anywhere until the patterns fit the banks.
+  auto assignment = detail::assign(list, p_budget);
+  while (not assignment &&
+         detail::merge_closest(list,
+                               wanted.view(),
+                               detail::overflowing_format(list, p_budget))) {
+    assignment = detail::assign(list, p_budget);
+  }
+
+  can_filter_plan plan{};
+  if (not assignment) {
+    return plan;
+  }
+  plan.fits = true;
+  plan.banks = assignment->banks;
+
+  std::ranges::sort(std::span(list.items).first(list.size),
+                    [](auto const& p_a, auto const& p_b) {
+                      return p_a.extended == p_b.extended ? p_a.id < p_b.id
+                                                          : p_b.extended;
+                    });
+
+  std::size_t identifiers = 0;
+  std::size_t masks = 0;
+  std::size_t extended_identifiers = 0;
+  std::size_t extended_masks = 0;
+  for (std::size_t i = 0; i < list.size; i++) {
+    auto const& pattern = list.items[i];
+    bool const single = pattern.mask == detail::can_id_mask(pattern.extended);
+    auto const unwanted = pattern.unwanted;
+    plan.false_positives += unwanted;
+
+    if (not pattern.extended) {
+      if (single && identifiers < assignment->identifiers) {
+        plan.identifiers[identifiers++] = static_cast<hal::u16>(pattern.id);
+      } else {
+        plan.mask_false_positives[masks] = static_cast<hal::u32>(unwanted);
+        plan.masks[masks++] = hal::can_mask_filter::pair{
+          .id = static_cast<hal::u16>(pattern.id),
+          .mask = static_cast<hal::u16>(pattern.mask),
+        };
+      }
+    } else if (single &&
+               extended_identifiers < assignment->extended_identifiers) {
+      plan.extended_identifiers[extended_identifiers++] = pattern.id;
+    } else {
+      plan.extended_mask_false_positives[extended_masks] =
+        static_cast<hal::u32>(unwanted);
+      plan.extended_masks[extended_masks++] =
+        hal::can_extended_mask_filter::pair{ .id = pattern.id,
+                                             .mask = pattern.mask };
+    }
+  }
+
+  return plan;
+}
+
+/**
+ * @brief Program the board's filters with a plan & only accept what it lets
+ * through
+ *
+ * Only the filters the plan uses are acquired, so on boards with filter banks
+ * no bank is spent on an unused filter. Must be called once, before any other
+ * filter accessor is used.
+ *
+ * @param p_plan - plan from plan_can_filters()
+ */
+void apply_can_filter_plan(can_filter_plan const& p_plan);
+}  // namespace hal::micromod
@@ -0,0 +1,182 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <optional>
+
+#include <libhal/can.hpp>
+#include <libhal/serial.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::micromod {
+/**
+ * @brief Estimate the time a frame takes on the bus, in bits
+ *
+ * Counts every bit from the start of frame to the end of the intermission,
+ * with the most stuff bits the frame's length allows: one for every 4 bits
+ * after the first, from the start of frame to the end of the CRC. Frames with
+ * a mix of 0s & 1s carry fewer stuff bits, so the estimate errs on the high
+ * side by up to ~20% for 8 byte frames.
+ *
+ * @param p_message - frame, only its format & length are used
+ * @return constexpr hal::u32 - frame length in bits
+ */
+constexpr hal::u32 can_frame_bits(hal::can_message const& p_message)
+{
+  hal::u32 const data =
+    p_message.remote_request ? 0 : std::min<hal::u32>(p_message.length, 8);
+  // Start of frame, arbitration, control, data & CRC fields are stuffed, then
+  // the CRC delimiter, ACK, end of frame & intermission are not
+  auto const stuffed = (p_message.extended ? 54 : 34) + (8 * data);
+  return stuffed + ((stuffed - 1) / 4) + 13;
+}
+
+/**
+ * @brief Snapshot of a CAN bus' traffic & error counters
+ *
+ * Frames are counted as the controller receives or finishes sending them.
+ * Frames rejected by hardware filters never reach the controller, set the bus
+ * manager's filter mode to accept all to count every frame on the bus.
+ *
+ * The frame & bit counters wrap around, compute rates with can_bus_rates over
+ * intervals shorter than an hour.
+ */
+struct can_bus_statistics
+{
+  /// uptime_clock() ticks when the snapshot was taken
+  hal::u64 timestamp = 0;
+  /// Frames received
+  hal::u32 received = 0;
+  /// Frames sent
+  hal::u32 transmitted = 0;
+  /// Bus time of the frames received & sent, see can_frame_bits()
+  hal::u32 bits = 0;
+  /// Times the controller went bus off
+  hal::u32 bus_off_events = 0;
+  /// Times received frames were lost because the receive buffer was full
+  hal::u32 receive_overflows = 0;
+  /// Bus baud rate, 0 if the bus is not in use
+  hal::u32 baud_rate = 0;
+  /// Controller's transmit error counter
+  hal::u8 transmit_errors = 0;
+  /// Controller's receive error counter
+  hal::u8 receive_errors = 0;
+};
+
+/**
+ * @brief Traffic between two can_bus_statistics snapshots
+ */
+struct can_bus_rates
+{
+  float received_per_second = 0.0f;
+  float transmitted_per_second = 0.0f;
+  /// Fraction of the bus time used, from 0.0 to 1.0
+  float load = 0.0f;
+
+  /**
+   * @brief Compute the traffic between two snapshots
+   *
+   * @param p_earlier - earlier snapshot
+   * @param p_later - later snapshot
+   * @param p_frequency - frequency of the clock timestamping the snapshots
+   */
+  can_bus_rates(can_bus_statistics const& p_earlier,
+                can_bus_statistics const& p_later,
+                hal::hertz p_frequency);
+};
+
+/**
+ * @brief Traffic counters updated from the CAN interrupts
+ *
+ * Each counter is a single atomic word, so the interrupts never wait and a
+ * snapshot costs a handful of loads.
+ */
+class can_traffic_counter
+{
+public:
+  /// Count a frame received
+  void received(hal::can_message const& p_message);
+  /// Count a frame sent
+  void transmitted(hal::can_message const& p_message);
+  /// Count the controller going bus off
+  void bus_off();
+  /// Count frames lost to a full receive buffer
+  void receive_overflow();
+
+  /**
+   * @brief Copy the counters into a snapshot
+   *
+   * @param p_statistics - snapshot whose traffic counters are set
+   */
+  void read(can_bus_statistics& p_statistics) const;
+
+private:
+  std::atomic<hal::u32> m_received = 0;
+  std::atomic<hal::u32> m_transmitted = 0;
+  std::atomic<hal::u32> m_bits = 0;
+  std::atomic<hal::u32> m_bus_off_events = 0;
+  std::atomic<hal::u32> m_receive_overflows = 0;
+};
+
+/**
+ * @brief Prints a line of CAN traffic & error counters once per period
+ *
+ * Call poll() from the main loop with a fresh snapshot, such as
+ * `hal::micromod::v1::can_statistics()`:
+ *
+ *     hal::micromod::can_statistics_report report(console, clock, 1s);
+ *     while (true) {
+ *       report.poll(hal::micromod::v1::can_statistics());
+ *       // ...
+ *     }
+ *
+ * prints lines like:
+ *
+ *     can: rx 812/s, tx 100/s, load 23.5%, tec 0, rec 0, bus off 0, overflow 0
+ */
+class can_statistics_report
+{
+public:
+  /**
+   * @brief Construct a new can statistics report object
+   *
+   * @param p_serial - serial port to print to
+   * @param p_clock - clock the snapshots are timestamped with
+   * @param p_period - time between lines
+   */
+  can_statistics_report(hal::serial& p_serial,
+                        hal::steady_clock& p_clock,
+                        hal::time_duration p_period);
+
+  /**
+   * @brief Print a line if a period has passed since the previous one
+   *
+   * The first call only records the snapshot to compute rates from.
+   *
+   * @param p_statistics - current snapshot
+   * @return true - a line was printed
+   */
+  bool poll(can_bus_statistics const& p_statistics);
+
+private:
+  hal::serial* m_serial;
+  hal::hertz m_frequency;
+  hal::u64 m_period;
+  std::optional<can_bus_statistics> m_previous;
+};
+}  // namespace hal::micromod
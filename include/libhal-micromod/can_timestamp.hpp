@@ -0,0 +1,123 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include <libhal/can.hpp>
+#include <libhal/functional.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::micromod {
+/**
+ * @brief Handler called from the transmit interrupt as a message finishes
+ * sending
+ *
+ * Receives the message sent & the uptime clock ticks at its start of frame.
+ */
+using can_transmit_handler = void(hal::can_message const& p_message,
+                                  hal::u64 p_start_of_frame);
+using optional_can_transmit_handler =
+  std::optional<hal::callback<can_transmit_handler>>;
+
+/**
+ * @brief Bits of a frame from its start of frame to the point the receiver
+ * accepts it, without any stuff bits
+ *
+ * The receiver accepts a frame at the last but one bit of its end of frame
+ * field, so this is the least time that can pass from the start of frame to
+ * the receive interrupt.
+ *
+ * @param p_message - message received
+ * @return constexpr hal::u32 - bits, with no bit stuffing
+ */
+constexpr hal::u32 can_minimum_frame_bits(hal::can_message const& p_message)
+{
+  hal::u32 const data = p_message.remote_request ? 0 : p_message.length;
+  // Start of frame to the end of the CRC, then the CRC delimiter, ACK slot,
+  // ACK delimiter & 6 bits of end of frame
+  return (p_message.extended ? 54 : 34) + (8 * (data > 8 ? 8 : data)) + 9;
+}
+
+/**
+ * @brief Extends a CAN controller's 16-bit start of frame timestamps to
+ * uptime clock ticks
+ *
+ * Controllers such as bxCAN in time triggered mode capture a 16-bit counter
+ * of bit times at the start of frame of every message. The counter wraps
+ * every 65536 bits, 131ms at 500kbit/s, and has no fixed relation to the
+ * uptime clock, so each capture is extended with the uptime at which the
+ * receive interrupt ran.
+ *
+ * The interrupt runs at least can_minimum_frame_bits() after the start of
+ * frame, plus a varying latency. extend() counts the bits since the previous
+ * message from the two captures, using the uptime only to tell how many
+ * times the counter wrapped, and moves the result earlier whenever a message
+ * shows the start of frame must have been earlier. The timestamps are thus
+ * free of the interrupt latency jitter, and late by the least latency and
+ * bit stuffing seen, a constant.
+ *
+ * The uptime clock must tick a whole number of times per bit and run from
+ * the same oscillator as the controller, as the uptime & CAN clocks of the
+ * STM32F1 do. Counting the bits between messages then never drifts, and the
+ * number of wraps is told correctly for as long as the uptime & the bits
+ * counted stay within 32768 bits of each other.
+ *
+ * Usage, from the receive interrupt:
+ *
+ *   auto const start_of_frame =
+ *     extender.extend(clock.uptime(), captured_time, message);
+ */
+class can_timestamp_extender
+{
+public:
+  /**
+   * @brief Construct a new can timestamp extender object
+   *
+   * @param p_ticks_per_bit - uptime clock ticks per bit time, at least 1
+   */
+  explicit can_timestamp_extender(hal::u32 p_ticks_per_bit);
+
+  /**
+   * @brief Extend a start of frame capture
+   *
+   * @param p_now - uptime when the receive interrupt ran
+   * @param p_capture - 16-bit bit time counter captured at the start of frame
+   * @param p_message - message received, for its length
+   * @return hal::u64 - uptime at the start of frame
+   */
+  hal::u64 extend(hal::u64 p_now,
+                  hal::u16 p_capture,
+                  hal::can_message const& p_message);
+
+  /**
+   * @brief Forget the previous messages, after the bit rate changed or the
+   * controller's counter restarted
+   *
+   * @param p_ticks_per_bit - uptime clock ticks per bit time, at least 1
+   */
+  void reset(hal::u32 p_ticks_per_bit);
+
+private:
+  hal::u32 m_ticks_per_bit;
+  /// Uptime at the start of frame of the previous message
+  hal::u64 m_anchor_time = 0;
+  /// Capture of the previous message
+  hal::u16 m_anchor_capture = 0;
+  bool m_anchored = false;
+};
+}  // namespace hal::micromod
@@ -0,0 +1,197 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+
+#include <libhal/can.hpp>
+#include <libhal/lock.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::micromod {
+/// Number of hardware transmit mailboxes a can_transmit_queue feeds
+constexpr std::size_t can_mailbox_count = 3;
+
+/**
+ * @brief Counters kept by a can_transmit_queue
+ *
+ * Latencies are in ticks of the queue's clock, from push() to the end of the
+ * message's transmission.
+ */
+struct can_transmit_statistics
+{
+  /// Messages accepted by push()
+  hal::u64 queued = 0;
+  /// Messages transmitted
+  hal::u64 sent = 0;
+  /// Messages taken back from a mailbox to make room for a more urgent one
+  hal::u64 preempted = 0;
+  /// Messages waiting in the queue or in a mailbox
+  std::size_t depth = 0;
+  /// Largest depth reached
+  std::size_t peak_depth = 0;
+  /// Sum of the latencies of the messages sent
+  hal::u64 total_latency = 0;
+  /// Largest latency of a message sent
+  hal::u64 worst_latency = 0;
+  /// Identifier of the message with the largest latency
+  hal::u32 worst_latency_id = 0;
+};
+
+/**
+ * @brief A message held by a can_transmit_queue
+ */
+struct can_queued_message
+{
+  hal::can_message message{};
+  /// Clock ticks when the message was pushed
+  hal::u64 queued_at = 0;
+  /// Order of the message among those pushed, keeps equal identifiers in order
+  hal::u32 sequence = 0;
+};
+
+/**
+ * @brief Arbitration priority of a message, lower values win the bus
+ *
+ * Orders messages the way bus arbitration does: by the 11 base identifier
+ * bits, then standard data frames before standard remote frames before
+ * extended frames, then by the 18 extension bits, then data before remote.
+ *
+ * @param p_message - message to rank
+ * @return constexpr hal::u32 - arbitration field as sent, recessive bits set
+ */
+constexpr hal::u32 can_arbitration_key(hal::can_message const& p_message)
+{
+  hal::u32 const remote = p_message.remote_request ? 1 : 0;
+  if (not p_message.extended) {
+    return ((p_message.id & 0x7FF) << 21) | (remote << 20);
+  }
+  auto const id = p_message.id & 0x1FFF'FFFF;
+  // Substitute remote request & identifier extension bits are both recessive
+  return ((id >> 18) << 21) | (0b11 << 19) | ((id & 0x3'FFFF) << 1) | remote;
+}
+
+/**
+ * @brief Transmit queue ordered by arbitration priority, feeding the
+ * controller's transmit mailboxes
+ *
+ * push() inserts the message by priority, equal identifiers staying in the
+ * order they were pushed, and loads the most urgent messages into the free
+ * mailboxes. The controller must send the loaded mailbox with the lowest
+ * identifier first, and equal identifiers in mailbox order, as bxCAN does with
+ * TXFP cleared. Whenever a waiting message is more urgent than loaded ones,
+ * those mailboxes are aborted and their messages go back into the queue once
+ * the aborts complete, so a burst of low priority messages never holds back
+ * an urgent one for longer than the frame already on the bus.
+ *
+ * Messages with the same arbitration priority are loaded in ascending mailbox
+ * order, so they go out in the order they were pushed. Mailboxes are only
+ * loaded with the most urgent waiting message. If it has to wait for a
+ * mailbox above those holding its identifier, the free mailboxes stay empty
+ * rather than let a less urgent message go out first.
+ *
+ * The platform derived class loads & aborts mailboxes in load_mailbox() and
+ * abort_mailbox() and calls mailbox_complete() from the transmit interrupt.
+ * The lock must mask that interrupt.
+ */
+class can_transmit_queue
+{
+public:
+  /**
+   * @brief Construct a new can transmit queue object
+   *
+   * @param p_storage - storage for the messages queued & loaded in mailboxes,
+   * must outlive the queue
+   * @param p_clock - clock used to measure latencies
+   * @param p_lock - lock protecting the queue from the transmit interrupt
+   */
+  can_transmit_queue(std::span<can_queued_message> p_storage,
+                     hal::steady_clock& p_clock,
+                     hal::basic_lock& p_lock);
+
+  can_transmit_queue(can_transmit_queue const&) = delete;
+  can_transmit_queue& operator=(can_transmit_queue const&) = delete;
+  can_transmit_queue(can_transmit_queue&&) = delete;
+  can_transmit_queue& operator=(can_transmit_queue&&) = delete;
+  virtual ~can_transmit_queue() = default;
+
+  /**
+   * @brief Queue a message for transmission
+   *
+   * @param p_message - message to send
+   * @return true - the message was queued
+   * @return false - the queue is full, nothing was queued
+   */
+  [[nodiscard]] bool push(hal::can_message const& p_message);
+
+  /**
+   * @brief Get the number of messages waiting, including those in mailboxes
+   *
+   * @return std::size_t - messages not yet transmitted
+   */
+  [[nodiscard]] std::size_t size();
+
+  /**
+   * @brief Get the number of messages the queue can hold
+   *
+   * @return std::size_t - capacity, including the messages in mailboxes
+   */
+  [[nodiscard]] std::size_t capacity() const;
+
+  /**
+   * @brief Get the queue's counters
+   *
+   * @return can_transmit_statistics - counters since construction
+   */
+  [[nodiscard]] can_transmit_statistics statistics();
+
+protected:
+  /**
+   * @brief Call from the transmit interrupt once a mailbox is empty again
+   *
+   * @param p_mailbox - mailbox index
+   * @param p_transmitted - true if the message was sent, false if it was
+   * aborted, in which case it is queued again.
+   */
+  void mailbox_complete(std::size_t p_mailbox, bool p_transmitted);
+
+private:
+  /// Load a message into an empty mailbox & request its transmission
+  virtual void load_mailbox(std::size_t p_mailbox,
+                            hal::can_message const& p_message) = 0;
+  /// Request that a loaded mailbox be aborted, completion is reported later
+  virtual void abort_mailbox(std::size_t p_mailbox) = 0;
+
+  void insert(can_queued_message const& p_entry);
+  [[nodiscard]] std::optional<std::size_t> free_mailbox(hal::u32 p_key) const;
+  void load_free_mailboxes();
+  void preempt_mailboxes();
+
+  std::span<can_queued_message> m_storage;
+  hal::steady_clock* m_clock;
+  hal::basic_lock* m_lock;
+  /// Messages waiting, sorted by arbitration priority then sequence
+  std::size_t m_size = 0;
+  std::array<std::optional<can_queued_message>, can_mailbox_count>
+    m_mailboxes{};
+  std::array<bool, can_mailbox_count> m_aborting{};
+  hal::u32 m_sequence = 0;
+  can_transmit_statistics m_statistics{};
+};
+}  // namespace hal::micromod
@@ -0,0 +1,271 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+
+#include <libhal/can.hpp>
+#include <libhal/functional.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include "can_capture.hpp"
+#include "spsc_ring.hpp"
+#include "tick_converter.hpp"
+
+namespace hal::micromod {
+/**
+ * @brief Counters & state of a synchronized_clock
+ */
+struct clock_sync_statistics
+{
+  /// Measurements of the master clock applied
+  hal::u32 samples = 0;
+  /// Times the clock jumped to the master's time instead of slewing to it
+  hal::u32 steps = 0;
+  /// Master time minus the clock's time at the last measurement, in ns
+  std::int64_t offset = 0;
+  /// Rate of the master clock relative to the local one, in parts per
+  /// billion, positive when the local clock runs slow
+  std::int64_t drift = 0;
+  /// The clock tracks the master
+  bool synchronized = false;
+};
+
+/**
+ * @brief A steady clock following the time of a master clock
+ *
+ * Counts nanoseconds of the master's clock, estimated from the local clock
+ * and measurements of the master's time fed to correct(). A proportional
+ * integral servo tracks the master: the integral term learns the drift of
+ * the local oscillator, the proportional term slews away the remaining
+ * offset over the next measurement interval. The clock only jumps, maybe
+ * backwards, at the first measurement or when the master is more than a
+ * millisecond away. Otherwise it never runs backwards, holding still until
+ * the master's time catches up instead.
+ *
+ * Before the first measurement the clock counts the local clock's time.
+ *
+ * Not safe to use from interrupts, call uptime() & correct() from the main
+ * loop only.
+ */
+class synchronized_clock : public hal::steady_clock
+{
+public:
+  /**
+   * @brief Construct a new synchronized clock object
+   *
+   * @param p_local - local clock the master's time is estimated from
+   */
+  explicit synchronized_clock(hal::steady_clock& p_local);
+
+  /**
+   * @brief Apply a measurement of the master's time
+   *
+   * @param p_local - local clock ticks at the instant measured
+   * @param p_master - master's time in nanoseconds at the same instant
+   */
+  void correct(hal::u64 p_local, hal::u64 p_master);
+
+  /**
+   * @brief Get the clock's counters & state
+   *
+   * @return clock_sync_statistics - counters since construction
+   */
+  [[nodiscard]] clock_sync_statistics statistics() const;
+
+private:
+  enum class state : std::uint8_t
+  {
+    free_running,
+    measuring_drift,
+    locked,
+  };
+
+  hal::hertz driver_frequency() override;
+  hal::u64 driver_uptime() override;
+  /// Master time estimated at a local time, both in nanoseconds
+  [[nodiscard]] hal::u64 master_time(hal::u64 p_local) const;
+  /// Restart from a measurement, within the step threshold
+  void step(hal::u64 p_local, hal::u64 p_master);
+  /// Restart from a measurement far off, measuring the drift again
+  void jump(hal::u64 p_local, hal::u64 p_master);
+
+  hal::steady_clock* m_local;
+  tick_converter m_to_time;
+  /// Local & master time in nanoseconds when the estimate was last updated
+  hal::u64 m_base_local = 0;
+  hal::u64 m_base_master = 0;
+  /// Rate applied since the base, in parts per billion
+  std::int64_t m_rate = 0;
+  /// Largest time returned, keeps the clock monotonic
+  hal::u64 m_latest = 0;
+  state m_state = state::free_running;
+  clock_sync_statistics m_statistics{};
+};
+
+/**
+ * @brief Sends the time of the master clock over CAN
+ *
+ * Each sync() sends a SYNC frame, then, once SYNC has gone out, poll() sends
+ * a FOLLOW_UP frame with the same identifier holding the master's time at
+ * the start of frame of SYNC, in the way of the two step PTP. Every node
+ * receives SYNC at the same instant, so no path delay needs measuring.
+ *
+ * - byte 0: frame type in bits 4-7, 1 for SYNC & 2 for FOLLOW_UP, sequence
+ *   number in bits 0-3
+ * - bytes 1-7, FOLLOW_UP only: master time in nanoseconds, 56 bits, little
+ *   endian
+ *
+ * The time SYNC was sent comes from the transmit handler, pass every message
+ * sent to transmitted(). SYNC may thus wait behind other frames in the
+ * transmit queue without making the time sent wrong. The accuracy is that of
+ * the transmit timestamps: the STM32F1 boards' can_on_transmit() handler gets
+ * the start of frame captured in hardware.
+ *
+ * Usage:
+ *
+ *   hal::micromod::clock_sync_master master(
+ *     hal::micromod::v1::can_transceiver(buffer), uptime_clock, 0x080);
+ *   hal::micromod::v1::can_on_transmit(
+ *     [&master](hal::can_message const& p_message, hal::u64 p_start) {
+ *       master.transmitted(p_message, p_start);
+ *     });
+ *   while (true) {
+ *     // ... master.sync() about every 100ms to 1s
+ *     master.poll();
+ *   }
+ */
+class clock_sync_master
+{
+public:
+  /**
+   * @brief Construct a new clock sync master object
+   *
+   * @param p_transceiver - transceiver the frames are sent with
+   * @param p_clock - master clock, must be the clock the start of frame times
+   * passed to transmitted() count
+   * @param p_id - identifier of the SYNC & FOLLOW_UP frames, sent as an
+   * extended identifier if above 0x7FF
+   */
+  clock_sync_master(hal::can_transceiver& p_transceiver,
+                    hal::steady_clock& p_clock,
+                    hal::u32 p_id);
+
+  /**
+   * @brief Send SYNC, about every 100ms to 1s
+   *
+   * A previous SYNC not sent yet gets no FOLLOW_UP.
+   */
+  void sync();
+
+  /**
+   * @brief Record the time SYNC was sent, call from the transmit handler
+   *
+   * Other messages are ignored. Safe to call from an interrupt.
+   *
+   * @param p_message - message sent
+   * @param p_start_of_frame - clock ticks at the start of frame of the message
+   */
+  void transmitted(hal::can_message const& p_message,
+                   hal::u64 p_start_of_frame);
+
+  /// Send FOLLOW_UP once SYNC has gone out, call from the main loop
+  void poll();
+
+private:
+  hal::can_transceiver* m_transceiver;
+  tick_converter m_to_time;
+  hal::u32 m_id;
+  hal::u8 m_sequence = 0;
+  /// Byte 0 of the SYNC waiting for its FOLLOW_UP, 0 when none is
+  std::atomic<hal::u8> m_pending = 0;
+  /// Byte 0 of the SYNC transmitted() last recorded, 0 when none is
+  std::atomic<hal::u8> m_sent = 0;
+  /// Start of frame of that SYNC in clock ticks
+  hal::u64 m_sent_time = 0;
+};
+
+/**
+ * @brief Keeps a synchronized_clock in step with a clock_sync_master
+ *
+ * The receive interrupt only timestamps the SYNC & FOLLOW_UP frames & pushes
+ * them into a lock free ring. poll(), called from the main loop, pairs each
+ * SYNC with its FOLLOW_UP & corrects the clock.
+ *
+ * The accuracy is that of the receive timestamps. On the STM32F1 boards,
+ * pass hal::micromod::v1::can_receive_timestamp, which captures the start of
+ * frame in hardware. Software timestamps add the interrupt latency jitter.
+ *
+ * Usage:
+ *
+ *   hal::micromod::synchronized_clock clock(uptime_clock);
+ *   hal::micromod::clock_sync_follower follower(
+ *     hal::micromod::v1::can_interrupt(), clock,
+ *     &hal::micromod::v1::can_receive_timestamp, 0x080, records);
+ *   while (true) {
+ *     follower.poll();
+ *     // ... clock.uptime() counts the master's nanoseconds
+ *   }
+ */
+class clock_sync_follower
+{
+public:
+  /**
+   * @brief Construct a new clock sync follower object & register its receive
+   * handler
+   *
+   * @param p_interrupt - receive interrupt of the bus the master is on
+   * @param p_clock - clock to keep in step, its local clock must be the clock
+   * p_timestamp counts
+   * @param p_timestamp - called from the receive handler, returns the local
+   * clock ticks at which the message being received started
+   * @param p_id - identifier of the master's SYNC & FOLLOW_UP frames,
+   * extended if above 0x7FF
+   * @param p_buffer - storage for the ring, must outlive the follower
+   */
+  clock_sync_follower(hal::can_interrupt& p_interrupt,
+                      synchronized_clock& p_clock,
+                      hal::callback<hal::u64()> p_timestamp,
+                      hal::u32 p_id,
+                      std::span<can_capture_record> p_buffer);
+
+  clock_sync_follower(clock_sync_follower const&) = delete;
+  clock_sync_follower& operator=(clock_sync_follower const&) = delete;
+  clock_sync_follower(clock_sync_follower&&) = delete;
+  clock_sync_follower& operator=(clock_sync_follower&&) = delete;
+  ~clock_sync_follower();
+
+  /// Apply the master's time received since the last call
+  void poll();
+
+private:
+  void capture(hal::can_message const& p_message);
+
+  hal::can_interrupt* m_interrupt;
+  synchronized_clock* m_clock;
+  hal::callback<hal::u64()> m_timestamp;
+  hal::u32 m_id;
+  spsc_ring<can_capture_record> m_ring;
+  /// Written by the interrupt only
+  std::atomic<hal::u32> m_received = 0;
+  /// Byte 0 & timestamp of the last SYNC, 0 when none is waiting
+  hal::u8 m_sync_header = 0;
+  hal::u64 m_sync_time = 0;
+};
+}  // namespace hal::micromod
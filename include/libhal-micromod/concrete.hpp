@@ -0,0 +1,47 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @brief Accessors returning the board's concrete driver types
+ *
+ * The accessors in micromod.hpp return interfaces, so every call goes through
+ * virtual dispatch. The functions in `hal::micromod::v1::concrete` return the
+ * same statically allocated drivers as their micromod.hpp counterparts, but
+ * typed as the platform's driver class, or the micromod class when the board
+ * builds the driver on a shared peripheral. As those classes are `final`,
+ * calls made through them are resolved at compile time and can be inlined
+ * when the driver's implementation is visible (header only drivers or LTO).
+ *
+ * Only the drivers that benefit from it are provided, and each board provides
+ * the subset that is backed by a public driver class. Code that uses this API
+ * is tied to the boards that provide the accessors it calls.
+ *
+ * The board is selected by the LIBHAL_MICROMOD_BOARD_<BOARD> definition
+ * provided by the package.
+ */
+
+#include "micromod.hpp"
+
+#if defined(LIBHAL_MICROMOD_BOARD_MOD_LPC40_V5)
+#include "concrete/mod-lpc40-v5.hpp"
+#elif defined(LIBHAL_MICROMOD_BOARD_MOD_STM32F1_V4) ||                        \
+  defined(LIBHAL_MICROMOD_BOARD_MOD_STM32F1_V5)
+#include "concrete/mod-stm32f1.hpp"
+#elif defined(LIBHAL_MICROMOD_BOARD_MOD_LINUX_HOST)
+#include "concrete/mod-linux-host.hpp"
+#else
+#error "No concrete accessors for this MicroMod board, is the board defined?"
+#endif
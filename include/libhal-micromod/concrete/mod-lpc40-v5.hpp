@@ -0,0 +1,60 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <libhal-arm-mcu/lpc40/i2c.hpp>
+#include <libhal-arm-mcu/lpc40/input_pin.hpp>
+#include <libhal-arm-mcu/lpc40/output_pin.hpp>
+#include <libhal-arm-mcu/lpc40/spi.hpp>
+
+#include "../analog_stream.hpp"
+
+namespace hal::micromod::v1::concrete {
+[[nodiscard]] hal::lpc40::output_pin& led();
+
+// The analog inputs are read from the burst mode stream of analog_inputs()
+[[nodiscard]] hal::micromod::analog_stream_adc& a0();
+[[nodiscard]] hal::micromod::analog_stream_adc& a1();
+[[nodiscard]] hal::micromod::analog_stream_adc& battery();
+
+[[nodiscard]] hal::lpc40::i2c& i2c();
+[[nodiscard]] hal::lpc40::i2c& i2c1();
+[[nodiscard]] hal::lpc40::spi& spi();
+[[nodiscard]] hal::lpc40::spi& spi1();
+
+[[nodiscard]] hal::lpc40::output_pin& output_g0();
+[[nodiscard]] hal::lpc40::output_pin& output_g1();
+[[nodiscard]] hal::lpc40::output_pin& output_g2();
+[[nodiscard]] hal::lpc40::output_pin& output_g3();
+[[nodiscard]] hal::lpc40::output_pin& output_g4();
+[[nodiscard]] hal::lpc40::output_pin& output_g5();
+[[nodiscard]] hal::lpc40::output_pin& output_g6();
+[[nodiscard]] hal::lpc40::output_pin& output_g7();
+[[nodiscard]] hal::lpc40::output_pin& output_g8();
+[[nodiscard]] hal::lpc40::output_pin& output_g9();
+[[nodiscard]] hal::lpc40::output_pin& output_g10();
+
+[[nodiscard]] hal::lpc40::input_pin& input_g0();
+[[nodiscard]] hal::lpc40::input_pin& input_g1();
+[[nodiscard]] hal::lpc40::input_pin& input_g2();
+[[nodiscard]] hal::lpc40::input_pin& input_g3();
+[[nodiscard]] hal::lpc40::input_pin& input_g4();
+[[nodiscard]] hal::lpc40::input_pin& input_g5();
+[[nodiscard]] hal::lpc40::input_pin& input_g6();
+[[nodiscard]] hal::lpc40::input_pin& input_g7();
+[[nodiscard]] hal::lpc40::input_pin& input_g8();
+[[nodiscard]] hal::lpc40::input_pin& input_g9();
+[[nodiscard]] hal::lpc40::input_pin& input_g10();
+}  // namespace hal::micromod::v1::concrete
@@ -0,0 +1,42 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <libhal-arm-mcu/stm32f1/input_pin.hpp>
+#include <libhal-arm-mcu/stm32f1/output_pin.hpp>
+
+namespace hal::micromod::v1::concrete {
+[[nodiscard]] hal::stm32f1::output_pin& led();
+
+[[nodiscard]] hal::stm32f1::output_pin& output_g0();
+[[nodiscard]] hal::stm32f1::output_pin& output_g1();
+[[nodiscard]] hal::stm32f1::output_pin& output_g2();
+[[nodiscard]] hal::stm32f1::output_pin& output_g3();
+[[nodiscard]] hal::stm32f1::output_pin& output_g4();
+[[nodiscard]] hal::stm32f1::output_pin& output_g5();
+[[nodiscard]] hal::stm32f1::output_pin& output_g6();
+[[nodiscard]] hal::stm32f1::output_pin& output_g7();
+[[nodiscard]] hal::stm32f1::output_pin& output_g8();
+
+[[nodiscard]] hal::stm32f1::input_pin& input_g0();
+[[nodiscard]] hal::stm32f1::input_pin& input_g1();
+[[nodiscard]] hal::stm32f1::input_pin& input_g2();
+[[nodiscard]] hal::stm32f1::input_pin& input_g3();
+[[nodiscard]] hal::stm32f1::input_pin& input_g4();
+[[nodiscard]] hal::stm32f1::input_pin& input_g5();
+[[nodiscard]] hal::stm32f1::input_pin& input_g6();
+[[nodiscard]] hal::stm32f1::input_pin& input_g7();
+[[nodiscard]] hal::stm32f1::input_pin& input_g8();
+}  // namespace hal::micromod::v1::concrete
@@ -0,0 +1,134 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <span>
+
+#include <libhal/units.hpp>
+
+namespace hal::micromod {
+/// Largest sample value of a dac_stream, DACs keep the top bits of a sample
+constexpr hal::u16 dac_full_scale = 0xFFFF;
+
+/**
+ * @brief Counters kept by a dac_stream
+ */
+struct dac_stream_statistics
+{
+  /// Blocks the hardware finished playing
+  hal::u32 played = 0;
+  /// Blocks the hardware started before write() completed them
+  hal::u32 underruns = 0;
+};
+
+/**
+ * @brief Fixed rate samples played by a DAC from a buffer of two blocks
+ *
+ * The hardware plays one block while write() fills the other, and moves on to
+ * the other block at the end of each one without the cpu writing samples. A
+ * block the hardware starts before write() completed it is an underrun: the
+ * block is filled with the last sample played instead, so the output holds,
+ * and the samples written into it so far are lost. Samples write() was copying
+ * into it when it started go into the next block. Keeping up means writing a
+ * block within each block period.
+ *
+ * The buffer holds the words the hardware writes to the DAC, each sample
+ * masked to the bits the DAC takes. The platform derived class starts playing
+ * the buffer's first block & calls block_started() from its interrupt each
+ * time the hardware moves on to the other block.
+ */
+class dac_stream
+{
+public:
+  /**
+   * @brief Construct a new dac stream object
+   *
+   * @param p_buffer - two blocks of DAC words, must outlive the stream
+   * @param p_sample_rate - samples played per second
+   * @param p_sample_mask - bits of a sample the DAC takes, in place
+   */
+  dac_stream(std::span<hal::u32> p_buffer,
+             hal::hertz p_sample_rate,
+             hal::u32 p_sample_mask);
+
+  dac_stream(dac_stream const&) = delete;
+  dac_stream& operator=(dac_stream const&) = delete;
+  dac_stream(dac_stream&&) = delete;
+  dac_stream& operator=(dac_stream&&) = delete;
+  virtual ~dac_stream() = default;
+
+  /**
+   * @brief Get the rate samples are played at
+   *
+   * @return hal::hertz - samples per second
+   */
+  [[nodiscard]] hal::hertz sample_rate() const;
+
+  /**
+   * @brief Get the number of samples in a block
+   *
+   * @return std::size_t - samples per block, half of the buffer
+   */
+  [[nodiscard]] std::size_t block_samples() const;
+
+  /**
+   * @brief Queue samples into the block the hardware plays next
+   *
+   * @param p_samples - samples from 0 to dac_full_scale
+   * @return std::size_t - samples queued, fewer than given once the next block
+   * is complete & waiting for the hardware
+   */
+  std::size_t write(std::span<hal::u16 const> p_samples);
+
+  /**
+   * @brief Get the number of samples write() would queue now
+   *
+   * @return std::size_t - samples left in the next block, 0 if it is complete
+   */
+  [[nodiscard]] std::size_t writable() const;
+
+  /**
+   * @brief Get the stream's counters
+   *
+   * @return dac_stream_statistics - counters since construction
+   */
+  [[nodiscard]] dac_stream_statistics statistics() const;
+
+protected:
+  /// Buffer the hardware plays, trimmed to two blocks
+  [[nodiscard]] std::span<hal::u32> buffer() const;
+
+  /// Call from the interrupt once the hardware moved on to the other block
+  void block_started();
+
+private:
+  std::span<hal::u32> m_buffer;
+  hal::hertz m_sample_rate;
+  hal::u32 m_sample_mask;
+  /// Blocks started, block m_started - 1 is playing. Block k is in half k % 2
+  /// of the buffer, block 0 is the buffer's initial contents.
+  std::atomic<hal::u32> m_started = 1;
+  /// Blocks completed by write() or filled as underruns, write() fills block
+  /// m_filled while it equals m_started
+  std::atomic<hal::u32> m_filled = 1;
+  std::atomic<hal::u32> m_underruns = 0;
+  /// Block write() was last filling & the samples written into it
+  hal::u32 m_filling = 1;
+  std::size_t m_position = 0;
+};
+}  // namespace hal::micromod
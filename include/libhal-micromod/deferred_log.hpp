@@ -0,0 +1,411 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include <libhal/serial.hpp>
+#include <libhal/units.hpp>
+
+/**
+ * @brief Deferred logging, the format string stays on the host
+ *
+ * LIBHAL_MICROMOD_LOG() places its format string in the `.micromod_log`
+ * section, which is kept in the ELF file but never loaded onto the device. The
+ * offset of the string within that section is its ID. Each log call sends only
+ * the ID and the raw arguments, as a COBS frame ending in a zero byte, and
+ * `tools/deferred_log_decoder.py` formats the text on the host using the ELF.
+ *
+ * Usage:
+ *
+ *   auto& console = hal::micromod::v1::console(hal::buffer<16>);
+ *   LIBHAL_MICROMOD_LOG(console, "id = %lu, length = %u", id, length);
+ *
+ * Arguments are encoded according to their conversion in the format string,
+ * which is checked against the argument types at compile time:
+ *
+ * - `d` `i`: zigzag varint
+ * - `u` `x` `X` `o` `p`: varint
+ * - `c`, and integers with the `hh` length modifier: one byte
+ * - `f` `F` `e` `E` `g` `G` `a` `A`: 32-bit float, doubles lose precision
+ * - `s`: varint length then the characters, truncated to log_string_limit
+ *
+ * Flags, width, precision and length modifiers are passed on to the decoder
+ * but `*` width or precision is not supported.
+ *
+ * Call LIBHAL_MICROMOD_LOG() from regular functions or lambdas. In inline
+ * functions and templates the compiler places the format string in a COMDAT
+ * group instead of `.micromod_log`, and the decoder cannot find it.
+ */
+#if defined(__PIE__)
+/// Provided by the linker at the start of the loaded ELF header
+extern "C" char const __ehdr_start[];  // NOLINT
+#endif
+
+namespace hal::micromod {
+/// Longest string argument sent, longer strings are truncated
+constexpr std::size_t log_string_limit = 32;
+/// Largest frame payload, chosen so a COBS frame needs one overhead byte
+constexpr std::size_t log_payload_limit = 254;
+
+namespace detail {
+enum class log_argument : std::uint8_t
+{
+  signed_integer,
+  unsigned_integer,
+  /// Sent as one byte, for `c` and `hh` integer conversions
+  character,
+  floating_point,
+  string,
+};
+
+/// Not constexpr, so calling it from log_format reports the error at compile
+/// time with this name in the message.
+void log_format_string_does_not_match_the_arguments();
+
+template<class T>
+concept log_integer = std::integral<T> || std::is_enum_v<T>;
+
+template<class T>
+concept log_string = std::convertible_to<T, std::string_view>;
+
+template<class T>
+constexpr bool accepts(log_argument p_argument)
+{
+  switch (p_argument) {
+    case log_argument::signed_integer:
+    case log_argument::unsigned_integer:
+      return log_integer<T> || std::is_pointer_v<T>;
+    case log_argument::character:
+      return log_integer<T>;
+    case log_argument::floating_point:
+      return std::floating_point<T>;
+    case log_argument::string:
+      return log_string<T>;
+  }
+  return false;
+}
+
+template<class T>
+constexpr std::size_t maximum_size()
+{
+  if constexpr (std::floating_point<T>) {
+    return sizeof(float);
+  } else if constexpr (log_string<T>) {
+    return 1 + log_string_limit;
+  } else {
+    // A 64-bit varint takes up to 10 bytes
+    return 10;
+  }
+}
+
+constexpr log_argument to_argument(char p_conversion)
+{
+  switch (p_conversion) {
+    case 'd':
+    case 'i':
+      return log_argument::signed_integer;
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+    case 'p':
+      return log_argument::unsigned_integer;
+    case 'c':
+      return log_argument::character;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      return log_argument::floating_point;
+    case 's':
+      return log_argument::string;
+    default:
+      // Includes '*' width & precision and the end of the string
+      log_format_string_does_not_match_the_arguments();
+      return log_argument::string;
+  }
+}
+
+/**
+ * @brief Parse the next conversion of a printf format string
+ *
+ * @param p_format - format string
+ * @param p_index - position to parse from, left after the conversion
+ * @return std::optional<log_argument> - how the conversion's argument is sent,
+ * std::nullopt at the end of the string
+ */
+constexpr std::optional<log_argument> next_conversion(char const* p_format,
+                                                      std::size_t& p_index)
+{
+  while (p_format[p_index] != '\0') {
+    if (p_format[p_index++] != '%') {
+      continue;
+    }
+    if (p_format[p_index] == '%') {
+      p_index++;
+      continue;
+    }
+    // Skip the flags, width, precision & length modifiers
+    auto const start = p_index;
+    while (std::string_view("-+ #0123456789.hljztL").find(
+             p_format[p_index]) != std::string_view::npos) {
+      p_index++;
+    }
+    auto const modifiers = std::string_view(p_format + start, p_index - start);
+    auto const argument = to_argument(p_format[p_index++]);
+    if (modifiers.ends_with("hh") &&
+        (argument == log_argument::signed_integer ||
+         argument == log_argument::unsigned_integer)) {
+      return log_argument::character;
+    }
+    return argument;
+  }
+  return std::nullopt;
+}
+
+inline std::size_t write_varint(hal::byte* p_out, hal::u64 p_value)
+{
+  std::size_t length = 0;
+  while (p_value >= 0x80) {
+    p_out[length++] = static_cast<hal::byte>(p_value | 0x80);
+    p_value >>= 7;
+  }
+  p_out[length++] = static_cast<hal::byte>(p_value);
+  return length;
+}
+
+template<class T>
+auto to_integer(T p_value)
+{
+  if constexpr (std::is_pointer_v<T>) {
+    return reinterpret_cast<std::uintptr_t>(p_value);
+  } else if constexpr (std::is_enum_v<T>) {
+    return to_integer(static_cast<std::underlying_type_t<T>>(p_value));
+  } else if constexpr (std::is_same_v<T, bool>) {
+    return static_cast<unsigned char>(p_value);
+  } else {
+    return p_value;
+  }
+}
+
+template<class T>
+std::size_t write_argument(hal::byte* p_out,
+                           log_argument p_argument,
+                           T const& p_value)
+{
+  if constexpr (std::floating_point<T>) {
+    auto const bits =
+      std::bit_cast<std::uint32_t>(static_cast<float>(p_value));
+    for (std::size_t i = 0; i < sizeof(bits); i++) {
+      p_out[i] = static_cast<hal::byte>(bits >> (8 * i));
+    }
+    return sizeof(bits);
+  } else if constexpr (log_string<T>) {
+    std::string_view string = "(null)";
+    if constexpr (std::is_pointer_v<T>) {
+      if (p_value != nullptr) {
+        string = p_value;
+      }
+    } else {
+      string = p_value;
+    }
+    auto const length = std::min(string.size(), log_string_limit);
+    p_out[0] = static_cast<hal::byte>(length);
+    std::memcpy(p_out + 1, string.data(), length);
+    return 1 + length;
+  } else {
+    // Reinterpret the value as the conversion does, at its own width
+    auto const integer = to_integer(p_value);
+    using integer_t = decltype(integer);
+    if (p_argument == log_argument::character) {
+      p_out[0] = static_cast<hal::byte>(integer);
+      return 1;
+    }
+    if (p_argument == log_argument::signed_integer) {
+      auto const value = static_cast<std::int64_t>(
+        static_cast<std::make_signed_t<integer_t>>(integer));
+      // Zigzag encode so small negative values stay short
+      auto const zigzag = (static_cast<hal::u64>(value) << 1) ^
+                          static_cast<hal::u64>(value >> 63);
+      return write_varint(p_out, zigzag);
+    }
+    return write_varint(p_out,
+                        static_cast<std::make_unsigned_t<integer_t>>(integer));
+  }
+}
+
+/// The ID of a format string, its offset in the `.micromod_log` section
+inline hal::u64 log_id(char const* p_format)
+{
+#if defined(__PIE__)
+  // Position independent executables are loaded at an offset, which the ELF
+  // header marks the start of.
+  return reinterpret_cast<std::uintptr_t>(p_format) -
+         reinterpret_cast<std::uintptr_t>(__ehdr_start);
+#else
+  return reinterpret_cast<std::uintptr_t>(p_format);
+#endif
+}
+
+/**
+ * @brief COBS encode a frame in place & append the zero delimiter
+ *
+ * @param p_frame - the payload, preceded by one spare byte & followed by one
+ * spare byte. The payload must be at most 254 bytes.
+ */
+inline void cobs_encode(std::span<hal::byte> p_frame)
+{
+  std::size_t code = 0;
+  auto const end = p_frame.size() - 1;
+  for (std::size_t i = 1; i < end; i++) {
+    if (p_frame[i] == 0) {
+      p_frame[code] = static_cast<hal::byte>(i - code);
+      code = i;
+    }
+  }
+  p_frame[code] = static_cast<hal::byte>(end - code);
+  p_frame[end] = 0;
+}
+}  // namespace detail
+
+/**
+ * @brief A format string checked against the types of its arguments
+ *
+ * Constructed only at compile time, from a string in `.micromod_log`.
+ *
+ * @tparam Args - types of the arguments
+ */
+template<class... Args>
+class log_format
+{
+public:
+  consteval log_format(char const* p_format)  // NOLINT: implicit by design
+    : m_format(p_format)
+  {
+    std::size_t index = 0;
+    std::size_t argument = 0;
+    bool matches = true;
+    ((matches =
+        matches && check<Args>(p_format, index, m_arguments[argument++])),
+     ...);
+    if (not matches || detail::next_conversion(p_format, index)) {
+      detail::log_format_string_does_not_match_the_arguments();
+    }
+  }
+
+  [[nodiscard]] char const* format() const
+  {
+    return m_format;
+  }
+
+  [[nodiscard]] detail::log_argument argument(std::size_t p_index) const
+  {
+    return m_arguments[p_index];
+  }
+
+private:
+  template<class T>
+  static consteval bool check(char const* p_format,
+                              std::size_t& p_index,
+                              detail::log_argument& p_argument)
+  {
+    auto const argument = detail::next_conversion(p_format, p_index);
+    if (not argument) {
+      return false;
+    }
+    p_argument = *argument;
+    return detail::accepts<std::decay_t<T>>(p_argument);
+  }
+
+  char const* m_format;
+  std::array<detail::log_argument, sizeof...(Args)> m_arguments{};
+};
+
+/**
+ * @brief Send a log message as a binary frame
+ *
+ * Use the LIBHAL_MICROMOD_LOG() macro, which places the format string in the
+ * `.micromod_log` section. The frame is written with a single write() so it is
+ * not split by other writers using the same serial port.
+ *
+ * @param p_serial - serial port to write the frame to
+ * @param p_format - format string
+ * @param p_arguments - arguments of the format string
+ */
+template<class... Args>
+void deferred_log(hal::serial& p_serial,
+                  log_format<std::type_identity_t<Args>...> p_format,
+                  Args const&... p_arguments)
+{
+  // The ID is a varint of up to 10 bytes for a 64-bit address
+  constexpr std::size_t payload_size =
+    10 + (detail::maximum_size<std::decay_t<Args>>() + ... + 0);
+  static_assert(payload_size <= log_payload_limit,
+                "Too many arguments to fit in a log frame");
+
+  // One spare byte for the COBS code and one for the delimiter
+  std::array<hal::byte, payload_size + 2> frame;
+  std::size_t length = 1;
+  length +=
+    detail::write_varint(&frame[length], detail::log_id(p_format.format()));
+  [[maybe_unused]] std::size_t index = 0;
+  ((length += detail::write_argument(
+      &frame[length], p_format.argument(index++), p_arguments)),
+   ...);
+
+  auto const encoded = std::span(frame).first(length + 1);
+  detail::cobs_encode(encoded);
+  p_serial.write(encoded);
+}
+}  // namespace hal::micromod
+
+#if defined(__arm__) || defined(__thumb__)
+#define LIBHAL_MICROMOD_LOG_SECTION ".micromod_log,\"\",%progbits @"
+#else
+#define LIBHAL_MICROMOD_LOG_SECTION ".micromod_log,\"\",@progbits #"
+#endif
+
+/**
+ * @brief Log a printf style message through a serial port without formatting
+ *
+ * The trailing comment character in the section name drops the flags the
+ * compiler appends, so the section is not allocated on the device.
+ *
+ * @param p_serial - hal::serial to write the frame to
+ * @param p_format - string literal format string
+ * @param ... - arguments of the format string
+ */
+#define LIBHAL_MICROMOD_LOG(p_serial, p_format, ...)                           \
+  do {                                                                         \
+    [[gnu::section(LIBHAL_MICROMOD_LOG_SECTION), gnu::used]]                   \
+    static constexpr char libhal_micromod_log_format[] = p_format;             \
+    ::hal::micromod::deferred_log(                                             \
+      p_serial, libhal_micromod_log_format __VA_OPT__(, ) __VA_ARGS__);        \
+  } while (false)
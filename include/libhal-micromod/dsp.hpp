@@ -0,0 +1,253 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <libhal/units.hpp>
+
+#include "analog_stream.hpp"
+
+namespace hal::micromod {
+/// Signed fixed point sample or coefficient with 15 fractional bits, -1 to 1
+using q15 = std::int16_t;
+
+/**
+ * @brief Inner loops a filter runs its multiply accumulates with
+ *
+ * Both give the same output bit for bit: products are exact and summed in a
+ * 64-bit accumulator, which is rounded & saturated once per output.
+ */
+enum class dsp_kernel : std::uint8_t
+{
+  /// One 16 x 16 multiply accumulate per tap, portable C++
+  scalar,
+  /**
+   * Two 16 x 16 multiply accumulates per instruction (SMLALD & co.) of the
+   * Cortex-M4 DSP extension, emulated with plain C++ on cores without it
+   */
+  dual_mac,
+};
+
+/// Fastest kernel of the core the library is built for
+#if defined(__ARM_FEATURE_SIMD32)
+constexpr dsp_kernel native_dsp_kernel = dsp_kernel::dual_mac;
+#else
+constexpr dsp_kernel native_dsp_kernel = dsp_kernel::scalar;
+#endif
+
+/**
+ * @brief Convert one input's samples of an analog block to q15
+ *
+ * The 12-bit samples are centered on mid-scale, so the input's full range
+ * maps to -1 to 1.
+ *
+ * @param p_block - block from an analog_stream
+ * @param p_channel - input to convert
+ * @param p_output - where to write the samples
+ * @return std::span<q15> - samples written, the first block.frames() of
+ * p_output or all of it if it is shorter
+ */
+std::span<q15> analog_to_q15(analog_block const& p_block,
+                             analog_channel p_channel,
+                             std::span<q15> p_output);
+
+/**
+ * @brief Finite impulse response filter, y[n] = sum of h[k] * x[n - k]
+ *
+ * Input is copied after the last taps - 1 samples kept in the state, so each
+ * output is computed from contiguous memory, and blocks longer than the state
+ * has room for are processed in several passes.
+ */
+class fir_filter
+{
+public:
+  /**
+   * @brief Construct a new fir filter object
+   *
+   * @param p_coefficients - taps h[0] to h[n - 1] in q15, must outlive the
+   * filter
+   * @param p_state - history & working storage, taps - 1 samples plus the
+   * samples processed per pass (at least one), must outlive the filter
+   */
+  fir_filter(std::span<q15 const> p_coefficients, std::span<q15> p_state);
+
+  /**
+   * @brief Filter a block of samples
+   *
+   * @param p_input - samples following the last block processed
+   * @param p_output - filtered samples, may be the same memory as p_input,
+   * filters the first min(p_input.size(), p_output.size()) samples
+   * @param p_kernel - inner loops to run
+   */
+  void process(std::span<q15 const> p_input,
+               std::span<q15> p_output,
+               dsp_kernel p_kernel = native_dsp_kernel);
+
+  /// Forget the samples seen, as if they were all zero
+  void reset();
+
+private:
+  std::span<q15 const> m_coefficients;
+  std::span<q15> m_state;
+};
+
+/**
+ * @brief Coefficients of one biquad stage, in q14 (value * 2^14, -2 to 2)
+ *
+ * y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+ */
+struct biquad_coefficients
+{
+  q15 b0 = 0;
+  q15 b1 = 0;
+  q15 b2 = 0;
+  q15 a1 = 0;
+  q15 a2 = 0;
+};
+
+/**
+ * @brief Samples a biquad stage remembers between blocks
+ */
+struct biquad_state
+{
+  q15 x1 = 0;
+  q15 x2 = 0;
+  q15 y1 = 0;
+  q15 y2 = 0;
+};
+
+/**
+ * @brief Cascade of direct form I biquad stages
+ *
+ * Each stage's output is rounded & saturated to q15 before it feeds the next,
+ * so order the stages by increasing gain to keep the headroom.
+ */
+class biquad_cascade
+{
+public:
+  /**
+   * @brief Construct a new biquad cascade object
+   *
+   * @param p_stages - coefficients of each stage, must outlive the cascade
+   * @param p_state - one state per stage, must outlive the cascade
+   */
+  biquad_cascade(std::span<biquad_coefficients const> p_stages,
+                 std::span<biquad_state> p_state);
+
+  /**
+   * @brief Filter a block of samples
+   *
+   * @param p_input - samples following the last block processed
+   * @param p_output - filtered samples, may be the same memory as p_input,
+   * filters the first min(p_input.size(), p_output.size()) samples
+   * @param p_kernel - inner loops to run
+   */
+  void process(std::span<q15 const> p_input,
+               std::span<q15> p_output,
+               dsp_kernel p_kernel = native_dsp_kernel);
+
+  /// Forget the samples seen, as if they were all zero
+  void reset();
+
+private:
+  std::span<biquad_coefficients const> m_stages;
+  std::span<biquad_state> m_state;
+};
+
+/**
+ * @brief Average of the last N samples, N a power of two
+ *
+ * Keeps a running sum, so the cost per sample does not depend on N.
+ */
+class moving_average
+{
+public:
+  /**
+   * @brief Construct a new moving average object
+   *
+   * @param p_window - storage for the last N samples, N is the largest power
+   * of two that fits, up to 65536, must outlive the filter
+   */
+  moving_average(std::span<q15> p_window);
+
+  /**
+   * @brief Average a block of samples
+   *
+   * @param p_input - samples following the last block processed
+   * @param p_output - averages, may be the same memory as p_input, filters
+   * the first min(p_input.size(), p_output.size()) samples
+   */
+  void process(std::span<q15 const> p_input, std::span<q15> p_output);
+
+  /// Forget the samples seen, as if they were all zero
+  void reset();
+
+private:
+  std::span<q15> m_window;
+  std::size_t m_index = 0;
+  std::int32_t m_sum = 0;
+  int m_shift = 0;
+};
+
+/**
+ * @brief Cascaded integrator comb decimator, a multiplier free low pass that
+ * keeps one in R samples
+ *
+ * Integrators run at the input rate and combs at the output rate, all in
+ * 32-bit wrapping arithmetic. The gain of R^order is divided out exactly, so R
+ * is a power of two, limited so order * log2(R) does not exceed 16.
+ */
+class cic_decimator
+{
+public:
+  /// Most integrator & comb stages
+  static constexpr std::size_t maximum_order = 4;
+
+  /**
+   * @brief Construct a new cic decimator object
+   *
+   * @param p_order - integrator & comb stages, 1 to maximum_order
+   * @param p_ratio - decimation ratio R, rounded down to a power of two &
+   * limited to 2^(16 / order)
+   */
+  cic_decimator(std::size_t p_order, std::size_t p_ratio);
+
+  /**
+   * @brief Decimate a block of samples
+   *
+   * @param p_input - samples following the last block processed
+   * @param p_output - decimated samples, one per R inputs, counting from the
+   * first sample after construction or reset(). Outputs past its end are
+   * dropped.
+   * @return std::size_t - number of samples written to p_output
+   */
+  std::size_t process(std::span<q15 const> p_input, std::span<q15> p_output);
+
+  /// Forget the samples seen, as if they were all zero
+  void reset();
+
+private:
+  std::array<std::uint32_t, maximum_order> m_integrators{};
+  std::array<std::uint32_t, maximum_order> m_combs{};
+  std::size_t m_order;
+  std::size_t m_ratio;
+  std::size_t m_phase = 0;
+  int m_shift;
+};
+}  // namespace hal::micromod
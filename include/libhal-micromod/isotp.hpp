@@ -0,0 +1,371 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include <libhal/can.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include "spsc_ring.hpp"
+#include "tick_converter.hpp"
+
+namespace hal::micromod {
+/// Largest payload of an ISO-TP message, the 32-bit first frame length
+constexpr std::size_t isotp_maximum_length = 0xFFFF'FFFF;
+
+/**
+ * @brief CAN identifiers used by one end of an ISO-TP connection
+ *
+ * Normal addressing, the whole payload of each frame carries protocol data.
+ */
+struct isotp_address
+{
+  /// Identifier of the frames this end sends
+  hal::u32 transmit_id = 0;
+  /// Identifier of the frames the other end sends
+  hal::u32 receive_id = 0;
+  /// Both identifiers are 29-bit extended identifiers
+  bool extended = false;
+};
+
+/**
+ * @brief Settings of an ISO-TP channel
+ */
+struct isotp_settings
+{
+  /// Consecutive frames the sender may send before waiting for a flow
+  /// control frame, 0 to never wait
+  hal::u8 block_size = 0;
+  /// Gap the sender must leave between consecutive frames, rounded up to
+  /// what a flow control frame can encode: 100us steps up to 900us, then
+  /// milliseconds up to 127ms
+  std::chrono::microseconds separation_time{ 0 };
+  /// Longest wait for the next frame of the other end before giving up
+  std::chrono::microseconds timeout = std::chrono::milliseconds(1000);
+  /// Byte frames are padded to 8 bytes with, or no padding, in which case
+  /// frames are only as long as their data
+  std::optional<hal::byte> padding = 0xCC;
+};
+
+/**
+ * @brief State of a transfer of an ISO-TP channel
+ */
+enum class isotp_status : std::uint8_t
+{
+  /// No transfer was started
+  idle,
+  /// Transfer in progress
+  busy,
+  /// Transfer finished successfully
+  complete,
+  /// The other end did not answer in time
+  timed_out,
+  /// The message is larger than the buffer of the receiving end
+  overflow,
+  /// A frame was lost or the other end broke the protocol
+  protocol_error,
+};
+
+/**
+ * @brief Encode a separation time as the STmin byte of a flow control frame
+ *
+ * @param p_separation - separation time
+ * @return constexpr hal::u8 - smallest STmin at least p_separation long
+ */
+constexpr hal::u8 isotp_encode_separation(
+  std::chrono::microseconds p_separation)
+{
+  auto const microseconds = p_separation.count();
+  if (microseconds <= 0) {
+    return 0;
+  }
+  if (microseconds <= 900) {
+    return static_cast<hal::u8>(0xF0 + ((microseconds + 99) / 100));
+  }
+  auto const milliseconds = (microseconds + 999) / 1000;
+  return static_cast<hal::u8>(milliseconds > 127 ? 127 : milliseconds);
+}
+
+/**
+ * @brief Decode the STmin byte of a flow control frame
+ *
+ * Reserved values are treated as the longest separation time, 127ms, as
+ * ISO 15765-2 requires.
+ *
+ * @param p_byte - STmin byte
+ * @return constexpr hal::u32 - separation time in microseconds
+ */
+constexpr hal::u32 isotp_decode_separation(hal::u8 p_byte)
+{
+  if (p_byte <= 0x7F) {
+    return p_byte * 1000U;
+  }
+  if (p_byte >= 0xF1 && p_byte <= 0xF9) {
+    return (p_byte - 0xF0U) * 100U;
+  }
+  return 127'000;
+}
+
+class isotp_router;
+
+/**
+ * @brief One end of an ISO-TP (ISO 15765-2) connection
+ *
+ * Sends and receives messages of up to 4GiB over classic CAN frames, both
+ * directions at once. Neither direction copies the message: send() segments
+ * it straight out of the caller's span and reception reassembles it straight
+ * into the caller's buffer, so both must stay valid until the transfer ends.
+ *
+ * A channel does nothing on its own, an isotp_router delivers its frames and
+ * drives its timing.
+ *
+ * Usage:
+ *
+ *   hal::micromod::isotp_channel channel({ .transmit_id = 0x7E0,
+ *                                          .receive_id = 0x7E8 });
+ *   std::array<hal::byte, 4096> buffer;
+ *   channel.receive(buffer);
+ *   // ... router.poll() from the main loop
+ *   if (channel.receive_status() == hal::micromod::isotp_status::complete) {
+ *     use(channel.received());
+ *     channel.receive(buffer);
+ *   }
+ */
+class isotp_channel
+{
+public:
+  /**
+   * @brief Construct a new isotp channel object
+   *
+   * @param p_address - identifiers of both ends
+   * @param p_settings - flow control & timing settings
+   */
+  explicit isotp_channel(isotp_address const& p_address,
+                         isotp_settings const& p_settings = {});
+
+  isotp_channel(isotp_channel const&) = delete;
+  isotp_channel& operator=(isotp_channel const&) = delete;
+  isotp_channel(isotp_channel&&) = delete;
+  isotp_channel& operator=(isotp_channel&&) = delete;
+  ~isotp_channel() = default;
+
+  /**
+   * @brief Start sending a message
+   *
+   * Messages of up to 7 bytes are sent as a single frame, longer ones as a
+   * first frame followed by consecutive frames, paced by the flow control
+   * frames of the other end. The router sends the frames from poll().
+   *
+   * @param p_data - message, must stay valid & unchanged until
+   * transmit_status() is no longer busy
+   * @return true - the transfer was started
+   * @return false - a transfer is already in progress, or p_data is empty or
+   * longer than isotp_maximum_length
+   */
+  [[nodiscard]] bool send(std::span<hal::byte const> p_data);
+
+  /**
+   * @brief Set the buffer the next message is received into
+   *
+   * Resets the receive status to idle. While no buffer is set, or after a
+   * message was received and until this is called again, messages longer
+   * than a single frame are refused with an overflow flow control frame.
+   *
+   * @param p_buffer - buffer, must stay valid until the message is received
+   */
+  void receive(std::span<hal::byte> p_buffer);
+
+  /// State of the last transfer started by send()
+  [[nodiscard]] isotp_status transmit_status() const;
+  /// State of the reception into the buffer set by receive()
+  [[nodiscard]] isotp_status receive_status() const;
+
+  /**
+   * @brief Get the message received
+   *
+   * @return std::span<hal::byte const> - the message within the receive
+   * buffer, empty unless receive_status() is complete.
+   */
+  [[nodiscard]] std::span<hal::byte const> received() const;
+
+  /// Identifiers of both ends
+  [[nodiscard]] isotp_address const& address() const;
+
+private:
+  friend class isotp_router;
+
+  enum class transmit_state : std::uint8_t
+  {
+    idle,
+    first_frame,
+    wait_for_flow_control,
+    consecutive_frames,
+  };
+
+  enum class receive_state : std::uint8_t
+  {
+    idle,
+    consecutive_frames,
+    done,
+  };
+
+  /// Handle a frame from the other end
+  void process(isotp_router& p_router,
+               hal::can_message const& p_message,
+               hal::u64 p_now);
+  void process_flow_control(hal::can_message const& p_message,
+                            hal::u64 p_now);
+  void process_single_frame(hal::can_message const& p_message);
+  void process_first_frame(isotp_router& p_router,
+                           hal::can_message const& p_message,
+                           hal::u64 p_now);
+  void process_consecutive_frame(isotp_router& p_router,
+                                 hal::can_message const& p_message,
+                                 hal::u64 p_now);
+  /**
+   * @brief Send the next frame due, if any
+   *
+   * @return true - a frame was sent
+   */
+  bool transmit(isotp_router& p_router, hal::u64 p_now);
+  void check_timeouts(hal::u64 p_now);
+  void send_flow_control(isotp_router& p_router, hal::u8 p_status);
+
+  isotp_address m_address;
+  isotp_settings m_settings;
+
+  // Transmit direction
+  std::span<hal::byte const> m_transmit_data;
+  std::size_t m_transmit_offset = 0;
+  /// Microsecond uptime the next frame may be sent at, or when the wait for
+  /// a flow control frame times out
+  hal::u64 m_transmit_time = 0;
+  hal::u32 m_separation = 0;
+  hal::u8 m_block_size = 0;
+  hal::u8 m_block_remaining = 0;
+  hal::u8 m_transmit_sequence = 0;
+  transmit_state m_transmit_state = transmit_state::idle;
+  isotp_status m_transmit_status = isotp_status::idle;
+
+  // Receive direction
+  std::span<hal::byte> m_receive_buffer;
+  std::size_t m_receive_length = 0;
+  std::size_t m_receive_offset = 0;
+  /// Microsecond uptime the wait for the next consecutive frame times out
+  hal::u64 m_receive_deadline = 0;
+  hal::u8 m_receive_sequence = 0;
+  hal::u8 m_receive_block = 0;
+  receive_state m_receive_state = receive_state::idle;
+  isotp_status m_receive_status = isotp_status::idle;
+};
+
+/**
+ * @brief Counters kept by an isotp_router
+ */
+struct isotp_statistics
+{
+  /// Frames addressed to one of the channels
+  hal::u32 received = 0;
+  /// Frames dropped because the receive ring was full
+  hal::u32 dropped = 0;
+  /// Frames sent by the channels
+  hal::u32 sent = 0;
+};
+
+/**
+ * @brief Carries the frames of several ISO-TP channels over one CAN bus
+ *
+ * The receive interrupt only picks out the frames addressed to one of the
+ * channels and pushes them into a lock free ring. poll(), called from the
+ * main loop, hands those frames to their channels, sends at most one frame
+ * per channel & checks the timeouts, so the channels are only ever touched by
+ * the main loop and channels sending at the same time take turns frame by
+ * frame.
+ *
+ * Timing is only as fine as the rate poll() is called at, so poll() should
+ * run in a tight loop while a transfer is in progress. A receiving channel
+ * must not request a separation time shorter than the other end can honor.
+ * Received frames wait in the ring until the next poll(), so the ring must
+ * hold the frames that arrive between two calls.
+ */
+class isotp_router
+{
+public:
+  /**
+   * @brief Construct a new isotp router object & register its receive handler
+   *
+   * @param p_transceiver - transceiver the frames are sent with
+   * @param p_interrupt - receive interrupt of the same bus
+   * @param p_clock - clock timing the separation times & timeouts
+   * @param p_channels - channels to carry, must outlive the router & each
+   * have a distinct receive identifier
+   * @param p_buffer - storage for the receive ring, must outlive the router
+   */
+  isotp_router(hal::can_transceiver& p_transceiver,
+               hal::can_interrupt& p_interrupt,
+               hal::steady_clock& p_clock,
+               std::span<isotp_channel* const> p_channels,
+               std::span<hal::can_message> p_buffer);
+
+  isotp_router(isotp_router const&) = delete;
+  isotp_router& operator=(isotp_router const&) = delete;
+  isotp_router(isotp_router&&) = delete;
+  isotp_router& operator=(isotp_router&&) = delete;
+  ~isotp_router();
+
+  /**
+   * @brief Deliver received frames, send the frames due & check timeouts
+   *
+   * Sends at most one frame per channel, waiting for the transceiver to
+   * accept it.
+   */
+  void poll();
+
+  /**
+   * @brief Get the router's counters
+   *
+   * @return isotp_statistics - counters since construction
+   */
+  [[nodiscard]] isotp_statistics statistics() const;
+
+private:
+  friend class isotp_channel;
+
+  void capture(hal::can_message const& p_message);
+  void deliver(hal::u64 p_now);
+  void send(isotp_channel const& p_channel,
+            std::span<hal::byte const> p_data);
+  [[nodiscard]] hal::u64 now() const;
+
+  hal::can_transceiver* m_transceiver;
+  hal::can_interrupt* m_interrupt;
+  hal::steady_clock* m_clock;
+  tick_converter m_to_time;
+  std::span<isotp_channel* const> m_channels;
+  spsc_ring<hal::can_message> m_ring;
+  /// Written by the interrupt only
+  std::atomic<hal::u32> m_received = 0;
+  std::atomic<hal::u32> m_dropped = 0;
+  hal::u32 m_sent = 0;
+};
+}  // namespace hal::micromod
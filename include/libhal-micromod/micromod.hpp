@@ -30,6 +30,16 @@
 #include <libhal/steady_clock.hpp>
 #include <libhal/timer.hpp>
 
+#include "analog_stream.hpp"
+#include "can_statistics.hpp"
+#include "can_timestamp.hpp"
+#include "can_transmit_queue.hpp"
+#include "dac_stream.hpp"
+#include "pwm_group.hpp"
+#include "tick_converter.hpp"
+#include "timer_wheel.hpp"
+#include "transmit_ring.hpp"
+
 namespace hal::micromod::v1 {
 // =============================================================================
 // CORE
@@ -45,9 +55,76 @@ namespace hal::micromod::v1 {
  */
 void initialize_platform();
 
+/**
+ * @brief Drivers that can be constructed ahead of their first use
+ *
+ * The same pin must not be selected as both an output and an input.
+ */
+enum class eager_driver : hal::u8
+{
+  output_g0,
+  output_g1,
+  output_g2,
+  output_g3,
+  output_g4,
+  output_g5,
+  output_g6,
+  output_g7,
+  output_g8,
+  output_g9,
+  output_g10,
+  input_g0,
+  input_g1,
+  input_g2,
+  input_g3,
+  input_g4,
+  input_g5,
+  input_g6,
+  input_g7,
+  input_g8,
+  input_g9,
+  input_g10,
+};
+
+/**
+ * @brief Construct a driver ahead of its first use
+ *
+ * By default, each driver is constructed by the first call to its accessor and
+ * every call checks a static guard. When the library is built with eager
+ * initialization (the `eager_initialization` package option), the uptime clock
+ * and led are constructed by initialize_platform(), and the accessors of the
+ * drivers in `eager_driver` return their driver without any check. Those
+ * drivers must be constructed with this function, once, before their accessor
+ * is called. Without eager initialization, this constructs the driver early.
+ *
+ * Drivers for pins the board does not have are ignored.
+ *
+ * @param p_driver - driver to construct
+ */
+void initialize_driver(eager_driver p_driver);
+
+/**
+ * @brief Construct a list of drivers ahead of their first use
+ *
+ * Call after initialize_platform(). See initialize_driver().
+ *
+ * @tparam drivers - drivers to construct
+ */
+template<eager_driver... drivers>
+void initialize_board()
+{
+  (initialize_driver(drivers), ...);
+}
+
 /**
  * @brief steady clock to measures the cycles the processor has been up.
  *
+ * The uptime is a 64-bit count that never wraps, and may be read from any
+ * context, including interrupts, without locking. On the microcontroller
+ * boards the underlying 32-bit cycle counter is kept extended by a periodic
+ * interrupt started in initialize_platform(). Use hal::micromod::tick_converter
+ * to convert the count to nanoseconds or microseconds.
+ *
  * @return hal::steady_clock& - system uptime steady clock.
  */
 [[nodiscard]] hal::steady_clock& uptime_clock();
@@ -61,13 +138,72 @@ void initialize_platform();
  */
 [[nodiscard]] hal::timer& system_timer();
 
+/**
+ * @brief Software timeouts multiplexed onto the system timer
+ *
+ * Schedule any number of hal::micromod::timeout objects, with a resolution of
+ * 1ms. The wheel takes ownership of the system timer, so do not use
+ * system_timer() directly once this has been called.
+ *
+ * @return hal::micromod::timer_wheel& - reference to the timer wheel
+ */
+[[nodiscard]] hal::micromod::timer_wheel& system_timer_wheel();
+
 /**
  * @brief Enter power savings mode for your processor
  *
- * Generally needs an interrupt to wake up the device from sleep
+ * Generally needs an interrupt to wake up the device from sleep. The processor
+ * waits for an interrupt with its core clock stopped, no periodic tick is run,
+ * so it sleeps until the next interrupt, including the system timer being due
+ * for the next pending system_timer_wheel() timeout. uptime_clock() is
+ * corrected for any cycles it did not count while the core was stopped.
+ *
+ * May return early, call in a loop that checks for the awaited condition.
  */
 void enter_power_saving_mode();
 
+/**
+ * @brief Time spent in enter_power_saving_mode()
+ */
+struct sleep_statistics
+{
+  /// Number of times the processor went to sleep
+  hal::u64 sleeps = 0;
+  /// Total time spent asleep in uptime_clock() ticks
+  hal::u64 asleep_ticks = 0;
+};
+
+/**
+ * @brief Get the time spent in enter_power_saving_mode() since startup
+ *
+ * Compare against uptime_clock() to get the fraction of time the processor
+ * was idle.
+ *
+ * @return sleep_statistics - counters since startup
+ */
+[[nodiscard]] sleep_statistics power_saving_statistics();
+
+/**
+ * @brief Sleep until uptime_clock() reaches a tick count
+ *
+ * Unlike hal::delay(), which spins on the clock, this schedules a timeout on
+ * system_timer_wheel() and calls enter_power_saving_mode() until it expires.
+ * Returns no earlier than the deadline, and generally within one wheel tick
+ * (1ms) after it. Must not be called from an interrupt.
+ *
+ * @param p_uptime - uptime_clock() tick count to wake up at
+ */
+void sleep_until(hal::u64 p_uptime);
+
+/**
+ * @brief Sleep for a duration
+ *
+ * See sleep_until().
+ *
+ * @param p_duration - time to sleep for
+ */
+void sleep_for(hal::time_duration p_duration);
+
 /**
  * @brief Console serial interface
  *
@@ -84,6 +220,30 @@ void enter_power_saving_mode();
  */
 [[nodiscard]] hal::serial& console(std::span<hal::byte> p_receive_buffer);
 
+/**
+ * @brief Set what console() writes do when the transmit buffer is full
+ *
+ * On the microcontroller boards, console() writes are copied into a transmit
+ * ring buffer and sent by DMA, so write() returns without waiting for the data
+ * to go out. The default, overflow_policy::block, waits for room when the
+ * buffer is full, so no data is lost. The drop policies never wait, use them
+ * where a stalled write would be worse than missing output, such as in control
+ * loops or interrupts. Blocking writes must not be made from interrupts.
+ *
+ * May be called before or after the console is first used.
+ *
+ * @param p_policy - what to do with data that does not fit
+ */
+void console_overflow_policy(hal::micromod::overflow_policy p_policy);
+
+/**
+ * @brief Get the console's transmit counters
+ *
+ * @return hal::micromod::transmit_statistics - bytes written & dropped, and
+ * the peak use of the transmit buffer.
+ */
+[[nodiscard]] hal::micromod::transmit_statistics console_statistics();
+
 /**
  * @brief Retrieve a serial console with a statically allocated receive buffer
  *
@@ -167,10 +327,25 @@ void enter_power_saving_mode();
 /**
  * @brief Driver for battery analog signal which is 1/3rd of the VIN voltage
  *
+ * Not available on the STM32F1 boards, which do not route BATT_VIN/3 to an
+ * ADC pin.
+ *
  * @return hal::adc& - Statically allocated battery analog pin driver.
  */
 [[nodiscard]] hal::adc& battery();
 
+/**
+ * @brief Stream of frames sampling a0, a1 & battery together at a fixed rate
+ *
+ * Conversions run in the background; a0(), a1() and battery() read the latest
+ * frame of this stream, or the latest oversampled result once oversampling()
+ * is set on it. The STM32F1 boards sample the internal reference in place of
+ * the battery, which no accessor reads.
+ *
+ * @return hal::micromod::analog_stream& - Statically allocated analog stream.
+ */
+[[nodiscard]] hal::micromod::analog_stream& analog_inputs();
+
 // =============================================================================
 // DAC
 // =============================================================================
@@ -185,10 +360,27 @@ void enter_power_saving_mode();
 /**
  * @brief Driver for dac pin 1
  *
+ * Not provided by the lpc40 board, the LPC4078 has a single DAC.
+ *
  * @return hal::dac& - Statically allocated dac pin driver.
  */
 [[nodiscard]] hal::dac& d1();
 
+/**
+ * @brief Stream of samples played on dac pin 0 at a fixed rate
+ *
+ * The hardware plays each block of samples without the cpu, write() only has
+ * to fill a block within each block period. Shares the DAC with d0(), whose
+ * writes the stream overrides once it exists. Provided by the lpc40 & host
+ * boards.
+ *
+ * @param p_sample_rate - samples played per second. Note that subsequent
+ * calls to the function will ignore this parameter, thus the first call will
+ * set the sample rate.
+ * @return hal::micromod::dac_stream& - Statically allocated dac stream.
+ */
+[[nodiscard]] hal::micromod::dac_stream& d0_stream(hal::hertz p_sample_rate);
+
 // =============================================================================
 // PWM
 // =============================================================================
@@ -196,17 +388,43 @@ void enter_power_saving_mode();
 /**
  * @brief Driver for pwm pin 0
  *
+ * On the stm32f1 boards this is TIM1 channel 1, and a new duty cycle takes
+ * effect at the end of the current period. On the lpc40 it is PWM1 channel 6,
+ * which shares its frequency with pwm1().
+ *
  * @return hal::pwm& - Statically allocated pwm pin driver.
+ * @throws hal::device_or_resource_busy - on the stm32f1 boards & the host, if
+ * synchronized_pwm() was called before
  */
 [[nodiscard]] hal::pwm& pwm0();
 
 /**
  * @brief Driver for pwm pin 1
  *
+ * On the stm32f1 boards this is TIM2 channel 2, on the lpc40 PWM1 channel 5.
+ *
  * @return hal::pwm& - Statically allocated pwm pin driver.
+ * @throws hal::device_or_resource_busy - on the stm32f1 boards & the host, if
+ * synchronized_pwm() was called before
  */
 [[nodiscard]] hal::pwm& pwm1();
 
+/**
+ * @brief Driver for pwm pins 0 & 1 as a group sharing one period
+ *
+ * Duty cycles are committed to both outputs at once, & A0 & A1 are converted
+ * at the center of every pulse, see hal::micromod::pwm_group. On the stm32f1
+ * boards this is TIM1 & TIM2 counting in lockstep, with ADC2 triggered by
+ * TIM1 & reserved for it. Uses the same timers & pins as pwm0() & pwm1(), so
+ * it may not be used alongside them. Not provided by the lpc40 board, whose
+ * ADC cannot be triggered by its PWM.
+ *
+ * @return hal::micromod::pwm_group& - Statically allocated pwm group driver.
+ * @throws hal::device_or_resource_busy - on the stm32f1 boards & the host, if
+ * pwm0() or pwm1() was called before
+ */
+[[nodiscard]] hal::micromod::pwm_group& synchronized_pwm();
+
 // =============================================================================
 // I2C
 // =============================================================================
@@ -380,6 +598,62 @@ hal::interrupt_pin& spi_interrupt_pin();
  */
 [[nodiscard]] hal::can_interrupt& can_interrupt();
 
+/**
+ * @brief Get the counters of the queue can_transceiver() sends through
+ *
+ * On the STM32F1 boards, send() queues the message by arbitration priority
+ * and returns, waiting only while the queue is full. The transmit interrupt
+ * keeps the mailboxes loaded with the most urgent messages. The other boards
+ * hand each message straight to the controller and return zeroed counters.
+ *
+ * @return hal::micromod::can_transmit_statistics - queue depth & latency
+ * counters since can_transceiver() was first called, latencies in
+ * uptime_clock() ticks.
+ */
+[[nodiscard]] hal::micromod::can_transmit_statistics
+can_transmit_queue_statistics();
+
+/**
+ * @brief Take a snapshot of the CAN bus' traffic & error counters
+ *
+ * Counting starts with the first use of a CAN accessor other than the
+ * deprecated can(). The snapshot only reads counters & registers, it is cheap
+ * enough to take every main loop iteration. Compute frame rates & bus load
+ * between two snapshots with hal::micromod::can_bus_rates, or print them
+ * periodically with hal::micromod::can_statistics_report.
+ *
+ * @return hal::micromod::can_bus_statistics - counters since the bus was first
+ * used, timestamped with uptime_clock()
+ */
+[[nodiscard]] hal::micromod::can_bus_statistics can_statistics();
+
+/**
+ * @brief Get the uptime at the start of frame of the message being received
+ *
+ * Call from a can_interrupt() receive handler. The STM32F1 boards capture the
+ * start of frame in hardware, so the timestamp is free of the interrupt
+ * latency jitter and late by a constant, the shortest latency seen (see
+ * hal::micromod::can_timestamp_extender). Other boards return the uptime when
+ * called.
+ *
+ * @return hal::u64 - uptime_clock() ticks at the start of frame of the last
+ * message received
+ */
+[[nodiscard]] hal::u64 can_receive_timestamp();
+
+/**
+ * @brief Set the handler called as each message finishes sending
+ *
+ * The handler runs in the transmit interrupt & gets the message with the
+ * uptime at its start of frame, which the STM32F1 boards capture in hardware
+ * like can_receive_timestamp(). Other boards pass the uptime when the
+ * transmit interrupt ran. Aborted messages are not reported.
+ *
+ * @param p_handler - handler, or std::nullopt to remove it
+ */
+void can_on_transmit(
+  hal::micromod::optional_can_transmit_handler const& p_handler);
+
 /**
  * @brief can bus identifier filter 0
  *
@@ -0,0 +1,148 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+#include <libhal/functional.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::micromod {
+/// Outputs of a pwm_group, pwm0 then pwm1
+constexpr std::size_t pwm_group_channels = 2;
+
+/**
+ * @brief A0 & A1 converted together at the center of a PWM pulse
+ */
+struct pwm_center_sample
+{
+  /// Samples from 0 to analog_full_scale
+  hal::u16 a0 = 0;
+  hal::u16 a1 = 0;
+  /// Samples converted before this one, one is converted per period
+  hal::u32 period = 0;
+};
+
+/**
+ * @brief Counters kept by a pwm_group
+ */
+struct pwm_group_statistics
+{
+  /// Duty cycle & frequency updates committed
+  hal::u32 commits = 0;
+  /// Commits that waited for the counters to reach the part of the period
+  /// commits are written in
+  hal::u32 waits = 0;
+  /// Center samples converted
+  hal::u32 samples = 0;
+};
+
+/**
+ * @brief PWM outputs sharing one period, updated together & sampling the
+ * analog inputs in step with it
+ *
+ * The outputs are center aligned: each pulse is centered on the same instant
+ * of every period, whatever its duty cycle. A set of duty cycles is committed
+ * as a whole and takes effect on every output at the same update event, so a
+ * control loop never drives one output with a new value & another with an old
+ * one. A0 & A1 are converted at the center of the pulses by the hardware, so
+ * the sampling instant does not depend on interrupt latency.
+ *
+ * A control loop runs in the center sample handler: it gets the samples of
+ * the period that just crossed its center, & the duty cycles it commits take
+ * effect at the next update event.
+ */
+class pwm_group
+{
+public:
+  using center_sample_handler = void(pwm_center_sample const&);
+  using optional_center_sample_handler =
+    std::optional<hal::callback<center_sample_handler>>;
+
+  pwm_group() = default;
+  pwm_group(pwm_group const&) = delete;
+  pwm_group& operator=(pwm_group const&) = delete;
+  pwm_group(pwm_group&&) = delete;
+  pwm_group& operator=(pwm_group&&) = delete;
+  virtual ~pwm_group() = default;
+
+  /**
+   * @brief Change the frequency of every output
+   *
+   * Committed like the duty cycles, which keep their values.
+   *
+   * @param p_frequency - PWM frequency, rounded to what the hardware reaches
+   */
+  void frequency(hal::hertz p_frequency)
+  {
+    driver_frequency(p_frequency);
+  }
+
+  /**
+   * @brief Get the frequency the outputs actually run at
+   *
+   * @return hal::hertz - PWM frequency after rounding
+   */
+  [[nodiscard]] hal::hertz frequency()
+  {
+    return driver_actual_frequency();
+  }
+
+  /**
+   * @brief Commit the duty cycle of every output
+   *
+   * May be called from the center sample handler.
+   *
+   * @param p_duty_cycles - high time over the period of each output, in
+   * pwm0, pwm1 order, limited to 0 to 1
+   */
+  void duty_cycles(std::array<float, pwm_group_channels> const& p_duty_cycles)
+  {
+    driver_duty_cycles(p_duty_cycles);
+  }
+
+  /**
+   * @brief Set the handler called with each center sample
+   *
+   * @param p_handler - called from an interrupt once both inputs are
+   * converted, std::nullopt to stop calling it
+   */
+  void on_center_sample(optional_center_sample_handler const& p_handler)
+  {
+    driver_on_center_sample(p_handler);
+  }
+
+  /**
+   * @brief Get the group's counters
+   *
+   * @return pwm_group_statistics - counters since construction
+   */
+  [[nodiscard]] pwm_group_statistics statistics()
+  {
+    return driver_statistics();
+  }
+
+private:
+  virtual void driver_frequency(hal::hertz p_frequency) = 0;
+  virtual hal::hertz driver_actual_frequency() = 0;
+  virtual void driver_duty_cycles(
+    std::array<float, pwm_group_channels> const& p_duty_cycles) = 0;
+  virtual void driver_on_center_sample(
+    optional_center_sample_handler const& p_handler) = 0;
+  virtual pwm_group_statistics driver_statistics() = 0;
+};
+}  // namespace hal::micromod
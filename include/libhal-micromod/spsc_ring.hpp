@@ -0,0 +1,139 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <span>
+
+namespace hal::micromod {
+/**
+ * @brief Lock free ring buffer with a single producer and a single consumer
+ *
+ * The producer, typically an interrupt, calls push(). The consumer reads the
+ * oldest element in place with front() and frees it with pop(). Neither side
+ * ever waits for the other or masks interrupts, each index is written by one
+ * side only and published with release/acquire ordering.
+ *
+ * One element of the buffer is left unused to tell a full ring from an empty
+ * one, so a buffer of N elements holds N - 1.
+ *
+ * @tparam T - element type
+ */
+template<class T>
+class spsc_ring
+{
+public:
+  /**
+   * @brief Construct a new spsc ring object
+   *
+   * @param p_buffer - storage for the ring, must outlive it & hold at least 2
+   * elements.
+   */
+  explicit spsc_ring(std::span<T> p_buffer)
+    : m_buffer(p_buffer)
+  {
+  }
+
+  spsc_ring(spsc_ring const&) = delete;
+  spsc_ring& operator=(spsc_ring const&) = delete;
+  spsc_ring(spsc_ring&&) = delete;
+  spsc_ring& operator=(spsc_ring&&) = delete;
+  ~spsc_ring() = default;
+
+  /**
+   * @brief Append an element, called by the producer only
+   *
+   * @param p_value - element to append
+   * @return true - the element was appended
+   * @return false - the ring is full, the element was not appended
+   */
+  bool push(T const& p_value)
+  {
+    auto const head = m_head.load(std::memory_order_relaxed);
+    auto const next = advance(head);
+    if (next == m_tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    m_buffer[head] = p_value;
+    m_head.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Get the oldest element, called by the consumer only
+   *
+   * @return T* - the oldest element, valid until pop(), or nullptr if the ring
+   * is empty.
+   */
+  [[nodiscard]] T* front()
+  {
+    auto const tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return &m_buffer[tail];
+  }
+
+  /**
+   * @brief Free the oldest element, called by the consumer only
+   *
+   * Must only be called when front() returned an element.
+   */
+  void pop()
+  {
+    auto const tail = m_tail.load(std::memory_order_relaxed);
+    m_tail.store(advance(tail), std::memory_order_release);
+  }
+
+  /**
+   * @brief Get the number of elements in the ring
+   *
+   * Exact when called by either side, the other side may change it at any
+   * time.
+   *
+   * @return std::size_t - number of elements
+   */
+  [[nodiscard]] std::size_t size() const
+  {
+    auto const head = m_head.load(std::memory_order_acquire);
+    auto const tail = m_tail.load(std::memory_order_acquire);
+    return head >= tail ? head - tail : head + m_buffer.size() - tail;
+  }
+
+  /**
+   * @brief Get the number of elements the ring can hold
+   *
+   * @return std::size_t - one less than the buffer size
+   */
+  [[nodiscard]] std::size_t capacity() const
+  {
+    return m_buffer.size() - 1;
+  }
+
+private:
+  [[nodiscard]] std::size_t advance(std::size_t p_index) const
+  {
+    // Compare rather than use modulo to avoid a division
+    return p_index + 1 == m_buffer.size() ? 0 : p_index + 1;
+  }
+
+  std::span<T> m_buffer;
+  /// Next element to write, written by the producer only
+  std::atomic<std::size_t> m_head = 0;
+  /// Oldest element, written by the consumer only
+  std::atomic<std::size_t> m_tail = 0;
+};
+}  // namespace hal::micromod
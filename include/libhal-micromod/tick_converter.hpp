@@ -0,0 +1,157 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include <libhal/units.hpp>
+
+namespace hal::micromod {
+/**
+ * @brief Converts tick counts of a steady clock to nanoseconds & microseconds
+ *
+ * Each conversion multiplies by a fixed point ratio computed once from the
+ * clock's frequency, using 32-bit multiplies and no division, so it is cheap
+ * enough to use from interrupts. The ratio is rounded up to 64 significant
+ * bits, so the results are exact, rounded down, for over a year of ticks.
+ *
+ * Usage:
+ *
+ *   auto& clock = hal::micromod::v1::uptime_clock();
+ *   hal::micromod::tick_converter const to_time(clock.frequency());
+ *   auto const microseconds = to_time.microseconds(clock.uptime());
+ */
+class tick_converter
+{
+public:
+  /**
+   * @brief Construct a new tick converter object
+   *
+   * @param p_frequency - tick rate of the clock, at least 1Hz
+   */
+  constexpr explicit tick_converter(hal::hertz p_frequency)
+    : m_nanoseconds(make_ratio(1'000'000'000, p_frequency))
+    , m_microseconds(make_ratio(1'000'000, p_frequency))
+  {
+  }
+
+  /**
+   * @brief Convert ticks to nanoseconds
+   *
+   * @param p_ticks - clock ticks
+   * @return hal::u64 - nanoseconds, rounded down to within 1ns
+   */
+  [[nodiscard]] constexpr hal::u64 nanoseconds(hal::u64 p_ticks) const
+  {
+    return multiply(p_ticks, m_nanoseconds);
+  }
+
+  /**
+   * @brief Convert ticks to microseconds
+   *
+   * @param p_ticks - clock ticks
+   * @return hal::u64 - microseconds, rounded down to within 1us
+   */
+  [[nodiscard]] constexpr hal::u64 microseconds(hal::u64 p_ticks) const
+  {
+    return multiply(p_ticks, m_microseconds);
+  }
+
+  /**
+   * @brief Convert ticks to a duration
+   *
+   * @param p_ticks - clock ticks
+   * @return hal::time_duration - duration of the ticks
+   */
+  [[nodiscard]] constexpr hal::time_duration duration(hal::u64 p_ticks) const
+  {
+    return hal::time_duration(
+      static_cast<hal::time_duration::rep>(nanoseconds(p_ticks)));
+  }
+
+private:
+  /// Units per tick as `multiplier / 2^shift`
+  struct ratio
+  {
+    hal::u64 multiplier;
+    unsigned shift;
+  };
+
+  static constexpr ratio make_ratio(hal::u64 p_units_per_second,
+                                    hal::hertz p_frequency)
+  {
+    // A float is an integer divided by a power of two, so find both & divide
+    // by the integer exactly
+    auto frequency = p_frequency < 1.0f ? 1.0 : double{ p_frequency };
+    unsigned fraction_bits = 0;
+    while (static_cast<double>(static_cast<hal::u64>(frequency)) != frequency) {
+      frequency *= 2.0;
+      fraction_bits++;
+    }
+    auto const divisor = static_cast<hal::u64>(frequency);
+
+    // Long division, a bit at a time, to 64 significant bits
+    constexpr hal::u64 top_bit = hal::u64{ 1 } << 63;
+    auto quotient = p_units_per_second / divisor;
+    auto remainder = p_units_per_second % divisor;
+    unsigned shift = 0;
+    while (quotient < top_bit) {
+      remainder <<= 1;
+      quotient <<= 1;
+      if (remainder >= divisor) {
+        remainder -= divisor;
+        quotient |= 1;
+      }
+      shift++;
+    }
+    // Round up, so whole units are not rounded down to the unit below
+    if (remainder != 0 && quotient != ~hal::u64{ 0 }) {
+      quotient++;
+    }
+    return { .multiplier = quotient, .shift = shift - fraction_bits };
+  }
+
+  /// (p_ticks * multiplier) >> shift from 32-bit partial products
+  static constexpr hal::u64 multiply(hal::u64 p_ticks, ratio p_ratio)
+  {
+    constexpr hal::u64 low_mask = 0xFFFF'FFFF;
+    auto const a_high = p_ticks >> 32;
+    auto const a_low = p_ticks & low_mask;
+    auto const b_high = p_ratio.multiplier >> 32;
+    auto const b_low = p_ratio.multiplier & low_mask;
+
+    auto const low_low = a_low * b_low;
+    auto const low_high = a_low * b_high;
+    auto const high_low = a_high * b_low;
+    auto const middle =
+      (low_low >> 32) + (low_high & low_mask) + (high_low & low_mask);
+    auto const product_low = (middle << 32) | (low_low & low_mask);
+    auto const product_high =
+      (a_high * b_high) + (low_high >> 32) + (high_low >> 32) + (middle >> 32);
+
+    auto const shift = p_ratio.shift;
+    if (shift == 0) {
+      return product_low;
+    }
+    if (shift >= 64) {
+      return product_high >> (shift - 64);
+    }
+    return (product_high << (64 - shift)) | (product_low >> shift);
+  }
+
+  ratio m_nanoseconds;
+  ratio m_microseconds;
+};
+}  // namespace hal::micromod
@@ -0,0 +1,209 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include <libhal/lock.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/timer.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::micromod {
+class timer_wheel;
+
+/**
+ * @brief A software timeout that can be scheduled on a timer_wheel
+ *
+ * The timeout is an intrusive list node, owned by the caller, so scheduling
+ * never allocates. Destroying a pending timeout cancels it.
+ */
+class timeout
+{
+public:
+  /**
+   * @brief Construct a new timeout object
+   *
+   * @param p_handler - called from the timer interrupt when the timeout
+   * expires. It may schedule or cancel any timeout, including this one.
+   */
+  explicit timeout(hal::callback<void(void)> p_handler);
+
+  timeout(timeout const&) = delete;
+  timeout& operator=(timeout const&) = delete;
+  timeout(timeout&&) = delete;
+  timeout& operator=(timeout&&) = delete;
+  ~timeout();
+
+  /**
+   * @brief Determine if the timeout is scheduled and has not expired yet
+   *
+   * @return true - the handler has yet to be called
+   */
+  [[nodiscard]] bool is_pending() const;
+
+private:
+  friend class timer_wheel;
+
+  hal::callback<void(void)> m_handler;
+  timer_wheel* m_wheel = nullptr;
+  timeout* m_next = nullptr;
+  timeout* m_previous = nullptr;
+  /// Expiry in wheel ticks
+  hal::u64 m_expiry = 0;
+  /// Index of the timer_wheel list holding the timeout
+  std::uint16_t m_list = 0;
+};
+
+/**
+ * @brief Multiplexes many software timeouts onto a single hal::timer
+ *
+ * Timeouts are kept in a hierarchical timer wheel: `levels` wheels of
+ * `slots_per_level` slots, where each level covers a range 64 times longer than
+ * the one below it. Scheduling and cancelling are O(1). A timeout is placed in
+ * the level where its expiry first differs from the current time, and moved
+ * down a level (cascaded) each time the current time reaches its slot, so
+ * expiry only touches the timeouts that are due.
+ *
+ * The hardware timer is not run periodically. It is scheduled for the next
+ * tick where a slot needs to be processed, limited to `p_maximum_delay`, and
+ * cancelled when no timeouts are pending. Ticks are derived from the steady
+ * clock so late timer interrupts do not accumulate drift.
+ *
+ * The timer wheel owns the hal::timer it is given. The lock must exclude the
+ * timer's callback context, on a microcontroller it should mask interrupts.
+ */
+class timer_wheel
+{
+public:
+  static constexpr std::size_t levels = 4;
+  static constexpr std::size_t slot_bits = 6;
+  static constexpr std::size_t slots_per_level = 1 << slot_bits;
+
+  /**
+   * @brief Construct a new timer wheel object
+   *
+   * @param p_clock - clock used as the time base of the wheel
+   * @param p_timer - hardware timer driving the wheel
+   * @param p_lock - lock protecting the wheel from the timer's callback
+   * @param p_resolution - duration of a wheel tick, timeouts are rounded up to
+   * a multiple of this.
+   * @param p_maximum_delay - longest delay the timer can be scheduled for
+   */
+  timer_wheel(hal::steady_clock& p_clock,
+              hal::timer& p_timer,
+              hal::basic_lock& p_lock,
+              hal::time_duration p_resolution,
+              hal::time_duration p_maximum_delay);
+
+  timer_wheel(timer_wheel const&) = delete;
+  timer_wheel& operator=(timer_wheel const&) = delete;
+  timer_wheel(timer_wheel&&) = delete;
+  timer_wheel& operator=(timer_wheel&&) = delete;
+  ~timer_wheel();
+
+  /**
+   * @brief Schedule a timeout to expire after a delay
+   *
+   * If the timeout is already pending, it is rescheduled.
+   *
+   * @param p_timeout - timeout to schedule
+   * @param p_delay - time from now until the timeout expires
+   */
+  void schedule(timeout& p_timeout, hal::time_duration p_delay);
+
+  /**
+   * @brief Schedule a timeout to expire one period after its last expiry
+   *
+   * For periodic work, call from the timeout's handler. Unlike schedule(), the
+   * period does not drift by the latency of the handler. If the timeout has
+   * fallen more than a period behind, it expires on the next tick.
+   *
+   * @param p_timeout - timeout to schedule
+   * @param p_period - time between expiries
+   */
+  void reschedule(timeout& p_timeout, hal::time_duration p_period);
+
+  /**
+   * @brief Cancel a timeout
+   *
+   * Does nothing if the timeout is not pending.
+   *
+   * @param p_timeout - timeout to cancel
+   */
+  void cancel(timeout& p_timeout);
+
+  /**
+   * @brief Get the duration of a wheel tick
+   *
+   * @return hal::time_duration - tick duration
+   */
+  [[nodiscard]] hal::time_duration resolution() const;
+
+  /**
+   * @brief Get the time until the next timeout may expire
+   *
+   * @return hal::time_duration - time until the wheel next needs to run, the
+   * maximum time_duration if no timeouts are pending.
+   */
+  [[nodiscard]] hal::time_duration time_until_next_event();
+
+  /**
+   * @brief Expire all timeouts that are due
+   *
+   * Called from the timer's callback, may also be called to process timeouts
+   * early, for example after waking up from sleep.
+   */
+  void run();
+
+private:
+  static constexpr hal::u64 never = std::numeric_limits<hal::u64>::max();
+  /// Timeouts too far in the future for the top level
+  static constexpr std::uint16_t overflow_list = levels * slots_per_level;
+  /// Timeouts that have expired and are about to be called
+  static constexpr std::uint16_t expired_list = overflow_list + 1;
+  static constexpr std::uint16_t list_count = expired_list + 1;
+
+  hal::u64 to_clock_ticks(hal::time_duration p_duration) const;
+  hal::time_duration to_duration(hal::u64 p_clock_ticks) const;
+  hal::u64 ticks_from(hal::u64 p_clock_ticks) const;
+  void insert(timeout& p_timeout);
+  void remove(timeout& p_timeout);
+  void push(std::uint16_t p_list, timeout& p_timeout);
+  hal::u64 next_event() const;
+  void process(hal::u64 p_tick);
+  void move_list(std::uint16_t p_list);
+  void arm();
+
+  hal::steady_clock* m_clock;
+  hal::timer* m_timer;
+  hal::basic_lock* m_lock;
+  hal::time_duration m_resolution;
+  hal::u64 m_maximum_delay_ticks;
+  /// Clock ticks per wheel tick
+  hal::u64 m_clock_ticks_per_tick;
+  /// Wheel tick up to which all timeouts have been processed
+  hal::u64 m_current = 0;
+  /// Wheel tick the hardware timer is scheduled for
+  hal::u64 m_armed = never;
+  std::array<timeout*, list_count> m_lists{};
+  /// Bit n is set if slot n of the level has at least one timeout
+  std::array<hal::u64, levels> m_occupied{};
+  /// Number of run() calls in progress, the timer is armed by the last one
+  std::uint8_t m_run_depth = 0;
+};
+}  // namespace hal::micromod
@@ -0,0 +1,182 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <libhal/lock.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::micromod {
+/**
+ * @brief What a transmit_ring does with data that does not fit
+ */
+enum class overflow_policy : std::uint8_t
+{
+  /// Accept only what fits, the writer waits for space to write the rest
+  block,
+  /// Discard the data that does not fit
+  drop_newest,
+  /// Discard the oldest data not yet being transmitted to make room. While a
+  /// claim is outstanding no room can be made, so data that does not fit is
+  /// discarded as with drop_newest.
+  drop_oldest,
+};
+
+/**
+ * @brief Counters kept by a transmit_ring
+ */
+struct transmit_statistics
+{
+  /// Bytes accepted into the ring
+  hal::u64 written = 0;
+  /// Bytes discarded by the overflow policy
+  hal::u64 dropped = 0;
+  /// Largest number of bytes held by the ring at once
+  std::size_t peak = 0;
+};
+
+/**
+ * @brief Byte ring buffer between a writer and a transmitter, such as DMA
+ *
+ * The writer copies data in with write(), or reserves space with reserve(),
+ * fills it in place & publishes it with commit(). The transmitter claims the
+ * longest contiguous run of pending bytes with claim(), sends them and frees
+ * them with release(). Only one claim may be outstanding, and claimed bytes are
+ * never overwritten or dropped.
+ *
+ * There must be a single writer. The indices are protected by the lock, which
+ * is held only to update them, never while data is copied. When the
+ * transmitter runs in an interrupt, the lock must mask that interrupt.
+ */
+class transmit_ring
+{
+public:
+  /**
+   * @brief Construct a new transmit ring object
+   *
+   * @param p_buffer - storage for the ring, must outlive it
+   * @param p_lock - lock protecting the indices from the transmitter
+   * @param p_policy - what to do with data that does not fit
+   */
+  transmit_ring(std::span<hal::byte> p_buffer,
+                hal::basic_lock& p_lock,
+                overflow_policy p_policy);
+
+  transmit_ring(transmit_ring const&) = delete;
+  transmit_ring& operator=(transmit_ring const&) = delete;
+  transmit_ring(transmit_ring&&) = delete;
+  transmit_ring& operator=(transmit_ring&&) = delete;
+  ~transmit_ring() = default;
+
+  /**
+   * @brief Change the overflow policy
+   *
+   * @param p_policy - what to do with data that does not fit
+   */
+  void policy(overflow_policy p_policy);
+
+  /**
+   * @brief Get the overflow policy
+   *
+   * @return overflow_policy - what is done with data that does not fit
+   */
+  [[nodiscard]] overflow_policy policy() const;
+
+  /**
+   * @brief Copy data into the ring, applying the overflow policy
+   *
+   * @param p_data - data to transmit
+   * @return std::size_t - number of bytes of p_data handled, either accepted
+   * or dropped. Less than p_data.size() only with overflow_policy::block, when
+   * the ring is full.
+   */
+  std::size_t write(std::span<hal::byte const> p_data);
+
+  /**
+   * @brief Reserve contiguous space to write into
+   *
+   * With overflow_policy::drop_oldest & no claim outstanding, pending bytes
+   * are dropped to make room.
+   * The space is only transmitted once commit() is called. Reserving again
+   * before committing returns the same space.
+   *
+   * @param p_size - number of bytes wanted
+   * @return std::span<hal::byte> - free space at the write position, shorter
+   * than p_size if the ring is full or wraps around.
+   */
+  std::span<hal::byte> reserve(std::size_t p_size);
+
+  /**
+   * @brief Publish bytes written into reserved space
+   *
+   * @param p_size - number of bytes written, at most the size reserved
+   */
+  void commit(std::size_t p_size);
+
+  /**
+   * @brief Claim the longest contiguous run of pending bytes to transmit
+   *
+   * @return std::span<hal::byte const> - bytes to transmit, empty if nothing
+   * is pending or a claim is already outstanding.
+   */
+  std::span<hal::byte const> claim();
+
+  /**
+   * @brief Free the bytes of the outstanding claim once transmitted
+   */
+  void release();
+
+  /**
+   * @brief Get the number of bytes held, including those being transmitted
+   *
+   * @return std::size_t - bytes held by the ring
+   */
+  [[nodiscard]] std::size_t size();
+
+  /**
+   * @brief Get the size of the ring's buffer
+   *
+   * @return std::size_t - maximum number of bytes the ring can hold
+   */
+  [[nodiscard]] std::size_t capacity() const;
+
+  /**
+   * @brief Get the ring's counters
+   *
+   * @return transmit_statistics - counters since construction
+   */
+  [[nodiscard]] transmit_statistics statistics();
+
+private:
+  void drop(std::size_t p_size);
+
+  std::span<hal::byte> m_buffer;
+  hal::basic_lock* m_lock;
+  overflow_policy m_policy;
+  /// Position of the oldest byte held, the start of the claim if there is one
+  std::size_t m_tail = 0;
+  /// Bytes held, including claimed bytes
+  std::size_t m_size = 0;
+  /// Position of the first byte not claimed
+  std::size_t m_unsent = 0;
+  /// Bytes committed but not yet claimed
+  std::size_t m_unsent_size = 0;
+  bool m_claimed = false;
+  transmit_statistics m_statistics{};
+};
+}  // namespace hal::micromod
@@ -0,0 +1,182 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/analog_stream.hpp>
+
+#include <algorithm>
+
+namespace hal::micromod {
+namespace {
+/// Most extra bits for which the sum of 4^n full scale samples fits in 32 bits
+constexpr hal::u8 oversampling_limit = 10;
+
+std::size_t group_frames(hal::u8 p_extra_bits)
+{
+  return std::size_t{ 1 } << (2 * p_extra_bits);
+}
+
+/// Sum an input over the 4^n frames from a frame & drop the n extra bits
+hal::u32 decimate_group(std::span<hal::u16 const> p_samples,
+                        std::size_t p_first_frame,
+                        analog_channel p_channel,
+                        hal::u8 p_extra_bits)
+{
+  auto const group = group_frames(p_extra_bits);
+  auto const samples =
+    p_samples.subspan((p_first_frame * analog_channels) +
+                        static_cast<std::size_t>(p_channel),
+                      ((group - 1) * analog_channels) + 1);
+  hal::u32 sum = 0;
+  for (std::size_t i = 0; i < samples.size(); i += analog_channels) {
+    sum += samples[i];
+  }
+  return sum >> p_extra_bits;
+}
+}  // namespace
+
+analog_stream::analog_stream(std::span<hal::u16> p_buffer,
+                             hal::hertz p_frame_rate)
+  : m_buffer(p_buffer.first(p_buffer.size() / (2 * analog_channels) *
+                            (2 * analog_channels)))
+  , m_frame_rate(p_frame_rate)
+{
+}
+
+hal::hertz analog_stream::frame_rate() const
+{
+  return m_frame_rate;
+}
+
+std::size_t analog_stream::block_frames() const
+{
+  return m_buffer.size() / (2 * analog_channels);
+}
+
+hal::u16 analog_stream::latest(analog_channel p_channel)
+{
+  auto const frames = m_buffer.size() / analog_channels;
+  auto const frame = (written() % m_buffer.size()) / analog_channels;
+  // The frame being written is incomplete, the one before it wraps around
+  auto const last = (frame + frames - 1) % frames;
+  return m_buffer[(last * analog_channels) +
+                  static_cast<std::size_t>(p_channel)];
+}
+
+analog_block analog_stream::take()
+{
+  auto const completed = m_completed.load(std::memory_order_acquire);
+  if (completed == m_taken) {
+    return {};
+  }
+  m_dropped += completed - m_taken - 1;
+  m_taken = completed;
+  auto const size = m_buffer.size() / 2;
+  auto const half = (completed - 1) % 2;
+  return { .samples = m_buffer.subspan(half * size, size),
+           .sequence = completed - 1 };
+}
+
+bool analog_stream::intact(analog_block const& p_block) const
+{
+  // The hardware writes over a block once the block after it completes
+  return m_completed.load(std::memory_order_acquire) < p_block.sequence + 2;
+}
+
+analog_stream_statistics analog_stream::statistics() const
+{
+  return { .completed = m_completed.load(std::memory_order_acquire),
+           .dropped = m_dropped };
+}
+
+void analog_stream::oversampling(hal::u8 p_extra_bits)
+{
+  m_extra_bits = std::min(p_extra_bits, maximum_oversampling());
+}
+
+hal::u8 analog_stream::oversampling() const
+{
+  return m_extra_bits;
+}
+
+hal::u8 analog_stream::maximum_oversampling() const
+{
+  auto const frames = block_frames();
+  hal::u8 extra_bits = 0;
+  while (frames != 0 && extra_bits < oversampling_limit &&
+         frames % group_frames(extra_bits + 1) == 0) {
+    extra_bits++;
+  }
+  return extra_bits;
+}
+
+hal::hertz analog_stream::oversampled_rate() const
+{
+  return m_frame_rate / static_cast<float>(group_frames(m_extra_bits));
+}
+
+hal::u32 analog_stream::oversampled(analog_channel p_channel)
+{
+  auto const group = group_frames(m_extra_bits);
+  auto const frames = m_buffer.size() / analog_channels;
+  auto const frame = (written() % m_buffer.size()) / analog_channels;
+  // The group holding the frame being written is incomplete, the one before
+  // it wraps around. Groups evenly divide the buffer, so never wrap inside.
+  auto const first = ((frame / group * group) + frames - group) % frames;
+  return decimate_group(m_buffer, first, p_channel, m_extra_bits);
+}
+
+std::span<hal::u16> analog_stream::buffer() const
+{
+  return m_buffer;
+}
+
+void analog_stream::block_complete(std::size_t p_half)
+{
+  auto completed = m_completed.load(std::memory_order_relaxed);
+  // Count a half whose interrupt was missed, so that the count keeps telling
+  // which half completed last
+  if (completed % 2 != p_half) {
+    completed++;
+  }
+  m_completed.store(completed + 1, std::memory_order_release);
+}
+
+std::size_t decimate(analog_block const& p_block,
+                     analog_channel p_channel,
+                     hal::u8 p_extra_bits,
+                     std::span<hal::u32> p_output)
+{
+  auto const group = group_frames(p_extra_bits);
+  auto const results = std::min(p_block.frames() / group, p_output.size());
+  for (std::size_t i = 0; i < results; i++) {
+    p_output[i] =
+      decimate_group(p_block.samples, i * group, p_channel, p_extra_bits);
+  }
+  return results;
+}
+
+analog_stream_adc::analog_stream_adc(analog_stream& p_stream,
+                                     analog_channel p_channel)
+  : m_stream(&p_stream)
+  , m_channel(p_channel)
+{
+}
+
+float analog_stream_adc::driver_read()
+{
+  auto const extra_bits = m_stream->oversampling();
+  return static_cast<float>(m_stream->oversampled(m_channel)) /
+         static_cast<float>(analog_full_scale_oversampled(extra_bits));
+}
+}  // namespace hal::micromod
@@ -0,0 +1,114 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+/**
+ * @brief Storage for the statically allocated drivers returned by the boards
+ *
+ * Each driver is described by a factory function returning it by value. By
+ * default the driver is a function-local static, constructed on the first call
+ * to its accessor, and every call pays for the thread safe static guard check.
+ *
+ * When the library is built with LIBHAL_MICROMOD_EAGER_INIT, the driver lives
+ * in `constinit` storage instead. It is constructed ahead of time by
+ * `emplace_driver()`, called from `initialize_platform()` or
+ * `initialize_driver()`, and its accessor is a plain reference to the storage.
+ * Calling the accessor of a driver that was never emplaced is undefined
+ * behavior.
+ */
+namespace hal::micromod {
+template<class T>
+class driver_storage
+{
+public:
+  constexpr driver_storage() = default;
+
+  template<class factory_t>
+  T& emplace(factory_t p_factory)
+  {
+    // The factory's prvalue is constructed directly in the storage, so T does
+    // not need to be movable.
+    return *::new (static_cast<void*>(m_storage)) T(p_factory());
+  }
+
+  T& get()
+  {
+    return *std::launder(reinterpret_cast<T*>(m_storage));
+  }
+
+private:
+  alignas(T) std::byte m_storage[sizeof(T)];
+};
+
+template<auto factory>
+using driver_t = decltype(factory());
+
+#if defined(LIBHAL_MICROMOD_EAGER_INIT)
+template<auto factory>
+constinit driver_storage<driver_t<factory>> eager_storage{};
+#endif
+
+/**
+ * @brief Get the driver made by the factory, constructed on first use
+ *
+ * For drivers that cannot be constructed ahead of time in either mode.
+ *
+ * @tparam factory - function returning the driver by value
+ * @return driver_t<factory>& - statically allocated driver
+ */
+template<auto factory>
+driver_t<factory>& lazy_driver()
+{
+  static driver_t<factory> driver = factory();
+  return driver;
+}
+
+/**
+ * @brief Get the driver made by the factory
+ *
+ * @tparam factory - function returning the driver by value
+ * @return driver_t<factory>& - statically allocated driver
+ */
+template<auto factory>
+driver_t<factory>& board_driver()
+{
+#if defined(LIBHAL_MICROMOD_EAGER_INIT)
+  return eager_storage<factory>.get();
+#else
+  return lazy_driver<factory>();
+#endif
+}
+
+/**
+ * @brief Construct the driver made by the factory ahead of its first use
+ *
+ * In the default lazy mode, this constructs the driver's function-local static
+ * early. In eager mode, it must be called once and only once per driver.
+ *
+ * @tparam factory - function returning the driver by value
+ */
+template<auto factory>
+void emplace_driver()
+{
+#if defined(LIBHAL_MICROMOD_EAGER_INIT)
+  eager_storage<factory>.emplace(factory);
+#else
+  static_cast<void>(board_driver<factory>());
+#endif
+}
+}  // namespace hal::micromod
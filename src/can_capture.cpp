@@ -0,0 +1,234 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/can_capture.hpp>
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <string_view>
+
+#include <libhal-micromod/deferred_log.hpp>
+
+namespace hal::micromod {
+namespace {
+/// Largest encoded binary record: flags, extended id, payload & time varint
+constexpr std::size_t maximum_record_size = 1 + 4 + 8 + 10;
+/// Largest candump output per record, a dropped comment and a line with an
+/// extended id & 8 bytes of payload
+constexpr std::size_t maximum_line_size = 80;
+
+constexpr std::array<char, 16> hex_digits{ '0', '1', '2', '3', '4', '5',
+                                           '6', '7', '8', '9', 'A', 'B',
+                                           'C', 'D', 'E', 'F' };
+
+char* write_hex(char* p_out, hal::u32 p_value, std::size_t p_digits)
+{
+  for (std::size_t digit = p_digits; digit > 0; digit--) {
+    p_out[digit - 1] = hex_digits[p_value & 0xF];
+    p_value >>= 4;
+  }
+  return p_out + p_digits;
+}
+
+char* write_decimal(char* p_out, hal::u64 p_value, std::size_t p_digits)
+{
+  for (std::size_t digit = p_digits; digit > 0; digit--) {
+    p_out[digit - 1] = static_cast<char>('0' + (p_value % 10));
+    p_value /= 10;
+  }
+  return p_out + p_digits;
+}
+
+char* write_decimal(char* p_out, hal::u64 p_value)
+{
+  std::size_t digits = 1;
+  for (auto value = p_value; value >= 10; value /= 10) {
+    digits++;
+  }
+  return write_decimal(p_out, p_value, digits);
+}
+
+char* write_text(char* p_out, std::string_view p_text)
+{
+  return std::copy(p_text.begin(), p_text.end(), p_out);
+}
+
+std::span<hal::byte const> as_bytes(char const* p_begin, char const* p_end)
+{
+  return { reinterpret_cast<hal::byte const*>(p_begin),
+           static_cast<std::size_t>(p_end - p_begin) };
+}
+}  // namespace
+
+can_capture::can_capture(hal::can_interrupt& p_interrupt,
+                         hal::steady_clock& p_clock,
+                         std::span<can_capture_record> p_buffer)
+  : m_interrupt(&p_interrupt)
+  , m_clock(&p_clock)
+  , m_to_time(p_clock.frequency())
+  , m_ring(p_buffer)
+{
+  m_interrupt->on_receive(
+    [this](hal::can_interrupt::on_receive_tag,
+           hal::can_message const& p_message) { capture(p_message); });
+}
+
+can_capture::~can_capture()
+{
+  m_interrupt->on_receive(std::nullopt);
+}
+
+void can_capture::capture(hal::can_message const& p_message)
+{
+  // Timestamp first, as close to the reception as possible
+  auto const timestamp = m_clock->uptime();
+  auto const sequence = m_received.load(std::memory_order_relaxed);
+  m_received.store(sequence + 1, std::memory_order_relaxed);
+
+  if (not m_ring.push({ .timestamp = timestamp,
+                        .sequence = sequence,
+                        .message = p_message })) {
+    m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+    return;
+  }
+
+  auto const size = m_ring.size();
+  if (size > m_peak.load(std::memory_order_relaxed)) {
+    m_peak.store(size, std::memory_order_relaxed);
+  }
+}
+
+std::size_t can_capture::drain(hal::serial& p_serial,
+                               can_capture_format p_format)
+{
+  if (p_format == can_capture_format::binary) {
+    return drain_binary(p_serial);
+  }
+  return drain_candump(p_serial);
+}
+
+std::size_t can_capture::drain_binary(hal::serial& p_serial)
+{
+  std::size_t drained = 0;
+
+  while (auto const* record = m_ring.front()) {
+    // One spare byte for the COBS code and one for the delimiter
+    std::array<hal::byte, log_payload_limit + 2> frame;
+    std::size_t length = 1;
+    auto const write_varint = [&frame, &length](hal::u64 p_value) {
+      length += detail::write_varint(&frame[length], p_value);
+    };
+
+    auto previous = m_to_time.microseconds(record->timestamp);
+    write_varint(record->sequence);
+    write_varint(m_dropped.load(std::memory_order_relaxed));
+    write_varint(previous);
+
+    // A gap in the sequence starts a new batch
+    auto sequence = record->sequence;
+    while (record != nullptr && record->sequence == sequence &&
+           length + maximum_record_size <= log_payload_limit + 1) {
+      auto const& message = record->message;
+      auto const data_length = std::min<hal::u8>(message.length, 8);
+      frame[length++] =
+        static_cast<hal::byte>(data_length | (message.extended << 4U) |
+                               (message.remote_request << 5U));
+      auto const id_length = message.extended ? 4U : 2U;
+      for (std::size_t i = 0; i < id_length; i++) {
+        frame[length++] = static_cast<hal::byte>(message.id >> (8 * i));
+      }
+      if (not message.remote_request) {
+        for (std::size_t i = 0; i < data_length; i++) {
+          frame[length++] = message.payload[i];
+        }
+      }
+      auto const time = m_to_time.microseconds(record->timestamp);
+      write_varint(time - previous);
+      previous = time;
+
+      m_ring.pop();
+      drained++;
+      sequence++;
+      record = m_ring.front();
+    }
+
+    m_next_sequence = sequence;
+    auto const encoded = std::span(frame).first(length + 1);
+    detail::cobs_encode(encoded);
+    p_serial.write(encoded);
+  }
+
+  return drained;
+}
+
+std::size_t can_capture::drain_candump(hal::serial& p_serial)
+{
+  std::size_t drained = 0;
+  std::array<char, 256> lines;
+  auto* out = lines.data();
+
+  while (auto const* record = m_ring.front()) {
+    if (out + maximum_line_size > lines.data() + lines.size()) {
+      p_serial.write(as_bytes(lines.data(), out));
+      out = lines.data();
+    }
+
+    if (record->sequence != m_next_sequence) {
+      out = write_text(out, "# dropped ");
+      auto const dropped = record->sequence - m_next_sequence;
+      out = write_decimal(out, dropped);
+      out = write_text(out, "\n");
+    }
+
+    // (0000000012.345678) can0 123#DEADBEEF
+    auto const& message = record->message;
+    auto const microseconds = m_to_time.microseconds(record->timestamp);
+    out = write_text(out, "(");
+    out = write_decimal(out, microseconds / 1'000'000, 10);
+    out = write_text(out, ".");
+    out = write_decimal(out, microseconds % 1'000'000, 6);
+    out = write_text(out, ") can0 ");
+    out = write_hex(out, message.id, message.extended ? 8 : 3);
+    out = write_text(out, "#");
+    if (message.remote_request) {
+      out = write_text(out, "R");
+    } else {
+      for (std::size_t i = 0; i < std::min<hal::u8>(message.length, 8); i++) {
+        out = write_hex(out, message.payload[i], 2);
+      }
+    }
+    out = write_text(out, "\n");
+
+    m_next_sequence = record->sequence + 1;
+    m_ring.pop();
+    drained++;
+  }
+
+  if (out != lines.data()) {
+    p_serial.write(as_bytes(lines.data(), out));
+  }
+  return drained;
+}
+
+can_capture_statistics can_capture::statistics() const
+{
+  return {
+    .received = m_received.load(std::memory_order_relaxed),
+    .dropped = m_dropped.load(std::memory_order_relaxed),
+    .peak = m_peak.load(std::memory_order_relaxed),
+  };
+}
+}  // namespace hal::micromod
@@ -0,0 +1,85 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/can_filter_plan.hpp>
+
+#include <array>
+
+#include <libhal-micromod/micromod.hpp>
+
+namespace hal::micromod {
+namespace {
+template<class filter_t>
+using accessor = filter_t& (*)();
+
+// Accessors are indexed by filter number so that only the filters in use are
+// constructed.
+constexpr std::array<accessor<hal::can_identifier_filter>, can_filter_slots>
+  identifier_filters{
+    &v1::can_identifier_filter0, &v1::can_identifier_filter1,
+    &v1::can_identifier_filter2, &v1::can_identifier_filter3,
+    &v1::can_identifier_filter4, &v1::can_identifier_filter5,
+    &v1::can_identifier_filter6, &v1::can_identifier_filter7,
+  };
+
+constexpr std::array<accessor<hal::can_mask_filter>, can_filter_slots>
+  mask_filters{
+    &v1::can_mask_filter0, &v1::can_mask_filter1, &v1::can_mask_filter2,
+    &v1::can_mask_filter3, &v1::can_mask_filter4, &v1::can_mask_filter5,
+    &v1::can_mask_filter6, &v1::can_mask_filter7,
+  };
+
+constexpr std::array<accessor<hal::can_extended_identifier_filter>,
+                     can_filter_slots>
+  extended_identifier_filters{
+    &v1::can_extended_identifier_filter0,
+    &v1::can_extended_identifier_filter1,
+    &v1::can_extended_identifier_filter2,
+    &v1::can_extended_identifier_filter3,
+    &v1::can_extended_identifier_filter4,
+    &v1::can_extended_identifier_filter5,
+    &v1::can_extended_identifier_filter6,
+    &v1::can_extended_identifier_filter7,
+  };
+
+constexpr std::array<accessor<hal::can_extended_mask_filter>,
+                     can_filter_slots>
+  extended_mask_filters{
+    &v1::can_extended_mask_filter0, &v1::can_extended_mask_filter1,
+    &v1::can_extended_mask_filter2, &v1::can_extended_mask_filter3,
+    &v1::can_extended_mask_filter4, &v1::can_extended_mask_filter5,
+    &v1::can_extended_mask_filter6, &v1::can_extended_mask_filter7,
+  };
+
+template<class filter_t, class value_t>
+void allow(std::array<accessor<filter_t>, can_filter_slots> const& p_filters,
+           std::array<std::optional<value_t>, can_filter_slots> const& p_plan)
+{
+  for (std::size_t i = 0; i < can_filter_slots; i++) {
+    if (p_plan[i]) {
+      p_filters[i]().allow(p_plan[i]);
+    }
+  }
+}
+}  // namespace
+
+void apply_can_filter_plan(can_filter_plan const& p_plan)
+{
+  allow(identifier_filters, p_plan.identifiers);
+  allow(mask_filters, p_plan.masks);
+  allow(extended_identifier_filters, p_plan.extended_identifiers);
+  allow(extended_mask_filters, p_plan.extended_masks);
+  v1::can_bus_manager().filter_mode(hal::can_bus_manager::accept::none);
+}
+}  // namespace hal::micromod
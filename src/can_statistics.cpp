@@ -0,0 +1,109 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/can_statistics.hpp>
+
+#include <libhal-util/serial.hpp>
+
+namespace hal::micromod {
+can_bus_rates::can_bus_rates(can_bus_statistics const& p_earlier,
+                             can_bus_statistics const& p_later,
+                             hal::hertz p_frequency)
+{
+  if (p_later.timestamp <= p_earlier.timestamp || p_frequency <= 0.0f) {
+    return;
+  }
+  auto const seconds =
+    static_cast<float>(p_later.timestamp - p_earlier.timestamp) / p_frequency;
+  // Unsigned differences stay correct across a counter wrap
+  received_per_second =
+    static_cast<float>(p_later.received - p_earlier.received) / seconds;
+  transmitted_per_second =
+    static_cast<float>(p_later.transmitted - p_earlier.transmitted) / seconds;
+  if (p_later.baud_rate != 0) {
+    load = static_cast<float>(p_later.bits - p_earlier.bits) /
+           (seconds * static_cast<float>(p_later.baud_rate));
+  }
+}
+
+void can_traffic_counter::received(hal::can_message const& p_message)
+{
+  m_received.fetch_add(1, std::memory_order_relaxed);
+  m_bits.fetch_add(can_frame_bits(p_message), std::memory_order_relaxed);
+}
+
+void can_traffic_counter::transmitted(hal::can_message const& p_message)
+{
+  m_transmitted.fetch_add(1, std::memory_order_relaxed);
+  m_bits.fetch_add(can_frame_bits(p_message), std::memory_order_relaxed);
+}
+
+void can_traffic_counter::bus_off()
+{
+  m_bus_off_events.fetch_add(1, std::memory_order_relaxed);
+}
+
+void can_traffic_counter::receive_overflow()
+{
+  m_receive_overflows.fetch_add(1, std::memory_order_relaxed);
+}
+
+void can_traffic_counter::read(can_bus_statistics& p_statistics) const
+{
+  p_statistics.received = m_received.load(std::memory_order_relaxed);
+  p_statistics.transmitted = m_transmitted.load(std::memory_order_relaxed);
+  p_statistics.bits = m_bits.load(std::memory_order_relaxed);
+  p_statistics.bus_off_events =
+    m_bus_off_events.load(std::memory_order_relaxed);
+  p_statistics.receive_overflows =
+    m_receive_overflows.load(std::memory_order_relaxed);
+}
+
+can_statistics_report::can_statistics_report(hal::serial& p_serial,
+                                             hal::steady_clock& p_clock,
+                                             hal::time_duration p_period)
+  : m_serial(&p_serial)
+  , m_frequency(p_clock.frequency())
+  , m_period(static_cast<hal::u64>(static_cast<double>(p_period.count()) *
+                                   m_frequency / 1e9))
+{
+}
+
+bool can_statistics_report::poll(can_bus_statistics const& p_statistics)
+{
+  if (not m_previous) {
+    m_previous = p_statistics;
+    return false;
+  }
+  if (p_statistics.timestamp - m_previous->timestamp < m_period) {
+    return false;
+  }
+
+  can_bus_rates const rates(*m_previous, p_statistics, m_frequency);
+  auto const permille = static_cast<unsigned long>(rates.load * 1000.0f);
+  hal::print<128>(*m_serial,
+                  "can: rx %lu/s, tx %lu/s, load %lu.%lu%%, tec %u, rec %u, "
+                  "bus off %lu, overflow %lu\n",
+                  static_cast<unsigned long>(rates.received_per_second),
+                  static_cast<unsigned long>(rates.transmitted_per_second),
+                  permille / 10,
+                  permille % 10,
+                  unsigned{ p_statistics.transmit_errors },
+                  unsigned{ p_statistics.receive_errors },
+                  static_cast<unsigned long>(p_statistics.bus_off_events),
+                  static_cast<unsigned long>(p_statistics.receive_overflows));
+  m_previous = p_statistics;
+  return true;
+}
+}  // namespace hal::micromod
@@ -0,0 +1,76 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <libhal-micromod/can_timestamp.hpp>
+
+#include <algorithm>
+
+namespace hal::micromod {
+namespace {
+/// Bits the 16-bit capture counts before wrapping
+constexpr std::int64_t capture_period = 1 << 16;
+}  // namespace
+
+can_timestamp_extender::can_timestamp_extender(hal::u32 p_ticks_per_bit)
+  : m_ticks_per_bit(std::max<hal::u32>(p_ticks_per_bit, 1))
+{
+}
+
+hal::u64 can_timestamp_extender::extend(hal::u64 p_now,
+                                        hal::u16 p_capture,
+                                        hal::can_message const& p_message)
+{
+  // The start of frame was at least a whole unstuffed frame before now
+  auto const shortest = hal::u64{ can_minimum_frame_bits(p_message) } *
+                        m_ticks_per_bit;
+  auto const latest = p_now > shortest ? p_now - shortest : 0;
+
+  if (not m_anchored) {
+    m_anchor_time = latest;
+    m_anchor_capture = p_capture;
+    m_anchored = true;
+    return latest;
+  }
+
+  // Bits since the previous start of frame as far as the uptime tells, then
+  // the nearest count that agrees with the captures
+  auto const elapsed = static_cast<std::int64_t>(
+    latest > m_anchor_time ? (latest - m_anchor_time) / m_ticks_per_bit : 0);
+  auto const captured =
+    static_cast<hal::u16>(p_capture - m_anchor_capture);
+  auto bits =
+    elapsed +
+    static_cast<std::int16_t>(captured - static_cast<hal::u16>(elapsed));
+  if (bits < 0) {
+    bits += capture_period;
+  }
+
+  auto start_of_frame =
+    m_anchor_time + (static_cast<hal::u64>(bits) * m_ticks_per_bit);
+  // A start of frame later than this message allows means the previous ones
+  // were late too, by a latency longer than this message's
+  start_of_frame = std::min(start_of_frame, latest);
+
+  m_anchor_time = start_of_frame;
+  m_anchor_capture = p_capture;
+  return start_of_frame;
+}
+
+void can_timestamp_extender::reset(hal::u32 p_ticks_per_bit)
+{
+  m_ticks_per_bit = std::max<hal::u32>(p_ticks_per_bit, 1);
+  m_anchored = false;
+}
+}  // namespace hal::micromod
@@ -0,0 +1,190 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/can_transmit_queue.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+
+namespace hal::micromod {
+namespace {
+/// true if p_left should be sent before p_right
+bool precedes(can_queued_message const& p_left,
+              can_queued_message const& p_right)
+{
+  auto const left_key = can_arbitration_key(p_left.message);
+  auto const right_key = can_arbitration_key(p_right.message);
+  if (left_key != right_key) {
+    return left_key < right_key;
+  }
+  // Wrap safe comparison of the sequence numbers
+  return static_cast<std::int32_t>(p_left.sequence - p_right.sequence) < 0;
+}
+}  // namespace
+
+can_transmit_queue::can_transmit_queue(std::span<can_queued_message> p_storage,
+                                       hal::steady_clock& p_clock,
+                                       hal::basic_lock& p_lock)
+  : m_storage(p_storage)
+  , m_clock(&p_clock)
+  , m_lock(&p_lock)
+{
+}
+
+bool can_transmit_queue::push(hal::can_message const& p_message)
+{
+  auto const now = m_clock->uptime();
+  std::lock_guard lock(*m_lock);
+  if (m_statistics.depth >= m_storage.size()) {
+    return false;
+  }
+
+  insert({ .message = p_message, .queued_at = now, .sequence = m_sequence++ });
+  m_statistics.queued++;
+  m_statistics.depth++;
+  m_statistics.peak_depth =
+    std::max(m_statistics.peak_depth, m_statistics.depth);
+
+  load_free_mailboxes();
+  preempt_mailboxes();
+  return true;
+}
+
+std::size_t can_transmit_queue::size()
+{
+  std::lock_guard lock(*m_lock);
+  return m_statistics.depth;
+}
+
+std::size_t can_transmit_queue::capacity() const
+{
+  return m_storage.size();
+}
+
+can_transmit_statistics can_transmit_queue::statistics()
+{
+  std::lock_guard lock(*m_lock);
+  return m_statistics;
+}
+
+void can_transmit_queue::mailbox_complete(std::size_t p_mailbox,
+                                          bool p_transmitted)
+{
+  auto const now = m_clock->uptime();
+  std::lock_guard lock(*m_lock);
+  auto& mailbox = m_mailboxes[p_mailbox];
+  if (not mailbox) {
+    return;
+  }
+
+  if (p_transmitted) {
+    auto const latency = now - mailbox->queued_at;
+    m_statistics.sent++;
+    m_statistics.depth--;
+    m_statistics.total_latency += latency;
+    if (latency >= m_statistics.worst_latency) {
+      m_statistics.worst_latency = latency;
+      m_statistics.worst_latency_id = mailbox->message.id;
+    }
+  } else {
+    // Keeps its sequence number, so it goes back ahead of messages with the
+    // same identifier pushed after it. Messages in mailboxes count towards
+    // the depth, so there is always room for it.
+    insert(*mailbox);
+    if (m_aborting[p_mailbox]) {
+      m_statistics.preempted++;
+    }
+  }
+  mailbox.reset();
+  m_aborting[p_mailbox] = false;
+
+  load_free_mailboxes();
+  preempt_mailboxes();
+}
+
+void can_transmit_queue::insert(can_queued_message const& p_entry)
+{
+  auto const queued = m_storage.first(m_size);
+  auto const position = static_cast<std::size_t>(
+    std::ranges::upper_bound(queued, p_entry, precedes) - queued.begin());
+  std::ranges::move_backward(queued.subspan(position),
+                             m_storage.begin() + m_size + 1);
+  m_storage[position] = p_entry;
+  m_size++;
+}
+
+std::optional<std::size_t> can_transmit_queue::free_mailbox(
+  hal::u32 p_key) const
+{
+  // The controller sends equal identifiers in mailbox order, so a message
+  // goes above every mailbox holding its identifier. Its identifier must not
+  // be in a mailbox being aborted either, as that message will come back
+  // ahead of it.
+  std::size_t first = 0;
+  for (std::size_t mailbox = 0; mailbox < m_mailboxes.size(); mailbox++) {
+    auto const& loaded = m_mailboxes[mailbox];
+    if (loaded && can_arbitration_key(loaded->message) == p_key) {
+      if (m_aborting[mailbox]) {
+        return std::nullopt;
+      }
+      first = mailbox + 1;
+    }
+  }
+  for (std::size_t mailbox = first; mailbox < m_mailboxes.size(); mailbox++) {
+    if (not m_mailboxes[mailbox]) {
+      return mailbox;
+    }
+  }
+  return std::nullopt;
+}
+
+void can_transmit_queue::load_free_mailboxes()
+{
+  // Strictly in order, if the most urgent message cannot be loaded yet, a
+  // less urgent one loaded in its place could go out first.
+  while (m_size > 0) {
+    auto const mailbox =
+      free_mailbox(can_arbitration_key(m_storage.front().message));
+    if (not mailbox) {
+      return;
+    }
+
+    m_mailboxes[*mailbox] = m_storage.front();
+    auto const remaining = m_storage.subspan(1, m_size - 1);
+    std::ranges::move(remaining, m_storage.begin());
+    m_size--;
+    load_mailbox(*mailbox, m_mailboxes[*mailbox]->message);
+  }
+}
+
+void can_transmit_queue::preempt_mailboxes()
+{
+  if (m_size == 0) {
+    return;
+  }
+  // Every mailbox less urgent than a waiting message could go out before it,
+  // not just enough of them to make room. The abort fails for the one already
+  // on the bus, and the controller picks the next frame as soon as it ends,
+  // before the interrupt could load the waiting message.
+  for (std::size_t mailbox = 0; mailbox < m_mailboxes.size(); mailbox++) {
+    auto const& loaded = m_mailboxes[mailbox];
+    if (loaded && not m_aborting[mailbox] &&
+        precedes(m_storage.front(), *loaded)) {
+      m_aborting[mailbox] = true;
+      abort_mailbox(mailbox);
+    }
+  }
+}
+}  // namespace hal::micromod
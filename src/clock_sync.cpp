@@ -0,0 +1,259 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <libhal-micromod/clock_sync.hpp>
+
+#include <algorithm>
+
+namespace hal::micromod {
+namespace {
+enum frame_type : hal::u8
+{
+  sync_frame = 0x1,
+  follow_up_frame = 0x2,
+};
+
+constexpr std::int64_t nanoseconds_per_second = 1'000'000'000;
+/// Farther than this from the master, the clock jumps to its time
+constexpr std::int64_t step_threshold = 1'000'000;
+/// Servo gains, as fractions of 10
+constexpr std::int64_t proportional_gain = 7;
+constexpr std::int64_t integral_gain = 3;
+/// Largest standard identifier, larger identifiers are sent extended
+constexpr hal::u32 standard_id_limit = 0x7FF;
+/// Bits of master time a FOLLOW_UP frame holds
+constexpr hal::u64 master_time_mask = (hal::u64{ 1 } << 56) - 1;
+
+/// p_value * p_parts_per_billion / 10^9 without overflowing
+std::int64_t scale(hal::u64 p_value, std::int64_t p_parts_per_billion)
+{
+  auto const seconds = static_cast<std::int64_t>(p_value / 1'000'000'000);
+  auto const remainder = static_cast<std::int64_t>(p_value % 1'000'000'000);
+  return (seconds * p_parts_per_billion) +
+         (remainder * p_parts_per_billion / nanoseconds_per_second);
+}
+}  // namespace
+
+synchronized_clock::synchronized_clock(hal::steady_clock& p_local)
+  : m_local(&p_local)
+  , m_to_time(p_local.frequency())
+{
+}
+
+void synchronized_clock::correct(hal::u64 p_local, hal::u64 p_master)
+{
+  auto const local = m_to_time.nanoseconds(p_local);
+  m_statistics.samples++;
+
+  if (m_state == state::free_running) {
+    jump(local, p_master);
+    return;
+  }
+
+  auto const predicted = master_time(local);
+  auto const offset = static_cast<std::int64_t>(p_master - predicted);
+  auto const interval = local > m_base_local ? local - m_base_local : 0;
+  m_statistics.offset = offset;
+  if (interval == 0) {
+    return;
+  }
+  if (offset > step_threshold || offset < -step_threshold) {
+    jump(local, p_master);
+    return;
+  }
+
+  // Rate that would cancel the offset over one more interval
+  auto const correction =
+    offset * nanoseconds_per_second / static_cast<std::int64_t>(interval);
+  if (m_state == state::measuring_drift) {
+    // The first interval measures the drift, jump the small offset left
+    m_statistics.drift = m_rate + correction;
+    m_rate = m_statistics.drift;
+    step(local, p_master);
+    m_state = state::locked;
+    m_statistics.synchronized = true;
+    return;
+  }
+
+  m_statistics.drift += correction * integral_gain / 10;
+  m_rate = m_statistics.drift + (correction * proportional_gain / 10);
+  // Continue from the estimate, so the clock slews rather than jumps
+  m_base_local = local;
+  m_base_master = predicted;
+}
+
+clock_sync_statistics synchronized_clock::statistics() const
+{
+  return m_statistics;
+}
+
+hal::hertz synchronized_clock::driver_frequency()
+{
+  return 1e9f;
+}
+
+hal::u64 synchronized_clock::driver_uptime()
+{
+  auto const local = m_to_time.nanoseconds(m_local->uptime());
+  auto const time = m_state == state::free_running ? local : master_time(local);
+  m_latest = std::max(m_latest, time);
+  return m_latest;
+}
+
+hal::u64 synchronized_clock::master_time(hal::u64 p_local) const
+{
+  auto const elapsed = p_local > m_base_local ? p_local - m_base_local : 0;
+  return m_base_master + elapsed +
+         static_cast<hal::u64>(scale(elapsed, m_rate));
+}
+
+void synchronized_clock::step(hal::u64 p_local, hal::u64 p_master)
+{
+  m_base_local = p_local;
+  m_base_master = p_master;
+  m_statistics.steps++;
+}
+
+void synchronized_clock::jump(hal::u64 p_local, hal::u64 p_master)
+{
+  step(p_local, p_master);
+  // Too far off to hold still until the master catches up
+  m_latest = 0;
+  m_state = state::measuring_drift;
+  m_statistics.synchronized = false;
+}
+
+clock_sync_master::clock_sync_master(hal::can_transceiver& p_transceiver,
+                                     hal::steady_clock& p_clock,
+                                     hal::u32 p_id)
+  : m_transceiver(&p_transceiver)
+  , m_to_time(p_clock.frequency())
+  , m_id(p_id)
+{
+}
+
+void clock_sync_master::sync()
+{
+  auto const sequence = static_cast<hal::u8>(m_sequence++ & 0xF);
+  auto const header = static_cast<hal::u8>((sync_frame << 4) | sequence);
+  // Cleared first, so a previous SYNC reported meanwhile is ignored
+  m_pending.store(0, std::memory_order_relaxed);
+  m_sent.store(0, std::memory_order_relaxed);
+  m_pending.store(header, std::memory_order_relaxed);
+  m_transceiver->send({
+    .id = m_id,
+    .length = 1,
+    .payload = { header },
+    .extended = m_id > standard_id_limit,
+  });
+}
+
+void clock_sync_master::transmitted(hal::can_message const& p_message,
+                                    hal::u64 p_start_of_frame)
+{
+  auto const pending = m_pending.load(std::memory_order_relaxed);
+  if (pending == 0 || p_message.id != m_id ||
+      p_message.extended != (m_id > standard_id_limit) ||
+      p_message.remote_request || p_message.length != 1 ||
+      p_message.payload[0] != pending) {
+    return;
+  }
+  m_sent_time = p_start_of_frame;
+  m_sent.store(pending, std::memory_order_release);
+}
+
+void clock_sync_master::poll()
+{
+  auto const pending = m_pending.load(std::memory_order_relaxed);
+  if (pending == 0 || m_sent.load(std::memory_order_acquire) != pending) {
+    return;
+  }
+  m_pending.store(0, std::memory_order_relaxed);
+  m_sent.store(0, std::memory_order_relaxed);
+
+  auto const time = m_to_time.nanoseconds(m_sent_time) & master_time_mask;
+  hal::can_message message{
+    .id = m_id,
+    .length = 8,
+    .payload = { static_cast<hal::u8>((follow_up_frame << 4) |
+                                      (pending & 0xF)) },
+    .extended = m_id > standard_id_limit,
+  };
+  for (std::size_t i = 0; i < 7; i++) {
+    message.payload[i + 1] = static_cast<hal::u8>(time >> (8 * i));
+  }
+  m_transceiver->send(message);
+}
+
+clock_sync_follower::clock_sync_follower(
+  hal::can_interrupt& p_interrupt,
+  synchronized_clock& p_clock,
+  hal::callback<hal::u64()> p_timestamp,
+  hal::u32 p_id,
+  std::span<can_capture_record> p_buffer)
+  : m_interrupt(&p_interrupt)
+  , m_clock(&p_clock)
+  , m_timestamp(p_timestamp)
+  , m_id(p_id)
+  , m_ring(p_buffer)
+{
+  m_interrupt->on_receive(
+    [this](hal::can_interrupt::on_receive_tag,
+           hal::can_message const& p_message) { capture(p_message); });
+}
+
+clock_sync_follower::~clock_sync_follower()
+{
+  m_interrupt->on_receive(std::nullopt);
+}
+
+void clock_sync_follower::poll()
+{
+  while (auto const* record = m_ring.front()) {
+    auto const& message = record->message;
+    auto const type = message.payload[0] >> 4;
+    if (type == sync_frame) {
+      m_sync_header = message.payload[0];
+      m_sync_time = record->timestamp;
+    } else if (type == follow_up_frame && message.length == 8 &&
+               m_sync_header != 0 &&
+               (m_sync_header & 0xF) == (message.payload[0] & 0xF)) {
+      hal::u64 master = 0;
+      for (std::size_t i = 0; i < 7; i++) {
+        master |= hal::u64{ message.payload[i + 1] } << (8 * i);
+      }
+      m_clock->correct(m_sync_time, master);
+      m_sync_header = 0;
+    }
+    m_ring.pop();
+  }
+}
+
+void clock_sync_follower::capture(hal::can_message const& p_message)
+{
+  auto const extended = m_id > standard_id_limit;
+  if (p_message.id != m_id || p_message.extended != extended ||
+      p_message.remote_request || p_message.length == 0) {
+    return;
+  }
+  // Timestamp first, as close to the reception as possible
+  auto const timestamp = m_timestamp();
+  auto const sequence = m_received.load(std::memory_order_relaxed);
+  m_received.store(sequence + 1, std::memory_order_relaxed);
+  (void)m_ring.push({ .timestamp = timestamp,
+                      .sequence = sequence,
+                      .message = p_message });
+}
+}  // namespace hal::micromod
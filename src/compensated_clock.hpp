@@ -0,0 +1,134 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+#include <libhal-arm-mcu/dwt_counter.hpp>
+#include <libhal-micromod/micromod.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include "extended_counter.hpp"
+#include "interrupt_lock.hpp"
+
+namespace hal::micromod {
+/**
+ * @brief DWT cycle counter corrected for the time the core spends asleep
+ *
+ * The DWT cycle counter counts core clock cycles, which may stop while the
+ * core waits for an interrupt. The board's sleep timer runs from a peripheral
+ * clock that keeps going, so each sleep is measured by both and any cycles the
+ * DWT counter missed are added to the uptime. Differences within the sleep
+ * timer's resolution are ignored, so a counter that keeps running while asleep
+ * is never corrected for the sleep timer's quantization.
+ *
+ * The 32-bit cycle counter wraps every 2^32 cycles (~67s at 64MHz, ~36s at
+ * 120MHz). It is extended to 64 bits by an extended_counter, so uptime() is
+ * wrap safe & lock free, and may be called from any interrupt. sample() must
+ * be called at least every quarter period of the cycle counter, which the
+ * board does from the sleep timer's periodic interrupt.
+ *
+ * A sleep timer provides:
+ *
+ *   - `std::uint32_t start()` - start measuring a sleep & arm a wake up
+ *     interrupt bounding it
+ *   - `hal::u64 stop(std::uint32_t)` - cpu cycles since start()
+ *   - `hal::u64 resolution()` - cpu cycles per sleep timer tick
+ *
+ * The DWT counter is enabled by the hal::cortex_m::dwt_counter this clock
+ * owns, but read directly, as the dwt_counter's own extension is not safe to
+ * use from interrupts.
+ */
+class compensated_clock final : public hal::steady_clock
+{
+public:
+  explicit compensated_clock(hal::hertz p_cpu_frequency)
+    : m_counter(p_cpu_frequency)
+  {
+  }
+
+  /**
+   * @brief Wait for an interrupt, accounting for the time spent asleep
+   *
+   * Interrupts are masked while asleep, so the interrupt that wakes the core is
+   * serviced after the uptime has been corrected.
+   *
+   * @param p_sleep_timer - timer measuring the sleep
+   */
+  template<class sleep_timer_t>
+  void sleep(sleep_timer_t& p_sleep_timer)
+  {
+    interrupt_lock lock;
+    std::lock_guard guard(lock);
+
+    auto const start = p_sleep_timer.start();
+    auto const before = cycles();
+    asm volatile("dsb\n"
+                 "wfi"
+                 :
+                 :
+                 : "memory");
+    auto const counted = cycles() - before;
+    auto const slept = p_sleep_timer.stop(start);
+
+    if (slept > counted + p_sleep_timer.resolution()) {
+      m_offset += slept - counted;
+    }
+    m_statistics.sleeps++;
+    m_statistics.asleep_ticks += slept;
+  }
+
+  [[nodiscard]] v1::sleep_statistics statistics() const
+  {
+    return m_statistics;
+  }
+
+  /// Keep the 64-bit extension of the cycle counter up to date
+  void sample()
+  {
+    static_cast<void>(cycles());
+  }
+
+private:
+  static std::uint32_t cycle_count()
+  {
+    return *reinterpret_cast<std::uint32_t volatile*>(0xE000'1004);
+  }
+
+  hal::u64 cycles()
+  {
+    return m_cycles.read(cycle_count);
+  }
+
+  hal::hertz driver_frequency() override
+  {
+    return m_counter.frequency();
+  }
+
+  hal::u64 driver_uptime() override
+  {
+    // Only updated with interrupts masked from thread context, so an interrupt
+    // never observes a partially written offset.
+    return cycles() + m_offset;
+  }
+
+  hal::cortex_m::dwt_counter m_counter;
+  extended_counter m_cycles{};
+  hal::u64 m_offset = 0;
+  v1::sleep_statistics m_statistics{};
+};
+}  // namespace hal::micromod
@@ -0,0 +1,121 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <libhal-micromod/dac_stream.hpp>
+
+#include <algorithm>
+
+namespace hal::micromod {
+dac_stream::dac_stream(std::span<hal::u32> p_buffer,
+                       hal::hertz p_sample_rate,
+                       hal::u32 p_sample_mask)
+  : m_buffer(p_buffer.first(p_buffer.size() / 2 * 2))
+  , m_sample_rate(p_sample_rate)
+  , m_sample_mask(p_sample_mask)
+{
+}
+
+hal::hertz dac_stream::sample_rate() const
+{
+  return m_sample_rate;
+}
+
+std::size_t dac_stream::block_samples() const
+{
+  return m_buffer.size() / 2;
+}
+
+std::size_t dac_stream::write(std::span<hal::u16 const> p_samples)
+{
+  auto const size = block_samples();
+  std::size_t queued = 0;
+  while (queued < p_samples.size()) {
+    auto const filled = m_filled.load(std::memory_order_acquire);
+    if (filled != m_filling) {
+      // The hardware started the block before it was complete
+      m_filling = filled;
+      m_position = 0;
+    }
+    if (filled != m_started.load(std::memory_order_acquire)) {
+      break;
+    }
+
+    auto const block = m_buffer.subspan((filled % 2) * size, size);
+    auto const count = std::min(size - m_position, p_samples.size() - queued);
+    for (std::size_t i = 0; i < count; i++) {
+      block[m_position + i] = p_samples[queued + i] & m_sample_mask;
+    }
+    if (m_filled.load(std::memory_order_acquire) != filled) {
+      // block_started() took the block as an underrun during the copy & it
+      // is playing now. Put back the sample it was filled with & write these
+      // samples into the next block instead.
+      auto const previous = m_buffer.subspan(((filled + 1) % 2) * size, size);
+      std::ranges::fill(block.subspan(m_position, count), previous.back());
+      continue;
+    }
+    m_position += count;
+    queued += count;
+
+    if (m_position == size) {
+      // Fails when block_started() took the block as an underrun since the
+      // check above, which then plays the held sample in place of these
+      auto expected = filled;
+      m_filled.compare_exchange_strong(
+        expected, filled + 1, std::memory_order_acq_rel);
+      m_filling = filled + 1;
+      m_position = 0;
+    }
+  }
+  return queued;
+}
+
+std::size_t dac_stream::writable() const
+{
+  auto const filled = m_filled.load(std::memory_order_acquire);
+  if (filled != m_started.load(std::memory_order_acquire)) {
+    return 0;
+  }
+  return block_samples() - (filled == m_filling ? m_position : 0);
+}
+
+dac_stream_statistics dac_stream::statistics() const
+{
+  return { .played = m_started.load(std::memory_order_acquire) - 1,
+           .underruns = m_underruns.load(std::memory_order_relaxed) };
+}
+
+std::span<hal::u32> dac_stream::buffer() const
+{
+  return m_buffer;
+}
+
+void dac_stream::block_started()
+{
+  auto const started = m_started.load(std::memory_order_relaxed);
+  auto const size = block_samples();
+  // Block `started` is the one starting now, take it if write() has not
+  // completed it
+  auto expected = started;
+  if (m_filled.compare_exchange_strong(
+        expected, started + 1, std::memory_order_acq_rel)) {
+    auto const previous = m_buffer.subspan(((started + 1) % 2) * size, size);
+    std::ranges::fill(m_buffer.subspan((started % 2) * size, size),
+                      previous.back());
+    m_underruns.store(m_underruns.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+  }
+  m_started.store(started + 1, std::memory_order_release);
+}
+}  // namespace hal::micromod
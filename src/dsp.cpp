@@ -0,0 +1,357 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/dsp.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
+
+namespace hal::micromod {
+namespace {
+/// Fractional bits of the biquad coefficients
+constexpr int biquad_shift = 14;
+/// Fractional bits of the fir coefficients
+constexpr int fir_shift = 15;
+/// Bits the cic integrators may grow by before the 32-bit registers overflow
+constexpr std::size_t cic_growth_limit = 16;
+
+/// Round away the fractional bits of an accumulator & saturate it to q15
+q15 narrow(std::int64_t p_accumulator, int p_shift)
+{
+  auto const rounded =
+    (p_accumulator + (std::int64_t{ 1 } << (p_shift - 1))) >> p_shift;
+  return static_cast<q15>(std::clamp<std::int64_t>(rounded, -32768, 32767));
+}
+
+// Two q15 values packed in a word, the first in the low half, as the dual
+// multiply accumulate instructions take them
+using q15x2 = std::uint32_t;
+
+q15x2 pack(q15 p_low, q15 p_high)
+{
+  return static_cast<std::uint16_t>(p_low) |
+         (static_cast<q15x2>(static_cast<std::uint16_t>(p_high)) << 16);
+}
+
+/// Two consecutive samples, p_pair[0] in the low half
+q15x2 load_pair(q15 const* p_pair)
+{
+#if defined(__ARM_FEATURE_SIMD32)
+  // A single (unaligned) word load on the little endian Cortex-M
+  q15x2 pair = 0;
+  std::memcpy(&pair, p_pair, sizeof(pair));
+  return pair;
+#else
+  return pack(p_pair[0], p_pair[1]);
+#endif
+}
+
+#if !defined(__ARM_FEATURE_SIMD32)
+std::int64_t low(q15x2 p_pair)
+{
+  return static_cast<q15>(p_pair & 0xFFFF);
+}
+
+std::int64_t high(q15x2 p_pair)
+{
+  return static_cast<q15>(p_pair >> 16);
+}
+#endif
+
+/// acc + low * low + high * high
+std::int64_t smlald(q15x2 p_a, q15x2 p_b, std::int64_t p_accumulator)
+{
+#if defined(__ARM_FEATURE_SIMD32)
+  return __smlald(static_cast<std::int32_t>(p_a),
+                  static_cast<std::int32_t>(p_b),
+                  p_accumulator);
+#else
+  return p_accumulator + (low(p_a) * low(p_b)) + (high(p_a) * high(p_b));
+#endif
+}
+
+/// acc + low * high + high * low
+std::int64_t smlaldx(q15x2 p_a, q15x2 p_b, std::int64_t p_accumulator)
+{
+#if defined(__ARM_FEATURE_SIMD32)
+  return __smlaldx(static_cast<std::int32_t>(p_a),
+                   static_cast<std::int32_t>(p_b),
+                   p_accumulator);
+#else
+  return p_accumulator + (low(p_a) * high(p_b)) + (high(p_a) * low(p_b));
+#endif
+}
+
+/// acc + low * low - high * high
+std::int64_t smlsld(q15x2 p_a, q15x2 p_b, std::int64_t p_accumulator)
+{
+#if defined(__ARM_FEATURE_SIMD32)
+  return __smlsld(static_cast<std::int32_t>(p_a),
+                  static_cast<std::int32_t>(p_b),
+                  p_accumulator);
+#else
+  return p_accumulator + (low(p_a) * low(p_b)) - (high(p_a) * high(p_b));
+#endif
+}
+
+/**
+ * Each output from p_window[i] to p_window[i + taps - 1], the newest sample
+ * last, so h[k] multiplies p_window[i + taps - 1 - k].
+ */
+void fir_scalar(std::span<q15 const> p_coefficients,
+                q15 const* p_window,
+                std::span<q15> p_output)
+{
+  auto const newest = p_coefficients.size() - 1;
+  for (std::size_t i = 0; i < p_output.size(); i++) {
+    auto const* samples = p_window + i + newest;
+    std::int64_t accumulator = 0;
+    for (std::size_t k = 0; k < p_coefficients.size(); k++) {
+      accumulator += std::int32_t{ p_coefficients[k] } * samples[-k];
+    }
+    p_output[i] = narrow(accumulator, fir_shift);
+  }
+}
+
+void fir_dual_mac(std::span<q15 const> p_coefficients,
+                  q15 const* p_window,
+                  std::span<q15> p_output)
+{
+  auto const taps = p_coefficients.size();
+  auto const* coefficients = p_coefficients.data();
+  for (std::size_t i = 0; i < p_output.size(); i++) {
+    auto const* samples = p_window + i + taps - 1;
+    std::int64_t accumulator = 0;
+    std::size_t k = 0;
+    for (; k + 1 < taps; k += 2) {
+      // h[k] * x[n - k] + h[k + 1] * x[n - k - 1]
+      accumulator = smlaldx(load_pair(coefficients + k),
+                            load_pair(samples - k - 1),
+                            accumulator);
+    }
+    if (k < taps) {
+      accumulator += std::int32_t{ coefficients[k] } * samples[-k];
+    }
+    p_output[i] = narrow(accumulator, fir_shift);
+  }
+}
+
+void biquad_scalar(biquad_coefficients const& p_stage,
+                   biquad_state& p_state,
+                   std::span<q15 const> p_input,
+                   std::span<q15> p_output)
+{
+  auto state = p_state;
+  for (std::size_t i = 0; i < p_output.size(); i++) {
+    auto const x0 = p_input[i];
+    std::int64_t accumulator = std::int32_t{ p_stage.b0 } * x0;
+    accumulator += std::int32_t{ p_stage.b1 } * state.x1;
+    accumulator += std::int32_t{ p_stage.b2 } * state.x2;
+    accumulator -= std::int32_t{ p_stage.a1 } * state.y1;
+    accumulator -= std::int32_t{ p_stage.a2 } * state.y2;
+    auto const y0 = narrow(accumulator, biquad_shift);
+    state = { .x1 = x0, .x2 = state.x1, .y1 = y0, .y2 = state.y1 };
+    p_output[i] = y0;
+  }
+  p_state = state;
+}
+
+void biquad_dual_mac(biquad_coefficients const& p_stage,
+                     biquad_state& p_state,
+                     std::span<q15 const> p_input,
+                     std::span<q15> p_output)
+{
+  auto const b0_b1 = pack(p_stage.b0, p_stage.b1);
+  auto const b2_a1 = pack(p_stage.b2, p_stage.a1);
+  auto const a2 = std::int32_t{ p_stage.a2 };
+  auto state = p_state;
+  for (std::size_t i = 0; i < p_output.size(); i++) {
+    auto const x0 = p_input[i];
+    // b0 x0 + b1 x1, then b2 x2 - a1 y1
+    auto accumulator = smlald(pack(x0, state.x1), b0_b1, 0);
+    accumulator = smlsld(pack(state.x2, state.y1), b2_a1, accumulator);
+    accumulator -= a2 * state.y2;
+    auto const y0 = narrow(accumulator, biquad_shift);
+    state = { .x1 = x0, .x2 = state.x1, .y1 = y0, .y2 = state.y1 };
+    p_output[i] = y0;
+  }
+  p_state = state;
+}
+}  // namespace
+
+std::span<q15> analog_to_q15(analog_block const& p_block,
+                             analog_channel p_channel,
+                             std::span<q15> p_output)
+{
+  constexpr int mid_scale = (analog_full_scale + 1) / 2;
+  // 12-bit samples to the top of the 16-bit range
+  constexpr int shift = 4;
+  auto const output =
+    p_output.first(std::min(p_output.size(), p_block.frames()));
+  for (std::size_t i = 0; i < output.size(); i++) {
+    output[i] = static_cast<q15>((p_block.sample(i, p_channel) - mid_scale)
+                                 << shift);
+  }
+  return output;
+}
+
+fir_filter::fir_filter(std::span<q15 const> p_coefficients,
+                       std::span<q15> p_state)
+  : m_coefficients(p_coefficients)
+  , m_state(p_state)
+{
+  reset();
+}
+
+void fir_filter::process(std::span<q15 const> p_input,
+                         std::span<q15> p_output,
+                         dsp_kernel p_kernel)
+{
+  auto const history = m_coefficients.size() - 1;
+  auto const pass = m_state.size() - history;
+  auto const count = std::min(p_input.size(), p_output.size());
+  for (std::size_t done = 0; done < count;) {
+    auto const samples = std::min(pass, count - done);
+    // Copied before any output is written, so the output may overwrite it
+    std::copy_n(p_input.begin() + done, samples, m_state.begin() + history);
+    auto const output = p_output.subspan(done, samples);
+    if (p_kernel == dsp_kernel::dual_mac) {
+      fir_dual_mac(m_coefficients, m_state.data(), output);
+    } else {
+      fir_scalar(m_coefficients, m_state.data(), output);
+    }
+    // Keep the newest taps - 1 samples for the next pass
+    std::copy_n(m_state.begin() + samples, history, m_state.begin());
+    done += samples;
+  }
+}
+
+void fir_filter::reset()
+{
+  std::ranges::fill(m_state, 0);
+}
+
+biquad_cascade::biquad_cascade(std::span<biquad_coefficients const> p_stages,
+                               std::span<biquad_state> p_state)
+  : m_stages(p_stages)
+  , m_state(p_state.first(std::min(p_state.size(), p_stages.size())))
+{
+  reset();
+}
+
+void biquad_cascade::process(std::span<q15 const> p_input,
+                             std::span<q15> p_output,
+                             dsp_kernel p_kernel)
+{
+  auto const count = std::min(p_input.size(), p_output.size());
+  auto input = p_input.first(count);
+  auto const output = p_output.first(count);
+  for (std::size_t i = 0; i < m_state.size(); i++) {
+    // Each stage filters the previous one's output in place
+    if (p_kernel == dsp_kernel::dual_mac) {
+      biquad_dual_mac(m_stages[i], m_state[i], input, output);
+    } else {
+      biquad_scalar(m_stages[i], m_state[i], input, output);
+    }
+    input = output;
+  }
+  if (m_state.empty()) {
+    std::ranges::copy(input, output.begin());
+  }
+}
+
+void biquad_cascade::reset()
+{
+  std::ranges::fill(m_state, biquad_state{});
+}
+
+moving_average::moving_average(std::span<q15> p_window)
+  : m_window(p_window.first(
+      std::bit_floor(std::min<std::size_t>(p_window.size(), 1 << 16))))
+  , m_shift(std::countr_zero(m_window.size()))
+{
+  reset();
+}
+
+void moving_average::process(std::span<q15 const> p_input,
+                             std::span<q15> p_output)
+{
+  auto const count = std::min(p_input.size(), p_output.size());
+  auto const mask = m_window.size() - 1;
+  for (std::size_t i = 0; i < count; i++) {
+    auto const sample = p_input[i];
+    m_sum += sample - m_window[m_index];
+    m_window[m_index] = sample;
+    m_index = (m_index + 1) & mask;
+    p_output[i] = m_shift == 0 ? sample : narrow(m_sum, m_shift);
+  }
+}
+
+void moving_average::reset()
+{
+  std::ranges::fill(m_window, 0);
+  m_index = 0;
+  m_sum = 0;
+}
+
+cic_decimator::cic_decimator(std::size_t p_order, std::size_t p_ratio)
+  : m_order(std::clamp<std::size_t>(p_order, 1, maximum_order))
+  // The integrators grow by order * log2(R) bits over the 16-bit input
+  , m_ratio(std::bit_floor(std::clamp<std::size_t>(
+      p_ratio, 1, std::size_t{ 1 } << (cic_growth_limit / m_order))))
+  , m_shift(static_cast<int>(m_order) * std::countr_zero(m_ratio))
+{
+}
+
+std::size_t cic_decimator::process(std::span<q15 const> p_input,
+                                   std::span<q15> p_output)
+{
+  std::size_t written = 0;
+  for (auto const sample : p_input) {
+    // Wrapping is harmless as long as the output fits the register
+    auto value = static_cast<std::uint32_t>(std::int32_t{ sample });
+    for (std::size_t i = 0; i < m_order; i++) {
+      m_integrators[i] += value;
+      value = m_integrators[i];
+    }
+    if (++m_phase < m_ratio) {
+      continue;
+    }
+    m_phase = 0;
+    for (std::size_t i = 0; i < m_order; i++) {
+      auto const delayed = m_combs[i];
+      m_combs[i] = value;
+      value -= delayed;
+    }
+    if (written < p_output.size()) {
+      auto const output = static_cast<std::int32_t>(value);
+      p_output[written++] =
+        m_shift == 0 ? static_cast<q15>(output) : narrow(output, m_shift);
+    }
+  }
+  return written;
+}
+
+void cic_decimator::reset()
+{
+  m_integrators = {};
+  m_combs = {};
+  m_phase = 0;
+}
+}  // namespace hal::micromod
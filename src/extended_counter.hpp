@@ -0,0 +1,70 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include <libhal/units.hpp>
+
+namespace hal::micromod {
+/**
+ * @brief Extends a free running 32-bit counter to 64 bits
+ *
+ * The extension is kept as the number of half periods (2^31 counts) the
+ * counter had completed when it was last read, in a single atomic word. A read
+ * loads the epoch before the counter, then takes the count that lies within
+ * one period after the start of the epoch. There is no lock to wait for, so
+ * reads are safe from any interrupt priority, and any read may advance the
+ * epoch.
+ *
+ * The counter must be read at least once every half period, for example from a
+ * periodic interrupt, including the time a reader may be preempted for.
+ */
+class extended_counter
+{
+public:
+  /**
+   * @brief Read the counter extended to 64 bits
+   *
+   * @param p_read_count - returns the current 32-bit count
+   * @return hal::u64 - count extended to 64 bits
+   */
+  template<class read_count_t>
+  hal::u64 read(read_count_t p_read_count)
+  {
+    // The epoch must be loaded before the counter is read, so the count is
+    // never behind the start of the epoch.
+    auto epoch = m_epoch.load(std::memory_order_acquire);
+    std::uint32_t const count = p_read_count();
+
+    auto const base = static_cast<hal::u64>(epoch) << half_period_bits;
+    auto const value = base + (count - static_cast<std::uint32_t>(base));
+
+    auto const current = static_cast<std::uint32_t>(value >> half_period_bits);
+    while (epoch < current &&
+           not m_epoch.compare_exchange_weak(
+             epoch, current, std::memory_order_release)) {
+      continue;
+    }
+    return value;
+  }
+
+private:
+  static constexpr unsigned half_period_bits = 31;
+
+  std::atomic<std::uint32_t> m_epoch = 0;
+};
+}  // namespace hal::micromod
@@ -0,0 +1,56 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include <libhal/lock.hpp>
+
+namespace hal::micromod {
+/**
+ * @brief Lock that masks all maskable interrupts on Cortex-M cores
+ *
+ * Used to protect state shared with interrupt service routines, where a
+ * blocking or spinning lock would deadlock. Locks may be nested, interrupts are
+ * only restored when the outermost lock is released, and only if they were
+ * enabled before it was taken.
+ */
+class interrupt_lock final : public hal::basic_lock
+{
+private:
+  void os_lock() override
+  {
+    std::uint32_t primask = 0;
+    asm volatile("mrs %0, primask\n"
+                 "cpsid i"
+                 : "=r"(primask)
+                 :
+                 : "memory");
+    if (m_depth++ == 0) {
+      m_primask = primask;
+    }
+  }
+
+  void os_unlock() override
+  {
+    if (--m_depth == 0 && (m_primask & 1U) == 0) {
+      asm volatile("cpsie i" ::: "memory");
+    }
+  }
+
+  std::uint32_t m_primask = 0;
+  std::uint32_t m_depth = 0;
+};
+}  // namespace hal::micromod
@@ -0,0 +1,462 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <libhal-micromod/isotp.hpp>
+
+#include <algorithm>
+#include <array>
+
+namespace hal::micromod {
+namespace {
+/// Protocol control information, the high nibble of the first byte
+enum frame_type : hal::u8
+{
+  single_frame = 0x0,
+  first_frame = 0x1,
+  consecutive_frame = 0x2,
+  flow_control = 0x3,
+};
+
+/// Flow status, the low nibble of the first byte of a flow control frame
+enum flow_status : hal::u8
+{
+  continue_to_send = 0x0,
+  wait = 0x1,
+  overflow = 0x2,
+};
+
+/// Data bytes of a classic CAN frame
+constexpr std::size_t frame_size = 8;
+/// Data bytes of a single frame or consecutive frame
+constexpr std::size_t frame_data_size = frame_size - 1;
+/// Longest message whose length fits the 12-bit first frame length
+constexpr std::size_t short_first_frame_limit = 0xFFF;
+
+hal::u8 protocol_byte(frame_type p_type, hal::u32 p_low)
+{
+  return static_cast<hal::u8>((p_type << 4) | (p_low & 0xF));
+}
+}  // namespace
+
+isotp_channel::isotp_channel(isotp_address const& p_address,
+                             isotp_settings const& p_settings)
+  : m_address(p_address)
+  , m_settings(p_settings)
+{
+}
+
+bool isotp_channel::send(std::span<hal::byte const> p_data)
+{
+  if (m_transmit_state != transmit_state::idle || p_data.empty() ||
+      hal::u64{ p_data.size() } > isotp_maximum_length) {
+    return false;
+  }
+  m_transmit_data = p_data;
+  m_transmit_offset = 0;
+  m_transmit_state = transmit_state::first_frame;
+  m_transmit_status = isotp_status::busy;
+  return true;
+}
+
+void isotp_channel::receive(std::span<hal::byte> p_buffer)
+{
+  m_receive_buffer = p_buffer;
+  m_receive_length = 0;
+  m_receive_offset = 0;
+  m_receive_state = receive_state::idle;
+  m_receive_status = isotp_status::idle;
+}
+
+isotp_status isotp_channel::transmit_status() const
+{
+  return m_transmit_status;
+}
+
+isotp_status isotp_channel::receive_status() const
+{
+  return m_receive_status;
+}
+
+std::span<hal::byte const> isotp_channel::received() const
+{
+  if (m_receive_status != isotp_status::complete) {
+    return {};
+  }
+  return m_receive_buffer.first(m_receive_length);
+}
+
+isotp_address const& isotp_channel::address() const
+{
+  return m_address;
+}
+
+void isotp_channel::process(isotp_router& p_router,
+                            hal::can_message const& p_message,
+                            hal::u64 p_now)
+{
+  if (p_message.remote_request || p_message.length == 0) {
+    return;
+  }
+  switch (p_message.payload[0] >> 4) {
+    case single_frame:
+      process_single_frame(p_message);
+      break;
+    case first_frame:
+      process_first_frame(p_router, p_message, p_now);
+      break;
+    case consecutive_frame:
+      process_consecutive_frame(p_router, p_message, p_now);
+      break;
+    case flow_control:
+      process_flow_control(p_message, p_now);
+      break;
+    default:
+      // Reserved frame types are ignored
+      break;
+  }
+}
+
+void isotp_channel::process_flow_control(hal::can_message const& p_message,
+                                         hal::u64 p_now)
+{
+  if (m_transmit_state != transmit_state::wait_for_flow_control) {
+    return;
+  }
+  if (p_message.length < 3) {
+    m_transmit_state = transmit_state::idle;
+    m_transmit_status = isotp_status::protocol_error;
+    return;
+  }
+
+  switch (p_message.payload[0] & 0xF) {
+    case continue_to_send:
+      m_block_size = p_message.payload[1];
+      m_block_remaining = m_block_size;
+      m_separation = isotp_decode_separation(p_message.payload[2]);
+      m_transmit_time = p_now;
+      m_transmit_state = transmit_state::consecutive_frames;
+      break;
+    case wait:
+      m_transmit_time = p_now + m_settings.timeout.count();
+      break;
+    case overflow:
+      m_transmit_state = transmit_state::idle;
+      m_transmit_status = isotp_status::overflow;
+      break;
+    default:
+      m_transmit_state = transmit_state::idle;
+      m_transmit_status = isotp_status::protocol_error;
+      break;
+  }
+}
+
+void isotp_channel::process_single_frame(hal::can_message const& p_message)
+{
+  std::size_t const length = p_message.payload[0] & 0xF;
+  if (length == 0 || length > frame_data_size || length >= p_message.length) {
+    return;
+  }
+  if (m_receive_state == receive_state::done) {
+    // The last message was not taken yet
+    return;
+  }
+  if (length > m_receive_buffer.size()) {
+    m_receive_state = receive_state::idle;
+    m_receive_status = isotp_status::overflow;
+    return;
+  }
+
+  // Replaces a multi frame message in progress, as ISO 15765-2 requires
+  std::copy_n(&p_message.payload[1], length, m_receive_buffer.begin());
+  m_receive_length = length;
+  m_receive_state = receive_state::done;
+  m_receive_status = isotp_status::complete;
+}
+
+void isotp_channel::process_first_frame(isotp_router& p_router,
+                                        hal::can_message const& p_message,
+                                        hal::u64 p_now)
+{
+  if (p_message.length < frame_size) {
+    return;
+  }
+  auto const& payload = p_message.payload;
+  std::size_t length = ((payload[0] & 0xFU) << 8) | payload[1];
+  std::size_t data_start = 2;
+  if (length == 0) {
+    // Escape sequence, the length follows as 32 bits
+    length = (hal::u32{ payload[2] } << 24) | (hal::u32{ payload[3] } << 16) |
+             (hal::u32{ payload[4] } << 8) | payload[5];
+    data_start = 6;
+  }
+  if (length <= frame_data_size) {
+    return;
+  }
+
+  if (m_receive_state == receive_state::done) {
+    send_flow_control(p_router, overflow);
+    return;
+  }
+  if (length > m_receive_buffer.size()) {
+    send_flow_control(p_router, overflow);
+    m_receive_state = receive_state::idle;
+    m_receive_status = isotp_status::overflow;
+    return;
+  }
+
+  // Replaces a multi frame message in progress, as ISO 15765-2 requires
+  auto const data = frame_size - data_start;
+  std::copy_n(&payload[data_start], data, m_receive_buffer.begin());
+  m_receive_length = length;
+  m_receive_offset = data;
+  m_receive_sequence = 1;
+  m_receive_block = 0;
+  m_receive_deadline = p_now + m_settings.timeout.count();
+  m_receive_state = receive_state::consecutive_frames;
+  m_receive_status = isotp_status::busy;
+  send_flow_control(p_router, continue_to_send);
+}
+
+void isotp_channel::process_consecutive_frame(
+  isotp_router& p_router,
+  hal::can_message const& p_message,
+  hal::u64 p_now)
+{
+  if (m_receive_state != receive_state::consecutive_frames) {
+    return;
+  }
+  auto const data = std::min(frame_data_size,
+                             m_receive_length - m_receive_offset);
+  if ((p_message.payload[0] & 0xF) != (m_receive_sequence & 0xF) ||
+      p_message.length < data + 1) {
+    m_receive_state = receive_state::idle;
+    m_receive_status = isotp_status::protocol_error;
+    return;
+  }
+
+  std::copy_n(&p_message.payload[1],
+              data,
+              m_receive_buffer.subspan(m_receive_offset).begin());
+  m_receive_offset += data;
+  m_receive_sequence++;
+  m_receive_deadline = p_now + m_settings.timeout.count();
+
+  if (m_receive_offset == m_receive_length) {
+    m_receive_state = receive_state::done;
+    m_receive_status = isotp_status::complete;
+    return;
+  }
+  if (m_settings.block_size != 0 &&
+      ++m_receive_block == m_settings.block_size) {
+    m_receive_block = 0;
+    send_flow_control(p_router, continue_to_send);
+  }
+}
+
+bool isotp_channel::transmit(isotp_router& p_router, hal::u64 p_now)
+{
+  std::array<hal::byte, frame_size> frame{};
+  auto const remaining = m_transmit_data.size() - m_transmit_offset;
+
+  switch (m_transmit_state) {
+    case transmit_state::first_frame: {
+      auto const length = m_transmit_data.size();
+      if (length <= frame_data_size) {
+        frame[0] = protocol_byte(single_frame, length);
+        std::ranges::copy(m_transmit_data, &frame[1]);
+        p_router.send(*this, std::span(frame).first(length + 1));
+        m_transmit_state = transmit_state::idle;
+        m_transmit_status = isotp_status::complete;
+        return true;
+      }
+
+      std::size_t data_start = 2;
+      if (length <= short_first_frame_limit) {
+        frame[0] = protocol_byte(first_frame, length >> 8);
+        frame[1] = static_cast<hal::byte>(length);
+      } else {
+        auto const long_length = static_cast<hal::u32>(length);
+        frame[0] = protocol_byte(first_frame, 0);
+        frame[1] = 0;
+        frame[2] = static_cast<hal::byte>(long_length >> 24);
+        frame[3] = static_cast<hal::byte>(long_length >> 16);
+        frame[4] = static_cast<hal::byte>(long_length >> 8);
+        frame[5] = static_cast<hal::byte>(long_length);
+        data_start = 6;
+      }
+      auto const data = frame_size - data_start;
+      std::copy_n(m_transmit_data.begin(), data, &frame[data_start]);
+      p_router.send(*this, frame);
+      m_transmit_offset = data;
+      m_transmit_sequence = 1;
+      m_transmit_time = p_now + m_settings.timeout.count();
+      m_transmit_state = transmit_state::wait_for_flow_control;
+      return true;
+    }
+    case transmit_state::consecutive_frames: {
+      if (p_now < m_transmit_time) {
+        return false;
+      }
+      auto const data = std::min(frame_data_size, remaining);
+      frame[0] = protocol_byte(consecutive_frame, m_transmit_sequence++);
+      std::copy_n(
+        m_transmit_data.subspan(m_transmit_offset).begin(), data, &frame[1]);
+      p_router.send(*this, std::span(frame).first(data + 1));
+      m_transmit_offset += data;
+
+      if (m_transmit_offset == m_transmit_data.size()) {
+        m_transmit_state = transmit_state::idle;
+        m_transmit_status = isotp_status::complete;
+      } else if (m_block_size != 0 && --m_block_remaining == 0) {
+        m_transmit_time = p_now + m_settings.timeout.count();
+        m_transmit_state = transmit_state::wait_for_flow_control;
+      } else {
+        m_transmit_time = p_now + m_separation;
+      }
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+void isotp_channel::check_timeouts(hal::u64 p_now)
+{
+  if (m_transmit_state == transmit_state::wait_for_flow_control &&
+      p_now >= m_transmit_time) {
+    m_transmit_state = transmit_state::idle;
+    m_transmit_status = isotp_status::timed_out;
+  }
+  if (m_receive_state == receive_state::consecutive_frames &&
+      p_now >= m_receive_deadline) {
+    m_receive_state = receive_state::idle;
+    m_receive_status = isotp_status::timed_out;
+  }
+}
+
+void isotp_channel::send_flow_control(isotp_router& p_router, hal::u8 p_status)
+{
+  std::array<hal::byte, 3> const frame{
+    protocol_byte(flow_control, p_status),
+    m_settings.block_size,
+    isotp_encode_separation(m_settings.separation_time),
+  };
+  p_router.send(*this, frame);
+}
+
+isotp_router::isotp_router(hal::can_transceiver& p_transceiver,
+                           hal::can_interrupt& p_interrupt,
+                           hal::steady_clock& p_clock,
+                           std::span<isotp_channel* const> p_channels,
+                           std::span<hal::can_message> p_buffer)
+  : m_transceiver(&p_transceiver)
+  , m_interrupt(&p_interrupt)
+  , m_clock(&p_clock)
+  , m_to_time(p_clock.frequency())
+  , m_channels(p_channels)
+  , m_ring(p_buffer)
+{
+  m_interrupt->on_receive(
+    [this](hal::can_interrupt::on_receive_tag,
+           hal::can_message const& p_message) { capture(p_message); });
+}
+
+isotp_router::~isotp_router()
+{
+  m_interrupt->on_receive(std::nullopt);
+}
+
+void isotp_router::poll()
+{
+  auto now = this->now();
+  deliver(now);
+  for (auto* channel : m_channels) {
+    if (channel->transmit(*this, now)) {
+      now = this->now();
+    }
+  }
+  for (auto* channel : m_channels) {
+    channel->check_timeouts(now);
+  }
+}
+
+isotp_statistics isotp_router::statistics() const
+{
+  return {
+    .received = m_received.load(std::memory_order_relaxed),
+    .dropped = m_dropped.load(std::memory_order_relaxed),
+    .sent = m_sent,
+  };
+}
+
+void isotp_router::capture(hal::can_message const& p_message)
+{
+  // Only the channel addresses are read here, they never change
+  for (auto const* channel : m_channels) {
+    auto const& address = channel->address();
+    if (address.receive_id != p_message.id ||
+        address.extended != p_message.extended) {
+      continue;
+    }
+    m_received.store(m_received.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+    if (not m_ring.push(p_message)) {
+      m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+    }
+    return;
+  }
+}
+
+void isotp_router::deliver(hal::u64 p_now)
+{
+  while (auto const* message = m_ring.front()) {
+    for (auto* channel : m_channels) {
+      auto const& address = channel->address();
+      if (address.receive_id == message->id &&
+          address.extended == message->extended) {
+        channel->process(*this, *message, p_now);
+        break;
+      }
+    }
+    m_ring.pop();
+  }
+}
+
+void isotp_router::send(isotp_channel const& p_channel,
+                        std::span<hal::byte const> p_data)
+{
+  auto const& settings = p_channel.m_settings;
+  hal::can_message message{
+    .id = p_channel.address().transmit_id,
+    .length = static_cast<hal::u8>(p_data.size()),
+    .extended = p_channel.address().extended,
+  };
+  std::ranges::copy(p_data, message.payload.begin());
+  if (settings.padding) {
+    std::fill(&message.payload[p_data.size()],
+              message.payload.end(),
+              *settings.padding);
+    message.length = frame_size;
+  }
+  m_transceiver->send(message);
+  m_sent++;
+}
+
+hal::u64 isotp_router::now() const
+{
+  return m_to_time.microseconds(m_clock->uptime());
+}
+}  // namespace hal::micromod
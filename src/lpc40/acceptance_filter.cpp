@@ -0,0 +1,306 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "acceptance_filter.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace hal::micromod::lpc40 {
+namespace {
+constexpr std::uint32_t standard_id_mask = 0x7FF;
+constexpr std::uint32_t extended_id_mask = 0x1FFF'FFFF;
+/// Standard entry bit that disables the entry
+constexpr std::uint32_t standard_disable = 1 << 12;
+/// Unused standard entry, sorts after every valid entry
+constexpr std::uint32_t standard_padding = 0xFFFF;
+
+struct id_range
+{
+  std::uint32_t lower;
+  std::uint32_t upper;
+};
+
+template<std::size_t capacity>
+struct range_list
+{
+  void push(std::uint32_t p_lower, std::uint32_t p_upper)
+  {
+    ranges[size++] = { .lower = p_lower, .upper = p_upper };
+  }
+
+  /// Sort the ranges & merge those that overlap or touch
+  std::span<id_range const> merge()
+  {
+    auto const used = std::span(ranges).first(size);
+    std::ranges::sort(used, {}, &id_range::lower);
+    std::size_t merged = 0;
+    for (auto const& range : used) {
+      if (merged > 0 && range.lower <= ranges[merged - 1].upper + 1) {
+        ranges[merged - 1].upper =
+          std::max(ranges[merged - 1].upper, range.upper);
+      } else {
+        ranges[merged++] = range;
+      }
+    }
+    return std::span(ranges).first(merged);
+  }
+
+  std::array<id_range, capacity> ranges{};
+  std::size_t size = 0;
+};
+
+/**
+ * @brief Split a mask filter into the ranges of identifiers it accepts
+ *
+ * Don't care bits below the lowest compared bit form the width of each range,
+ * the don't care bits above it select one of the ranges.
+ *
+ * @return true - the ranges accept exactly what the mask filter does
+ */
+template<std::size_t capacity>
+bool split_mask(std::uint32_t p_id,
+                std::uint32_t p_mask,
+                std::uint32_t p_id_mask,
+                std::size_t p_maximum_ranges,
+                range_list<capacity>& p_list)
+{
+  auto mask = p_mask & p_id_mask;
+  auto low = mask == 0 ? p_id_mask : ((mask & -mask) - 1);
+  auto selecting = ~mask & p_id_mask & ~low;
+  auto const maximum_bits =
+    static_cast<int>(std::bit_width(p_maximum_ranges)) - 1;
+  bool exact = true;
+
+  while (std::popcount(selecting) > maximum_bits) {
+    // Stop comparing the bits up to the lowest selecting bit, which widens the
+    // ranges & halves their number.
+    auto const bit = selecting & -selecting;
+    low = (bit << 1) - 1;
+    mask &= ~low;
+    selecting = ~mask & p_id_mask & ~low;
+    exact = false;
+  }
+
+  auto const base = p_id & mask;
+  std::uint32_t subset = 0;
+  do {
+    p_list.push(base | subset, base | subset | low);
+    // Next subset of the selecting bits
+    subset = (subset - selecting) & selecting;
+  } while (subset != 0);
+
+  return exact;
+}
+
+/// Determine if a mask filter cannot match any identifier of its kind
+bool never_matches(std::uint32_t p_id,
+                   std::uint32_t p_mask,
+                   std::uint32_t p_id_mask)
+{
+  return (p_id & p_mask & ~p_id_mask) != 0;
+}
+
+template<class pair_t>
+std::optional<id_range> to_range(pair_t const& p_pair, std::uint32_t p_id_mask)
+{
+  auto const lower = std::min<std::uint32_t>(p_pair.id_1, p_pair.id_2);
+  auto const upper = std::max<std::uint32_t>(p_pair.id_1, p_pair.id_2);
+  if (lower > p_id_mask) {
+    return std::nullopt;
+  }
+  return id_range{ .lower = lower, .upper = std::min(upper, p_id_mask) };
+}
+
+std::uint32_t standard_entry(std::uint8_t p_controller, std::uint32_t p_id)
+{
+  return (static_cast<std::uint32_t>(p_controller) << 13) | p_id;
+}
+
+std::uint32_t extended_entry(std::uint8_t p_controller, std::uint32_t p_id)
+{
+  return (static_cast<std::uint32_t>(p_controller) << 29) | p_id;
+}
+
+bool standard_entry_matches(std::uint32_t p_entry, std::uint32_t p_key)
+{
+  return (p_entry & standard_disable) == 0 && p_entry == p_key;
+}
+}  // namespace
+
+acceptance_filter_layout build_acceptance_filter(
+  can_filter_settings const& p_settings,
+  std::uint8_t p_controller,
+  std::span<std::uint32_t, acceptance_filter_words> p_table)
+{
+  acceptance_filter_layout layout{};
+  std::size_t word = 0;
+
+  // Standard identifiers, sorted one per word then packed two per word
+  for (auto const& filter : p_settings.identifiers) {
+    if (filter && *filter <= standard_id_mask) {
+      p_table[word++] = standard_entry(p_controller, *filter);
+    }
+  }
+  auto standard = p_table.first(word);
+  std::ranges::sort(standard);
+  standard = standard.first(static_cast<std::size_t>(
+    std::ranges::unique(standard).begin() - standard.begin()));
+  word = 0;
+  for (std::size_t i = 0; i < standard.size(); i += 2) {
+    auto const second =
+      i + 1 < standard.size() ? standard[i + 1] : standard_padding;
+    p_table[word++] = (standard[i] << 16) | second;
+  }
+
+  // Standard ranges, including mask filters split into ranges
+  layout.standard_group_start = word * sizeof(std::uint32_t);
+  range_list<can_filter_count * (1 + standard_mask_ranges)> standard_ranges;
+  for (auto const& filter : p_settings.ranges) {
+    if (auto const range = filter ? to_range(*filter, standard_id_mask)
+                                  : std::nullopt) {
+      standard_ranges.push(range->lower, range->upper);
+    }
+  }
+  for (auto const& filter : p_settings.masks) {
+    if (filter &&
+        not never_matches(filter->id, filter->mask, standard_id_mask)) {
+      layout.exact &= split_mask(filter->id,
+                                 filter->mask,
+                                 standard_id_mask,
+                                 standard_mask_ranges,
+                                 standard_ranges);
+    }
+  }
+  for (auto const& range : standard_ranges.merge()) {
+    p_table[word++] = (standard_entry(p_controller, range.lower) << 16) |
+                      standard_entry(p_controller, range.upper);
+  }
+
+  // Extended identifiers
+  layout.extended_start = word * sizeof(std::uint32_t);
+  auto const extended_first = word;
+  for (auto const& filter : p_settings.extended_identifiers) {
+    if (filter && *filter <= extended_id_mask) {
+      p_table[word++] = extended_entry(p_controller, *filter);
+    }
+  }
+  auto extended = p_table.subspan(extended_first, word - extended_first);
+  std::ranges::sort(extended);
+  word = extended_first + static_cast<std::size_t>(
+                            std::ranges::unique(extended).begin() -
+                            extended.begin());
+
+  // Extended ranges, including mask filters split into ranges
+  layout.extended_group_start = word * sizeof(std::uint32_t);
+  range_list<can_filter_count * (1 + extended_mask_ranges)> extended_ranges;
+  for (auto const& filter : p_settings.extended_ranges) {
+    if (auto const range = filter ? to_range(*filter, extended_id_mask)
+                                  : std::nullopt) {
+      extended_ranges.push(range->lower, range->upper);
+    }
+  }
+  for (auto const& filter : p_settings.extended_masks) {
+    if (filter &&
+        not never_matches(filter->id, filter->mask, extended_id_mask)) {
+      layout.exact &= split_mask(filter->id,
+                                 filter->mask,
+                                 extended_id_mask,
+                                 extended_mask_ranges,
+                                 extended_ranges);
+    }
+  }
+  for (auto const& range : extended_ranges.merge()) {
+    p_table[word++] = extended_entry(p_controller, range.lower);
+    p_table[word++] = extended_entry(p_controller, range.upper);
+  }
+
+  layout.end = word * sizeof(std::uint32_t);
+  return layout;
+}
+
+bool acceptance_filter_accepts(std::span<std::uint32_t const> p_table,
+                               acceptance_filter_layout const& p_layout,
+                               std::uint8_t p_controller,
+                               hal::can_message const& p_message)
+{
+  auto const section = [&p_table](std::uint32_t p_start, std::uint32_t p_end) {
+    return p_table.subspan(p_start / sizeof(std::uint32_t),
+                           (p_end - p_start) / sizeof(std::uint32_t));
+  };
+
+  if (not p_message.extended) {
+    if (p_message.id > standard_id_mask) {
+      return false;
+    }
+    auto const key = standard_entry(p_controller, p_message.id);
+    for (auto const word : section(0, p_layout.standard_group_start)) {
+      if (standard_entry_matches(word >> 16, key) ||
+          standard_entry_matches(word & 0xFFFF, key)) {
+        return true;
+      }
+    }
+    for (auto const word :
+         section(p_layout.standard_group_start, p_layout.extended_start)) {
+      auto const lower = word >> 16;
+      auto const upper = word & 0xFFFF;
+      if ((lower & standard_disable) == 0 && lower <= key && key <= upper) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  auto const key = extended_entry(p_controller, p_message.id);
+  for (auto const word :
+       section(p_layout.extended_start, p_layout.extended_group_start)) {
+    if (word == key) {
+      return true;
+    }
+  }
+  auto const groups = section(p_layout.extended_group_start, p_layout.end);
+  for (std::size_t i = 0; i + 1 < groups.size(); i += 2) {
+    if (groups[i] <= key && key <= groups[i + 1]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool filters_accept(can_filter_settings const& p_settings,
+                    hal::can_message const& p_message)
+{
+  auto const id = p_message.id;
+  auto const in_range = [id](auto const& p_filter) {
+    return p_filter &&
+           std::min<hal::u32>(p_filter->id_1, p_filter->id_2) <= id &&
+           id <= std::max<hal::u32>(p_filter->id_1, p_filter->id_2);
+  };
+  auto const mask_matches = [id](auto const& p_filter) {
+    return p_filter && ((id ^ p_filter->id) & p_filter->mask) == 0;
+  };
+  auto const equals = [id](auto const& p_filter) {
+    return p_filter && *p_filter == id;
+  };
+
+  if (p_message.extended) {
+    return std::ranges::any_of(p_settings.extended_identifiers, equals) ||
+           std::ranges::any_of(p_settings.extended_masks, mask_matches) ||
+           std::ranges::any_of(p_settings.extended_ranges, in_range);
+  }
+  return std::ranges::any_of(p_settings.identifiers, equals) ||
+         std::ranges::any_of(p_settings.masks, mask_matches) ||
+         std::ranges::any_of(p_settings.ranges, in_range);
+}
+}  // namespace hal::micromod::lpc40
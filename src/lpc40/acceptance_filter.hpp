@@ -0,0 +1,139 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include <libhal/can.hpp>
+#include <libhal/units.hpp>
+
+/**
+ * @brief Model of the LPC40xx CAN acceptance filter look up table
+ *
+ * This is plain C++ with no register access, so the table built for a set of
+ * filters can be checked on a development machine. The driver copies the
+ * table into the acceptance filter RAM and the section offsets into the
+ * SFF_sa, SFF_GRP_sa, EFF_sa, EFF_GRP_sa & ENDofTable registers.
+ *
+ * The table has no FullCAN section and is laid out as UM10562 requires, each
+ * section sorted in ascending order:
+ *
+ * - standard identifiers, two 16-bit entries per word
+ * - standard identifier ranges, one word per range
+ * - extended identifiers, one word each
+ * - extended identifier ranges, two words per range
+ *
+ * The hardware has no mask filters. A mask filter is split into the ranges of
+ * identifiers it accepts. If that takes more than a handful of ranges, the
+ * mask is widened until it fits, and the table then accepts more than the
+ * filters do, which the layout's `exact` flag reports so the driver can check
+ * messages in software.
+ */
+namespace hal::micromod::lpc40 {
+/// Number of filters of each kind provided by the board
+constexpr std::size_t can_filter_count = 8;
+
+/**
+ * @brief Settings of every filter, std::nullopt for disabled filters
+ */
+struct can_filter_settings
+{
+  std::array<std::optional<hal::u16>, can_filter_count> identifiers{};
+  std::array<std::optional<hal::can_mask_filter::pair>, can_filter_count>
+    masks{};
+  std::array<std::optional<hal::can_range_filter::pair>, can_filter_count>
+    ranges{};
+  std::array<std::optional<hal::u32>, can_filter_count> extended_identifiers{};
+  std::array<std::optional<hal::can_extended_mask_filter::pair>,
+             can_filter_count>
+    extended_masks{};
+  std::array<std::optional<hal::can_extended_range_filter::pair>,
+             can_filter_count>
+    extended_ranges{};
+};
+
+/// Most ranges a standard mask filter is split into
+constexpr std::size_t standard_mask_ranges = 16;
+/// Most ranges an extended mask filter is split into
+constexpr std::size_t extended_mask_ranges = 8;
+
+/// Words needed for the largest possible table
+constexpr std::size_t acceptance_filter_words =
+  (can_filter_count + 1) / 2 +
+  can_filter_count * (1 + standard_mask_ranges) + can_filter_count +
+  2 * can_filter_count * (1 + extended_mask_ranges);
+
+/// Size of the acceptance filter RAM in words
+constexpr std::size_t acceptance_filter_ram_words = 512;
+static_assert(acceptance_filter_words <= acceptance_filter_ram_words);
+
+/**
+ * @brief Byte offsets of the sections of a table
+ *
+ * The standard identifier section always starts at 0.
+ */
+struct acceptance_filter_layout
+{
+  std::uint32_t standard_group_start = 0;
+  std::uint32_t extended_start = 0;
+  std::uint32_t extended_group_start = 0;
+  std::uint32_t end = 0;
+  /// false if the table accepts messages the filters do not
+  bool exact = true;
+};
+
+/**
+ * @brief Build the look up table for a set of filters
+ *
+ * @param p_settings - filters to program
+ * @param p_controller - CAN controller the entries apply to, 0 for CAN1 and 1
+ * for CAN2.
+ * @param p_table - receives the table
+ * @return acceptance_filter_layout - offsets of the sections in p_table
+ */
+acceptance_filter_layout build_acceptance_filter(
+  can_filter_settings const& p_settings,
+  std::uint8_t p_controller,
+  std::span<std::uint32_t, acceptance_filter_words> p_table);
+
+/**
+ * @brief Look a message up in a table the way the hardware does
+ *
+ * @param p_table - table built by build_acceptance_filter()
+ * @param p_layout - layout returned by build_acceptance_filter()
+ * @param p_controller - CAN controller the message was received on
+ * @param p_message - received message
+ * @return true - the hardware would accept the message
+ */
+[[nodiscard]] bool acceptance_filter_accepts(
+  std::span<std::uint32_t const> p_table,
+  acceptance_filter_layout const& p_layout,
+  std::uint8_t p_controller,
+  hal::can_message const& p_message);
+
+/**
+ * @brief Determine if any filter accepts a message
+ *
+ * @param p_settings - filters
+ * @param p_message - received message
+ * @return true - at least one enabled filter accepts the message
+ */
+[[nodiscard]] bool filters_accept(can_filter_settings const& p_settings,
+                                  hal::can_message const& p_message);
+}  // namespace hal::micromod::lpc40
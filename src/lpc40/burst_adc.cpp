@@ -0,0 +1,146 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "burst_adc.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include <libhal-arm-mcu/interrupt.hpp>
+#include <libhal-arm-mcu/lpc40/interrupt.hpp>
+
+#include "registers.hpp"
+
+namespace hal::micromod::lpc40 {
+namespace {
+constexpr hal::cortex_m::irq_t adc_irq = 22;
+/// ADC clock, the rate hal::lpc40::adc also runs the ADC at
+constexpr hal::hertz adc_clock = 1'000'000.0f;
+/// ADC clock cycles per conversion
+constexpr float conversion_cycles = 31.0f;
+
+struct analog_pin
+{
+  std::uint8_t port;
+  std::uint8_t pin;
+  std::uint8_t function;
+  std::uint8_t adc_channel;
+};
+
+/// Pins of the inputs, in analog_channel order
+constexpr std::array<analog_pin, analog_channels> analog_pins{ {
+  { .port = 1, .pin = 31, .function = 3, .adc_channel = 5 },
+  { .port = 1, .pin = 30, .function = 3, .adc_channel = 4 },
+  { .port = 0, .pin = 25, .function = 1, .adc_channel = 2 },
+} };
+
+/// Bursts convert the selected channels lowest first, A0's is the highest
+constexpr std::uint8_t last_channel = 5;
+
+burst_adc* active_driver = nullptr;
+
+void adc_handler()
+{
+  if (active_driver != nullptr) {
+    active_driver->handle_interrupt();
+  }
+}
+
+std::uint32_t channel_selection()
+{
+  std::uint32_t selection = 0;
+  for (auto const& pin : analog_pins) {
+    selection |= 1U << pin.adc_channel;
+  }
+  return selection;
+}
+
+/// Divider of the peripheral clock giving an ADC clock of at most adc_clock
+std::uint32_t adc_clock_divider(hal::hertz p_cpu_frequency)
+{
+  auto const peripheral_frequency =
+    p_cpu_frequency * static_cast<float>(cpu_clock_divider()) /
+    static_cast<float>(peripheral_clock_divider());
+  auto const divider =
+    static_cast<std::uint32_t>(std::ceil(peripheral_frequency / adc_clock));
+  return std::clamp<std::uint32_t>(divider, 1, 256);
+}
+
+hal::hertz burst_frame_rate(hal::hertz p_cpu_frequency)
+{
+  auto const peripheral_frequency =
+    p_cpu_frequency * static_cast<float>(cpu_clock_divider()) /
+    static_cast<float>(peripheral_clock_divider());
+  auto const divider = static_cast<float>(adc_clock_divider(p_cpu_frequency));
+  return peripheral_frequency / divider /
+         (conversion_cycles * static_cast<float>(analog_channels));
+}
+}  // namespace
+
+burst_adc::burst_adc(hal::hertz p_cpu_frequency, std::span<hal::u16> p_buffer)
+  : analog_stream(p_buffer, burst_frame_rate(p_cpu_frequency))
+{
+  *system_control::pconp = *system_control::pconp | pconp_bits::adc;
+
+  for (auto const& pin : analog_pins) {
+    // Analog mode without pull resistors is every other IOCON bit cleared
+    *iocon(pin.port, pin.pin) = pin.function;
+  }
+
+  // Interrupt on the last conversion of each burst only, not on every one
+  adc->inten = 1U << last_channel;
+  adc->cr = channel_selection() |
+            adc_bits::clock_divider(adc_clock_divider(p_cpu_frequency)) |
+            adc_bits::burst | adc_bits::power_on;
+
+  active_driver = this;
+  hal::lpc40::initialize_interrupts();
+  hal::cortex_m::enable_interrupt(adc_irq, adc_handler);
+}
+
+burst_adc::~burst_adc()
+{
+  hal::cortex_m::disable_interrupt(adc_irq);
+  adc->cr = 0;
+  adc->inten = 0;
+  *system_control::pconp = *system_control::pconp & ~pconp_bits::adc;
+  active_driver = nullptr;
+}
+
+void burst_adc::handle_interrupt()
+{
+  auto const samples = buffer();
+  auto const frames = samples.size() / analog_channels;
+  auto const frame = m_frame.load(std::memory_order_relaxed);
+
+  // Reading A0's result, the last channel's, clears the interrupt
+  for (std::size_t i = 0; i < analog_channels; i++) {
+    samples[(frame * analog_channels) + i] = static_cast<hal::u16>(
+      adc_bits::result(adc->dr[analog_pins[i].adc_channel]));
+  }
+
+  auto const next = (frame + 1) % frames;
+  m_frame.store(next, std::memory_order_release);
+  if (next % (frames / 2) == 0) {
+    block_complete(next == 0 ? 1 : 0);
+  }
+}
+
+std::size_t burst_adc::written()
+{
+  return m_frame.load(std::memory_order_acquire) * analog_channels;
+}
+}  // namespace hal::micromod::lpc40
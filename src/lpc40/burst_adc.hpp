@@ -0,0 +1,66 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <atomic>
+#include <span>
+
+#include <libhal-micromod/analog_stream.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::micromod::lpc40 {
+/**
+ * @brief ADC converting every MicroMod analog input in burst mode, with its
+ * interrupt copying each frame into the stream's double buffer
+ *
+ * Burst mode converts the inputs one after the other without pause, each
+ * conversion taking 31 cycles of a 1MHz ADC clock, so frames come at a fixed
+ * rate set by the ADC clock alone. The conversion of the last input raises an
+ * interrupt that copies the frame's results, one short interrupt per frame.
+ *
+ * A0 is P1.31 (ADC0_IN5), A1 is P1.30 (ADC0_IN4) & BATT_VIN/3 is P0.25
+ * (ADC0_IN2). The board's adc drivers, concrete or not, read these inputs from
+ * the stream, as a hal::lpc40::adc would reprogram the ADC under it.
+ *
+ * Only one instance of this driver may exist as it owns the ADC interrupt.
+ */
+class burst_adc final : public hal::micromod::analog_stream
+{
+public:
+  /**
+   * @brief Construct a new burst adc object & start converting
+   *
+   * @param p_cpu_frequency - frequency of the cpu
+   * @param p_buffer - two blocks of whole frames, must outlive the driver
+   */
+  burst_adc(hal::hertz p_cpu_frequency, std::span<hal::u16> p_buffer);
+
+  burst_adc(burst_adc const&) = delete;
+  burst_adc& operator=(burst_adc const&) = delete;
+  burst_adc(burst_adc&&) = delete;
+  burst_adc& operator=(burst_adc&&) = delete;
+  ~burst_adc() override;
+
+  /// Called from the ADC interrupt service routine
+  void handle_interrupt();
+
+private:
+  std::size_t written() override;
+
+  /// Frame the next interrupt writes, from the start of the buffer
+  std::atomic<std::size_t> m_frame = 0;
+};
+}  // namespace hal::micromod::lpc40
@@ -0,0 +1,405 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "can.hpp"
+
+#include <algorithm>
+#include <optional>
+
+#include <libhal-arm-mcu/interrupt.hpp>
+#include <libhal-arm-mcu/lpc40/clock.hpp>
+#include <libhal-arm-mcu/lpc40/interrupt.hpp>
+#include <libhal/error.hpp>
+
+#include "registers.hpp"
+
+namespace hal::micromod::lpc40 {
+namespace {
+constexpr hal::cortex_m::irq_t can_irq = 25;
+/// Acceptance filter entries for CAN2 carry a source CAN channel of 1
+constexpr std::uint8_t can2_channel = 1;
+constexpr std::uint8_t rd2_port = 2;
+constexpr std::uint8_t rd2_pin = 7;
+constexpr std::uint8_t td2_port = 2;
+constexpr std::uint8_t td2_pin = 8;
+constexpr std::uint32_t can2_function = 1;
+constexpr std::uint32_t maximum_prescaler = 1024;
+
+can_controller* active_driver = nullptr;
+
+void can_handler()
+{
+  if (active_driver != nullptr) {
+    active_driver->handle_interrupt();
+  }
+}
+
+/// Keeps the CAN interrupt from running while state it reads is changed
+class can_interrupt_pause
+{
+public:
+  can_interrupt_pause()
+  {
+    hal::cortex_m::disable_interrupt(can_irq);
+  }
+
+  can_interrupt_pause(can_interrupt_pause const&) = delete;
+  can_interrupt_pause& operator=(can_interrupt_pause const&) = delete;
+  can_interrupt_pause(can_interrupt_pause&&) = delete;
+  can_interrupt_pause& operator=(can_interrupt_pause&&) = delete;
+
+  ~can_interrupt_pause()
+  {
+    hal::cortex_m::enable_interrupt(can_irq, can_handler);
+  }
+};
+
+std::uint32_t peripheral_frequency()
+{
+  auto const cpu_frequency =
+    hal::lpc40::get_frequency(hal::lpc40::peripheral::cpu);
+  return static_cast<std::uint32_t>(
+    cpu_frequency * static_cast<float>(cpu_clock_divider()) /
+    static_cast<float>(peripheral_clock_divider()));
+}
+
+/**
+ * @brief Find the BTR value for a baud rate
+ *
+ * Picks the number of time quanta per bit whose sample point is closest to
+ * 87.5%, among those that divide the peripheral clock exactly.
+ *
+ * @return std::optional<std::uint32_t> - BTR value, std::nullopt if the baud
+ * rate cannot be reached exactly
+ */
+std::optional<std::uint32_t> bit_timing(std::uint32_t p_peripheral_frequency,
+                                        std::uint32_t p_baud_rate)
+{
+  constexpr std::uint32_t target_sample_point = 875;
+  std::optional<std::uint32_t> best;
+  std::uint32_t best_error = 1000;
+
+  if (p_baud_rate == 0) {
+    return std::nullopt;
+  }
+
+  // Synchronization segment + segment 1 (1 to 16) + segment 2 (1 to 8)
+  for (std::uint32_t quanta = 25; quanta >= 8; quanta--) {
+    auto const bit_clocks = p_baud_rate * quanta;
+    if (p_peripheral_frequency % bit_clocks != 0) {
+      continue;
+    }
+    auto const prescaler = p_peripheral_frequency / bit_clocks;
+    if (prescaler == 0 || prescaler > maximum_prescaler) {
+      continue;
+    }
+    auto const sampled = (quanta * target_sample_point + 500) / 1000;
+    // Segment 1 cannot be longer than 16 quanta
+    auto const shortest_segment2 = quanta > 17 ? quanta - 17 : 1;
+    auto const segment2 =
+      std::clamp<std::uint32_t>(quanta - sampled, shortest_segment2, 8);
+    auto const segment1 = quanta - 1 - segment2;
+    auto const sample_point = ((1 + segment1) * 1000) / quanta;
+    auto const error = sample_point > target_sample_point
+                         ? sample_point - target_sample_point
+                         : target_sample_point - sample_point;
+    if (error < best_error) {
+      best_error = error;
+      best = can_bits::bit_timing(
+        prescaler, std::min<std::uint32_t>(4, segment2), segment1, segment2);
+    }
+  }
+
+  return best;
+}
+
+void select_function(std::uint8_t p_port, std::uint8_t p_pin)
+{
+  auto* pin = iocon(p_port, p_pin);
+  *pin = (*pin & ~iocon_function_mask) | can2_function;
+}
+}  // namespace
+
+can_controller::can_controller(hal::u32 p_baud_rate,
+                               hal::steady_clock& p_clock)
+  : m_clock(&p_clock)
+{
+  auto const timing = bit_timing(peripheral_frequency(), p_baud_rate);
+  if (not timing) {
+    hal::safe_throw(hal::operation_not_supported(this));
+  }
+  m_baud_rate = p_baud_rate;
+
+  *system_control::pconp = *system_control::pconp | pconp_bits::can2;
+  select_function(rd2_port, rd2_pin);
+  select_function(td2_port, td2_pin);
+
+  can2->mod = can_bits::reset_mode;
+  can2->ier = 0;
+  can2->btr = *timing;
+  can_acceptance_filter->afmr = afmr_bits::acceptance_bypass;
+  can2->mod = 0;
+
+  active_driver = this;
+  hal::lpc40::initialize_interrupts();
+  hal::cortex_m::enable_interrupt(can_irq, can_handler);
+  can2->ier = can_bits::receive_interrupt | can_bits::transmit1_interrupt |
+              can_bits::error_warning_interrupt |
+              can_bits::data_overrun_interrupt;
+}
+
+can_controller::~can_controller()
+{
+  hal::cortex_m::disable_interrupt(can_irq);
+  can2->ier = 0;
+  can2->mod = can_bits::reset_mode;
+  *system_control::pconp = *system_control::pconp & ~pconp_bits::can2;
+  active_driver = nullptr;
+}
+
+void can_controller::baud_rate(hal::u32 p_baud_rate)
+{
+  auto const timing = bit_timing(peripheral_frequency(), p_baud_rate);
+  if (not timing) {
+    hal::safe_throw(hal::operation_not_supported(this));
+  }
+  m_baud_rate = p_baud_rate;
+
+  // BTR can only be written in reset mode
+  can2->mod = can_bits::reset_mode;
+  can2->btr = *timing;
+  can2->mod = 0;
+}
+
+hal::u32 can_controller::baud_rate() const
+{
+  return m_baud_rate;
+}
+
+void can_controller::send(hal::can_message const& p_message)
+{
+  while ((can2->sr & can_bits::transmit_buffer1_status) == 0) {
+    if (can2->gsr & can_bits::bus_status) {
+      hal::safe_throw(hal::io_error(this));
+    }
+  }
+
+  auto const length = std::min<std::uint32_t>(p_message.length, 8);
+  auto const& payload = p_message.payload;
+  auto& buffer = can2->transmit[0];
+  buffer.frame_info = can_bits::frame_info(
+    length, p_message.remote_request, p_message.extended);
+  buffer.id = p_message.id;
+  buffer.data_a = payload[0] | (payload[1] << 8) | (payload[2] << 16) |
+                  (static_cast<std::uint32_t>(payload[3]) << 24);
+  buffer.data_b = payload[4] | (payload[5] << 8) | (payload[6] << 16) |
+                  (static_cast<std::uint32_t>(payload[7]) << 24);
+  can2->cmr =
+    can_bits::transmission_request | can_bits::select_transmit_buffer1;
+}
+
+void can_controller::receive_buffer(std::span<hal::can_message> p_buffer)
+{
+  can_interrupt_pause pause;
+  m_receive_buffer = p_buffer;
+  m_cursor = 0;
+}
+
+std::span<hal::can_message const> can_controller::receive_buffer() const
+{
+  return m_receive_buffer;
+}
+
+std::size_t can_controller::receive_cursor() const
+{
+  return m_cursor;
+}
+
+void can_controller::filter_mode(hal::can_bus_manager::accept p_accept)
+{
+  can_interrupt_pause pause;
+  m_accept = p_accept;
+  program_acceptance_filter();
+}
+
+void can_controller::update_filters(
+  hal::callback<void(can_filter_settings&)> p_change)
+{
+  can_interrupt_pause pause;
+  p_change(m_filters);
+  program_acceptance_filter();
+}
+
+void can_controller::program_acceptance_filter()
+{
+  if (m_accept == hal::can_bus_manager::accept::all) {
+    can_acceptance_filter->afmr = afmr_bits::acceptance_bypass;
+    return;
+  }
+
+  m_layout = build_acceptance_filter(m_filters, can2_channel, m_table);
+
+  // The look up table can only be written while the filter is off, which
+  // drops the messages received meanwhile.
+  can_acceptance_filter->afmr = afmr_bits::acceptance_off;
+  auto const words = m_layout.end / sizeof(std::uint32_t);
+  for (std::size_t i = 0; i < words; i++) {
+    can_acceptance_filter_ram[i] = m_table[i];
+  }
+  // No FullCAN section, the standard identifiers start the table
+  can_acceptance_filter->standard_start = 0;
+  can_acceptance_filter->standard_group_start = m_layout.standard_group_start;
+  can_acceptance_filter->extended_start = m_layout.extended_start;
+  can_acceptance_filter->extended_group_start = m_layout.extended_group_start;
+  can_acceptance_filter->end_of_table = m_layout.end;
+  can_acceptance_filter->afmr = 0;
+}
+
+void can_controller::on_receive(
+  hal::can_interrupt::optional_receive_handler const& p_handler)
+{
+  can_interrupt_pause pause;
+  m_receive_handler = p_handler;
+}
+
+void can_controller::on_bus_off(
+  hal::can_bus_manager::optional_bus_off_handler& p_handler)
+{
+  can_interrupt_pause pause;
+  m_bus_off_handler = p_handler;
+}
+
+void can_controller::on_transmit(
+  optional_can_transmit_handler const& p_handler)
+{
+  can_interrupt_pause pause;
+  m_transmit_handler = p_handler;
+}
+
+void can_controller::bus_on()
+{
+  // The controller enters reset mode when it goes bus off, leaving it starts
+  // the bus off recovery sequence.
+  can2->mod = 0;
+}
+
+void can_controller::handle_interrupt()
+{
+  // Reading ICR clears every flag except the receive interrupt, which is
+  // cleared by releasing the receive buffer.
+  auto const flags = can2->icr;
+
+  if (flags & can_bits::receive_interrupt) {
+    receive();
+  }
+
+  if (flags & can_bits::transmit1_interrupt) {
+    transmitted();
+  }
+
+  if (flags & can_bits::data_overrun_interrupt) {
+    m_traffic.receive_overflow();
+    can2->cmr = can_bits::clear_data_overrun;
+  }
+
+  if ((flags & can_bits::error_warning_interrupt) &&
+      (can2->gsr & can_bits::bus_status)) {
+    m_traffic.bus_off();
+    if (m_bus_off_handler) {
+      (*m_bus_off_handler)(hal::can_bus_manager::bus_off_tag{});
+    }
+  }
+}
+
+void can_controller::transmitted()
+{
+  auto const now = m_clock->uptime();
+  // Also raised when a transmission is aborted, which is not counted
+  if ((can2->gsr & can_bits::transmit_complete_status) == 0) {
+    return;
+  }
+  auto const& buffer = can2->transmit[0];
+  auto const frame_info = buffer.frame_info;
+  hal::can_message message{
+    .id = buffer.id,
+    .length = static_cast<hal::u8>(
+      std::min<std::uint32_t>(can_bits::data_length(frame_info), 8)),
+    .payload = {},
+    .remote_request = (frame_info & can_bits::remote_request) != 0,
+    .extended = (frame_info & can_bits::extended_frame) != 0,
+  };
+  m_traffic.transmitted(message);
+
+  if (m_transmit_handler) {
+    auto const data_a = buffer.data_a;
+    auto const data_b = buffer.data_b;
+    for (std::size_t i = 0; i < 4; i++) {
+      message.payload[i] = static_cast<hal::byte>(data_a >> (8 * i));
+      message.payload[i + 4] = static_cast<hal::byte>(data_b >> (8 * i));
+    }
+    (*m_transmit_handler)(message, now);
+  }
+}
+
+hal::micromod::can_bus_statistics can_controller::statistics() const
+{
+  hal::micromod::can_bus_statistics statistics{};
+  m_traffic.read(statistics);
+  auto const status = can2->gsr;
+  statistics.baud_rate = m_baud_rate;
+  statistics.transmit_errors =
+    static_cast<hal::u8>(can_bits::transmit_error_count(status));
+  statistics.receive_errors =
+    static_cast<hal::u8>(can_bits::receive_error_count(status));
+  return statistics;
+}
+
+void can_controller::receive()
+{
+  while (can2->gsr & can_bits::receive_buffer_status) {
+    auto const status = can2->receive_frame_status;
+    auto const data_a = can2->receive_data_a;
+    auto const data_b = can2->receive_data_b;
+    hal::can_message message{
+      .id = can2->receive_id,
+      .length = static_cast<hal::u8>(
+        std::min<std::uint32_t>(can_bits::data_length(status), 8)),
+      .payload = {},
+      .remote_request = (status & can_bits::remote_request) != 0,
+      .extended = (status & can_bits::extended_frame) != 0,
+    };
+    for (std::size_t i = 0; i < 4; i++) {
+      message.payload[i] = static_cast<hal::byte>(data_a >> (8 * i));
+      message.payload[i + 4] = static_cast<hal::byte>(data_b >> (8 * i));
+    }
+    can2->cmr = can_bits::release_receive_buffer;
+    m_traffic.received(message);
+
+    // A widened mask filter lets through messages the filters reject
+    if (m_accept == hal::can_bus_manager::accept::none &&
+        not m_layout.exact && not filters_accept(m_filters, message)) {
+      continue;
+    }
+
+    if (not m_receive_buffer.empty()) {
+      m_receive_buffer[m_cursor] = message;
+      m_cursor = (m_cursor + 1) % m_receive_buffer.size();
+    }
+
+    if (m_receive_handler) {
+      (*m_receive_handler)(hal::can_interrupt::on_receive_tag{}, message);
+    }
+  }
+}
+}  // namespace hal::micromod::lpc40
@@ -0,0 +1,150 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include <libhal-micromod/can_statistics.hpp>
+#include <libhal-micromod/can_timestamp.hpp>
+#include <libhal/can.hpp>
+#include <libhal/functional.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include "acceptance_filter.hpp"
+
+namespace hal::micromod::lpc40 {
+/**
+ * @brief CAN2 controller with its filters in the acceptance filter RAM
+ *
+ * Backs the board's transceiver, bus manager, interrupt & filter accessors.
+ * Messages rejected by the filters are dropped by the acceptance filter before
+ * they reach the receive buffer, so they never cost an interrupt. Only when a
+ * mask filter had to be widened to fit the table (see build_acceptance_filter)
+ * are the messages it lets through checked again in the interrupt.
+ *
+ * Uses RD2 on P2.7 & TD2 on P2.8, and owns the acceptance filter, which is
+ * shared by CAN1 & CAN2. Only one instance of this driver may exist, and it
+ * may not be used alongside the deprecated hal::can driver of the board.
+ */
+class can_controller
+{
+public:
+  /**
+   * @brief Construct a new can controller object & go bus on
+   *
+   * Accepts every message until filter_mode() is called.
+   *
+   * @param p_baud_rate - bus baud rate
+   * @param p_clock - uptime clock, timestamps the messages sent
+   * @throws hal::operation_not_supported - if the baud rate cannot be reached
+   * exactly from the peripheral clock.
+   */
+  can_controller(hal::u32 p_baud_rate, hal::steady_clock& p_clock);
+
+  can_controller(can_controller const&) = delete;
+  can_controller& operator=(can_controller const&) = delete;
+  can_controller(can_controller&&) = delete;
+  can_controller& operator=(can_controller&&) = delete;
+  ~can_controller();
+
+  /**
+   * @brief Change the baud rate, resets the controller
+   *
+   * @param p_baud_rate - bus baud rate
+   * @throws hal::operation_not_supported - if the baud rate cannot be reached
+   * exactly from the peripheral clock.
+   */
+  void baud_rate(hal::u32 p_baud_rate);
+  [[nodiscard]] hal::u32 baud_rate() const;
+
+  /**
+   * @brief Send a message, waiting for the transmit buffer to be free
+   *
+   * @param p_message - message to send
+   * @throws hal::io_error - if the controller is bus off
+   */
+  void send(hal::can_message const& p_message);
+
+  /**
+   * @brief Set the circular buffer received messages are written to
+   *
+   * @param p_buffer - buffer, may be empty
+   */
+  void receive_buffer(std::span<hal::can_message> p_buffer);
+  [[nodiscard]] std::span<hal::can_message const> receive_buffer() const;
+  /// Index of the next receive buffer entry to be written
+  [[nodiscard]] std::size_t receive_cursor() const;
+
+  /**
+   * @brief Accept all messages or only those the filters accept
+   *
+   * @param p_accept - all to bypass the filters, none to apply them
+   */
+  void filter_mode(hal::can_bus_manager::accept p_accept);
+
+  /**
+   * @brief Change the filter settings & program the acceptance filter
+   *
+   * The CAN interrupt is disabled while the settings change, as it reads them
+   * when a mask filter had to be widened.
+   *
+   * @param p_change - called with the settings to change
+   */
+  void update_filters(hal::callback<void(can_filter_settings&)> p_change);
+
+  void on_receive(
+    hal::can_interrupt::optional_receive_handler const& p_handler);
+  void on_bus_off(hal::can_bus_manager::optional_bus_off_handler& p_handler);
+  /// The handler gets the uptime when the transmit interrupt ran, as the
+  /// controller has no timestamp capture
+  void on_transmit(optional_can_transmit_handler const& p_handler);
+
+  /// Leave the bus off state, once 128 x 11 recessive bits have been seen
+  void bus_on();
+
+  /**
+   * @brief Read the traffic & error counters
+   *
+   * @return hal::micromod::can_bus_statistics - counters since construction,
+   * without a timestamp
+   */
+  [[nodiscard]] hal::micromod::can_bus_statistics statistics() const;
+
+  /// Called from the CAN interrupt service routine
+  void handle_interrupt();
+
+private:
+  void program_acceptance_filter();
+  void receive();
+  void transmitted();
+
+  std::span<hal::can_message> m_receive_buffer;
+  std::size_t m_cursor = 0;
+  hal::u32 m_baud_rate = 0;
+  hal::can_bus_manager::accept m_accept = hal::can_bus_manager::accept::all;
+  hal::can_interrupt::optional_receive_handler m_receive_handler;
+  hal::can_bus_manager::optional_bus_off_handler m_bus_off_handler;
+  optional_can_transmit_handler m_transmit_handler;
+  hal::steady_clock* m_clock;
+  can_filter_settings m_filters{};
+  acceptance_filter_layout m_layout{};
+  hal::micromod::can_traffic_counter m_traffic;
+  /// Table is built here then copied to the acceptance filter RAM
+  std::array<std::uint32_t, acceptance_filter_words> m_table{};
+};
+}  // namespace hal::micromod::lpc40
@@ -0,0 +1,64 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dma.hpp"
+
+#include <array>
+
+#include <libhal-arm-mcu/interrupt.hpp>
+#include <libhal-arm-mcu/lpc40/interrupt.hpp>
+
+#include "registers.hpp"
+
+namespace hal::micromod::lpc40 {
+namespace {
+constexpr hal::cortex_m::irq_t gpdma_irq = 26;
+
+std::array<hal::callback<void(void)>, dma_channel_count> handlers{};
+bool initialized = false;
+
+void gpdma_handler()
+{
+  auto const status = gpdma->int_stat;
+  gpdma->int_tc_clear = status;
+  gpdma->int_err_clear = status;
+  for (std::uint8_t i = 0; i < dma_channel_count; i++) {
+    if ((status & (1U << i)) && handlers[i]) {
+      handlers[i]();
+    }
+  }
+}
+}  // namespace
+
+void initialize_dma()
+{
+  if (initialized) {
+    return;
+  }
+  initialized = true;
+  *system_control::pconp = *system_control::pconp | pconp_bits::gpdma;
+  gpdma->int_tc_clear = 0xFF;
+  gpdma->int_err_clear = 0xFF;
+  gpdma->config = gpdma_bits::enable;
+
+  hal::lpc40::initialize_interrupts();
+  hal::cortex_m::enable_interrupt(gpdma_irq, gpdma_handler);
+}
+
+void on_dma_interrupt(std::uint8_t p_channel,
+                      hal::callback<void(void)> p_handler)
+{
+  handlers[p_channel] = p_handler;
+}
+}  // namespace hal::micromod::lpc40
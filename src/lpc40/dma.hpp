@@ -0,0 +1,44 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include <libhal/functional.hpp>
+
+namespace hal::micromod::lpc40 {
+/// Number of GPDMA channels
+constexpr std::uint8_t dma_channel_count = 8;
+
+/**
+ * @brief Power on & enable the GPDMA controller and its interrupt
+ *
+ * Safe to call more than once.
+ */
+void initialize_dma();
+
+/**
+ * @brief Set the handler called when a GPDMA channel raises an interrupt
+ *
+ * The GPDMA controller has a single interrupt shared by all channels. It
+ * clears the channel's terminal count & error flags, then calls the handler of
+ * each channel that raised it.
+ *
+ * @param p_channel - channel number 0 to 7
+ * @param p_handler - called from the GPDMA interrupt service routine
+ */
+void on_dma_interrupt(std::uint8_t p_channel,
+                      hal::callback<void(void)> p_handler);
+}  // namespace hal::micromod::lpc40
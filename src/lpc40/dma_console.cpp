@@ -0,0 +1,88 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dma_console.hpp"
+
+#include <algorithm>
+
+#include "dma.hpp"
+#include "registers.hpp"
+
+namespace hal::micromod::lpc40 {
+namespace {
+gpdma_channel_reg_t& dma_channel()
+{
+  return gpdma->channel[dma_console::channel];
+}
+}  // namespace
+
+dma_console::dma_console(hal::serial& p_uart,
+                         std::span<hal::byte> p_buffer,
+                         overflow_policy p_policy)
+  : ring_console(p_uart, p_buffer, p_policy)
+{
+  initialize_dma();
+  dma_channel().config = 0;
+  // Select UART0 rather than UART3 for the request line
+  *system_control::dmareqsel =
+    *system_control::dmareqsel & ~(1U << dma_request::uart0_transmit);
+  serial_configured();
+  on_dma_interrupt(channel, [this]() { handle_interrupt(); });
+}
+
+dma_console::~dma_console()
+{
+  dma_channel().config = 0;
+  on_dma_interrupt(channel, {});
+}
+
+void dma_console::serial_configured()
+{
+  *uart0_fcr = uart_fcr_bits::fifo_enable | uart_fcr_bits::dma_mode;
+}
+
+void dma_console::start_transmit(std::span<hal::byte const> p_data)
+{
+  m_data = p_data;
+  m_sent = 0;
+  handle_interrupt();
+}
+
+void dma_console::handle_interrupt()
+{
+  dma_channel().config = 0;
+  if (m_sent == m_data.size()) {
+    transmit_complete();
+    return;
+  }
+
+  // A transfer is limited to 4095 bytes, so long runs take several
+  auto const remaining = m_data.subspan(m_sent);
+  auto const size = std::min<std::size_t>(remaining.size(),
+                                          gpdma_bits::maximum_transfer_size);
+  m_sent += size;
+
+  auto& channel_registers = dma_channel();
+  channel_registers.source = reinterpret_cast<std::uintptr_t>(remaining.data());
+  channel_registers.destination = reinterpret_cast<std::uintptr_t>(uart0_thr);
+  channel_registers.linked_list = 0;
+  channel_registers.control = static_cast<std::uint32_t>(size) |
+                              gpdma_bits::source_increment |
+                              gpdma_bits::terminal_count_interrupt;
+  channel_registers.config =
+    gpdma_bits::destination_peripheral(dma_request::uart0_transmit) |
+    gpdma_bits::memory_to_peripheral | gpdma_bits::error_interrupt_mask |
+    gpdma_bits::terminal_count_interrupt_mask | gpdma_bits::channel_enable;
+}
+}  // namespace hal::micromod::lpc40
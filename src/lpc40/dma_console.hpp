@@ -0,0 +1,70 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <span>
+
+#include <libhal/serial.hpp>
+#include <libhal/units.hpp>
+
+#include "../ring_console.hpp"
+
+namespace hal::micromod::lpc40 {
+/**
+ * @brief UART0 console that transmits from a ring buffer with DMA
+ *
+ * Reception is left to the wrapped libhal uart driver. Transmission is done by
+ * GPDMA channel 7, the lowest priority channel, paced by the UART0 transmit
+ * request. Each contiguous run of the ring is sent as one transfer, and the
+ * terminal count interrupt starts the next one.
+ *
+ * The UART's FIFO control register is write only, so enabling its DMA mode
+ * also sets the receive trigger level to 1 character.
+ *
+ * Only one instance of this driver may exist as it owns GPDMA channel 7.
+ */
+class dma_console final : public hal::micromod::ring_console
+{
+public:
+  /// GPDMA channel used to transmit
+  static constexpr std::uint8_t channel = 7;
+
+  /**
+   * @brief Construct a new dma console object
+   *
+   * @param p_uart - UART0 driver, used to receive & configure the port
+   * @param p_buffer - transmit ring storage
+   * @param p_policy - what write() does when the ring is full
+   */
+  dma_console(hal::serial& p_uart,
+              std::span<hal::byte> p_buffer,
+              overflow_policy p_policy);
+
+  dma_console(dma_console const&) = delete;
+  dma_console& operator=(dma_console const&) = delete;
+  dma_console(dma_console&&) = delete;
+  dma_console& operator=(dma_console&&) = delete;
+  ~dma_console() override;
+
+private:
+  void start_transmit(std::span<hal::byte const> p_data) override;
+  void serial_configured() override;
+  void handle_interrupt();
+
+  /// Bytes of the claim sent by transfers already started
+  std::size_t m_sent = 0;
+  std::span<hal::byte const> m_data{};
+};
+}  // namespace hal::micromod::lpc40
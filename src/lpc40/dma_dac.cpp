@@ -0,0 +1,136 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "dma_dac.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "dma.hpp"
+
+namespace hal::micromod::lpc40 {
+namespace {
+/// Fastest DAC update rate, with the BIAS bit clear
+constexpr hal::hertz maximum_sample_rate = 1'000'000.0f;
+
+/// Address as the GPDMA controller takes it
+std::uint32_t address(void const volatile* p_pointer)
+{
+  return static_cast<std::uint32_t>(
+    reinterpret_cast<std::uintptr_t>(p_pointer));
+}
+
+void connect_dac()
+{
+  *iocon(0, 26) = 0b010 | iocon_dac_enable;
+}
+
+hal::hertz peripheral_frequency(hal::hertz p_cpu_frequency)
+{
+  return p_cpu_frequency * static_cast<float>(cpu_clock_divider()) /
+         static_cast<float>(peripheral_clock_divider());
+}
+
+/// Peripheral clock cycles between samples, nearest to the requested rate
+std::uint32_t sample_count(hal::hertz p_cpu_frequency,
+                           hal::hertz p_sample_rate)
+{
+  auto const frequency = peripheral_frequency(p_cpu_frequency);
+  auto const fastest =
+    static_cast<std::uint32_t>(std::ceil(frequency / maximum_sample_rate));
+  auto const count =
+    static_cast<std::uint32_t>(std::lround(frequency / p_sample_rate));
+  return std::clamp<std::uint32_t>(count, std::max(fastest, 1U), 0xFFFF);
+}
+
+hal::hertz counter_sample_rate(hal::hertz p_cpu_frequency,
+                               hal::hertz p_sample_rate)
+{
+  return peripheral_frequency(p_cpu_frequency) /
+         static_cast<float>(sample_count(p_cpu_frequency, p_sample_rate));
+}
+}  // namespace
+
+direct_dac::direct_dac()
+{
+  connect_dac();
+}
+
+void direct_dac::driver_write(float p_percentage)
+{
+  auto const value = std::lround(std::clamp(p_percentage, 0.0f, 1.0f) *
+                                 static_cast<float>(dac_full_scale));
+  // The base class's name hides the register block's
+  lpc40::dac->dacr = static_cast<std::uint32_t>(value) & dac_bits::value_mask;
+}
+
+dma_dac::dma_dac(hal::hertz p_cpu_frequency,
+                 std::span<hal::u32> p_buffer,
+                 hal::hertz p_sample_rate)
+  : dac_stream(p_buffer,
+               counter_sample_rate(p_cpu_frequency, p_sample_rate),
+               dac_bits::value_mask)
+{
+  connect_dac();
+  auto const samples = buffer();
+  std::ranges::fill(samples, dac->dacr & dac_bits::value_mask);
+
+  auto const size = block_samples();
+  auto const control = static_cast<std::uint32_t>(size) |
+                       gpdma_bits::source_width_word |
+                       gpdma_bits::destination_width_word |
+                       gpdma_bits::source_increment |
+                       gpdma_bits::terminal_count_interrupt;
+  for (std::size_t i = 0; i < m_blocks.size(); i++) {
+    m_blocks[i] = {
+      .source = address(&samples[i * size]),
+      .destination = address(&dac->dacr),
+      .linked_list = address(&m_blocks[(i + 1) % m_blocks.size()]),
+      .control = control,
+    };
+  }
+
+  initialize_dma();
+  on_dma_interrupt(channel, [this]() { handle_interrupt(); });
+  // Select the DAC rather than the reserved alternate for the request line
+  *system_control::dmareqsel =
+    *system_control::dmareqsel & ~(1U << dma_request::dac);
+  auto& channel_registers = gpdma->channel[channel];
+  channel_registers.source = m_blocks[0].source;
+  channel_registers.destination = m_blocks[0].destination;
+  channel_registers.linked_list = m_blocks[0].linked_list;
+  channel_registers.control = m_blocks[0].control;
+  channel_registers.config =
+    gpdma_bits::destination_peripheral(dma_request::dac) |
+    gpdma_bits::memory_to_peripheral | gpdma_bits::error_interrupt_mask |
+    gpdma_bits::terminal_count_interrupt_mask | gpdma_bits::channel_enable;
+
+  dac->cntval = sample_count(p_cpu_frequency, p_sample_rate);
+  dac->ctrl = dac_bits::double_buffer | dac_bits::counter_enable |
+              dac_bits::dma_enable;
+}
+
+dma_dac::~dma_dac()
+{
+  dac->ctrl = 0;
+  gpdma->channel[channel].config = 0;
+  on_dma_interrupt(channel, {});
+}
+
+void dma_dac::handle_interrupt()
+{
+  block_started();
+}
+}  // namespace hal::micromod::lpc40
@@ -0,0 +1,96 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include <libhal-micromod/dac_stream.hpp>
+#include <libhal/dac.hpp>
+#include <libhal/units.hpp>
+
+#include "registers.hpp"
+
+namespace hal::micromod::lpc40 {
+/**
+ * @brief DAC output on P0.26, written by the cpu
+ *
+ * The DAC is 10-bit. It may not be used while a dma_dac is playing.
+ */
+class direct_dac final : public hal::dac
+{
+public:
+  /// Construct a new direct dac object & connect the DAC to its pin
+  direct_dac();
+
+private:
+  void driver_write(float p_percentage) override;
+};
+
+/**
+ * @brief DAC output on P0.26 playing a dac_stream, with GPDMA writing each
+ * sample to the DAC
+ *
+ * The DAC's own counter paces the samples: each time it reaches zero it
+ * outputs the sample held in its double buffer & requests the next one from
+ * GPDMA channel 6. The channel follows a linked list of two items, one per
+ * block, that point at each other, so it moves on to the other block with no
+ * cpu involvement. Its terminal count interrupt at the end of each block is
+ * the stream's block_started().
+ *
+ * The counter is clocked by the peripheral clock, so the sample rate is the
+ * peripheral clock divided by a 16-bit count, at most 1MHz, the DAC's fastest
+ * update rate.
+ *
+ * Only one instance of this driver may exist as it owns the DAC & GPDMA
+ * channel 6.
+ */
+class dma_dac final : public hal::micromod::dac_stream
+{
+public:
+  /// GPDMA channel used to play the samples
+  static constexpr std::uint8_t channel = 6;
+
+  /**
+   * @brief Construct a new dma dac object & start playing
+   *
+   * Plays the DAC's present output until samples are written.
+   *
+   * @param p_cpu_frequency - frequency of the cpu
+   * @param p_buffer - two blocks of DAC words, at most 4095 words each, must
+   * outlive the driver
+   * @param p_sample_rate - requested sample rate, sample_rate() tells the
+   * nearest one the counter reaches
+   */
+  dma_dac(hal::hertz p_cpu_frequency,
+          std::span<hal::u32> p_buffer,
+          hal::hertz p_sample_rate);
+
+  dma_dac(dma_dac const&) = delete;
+  dma_dac& operator=(dma_dac const&) = delete;
+  dma_dac(dma_dac&&) = delete;
+  dma_dac& operator=(dma_dac&&) = delete;
+  ~dma_dac() override;
+
+  /// Called from the GPDMA interrupt service routine
+  void handle_interrupt();
+
+private:
+  /// Linked list of the blocks, read by the GPDMA controller
+  std::array<gpdma_linked_list_item, 2> m_blocks{};
+};
+}  // namespace hal::micromod::lpc40
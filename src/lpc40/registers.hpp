@@ -0,0 +1,343 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * @brief Register maps for the LPC40xx peripherals driven directly by the
+ * board library.
+ *
+ * Only the peripherals that libhal-arm-mcu does not already provide drivers
+ * for are described here. See UM10562 for the meaning of each register.
+ */
+namespace hal::micromod::lpc40 {
+using reg_t = std::uint32_t volatile;
+
+struct timer_reg_t
+{
+  reg_t ir;
+  reg_t tcr;
+  reg_t tc;
+  reg_t pr;
+  reg_t pc;
+  reg_t mcr;
+  reg_t mr[4];
+  reg_t ccr;
+  reg_t cr[2];
+};
+
+struct adc_reg_t
+{
+  reg_t cr;
+  reg_t gdr;
+  reg_t reserved;
+  reg_t inten;
+  reg_t dr[8];
+  reg_t stat;
+  reg_t trm;
+};
+
+struct gpdma_channel_reg_t
+{
+  reg_t source;
+  reg_t destination;
+  reg_t linked_list;
+  reg_t control;
+  reg_t config;
+  reg_t reserved[3];
+};
+
+/// GPDMA linked list item, loaded into a channel's registers when the
+/// channel's transfer completes
+struct gpdma_linked_list_item
+{
+  std::uint32_t source;
+  std::uint32_t destination;
+  std::uint32_t linked_list;
+  std::uint32_t control;
+};
+
+struct gpdma_reg_t
+{
+  reg_t int_stat;
+  reg_t int_tc_stat;
+  reg_t int_tc_clear;
+  reg_t int_err_stat;
+  reg_t int_err_clear;
+  reg_t raw_int_tc_stat;
+  reg_t raw_int_err_stat;
+  reg_t enabled_channels;
+  reg_t soft_burst_request;
+  reg_t soft_single_request;
+  reg_t soft_last_burst_request;
+  reg_t soft_last_single_request;
+  reg_t config;
+  reg_t sync;
+  reg_t reserved[50];
+  gpdma_channel_reg_t channel[8];
+};
+
+struct dac_reg_t
+{
+  reg_t dacr;
+  reg_t ctrl;
+  reg_t cntval;
+};
+
+struct can_transmit_reg_t
+{
+  reg_t frame_info;
+  reg_t id;
+  reg_t data_a;
+  reg_t data_b;
+};
+
+struct can_reg_t
+{
+  reg_t mod;
+  reg_t cmr;
+  reg_t gsr;
+  reg_t icr;
+  reg_t ier;
+  reg_t btr;
+  reg_t ewl;
+  reg_t sr;
+  reg_t receive_frame_status;
+  reg_t receive_id;
+  reg_t receive_data_a;
+  reg_t receive_data_b;
+  can_transmit_reg_t transmit[3];
+};
+
+struct can_acceptance_filter_reg_t
+{
+  reg_t afmr;
+  reg_t standard_start;
+  reg_t standard_group_start;
+  reg_t extended_start;
+  reg_t extended_group_start;
+  reg_t end_of_table;
+  reg_t lookup_error_address;
+  reg_t lookup_error;
+};
+
+/// System control registers
+namespace system_control {
+inline auto* pconp = reinterpret_cast<reg_t*>(0x400F'C0C4);
+inline auto* cclksel = reinterpret_cast<reg_t*>(0x400F'C104);
+inline auto* pclksel = reinterpret_cast<reg_t*>(0x400F'C1A8);
+inline auto* dmareqsel = reinterpret_cast<reg_t*>(0x400F'C1C4);
+}  // namespace system_control
+
+/**
+ * @brief Get the IOCON register of a pin
+ *
+ * @param p_port - port of the pin
+ * @param p_pin - pin number within the port
+ * @return reg_t* - the pin's IOCON register
+ */
+inline reg_t* iocon(std::uint8_t p_port, std::uint8_t p_pin)
+{
+  return reinterpret_cast<reg_t*>(0x4002'C000 + (p_port * 0x80) + (p_pin * 4));
+}
+
+inline auto* adc = reinterpret_cast<adc_reg_t*>(0x4003'4000);
+inline auto* timer3 = reinterpret_cast<timer_reg_t*>(0x4009'4000);
+inline auto* gpdma = reinterpret_cast<gpdma_reg_t*>(0x2008'0000);
+inline auto* dac = reinterpret_cast<dac_reg_t*>(0x4008'C000);
+inline auto* can2 = reinterpret_cast<can_reg_t*>(0x4004'8000);
+inline auto* can_acceptance_filter =
+  reinterpret_cast<can_acceptance_filter_reg_t*>(0x4003'C000);
+/// Acceptance filter look up table RAM, 512 words
+inline auto* can_acceptance_filter_ram = reinterpret_cast<reg_t*>(0x4003'8000);
+/// UART0 transmit holding register, the DMA destination for UART0 transmits
+inline auto* uart0_thr = reinterpret_cast<reg_t*>(0x4000'C000);
+/// UART0 FIFO control register (write only)
+inline auto* uart0_fcr = reinterpret_cast<reg_t*>(0x4000'C008);
+
+/// Bit positions of the PCONP register
+namespace pconp_bits {
+constexpr std::uint32_t adc = 1 << 12;
+constexpr std::uint32_t can2 = 1 << 14;
+constexpr std::uint32_t timer3 = 1 << 23;
+constexpr std::uint32_t gpdma = 1 << 29;
+}  // namespace pconp_bits
+
+/// GPDMA peripheral request lines, see DMAREQSEL for the alternates
+namespace dma_request {
+constexpr std::uint32_t dac = 9;
+constexpr std::uint32_t uart0_transmit = 10;
+}  // namespace dma_request
+
+/// Bit positions of the GPDMA registers
+namespace gpdma_bits {
+// CONFIG
+constexpr std::uint32_t enable = 1 << 0;
+// Channel CONTROL
+constexpr std::uint32_t source_width_word = 0b010 << 18;
+constexpr std::uint32_t destination_width_word = 0b010 << 21;
+constexpr std::uint32_t source_increment = 1 << 26;
+constexpr std::uint32_t destination_increment = 1 << 27;
+constexpr std::uint32_t terminal_count_interrupt = 1U << 31;
+constexpr std::uint32_t maximum_transfer_size = 0xFFF;
+// Channel CONFIG
+constexpr std::uint32_t channel_enable = 1 << 0;
+constexpr std::uint32_t memory_to_peripheral = 0b001 << 11;
+constexpr std::uint32_t error_interrupt_mask = 1 << 14;
+constexpr std::uint32_t terminal_count_interrupt_mask = 1 << 15;
+
+constexpr std::uint32_t destination_peripheral(std::uint32_t p_request)
+{
+  return p_request << 6;
+}
+}  // namespace gpdma_bits
+
+/// Bit positions of the ADC registers
+namespace adc_bits {
+// CR
+constexpr std::uint32_t burst = 1 << 16;
+constexpr std::uint32_t power_on = 1 << 21;
+constexpr std::uint32_t clock_divider(std::uint32_t p_divider)
+{
+  return (p_divider - 1) << 8;
+}
+// DR
+constexpr std::uint32_t result(std::uint32_t p_dr)
+{
+  return (p_dr >> 4) & 0xFFF;
+}
+}  // namespace adc_bits
+
+/// Bit positions of the UART FCR register
+namespace uart_fcr_bits {
+constexpr std::uint32_t fifo_enable = 1 << 0;
+constexpr std::uint32_t dma_mode = 1 << 3;
+}  // namespace uart_fcr_bits
+
+/// IOCON function select field
+constexpr std::uint32_t iocon_function_mask = 0b111;
+/// IOCON bit connecting the DAC to P0.26
+constexpr std::uint32_t iocon_dac_enable = 1 << 16;
+
+/// Bit positions of the DAC registers
+namespace dac_bits {
+// DACR, the top 10 bits of a 16-bit sample are in place
+constexpr std::uint32_t value_mask = 0xFFC0;
+// CTRL
+constexpr std::uint32_t double_buffer = 1 << 1;
+constexpr std::uint32_t counter_enable = 1 << 2;
+constexpr std::uint32_t dma_enable = 1 << 3;
+}  // namespace dac_bits
+
+/// Bit positions of the CAN controller registers
+namespace can_bits {
+// MOD
+constexpr std::uint32_t reset_mode = 1 << 0;
+// CMR
+constexpr std::uint32_t transmission_request = 1 << 0;
+constexpr std::uint32_t release_receive_buffer = 1 << 2;
+constexpr std::uint32_t clear_data_overrun = 1 << 3;
+constexpr std::uint32_t select_transmit_buffer1 = 1 << 5;
+// GSR
+constexpr std::uint32_t receive_buffer_status = 1 << 0;
+constexpr std::uint32_t transmit_complete_status = 1 << 3;
+constexpr std::uint32_t bus_status = 1 << 7;
+constexpr std::uint32_t receive_error_count(std::uint32_t p_gsr)
+{
+  return (p_gsr >> 16) & 0xFF;
+}
+constexpr std::uint32_t transmit_error_count(std::uint32_t p_gsr)
+{
+  return (p_gsr >> 24) & 0xFF;
+}
+// ICR & IER
+constexpr std::uint32_t receive_interrupt = 1 << 0;
+constexpr std::uint32_t transmit1_interrupt = 1 << 1;
+constexpr std::uint32_t error_warning_interrupt = 1 << 2;
+constexpr std::uint32_t data_overrun_interrupt = 1 << 3;
+// SR
+constexpr std::uint32_t transmit_buffer1_status = 1 << 2;
+// Frame status & frame info
+constexpr std::uint32_t remote_request = 1 << 30;
+constexpr std::uint32_t extended_frame = 1U << 31;
+
+constexpr std::uint32_t data_length(std::uint32_t p_frame)
+{
+  return (p_frame >> 16) & 0xF;
+}
+
+constexpr std::uint32_t frame_info(std::uint32_t p_length,
+                                   bool p_remote_request,
+                                   bool p_extended)
+{
+  return (p_length << 16) | (p_remote_request ? remote_request : 0) |
+         (p_extended ? extended_frame : 0);
+}
+
+// BTR, each field holds its value minus one
+constexpr std::uint32_t bit_timing(std::uint32_t p_prescaler,
+                                   std::uint32_t p_jump_width,
+                                   std::uint32_t p_segment1,
+                                   std::uint32_t p_segment2)
+{
+  return (p_prescaler - 1) | ((p_jump_width - 1) << 14) |
+         ((p_segment1 - 1) << 16) | ((p_segment2 - 1) << 20);
+}
+}  // namespace can_bits
+
+/// Bit positions of the acceptance filter AFMR register
+namespace afmr_bits {
+constexpr std::uint32_t acceptance_off = 1 << 0;
+constexpr std::uint32_t acceptance_bypass = 1 << 1;
+}  // namespace afmr_bits
+
+/// Bit positions of the timer registers
+namespace timer_bits {
+// IR
+constexpr std::uint32_t mr0_flag = 1 << 0;
+constexpr std::uint32_t mr1_flag = 1 << 1;
+// TCR
+constexpr std::uint32_t counter_enable = 1 << 0;
+constexpr std::uint32_t counter_reset = 1 << 1;
+// MCR
+constexpr std::uint32_t mr0_interrupt = 1 << 0;
+constexpr std::uint32_t mr1_interrupt = 1 << 3;
+}  // namespace timer_bits
+
+/**
+ * @brief Get the divider of the cpu clock
+ *
+ * The cpu & peripheral clocks are divided from the same clock source, by the
+ * CCLKSEL & PCLKSEL dividers.
+ *
+ * @return std::uint32_t - CCLKSEL divider, at least 1
+ */
+inline std::uint32_t cpu_clock_divider()
+{
+  return std::max<std::uint32_t>(*system_control::cclksel & 0x1F, 1);
+}
+
+/**
+ * @brief Get the divider of the peripheral clock
+ *
+ * @return std::uint32_t - PCLKSEL divider, at least 1
+ */
+inline std::uint32_t peripheral_clock_divider()
+{
+  return std::max<std::uint32_t>(*system_control::pclksel & 0x1F, 1);
+}
+}  // namespace hal::micromod::lpc40
@@ -0,0 +1,109 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sleep_timer.hpp"
+
+#include <libhal-arm-mcu/interrupt.hpp>
+#include <libhal-arm-mcu/lpc40/interrupt.hpp>
+
+#include "registers.hpp"
+
+namespace hal::micromod::lpc40 {
+namespace {
+constexpr hal::cortex_m::irq_t timer3_irq = 4;
+/// cpu cycles between periodic interrupts, a quarter of the DWT counter period
+constexpr hal::u64 period_cycles = hal::u64{ 1 } << 30;
+
+sleep_timer* active_driver = nullptr;
+
+void timer3_handler()
+{
+  if (active_driver != nullptr) {
+    active_driver->handle_interrupt();
+  }
+}
+}  // namespace
+
+sleep_timer::sleep_timer(hal::hertz p_cpu_frequency,
+                         hal::callback<void(void)> p_on_period)
+  : m_on_period(p_on_period)
+  , m_maximum_sleep_ticks(0)
+  , m_period_ticks(0)
+  , m_peripheral_divider(peripheral_clock_divider())
+  , m_cpu_divider(cpu_clock_divider())
+{
+  *system_control::pconp = *system_control::pconp | pconp_bits::timer3;
+
+  // One second of peripheral clock cycles
+  m_maximum_sleep_ticks = static_cast<std::uint32_t>(
+    p_cpu_frequency * static_cast<float>(m_cpu_divider) /
+    static_cast<float>(m_peripheral_divider));
+  m_period_ticks =
+    static_cast<std::uint32_t>((period_cycles * m_cpu_divider) /
+                               m_peripheral_divider);
+
+  timer3->tcr = timer_bits::counter_reset;
+  timer3->pr = 0;
+  timer3->mr[1] = m_period_ticks;
+  timer3->ir = timer_bits::mr0_flag | timer_bits::mr1_flag;
+  timer3->mcr = timer_bits::mr1_interrupt;
+  timer3->tcr = timer_bits::counter_enable;
+
+  active_driver = this;
+  hal::lpc40::initialize_interrupts();
+  hal::cortex_m::enable_interrupt(timer3_irq, timer3_handler);
+}
+
+sleep_timer::~sleep_timer()
+{
+  hal::cortex_m::disable_interrupt(timer3_irq);
+  timer3->tcr = 0;
+  timer3->mcr = 0;
+  *system_control::pconp = *system_control::pconp & ~pconp_bits::timer3;
+  active_driver = nullptr;
+}
+
+std::uint32_t sleep_timer::start()
+{
+  auto const start = timer3->tc;
+  timer3->mr[0] = start + m_maximum_sleep_ticks;
+  timer3->ir = timer_bits::mr0_flag;
+  timer3->mcr = timer_bits::mr0_interrupt | timer_bits::mr1_interrupt;
+  return start;
+}
+
+hal::u64 sleep_timer::stop(std::uint32_t p_start)
+{
+  auto const elapsed = static_cast<hal::u64>(timer3->tc - p_start);
+  timer3->mcr = timer_bits::mr1_interrupt;
+  return (elapsed * m_peripheral_divider) / m_cpu_divider;
+}
+
+hal::u64 sleep_timer::resolution() const
+{
+  return (m_peripheral_divider + m_cpu_divider - 1) / m_cpu_divider;
+}
+
+void sleep_timer::handle_interrupt()
+{
+  // IR flags are cleared by writing 1. The MR0 interrupt only exists to wake
+  // the core, the sleep is accounted for by stop().
+  auto const status = timer3->ir;
+  timer3->ir = status;
+  if (status & timer_bits::mr1_flag) {
+    timer3->mr[1] = timer3->mr[1] + m_period_ticks;
+    m_on_period();
+  }
+}
+}  // namespace hal::micromod::lpc40
@@ -0,0 +1,93 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include <libhal/functional.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::micromod::lpc40 {
+/**
+ * @brief Measures the time the core spends asleep with TIMER3
+ *
+ * TIMER3 is clocked by the peripheral clock, which keeps running while the
+ * core waits for an interrupt. Its 32-bit counter runs freely at the
+ * peripheral clock rate, and a match interrupt wakes the core once a second
+ * so a sleep is never longer than the counter's period.
+ *
+ * A second match register raises a periodic interrupt every 2^30 cpu cycles,
+ * for keeping the 64-bit extension of the uptime clock up to date.
+ *
+ * See hal::micromod::compensated_clock. Only one instance of this driver may
+ * exist as it owns TIMER3.
+ */
+class sleep_timer
+{
+public:
+  /**
+   * @brief Construct a new sleep timer object
+   *
+   * @param p_cpu_frequency - frequency of the cpu
+   * @param p_on_period - called from the timer interrupt every 2^30 cpu
+   * cycles
+   */
+  sleep_timer(hal::hertz p_cpu_frequency,
+              hal::callback<void(void)> p_on_period);
+
+  sleep_timer(sleep_timer const&) = delete;
+  sleep_timer& operator=(sleep_timer const&) = delete;
+  sleep_timer(sleep_timer&&) = delete;
+  sleep_timer& operator=(sleep_timer&&) = delete;
+  ~sleep_timer();
+
+  /**
+   * @brief Start measuring a sleep
+   *
+   * Arms the match interrupt to bound the sleep.
+   *
+   * @return std::uint32_t - counter value to pass to stop()
+   */
+  std::uint32_t start();
+
+  /**
+   * @brief Stop measuring a sleep
+   *
+   * @param p_start - value returned by start()
+   * @return hal::u64 - cpu cycles elapsed since start()
+   */
+  hal::u64 stop(std::uint32_t p_start);
+
+  /**
+   * @brief Get the resolution of the measurements
+   *
+   * @return hal::u64 - cpu cycles per timer tick, rounded up
+   */
+  [[nodiscard]] hal::u64 resolution() const;
+
+  /// Called from the TIMER3 interrupt service routine
+  void handle_interrupt();
+
+private:
+  hal::callback<void(void)> m_on_period;
+  /// Timer ticks per maximum sleep
+  std::uint32_t m_maximum_sleep_ticks;
+  /// Timer ticks between periodic interrupts
+  std::uint32_t m_period_ticks;
+  /// cpu cycles per timer tick is m_peripheral_divider / m_cpu_divider
+  std::uint32_t m_peripheral_divider;
+  std::uint32_t m_cpu_divider;
+};
+}  // namespace hal::micromod::lpc40
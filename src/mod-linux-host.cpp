@@ -0,0 +1,2010 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/concrete/mod-linux-host.hpp>
+#include <libhal-micromod/micromod.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libhal/error.hpp>
+#include <libhal/lock.hpp>
+
+#include "lpc40/acceptance_filter.hpp"
+#include "stm32f1/center_aligned_pwm.hpp"
+#include "stm32f1/timer_pwm.hpp"
+
+namespace hal::micromod::v1 {
+namespace {
+/**
+ * @brief Exit code used by reset()
+ *
+ * A process supervisor (or wrapper script) running the application can look
+ * for this code and restart the program, emulating a device reset.
+ */
+constexpr int reset_exit_code = 3;
+
+/// Time spent in enter_power_saving_mode(), only called from the main thread
+sleep_statistics host_sleep_statistics{};
+
+class monotonic_clock final : public hal::steady_clock
+{
+private:
+  hal::hertz driver_frequency() override
+  {
+    return 1'000'000'000.0f;
+  }
+
+  hal::u64 driver_uptime() override
+  {
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<hal::u64>(now.tv_sec) * 1'000'000'000ULL +
+           static_cast<hal::u64>(now.tv_nsec);
+  }
+};
+
+/**
+ * @brief hal::timer emulated with a worker thread
+ *
+ * The scheduled callback is invoked from the worker thread, which plays the
+ * role of the timer interrupt on real hardware.
+ */
+class thread_timer final : public hal::timer
+{
+public:
+  thread_timer()
+    : m_worker([this]() { run(); })
+  {
+  }
+
+  thread_timer(thread_timer const&) = delete;
+  thread_timer& operator=(thread_timer const&) = delete;
+
+  ~thread_timer() override
+  {
+    {
+      std::lock_guard lock(m_mutex);
+      m_stop = true;
+    }
+    m_condition.notify_all();
+    m_worker.join();
+  }
+
+private:
+  using clock_t = std::chrono::steady_clock;
+
+  bool driver_is_running() override
+  {
+    std::lock_guard lock(m_mutex);
+    return m_running;
+  }
+
+  void driver_cancel() override
+  {
+    std::lock_guard lock(m_mutex);
+    m_running = false;
+    m_condition.notify_all();
+  }
+
+  void driver_schedule(hal::callback<void(void)> p_callback,
+                       hal::time_duration p_delay) override
+  {
+    std::lock_guard lock(m_mutex);
+    m_callback = p_callback;
+    m_deadline = clock_t::now() + p_delay;
+    m_running = true;
+    m_condition.notify_all();
+  }
+
+  void run()
+  {
+    std::unique_lock lock(m_mutex);
+    while (not m_stop) {
+      if (not m_running) {
+        m_condition.wait(lock);
+        continue;
+      }
+
+      if (m_condition.wait_until(lock, m_deadline) ==
+          std::cv_status::no_timeout) {
+        // Woken up early due to schedule(), cancel() or shutdown, re-evaluate
+        // the state of the timer.
+        continue;
+      }
+
+      if (m_running && clock_t::now() >= m_deadline) {
+        m_running = false;
+        auto callback = m_callback;
+        // Release the lock so the callback can reschedule the timer.
+        lock.unlock();
+        callback();
+        lock.lock();
+      }
+    }
+  }
+
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  hal::callback<void(void)> m_callback = []() {};
+  clock_t::time_point m_deadline{};
+  bool m_running = false;
+  bool m_stop = false;
+  std::thread m_worker;
+};
+
+/**
+ * @brief hal::basic_lock over a mutex, excludes the thread_timer's worker
+ */
+class mutex_lock final : public hal::basic_lock
+{
+private:
+  void os_lock() override
+  {
+    m_mutex.lock();
+  }
+
+  void os_unlock() override
+  {
+    m_mutex.unlock();
+  }
+
+  std::mutex m_mutex;
+};
+
+/**
+ * @brief Serial port backed by the process's stdin & stdout
+ *
+ * If stdin/stdout are attached to a pty, this behaves like a terminal connected
+ * to the board's console.
+ */
+class stdio_serial final : public hal::serial
+{
+public:
+  stdio_serial(std::span<hal::byte> p_receive_buffer)
+    : m_capacity(p_receive_buffer.size())
+  {
+    auto const flags = fcntl(STDIN_FILENO, F_GETFL, 0);
+    fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK);
+  }
+
+  [[nodiscard]] hal::u64 written() const
+  {
+    return m_written;
+  }
+
+private:
+  void driver_configure(settings const&) override
+  {
+    // Baud rate, parity and stop bits have no meaning for stdio
+  }
+
+  write_t driver_write(std::span<hal::byte const> p_data) override
+  {
+    auto remaining = p_data;
+    while (not remaining.empty()) {
+      auto const written =
+        ::write(STDOUT_FILENO, remaining.data(), remaining.size());
+      if (written < 0) {
+        break;
+      }
+      remaining = remaining.subspan(static_cast<std::size_t>(written));
+    }
+    m_written += p_data.size() - remaining.size();
+    return { .data = p_data.first(p_data.size() - remaining.size()) };
+  }
+
+  read_t driver_read(std::span<hal::byte> p_data) override
+  {
+    auto const bytes_read = ::read(STDIN_FILENO, p_data.data(), p_data.size());
+    auto const length =
+      bytes_read > 0 ? static_cast<std::size_t>(bytes_read) : 0U;
+    return {
+      .data = p_data.first(length),
+      .available = 0,
+      .capacity = m_capacity,
+    };
+  }
+
+  void driver_flush() override
+  {
+    std::array<hal::byte, 64> discard{};
+    while (::read(STDIN_FILENO, discard.data(), discard.size()) > 0) {
+      continue;
+    }
+  }
+
+  std::size_t m_capacity;
+  hal::u64 m_written = 0;
+};
+
+/**
+ * @brief Serial port with its TX line connected to its own RX line
+ *
+ * Bytes written are placed into the receive buffer and can be read back.
+ */
+class loopback_serial final : public hal::serial
+{
+public:
+  loopback_serial(std::span<hal::byte> p_receive_buffer)
+    : m_buffer(p_receive_buffer)
+  {
+  }
+
+private:
+  void driver_configure(settings const&) override
+  {
+  }
+
+  write_t driver_write(std::span<hal::byte const> p_data) override
+  {
+    std::lock_guard lock(m_mutex);
+    for (auto const byte : p_data) {
+      if (m_buffer.empty()) {
+        break;
+      }
+      m_buffer[m_write_index] = byte;
+      m_write_index = (m_write_index + 1) % m_buffer.size();
+      if (m_count == m_buffer.size()) {
+        // Overwrite the oldest byte like a hardware FIFO overrun
+        m_read_index = (m_read_index + 1) % m_buffer.size();
+      } else {
+        m_count++;
+      }
+    }
+    return { .data = p_data };
+  }
+
+  read_t driver_read(std::span<hal::byte> p_data) override
+  {
+    std::lock_guard lock(m_mutex);
+    std::size_t length = 0;
+    while (length < p_data.size() && m_count > 0) {
+      p_data[length++] = m_buffer[m_read_index];
+      m_read_index = (m_read_index + 1) % m_buffer.size();
+      m_count--;
+    }
+    return {
+      .data = p_data.first(length),
+      .available = m_count,
+      .capacity = m_buffer.size(),
+    };
+  }
+
+  void driver_flush() override
+  {
+    std::lock_guard lock(m_mutex);
+    m_read_index = m_write_index;
+    m_count = 0;
+  }
+
+  std::mutex m_mutex;
+  std::span<hal::byte> m_buffer;
+  std::size_t m_write_index = 0;
+  std::size_t m_read_index = 0;
+  std::size_t m_count = 0;
+};
+
+/**
+ * @brief In-memory model of a single GPIO pin
+ *
+ * The output, input and interrupt drivers for the same pin share one model,
+ * so driving an output is observable through the input and interrupt drivers
+ * of that pin.
+ */
+struct gpio_model
+{
+  void level(bool p_level)
+  {
+    auto const previous = std::exchange(m_level, p_level);
+    if (previous == p_level) {
+      return;
+    }
+
+    using edge = hal::interrupt_pin::trigger_edge;
+    auto const triggered = m_trigger == edge::both ||
+                           (m_trigger == edge::rising && p_level) ||
+                           (m_trigger == edge::falling && not p_level);
+    if (triggered) {
+      m_handler(p_level);
+    }
+  }
+
+  bool m_level = false;
+  hal::interrupt_pin::trigger_edge m_trigger =
+    hal::interrupt_pin::trigger_edge::rising;
+  hal::callback<hal::interrupt_pin::handler> m_handler = [](bool) {};
+};
+
+class model_output_pin final : public hal::output_pin
+{
+public:
+  model_output_pin(gpio_model& p_model)
+    : m_model(&p_model)
+  {
+  }
+
+private:
+  void driver_configure(settings const&) override
+  {
+  }
+
+  void driver_level(bool p_high) override
+  {
+    m_model->level(p_high);
+  }
+
+  bool driver_level() override
+  {
+    return m_model->m_level;
+  }
+
+  gpio_model* m_model;
+};
+
+class model_input_pin final : public hal::input_pin
+{
+public:
+  model_input_pin(gpio_model& p_model)
+    : m_model(&p_model)
+  {
+  }
+
+private:
+  void driver_configure(settings const& p_settings) override
+  {
+    // With nothing driving the pin, the level settles to the pull resistor
+    if (p_settings.resistor == hal::pin_resistor::pull_up) {
+      m_model->level(true);
+    } else if (p_settings.resistor == hal::pin_resistor::pull_down) {
+      m_model->level(false);
+    }
+  }
+
+  bool driver_level() override
+  {
+    return m_model->m_level;
+  }
+
+  gpio_model* m_model;
+};
+
+class model_interrupt_pin final : public hal::interrupt_pin
+{
+public:
+  model_interrupt_pin(gpio_model& p_model)
+    : m_model(&p_model)
+  {
+  }
+
+private:
+  void driver_configure(settings const& p_settings) override
+  {
+    m_model->m_trigger = p_settings.trigger;
+  }
+
+  void driver_on_trigger(hal::callback<handler> p_callback) override
+  {
+    m_model->m_handler = p_callback;
+  }
+
+  gpio_model* m_model;
+};
+
+/**
+ * @brief In-memory model of an analog signal
+ *
+ * DAC drivers write to the model and the analog stream samples it, emulating a
+ * DAC output wired to an ADC input.
+ */
+struct analog_model
+{
+  /// Written by the DAC, read by the analog stream's worker thread
+  std::atomic<float> m_level = 0.0f;
+};
+
+class model_dac final : public hal::dac
+{
+public:
+  model_dac(analog_model& p_model)
+    : m_model(&p_model)
+  {
+  }
+
+private:
+  void driver_write(float p_percentage) override
+  {
+    m_model->m_level = std::clamp(p_percentage, 0.0f, 1.0f);
+  }
+
+  analog_model* m_model;
+};
+
+/**
+ * @brief I2C bus with no devices attached
+ *
+ * Every transaction is NACK'd, just like a real bus with nothing on it.
+ */
+class empty_i2c final : public hal::i2c
+{
+private:
+  void driver_configure(settings const&) override
+  {
+  }
+
+  void driver_transaction(hal::byte p_address,
+                          std::span<hal::byte const>,
+                          std::span<hal::byte>,
+                          hal::function_ref<hal::timeout_function>) override
+  {
+    hal::safe_throw(hal::no_such_device(p_address, this));
+  }
+};
+
+/**
+ * @brief SPI bus with its data out line connected to its data in line
+ */
+class loopback_spi final : public hal::spi
+{
+private:
+  void driver_configure(settings const&) override
+  {
+  }
+
+  void driver_transfer(std::span<hal::byte const> p_data_out,
+                       std::span<hal::byte> p_data_in,
+                       hal::byte p_filler) override
+  {
+    for (std::size_t i = 0; i < p_data_in.size(); i++) {
+      p_data_in[i] = i < p_data_out.size() ? p_data_out[i] : p_filler;
+    }
+  }
+};
+
+// =============================================================================
+//
+// CAN BUS
+//
+// =============================================================================
+
+class can_node;
+
+/**
+ * @brief In-process CAN bus
+ *
+ * Every message sent by a node is delivered to every other node attached to
+ * the bus. Delivery happens synchronously within the sender's thread, which
+ * stands in for the receive interrupt of the other nodes.
+ */
+class virtual_can_bus
+{
+public:
+  void attach(can_node& p_node)
+  {
+    std::lock_guard lock(m_mutex);
+    m_nodes.push_back(&p_node);
+  }
+
+  void send(can_node const& p_sender, hal::can_message const& p_message);
+
+private:
+  std::recursive_mutex m_mutex;
+  std::vector<can_node*> m_nodes;
+};
+
+virtual_can_bus& get_can_bus()
+{
+  static virtual_can_bus bus;
+  return bus;
+}
+
+class can_node
+{
+public:
+  virtual void deliver(hal::can_message const& p_message) = 0;
+
+protected:
+  ~can_node() = default;
+};
+
+void virtual_can_bus::send(can_node const& p_sender,
+                           hal::can_message const& p_message)
+{
+  std::lock_guard lock(m_mutex);
+  for (auto* node : m_nodes) {
+    if (node != &p_sender) {
+      node->deliver(p_message);
+    }
+  }
+}
+
+class legacy_can final
+  : public hal::can
+  , public can_node
+{
+public:
+  legacy_can()
+  {
+    get_can_bus().attach(*this);
+  }
+
+  void deliver(hal::can_message const& p_message) override
+  {
+    if (not m_bus_on) {
+      return;
+    }
+    message_t message{};
+    message.id = p_message.id;
+    message.length = p_message.length;
+    message.is_remote_request = p_message.remote_request;
+    message.payload = p_message.payload;
+    m_handler(message);
+  }
+
+private:
+  void driver_configure(settings const&) override
+  {
+  }
+
+  void driver_bus_on() override
+  {
+    m_bus_on = true;
+  }
+
+  void driver_send(message_t const& p_message) override
+  {
+    hal::can_message message{};
+    message.id = p_message.id;
+    message.length = p_message.length;
+    message.remote_request = p_message.is_remote_request;
+    message.payload = p_message.payload;
+    get_can_bus().send(*this, message);
+  }
+
+  void driver_on_receive(hal::callback<handler> p_handler) override
+  {
+    m_handler = p_handler;
+  }
+
+  hal::callback<handler> m_handler = [](message_t const&) {};
+  bool m_bus_on = true;
+};
+
+/**
+ * @brief CAN node backing the transceiver, bus manager, interrupt and filter
+ * accessors
+ */
+class can_peripheral final : public can_node
+{
+public:
+  can_peripheral()
+  {
+    update_filters();
+    get_can_bus().attach(*this);
+  }
+
+  void deliver(hal::can_message const& p_message) override
+  {
+    std::lock_guard lock(m_mutex);
+    if (not m_bus_on) {
+      return;
+    }
+    // Every frame on the virtual bus reaches the node, as with the filters
+    // bypassed on hardware
+    m_traffic.received(p_message);
+    if (not accepted(p_message)) {
+      return;
+    }
+
+    if (not m_receive_buffer.empty()) {
+      m_receive_buffer[m_cursor] = p_message;
+      m_cursor = (m_cursor + 1) % m_receive_buffer.size();
+    }
+
+    if (m_receive_handler) {
+      (*m_receive_handler)(hal::can_interrupt::on_receive_tag{}, p_message);
+    }
+  }
+
+  void send(hal::can_message const& p_message)
+  {
+    // The other nodes receive the frame while it is sent, so its start is
+    // the uptime before
+    auto const start_of_frame = uptime_clock().uptime();
+    get_can_bus().send(*this, p_message);
+    m_traffic.transmitted(p_message);
+
+    std::lock_guard lock(m_mutex);
+    if (m_transmit_handler) {
+      (*m_transmit_handler)(p_message, start_of_frame);
+    }
+  }
+
+  /// Rebuild the look up table after m_filters changes
+  void update_filters()
+  {
+    m_layout = hal::micromod::lpc40::build_acceptance_filter(
+      m_filters, can_controller, m_table);
+  }
+
+  std::recursive_mutex m_mutex;
+  std::span<hal::can_message> m_receive_buffer;
+  std::size_t m_cursor = 0;
+  hal::u32 m_baud_rate = 100'000;
+  bool m_bus_on = true;
+  hal::can_bus_manager::accept m_accept = hal::can_bus_manager::accept::all;
+  hal::can_interrupt::optional_receive_handler m_receive_handler;
+  hal::micromod::optional_can_transmit_handler m_transmit_handler;
+  /// Same filter semantics as the acceptance filter of the LPC40 board
+  hal::micromod::lpc40::can_filter_settings m_filters{};
+  hal::micromod::can_traffic_counter m_traffic;
+
+private:
+  /// Controller the table's entries are for, as CAN1 of the LPC40
+  static constexpr std::uint8_t can_controller = 0;
+
+  bool accepted(hal::can_message const& p_message)
+  {
+    if (m_accept == hal::can_bus_manager::accept::all) {
+      return true;
+    }
+    // Looked up in the table as the hardware does, then checked against the
+    // filters in software if a widened mask filter lets through more, as the
+    // LPC40 driver does
+    return hal::micromod::lpc40::acceptance_filter_accepts(
+             m_table, m_layout, can_controller, p_message) &&
+           (m_layout.exact ||
+            hal::micromod::lpc40::filters_accept(m_filters, p_message));
+  }
+
+  std::array<std::uint32_t, hal::micromod::lpc40::acceptance_filter_words>
+    m_table{};
+  hal::micromod::lpc40::acceptance_filter_layout m_layout{};
+};
+
+can_peripheral* active_can_peripheral = nullptr;
+
+can_peripheral& get_can_peripheral()
+{
+  static can_peripheral peripheral;
+  active_can_peripheral = &peripheral;
+  return peripheral;
+}
+
+class host_can_transceiver final : public hal::can_transceiver
+{
+private:
+  hal::u32 driver_baud_rate() override
+  {
+    return get_can_peripheral().m_baud_rate;
+  }
+
+  void driver_send(hal::can_message const& p_message) override
+  {
+    get_can_peripheral().send(p_message);
+  }
+
+  std::span<hal::can_message const> driver_receive_buffer() override
+  {
+    return get_can_peripheral().m_receive_buffer;
+  }
+
+  std::size_t driver_receive_cursor() override
+  {
+    std::lock_guard lock(get_can_peripheral().m_mutex);
+    return get_can_peripheral().m_cursor;
+  }
+};
+
+class host_can_bus_manager final : public hal::can_bus_manager
+{
+private:
+  void driver_baud_rate(hal::u32 p_hertz) override
+  {
+    std::lock_guard lock(get_can_peripheral().m_mutex);
+    get_can_peripheral().m_baud_rate = p_hertz;
+  }
+
+  void driver_filter_mode(accept p_accept) override
+  {
+    std::lock_guard lock(get_can_peripheral().m_mutex);
+    get_can_peripheral().m_accept = p_accept;
+  }
+
+  void driver_on_bus_off(optional_bus_off_handler&) override
+  {
+    // The virtual bus has no physical layer and thus can never go bus-off
+  }
+
+  void driver_bus_on() override
+  {
+    std::lock_guard lock(get_can_peripheral().m_mutex);
+    get_can_peripheral().m_bus_on = true;
+  }
+};
+
+class host_can_interrupt final : public hal::can_interrupt
+{
+private:
+  void driver_on_receive(optional_receive_handler const& p_callback) override
+  {
+    std::lock_guard lock(get_can_peripheral().m_mutex);
+    get_can_peripheral().m_receive_handler = p_callback;
+  }
+};
+
+using hal::micromod::lpc40::can_filter_settings;
+
+/**
+ * @brief Generic filter driver that stores its setting in one of the can
+ * peripheral's filter tables
+ *
+ * @tparam interface_t - hal filter interface to implement
+ * @tparam value_t - type of the value passed to allow()
+ * @tparam table - pointer to the can_filter_settings member holding the
+ * filters
+ */
+template<class interface_t, class value_t, auto table>
+class host_can_filter final : public interface_t
+{
+public:
+  host_can_filter(std::size_t p_index)
+    : m_index(p_index)
+  {
+  }
+
+private:
+  void driver_allow(std::optional<value_t> p_value) override
+  {
+    auto& peripheral = get_can_peripheral();
+    std::lock_guard lock(peripheral.m_mutex);
+    (peripheral.m_filters.*table)[m_index] = p_value;
+    peripheral.update_filters();
+  }
+
+  std::size_t m_index;
+};
+
+using identifier_filter = host_can_filter<hal::can_identifier_filter,
+                                          hal::u16,
+                                          &can_filter_settings::identifiers>;
+using mask_filter = host_can_filter<hal::can_mask_filter,
+                                    hal::can_mask_filter::pair,
+                                    &can_filter_settings::masks>;
+using range_filter = host_can_filter<hal::can_range_filter,
+                                     hal::can_range_filter::pair,
+                                     &can_filter_settings::ranges>;
+using extended_identifier_filter =
+  host_can_filter<hal::can_extended_identifier_filter,
+                  hal::u32,
+                  &can_filter_settings::extended_identifiers>;
+using extended_mask_filter =
+  host_can_filter<hal::can_extended_mask_filter,
+                  hal::can_extended_mask_filter::pair,
+                  &can_filter_settings::extended_masks>;
+using extended_range_filter =
+  host_can_filter<hal::can_extended_range_filter,
+                  hal::can_extended_range_filter::pair,
+                  &can_filter_settings::extended_ranges>;
+
+template<class filter_t, std::size_t index>
+filter_t& get_filter()
+{
+  static filter_t filter(index);
+  return filter;
+}
+
+// =============================================================================
+//
+// GPIO
+//
+// =============================================================================
+
+constexpr std::size_t gpio_count = 11;
+
+gpio_model& get_gpio_model(std::size_t p_gpio_pin)
+{
+  static std::array<gpio_model, gpio_count> models{};
+  return models[p_gpio_pin];
+}
+
+template<class gpio_t, std::uint8_t gpio_pin>
+gpio_t& gpio()
+{
+  static_assert(gpio_pin < gpio_count, "GPIO pin does not exist");
+  static gpio_t driver(get_gpio_model(gpio_pin));
+  return driver;
+}
+
+template<class gpio_t, std::uint8_t... gpio_pins>
+void construct_gpio(std::uint8_t p_gpio_pin,
+                    std::integer_sequence<std::uint8_t, gpio_pins...>)
+{
+  static_cast<void>(
+    ((p_gpio_pin == gpio_pins &&
+      (static_cast<void>(gpio<gpio_t, gpio_pins>()), true)) ||
+     ...));
+}
+
+analog_model& get_analog_model(std::size_t p_channel)
+{
+  // Channel 0 & 1 are a0/d0 & a1/d1, channel 2 is the battery
+  static std::array<analog_model, 3> models{
+    analog_model{},
+    analog_model{},
+    // Emulate a 3.6V battery seen through a 1/3rd divider on a 3.3V reference
+    analog_model{ .m_level = (3.6f / 3.0f) / 3.3f },
+  };
+  return models[p_channel];
+}
+
+/// Frames per second of the analog stream
+constexpr hal::hertz analog_frame_rate = 10'000.0f;
+/// Frames in each of the two blocks of the analog stream
+constexpr std::size_t analog_block_frames = 64;
+
+/**
+ * @brief Analog stream filled from the analog models by a worker thread
+ *
+ * The worker writes a whole block of the models' levels each block period,
+ * playing the role of the DMA & its interrupt on real hardware. Each sample
+ * carries under an LSB of noise, as a real converter's do, so oversampling
+ * gains resolution on the host as well.
+ */
+class model_analog_stream final : public hal::micromod::analog_stream
+{
+public:
+  model_analog_stream(std::span<hal::u16> p_buffer)
+    : analog_stream(p_buffer, analog_frame_rate)
+    , m_worker([this]() { run(); })
+  {
+  }
+
+  model_analog_stream(model_analog_stream const&) = delete;
+  model_analog_stream& operator=(model_analog_stream const&) = delete;
+
+  ~model_analog_stream() override
+  {
+    {
+      std::lock_guard lock(m_mutex);
+      m_stop = true;
+    }
+    m_condition.notify_all();
+    m_worker.join();
+  }
+
+private:
+  using clock_t = std::chrono::steady_clock;
+
+  std::size_t written() override
+  {
+    return m_written.load(std::memory_order_acquire);
+  }
+
+  void run()
+  {
+    auto const samples = buffer();
+    auto const half = samples.size() / 2;
+    auto const period = std::chrono::duration_cast<clock_t::duration>(
+      std::chrono::duration<double>(static_cast<double>(block_frames()) /
+                                    analog_frame_rate));
+    auto deadline = clock_t::now();
+    std::size_t next_half = 0;
+    std::unique_lock lock(m_mutex);
+    while (not m_stop) {
+      deadline += period;
+      if (m_condition.wait_until(lock, deadline, [this]() { return m_stop; })) {
+        break;
+      }
+      auto const block = samples.subspan(next_half * half, half);
+      for (std::size_t i = 0; i < block.size(); i++) {
+        auto const level = get_analog_model(i % analog_channels).m_level.load();
+        auto const sample = (level * analog_full_scale) + noise();
+        block[i] = static_cast<hal::u16>(
+          std::lround(std::clamp(sample, 0.0f, float{ analog_full_scale })));
+      }
+      m_written.store(next_half == 0 ? half : 0, std::memory_order_release);
+      block_complete(next_half);
+      next_half ^= 1;
+    }
+  }
+
+  /// Triangular noise from -1 to 1 LSB, the sum of two uniform draws
+  float noise()
+  {
+    auto const uniform = [this]() {
+      m_noise_state = (m_noise_state * 1'103'515'245U) + 12'345U;
+      return static_cast<float>((m_noise_state >> 16) & 0x7FFF) / 32768.0f;
+    };
+    return uniform() + uniform() - 1.0f;
+  }
+
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::atomic<std::size_t> m_written = 0;
+  hal::u32 m_noise_state = 1;
+  bool m_stop = false;
+  std::thread m_worker;
+};
+
+/// Samples in each of the two blocks of the dac stream
+constexpr std::size_t dac_block_samples = 256;
+/// Time between updates of the analog model from the dac stream
+constexpr std::chrono::microseconds dac_model_step{ 100 };
+
+/**
+ * @brief Dac stream played into the analog model of d0 by a worker thread
+ *
+ * The worker keeps a sample clock of its own, started with the stream, and
+ * calls block_started() for each block boundary the clock has passed, playing
+ * the role of the DMA & its interrupt on real hardware. A writer that falls
+ * behind sees underruns where the hardware would give them, however late the
+ * worker runs. The model's level follows the sample due at each step.
+ */
+class model_dac_stream final : public hal::micromod::dac_stream
+{
+public:
+  model_dac_stream(std::span<hal::u32> p_buffer, hal::hertz p_sample_rate)
+    : dac_stream(p_buffer, p_sample_rate, dac_full_scale)
+  {
+    auto const level = get_analog_model(0).m_level.load();
+    std::ranges::fill(buffer(),
+                      static_cast<hal::u32>(std::lround(
+                        level * static_cast<float>(dac_full_scale))));
+    m_worker = std::thread([this]() { run(); });
+  }
+
+  model_dac_stream(model_dac_stream const&) = delete;
+  model_dac_stream& operator=(model_dac_stream const&) = delete;
+
+  ~model_dac_stream() override
+  {
+    {
+      std::lock_guard lock(m_mutex);
+      m_stop = true;
+    }
+    m_condition.notify_all();
+    m_worker.join();
+  }
+
+private:
+  using clock_t = std::chrono::steady_clock;
+
+  void run()
+  {
+    auto const samples = buffer();
+    auto const size = block_samples();
+    auto const start = clock_t::now();
+    auto deadline = start;
+    hal::u64 block = 0;
+    std::unique_lock lock(m_mutex);
+    while (not m_stop) {
+      deadline += dac_model_step;
+      if (m_condition.wait_until(lock, deadline, [this]() { return m_stop; })) {
+        break;
+      }
+      auto const elapsed =
+        std::chrono::duration<double>(clock_t::now() - start).count();
+      auto const sample =
+        static_cast<hal::u64>(elapsed * static_cast<double>(sample_rate()));
+      for (; block < sample / size; block++) {
+        block_started();
+      }
+      auto const word = samples[sample % samples.size()];
+      get_analog_model(0).m_level =
+        static_cast<float>(word) / static_cast<float>(dac_full_scale);
+    }
+  }
+
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  bool m_stop = false;
+  std::thread m_worker;
+};
+
+stdio_serial* active_console = nullptr;
+}  // namespace
+
+void initialize_platform()
+{
+  // Nothing to initialize when running as a process
+}
+
+void initialize_driver(eager_driver p_driver)
+{
+  // The guard check is not a concern on the host, so the drivers are always
+  // constructed on first use & this only constructs them early.
+  constexpr auto gpio_pins =
+    std::make_integer_sequence<std::uint8_t, gpio_count>();
+  auto const driver = static_cast<std::uint8_t>(p_driver);
+  auto const first_input = static_cast<std::uint8_t>(eager_driver::input_g0);
+  if (driver < first_input) {
+    construct_gpio<model_output_pin>(driver, gpio_pins);
+  } else {
+    construct_gpio<model_input_pin>(driver - first_input, gpio_pins);
+  }
+}
+
+hal::steady_clock& uptime_clock()
+{
+  static monotonic_clock steady_clock;
+  return steady_clock;
+}
+
+hal::timer& system_timer()
+{
+  static thread_timer timer;
+  return timer;
+}
+
+hal::micromod::timer_wheel& system_timer_wheel()
+{
+  using namespace std::chrono_literals;
+  static mutex_lock lock;
+  static hal::micromod::timer_wheel wheel(
+    uptime_clock(), system_timer(), lock, 1ms, 1s);
+  return wheel;
+}
+
+void enter_power_saving_mode()
+{
+  // Emulate wait-for-interrupt by sleeping until the console has data or a
+  // millisecond has passed, whichever comes first.
+  auto& clock = uptime_clock();
+  auto const start = clock.uptime();
+  pollfd console_fd{ .fd = STDIN_FILENO, .events = POLLIN, .revents = 0 };
+  poll(&console_fd, 1, 1);
+  host_sleep_statistics.sleeps++;
+  host_sleep_statistics.asleep_ticks += clock.uptime() - start;
+}
+
+sleep_statistics power_saving_statistics()
+{
+  return host_sleep_statistics;
+}
+
+void reset()
+{
+  std::fflush(stdout);
+  std::exit(reset_exit_code);
+}
+
+hal::serial& console(std::span<hal::byte> p_receive_buffer)
+{
+  static stdio_serial driver(p_receive_buffer);
+  active_console = &driver;
+  return driver;
+}
+
+void console_overflow_policy(hal::micromod::overflow_policy)
+{
+  // Writes go straight to stdout, which the OS buffers, so there is no
+  // transmit ring to overflow.
+}
+
+hal::micromod::transmit_statistics console_statistics()
+{
+  if (active_console == nullptr) {
+    return {};
+  }
+  return { .written = active_console->written() };
+}
+
+hal::output_pin& concrete::led()
+{
+  static gpio_model model;
+  static model_output_pin driver(model);
+  return driver;
+}
+
+hal::output_pin& led()
+{
+  return concrete::led();
+}
+
+hal::micromod::analog_stream& analog_inputs()
+{
+  static std::array<hal::u16, 2 * analog_block_frames * analog_channels>
+    buffer{};
+  static model_analog_stream stream(buffer);
+  return stream;
+}
+
+hal::adc& a0()
+{
+  static hal::micromod::analog_stream_adc driver(
+    analog_inputs(), hal::micromod::analog_channel::a0);
+  return driver;
+}
+
+hal::adc& a1()
+{
+  static hal::micromod::analog_stream_adc driver(
+    analog_inputs(), hal::micromod::analog_channel::a1);
+  return driver;
+}
+
+hal::adc& battery()
+{
+  static hal::micromod::analog_stream_adc driver(
+    analog_inputs(), hal::micromod::analog_channel::battery);
+  return driver;
+}
+
+hal::dac& d0()
+{
+  static model_dac driver(get_analog_model(0));
+  return driver;
+}
+
+hal::dac& d1()
+{
+  static model_dac driver(get_analog_model(1));
+  return driver;
+}
+
+hal::micromod::dac_stream& d0_stream(hal::hertz p_sample_rate)
+{
+  static std::array<hal::u32, 2 * dac_block_samples> buffer{};
+  static model_dac_stream stream(buffer, p_sample_rate);
+  return stream;
+}
+
+namespace {
+/// Kernel clock of the STM32F1 timers on the boards, at 64MHz
+constexpr hal::hertz model_timer_clock = 64'000'000.0f;
+
+/**
+ * @brief Timer registers the PWM outputs are written to
+ *
+ * The outputs run the STM32F1 timer driver on in-memory registers, as pwm0()
+ * on TIM1 & pwm1() on TIM2 do on the boards, so the prescaler, period &
+ * compare values an application produces can be checked without hardware.
+ */
+std::array<hal::micromod::stm32f1::timer_reg_t, 2> model_timers{};
+
+auto& get_model_timer1()
+{
+  static hal::micromod::stm32f1::pwm_timer timer(
+    model_timers[0], model_timer_clock, true);
+  return timer;
+}
+
+auto& get_model_timer2()
+{
+  static hal::micromod::stm32f1::pwm_timer timer(
+    model_timers[1], model_timer_clock, false);
+  return timer;
+}
+
+/// Drivers the model timers may be given to, one kind or the other
+enum class pwm_timers_user : std::uint8_t
+{
+  none,
+  outputs,
+  group,
+};
+
+pwm_timers_user pwm_timers = pwm_timers_user::none;
+
+/// Give the model timers to p_user, unless the other kind of driver has them
+void take_pwm_timers(pwm_timers_user p_user)
+{
+  if (pwm_timers != pwm_timers_user::none && pwm_timers != p_user) {
+    hal::safe_throw(hal::device_or_resource_busy(nullptr));
+  }
+  pwm_timers = p_user;
+}
+}  // namespace
+
+hal::pwm& pwm0()
+{
+  take_pwm_timers(pwm_timers_user::outputs);
+  static hal::micromod::stm32f1::timer_pwm driver(get_model_timer1(), 1);
+  return driver;
+}
+
+hal::pwm& pwm1()
+{
+  take_pwm_timers(pwm_timers_user::outputs);
+  static hal::micromod::stm32f1::timer_pwm driver(get_model_timer2(), 2);
+  return driver;
+}
+
+namespace {
+/// ADC2's registers, sampled by the synchronized pwm model
+hal::micromod::stm32f1::adc_reg_t model_adc2{};
+/// Samples kept for the worker, older ones are lost as an overrun would be
+constexpr std::size_t model_pending_samples = 64;
+/// Time between runs of the synchronized pwm model's interrupt
+constexpr std::chrono::microseconds model_interrupt_step{ 50 };
+
+/**
+ * @brief Lock of the synchronized pwm model, which also runs its counters
+ *
+ * Nothing counts on the host, so each time the lock is taken the timers are
+ * caught up to real time at the model timer clock: counting up to the top &
+ * back down with CR1.DIR showing the direction, loading the preloaded
+ * registers at both ends unless updates are disabled, & converting A0 & A1 at
+ * the top while ADC2's injected trigger is enabled. A conversion reads the
+ * duty cycle each output ran up to the top, as if each output were filtered
+ * into the input sampling it, so the samples show the update event a commit
+ * took effect at.
+ *
+ * A worker thread plays the ADC interrupt, calling handle_interrupt() with the
+ * lock held as the interrupt_lock excludes the interrupt on the boards. The
+ * lock is recursive, for commits made from the sample handler.
+ */
+class model_pwm_counter final : public hal::basic_lock
+{
+public:
+  model_pwm_counter() = default;
+  model_pwm_counter(model_pwm_counter const&) = delete;
+  model_pwm_counter& operator=(model_pwm_counter const&) = delete;
+
+  ~model_pwm_counter() override
+  {
+    stop();
+  }
+
+  void start(hal::micromod::stm32f1::center_aligned_pwm& p_driver)
+  {
+    m_driver = &p_driver;
+    m_worker = std::thread([this]() { run(); });
+  }
+
+  void stop()
+  {
+    m_stop = true;
+    if (m_worker.joinable()) {
+      m_worker.join();
+    }
+  }
+
+private:
+  using clock_t = std::chrono::steady_clock;
+
+  struct active_timer
+  {
+    hal::u32 prescaler = 1;
+    hal::u32 top = 0;
+    hal::u32 compare = 0;
+  };
+
+  void os_lock() override
+  {
+    m_mutex.lock();
+    advance();
+  }
+
+  void os_unlock() override
+  {
+    m_mutex.unlock();
+  }
+
+  void run()
+  {
+    while (not m_stop) {
+      std::this_thread::sleep_for(model_interrupt_step);
+      std::lock_guard lock(*this);
+      // Only the samples already converted, so that a slow handler cannot
+      // keep the lock forever
+      for (auto pending = m_pending.size(); pending > 0; pending--) {
+        auto const [a0, a1] = m_pending.front();
+        m_pending.pop_front();
+        model_adc2.jdr[0] = a0;
+        model_adc2.jdr[1] = a1;
+        model_adc2.sr =
+          model_adc2.sr | hal::micromod::stm32f1::adc_bits::injected_end;
+        m_driver->handle_interrupt();
+      }
+    }
+  }
+
+  void advance()
+  {
+    using namespace hal::micromod::stm32f1;
+    auto const now = clock_t::now();
+    auto& master = model_timers[0];
+    if ((master.cr1 & timer_bits::counter_enable) == 0) {
+      m_running = false;
+      return;
+    }
+    if (not m_running) {
+      // The update generated before the counter was enabled
+      m_running = true;
+      m_last = now;
+      m_clocks = 0.0;
+      m_counter = 0;
+      m_up = true;
+      load();
+      return;
+    }
+
+    m_clocks += std::chrono::duration<double>(now - m_last).count() *
+                static_cast<double>(model_timer_clock);
+    m_last = now;
+    while (true) {
+      auto const prescaler = static_cast<double>(m_active[0].prescaler);
+      auto const end = m_up ? m_active[0].top - m_counter : m_counter;
+      auto const clocks = static_cast<double>(end) * prescaler;
+      if (m_clocks < clocks) {
+        auto const counts = static_cast<hal::u32>(m_clocks / prescaler);
+        m_counter = m_up ? m_counter + counts : m_counter - counts;
+        m_clocks -= static_cast<double>(counts) * prescaler;
+        break;
+      }
+      m_clocks -= clocks;
+      if (m_up) {
+        m_counter = m_active[0].top;
+        convert();
+      } else {
+        m_counter = 0;
+      }
+      m_up = not m_up;
+      load();
+    }
+    for (auto& timer : model_timers) {
+      timer.cnt = m_counter;
+      timer.cr1 = m_up ? timer.cr1 & ~timer_bits::direction_down
+                       : timer.cr1 | timer_bits::direction_down;
+    }
+  }
+
+  /// Update event, loading each timer's preloaded registers
+  void load()
+  {
+    using namespace hal::micromod::stm32f1;
+    for (std::size_t i = 0; i < model_timers.size(); i++) {
+      auto const& timer = model_timers[i];
+      if ((timer.cr1 & timer_bits::update_disable) == 0) {
+        m_active[i] = {
+          .prescaler = timer.psc + 1,
+          .top = timer.arr,
+          .compare = i == 0 ? timer.ccr1 : timer.ccr2,
+        };
+      }
+    }
+  }
+
+  void convert()
+  {
+    using namespace hal::micromod::stm32f1;
+    if ((model_adc2.cr2 & adc_bits::injected_external_trigger) == 0) {
+      return;
+    }
+    auto const level = [](active_timer const& p_timer) {
+      if (p_timer.top == 0 || p_timer.compare >= p_timer.top) {
+        return hal::u32{ 0 };
+      }
+      auto const duty = static_cast<float>(p_timer.top - p_timer.compare) /
+                        static_cast<float>(p_timer.top);
+      return static_cast<hal::u32>(std::lround(duty * 4095.0f));
+    };
+    if (m_pending.size() == model_pending_samples) {
+      m_pending.pop_front();
+    }
+    m_pending.push_back({ level(m_active[0]), level(m_active[1]) });
+  }
+
+  std::recursive_mutex m_mutex;
+  hal::micromod::stm32f1::center_aligned_pwm* m_driver = nullptr;
+  std::array<active_timer, 2> m_active{};
+  std::deque<std::array<hal::u32, 2>> m_pending;
+  clock_t::time_point m_last{};
+  /// Timer clocks not yet counted
+  double m_clocks = 0.0;
+  hal::u32 m_counter = 0;
+  bool m_up = true;
+  bool m_running = false;
+  std::atomic<bool> m_stop = false;
+  std::thread m_worker;
+};
+
+/**
+ * @brief Synchronized pwm driver on the model's registers & counters
+ *
+ * The worker is stopped before the driver is destroyed.
+ */
+class model_synchronized_pwm
+{
+public:
+  model_synchronized_pwm()
+    : m_driver(model_timers[0],
+               model_timers[1],
+               model_adc2,
+               model_timer_clock,
+               m_counter)
+  {
+    m_counter.start(m_driver);
+  }
+
+  model_synchronized_pwm(model_synchronized_pwm const&) = delete;
+  model_synchronized_pwm& operator=(model_synchronized_pwm const&) = delete;
+
+  ~model_synchronized_pwm()
+  {
+    m_counter.stop();
+  }
+
+  hal::micromod::pwm_group& driver()
+  {
+    return m_driver;
+  }
+
+private:
+  model_pwm_counter m_counter;
+  hal::micromod::stm32f1::center_aligned_pwm m_driver;
+};
+}  // namespace
+
+hal::micromod::pwm_group& synchronized_pwm()
+{
+  take_pwm_timers(pwm_timers_user::group);
+  static model_synchronized_pwm group;
+  return group.driver();
+}
+
+hal::i2c& i2c()
+{
+  static empty_i2c driver;
+  return driver;
+}
+
+hal::interrupt_pin& i2c_interrupt_pin()
+{
+  static gpio_model model;
+  static model_interrupt_pin driver(model);
+  return driver;
+}
+
+hal::i2c& i2c1()
+{
+  static empty_i2c driver;
+  return driver;
+}
+
+hal::spi& spi()
+{
+  static loopback_spi driver;
+  return driver;
+}
+
+hal::output_pin& spi_chip_select()
+{
+  static gpio_model model;
+  static model_output_pin driver(model);
+  return driver;
+}
+
+hal::spi& spi1()
+{
+  static loopback_spi driver;
+  return driver;
+}
+
+hal::serial& uart1(std::span<hal::byte> p_receive_buffer)
+{
+  static loopback_serial driver(p_receive_buffer);
+  return driver;
+}
+
+hal::serial& uart2(std::span<hal::byte> p_receive_buffer)
+{
+  static loopback_serial driver(p_receive_buffer);
+  return driver;
+}
+
+hal::output_pin& concrete::output_g0()
+{
+  return gpio<model_output_pin, 0>();
+}
+hal::output_pin& output_g0()
+{
+  return concrete::output_g0();
+}
+hal::output_pin& concrete::output_g1()
+{
+  return gpio<model_output_pin, 1>();
+}
+hal::output_pin& output_g1()
+{
+  return concrete::output_g1();
+}
+hal::output_pin& concrete::output_g2()
+{
+  return gpio<model_output_pin, 2>();
+}
+hal::output_pin& output_g2()
+{
+  return concrete::output_g2();
+}
+hal::output_pin& concrete::output_g3()
+{
+  return gpio<model_output_pin, 3>();
+}
+hal::output_pin& output_g3()
+{
+  return concrete::output_g3();
+}
+hal::output_pin& concrete::output_g4()
+{
+  return gpio<model_output_pin, 4>();
+}
+hal::output_pin& output_g4()
+{
+  return concrete::output_g4();
+}
+hal::output_pin& concrete::output_g5()
+{
+  return gpio<model_output_pin, 5>();
+}
+hal::output_pin& output_g5()
+{
+  return concrete::output_g5();
+}
+hal::output_pin& concrete::output_g6()
+{
+  return gpio<model_output_pin, 6>();
+}
+hal::output_pin& output_g6()
+{
+  return concrete::output_g6();
+}
+hal::output_pin& concrete::output_g7()
+{
+  return gpio<model_output_pin, 7>();
+}
+hal::output_pin& output_g7()
+{
+  return concrete::output_g7();
+}
+hal::output_pin& concrete::output_g8()
+{
+  return gpio<model_output_pin, 8>();
+}
+hal::output_pin& output_g8()
+{
+  return concrete::output_g8();
+}
+hal::output_pin& concrete::output_g9()
+{
+  return gpio<model_output_pin, 9>();
+}
+hal::output_pin& output_g9()
+{
+  return concrete::output_g9();
+}
+hal::output_pin& concrete::output_g10()
+{
+  return gpio<model_output_pin, 10>();
+}
+hal::output_pin& output_g10()
+{
+  return concrete::output_g10();
+}
+
+hal::input_pin& concrete::input_g0()
+{
+  return gpio<model_input_pin, 0>();
+}
+hal::input_pin& input_g0()
+{
+  return concrete::input_g0();
+}
+hal::input_pin& concrete::input_g1()
+{
+  return gpio<model_input_pin, 1>();
+}
+hal::input_pin& input_g1()
+{
+  return concrete::input_g1();
+}
+hal::input_pin& concrete::input_g2()
+{
+  return gpio<model_input_pin, 2>();
+}
+hal::input_pin& input_g2()
+{
+  return concrete::input_g2();
+}
+hal::input_pin& concrete::input_g3()
+{
+  return gpio<model_input_pin, 3>();
+}
+hal::input_pin& input_g3()
+{
+  return concrete::input_g3();
+}
+hal::input_pin& concrete::input_g4()
+{
+  return gpio<model_input_pin, 4>();
+}
+hal::input_pin& input_g4()
+{
+  return concrete::input_g4();
+}
+hal::input_pin& concrete::input_g5()
+{
+  return gpio<model_input_pin, 5>();
+}
+hal::input_pin& input_g5()
+{
+  return concrete::input_g5();
+}
+hal::input_pin& concrete::input_g6()
+{
+  return gpio<model_input_pin, 6>();
+}
+hal::input_pin& input_g6()
+{
+  return concrete::input_g6();
+}
+hal::input_pin& concrete::input_g7()
+{
+  return gpio<model_input_pin, 7>();
+}
+hal::input_pin& input_g7()
+{
+  return concrete::input_g7();
+}
+hal::input_pin& concrete::input_g8()
+{
+  return gpio<model_input_pin, 8>();
+}
+hal::input_pin& input_g8()
+{
+  return concrete::input_g8();
+}
+hal::input_pin& concrete::input_g9()
+{
+  return gpio<model_input_pin, 9>();
+}
+hal::input_pin& input_g9()
+{
+  return concrete::input_g9();
+}
+hal::input_pin& concrete::input_g10()
+{
+  return gpio<model_input_pin, 10>();
+}
+hal::input_pin& input_g10()
+{
+  return concrete::input_g10();
+}
+
+hal::interrupt_pin& interrupt_g0()
+{
+  return gpio<model_interrupt_pin, 0>();
+}
+hal::interrupt_pin& interrupt_g1()
+{
+  return gpio<model_interrupt_pin, 1>();
+}
+hal::interrupt_pin& interrupt_g2()
+{
+  return gpio<model_interrupt_pin, 2>();
+}
+hal::interrupt_pin& interrupt_g3()
+{
+  return gpio<model_interrupt_pin, 3>();
+}
+hal::interrupt_pin& interrupt_g4()
+{
+  return gpio<model_interrupt_pin, 4>();
+}
+hal::interrupt_pin& interrupt_g5()
+{
+  return gpio<model_interrupt_pin, 5>();
+}
+hal::interrupt_pin& interrupt_g6()
+{
+  return gpio<model_interrupt_pin, 6>();
+}
+hal::interrupt_pin& interrupt_g7()
+{
+  return gpio<model_interrupt_pin, 7>();
+}
+hal::interrupt_pin& interrupt_g8()
+{
+  return gpio<model_interrupt_pin, 8>();
+}
+hal::interrupt_pin& interrupt_g9()
+{
+  return gpio<model_interrupt_pin, 9>();
+}
+hal::interrupt_pin& interrupt_g10()
+{
+  return gpio<model_interrupt_pin, 10>();
+}
+
+// =============================================================================
+//
+// CAN BUS
+//
+// =============================================================================
+
+hal::can& can()
+{
+  static legacy_can driver;
+  return driver;
+}
+
+hal::can_transceiver& can_transceiver(std::span<can_message> p_receive_buffer)
+{
+  static host_can_transceiver transceiver = [p_receive_buffer]() {
+    std::lock_guard lock(get_can_peripheral().m_mutex);
+    get_can_peripheral().m_receive_buffer = p_receive_buffer;
+    return host_can_transceiver{};
+  }();
+  return transceiver;
+}
+
+hal::can_bus_manager& can_bus_manager()
+{
+  static host_can_bus_manager bus_manager;
+  return bus_manager;
+}
+
+hal::can_interrupt& can_interrupt()
+{
+  static host_can_interrupt interrupt;
+  return interrupt;
+}
+
+hal::micromod::can_transmit_statistics can_transmit_queue_statistics()
+{
+  // Messages are handed straight to the controller, there is no queue
+  return {};
+}
+
+hal::micromod::can_bus_statistics can_statistics()
+{
+  hal::micromod::can_bus_statistics statistics{};
+  if (active_can_peripheral != nullptr) {
+    // The virtual bus has no physical layer, so no errors
+    active_can_peripheral->m_traffic.read(statistics);
+    std::lock_guard lock(active_can_peripheral->m_mutex);
+    statistics.baud_rate = active_can_peripheral->m_baud_rate;
+  }
+  statistics.timestamp = uptime_clock().uptime();
+  return statistics;
+}
+
+hal::u64 can_receive_timestamp()
+{
+  // Messages are delivered by the sending thread, there is no capture
+  return uptime_clock().uptime();
+}
+
+void can_on_transmit(
+  hal::micromod::optional_can_transmit_handler const& p_handler)
+{
+  std::lock_guard lock(get_can_peripheral().m_mutex);
+  get_can_peripheral().m_transmit_handler = p_handler;
+}
+
+hal::can_identifier_filter& can_identifier_filter0()
+{
+  return get_filter<identifier_filter, 0>();
+}
+hal::can_identifier_filter& can_identifier_filter1()
+{
+  return get_filter<identifier_filter, 1>();
+}
+hal::can_identifier_filter& can_identifier_filter2()
+{
+  return get_filter<identifier_filter, 2>();
+}
+hal::can_identifier_filter& can_identifier_filter3()
+{
+  return get_filter<identifier_filter, 3>();
+}
+hal::can_identifier_filter& can_identifier_filter4()
+{
+  return get_filter<identifier_filter, 4>();
+}
+hal::can_identifier_filter& can_identifier_filter5()
+{
+  return get_filter<identifier_filter, 5>();
+}
+hal::can_identifier_filter& can_identifier_filter6()
+{
+  return get_filter<identifier_filter, 6>();
+}
+hal::can_identifier_filter& can_identifier_filter7()
+{
+  return get_filter<identifier_filter, 7>();
+}
+
+hal::can_mask_filter& can_mask_filter0()
+{
+  return get_filter<mask_filter, 0>();
+}
+hal::can_mask_filter& can_mask_filter1()
+{
+  return get_filter<mask_filter, 1>();
+}
+hal::can_mask_filter& can_mask_filter2()
+{
+  return get_filter<mask_filter, 2>();
+}
+hal::can_mask_filter& can_mask_filter3()
+{
+  return get_filter<mask_filter, 3>();
+}
+hal::can_mask_filter& can_mask_filter4()
+{
+  return get_filter<mask_filter, 4>();
+}
+hal::can_mask_filter& can_mask_filter5()
+{
+  return get_filter<mask_filter, 5>();
+}
+hal::can_mask_filter& can_mask_filter6()
+{
+  return get_filter<mask_filter, 6>();
+}
+hal::can_mask_filter& can_mask_filter7()
+{
+  return get_filter<mask_filter, 7>();
+}
+
+hal::can_range_filter& can_range_filter0()
+{
+  return get_filter<range_filter, 0>();
+}
+hal::can_range_filter& can_range_filter1()
+{
+  return get_filter<range_filter, 1>();
+}
+hal::can_range_filter& can_range_filter2()
+{
+  return get_filter<range_filter, 2>();
+}
+hal::can_range_filter& can_range_filter3()
+{
+  return get_filter<range_filter, 3>();
+}
+hal::can_range_filter& can_range_filter4()
+{
+  return get_filter<range_filter, 4>();
+}
+hal::can_range_filter& can_range_filter5()
+{
+  return get_filter<range_filter, 5>();
+}
+hal::can_range_filter& can_range_filter6()
+{
+  return get_filter<range_filter, 6>();
+}
+hal::can_range_filter& can_range_filter7()
+{
+  return get_filter<range_filter, 7>();
+}
+
+hal::can_extended_identifier_filter& can_extended_identifier_filter0()
+{
+  return get_filter<extended_identifier_filter, 0>();
+}
+hal::can_extended_identifier_filter& can_extended_identifier_filter1()
+{
+  return get_filter<extended_identifier_filter, 1>();
+}
+hal::can_extended_identifier_filter& can_extended_identifier_filter2()
+{
+  return get_filter<extended_identifier_filter, 2>();
+}
+hal::can_extended_identifier_filter& can_extended_identifier_filter3()
+{
+  return get_filter<extended_identifier_filter, 3>();
+}
+hal::can_extended_identifier_filter& can_extended_identifier_filter4()
+{
+  return get_filter<extended_identifier_filter, 4>();
+}
+hal::can_extended_identifier_filter& can_extended_identifier_filter5()
+{
+  return get_filter<extended_identifier_filter, 5>();
+}
+hal::can_extended_identifier_filter& can_extended_identifier_filter6()
+{
+  return get_filter<extended_identifier_filter, 6>();
+}
+hal::can_extended_identifier_filter& can_extended_identifier_filter7()
+{
+  return get_filter<extended_identifier_filter, 7>();
+}
+
+hal::can_extended_mask_filter& can_extended_mask_filter0()
+{
+  return get_filter<extended_mask_filter, 0>();
+}
+hal::can_extended_mask_filter& can_extended_mask_filter1()
+{
+  return get_filter<extended_mask_filter, 1>();
+}
+hal::can_extended_mask_filter& can_extended_mask_filter2()
+{
+  return get_filter<extended_mask_filter, 2>();
+}
+hal::can_extended_mask_filter& can_extended_mask_filter3()
+{
+  return get_filter<extended_mask_filter, 3>();
+}
+hal::can_extended_mask_filter& can_extended_mask_filter4()
+{
+  return get_filter<extended_mask_filter, 4>();
+}
+hal::can_extended_mask_filter& can_extended_mask_filter5()
+{
+  return get_filter<extended_mask_filter, 5>();
+}
+hal::can_extended_mask_filter& can_extended_mask_filter6()
+{
+  return get_filter<extended_mask_filter, 6>();
+}
+hal::can_extended_mask_filter& can_extended_mask_filter7()
+{
+  return get_filter<extended_mask_filter, 7>();
+}
+
+hal::can_extended_range_filter& can_extended_range_filter0()
+{
+  return get_filter<extended_range_filter, 0>();
+}
+hal::can_extended_range_filter& can_extended_range_filter1()
+{
+  return get_filter<extended_range_filter, 1>();
+}
+hal::can_extended_range_filter& can_extended_range_filter2()
+{
+  return get_filter<extended_range_filter, 2>();
+}
+hal::can_extended_range_filter& can_extended_range_filter3()
+{
+  return get_filter<extended_range_filter, 3>();
+}
+hal::can_extended_range_filter& can_extended_range_filter4()
+{
+  return get_filter<extended_range_filter, 4>();
+}
+hal::can_extended_range_filter& can_extended_range_filter5()
+{
+  return get_filter<extended_range_filter, 5>();
+}
+hal::can_extended_range_filter& can_extended_range_filter6()
+{
+  return get_filter<extended_range_filter, 6>();
+}
+hal::can_extended_range_filter& can_extended_range_filter7()
+{
+  return get_filter<extended_range_filter, 7>();
+}
+}  // namespace hal::micromod::v1
@@ -1,12 +1,16 @@
+#include <libhal-micromod/concrete/mod-lpc40-v5.hpp>
 #include <libhal-micromod/micromod.hpp>
 
-#include <libhal-arm-mcu/dwt_counter.hpp>
+#include <array>
+#include <type_traits>
+#include <utility>
+
 #include <libhal-arm-mcu/interrupt.hpp>
-#include <libhal-arm-mcu/lpc40/adc.hpp>
 #include <libhal-arm-mcu/lpc40/can.hpp>
 #include <libhal-arm-mcu/lpc40/clock.hpp>
 #include <libhal-arm-mcu/lpc40/i2c.hpp>
 #include <libhal-arm-mcu/lpc40/input_pin.hpp>
+#include <libhal-arm-mcu/lpc40/interrupt.hpp>
 #include <libhal-arm-mcu/lpc40/interrupt_pin.hpp>
 #include <libhal-arm-mcu/lpc40/output_pin.hpp>
 #include <libhal-arm-mcu/lpc40/pwm.hpp>
@@ -14,63 +18,233 @@
 #include <libhal-arm-mcu/lpc40/uart.hpp>
 #include <libhal-arm-mcu/startup.hpp>
 #include <libhal-arm-mcu/system_control.hpp>
+#include <libhal-arm-mcu/systick_timer.hpp>
 #include <libhal-util/enum.hpp>
 
+#include "board_driver.hpp"
+#include "compensated_clock.hpp"
+#include "interrupt_lock.hpp"
+#include "lpc40/burst_adc.hpp"
+#include "lpc40/can.hpp"
+#include "lpc40/dma_dac.hpp"
+#include "lpc40/dma_console.hpp"
+#include "lpc40/sleep_timer.hpp"
+
 namespace hal::micromod::v1 {
 
+namespace {
+/// Size of the console's transmit ring buffer
+constexpr std::size_t console_transmit_size = 1024;
+hal::micromod::overflow_policy console_policy =
+  hal::micromod::overflow_policy::block;
+hal::micromod::ring_console* active_console = nullptr;
+
+hal::micromod::compensated_clock make_uptime_clock()
+{
+  auto const cpu_frequency =
+    hal::lpc40::get_frequency(hal::lpc40::peripheral::cpu);
+  return hal::micromod::compensated_clock(cpu_frequency);
+}
+
+hal::micromod::lpc40::sleep_timer make_sleep_timer()
+{
+  // The sleep timer's periodic interrupt keeps the uptime clock's 64-bit
+  // extension up to date, so the clock must exist first.
+  auto& clock = board_driver<make_uptime_clock>();
+  return hal::micromod::lpc40::sleep_timer(
+    hal::lpc40::get_frequency(hal::lpc40::peripheral::cpu),
+    [&clock]() { clock.sample(); });
+}
+
+hal::lpc40::output_pin make_led()
+{
+  return hal::lpc40::output_pin(1, 10);
+}
+
+hal::cortex_m::systick_timer make_system_timer()
+{
+  hal::lpc40::initialize_interrupts();
+  return hal::cortex_m::systick_timer(
+    hal::lpc40::get_frequency(hal::lpc40::peripheral::cpu));
+}
+}  // namespace
+
 void initialize_platform()
 {
   using namespace hal::literals;
   constexpr hertz crystal_frequency = 12.0_MHz;
   hal::lpc40::maximum(crystal_frequency);
+  // Always started here, as the uptime clock relies on the sleep timer to
+  // track its 32-bit cycle counter wrapping.
+  emplace_driver<make_uptime_clock>();
+  emplace_driver<make_sleep_timer>();
+#if defined(LIBHAL_MICROMOD_EAGER_INIT)
+  emplace_driver<make_led>();
+#endif
 }
 
 hal::steady_clock& uptime_clock()
 {
-  auto const cpu_frequency =
-    hal::lpc40::get_frequency(hal::lpc40::peripheral::cpu);
-  static hal::cortex_m::dwt_counter steady_clock(cpu_frequency);
-  return steady_clock;
+  return board_driver<make_uptime_clock>();
+}
+
+hal::timer& system_timer()
+{
+  return lazy_driver<make_system_timer>();
+}
+
+hal::micromod::timer_wheel& system_timer_wheel()
+{
+  using namespace std::chrono_literals;
+  // SysTick's 24-bit counter limits a single delay to ~140ms at 120MHz
+  constexpr auto maximum_delay = 100ms;
+  static interrupt_lock lock;
+  static hal::micromod::timer_wheel wheel(
+    uptime_clock(), system_timer(), lock, 1ms, maximum_delay);
+  return wheel;
+}
+
+void enter_power_saving_mode()
+{
+  // Any pending timeout has the system timer scheduled to wake the core
+  auto& sleep_timer = board_driver<make_sleep_timer>();
+  board_driver<make_uptime_clock>().sleep(sleep_timer);
+}
+
+sleep_statistics power_saving_statistics()
+{
+  return board_driver<make_uptime_clock>().statistics();
 }
 
 void reset()
 {
+  if (active_console != nullptr) {
+    // Give the console a moment to send what is still buffered
+    auto& clock = uptime_clock();
+    auto const deadline =
+      clock.uptime() + static_cast<hal::u64>(clock.frequency() * 0.1f);
+    while (not active_console->idle() && clock.uptime() < deadline) {
+      continue;
+    }
+  }
   hal::cortex_m::reset();
   hal::halt();
 }
 
 hal::serial& console(std::span<hal::byte> p_receive_buffer)
 {
-  static hal::lpc40::uart driver(0, p_receive_buffer, {});
+  static hal::lpc40::uart uart(0, p_receive_buffer, {});
+  static std::array<hal::byte, console_transmit_size> transmit_buffer{};
+  static hal::micromod::lpc40::dma_console driver(
+    uart, transmit_buffer, console_policy);
+  active_console = &driver;
   return driver;
 }
 
+void console_overflow_policy(hal::micromod::overflow_policy p_policy)
+{
+  console_policy = p_policy;
+  if (active_console != nullptr) {
+    active_console->policy(p_policy);
+  }
+}
+
+hal::micromod::transmit_statistics console_statistics()
+{
+  if (active_console == nullptr) {
+    return {};
+  }
+  return active_console->statistics();
+}
+
+hal::lpc40::output_pin& concrete::led()
+{
+  return board_driver<make_led>();
+}
+
 hal::output_pin& led()
 {
-  static hal::lpc40::output_pin driver(1, 10);
+  return concrete::led();
+}
+
+namespace {
+/// Frames in each of the two blocks of the analog stream
+constexpr std::size_t analog_block_frames = 64;
+std::array<hal::u16, 2 * analog_block_frames * hal::micromod::analog_channels>
+  analog_buffer{};
+
+auto& get_burst_adc()
+{
+  static hal::micromod::lpc40::burst_adc adc(
+    hal::lpc40::get_frequency(hal::lpc40::peripheral::cpu), analog_buffer);
+  return adc;
+}
+}  // namespace
+
+hal::micromod::analog_stream& analog_inputs()
+{
+  return get_burst_adc();
+}
+
+hal::micromod::analog_stream_adc& concrete::a0()
+{
+  static hal::micromod::analog_stream_adc driver(
+    get_burst_adc(), hal::micromod::analog_channel::a0);
   return driver;
 }
 
 hal::adc& a0()
 {
-  static hal::lpc40::adc driver(hal::channel<5>);
+  return concrete::a0();
+}
+
+hal::micromod::analog_stream_adc& concrete::a1()
+{
+  static hal::micromod::analog_stream_adc driver(
+    get_burst_adc(), hal::micromod::analog_channel::a1);
   return driver;
 }
 
 hal::adc& a1()
 {
-  static hal::lpc40::adc driver(hal::channel<4>);
+  return concrete::a1();
+}
+
+hal::micromod::analog_stream_adc& concrete::battery()
+{
+  static hal::micromod::analog_stream_adc driver(
+    get_burst_adc(), hal::micromod::analog_channel::battery);
   return driver;
 }
 
 hal::adc& battery()
 {
-  static hal::lpc40::adc driver(hal::channel<2>);
+  return concrete::battery();
+}
+
+hal::dac& d0()
+{
+  static hal::micromod::lpc40::direct_dac driver;
   return driver;
 }
 
+namespace {
+/// Samples in each of the two blocks of the dac stream
+constexpr std::size_t dac_block_samples = 256;
+std::array<hal::u32, 2 * dac_block_samples> dac_buffer{};
+}  // namespace
+
+hal::micromod::dac_stream& d0_stream(hal::hertz p_sample_rate)
+{
+  static hal::micromod::lpc40::dma_dac stream(
+    hal::lpc40::get_frequency(hal::lpc40::peripheral::cpu),
+    dac_buffer,
+    p_sample_rate);
+  return stream;
+}
+
+// The LPC4078 has a single DAC, which d0() drives
 #if 0
-hal::dac& d0();
 hal::dac& d1();
 #endif
 
@@ -86,42 +260,67 @@ hal::pwm& pwm1()
   return driver;
 }
 
-hal::i2c& i2c()
+// The LPC4078's ADC cannot be triggered by PWM1, it runs in burst mode
+#if 0
+hal::micromod::pwm_group& synchronized_pwm();
+#endif
+
+hal::lpc40::i2c& concrete::i2c()
 {
   static hal::lpc40::i2c driver(2);
   return driver;
 }
 
+hal::i2c& i2c()
+{
+  return concrete::i2c();
+}
+
 hal::interrupt_pin& i2c_interrupt_pin()
 {
   static hal::lpc40::interrupt_pin driver(2, 6);
   return driver;
 }
 
-hal::i2c& i2c1()
+hal::lpc40::i2c& concrete::i2c1()
 {
   static hal::lpc40::i2c driver(1);
   return driver;
 }
 
-hal::spi& spi()
+hal::i2c& i2c1()
+{
+  return concrete::i2c1();
+}
+
+hal::lpc40::spi& concrete::spi()
 {
   static hal::lpc40::spi spi0(0);
   return spi0;
 }
 
+hal::spi& spi()
+{
+  return concrete::spi();
+}
+
 hal::output_pin& spi_cs()
 {
   static hal::lpc40::output_pin driver(1, 8);
   return driver;
 }
 
-hal::spi& spi1()
+hal::lpc40::spi& concrete::spi1()
 {
   static hal::lpc40::spi spi2(2);
   return spi2;
 }
 
+hal::spi& spi1()
+{
+  return concrete::spi1();
+}
+
 hal::output_pin& spi1_cs()
 {
   static hal::lpc40::output_pin driver(0, 16);
@@ -146,6 +345,389 @@ hal::can& can()
   return driver;
 }
 
+// =============================================================================
+//
+// CAN BUS
+//
+// =============================================================================
+
+namespace {
+using hal::micromod::lpc40::can_filter_settings;
+
+hal::micromod::lpc40::can_controller* active_can_controller = nullptr;
+
+auto& get_can_controller()
+{
+  static hal::micromod::lpc40::can_controller controller(100'000,
+                                                         uptime_clock());
+  active_can_controller = &controller;
+  return controller;
+}
+
+class lpc40_can_transceiver final : public hal::can_transceiver
+{
+private:
+  hal::u32 driver_baud_rate() override
+  {
+    return get_can_controller().baud_rate();
+  }
+
+  void driver_send(hal::can_message const& p_message) override
+  {
+    get_can_controller().send(p_message);
+  }
+
+  std::span<hal::can_message const> driver_receive_buffer() override
+  {
+    return get_can_controller().receive_buffer();
+  }
+
+  std::size_t driver_receive_cursor() override
+  {
+    return get_can_controller().receive_cursor();
+  }
+};
+
+class lpc40_can_bus_manager final : public hal::can_bus_manager
+{
+private:
+  void driver_baud_rate(hal::u32 p_hertz) override
+  {
+    get_can_controller().baud_rate(p_hertz);
+  }
+
+  void driver_filter_mode(accept p_accept) override
+  {
+    get_can_controller().filter_mode(p_accept);
+  }
+
+  void driver_on_bus_off(optional_bus_off_handler& p_callback) override
+  {
+    get_can_controller().on_bus_off(p_callback);
+  }
+
+  void driver_bus_on() override
+  {
+    get_can_controller().bus_on();
+  }
+};
+
+class lpc40_can_interrupt final : public hal::can_interrupt
+{
+private:
+  void driver_on_receive(optional_receive_handler const& p_callback) override
+  {
+    get_can_controller().on_receive(p_callback);
+  }
+};
+
+/**
+ * @brief Filter driver that stores its setting in the can controller's filter
+ * settings & reprograms the acceptance filter
+ *
+ * @tparam interface_t - hal filter interface to implement
+ * @tparam value_t - type of the value passed to allow()
+ * @tparam table - pointer to the can_filter_settings member holding the
+ * filters
+ */
+template<class interface_t, class value_t, auto table>
+class can_filter final : public interface_t
+{
+public:
+  can_filter(std::size_t p_index)
+    : m_index(p_index)
+  {
+  }
+
+private:
+  void driver_allow(std::optional<value_t> p_value) override
+  {
+    get_can_controller().update_filters(
+      [this, &p_value](can_filter_settings& p_settings) {
+        (p_settings.*table)[m_index] = p_value;
+      });
+  }
+
+  std::size_t m_index;
+};
+
+using identifier_filter = can_filter<hal::can_identifier_filter,
+                                     hal::u16,
+                                     &can_filter_settings::identifiers>;
+using mask_filter = can_filter<hal::can_mask_filter,
+                               hal::can_mask_filter::pair,
+                               &can_filter_settings::masks>;
+using range_filter = can_filter<hal::can_range_filter,
+                                hal::can_range_filter::pair,
+                                &can_filter_settings::ranges>;
+using extended_identifier_filter =
+  can_filter<hal::can_extended_identifier_filter,
+             hal::u32,
+             &can_filter_settings::extended_identifiers>;
+using extended_mask_filter =
+  can_filter<hal::can_extended_mask_filter,
+             hal::can_extended_mask_filter::pair,
+             &can_filter_settings::extended_masks>;
+using extended_range_filter =
+  can_filter<hal::can_extended_range_filter,
+             hal::can_extended_range_filter::pair,
+             &can_filter_settings::extended_ranges>;
+
+template<class filter_t, std::size_t index>
+filter_t& get_can_filter()
+{
+  static filter_t filter(index);
+  return filter;
+}
+}  // namespace
+
+hal::can_transceiver& can_transceiver(std::span<can_message> p_receive_buffer)
+{
+  static lpc40_can_transceiver transceiver = [p_receive_buffer]() {
+    get_can_controller().receive_buffer(p_receive_buffer);
+    return lpc40_can_transceiver{};
+  }();
+  return transceiver;
+}
+
+hal::can_bus_manager& can_bus_manager()
+{
+  static lpc40_can_bus_manager bus_manager;
+  return bus_manager;
+}
+
+hal::can_interrupt& can_interrupt()
+{
+  static lpc40_can_interrupt interrupt;
+  return interrupt;
+}
+
+hal::micromod::can_transmit_statistics can_transmit_queue_statistics()
+{
+  // Messages are handed straight to the controller, there is no queue
+  return {};
+}
+
+hal::micromod::can_bus_statistics can_statistics()
+{
+  hal::micromod::can_bus_statistics statistics{};
+  if (active_can_controller != nullptr) {
+    statistics = active_can_controller->statistics();
+  }
+  statistics.timestamp = uptime_clock().uptime();
+  return statistics;
+}
+
+hal::u64 can_receive_timestamp()
+{
+  // The controller has no timestamp capture
+  return uptime_clock().uptime();
+}
+
+void can_on_transmit(
+  hal::micromod::optional_can_transmit_handler const& p_handler)
+{
+  get_can_controller().on_transmit(p_handler);
+}
+
+hal::can_identifier_filter& can_identifier_filter0()
+{
+  return get_can_filter<identifier_filter, 0>();
+}
+hal::can_identifier_filter& can_identifier_filter1()
+{
+  return get_can_filter<identifier_filter, 1>();
+}
+hal::can_identifier_filter& can_identifier_filter2()
+{
+  return get_can_filter<identifier_filter, 2>();
+}
+hal::can_identifier_filter& can_identifier_filter3()
+{
+  return get_can_filter<identifier_filter, 3>();
+}
+hal::can_identifier_filter& can_identifier_filter4()
+{
+  return get_can_filter<identifier_filter, 4>();
+}
+hal::can_identifier_filter& can_identifier_filter5()
+{
+  return get_can_filter<identifier_filter, 5>();
+}
+hal::can_identifier_filter& can_identifier_filter6()
+{
+  return get_can_filter<identifier_filter, 6>();
+}
+hal::can_identifier_filter& can_identifier_filter7()
+{
+  return get_can_filter<identifier_filter, 7>();
+}
+
+hal::can_mask_filter& can_mask_filter0()
+{
+  return get_can_filter<mask_filter, 0>();
+}
+hal::can_mask_filter& can_mask_filter1()
+{
+  return get_can_filter<mask_filter, 1>();
+}
+hal::can_mask_filter& can_mask_filter2()
+{
+  return get_can_filter<mask_filter, 2>();
+}
+hal::can_mask_filter& can_mask_filter3()
+{
+  return get_can_filter<mask_filter, 3>();
+}
+hal::can_mask_filter& can_mask_filter4()
+{
+  return get_can_filter<mask_filter, 4>();
+}
+hal::can_mask_filter& can_mask_filter5()
+{
+  return get_can_filter<mask_filter, 5>();
+}
+hal::can_mask_filter& can_mask_filter6()
+{
+  return get_can_filter<mask_filter, 6>();
+}
+hal::can_mask_filter& can_mask_filter7()
+{
+  return get_can_filter<mask_filter, 7>();
+}
+
+hal::can_range_filter& can_range_filter0()
+{
+  return get_can_filter<range_filter, 0>();
+}
+hal::can_range_filter& can_range_filter1()
+{
+  return get_can_filter<range_filter, 1>();
+}
+hal::can_range_filter& can_range_filter2()
+{
+  return get_can_filter<range_filter, 2>();
+}
+hal::can_range_filter& can_range_filter3()
+{
+  return get_can_filter<range_filter, 3>();
+}
+hal::can_range_filter& can_range_filter4()
+{
+  return get_can_filter<range_filter, 4>();
+}
+hal::can_range_filter& can_range_filter5()
+{
+  return get_can_filter<range_filter, 5>();
+}
+hal::can_range_filter& can_range_filter6()
+{
+  return get_can_filter<range_filter, 6>();
+}
+hal::can_range_filter& can_range_filter7()
+{
+  return get_can_filter<range_filter, 7>();
+}
+
+hal::can_extended_identifier_filter& can_extended_identifier_filter0()
+{
+  return get_can_filter<extended_identifier_filter, 0>();
+}
+hal::can_extended_identifier_filter& can_extended_identifier_filter1()
+{
+  return get_can_filter<extended_identifier_filter, 1>();
+}
+hal::can_extended_identifier_filter& can_extended_identifier_filter2()
+{
+  return get_can_filter<extended_identifier_filter, 2>();
+}
+hal::can_extended_identifier_filter& can_extended_identifier_filter3()
+{
+  return get_can_filter<extended_identifier_filter, 3>();
+}
+hal::can_extended_identifier_filter& can_extended_identifier_filter4()
+{
+  return get_can_filter<extended_identifier_filter, 4>();
+}
+hal::can_extended_identifier_filter& can_extended_identifier_filter5()
+{
+  return get_can_filter<extended_identifier_filter, 5>();
+}
+hal::can_extended_identifier_filter& can_extended_identifier_filter6()
+{
+  return get_can_filter<extended_identifier_filter, 6>();
+}
+hal::can_extended_identifier_filter& can_extended_identifier_filter7()
+{
+  return get_can_filter<extended_identifier_filter, 7>();
+}
+
+hal::can_extended_mask_filter& can_extended_mask_filter0()
+{
+  return get_can_filter<extended_mask_filter, 0>();
+}
+hal::can_extended_mask_filter& can_extended_mask_filter1()
+{
+  return get_can_filter<extended_mask_filter, 1>();
+}
+hal::can_extended_mask_filter& can_extended_mask_filter2()
+{
+  return get_can_filter<extended_mask_filter, 2>();
+}
+hal::can_extended_mask_filter& can_extended_mask_filter3()
+{
+  return get_can_filter<extended_mask_filter, 3>();
+}
+hal::can_extended_mask_filter& can_extended_mask_filter4()
+{
+  return get_can_filter<extended_mask_filter, 4>();
+}
+hal::can_extended_mask_filter& can_extended_mask_filter5()
+{
+  return get_can_filter<extended_mask_filter, 5>();
+}
+hal::can_extended_mask_filter& can_extended_mask_filter6()
+{
+  return get_can_filter<extended_mask_filter, 6>();
+}
+hal::can_extended_mask_filter& can_extended_mask_filter7()
+{
+  return get_can_filter<extended_mask_filter, 7>();
+}
+
+hal::can_extended_range_filter& can_extended_range_filter0()
+{
+  return get_can_filter<extended_range_filter, 0>();
+}
+hal::can_extended_range_filter& can_extended_range_filter1()
+{
+  return get_can_filter<extended_range_filter, 1>();
+}
+hal::can_extended_range_filter& can_extended_range_filter2()
+{
+  return get_can_filter<extended_range_filter, 2>();
+}
+hal::can_extended_range_filter& can_extended_range_filter3()
+{
+  return get_can_filter<extended_range_filter, 3>();
+}
+hal::can_extended_range_filter& can_extended_range_filter4()
+{
+  return get_can_filter<extended_range_filter, 4>();
+}
+hal::can_extended_range_filter& can_extended_range_filter5()
+{
+  return get_can_filter<extended_range_filter, 5>();
+}
+hal::can_extended_range_filter& can_extended_range_filter6()
+{
+  return get_can_filter<extended_range_filter, 6>();
+}
+hal::can_extended_range_filter& can_extended_range_filter7()
+{
+  return get_can_filter<extended_range_filter, 7>();
+}
+
 struct pin_map
 {
   std::uint8_t port;
@@ -186,107 +768,231 @@ constexpr pin_map get_pin_map()
   }
 }
 
+/// Number of G pins that can be constructed ahead of time, see eager_driver
+constexpr std::uint8_t eager_gpio_count = 11;
+
 template<class gpio_t, std::uint8_t gpio_pin>
-gpio_t& gpio()
+gpio_t make_gpio()
 {
   constexpr auto pin = get_pin_map<gpio_pin>();
-  static gpio_t driver(pin.port, pin.pin);
-  return driver;
+  return gpio_t(pin.port, pin.pin);
 }
 
-hal::output_pin& output_g0()
+template<class gpio_t, std::uint8_t gpio_pin>
+gpio_t& gpio()
+{
+  if constexpr (std::is_same_v<gpio_t, hal::lpc40::interrupt_pin> ||
+                gpio_pin >= eager_gpio_count) {
+    return lazy_driver<make_gpio<gpio_t, gpio_pin>>();
+  } else {
+    return board_driver<make_gpio<gpio_t, gpio_pin>>();
+  }
+}
+
+template<class gpio_t, std::uint8_t... gpio_pins>
+void emplace_gpio(std::uint8_t p_gpio_pin,
+                  std::integer_sequence<std::uint8_t, gpio_pins...>)
+{
+  static_cast<void>(
+    ((p_gpio_pin == gpio_pins &&
+      (emplace_driver<make_gpio<gpio_t, gpio_pins>>(), true)) ||
+     ...));
+}
+
+void initialize_driver(eager_driver p_driver)
+{
+  constexpr auto gpio_pins =
+    std::make_integer_sequence<std::uint8_t, eager_gpio_count>();
+  auto const driver = hal::value(p_driver);
+  auto const first_input = hal::value(eager_driver::input_g0);
+  if (driver < first_input) {
+    emplace_gpio<hal::lpc40::output_pin>(driver, gpio_pins);
+  } else {
+    emplace_gpio<hal::lpc40::input_pin>(driver - first_input, gpio_pins);
+  }
+}
+
+hal::lpc40::output_pin& concrete::output_g0()
 {
   return gpio<hal::lpc40::output_pin, 0>();
 }
-hal::output_pin& output_g1()
+hal::output_pin& output_g0()
+{
+  return concrete::output_g0();
+}
+hal::lpc40::output_pin& concrete::output_g1()
 {
   return gpio<hal::lpc40::output_pin, 1>();
 }
-hal::output_pin& output_g2()
+hal::output_pin& output_g1()
+{
+  return concrete::output_g1();
+}
+hal::lpc40::output_pin& concrete::output_g2()
 {
   return gpio<hal::lpc40::output_pin, 2>();
 }
-hal::output_pin& output_g3()
+hal::output_pin& output_g2()
+{
+  return concrete::output_g2();
+}
+hal::lpc40::output_pin& concrete::output_g3()
 {
   return gpio<hal::lpc40::output_pin, 3>();
 }
-hal::output_pin& output_g4()
+hal::output_pin& output_g3()
+{
+  return concrete::output_g3();
+}
+hal::lpc40::output_pin& concrete::output_g4()
 {
   return gpio<hal::lpc40::output_pin, 4>();
 }
-hal::output_pin& output_g5()
+hal::output_pin& output_g4()
+{
+  return concrete::output_g4();
+}
+hal::lpc40::output_pin& concrete::output_g5()
 {
   return gpio<hal::lpc40::output_pin, 5>();
 }
-hal::output_pin& output_g6()
+hal::output_pin& output_g5()
+{
+  return concrete::output_g5();
+}
+hal::lpc40::output_pin& concrete::output_g6()
 {
   return gpio<hal::lpc40::output_pin, 6>();
 }
-hal::output_pin& output_g7()
+hal::output_pin& output_g6()
+{
+  return concrete::output_g6();
+}
+hal::lpc40::output_pin& concrete::output_g7()
 {
   return gpio<hal::lpc40::output_pin, 7>();
 }
-hal::output_pin& output_g8()
+hal::output_pin& output_g7()
+{
+  return concrete::output_g7();
+}
+hal::lpc40::output_pin& concrete::output_g8()
 {
   return gpio<hal::lpc40::output_pin, 8>();
 }
-hal::output_pin& output_g9()
+hal::output_pin& output_g8()
+{
+  return concrete::output_g8();
+}
+hal::lpc40::output_pin& concrete::output_g9()
 {
   return gpio<hal::lpc40::output_pin, 9>();
 }
-hal::output_pin& output_g10()
+hal::output_pin& output_g9()
+{
+  return concrete::output_g9();
+}
+hal::lpc40::output_pin& concrete::output_g10()
 {
   return gpio<hal::lpc40::output_pin, 10>();
 }
+hal::output_pin& output_g10()
+{
+  return concrete::output_g10();
+}
 hal::output_pin& output_g11()
 {
   return gpio<hal::lpc40::output_pin, 11>();
 }
 
-hal::input_pin& input_g0()
+hal::lpc40::input_pin& concrete::input_g0()
 {
   return gpio<hal::lpc40::input_pin, 0>();
 }
-hal::input_pin& input_g1()
+hal::input_pin& input_g0()
+{
+  return concrete::input_g0();
+}
+hal::lpc40::input_pin& concrete::input_g1()
 {
   return gpio<hal::lpc40::input_pin, 1>();
 }
-hal::input_pin& input_g2()
+hal::input_pin& input_g1()
+{
+  return concrete::input_g1();
+}
+hal::lpc40::input_pin& concrete::input_g2()
 {
   return gpio<hal::lpc40::input_pin, 2>();
 }
-hal::input_pin& input_g3()
+hal::input_pin& input_g2()
+{
+  return concrete::input_g2();
+}
+hal::lpc40::input_pin& concrete::input_g3()
 {
   return gpio<hal::lpc40::input_pin, 3>();
 }
-hal::input_pin& input_g4()
+hal::input_pin& input_g3()
+{
+  return concrete::input_g3();
+}
+hal::lpc40::input_pin& concrete::input_g4()
 {
   return gpio<hal::lpc40::input_pin, 4>();
 }
-hal::input_pin& input_g5()
+hal::input_pin& input_g4()
+{
+  return concrete::input_g4();
+}
+hal::lpc40::input_pin& concrete::input_g5()
 {
   return gpio<hal::lpc40::input_pin, 5>();
 }
-hal::input_pin& input_g6()
+hal::input_pin& input_g5()
+{
+  return concrete::input_g5();
+}
+hal::lpc40::input_pin& concrete::input_g6()
 {
   return gpio<hal::lpc40::input_pin, 6>();
 }
-hal::input_pin& input_g7()
+hal::input_pin& input_g6()
+{
+  return concrete::input_g6();
+}
+hal::lpc40::input_pin& concrete::input_g7()
 {
   return gpio<hal::lpc40::input_pin, 7>();
 }
-hal::input_pin& input_g8()
+hal::input_pin& input_g7()
+{
+  return concrete::input_g7();
+}
+hal::lpc40::input_pin& concrete::input_g8()
 {
   return gpio<hal::lpc40::input_pin, 8>();
 }
-hal::input_pin& input_g9()
+hal::input_pin& input_g8()
+{
+  return concrete::input_g8();
+}
+hal::lpc40::input_pin& concrete::input_g9()
 {
   return gpio<hal::lpc40::input_pin, 9>();
 }
-hal::input_pin& input_g10()
+hal::input_pin& input_g9()
+{
+  return concrete::input_g9();
+}
+hal::lpc40::input_pin& concrete::input_g10()
 {
   return gpio<hal::lpc40::input_pin, 10>();
 }
+hal::input_pin& input_g10()
+{
+  return concrete::input_g10();
+}
 hal::input_pin& input_g11()
 {
   return gpio<hal::lpc40::input_pin, 11>();
@@ -1,54 +1,173 @@
+#include <libhal-micromod/concrete/mod-stm32f1.hpp>
 #include <libhal-micromod/micromod.hpp>
 
-#include <libhal-arm-mcu/dwt_counter.hpp>
+#include <array>
+#include <utility>
+
 #include <libhal-arm-mcu/interrupt.hpp>
 #include <libhal-arm-mcu/startup.hpp>
-#include <libhal-arm-mcu/stm32f1/adc.hpp>
 #include <libhal-arm-mcu/stm32f1/can.hpp>
 #include <libhal-arm-mcu/stm32f1/clock.hpp>
 #include <libhal-arm-mcu/stm32f1/input_pin.hpp>
+#include <libhal-arm-mcu/stm32f1/interrupt.hpp>
 #include <libhal-arm-mcu/stm32f1/output_pin.hpp>
 #include <libhal-arm-mcu/stm32f1/pin.hpp>
 #include <libhal-arm-mcu/stm32f1/uart.hpp>
 #include <libhal-arm-mcu/system_control.hpp>
-#include <libhal-util/atomic_spin_lock.hpp>
-#include <libhal-util/bit_bang_i2c.hpp>
-#include <libhal-util/bit_bang_spi.hpp>
+#include <libhal-arm-mcu/systick_timer.hpp>
 #include <libhal-util/enum.hpp>
+#include <libhal/error.hpp>
+
+#include "board_driver.hpp"
+#include "compensated_clock.hpp"
+#include "interrupt_lock.hpp"
+#include "stm32f1/bit_bang.hpp"
+#include "stm32f1/center_aligned_pwm.hpp"
+#include "stm32f1/can_timestamps.hpp"
+#include "stm32f1/can_transmitter.hpp"
+#include "stm32f1/dma_console.hpp"
+#include "stm32f1/dma_spi.hpp"
+#include "stm32f1/i2c.hpp"
+#include "stm32f1/registers.hpp"
+#include "stm32f1/scan_adc.hpp"
+#include "stm32f1/sleep_timer.hpp"
+#include "stm32f1/timer_pwm.hpp"
 
 namespace hal::micromod::v1 {
 
+namespace {
+/// Size of the console's transmit ring buffer
+constexpr std::size_t console_transmit_size = 512;
+hal::micromod::overflow_policy console_policy =
+  hal::micromod::overflow_policy::block;
+hal::micromod::ring_console* active_console = nullptr;
+
+hal::micromod::compensated_clock make_uptime_clock()
+{
+  return hal::micromod::compensated_clock(
+    hal::stm32f1::frequency(hal::stm32f1::peripheral::cpu));
+}
+
+hal::micromod::stm32f1::sleep_timer make_sleep_timer()
+{
+  // The sleep timer's periodic interrupt keeps the uptime clock's 64-bit
+  // extension up to date, so the clock must exist first.
+  auto& clock = board_driver<make_uptime_clock>();
+  return hal::micromod::stm32f1::sleep_timer(
+    hal::stm32f1::frequency(hal::stm32f1::peripheral::cpu),
+    [&clock]() { clock.sample(); });
+}
+
+hal::stm32f1::output_pin make_led()
+{
+  return hal::stm32f1::output_pin('C', 13);
+}
+
+hal::cortex_m::systick_timer make_system_timer()
+{
+  hal::stm32f1::initialize_interrupts();
+  return hal::cortex_m::systick_timer(
+    hal::stm32f1::frequency(hal::stm32f1::peripheral::cpu));
+}
+}  // namespace
+
 void initialize_platform()
 {
   using namespace hal::literals;
   hal::stm32f1::maximum_speed_using_internal_oscillator();
+  // Always started here, as the uptime clock relies on the sleep timer to
+  // track its 32-bit cycle counter wrapping.
+  emplace_driver<make_uptime_clock>();
+  emplace_driver<make_sleep_timer>();
+#if defined(LIBHAL_MICROMOD_EAGER_INIT)
+  emplace_driver<make_led>();
+#endif
 }
 
 hal::steady_clock& uptime_clock()
 {
-  static hal::cortex_m::dwt_counter steady_clock(
-    hal::stm32f1::frequency(hal::stm32f1::peripheral::cpu));
-  return steady_clock;
+  return board_driver<make_uptime_clock>();
+}
+
+hal::timer& system_timer()
+{
+  return lazy_driver<make_system_timer>();
+}
+
+hal::micromod::timer_wheel& system_timer_wheel()
+{
+  using namespace std::chrono_literals;
+  // SysTick's 24-bit counter limits a single delay to ~260ms at 64MHz
+  constexpr auto maximum_delay = 100ms;
+  static interrupt_lock lock;
+  static hal::micromod::timer_wheel wheel(
+    uptime_clock(), system_timer(), lock, 1ms, maximum_delay);
+  return wheel;
+}
+
+void enter_power_saving_mode()
+{
+  // Any pending timeout has the system timer scheduled to wake the core
+  auto& sleep_timer = board_driver<make_sleep_timer>();
+  board_driver<make_uptime_clock>().sleep(sleep_timer);
+}
+
+sleep_statistics power_saving_statistics()
+{
+  return board_driver<make_uptime_clock>().statistics();
 }
 
 void reset()
 {
+  if (active_console != nullptr) {
+    // Give the console a moment to send what is still buffered
+    auto& clock = uptime_clock();
+    auto const deadline =
+      clock.uptime() + static_cast<hal::u64>(clock.frequency() * 0.1f);
+    while (not active_console->idle() && clock.uptime() < deadline) {
+      continue;
+    }
+  }
   hal::cortex_m::reset();
   hal::halt();
 }
 
+hal::stm32f1::output_pin& concrete::led()
+{
+  return board_driver<make_led>();
+}
+
 hal::output_pin& led()
 {
-  static hal::stm32f1::output_pin driver('C', 13);
-  return driver;
+  return concrete::led();
 }
 
 hal::serial& console(std::span<hal::byte> p_receive_buffer)
 {
-  static hal::stm32f1::uart driver(hal::runtime{}, 1, p_receive_buffer, {});
+  static hal::stm32f1::uart uart(hal::runtime{}, 1, p_receive_buffer, {});
+  static std::array<hal::byte, console_transmit_size> transmit_buffer{};
+  static hal::micromod::stm32f1::dma_console driver(
+    uart, transmit_buffer, console_policy);
+  active_console = &driver;
   return driver;
 }
 
+void console_overflow_policy(hal::micromod::overflow_policy p_policy)
+{
+  console_policy = p_policy;
+  if (active_console != nullptr) {
+    active_console->policy(p_policy);
+  }
+}
+
+hal::micromod::transmit_statistics console_statistics()
+{
+  if (active_console == nullptr) {
+    return {};
+  }
+  return active_console->statistics();
+}
+
 hal::can& can()
 {
   static hal::stm32f1::can driver({}, hal::stm32f1::can_pins::pb9_pb8);
@@ -90,120 +209,379 @@ constexpr pin_map get_pin_map()
 }
 
 template<class gpio_t, std::uint8_t gpio_pin>
-gpio_t& gpio()
+gpio_t make_gpio()
 {
   constexpr auto pin = get_pin_map<gpio_pin>();
-  static gpio_t driver(pin.port, pin.pin);
-  return driver;
+  return gpio_t(pin.port, pin.pin);
 }
 
-hal::output_pin& output_g0()
+template<class gpio_t, std::uint8_t gpio_pin>
+gpio_t& gpio()
+{
+  return board_driver<make_gpio<gpio_t, gpio_pin>>();
+}
+
+template<class gpio_t, std::uint8_t... gpio_pins>
+void emplace_gpio(std::uint8_t p_gpio_pin,
+                  std::integer_sequence<std::uint8_t, gpio_pins...>)
+{
+  static_cast<void>(
+    ((p_gpio_pin == gpio_pins &&
+      (emplace_driver<make_gpio<gpio_t, gpio_pins>>(), true)) ||
+     ...));
+}
+
+void initialize_driver(eager_driver p_driver)
+{
+  constexpr auto gpio_pins = std::make_integer_sequence<std::uint8_t, 9>();
+  auto const driver = hal::value(p_driver);
+  auto const first_input = hal::value(eager_driver::input_g0);
+  if (driver < first_input) {
+    emplace_gpio<hal::stm32f1::output_pin>(driver, gpio_pins);
+  } else {
+    emplace_gpio<hal::stm32f1::input_pin>(driver - first_input, gpio_pins);
+  }
+}
+
+hal::stm32f1::output_pin& concrete::output_g0()
 {
   return gpio<hal::stm32f1::output_pin, 0>();
 }
-hal::output_pin& output_g1()
+hal::output_pin& output_g0()
+{
+  return concrete::output_g0();
+}
+hal::stm32f1::output_pin& concrete::output_g1()
 {
   hal::stm32f1::release_jtag_pins();
   return gpio<hal::stm32f1::output_pin, 1>();
 }
-hal::output_pin& output_g2()
+hal::output_pin& output_g1()
+{
+  return concrete::output_g1();
+}
+hal::stm32f1::output_pin& concrete::output_g2()
 {
   hal::stm32f1::release_jtag_pins();
   return gpio<hal::stm32f1::output_pin, 2>();
 }
-hal::output_pin& output_g3()
+hal::output_pin& output_g2()
+{
+  return concrete::output_g2();
+}
+hal::stm32f1::output_pin& concrete::output_g3()
 {
   hal::stm32f1::release_jtag_pins();
   return gpio<hal::stm32f1::output_pin, 3>();
 }
-hal::output_pin& output_g4()
+hal::output_pin& output_g3()
+{
+  return concrete::output_g3();
+}
+hal::stm32f1::output_pin& concrete::output_g4()
 {
   return gpio<hal::stm32f1::output_pin, 4>();
 }
-hal::output_pin& output_g5()
+hal::output_pin& output_g4()
+{
+  return concrete::output_g4();
+}
+hal::stm32f1::output_pin& concrete::output_g5()
 {
   return gpio<hal::stm32f1::output_pin, 5>();
 }
-hal::output_pin& output_g6()
+hal::output_pin& output_g5()
+{
+  return concrete::output_g5();
+}
+hal::stm32f1::output_pin& concrete::output_g6()
 {
   return gpio<hal::stm32f1::output_pin, 6>();
 }
-hal::output_pin& output_g7()
+hal::output_pin& output_g6()
+{
+  return concrete::output_g6();
+}
+hal::stm32f1::output_pin& concrete::output_g7()
 {
   return gpio<hal::stm32f1::output_pin, 7>();
 }
-hal::output_pin& output_g8()
+hal::output_pin& output_g7()
+{
+  return concrete::output_g7();
+}
+hal::stm32f1::output_pin& concrete::output_g8()
 {
   return gpio<hal::stm32f1::output_pin, 8>();
 }
+hal::output_pin& output_g8()
+{
+  return concrete::output_g8();
+}
 
-hal::input_pin& input_g0()
+hal::stm32f1::input_pin& concrete::input_g0()
 {
   return gpio<hal::stm32f1::input_pin, 0>();
 }
-hal::input_pin& input_g1()
+hal::input_pin& input_g0()
+{
+  return concrete::input_g0();
+}
+hal::stm32f1::input_pin& concrete::input_g1()
 {
   return gpio<hal::stm32f1::input_pin, 1>();
 }
-hal::input_pin& input_g2()
+hal::input_pin& input_g1()
+{
+  return concrete::input_g1();
+}
+hal::stm32f1::input_pin& concrete::input_g2()
 {
   return gpio<hal::stm32f1::input_pin, 2>();
 }
-hal::input_pin& input_g3()
+hal::input_pin& input_g2()
+{
+  return concrete::input_g2();
+}
+hal::stm32f1::input_pin& concrete::input_g3()
 {
   return gpio<hal::stm32f1::input_pin, 3>();
 }
-hal::input_pin& input_g4()
+hal::input_pin& input_g3()
+{
+  return concrete::input_g3();
+}
+hal::stm32f1::input_pin& concrete::input_g4()
 {
   return gpio<hal::stm32f1::input_pin, 4>();
 }
-hal::input_pin& input_g5()
+hal::input_pin& input_g4()
+{
+  return concrete::input_g4();
+}
+hal::stm32f1::input_pin& concrete::input_g5()
 {
   return gpio<hal::stm32f1::input_pin, 5>();
 }
-hal::input_pin& input_g6()
+hal::input_pin& input_g5()
+{
+  return concrete::input_g5();
+}
+hal::stm32f1::input_pin& concrete::input_g6()
 {
   return gpio<hal::stm32f1::input_pin, 6>();
 }
-hal::input_pin& input_g7()
+hal::input_pin& input_g6()
+{
+  return concrete::input_g6();
+}
+hal::stm32f1::input_pin& concrete::input_g7()
 {
   return gpio<hal::stm32f1::input_pin, 7>();
 }
-hal::input_pin& input_g8()
+hal::input_pin& input_g7()
+{
+  return concrete::input_g7();
+}
+hal::stm32f1::input_pin& concrete::input_g8()
 {
   return gpio<hal::stm32f1::input_pin, 8>();
 }
+hal::input_pin& input_g8()
+{
+  return concrete::input_g8();
+}
+
+namespace {
+/// Frames in each of the two blocks of the analog stream
+constexpr std::size_t analog_block_frames = 64;
+std::array<hal::u16, 2 * analog_block_frames * hal::micromod::analog_channels>
+  analog_buffer{};
+
+auto& get_scan_adc()
+{
+  static stm32f1::scan_adc adc(
+    hal::stm32f1::frequency(hal::stm32f1::peripheral::cpu), analog_buffer);
+  return adc;
+}
+}  // namespace
+
+hal::micromod::analog_stream& analog_inputs()
+{
+  return get_scan_adc();
+}
 
 hal::adc& a0()
 {
-  static hal::atomic_spin_lock adc_lock;
-  static hal::stm32f1::adc<hal::stm32f1::peripheral::adc1> adc(adc_lock);
-  static auto driver = adc.acquire_channel(hal::stm32f1::adc_pins::pb0);
+  static hal::micromod::analog_stream_adc driver(
+    get_scan_adc(), hal::micromod::analog_channel::a0);
   return driver;
 }
 
 hal::adc& a1()
 {
-  static hal::atomic_spin_lock adc_lock;
-  static hal::stm32f1::adc<hal::stm32f1::peripheral::adc1> adc(adc_lock);
-  static auto driver = adc.acquire_channel(hal::stm32f1::adc_pins::pb1);
+  static hal::micromod::analog_stream_adc driver(
+    get_scan_adc(), hal::micromod::analog_channel::a1);
   return driver;
 }
 
-hal::spi& spi()
+// BATT_VIN/3 is not routed to an ADC pin on this board, the battery slot of
+// analog_inputs() samples the internal reference instead
+#if 0
+hal::adc& battery();
+#endif
+
+namespace {
+/// Drivers TIM1 & TIM2 may be given to, one kind or the other
+enum class pwm_timers_user : std::uint8_t
+{
+  none,
+  outputs,
+  group,
+};
+
+pwm_timers_user pwm_timers = pwm_timers_user::none;
+
+/// Give TIM1 & TIM2 to p_user, unless the other kind of driver has them
+void take_pwm_timers(pwm_timers_user p_user)
+{
+  if (pwm_timers != pwm_timers_user::none && pwm_timers != p_user) {
+    hal::safe_throw(hal::device_or_resource_busy(nullptr));
+  }
+  pwm_timers = p_user;
+}
+
+hal::micromod::stm32f1::pwm_timer make_pwm_timer1()
+{
+  stm32f1::rcc->apb2enr = stm32f1::rcc->apb2enr | stm32f1::rcc_enable::timer1;
+  return stm32f1::pwm_timer(
+    *stm32f1::timer1,
+    stm32f1::timer_clock_frequency(
+      hal::stm32f1::frequency(hal::stm32f1::peripheral::cpu), true),
+    true);
+}
+
+hal::micromod::stm32f1::pwm_timer make_pwm_timer2()
+{
+  stm32f1::rcc->apb1enr = stm32f1::rcc->apb1enr | stm32f1::rcc_enable::timer2;
+  return stm32f1::pwm_timer(
+    *stm32f1::timer2,
+    stm32f1::timer_clock_frequency(
+      hal::stm32f1::frequency(hal::stm32f1::peripheral::cpu), false),
+    false);
+}
+
+hal::micromod::stm32f1::timer_pwm make_pwm0()
+{
+  take_pwm_timers(pwm_timers_user::outputs);
+  // PA8 is TIM1_CH1
+  stm32f1::connect_timer_output('A', 8);
+  return stm32f1::timer_pwm(lazy_driver<make_pwm_timer1>(), 1);
+}
+
+hal::micromod::stm32f1::timer_pwm make_pwm1()
+{
+  take_pwm_timers(pwm_timers_user::outputs);
+  // PA1 is TIM2_CH2
+  stm32f1::connect_timer_output('A', 1);
+  return stm32f1::timer_pwm(lazy_driver<make_pwm_timer2>(), 2);
+}
+}  // namespace
+
+// PWM0 & PWM1 are on different timers, so each has a frequency of its own
+hal::pwm& pwm0()
+{
+  return lazy_driver<make_pwm0>();
+}
+
+hal::pwm& pwm1()
+{
+  return lazy_driver<make_pwm1>();
+}
+
+namespace {
+hal::micromod::stm32f1::center_aligned_pwm* active_synchronized_pwm = nullptr;
+
+void adc1_2_handler()
+{
+  if (active_synchronized_pwm != nullptr) {
+    active_synchronized_pwm->handle_interrupt();
+  }
+}
+
+hal::micromod::stm32f1::center_aligned_pwm make_synchronized_pwm()
+{
+  take_pwm_timers(pwm_timers_user::group);
+  constexpr hal::cortex_m::irq_t adc1_2_irq = 18;
+  static interrupt_lock lock;
+  auto const cpu = hal::stm32f1::frequency(hal::stm32f1::peripheral::cpu);
+  stm32f1::rcc->apb2enr = stm32f1::rcc->apb2enr | stm32f1::rcc_enable::timer1;
+  stm32f1::rcc->apb1enr = stm32f1::rcc->apb1enr | stm32f1::rcc_enable::timer2;
+  stm32f1::power_on_adc2(cpu);
+  // The pins of pwm0 & pwm1
+  stm32f1::connect_timer_output('A', 8);
+  stm32f1::connect_timer_output('A', 1);
+  hal::stm32f1::initialize_interrupts();
+  hal::cortex_m::enable_interrupt(adc1_2_irq, adc1_2_handler);
+  // TIM1 on APB2 & TIM2 on APB1 both run at the cpu clock
+  return stm32f1::center_aligned_pwm(*stm32f1::timer1,
+                                     *stm32f1::timer2,
+                                     *stm32f1::adc2,
+                                     stm32f1::timer_clock_frequency(cpu, true),
+                                     lock);
+}
+}  // namespace
+
+hal::micromod::pwm_group& synchronized_pwm()
+{
+  auto& driver = lazy_driver<make_synchronized_pwm>();
+  active_synchronized_pwm = &driver;
+  return driver;
+}
+
+namespace {
+hal::micromod::stm32f1::dma_spi* active_spi = nullptr;
+
+void dma1_channel6_handler()
+{
+  if (active_spi != nullptr) {
+    active_spi->handle_interrupt();
+  }
+}
+
+hal::micromod::stm32f1::dma_spi make_spi()
 {
+  constexpr hal::cortex_m::irq_t dma1_channel6_irq = 16;
+  // PA6 & PA7 are SPI1's MISO & MOSI pins, but the board routes them to the
+  // opposite MicroMod SDO & SDI signals, so the SPI1 peripheral cannot be used.
+  // The pins are driven by DMA instead.
   static hal::stm32f1::output_pin sck('A', 5);
   static hal::stm32f1::output_pin copi('A', 6);
   static hal::stm32f1::input_pin cipo('A', 7);
-  static hal::bit_bang_spi bit_bang_spi(
-    hal::bit_bang_spi::pins{
-      .sck = &sck,
-      .copi = &copi,
-      .cipo = &cipo,
-    },
-    uptime_clock());
+  auto const cpu = hal::stm32f1::frequency(hal::stm32f1::peripheral::cpu);
+  stm32f1::rcc->ahbenr = stm32f1::rcc->ahbenr | stm32f1::rcc_enable::dma1;
+  stm32f1::rcc->apb1enr = stm32f1::rcc->apb1enr | stm32f1::rcc_enable::timer3;
+  hal::stm32f1::initialize_interrupts();
+  hal::cortex_m::enable_interrupt(dma1_channel6_irq, dma1_channel6_handler);
+  return stm32f1::dma_spi(*stm32f1::dma1,
+                          *stm32f1::timer3,
+                          *stm32f1::gpio('A'),
+                          stm32f1::dma_spi::pins{
+                            .sck = 5,
+                            .copi = 6,
+                            .cipo = 7,
+                          },
+                          uptime_clock(),
+                          stm32f1::timer_clock_frequency(cpu, false),
+                          {});
+}
+}  // namespace
 
-  return bit_bang_spi;
+hal::spi& spi()
+{
+  auto& driver = lazy_driver<make_spi>();
+  active_spi = &driver;
+  return driver;
 }
 
 hal::output_pin& spi_chip_select()
@@ -212,18 +590,85 @@ hal::output_pin& spi_chip_select()
   return chip_select_pin;
 }
 
-hal::i2c& i2c()
+hal::spi& spi1()
+{
+  // The MicroMod SPI1 pins are not routed on this board, so spi1 is bit-banged
+  // on G5 (SCK), G7 (COPI) & G6 (CIPO), which are the SPI2 pins of the MCU.
+  constexpr auto sck = get_pin_map<5>();
+  constexpr auto copi = get_pin_map<7>();
+  constexpr auto cipo = get_pin_map<6>();
+  // The bus is timed with the DWT cycle counter started by the uptime clock
+  static_cast<void>(uptime_clock());
+  static hal::stm32f1::output_pin sck_pin(sck.port, sck.pin);
+  static hal::stm32f1::output_pin copi_pin(copi.port, copi.pin);
+  static hal::stm32f1::input_pin cipo_pin(cipo.port, cipo.pin);
+  static stm32f1::fast_bit_bang_spi<sck, copi, cipo> driver(
+    hal::stm32f1::frequency(hal::stm32f1::peripheral::cpu), {});
+  return driver;
+}
+
+hal::i2c& i2c1()
 {
-  static hal::stm32f1::output_pin sda_output_pin('B', 7);
-  static hal::stm32f1::output_pin scl_output_pin('B', 6);
-  static hal::bit_bang_i2c bit_bang_i2c(
-    hal::bit_bang_i2c::pins{
-      .sda = &sda_output_pin,
-      .scl = &scl_output_pin,
-    },
-    uptime_clock());
+  // The MicroMod I2C_SDA1 & I2C_SCL1 pins are not routed on this board, so
+  // i2c1 is bit-banged on G2 (SCL) & G3 (SDA).
+  hal::stm32f1::release_jtag_pins();
+  constexpr auto scl = get_pin_map<2>();
+  constexpr auto sda = get_pin_map<3>();
+  constexpr hal::output_pin::settings open_drain = {
+    .resistor = hal::pin_resistor::pull_up,
+    .open_drain = true,
+  };
+  static_cast<void>(uptime_clock());
+  static hal::stm32f1::output_pin scl_pin(scl.port, scl.pin, open_drain);
+  static hal::stm32f1::output_pin sda_pin(sda.port, sda.pin, open_drain);
+  static stm32f1::fast_bit_bang_i2c<sda, scl> driver(
+    hal::stm32f1::frequency(hal::stm32f1::peripheral::cpu), {});
+  return driver;
+}
+
+namespace {
+hal::micromod::stm32f1::i2c* active_i2c = nullptr;
+
+void i2c1_event_handler()
+{
+  if (active_i2c != nullptr) {
+    active_i2c->handle_event();
+  }
+}
+
+void i2c1_error_handler()
+{
+  if (active_i2c != nullptr) {
+    active_i2c->handle_error();
+  }
+}
+
+hal::micromod::stm32f1::i2c make_i2c()
+{
+  using namespace std::chrono_literals;
+  constexpr hal::cortex_m::irq_t i2c1_event_irq = 31;
+  constexpr hal::cortex_m::irq_t i2c1_error_irq = 32;
+  // Matches the SMBus clock low timeout
+  constexpr auto clock_stretch_timeout = 25ms;
+  auto const cpu = hal::stm32f1::frequency(hal::stm32f1::peripheral::cpu);
+  hal::stm32f1::initialize_interrupts();
+  hal::cortex_m::enable_interrupt(i2c1_event_irq, i2c1_event_handler);
+  hal::cortex_m::enable_interrupt(i2c1_error_irq, i2c1_error_handler);
+  return stm32f1::i2c(*stm32f1::i2c1,
+                      *stm32f1::rcc,
+                      *stm32f1::gpio('B'),
+                      uptime_clock(),
+                      stm32f1::apb_clock_frequency(cpu, false),
+                      clock_stretch_timeout,
+                      {});
+}
+}  // namespace
 
-  return bit_bang_i2c;
+hal::i2c& i2c()
+{
+  auto& driver = lazy_driver<make_i2c>();
+  active_i2c = &driver;
+  return driver;
 }
 
 // =============================================================================
@@ -241,6 +686,184 @@ auto& get_can_peripheral()
   return can;
 }
 
+/// Messages the CAN transmit queue holds, including those in mailboxes
+constexpr std::size_t can_transmit_queue_size = 16;
+hal::micromod::stm32f1::can_transmitter* active_can_transmitter = nullptr;
+hal::micromod::can_traffic_counter can_traffic;
+bool can_counting = false;
+
+/**
+ * @brief Count a receive FIFO overrun seen since the last check
+ *
+ * The overrun flag stays set until cleared, so overruns between two checks
+ * count once.
+ */
+void check_receive_overflow()
+{
+  if (stm32f1::can1->rf0r & stm32f1::can_bits::fifo_overrun) {
+    // Writing zero to the other flags leaves them & the FIFO unchanged
+    stm32f1::can1->rf0r = stm32f1::can_bits::fifo_overrun;
+    can_traffic.receive_overflow();
+  }
+}
+
+auto& get_can_timestamps()
+{
+  // Runs ahead of the peripheral manager's receive interrupt handler
+  get_can_peripheral();
+  static hal::micromod::stm32f1::can_receive_timestamps timestamps(
+    uptime_clock());
+  return timestamps;
+}
+
+/// Counts each message received, then passes it to the application's handler
+class counted_can_interrupt final : public hal::can_interrupt
+{
+public:
+  explicit counted_can_interrupt(hal::can_interrupt& p_interrupt)
+  {
+    p_interrupt.on_receive(
+      [this](on_receive_tag p_tag, hal::can_message const& p_message) {
+        can_traffic.received(p_message);
+        check_receive_overflow();
+        if (m_handler) {
+          (*m_handler)(p_tag, p_message);
+        }
+      });
+  }
+
+private:
+  void driver_on_receive(optional_receive_handler const& p_handler) override
+  {
+    std::lock_guard lock(m_lock);
+    m_handler = p_handler;
+  }
+
+  interrupt_lock m_lock;
+  optional_receive_handler m_handler;
+};
+
+/// Counts bus off events, forwards everything else to the peripheral manager
+class counted_can_bus_manager final : public hal::can_bus_manager
+{
+public:
+  explicit counted_can_bus_manager(hal::can_bus_manager& p_manager)
+    : m_manager(&p_manager)
+  {
+    m_manager->on_bus_off(m_counting_handler);
+  }
+
+private:
+  void driver_baud_rate(hal::u32 p_hertz) override
+  {
+    m_manager->baud_rate(p_hertz);
+    get_can_timestamps().bit_timing_changed();
+    if (active_can_transmitter != nullptr) {
+      active_can_transmitter->bit_timing_changed(
+        get_can_timestamps().ticks_per_bit());
+    }
+  }
+
+  void driver_filter_mode(accept p_accept) override
+  {
+    m_manager->filter_mode(p_accept);
+  }
+
+  void driver_on_bus_off(optional_bus_off_handler& p_handler) override
+  {
+    std::lock_guard lock(m_lock);
+    m_handler = p_handler;
+  }
+
+  void driver_bus_on() override
+  {
+    m_manager->bus_on();
+  }
+
+  hal::can_bus_manager* m_manager;
+  interrupt_lock m_lock;
+  optional_bus_off_handler m_handler;
+  optional_bus_off_handler m_counting_handler = [this](bus_off_tag p_tag) {
+    can_traffic.bus_off();
+    if (m_handler) {
+      (*m_handler)(p_tag);
+    }
+  };
+};
+
+counted_can_interrupt& get_can_interrupt()
+{
+  static auto interrupt = get_can_peripheral().acquire_interrupt();
+  static counted_can_interrupt counted(interrupt);
+  return counted;
+}
+
+counted_can_bus_manager& get_can_bus_manager()
+{
+  static auto bus_manager = get_can_peripheral().acquire_bus_manager();
+  static counted_can_bus_manager counted(bus_manager);
+  return counted;
+}
+
+/// Count & timestamp the bus' traffic from its first use, with or without
+/// handlers
+void start_can_monitoring()
+{
+  get_can_interrupt();
+  get_can_bus_manager();
+  // After the accessors above, as acquiring may install the peripheral
+  // manager's receive handler again
+  get_can_timestamps().hook();
+  can_counting = true;
+}
+
+auto& get_can_transmitter()
+{
+  // The peripheral manager powers up & configures the controller, the
+  // timestamps switch on the start of frame capture of the mailboxes
+  auto& timestamps = get_can_timestamps();
+  static interrupt_lock lock;
+  static std::array<hal::micromod::can_queued_message, can_transmit_queue_size>
+    storage{};
+  static hal::micromod::stm32f1::can_transmitter transmitter(
+    storage, uptime_clock(), lock, can_traffic, timestamps.ticks_per_bit());
+  active_can_transmitter = &transmitter;
+  return transmitter;
+}
+
+/// Receives through the peripheral manager, sends through the priority queue
+class queued_can_transceiver final : public hal::can_transceiver
+{
+public:
+  explicit queued_can_transceiver(hal::can_transceiver& p_receiver)
+    : m_receiver(&p_receiver)
+  {
+  }
+
+private:
+  hal::u32 driver_baud_rate() override
+  {
+    return m_receiver->baud_rate();
+  }
+
+  void driver_send(hal::can_message const& p_message) override
+  {
+    get_can_transmitter().send(p_message);
+  }
+
+  std::span<hal::can_message const> driver_receive_buffer() override
+  {
+    return m_receiver->receive_buffer();
+  }
+
+  std::size_t driver_receive_cursor() override
+  {
+    return m_receiver->receive_cursor();
+  }
+
+  hal::can_transceiver* m_receiver;
+};
+
 template<hal::u8 set_number>
 auto& get_identifier_filter_set()
 {
@@ -273,21 +896,70 @@ auto& get_extended_mask()
 
 hal::can_transceiver& can_transceiver(std::span<can_message> p_receive_buffer)
 {
-  static auto transceiver =
+  static auto receiver =
     get_can_peripheral().acquire_transceiver(p_receive_buffer);
+  static queued_can_transceiver transceiver(receiver);
+  start_can_monitoring();
   return transceiver;
 }
 
 hal::can_bus_manager& can_bus_manager()
 {
-  static auto bus_manager = get_can_peripheral().acquire_bus_manager();
-  return bus_manager;
+  start_can_monitoring();
+  return get_can_bus_manager();
 }
 
 hal::can_interrupt& can_interrupt()
 {
-  static auto interrupt = get_can_peripheral().acquire_interrupt();
-  return interrupt;
+  start_can_monitoring();
+  return get_can_interrupt();
+}
+
+hal::micromod::can_transmit_statistics can_transmit_queue_statistics()
+{
+  if (active_can_transmitter == nullptr) {
+    return {};
+  }
+  return active_can_transmitter->statistics();
+}
+
+hal::micromod::can_bus_statistics can_statistics()
+{
+  hal::micromod::can_bus_statistics statistics{};
+  if (can_counting) {
+    {
+      // The receive interrupt also checks & clears the overrun flag
+      interrupt_lock lock;
+      std::lock_guard guard(lock);
+      check_receive_overflow();
+    }
+    can_traffic.read(statistics);
+    auto const errors = stm32f1::can1->esr;
+    statistics.transmit_errors =
+      static_cast<hal::u8>(stm32f1::can_bits::transmit_error_count(errors));
+    statistics.receive_errors =
+      static_cast<hal::u8>(stm32f1::can_bits::receive_error_count(errors));
+    auto const timing = stm32f1::can1->btr;
+    auto const can_clock = stm32f1::apb_clock_frequency(
+      hal::stm32f1::frequency(hal::stm32f1::peripheral::cpu), false);
+    auto const clocks_per_bit = stm32f1::can_bits::prescaler(timing) *
+                                stm32f1::can_bits::quanta_per_bit(timing);
+    statistics.baud_rate = static_cast<hal::u32>(
+      can_clock / static_cast<float>(clocks_per_bit));
+  }
+  statistics.timestamp = uptime_clock().uptime();
+  return statistics;
+}
+
+hal::u64 can_receive_timestamp()
+{
+  return get_can_timestamps().latest();
+}
+
+void can_on_transmit(
+  hal::micromod::optional_can_transmit_handler const& p_handler)
+{
+  get_can_transmitter().on_transmit(p_handler);
 }
 
 hal::can_identifier_filter& can_identifier_filter0()
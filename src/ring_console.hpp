@@ -0,0 +1,160 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <span>
+
+#include <libhal-micromod/transmit_ring.hpp>
+#include <libhal/serial.hpp>
+#include <libhal/units.hpp>
+
+#include "interrupt_lock.hpp"
+
+namespace hal::micromod {
+/**
+ * @brief Serial port whose writes are queued in a transmit_ring & sent by DMA
+ *
+ * write() copies the data into the ring, starts a DMA transfer if none is
+ * running and returns without waiting for the data to be sent. Reading,
+ * configuration & flush are forwarded to the wrapped serial port, which keeps
+ * handling reception.
+ *
+ * The platform derived class starts DMA transfers in start_transmit() and calls
+ * transmit_complete() from the DMA interrupt once a transfer is done.
+ */
+class ring_console : public hal::serial
+{
+public:
+  /**
+   * @brief Construct a new ring console object
+   *
+   * @param p_serial - serial port to receive with & to configure
+   * @param p_buffer - transmit ring storage, must outlive the console
+   * @param p_policy - what write() does when the ring is full
+   */
+  ring_console(hal::serial& p_serial,
+               std::span<hal::byte> p_buffer,
+               overflow_policy p_policy)
+    : m_serial(&p_serial)
+    , m_ring(p_buffer, m_lock, p_policy)
+  {
+  }
+
+  ring_console(ring_console const&) = delete;
+  ring_console& operator=(ring_console const&) = delete;
+  ring_console(ring_console&&) = delete;
+  ring_console& operator=(ring_console&&) = delete;
+  ~ring_console() override = default;
+
+  /**
+   * @brief Change what write() does when the ring is full
+   *
+   * @param p_policy - overflow policy
+   */
+  void policy(overflow_policy p_policy)
+  {
+    m_ring.policy(p_policy);
+  }
+
+  /**
+   * @brief Get the transmit ring's counters
+   *
+   * @return transmit_statistics - counters since construction
+   */
+  [[nodiscard]] transmit_statistics statistics()
+  {
+    return m_ring.statistics();
+  }
+
+  /**
+   * @brief Determine if every byte written has been handed to the DMA
+   *
+   * @return true - the transmit ring is empty
+   */
+  [[nodiscard]] bool idle()
+  {
+    return m_ring.size() == 0;
+  }
+
+protected:
+  /// Call from the DMA interrupt once the last started transfer is done
+  void transmit_complete()
+  {
+    m_ring.release();
+    m_transmitting = false;
+    start_next();
+  }
+
+private:
+  /// Start transmitting the data, only called with no transfer running
+  virtual void start_transmit(std::span<hal::byte const> p_data) = 0;
+  /// Re-enable the serial port's DMA requests after it has been configured
+  virtual void serial_configured() = 0;
+
+  void start_next()
+  {
+    auto const data = m_ring.claim();
+    if (data.empty()) {
+      return;
+    }
+    m_transmitting = true;
+    start_transmit(data);
+  }
+
+  void driver_configure(settings const& p_settings) override
+  {
+    m_serial->configure(p_settings);
+    serial_configured();
+  }
+
+  write_t driver_write(std::span<hal::byte const> p_data) override
+  {
+    std::size_t handled = 0;
+    while (true) {
+      handled += m_ring.write(p_data.subspan(handled));
+      {
+        std::lock_guard lock(m_lock);
+        if (not m_transmitting) {
+          start_next();
+        }
+      }
+      // Only a blocking policy leaves data unhandled, wait for the transfer
+      // to free up space.
+      if (handled == p_data.size()) {
+        break;
+      }
+    }
+    // Dropped bytes count as written, they were handled by the policy
+    return { .data = p_data };
+  }
+
+  read_t driver_read(std::span<hal::byte> p_data) override
+  {
+    return m_serial->read(p_data);
+  }
+
+  void driver_flush() override
+  {
+    m_serial->flush();
+  }
+
+  hal::serial* m_serial;
+  interrupt_lock m_lock{};
+  transmit_ring m_ring;
+  bool m_transmitting = false;
+};
+}  // namespace hal::micromod
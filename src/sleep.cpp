@@ -0,0 +1,63 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/micromod.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace hal::micromod::v1 {
+namespace {
+hal::u64 to_ticks(hal::time_duration p_duration, hal::hertz p_frequency)
+{
+  auto const nanoseconds = std::max<hal::time_duration::rep>(
+    p_duration.count(), 0);
+  return static_cast<hal::u64>(
+    std::ceil(static_cast<double>(nanoseconds) * p_frequency / 1e9));
+}
+
+hal::time_duration to_duration(hal::u64 p_ticks, hal::hertz p_frequency)
+{
+  auto const nanoseconds =
+    std::ceil(static_cast<double>(p_ticks) * 1e9 / p_frequency);
+  return hal::time_duration(static_cast<hal::time_duration::rep>(nanoseconds));
+}
+}  // namespace
+
+void sleep_until(hal::u64 p_uptime)
+{
+  auto& clock = uptime_clock();
+  auto& wheel = system_timer_wheel();
+  auto const frequency = clock.frequency();
+  // Only wakes the processor, the deadline is checked against the clock
+  hal::micromod::timeout wake_up([]() {});
+
+  while (true) {
+    auto const now = clock.uptime();
+    if (now >= p_uptime) {
+      break;
+    }
+    if (not wake_up.is_pending()) {
+      wheel.schedule(wake_up, to_duration(p_uptime - now, frequency));
+    }
+    enter_power_saving_mode();
+  }
+}
+
+void sleep_for(hal::time_duration p_duration)
+{
+  auto& clock = uptime_clock();
+  sleep_until(clock.uptime() + to_ticks(p_duration, clock.frequency()));
+}
+}  // namespace hal::micromod::v1
@@ -0,0 +1,385 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+
+#include <libhal/error.hpp>
+#include <libhal/i2c.hpp>
+#include <libhal/spi.hpp>
+#include <libhal/units.hpp>
+
+#include "registers.hpp"
+
+/**
+ * @brief Bit-bang protocol engines specialized at compile time for their pins
+ *
+ * Unlike hal::bit_bang_spi and hal::bit_bang_i2c, which toggle pins through
+ * virtual hal::output_pin calls and time each half period by polling a
+ * hal::steady_clock, these engines write the GPIO BSRR/BRR registers directly
+ * and time edges against the DWT cycle counter. The port & pin are template
+ * parameters taken from the board's pin_map, so every pin access compiles
+ * down to a single store or load.
+ *
+ * Edges are scheduled against absolute cycle counts, so the loop overhead is
+ * absorbed into the half period rather than added to it. The DWT cycle counter
+ * must be running, which is the case once uptime_clock() has been constructed.
+ *
+ * The pins & cycle counter are reached through an io_t template parameter,
+ * register_io on the boards. A host test substitutes a model with the same
+ * members to record the edges an engine produces.
+ */
+namespace hal::micromod::stm32f1 {
+/**
+ * @brief Single GPIO pin accessed through its port registers
+ *
+ * @tparam pin - pin_map like object with `port` and `pin` members
+ */
+template<auto pin>
+struct fast_pin
+{
+  static constexpr std::uint32_t mask = 1U << pin.pin;
+
+  static void high()
+  {
+    gpio(pin.port)->bsrr = mask;
+  }
+
+  static void low()
+  {
+    gpio(pin.port)->brr = mask;
+  }
+
+  static void level(bool p_high)
+  {
+    gpio(pin.port)->bsrr = p_high ? mask : (mask << 16U);
+  }
+
+  static bool level()
+  {
+    return gpio(pin.port)->idr & mask;
+  }
+};
+
+/**
+ * @brief Pin & cycle counter access of the engines on the STM32F1
+ *
+ * An io_t provides:
+ *
+ *   - `template<auto pin> pin_t` - type with the static members of fast_pin
+ *   - `static std::uint32_t cycle_count()` - free running cpu cycle counter
+ */
+struct register_io
+{
+  template<auto pin>
+  using pin_t = fast_pin<pin>;
+
+  /// DWT cycle counter
+  static std::uint32_t cycle_count()
+  {
+    return *reinterpret_cast<std::uint32_t volatile*>(0xE000'1004);
+  }
+};
+
+/**
+ * @brief Schedules edges at a fixed number of cpu cycles apart
+ *
+ * @tparam io_t - provides the cycle counter, see register_io
+ */
+template<class io_t>
+class edge_timer
+{
+public:
+  void half_period(std::uint32_t p_cycles)
+  {
+    m_half_period = p_cycles;
+  }
+
+  /// Restart the schedule from the current cycle count
+  void restart()
+  {
+    m_last_edge = io_t::cycle_count();
+  }
+
+  /// Wait until one half period after the previous edge
+  void wait()
+  {
+    m_last_edge += m_half_period;
+    while (static_cast<std::int32_t>(io_t::cycle_count() - m_last_edge) < 0) {
+      continue;
+    }
+  }
+
+private:
+  std::uint32_t m_half_period = 0;
+  std::uint32_t m_last_edge = 0;
+};
+
+/**
+ * @brief Compute the cpu cycles per half period of a bus clock
+ *
+ * @param p_cpu_frequency - frequency of the cpu
+ * @param p_clock_rate - requested bus clock rate
+ * @return std::uint32_t - cycles per half period, at least 1
+ */
+inline std::uint32_t half_period_cycles(hal::hertz p_cpu_frequency,
+                                        hal::hertz p_clock_rate)
+{
+  if (p_clock_rate <= 0.0f) {
+    return 1;
+  }
+  auto const cycles = p_cpu_frequency / (2.0f * p_clock_rate);
+  return std::max<std::uint32_t>(static_cast<std::uint32_t>(cycles), 1);
+}
+
+/**
+ * @brief SPI controller bit-banged through the GPIO registers
+ *
+ * The pins must already be configured, sck & copi as push-pull outputs and cipo
+ * as an input.
+ *
+ * @tparam sck - pin map of the serial clock pin
+ * @tparam copi - pin map of the controller out, peripheral in pin
+ * @tparam cipo - pin map of the controller in, peripheral out pin
+ * @tparam io_t - pin & cycle counter access, see register_io
+ */
+template<auto sck, auto copi, auto cipo, class io_t = register_io>
+class fast_bit_bang_spi final : public hal::spi
+{
+public:
+  fast_bit_bang_spi(hal::hertz p_cpu_frequency, settings const& p_settings)
+    : m_cpu_frequency(p_cpu_frequency)
+  {
+    driver_configure(p_settings);
+  }
+
+private:
+  using sck_pin = typename io_t::template pin_t<sck>;
+  using copi_pin = typename io_t::template pin_t<copi>;
+  using cipo_pin = typename io_t::template pin_t<cipo>;
+
+  void driver_configure(settings const& p_settings) override
+  {
+    m_settings = p_settings;
+    m_timer.half_period(
+      half_period_cycles(m_cpu_frequency, p_settings.clock_rate));
+    sck_pin::level(m_settings.clock_idles_high);
+  }
+
+  template<bool trailing_edge>
+  hal::byte transfer_byte(hal::byte p_byte)
+  {
+    auto const idle = m_settings.clock_idles_high;
+    hal::byte received = 0;
+
+    for (int bit = 7; bit >= 0; bit--) {
+      auto const high = static_cast<bool>((p_byte >> bit) & 1U);
+      if constexpr (trailing_edge) {
+        // Data changes on the leading edge, sampled on the trailing edge
+        sck_pin::level(not idle);
+        copi_pin::level(high);
+        m_timer.wait();
+        sck_pin::level(idle);
+        received = static_cast<hal::byte>(received << 1U) | cipo_pin::level();
+        m_timer.wait();
+      } else {
+        // Data is set up before the leading edge and sampled on it
+        copi_pin::level(high);
+        m_timer.wait();
+        sck_pin::level(not idle);
+        received = static_cast<hal::byte>(received << 1U) | cipo_pin::level();
+        m_timer.wait();
+        sck_pin::level(idle);
+      }
+    }
+
+    return received;
+  }
+
+  void driver_transfer(std::span<hal::byte const> p_data_out,
+                       std::span<hal::byte> p_data_in,
+                       hal::byte p_filler) override
+  {
+    auto const length = std::max(p_data_out.size(), p_data_in.size());
+    m_timer.restart();
+
+    for (std::size_t i = 0; i < length; i++) {
+      auto const out = i < p_data_out.size() ? p_data_out[i] : p_filler;
+      auto const in = m_settings.data_valid_on_trailing_edge
+                        ? transfer_byte<true>(out)
+                        : transfer_byte<false>(out);
+      if (i < p_data_in.size()) {
+        p_data_in[i] = in;
+      }
+    }
+  }
+
+  hal::hertz m_cpu_frequency;
+  settings m_settings{};
+  edge_timer<io_t> m_timer{};
+};
+
+/**
+ * @brief I2C controller bit-banged through the GPIO registers
+ *
+ * Both pins must already be configured as open drain outputs, so writing a 1
+ * releases the line and the input register reflects the bus level. Supports
+ * clock stretching by waiting for SCL to be released, calling the
+ * transaction's timeout function while it waits.
+ *
+ * @tparam sda - pin map of the serial data pin
+ * @tparam scl - pin map of the serial clock pin
+ * @tparam io_t - pin & cycle counter access, see register_io
+ */
+template<auto sda, auto scl, class io_t = register_io>
+class fast_bit_bang_i2c final : public hal::i2c
+{
+public:
+  fast_bit_bang_i2c(hal::hertz p_cpu_frequency, settings const& p_settings)
+    : m_cpu_frequency(p_cpu_frequency)
+  {
+    sda_pin::high();
+    scl_pin::high();
+    driver_configure(p_settings);
+  }
+
+private:
+  using sda_pin = typename io_t::template pin_t<sda>;
+  using scl_pin = typename io_t::template pin_t<scl>;
+  using timeout_t = hal::function_ref<hal::timeout_function>;
+
+  void driver_configure(settings const& p_settings) override
+  {
+    m_timer.half_period(
+      half_period_cycles(m_cpu_frequency, p_settings.clock_rate));
+  }
+
+  void release_scl(timeout_t& p_timeout)
+  {
+    scl_pin::high();
+    while (not scl_pin::level()) {
+      // The device is stretching the clock
+      p_timeout();
+    }
+    // Measure the high period from when the clock was actually released
+    m_timer.restart();
+  }
+
+  void start(timeout_t& p_timeout)
+  {
+    sda_pin::high();
+    m_timer.wait();
+    release_scl(p_timeout);
+    m_timer.wait();
+    sda_pin::low();
+    m_timer.wait();
+    scl_pin::low();
+  }
+
+  void stop(timeout_t& p_timeout)
+  {
+    sda_pin::low();
+    m_timer.wait();
+    release_scl(p_timeout);
+    m_timer.wait();
+    sda_pin::high();
+    m_timer.wait();
+  }
+
+  bool read_bit(timeout_t& p_timeout)
+  {
+    sda_pin::high();
+    m_timer.wait();
+    release_scl(p_timeout);
+    m_timer.wait();
+    bool const level = sda_pin::level();
+    scl_pin::low();
+    return level;
+  }
+
+  void write_bit(bool p_high, timeout_t& p_timeout)
+  {
+    sda_pin::level(p_high);
+    m_timer.wait();
+    release_scl(p_timeout);
+    m_timer.wait();
+    scl_pin::low();
+  }
+
+  /// @return true if the byte was acknowledged
+  bool write_byte(hal::byte p_byte, timeout_t& p_timeout)
+  {
+    for (int bit = 7; bit >= 0; bit--) {
+      write_bit((p_byte >> bit) & 1U, p_timeout);
+    }
+    return not read_bit(p_timeout);
+  }
+
+  hal::byte read_byte(bool p_acknowledge, timeout_t& p_timeout)
+  {
+    hal::byte byte = 0;
+    for (int bit = 0; bit < 8; bit++) {
+      byte = static_cast<hal::byte>(byte << 1U) | read_bit(p_timeout);
+    }
+    write_bit(not p_acknowledge, p_timeout);
+    return byte;
+  }
+
+  void driver_transaction(hal::byte p_address,
+                          std::span<hal::byte const> p_data_out,
+                          std::span<hal::byte> p_data_in,
+                          timeout_t p_timeout) override
+  {
+    m_timer.restart();
+
+    if (not p_data_out.empty() || p_data_in.empty()) {
+      start(p_timeout);
+      if (not write_byte(static_cast<hal::byte>(p_address << 1), p_timeout)) {
+        stop(p_timeout);
+        hal::safe_throw(hal::no_such_device(p_address, this));
+      }
+
+      for (auto const byte : p_data_out) {
+        if (not write_byte(byte, p_timeout)) {
+          stop(p_timeout);
+          hal::safe_throw(hal::io_error(this));
+        }
+      }
+    }
+
+    if (not p_data_in.empty()) {
+      // Acts as a repeated start if data was written
+      start(p_timeout);
+      auto const read_address = static_cast<hal::byte>((p_address << 1) | 1);
+      if (not write_byte(read_address, p_timeout)) {
+        stop(p_timeout);
+        hal::safe_throw(hal::no_such_device(p_address, this));
+      }
+
+      for (std::size_t i = 0; i < p_data_in.size(); i++) {
+        // NACK the last byte to signal the end of the read
+        p_data_in[i] = read_byte(i + 1 < p_data_in.size(), p_timeout);
+      }
+    }
+
+    stop(p_timeout);
+  }
+
+  hal::hertz m_cpu_frequency;
+  edge_timer<io_t> m_timer{};
+};
+}  // namespace hal::micromod::stm32f1
@@ -0,0 +1,147 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "can_timestamps.hpp"
+
+#include <cstdint>
+
+#include <libhal-arm-mcu/stm32f1/clock.hpp>
+#include <libhal-arm-mcu/stm32f1/interrupt.hpp>
+
+#include "registers.hpp"
+
+namespace hal::micromod::stm32f1 {
+namespace {
+constexpr hal::cortex_m::irq_t can_receive_irq = 20;
+/// Exceptions of the core that precede the interrupts in the vector table
+constexpr std::size_t core_exceptions = 16;
+
+can_receive_timestamps* active_driver = nullptr;
+
+void can_receive_handler()
+{
+  if (active_driver != nullptr) {
+    active_driver->handle_interrupt();
+  }
+}
+
+hal::cortex_m::interrupt_pointer& vector_table_entry(hal::cortex_m::irq_t p_irq)
+{
+  // VTOR, which libhal points at the vector table it copied to RAM
+  auto const vector_table =
+    *reinterpret_cast<std::uint32_t volatile*>(0xE000'ED08);
+  auto* entries =
+    reinterpret_cast<hal::cortex_m::interrupt_pointer*>(vector_table);
+  return entries[core_exceptions + p_irq];
+}
+
+/// Switch time triggered communication mode on, if it is off
+void enable_time_triggered_mode()
+{
+  if (can1->mcr & can_bits::time_triggered_mode) {
+    return;
+  }
+  // Only writable in initialization mode
+  can1->mcr = can1->mcr | can_bits::initialization_request;
+  while ((can1->msr & can_bits::initialization_acknowledge) == 0) {
+    continue;
+  }
+  can1->mcr = can1->mcr | can_bits::time_triggered_mode;
+  can1->mcr = can1->mcr & ~can_bits::initialization_request;
+  // Back on the bus after 11 recessive bits
+  while (can1->msr & can_bits::initialization_acknowledge) {
+    continue;
+  }
+}
+}  // namespace
+
+can_receive_timestamps::can_receive_timestamps(hal::steady_clock& p_clock)
+  : m_clock(&p_clock)
+  , m_extender(ticks_per_bit())
+{
+  enable_time_triggered_mode();
+  active_driver = this;
+  hal::stm32f1::initialize_interrupts();
+  hook();
+}
+
+can_receive_timestamps::~can_receive_timestamps()
+{
+  if (vector_table_entry(can_receive_irq) == can_receive_handler &&
+      m_forward != nullptr) {
+    hal::cortex_m::enable_interrupt(can_receive_irq, m_forward);
+  }
+  active_driver = nullptr;
+}
+
+void can_receive_timestamps::hook()
+{
+  auto const current = vector_table_entry(can_receive_irq);
+  if (current == can_receive_handler) {
+    return;
+  }
+  // Set before the handler is swapped, so it always has one to forward to
+  m_forward = current;
+  hal::cortex_m::enable_interrupt(can_receive_irq, can_receive_handler);
+}
+
+void can_receive_timestamps::bit_timing_changed()
+{
+  enable_time_triggered_mode();
+  m_extender.reset(ticks_per_bit());
+}
+
+hal::u64 can_receive_timestamps::latest() const
+{
+  return m_latest;
+}
+
+void can_receive_timestamps::handle_interrupt()
+{
+  auto const now = m_clock->uptime();
+  if (can1->rf0r & can_bits::fifo_pending_mask) {
+    // The message the peripheral manager is about to read
+    auto const& fifo = can1->receive[0];
+    auto const identifier = fifo.rir;
+    auto const timing = fifo.rdtr;
+    m_latest = m_extender.extend(
+      now,
+      can_bits::capture_time(timing),
+      {
+        .id = 0,
+        .length = static_cast<hal::u8>(timing & can_bits::data_length_mask),
+        .payload = {},
+        .remote_request = (identifier & can_bits::remote_request) != 0,
+        .extended = (identifier & can_bits::extended_identifier) != 0,
+      });
+  }
+  if (m_forward != nullptr) {
+    m_forward();
+  }
+}
+
+hal::u32 can_receive_timestamps::ticks_per_bit() const
+{
+  auto const timing = can1->btr;
+  auto const can_clock = apb_clock_frequency(
+    hal::stm32f1::frequency(hal::stm32f1::peripheral::cpu), false);
+  auto const clocks_per_bit =
+    can_bits::prescaler(timing) * can_bits::quanta_per_bit(timing);
+  // Both clocks run from the cpu clock, so the ratio is a whole number
+  auto const ticks = m_clock->frequency() / can_clock *
+                     static_cast<float>(clocks_per_bit);
+  return static_cast<hal::u32>(ticks + 0.5f);
+}
+}  // namespace hal::micromod::stm32f1
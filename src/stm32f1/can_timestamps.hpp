@@ -0,0 +1,100 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <libhal-arm-mcu/interrupt.hpp>
+#include <libhal-micromod/can_timestamp.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::micromod::stm32f1 {
+/**
+ * @brief Start of frame timestamps of the messages bxCAN receives
+ *
+ * Puts the controller in time triggered communication mode, where it
+ * captures its 16-bit bit time counter at the start of frame of every
+ * message, and runs ahead of the peripheral manager's receive interrupt
+ * (USB_LP_CAN_RX0) to extend the capture of the message in FIFO 0 to uptime
+ * clock ticks with a can_timestamp_extender. The manager's handler then reads
+ * the message & calls the application's receive handler, which gets the
+ * timestamp from latest().
+ *
+ * The libhal-arm-mcu CAN peripheral manager must be constructed first, as
+ * its handler is looked up in the vector table and called from this one.
+ * Only one instance of this driver may exist.
+ */
+class can_receive_timestamps
+{
+public:
+  /**
+   * @brief Construct a new can receive timestamps object
+   *
+   * Briefly takes the controller off the bus to switch time triggered mode
+   * on.
+   *
+   * @param p_clock - uptime clock, running from the cpu clock
+   */
+  explicit can_receive_timestamps(hal::steady_clock& p_clock);
+
+  can_receive_timestamps(can_receive_timestamps const&) = delete;
+  can_receive_timestamps& operator=(can_receive_timestamps const&) = delete;
+  can_receive_timestamps(can_receive_timestamps&&) = delete;
+  can_receive_timestamps& operator=(can_receive_timestamps&&) = delete;
+  ~can_receive_timestamps();
+
+  /**
+   * @brief Run ahead of the receive interrupt handler in the vector table
+   *
+   * Does nothing if already in place. Call again whenever the peripheral
+   * manager may have installed its handler again.
+   */
+  void hook();
+
+  /**
+   * @brief Restart the timestamps after the bit timing changed
+   *
+   * Switches time triggered mode back on if reconfiguring the controller
+   * turned it off.
+   */
+  void bit_timing_changed();
+
+  /**
+   * @brief Get the start of frame of the message being received
+   *
+   * @return hal::u64 - uptime clock ticks at the start of frame of the last
+   * message received
+   */
+  [[nodiscard]] hal::u64 latest() const;
+
+  /**
+   * @brief Get the uptime clock ticks per bit time at the current bit timing
+   *
+   * @return hal::u32 - ticks per bit, rounded to the nearest
+   */
+  [[nodiscard]] hal::u32 ticks_per_bit() const;
+
+  /// Called from the USB_LP_CAN_RX0 interrupt service routine
+  void handle_interrupt();
+
+private:
+
+  hal::steady_clock* m_clock;
+  hal::micromod::can_timestamp_extender m_extender;
+  /// The peripheral manager's receive interrupt handler
+  hal::cortex_m::interrupt_pointer m_forward = nullptr;
+  hal::u64 m_latest = 0;
+};
+}  // namespace hal::micromod::stm32f1
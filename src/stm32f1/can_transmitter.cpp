@@ -0,0 +1,192 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "can_transmitter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <mutex>
+
+#include <libhal-arm-mcu/interrupt.hpp>
+#include <libhal-arm-mcu/stm32f1/interrupt.hpp>
+#include <libhal/error.hpp>
+
+#include "registers.hpp"
+
+namespace hal::micromod::stm32f1 {
+namespace {
+constexpr hal::cortex_m::irq_t can_transmit_irq = 19;
+
+can_transmitter* active_driver = nullptr;
+
+void can_transmit_handler()
+{
+  if (active_driver != nullptr) {
+    active_driver->handle_interrupt();
+  }
+}
+}  // namespace
+
+can_transmitter::can_transmitter(std::span<can_queued_message> p_storage,
+                                 hal::steady_clock& p_clock,
+                                 hal::basic_lock& p_lock,
+                                 hal::micromod::can_traffic_counter& p_traffic,
+                                 hal::u32 p_ticks_per_bit)
+  : can_transmit_queue(p_storage, p_clock, p_lock)
+  , m_clock(&p_clock)
+  , m_lock(&p_lock)
+  , m_traffic(&p_traffic)
+  , m_extender(p_ticks_per_bit)
+{
+  // Send the pending mailbox with the lowest identifier first, rather than
+  // the one loaded first
+  can1->mcr = can1->mcr & ~can_bits::transmit_fifo_priority;
+
+  active_driver = this;
+  hal::stm32f1::initialize_interrupts();
+  hal::cortex_m::enable_interrupt(can_transmit_irq, can_transmit_handler);
+  can1->ier = can1->ier | can_bits::transmit_mailbox_empty_interrupt;
+}
+
+can_transmitter::~can_transmitter()
+{
+  can1->ier = can1->ier & ~can_bits::transmit_mailbox_empty_interrupt;
+  hal::cortex_m::disable_interrupt(can_transmit_irq);
+  active_driver = nullptr;
+}
+
+void can_transmitter::send(hal::can_message const& p_message)
+{
+  // The transmit interrupt frees up room as mailboxes complete
+  while (not push(p_message)) {
+    if (can1->esr & can_bits::bus_off) {
+      hal::safe_throw(hal::io_error(this));
+    }
+  }
+}
+
+void can_transmitter::on_transmit(
+  optional_can_transmit_handler const& p_handler)
+{
+  std::lock_guard guard(*m_lock);
+  m_transmit_handler = p_handler;
+}
+
+void can_transmitter::bit_timing_changed(hal::u32 p_ticks_per_bit)
+{
+  std::lock_guard guard(*m_lock);
+  m_extender.reset(p_ticks_per_bit);
+}
+
+void can_transmitter::handle_interrupt()
+{
+  // First, as close to the end of the frames as possible
+  auto const now = m_clock->uptime();
+  auto const status = can1->tsr;
+  std::array<std::size_t, can_mailbox_count> sent{};
+  std::size_t sent_count = 0;
+  for (std::size_t mailbox = 0; mailbox < can_mailbox_count; mailbox++) {
+    if ((status & can_bits::request_completed(mailbox)) == 0) {
+      continue;
+    }
+    // Clears the mailbox's request completed & status flags
+    can1->tsr = can_bits::request_completed(mailbox);
+    if (status & can_bits::transmission_ok(mailbox)) {
+      sent[sent_count++] = mailbox;
+    } else {
+      mailbox_complete(mailbox, false);
+    }
+  }
+
+  // The timestamps are extended in the order the frames were sent, the
+  // captures of a late interrupt lie within a few frames of each other
+  auto const sent_mailboxes = std::span(sent).first(sent_count);
+  std::ranges::sort(sent_mailboxes, [](std::size_t p_a, std::size_t p_b) {
+    auto const a = can_bits::capture_time(can1->transmit[p_a].tdtr);
+    auto const b = can_bits::capture_time(can1->transmit[p_b].tdtr);
+    return static_cast<std::int16_t>(a - b) < 0;
+  });
+  for (auto const mailbox : sent_mailboxes) {
+    report_transmitted(mailbox, now);
+  }
+  // Only then, as completing a mailbox may load the next message into it
+  for (auto const mailbox : sent_mailboxes) {
+    mailbox_complete(mailbox, true);
+  }
+}
+
+void can_transmitter::report_transmitted(std::size_t p_mailbox,
+                                         hal::u64 p_now)
+{
+  // The mailbox still holds the message sent, & its start of frame capture
+  auto const& mailbox = can1->transmit[p_mailbox];
+  auto const identifier = mailbox.tir;
+  auto const timing = mailbox.tdtr;
+  auto const extended = (identifier & can_bits::extended_identifier) != 0;
+  hal::can_message message{
+    .id = extended ? (identifier >> 3) : (identifier >> 21),
+    .length = static_cast<hal::u8>(
+      std::min<std::uint32_t>(timing & can_bits::data_length_mask, 8)),
+    .payload = {},
+    .remote_request = (identifier & can_bits::remote_request) != 0,
+    .extended = extended,
+  };
+  m_traffic->transmitted(message);
+
+  // Extended even without a handler, so the least latency is known by the
+  // time one is set
+  auto const start_of_frame =
+    m_extender.extend(p_now, can_bits::capture_time(timing), message);
+  if (m_transmit_handler) {
+    auto const low = mailbox.tdlr;
+    auto const high = mailbox.tdhr;
+    for (std::size_t i = 0; i < 4; i++) {
+      message.payload[i] = static_cast<hal::byte>(low >> (8 * i));
+      message.payload[i + 4] = static_cast<hal::byte>(high >> (8 * i));
+    }
+    (*m_transmit_handler)(message, start_of_frame);
+  }
+}
+
+void can_transmitter::load_mailbox(std::size_t p_mailbox,
+                                   hal::can_message const& p_message)
+{
+  auto const& payload = p_message.payload;
+  auto& mailbox = can1->transmit[p_mailbox];
+  mailbox.tdtr = std::min<std::uint32_t>(p_message.length, 8);
+  mailbox.tdlr = payload[0] | (payload[1] << 8) | (payload[2] << 16) |
+                 (static_cast<std::uint32_t>(payload[3]) << 24);
+  mailbox.tdhr = payload[4] | (payload[5] << 8) | (payload[6] << 16) |
+                 (static_cast<std::uint32_t>(payload[7]) << 24);
+
+  std::uint32_t identifier = 0;
+  if (p_message.extended) {
+    identifier =
+      ((p_message.id & 0x1FFF'FFFF) << 3) | can_bits::extended_identifier;
+  } else {
+    identifier = (p_message.id & 0x7FF) << 21;
+  }
+  if (p_message.remote_request) {
+    identifier |= can_bits::remote_request;
+  }
+  mailbox.tir = identifier | can_bits::transmit_request;
+}
+
+void can_transmitter::abort_mailbox(std::size_t p_mailbox)
+{
+  // Writing zero to the other flags leaves them unchanged
+  can1->tsr = can_bits::abort_request(p_mailbox);
+}
+}  // namespace hal::micromod::stm32f1
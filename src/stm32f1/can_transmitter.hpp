@@ -0,0 +1,107 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+#include <libhal-micromod/can_statistics.hpp>
+#include <libhal-micromod/can_timestamp.hpp>
+#include <libhal-micromod/can_transmit_queue.hpp>
+#include <libhal/can.hpp>
+#include <libhal/lock.hpp>
+#include <libhal/steady_clock.hpp>
+
+namespace hal::micromod::stm32f1 {
+/**
+ * @brief Feeds the bxCAN transmit mailboxes from a priority ordered queue
+ *
+ * Loads the queue's most urgent messages into the three mailboxes, which the
+ * controller sends lowest identifier first, and refills them from the
+ * transmit mailbox empty interrupt (USB_HP_CAN_TX). Reception, filters & bit
+ * timing stay with the libhal-arm-mcu CAN peripheral manager, which must be
+ * constructed first.
+ *
+ * Messages sent are reported to the transmit handler with their start of
+ * frame, which the controller captures in time triggered communication mode
+ * (see can_receive_timestamps, which switches it on) & which is extended to
+ * uptime clock ticks the same way as on reception.
+ *
+ * Only one instance of this driver may exist as it owns the transmit
+ * mailboxes & interrupt.
+ */
+class can_transmitter final : public hal::micromod::can_transmit_queue
+{
+public:
+  /**
+   * @brief Construct a new can transmitter object
+   *
+   * @param p_storage - queue storage, must outlive the transmitter
+   * @param p_clock - uptime clock, running from the cpu clock, also used to
+   * measure latencies
+   * @param p_lock - lock masking the transmit interrupt
+   * @param p_traffic - counts the messages sent
+   * @param p_ticks_per_bit - uptime clock ticks per bit time
+   */
+  can_transmitter(std::span<can_queued_message> p_storage,
+                  hal::steady_clock& p_clock,
+                  hal::basic_lock& p_lock,
+                  hal::micromod::can_traffic_counter& p_traffic,
+                  hal::u32 p_ticks_per_bit);
+
+  can_transmitter(can_transmitter const&) = delete;
+  can_transmitter& operator=(can_transmitter const&) = delete;
+  can_transmitter(can_transmitter&&) = delete;
+  can_transmitter& operator=(can_transmitter&&) = delete;
+  ~can_transmitter() override;
+
+  /**
+   * @brief Queue a message, waiting for room if the queue is full
+   *
+   * @param p_message - message to send
+   * @throws hal::io_error - if the queue is full & the controller is bus off
+   */
+  void send(hal::can_message const& p_message);
+
+  /**
+   * @brief Set the handler called as each message finishes sending
+   *
+   * @param p_handler - handler, or std::nullopt to remove it
+   */
+  void on_transmit(optional_can_transmit_handler const& p_handler);
+
+  /**
+   * @brief Restart the start of frame timestamps after the bit timing changed
+   *
+   * @param p_ticks_per_bit - uptime clock ticks per bit time
+   */
+  void bit_timing_changed(hal::u32 p_ticks_per_bit);
+
+  /// Called from the USB_HP_CAN_TX interrupt service routine
+  void handle_interrupt();
+
+private:
+  void load_mailbox(std::size_t p_mailbox,
+                    hal::can_message const& p_message) override;
+  void abort_mailbox(std::size_t p_mailbox) override;
+  void report_transmitted(std::size_t p_mailbox, hal::u64 p_now);
+
+  hal::steady_clock* m_clock;
+  hal::basic_lock* m_lock;
+  hal::micromod::can_traffic_counter* m_traffic;
+  hal::micromod::can_timestamp_extender m_extender;
+  optional_can_transmit_handler m_transmit_handler;
+};
+}  // namespace hal::micromod::stm32f1
@@ -0,0 +1,230 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "center_aligned_pwm.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hal::micromod::stm32f1 {
+namespace {
+/// Largest top whose 0% compare value, one above it, fits in the 16-bit CCR
+constexpr std::uint32_t maximum_top = 65534;
+constexpr std::uint32_t maximum_prescaler = 65536;
+/// A0 & A1 are ADC12_IN8 & ADC12_IN9
+constexpr std::uint32_t a0_channel = 8;
+constexpr std::uint32_t a1_channel = 9;
+constexpr std::uint32_t sample_mask = 0xFFF;
+
+/// Counts of the guard at a prescaler
+std::uint32_t guard_counts(std::uint32_t p_prescaler)
+{
+  return (center_aligned_pwm::guard_clocks + p_prescaler - 1) / p_prescaler;
+}
+}  // namespace
+
+center_aligned_pwm::center_aligned_pwm(timer_reg_t& p_master,
+                                       timer_reg_t& p_slave,
+                                       adc_reg_t& p_adc,
+                                       hal::hertz p_clock_frequency,
+                                       hal::basic_lock& p_lock)
+  : m_master(&p_master)
+  , m_slave(&p_slave)
+  , m_adc(&p_adc)
+  , m_clock_frequency(p_clock_frequency)
+  , m_lock(&p_lock)
+{
+  for (auto* timer : { m_master, m_slave }) {
+    timer->cr1 = 0;
+    timer->cr2 = 0;
+    timer->smcr = 0;
+    timer->dier = 0;
+    timer->ccer = 0;
+    timer->cnt = 0;
+  }
+  constexpr auto pwm =
+    timer_bits::pwm_mode_2 | timer_bits::output_compare_preload;
+  m_master->ccmr1 = pwm;
+  // Channel 4 only compares, for the ADC trigger
+  m_master->ccmr2 = timer_bits::output_compare_preload << 8;
+  m_slave->ccmr1 = pwm << 8;
+  m_slave->ccmr2 = 0;
+  m_master->rcr = 0;
+
+  // Counters are stopped, so there is no update event to keep clear of
+  driver_frequency(default_frequency);
+  for (auto* timer : { m_master, m_slave }) {
+    timer->egr = timer_bits::update_generation;
+    timer->sr = 0;
+  }
+  m_master->ccer = timer_bits::compare_output_enable;
+  m_slave->ccer = timer_bits::compare_output_enable << 4;
+  m_master->bdtr = timer_bits::main_output_enable;
+
+  constexpr auto a0_shift = a0_channel * 3;
+  constexpr auto a1_shift = a1_channel * 3;
+  m_adc->smpr2 =
+    (m_adc->smpr2 & ~((adc_bits::sample_time_mask << a0_shift) |
+                      (adc_bits::sample_time_mask << a1_shift))) |
+    (adc_bits::sample_time_28 << a0_shift) |
+    (adc_bits::sample_time_28 << a1_shift);
+  m_adc->jsqr = adc_bits::injected_pair(a0_channel, a1_channel);
+  m_adc->sr = 0;
+  m_adc->cr1 = adc_bits::scan | adc_bits::injected_interrupt;
+  m_adc->cr2 = adc_bits::power_on | adc_bits::injected_trigger_timer1_cc4 |
+               adc_bits::injected_external_trigger;
+
+  // TIM1 enabling its counter starts TIM2's
+  m_slave->smcr = timer_bits::slave_mode_trigger;
+  m_master->cr2 = timer_bits::master_mode_enable;
+  m_slave->cr1 = timer_bits::center_aligned_1 | timer_bits::auto_reload_preload;
+  m_master->cr1 = timer_bits::center_aligned_1 |
+                  timer_bits::auto_reload_preload | timer_bits::counter_enable;
+}
+
+center_aligned_pwm::~center_aligned_pwm()
+{
+  m_adc->cr1 = 0;
+  m_adc->cr2 = 0;
+  for (auto* timer : { m_master, m_slave }) {
+    timer->cr1 = 0;
+    timer->ccer = 0;
+    timer->smcr = 0;
+  }
+}
+
+void center_aligned_pwm::handle_interrupt()
+{
+  if ((m_adc->sr & adc_bits::injected_end) == 0) {
+    return;
+  }
+  m_adc->sr = ~adc_bits::injected_end;
+  auto const period = m_samples.load(std::memory_order_relaxed);
+  pwm_center_sample const sample{
+    .a0 = static_cast<hal::u16>(m_adc->jdr[0] & sample_mask),
+    .a1 = static_cast<hal::u16>(m_adc->jdr[1] & sample_mask),
+    .period = period,
+  };
+  m_samples.store(period + 1, std::memory_order_relaxed);
+  if (m_handler) {
+    (*m_handler)(sample);
+  }
+}
+
+void center_aligned_pwm::driver_frequency(hal::hertz p_frequency)
+{
+  // Half a period, from one end of the count to the other
+  auto const ticks = m_clock_frequency / p_frequency / 2.0f;
+  auto const prescaler = static_cast<std::uint32_t>(
+    std::clamp<float>(std::ceil(ticks / static_cast<float>(maximum_top)),
+                      1.0f,
+                      static_cast<float>(maximum_prescaler)));
+  auto const guard = guard_counts(prescaler);
+  auto const top = static_cast<std::uint32_t>(std::clamp<float>(
+    std::round(ticks / static_cast<float>(prescaler)),
+    static_cast<float>(4 * guard),
+    static_cast<float>(maximum_top)));
+
+  auto const running = (m_master->cr1 & timer_bits::counter_enable) != 0;
+  std::unique_lock<hal::basic_lock> lock;
+  if (running) {
+    lock = commit_window();
+  }
+  // Until the update event, the timers may still count to the old top. The
+  // window is kept clear of both, which only leaves out a second change within
+  // the same half period.
+  auto const old_guard = guard_counts(m_prescaler);
+  m_window_start = running ? std::max(guard, old_guard) : guard;
+  m_window_end =
+    running ? std::min(top - guard, m_top - old_guard) : top - guard;
+  m_prescaler = prescaler;
+  m_top = top;
+
+  auto const master_compare = compare_value(m_duty_cycles[0]);
+  auto const slave_compare = compare_value(m_duty_cycles[1]);
+  m_master->psc = prescaler - 1;
+  m_master->arr = top;
+  m_master->ccr1 = master_compare;
+  m_master->ccr4 = top;
+  m_slave->psc = prescaler - 1;
+  m_slave->arr = top;
+  m_slave->ccr2 = slave_compare;
+}
+
+hal::hertz center_aligned_pwm::driver_actual_frequency()
+{
+  std::lock_guard lock(*m_lock);
+  return m_clock_frequency / static_cast<float>(2 * m_prescaler * m_top);
+}
+
+void center_aligned_pwm::driver_duty_cycles(
+  std::array<float, pwm_group_channels> const& p_duty_cycles)
+{
+  auto const lock = commit_window();
+  for (std::size_t i = 0; i < pwm_group_channels; i++) {
+    m_duty_cycles[i] = std::clamp(p_duty_cycles[i], 0.0f, 1.0f);
+  }
+  m_master->ccr1 = compare_value(m_duty_cycles[0]);
+  m_slave->ccr2 = compare_value(m_duty_cycles[1]);
+}
+
+void center_aligned_pwm::driver_on_center_sample(
+  optional_center_sample_handler const& p_handler)
+{
+  std::lock_guard lock(*m_lock);
+  m_handler = p_handler;
+}
+
+pwm_group_statistics center_aligned_pwm::driver_statistics()
+{
+  std::lock_guard lock(*m_lock);
+  auto statistics = m_statistics;
+  statistics.samples = m_samples.load(std::memory_order_relaxed);
+  return statistics;
+}
+
+std::unique_lock<hal::basic_lock> center_aligned_pwm::commit_window()
+{
+  std::unique_lock lock(*m_lock);
+  m_statistics.commits++;
+  bool waited = false;
+  while (true) {
+    // Counting down, the next update event is the underflow ending the period.
+    // The count is read first: with the lock held the counter cannot turn
+    // around at 0 & count back up past the guard before DIR is read.
+    auto const count = m_master->cnt;
+    auto const down = (m_master->cr1 & timer_bits::direction_down) != 0;
+    if (down && m_window_start <= count && count <= m_window_end) {
+      return lock;
+    }
+    if (not waited) {
+      m_statistics.waits++;
+      waited = true;
+    }
+    // Let interrupts in while the counter moves on
+    lock.unlock();
+    lock.lock();
+  }
+}
+
+std::uint32_t center_aligned_pwm::compare_value(float p_duty_cycle) const
+{
+  // In PWM mode 2 the output is high while the counter is above the compare
+  // value, for 2 x (top - compare) of the 2 x top counts of a period. Above
+  // the top it stays low, at 0 it stays high.
+  auto const steps = static_cast<std::uint32_t>(
+    std::lround(p_duty_cycle * static_cast<float>(m_top)));
+  return steps == 0 ? m_top + 1 : m_top - steps;
+}
+}  // namespace hal::micromod::stm32f1
@@ -0,0 +1,119 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include <libhal-micromod/pwm_group.hpp>
+#include <libhal/lock.hpp>
+#include <libhal/units.hpp>
+
+#include "registers.hpp"
+
+namespace hal::micromod::stm32f1 {
+/**
+ * @brief PWM group of TIM1 channel 1 & TIM2 channel 2, sampling A0 & A1 with
+ * ADC2 at the center of each pulse
+ *
+ * Both timers count up to the top & back down, the pulses centered on the top
+ * (PWM mode 2). TIM2 is started by TIM1's trigger output, & with the same
+ * clock, prescaler & top the two count in lockstep from then on.
+ *
+ * Each timer loads its preloaded prescaler, top & compare values at both ends
+ * of the count, the update events. A commit writes them only while TIM1 counts
+ * down (CR1.DIR) with its counter at least guard_clocks away from either end,
+ * waiting for that if needed, with the lock held. Every value of a commit is
+ * then written in the same half period, & every output switches to it at the
+ * underflow starting the next period, within a period. Both halves of a period
+ * run on the same values, so each pulse stays centered on the top. TIM2 is
+ * never behind TIM1 by more than a couple of clocks, well inside the guard.
+ *
+ * TIM1 channel 4 compares at the top, & its event triggers ADC2's injected
+ * sequence, A0 (ADC12_IN8) then A1 (ADC12_IN9), each sampled for 28.5 ADC
+ * clock cycles. The end of the sequence interrupts, & the interrupt calls
+ * handle_interrupt().
+ *
+ * Only the registers are touched: the timers' & ADC2's clocks must be on, ADC2
+ * calibrated (see power_on_adc2()), the output pins connected & the ADC
+ * interrupt routed to handle_interrupt(). Owns TIM1, TIM2 & ADC2, so it may
+ * not be used alongside a pwm_timer of either timer.
+ */
+class center_aligned_pwm final : public hal::micromod::pwm_group
+{
+public:
+  /// Timer clocks kept between a commit & the next update event
+  static constexpr std::uint32_t guard_clocks = 64;
+  static constexpr hal::hertz default_frequency = 20'000.0f;
+
+  /**
+   * @brief Construct a new center aligned pwm object & start counting
+   *
+   * Runs at the default frequency with both outputs low.
+   *
+   * @param p_master - TIM1's registers, must outlive the object
+   * @param p_slave - TIM2's registers, must outlive the object
+   * @param p_adc - ADC2's registers, must outlive the object
+   * @param p_clock_frequency - kernel clock of both timers, which must be the
+   * same, see timer_clock_frequency()
+   * @param p_lock - lock excluding handle_interrupt(), must outlive the object
+   */
+  center_aligned_pwm(timer_reg_t& p_master,
+                     timer_reg_t& p_slave,
+                     adc_reg_t& p_adc,
+                     hal::hertz p_clock_frequency,
+                     hal::basic_lock& p_lock);
+
+  center_aligned_pwm(center_aligned_pwm const&) = delete;
+  center_aligned_pwm& operator=(center_aligned_pwm const&) = delete;
+  center_aligned_pwm(center_aligned_pwm&&) = delete;
+  center_aligned_pwm& operator=(center_aligned_pwm&&) = delete;
+  ~center_aligned_pwm() override;
+
+  /// Called from the ADC interrupt service routine
+  void handle_interrupt();
+
+private:
+  void driver_frequency(hal::hertz p_frequency) override;
+  hal::hertz driver_actual_frequency() override;
+  void driver_duty_cycles(
+    std::array<float, pwm_group_channels> const& p_duty_cycles) override;
+  void driver_on_center_sample(
+    optional_center_sample_handler const& p_handler) override;
+  pwm_group_statistics driver_statistics() override;
+
+  /// Take the lock once the counter counts down, clear of the update events
+  [[nodiscard]] std::unique_lock<hal::basic_lock> commit_window();
+  [[nodiscard]] std::uint32_t compare_value(float p_duty_cycle) const;
+
+  timer_reg_t* m_master;
+  timer_reg_t* m_slave;
+  adc_reg_t* m_adc;
+  hal::hertz m_clock_frequency;
+  hal::basic_lock* m_lock;
+  std::uint32_t m_prescaler = 1;
+  /// Count the timers turn around at, half a period
+  std::uint32_t m_top = 2;
+  /// Counts commits may be written at, clear of both tops in use
+  std::uint32_t m_window_start = 0;
+  std::uint32_t m_window_end = 0;
+  std::array<float, pwm_group_channels> m_duty_cycles{};
+  optional_center_sample_handler m_handler;
+  pwm_group_statistics m_statistics{};
+  std::atomic<hal::u32> m_samples = 0;
+};
+}  // namespace hal::micromod::stm32f1
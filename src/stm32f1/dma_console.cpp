@@ -0,0 +1,88 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dma_console.hpp"
+
+#include <libhal-arm-mcu/interrupt.hpp>
+#include <libhal-arm-mcu/stm32f1/interrupt.hpp>
+
+#include "registers.hpp"
+
+namespace hal::micromod::stm32f1 {
+namespace {
+constexpr std::uint32_t transmit_channel = 4;
+constexpr hal::cortex_m::irq_t dma1_channel4_irq = 14;
+
+dma_console* active_driver = nullptr;
+
+void dma1_channel4_handler()
+{
+  if (active_driver != nullptr) {
+    active_driver->handle_interrupt();
+  }
+}
+
+dma_channel_reg_t& channel()
+{
+  return dma1->channel[transmit_channel - 1];
+}
+}  // namespace
+
+dma_console::dma_console(hal::serial& p_uart,
+                         std::span<hal::byte> p_buffer,
+                         overflow_policy p_policy)
+  : ring_console(p_uart, p_buffer, p_policy)
+{
+  rcc->ahbenr = rcc->ahbenr | rcc_enable::dma1;
+  channel().ccr = 0;
+  channel().cpar = reinterpret_cast<std::uintptr_t>(&usart1->dr);
+  dma1->ifcr = dma_flag(transmit_channel, 0);
+  serial_configured();
+
+  active_driver = this;
+  hal::stm32f1::initialize_interrupts();
+  hal::cortex_m::enable_interrupt(dma1_channel4_irq, dma1_channel4_handler);
+}
+
+dma_console::~dma_console()
+{
+  hal::cortex_m::disable_interrupt(dma1_channel4_irq);
+  channel().ccr = 0;
+  usart1->cr3 = usart1->cr3 & ~usart_bits::dma_transmit;
+  active_driver = nullptr;
+}
+
+void dma_console::serial_configured()
+{
+  usart1->cr3 = usart1->cr3 | usart_bits::dma_transmit;
+}
+
+void dma_console::start_transmit(std::span<hal::byte const> p_data)
+{
+  channel().ccr = 0;
+  channel().cmar = reinterpret_cast<std::uintptr_t>(p_data.data());
+  channel().cndtr = static_cast<std::uint32_t>(p_data.size());
+  channel().ccr = dma_ccr::memory_to_peripheral | dma_ccr::memory_increment |
+                  dma_ccr::transfer_complete_interrupt |
+                  dma_ccr::transfer_error_interrupt | dma_ccr::enable;
+}
+
+void dma_console::handle_interrupt()
+{
+  dma1->ifcr = dma_flag(transmit_channel, 0);
+  channel().ccr = 0;
+  // A transfer error also ends the transfer, its bytes are given up on
+  transmit_complete();
+}
+}  // namespace hal::micromod::stm32f1
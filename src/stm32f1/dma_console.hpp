@@ -0,0 +1,61 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <span>
+
+#include <libhal/serial.hpp>
+#include <libhal/units.hpp>
+
+#include "../ring_console.hpp"
+
+namespace hal::micromod::stm32f1 {
+/**
+ * @brief USART1 console that transmits from a ring buffer with DMA
+ *
+ * Reception is left to the wrapped libhal uart driver. Transmission is done by
+ * DMA1 channel 4 (USART1_TX), which sends each contiguous run of the ring and
+ * raises its transfer complete interrupt to start the next one.
+ *
+ * Only one instance of this driver may exist as it owns DMA1 channel 4.
+ */
+class dma_console final : public hal::micromod::ring_console
+{
+public:
+  /**
+   * @brief Construct a new dma console object
+   *
+   * @param p_uart - USART1 driver, used to receive & configure the port
+   * @param p_buffer - transmit ring storage, at most 65535 bytes
+   * @param p_policy - what write() does when the ring is full
+   */
+  dma_console(hal::serial& p_uart,
+              std::span<hal::byte> p_buffer,
+              overflow_policy p_policy);
+
+  dma_console(dma_console const&) = delete;
+  dma_console& operator=(dma_console const&) = delete;
+  dma_console(dma_console&&) = delete;
+  dma_console& operator=(dma_console&&) = delete;
+  ~dma_console() override;
+
+  /// Called from the DMA1 channel 4 interrupt service routine
+  void handle_interrupt();
+
+private:
+  void start_transmit(std::span<hal::byte const> p_data) override;
+  void serial_configured() override;
+};
+}  // namespace hal::micromod::stm32f1
@@ -0,0 +1,266 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dma_spi.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <libhal/error.hpp>
+
+#include "../wait_for_interrupt.hpp"
+
+namespace hal::micromod::stm32f1 {
+namespace {
+constexpr std::uint32_t lead_channel = 3;
+constexpr std::uint32_t trail_channel = 2;
+constexpr std::uint32_t sample_channel = 6;
+}  // namespace
+
+dma_spi::dma_spi(dma_reg_t& p_dma,
+                 timer_reg_t& p_timer,
+                 gpio_reg_t& p_port,
+                 pins p_pins,
+                 hal::steady_clock& p_clock,
+                 hal::hertz p_timer_clock,
+                 settings const& p_settings)
+  : m_dma(&p_dma)
+  , m_timer(&p_timer)
+  , m_port(&p_port)
+  , m_clock(&p_clock)
+  , m_timer_clock(p_timer_clock)
+  , m_pins(p_pins)
+{
+  driver_configure(p_settings);
+}
+
+dma_spi::~dma_spi()
+{
+  stop();
+}
+
+dma_channel_reg_t& dma_spi::channel(std::uint32_t p_channel)
+{
+  return m_dma->channel[p_channel - 1];
+}
+
+hal::u64 dma_spi::timeout_ticks() const
+{
+  auto const bit_time = static_cast<float>(m_ticks_per_bit) *
+                        static_cast<float>(m_prescaler + 1) / m_timer_clock;
+  // The waveform ends with the idle remainder of the last buffer half
+  auto const bits = static_cast<float>(m_length * 8 + buffer_bits);
+  auto const seconds = (2.0f * bits * bit_time) + transfer_timeout_margin;
+  return static_cast<hal::u64>(std::ceil(seconds * m_clock->frequency()));
+}
+
+void dma_spi::driver_configure(settings const& p_settings)
+{
+  auto ticks = static_cast<std::uint32_t>(
+    std::ceil(m_timer_clock / std::max(p_settings.clock_rate, 1.0f)));
+  // Requests faster than the DMA controller can keep up with run at the
+  // fastest supported rate.
+  ticks = std::max(ticks, minimum_ticks_per_bit);
+
+  m_prescaler = (ticks - 1) / 65536;
+  m_ticks_per_bit = ticks / (m_prescaler + 1);
+
+  auto const sck_set = 1U << m_pins.sck;
+  auto const sck_reset = 1U << (m_pins.sck + 16U);
+  m_idle_clock = p_settings.clock_idles_high ? sck_set : sck_reset;
+  m_active_clock = p_settings.clock_idles_high ? sck_reset : sck_set;
+  m_data_valid_on_trailing_edge = p_settings.data_valid_on_trailing_edge;
+
+  m_port->bsrr = m_idle_clock;
+}
+
+void dma_spi::encode_half(std::size_t p_half)
+{
+  auto const copi_set = 1U << m_pins.copi;
+  auto const copi_reset = 1U << (m_pins.copi + 16U);
+  // With data valid on the leading edge, the data is placed on the bus while
+  // the clock is idle and the leading edge comes half a bit later. Otherwise,
+  // the data changes with the leading edge and is sampled on the trailing
+  // edge.
+  auto const lead_clock =
+    m_data_valid_on_trailing_edge ? m_active_clock : m_idle_clock;
+  auto const trail_clock =
+    m_data_valid_on_trailing_edge ? m_idle_clock : m_active_clock;
+
+  auto* lead = &m_lead[p_half * half_bits];
+  auto* trail = &m_trail[p_half * half_bits];
+
+  for (std::size_t i = 0; i < half_bytes; i++, m_encoded++) {
+    if (m_encoded >= m_length) {
+      // Keep the clock idle for the remainder of the buffer
+      std::fill_n(lead, 8, m_idle_clock);
+      std::fill_n(trail, 8, m_idle_clock);
+    } else {
+      auto const byte =
+        m_encoded < m_data_out.size() ? m_data_out[m_encoded] : m_filler;
+      for (std::size_t bit = 0; bit < 8; bit++) {
+        auto const high = (byte >> (7 - bit)) & 1U;
+        lead[bit] = lead_clock | (high ? copi_set : copi_reset);
+        trail[bit] = trail_clock;
+      }
+    }
+    lead += 8;
+    trail += 8;
+  }
+}
+
+void dma_spi::decode_half(std::size_t p_half)
+{
+  auto const* samples = &m_samples[p_half * half_bits];
+  for (std::size_t i = 0; i < half_bytes && m_decoded < m_length;
+       i++, m_decoded++) {
+    hal::byte byte = 0;
+    for (std::size_t bit = 0; bit < 8; bit++) {
+      byte = static_cast<hal::byte>(byte << 1U) |
+             static_cast<hal::byte>((samples[bit] >> m_pins.cipo) & 1U);
+    }
+    if (m_decoded < m_data_in.size()) {
+      m_data_in[m_decoded] = byte;
+    }
+    samples += 8;
+  }
+}
+
+void dma_spi::stop()
+{
+  m_timer->cr1 = 0;
+  m_timer->dier = 0;
+  channel(lead_channel).ccr = 0;
+  channel(trail_channel).ccr = 0;
+  channel(sample_channel).ccr = 0;
+  m_dma->ifcr = dma_flag(lead_channel, 0) | dma_flag(trail_channel, 0) |
+               dma_flag(sample_channel, 0);
+  // The timer may have been stopped between the sampling and trailing edge of
+  // the last bit, so return the clock to idle.
+  m_port->bsrr = m_idle_clock;
+  m_done = true;
+}
+
+void dma_spi::handle_interrupt()
+{
+  auto const status = m_dma->isr;
+  m_dma->ifcr = dma_flag(sample_channel, 0);
+
+  if (status & dma_flag(sample_channel, 3)) {
+    m_error = true;
+    stop();
+    return;
+  }
+
+  for (std::size_t half = 0; half < 2; half++) {
+    // Half transfer (flag 2) completes the first half, transfer complete
+    // (flag 1) completes the second half.
+    if (not(status & dma_flag(sample_channel, 2 - half))) {
+      continue;
+    }
+
+    decode_half(half);
+    if (m_decoded >= m_length) {
+      stop();
+      return;
+    }
+    // The other half is being played out, so this half can be refilled with
+    // the bytes that follow it.
+    encode_half(half);
+  }
+}
+
+void dma_spi::driver_transfer(std::span<hal::byte const> p_data_out,
+                              std::span<hal::byte> p_data_in,
+                              hal::byte p_filler)
+{
+  m_length = std::max(p_data_out.size(), p_data_in.size());
+  if (m_length == 0) {
+    return;
+  }
+
+  m_data_out = p_data_out;
+  m_data_in = p_data_in;
+  m_filler = p_filler;
+  m_encoded = 0;
+  m_decoded = 0;
+  m_error = false;
+  m_done = false;
+
+  encode_half(0);
+  encode_half(1);
+
+  auto const output_flags =
+    dma_ccr::memory_to_peripheral | dma_ccr::circular |
+    dma_ccr::memory_increment | dma_ccr::peripheral_32_bit |
+    dma_ccr::memory_32_bit | dma_ccr::priority_very_high;
+
+  auto setup_channel = [this](std::uint32_t p_channel,
+                              reg_t* p_peripheral,
+                              void* p_memory,
+                              std::uint32_t p_flags) {
+    auto& dma_channel = channel(p_channel);
+    dma_channel.ccr = 0;
+    dma_channel.cpar = reinterpret_cast<std::uintptr_t>(p_peripheral);
+    dma_channel.cmar = reinterpret_cast<std::uintptr_t>(p_memory);
+    dma_channel.cndtr = buffer_bits;
+    dma_channel.ccr = p_flags | dma_ccr::enable;
+  };
+
+  m_dma->ifcr = dma_flag(lead_channel, 0) | dma_flag(trail_channel, 0) |
+                dma_flag(sample_channel, 0);
+  setup_channel(lead_channel, &m_port->bsrr, m_lead.data(), output_flags);
+  setup_channel(trail_channel, &m_port->bsrr, m_trail.data(), output_flags);
+  setup_channel(sample_channel,
+                &m_port->idr,
+                m_samples.data(),
+                dma_ccr::circular | dma_ccr::memory_increment |
+                  dma_ccr::peripheral_16_bit | dma_ccr::memory_16_bit |
+                  dma_ccr::priority_high | dma_ccr::half_transfer_interrupt |
+                  dma_ccr::transfer_complete_interrupt |
+                  dma_ccr::transfer_error_interrupt);
+
+  // Each bit starts with the update event writing the leading word, the
+  // trailing word is written half way through the bit and the input is
+  // sampled three quarters of the way through the bit.
+  m_timer->cr1 = 0;
+  m_timer->psc = m_prescaler;
+  m_timer->arr = m_ticks_per_bit - 1;
+  m_timer->ccr3 = m_ticks_per_bit / 2;
+  m_timer->ccr1 = (m_ticks_per_bit * 3) / 4;
+  m_timer->egr = timer_bits::update_generation;
+  m_timer->sr = 0;
+  // Start at the top of the count so the first event is the update event
+  m_timer->cnt = m_ticks_per_bit - 1;
+  m_timer->dier =
+    timer_bits::update_dma | timer_bits::cc3_dma | timer_bits::cc1_dma;
+
+  // Sleep until the transfer completes. A DMA or timer that never gets going
+  // still wakes the core with the uptime clock's periodic interrupt, so the
+  // deadline is checked at least that often.
+  auto const deadline = m_clock->uptime() + timeout_ticks();
+  m_timer->cr1 = timer_bits::counter_enable;
+  while (not m_done) {
+    if (m_clock->uptime() >= deadline) {
+      stop();
+      hal::safe_throw(hal::timed_out(this));
+    }
+    wait_for_interrupt_unless(m_done);
+  }
+
+  if (m_error) {
+    hal::safe_throw(hal::io_error(this));
+  }
+}
+}  // namespace hal::micromod::stm32f1
@@ -0,0 +1,150 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <span>
+
+#include <libhal/spi.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include "registers.hpp"
+
+namespace hal::micromod::stm32f1 {
+/**
+ * @brief SPI controller that streams the SPI waveform to GPIO pins using DMA
+ *
+ * The MicroMod STM32F1 boards route the hardware SPI1 MISO pin (PA6) to the
+ * connector's SDO line and MOSI (PA7) to SDI, the opposite of what the SPI1
+ * peripheral needs as a controller. So instead of using the SPI peripheral,
+ * timer 3 paces three DMA channels:
+ *
+ *   - DMA1 channel 3 (TIM3_UP) writes the leading half of each bit (data and
+ *     clock) to the port's BSRR register.
+ *   - DMA1 channel 2 (TIM3_CH3) writes the trailing clock edge to BSRR.
+ *   - DMA1 channel 6 (TIM3_CH1) samples the port's IDR register after the
+ *     sampling edge.
+ *
+ * The waveform is double buffered. The half-transfer and transfer-complete
+ * interrupts of channel 6 decode the received bits and refill the half that
+ * just finished, so the CPU only wakes up once per `half_bytes` bytes and
+ * sleeps (WFI) for the rest of the transfer. A transfer that has not completed
+ * in twice its expected time, plus transfer_timeout_margin, is stopped and
+ * `hal::timed_out` is thrown.
+ *
+ * Only the registers are touched: the DMA1 & TIM3 clocks must be on, the pins
+ * configured and the DMA1 channel 6 interrupt routed to handle_interrupt().
+ * Only one instance of this driver may exist as it owns timer 3 and DMA1
+ * channels 2, 3 & 6.
+ */
+class dma_spi final : public hal::spi
+{
+public:
+  /// GPIO pins used by the SPI bus, all pins must be on the same port.
+  struct pins
+  {
+    /// Serial clock pin number, must already be configured as an output
+    std::uint8_t sck;
+    /// Controller out, peripheral in pin, must already be configured as an
+    /// output
+    std::uint8_t copi;
+    /// Controller in, peripheral out pin, must already be configured as an
+    /// input
+    std::uint8_t cipo;
+  };
+
+  /// Number of bytes held in each half of the waveform double buffer
+  static constexpr std::size_t half_bytes = 8;
+  /// Number of timer ticks needed per bit for the DMA controller to keep up
+  /// with the three requests made per bit.
+  static constexpr std::uint32_t minimum_ticks_per_bit = 32;
+  /// Time allowed for a transfer on top of twice its expected duration
+  static constexpr float transfer_timeout_margin = 0.01f;
+
+  /**
+   * @brief Construct a new dma spi object
+   *
+   * @param p_dma - DMA1's registers, must outlive the object
+   * @param p_timer - TIM3's registers, must outlive the object
+   * @param p_port - registers of the port the pins are on, must outlive the
+   * object
+   * @param p_pins - pins of the spi bus
+   * @param p_clock - steady clock bounding each transfer
+   * @param p_timer_clock - kernel clock of TIM3, see timer_clock_frequency()
+   * @param p_settings - initial bus settings
+   */
+  dma_spi(dma_reg_t& p_dma,
+          timer_reg_t& p_timer,
+          gpio_reg_t& p_port,
+          pins p_pins,
+          hal::steady_clock& p_clock,
+          hal::hertz p_timer_clock,
+          settings const& p_settings);
+
+  dma_spi(dma_spi const&) = delete;
+  dma_spi& operator=(dma_spi const&) = delete;
+  dma_spi(dma_spi&&) = delete;
+  dma_spi& operator=(dma_spi&&) = delete;
+  ~dma_spi() override;
+
+  /**
+   * @brief Handle a DMA interrupt of the sampling channel
+   *
+   * Called from the DMA1 channel 6 interrupt service routine.
+   */
+  void handle_interrupt();
+
+private:
+  static constexpr std::size_t half_bits = half_bytes * 8;
+  static constexpr std::size_t buffer_bits = half_bits * 2;
+
+  void driver_configure(settings const& p_settings) override;
+  void driver_transfer(std::span<hal::byte const> p_data_out,
+                       std::span<hal::byte> p_data_in,
+                       hal::byte p_filler) override;
+
+  void encode_half(std::size_t p_half);
+  void decode_half(std::size_t p_half);
+  void stop();
+  [[nodiscard]] dma_channel_reg_t& channel(std::uint32_t p_channel);
+  [[nodiscard]] hal::u64 timeout_ticks() const;
+
+  std::array<std::uint32_t, buffer_bits> m_lead{};
+  std::array<std::uint32_t, buffer_bits> m_trail{};
+  std::array<std::uint16_t, buffer_bits> m_samples{};
+  std::span<hal::byte const> m_data_out{};
+  std::span<hal::byte> m_data_in{};
+  std::size_t m_length = 0;
+  std::size_t m_encoded = 0;
+  std::size_t m_decoded = 0;
+  dma_reg_t* m_dma;
+  timer_reg_t* m_timer;
+  gpio_reg_t* m_port;
+  hal::steady_clock* m_clock;
+  hal::hertz m_timer_clock;
+  pins m_pins;
+  std::uint32_t m_prescaler = 0;
+  std::uint32_t m_ticks_per_bit = minimum_ticks_per_bit;
+  std::uint32_t m_idle_clock = 0;
+  std::uint32_t m_active_clock = 0;
+  bool m_data_valid_on_trailing_edge = false;
+  hal::byte m_filler = hal::spi::default_filler;
+  std::atomic<bool> m_done = true;
+  std::atomic<bool> m_error = false;
+};
+}  // namespace hal::micromod::stm32f1
@@ -0,0 +1,350 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "i2c.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <libhal/error.hpp>
+
+namespace hal::micromod::stm32f1 {
+namespace {
+namespace cr1 {
+constexpr std::uint32_t peripheral_enable = 1 << 0;
+constexpr std::uint32_t start = 1 << 8;
+constexpr std::uint32_t stop = 1 << 9;
+constexpr std::uint32_t ack = 1 << 10;
+constexpr std::uint32_t pos = 1 << 11;
+constexpr std::uint32_t software_reset = 1 << 15;
+}  // namespace cr1
+
+namespace cr2 {
+constexpr std::uint32_t error_interrupt = 1 << 8;
+constexpr std::uint32_t event_interrupt = 1 << 9;
+constexpr std::uint32_t buffer_interrupt = 1 << 10;
+}  // namespace cr2
+
+namespace sr1 {
+constexpr std::uint32_t start_bit = 1 << 0;
+constexpr std::uint32_t address = 1 << 1;
+constexpr std::uint32_t byte_transfer_finished = 1 << 2;
+constexpr std::uint32_t receive_not_empty = 1 << 6;
+constexpr std::uint32_t transmit_empty = 1 << 7;
+constexpr std::uint32_t bus_error = 1 << 8;
+constexpr std::uint32_t arbitration_lost = 1 << 9;
+constexpr std::uint32_t acknowledge_failure = 1 << 10;
+constexpr std::uint32_t overrun = 1 << 11;
+}  // namespace sr1
+
+constexpr std::uint32_t fast_mode = 1 << 15;
+constexpr hal::hertz standard_mode_limit = 100'000.0f;
+constexpr hal::hertz fast_mode_limit = 400'000.0f;
+
+}  // namespace
+
+i2c::i2c(i2c_reg_t& p_i2c,
+         rcc_reg_t& p_rcc,
+         gpio_reg_t& p_port,
+         hal::steady_clock& p_clock,
+         hal::hertz p_bus_clock,
+         hal::time_duration p_clock_stretch_timeout,
+         settings const& p_settings)
+  : m_i2c(&p_i2c)
+  , m_clock(&p_clock)
+  , m_bus_clock(p_bus_clock)
+  , m_stretch_timeout_ticks(static_cast<hal::u64>(
+      p_clock.frequency() *
+      std::chrono::duration<float>(p_clock_stretch_timeout).count()))
+{
+  p_rcc.apb2enr = p_rcc.apb2enr | rcc_enable::gpio_b;
+  p_rcc.apb1enr = p_rcc.apb1enr | rcc_enable::i2c1;
+
+  // PB6 & PB7 as 50MHz alternate function open drain outputs
+  p_port.crl = (p_port.crl & 0x00FF'FFFF) | 0xFF00'0000;
+
+  driver_configure(p_settings);
+}
+
+i2c::~i2c()
+{
+  m_i2c->cr1 = 0;
+}
+
+void i2c::set(std::uint32_t p_mask)
+{
+  m_i2c->cr1 = m_i2c->cr1 | p_mask;
+}
+
+void i2c::clear(std::uint32_t p_mask)
+{
+  m_i2c->cr1 = m_i2c->cr1 & ~p_mask;
+}
+
+void i2c::clear_address_flag()
+{
+  // ADDR is cleared by reading SR1 (already done by the caller) then SR2
+  [[maybe_unused]] auto const status2 = m_i2c->sr2;
+}
+
+void i2c::enable_buffer_interrupt()
+{
+  m_i2c->cr2 = m_i2c->cr2 | cr2::buffer_interrupt;
+}
+
+void i2c::disable_buffer_interrupt()
+{
+  m_i2c->cr2 = m_i2c->cr2 & ~cr2::buffer_interrupt;
+}
+
+void i2c::driver_configure(settings const& p_settings)
+{
+  if (p_settings.clock_rate > fast_mode_limit ||
+      p_settings.clock_rate <= 0.0f) {
+    hal::safe_throw(hal::operation_not_supported(this));
+  }
+  m_settings = p_settings;
+  setup_peripheral();
+}
+
+void i2c::setup_peripheral()
+{
+  auto const pclk1 = m_bus_clock;
+  auto const pclk1_mhz = static_cast<std::uint32_t>(pclk1 / 1'000'000.0f);
+  auto const rate = m_settings.clock_rate;
+
+  m_i2c->cr1 = 0;
+  m_i2c->cr2 = pclk1_mhz | cr2::error_interrupt | cr2::event_interrupt;
+
+  if (rate <= standard_mode_limit) {
+    // SCL high and low times are both CCR * T(pclk1)
+    auto const ccr = static_cast<std::uint32_t>(std::ceil(pclk1 / (2 * rate)));
+    m_i2c->ccr = std::max<std::uint32_t>(ccr, 4);
+    // Maximum rise time of 1000ns in standard mode
+    m_i2c->trise = pclk1_mhz + 1;
+  } else {
+    // With DUTY = 0, SCL low time is 2 * CCR and high time is CCR
+    auto const ccr = static_cast<std::uint32_t>(std::ceil(pclk1 / (3 * rate)));
+    m_i2c->ccr = fast_mode | std::max<std::uint32_t>(ccr, 1);
+    // Maximum rise time of 300ns in fast mode
+    m_i2c->trise = ((pclk1_mhz * 300) / 1000) + 1;
+  }
+
+  m_i2c->cr1 = cr1::peripheral_enable;
+}
+
+void i2c::reset_peripheral()
+{
+  m_i2c->cr1 = cr1::software_reset;
+  m_i2c->cr1 = 0;
+  setup_peripheral();
+  m_state = state::idle;
+}
+
+void i2c::finish(state p_state)
+{
+  disable_buffer_interrupt();
+  m_state = p_state;
+}
+
+void i2c::handle_event()
+{
+  m_events++;
+  auto const status = m_i2c->sr1;
+  auto const current_state = m_state.load();
+
+  if (status & sr1::start_bit) {
+    auto const reading = current_state == state::read;
+    if (reading && m_data_in.size() == 2) {
+      // ACK the first byte and NACK the second, see RM0008 26.3.3
+      set(cr1::ack | cr1::pos);
+    } else if (reading) {
+      clear(cr1::pos);
+      set(cr1::ack);
+    }
+    m_address_phase = true;
+    // Writing the address clears the start bit flag
+    m_i2c->dr = static_cast<std::uint32_t>(m_address << 1) | (reading ? 1 : 0);
+    return;
+  }
+
+  if (status & sr1::address) {
+    m_address_phase = false;
+    if (current_state == state::read) {
+      auto const length = m_data_in.size();
+      if (length == 1) {
+        clear(cr1::ack);
+        clear_address_flag();
+        set(cr1::stop);
+      } else if (length == 2) {
+        clear_address_flag();
+        clear(cr1::ack);
+        disable_buffer_interrupt();
+      } else {
+        clear_address_flag();
+        if (length == 3) {
+          disable_buffer_interrupt();
+        }
+      }
+    } else {
+      clear_address_flag();
+      if (m_data_out.empty()) {
+        // Address only transaction used to probe for a device
+        set(cr1::stop);
+        finish(state::finished);
+      }
+    }
+    return;
+  }
+
+  if (current_state == state::write) {
+    if ((status & sr1::transmit_empty) && m_index < m_data_out.size()) {
+      m_i2c->dr = m_data_out[m_index++];
+      if (m_index == m_data_out.size()) {
+        // Wait for the last byte to finish shifting out
+        disable_buffer_interrupt();
+      }
+      return;
+    }
+
+    if (status & sr1::byte_transfer_finished) {
+      if (not m_data_in.empty()) {
+        m_state = state::read;
+        m_index = 0;
+        // BTF & TXE stay set until the repeated START goes out, which the
+        // read must not take for its own events
+        m_address_phase = true;
+        enable_buffer_interrupt();
+        set(cr1::start);
+      } else {
+        set(cr1::stop);
+        finish(state::finished);
+      }
+    }
+    return;
+  }
+
+  if (current_state == state::read && not m_address_phase) {
+    auto const remaining = m_data_in.size() - m_index;
+    if ((status & sr1::receive_not_empty) && remaining == 1) {
+      m_data_in[m_index++] = static_cast<hal::byte>(m_i2c->dr);
+      finish(state::finished);
+    } else if ((status & sr1::receive_not_empty) && remaining > 3) {
+      m_data_in[m_index++] = static_cast<hal::byte>(m_i2c->dr);
+      if (remaining - 1 == 3) {
+        // The last three bytes are handled with BTF so the NACK and STOP can
+        // be placed at the right time.
+        disable_buffer_interrupt();
+      }
+    } else if (status & sr1::byte_transfer_finished) {
+      if (remaining == 3) {
+        // Byte N-2 in DR, N-1 in the shift register, NACK byte N
+        clear(cr1::ack);
+        m_data_in[m_index++] = static_cast<hal::byte>(m_i2c->dr);
+      } else if (remaining == 2) {
+        // Byte N-1 in DR, N in the shift register
+        set(cr1::stop);
+        m_data_in[m_index++] = static_cast<hal::byte>(m_i2c->dr);
+        m_data_in[m_index++] = static_cast<hal::byte>(m_i2c->dr);
+        finish(state::finished);
+      }
+    }
+  }
+}
+
+void i2c::handle_error()
+{
+  m_events++;
+  auto const status = m_i2c->sr1;
+  // Error flags are cleared by writing 0, the other flags are read only
+  m_i2c->sr1 = 0;
+
+  if (status & sr1::acknowledge_failure) {
+    set(cr1::stop);
+    finish(m_address_phase ? state::address_nack : state::data_nack);
+  } else if (status & (sr1::bus_error | sr1::arbitration_lost | sr1::overrun)) {
+    finish(state::bus_error);
+  }
+}
+
+void i2c::driver_transaction(
+  hal::byte p_address,
+  std::span<hal::byte const> p_data_out,
+  std::span<hal::byte> p_data_in,
+  hal::function_ref<hal::timeout_function> p_timeout)
+{
+  // Wait for the STOP of the previous transaction to go out on the bus, which
+  // a device holding SCL low can keep from ever happening
+  auto const stop_requested = m_clock->uptime();
+  while (m_i2c->cr1 & cr1::stop) {
+    if (m_clock->uptime() - stop_requested > m_stretch_timeout_ticks) {
+      reset_peripheral();
+      hal::safe_throw(hal::timed_out(this));
+    }
+  }
+
+  m_address = p_address;
+  m_data_out = p_data_out;
+  m_data_in = p_data_in;
+  m_index = 0;
+  m_address_phase = false;
+  m_state = (p_data_out.empty() && not p_data_in.empty()) ? state::read
+                                                          : state::write;
+
+  auto last_events = m_events.load();
+  auto last_progress = m_clock->uptime();
+
+  enable_buffer_interrupt();
+  set(cr1::start);
+
+  while (m_state == state::write || m_state == state::read) {
+    try {
+      p_timeout();
+    } catch (...) {
+      reset_peripheral();
+      throw;
+    }
+
+    auto const events = m_events.load();
+    auto const now = m_clock->uptime();
+    if (events != last_events) {
+      last_events = events;
+      last_progress = now;
+    } else if (now - last_progress > m_stretch_timeout_ticks) {
+      // A device is holding the bus (clock stretching) for too long
+      reset_peripheral();
+      hal::safe_throw(hal::timed_out(this));
+    }
+  }
+
+  switch (m_state.load()) {
+    case state::address_nack:
+      m_state = state::idle;
+      hal::safe_throw(hal::no_such_device(p_address, this));
+      break;
+    case state::data_nack:
+      m_state = state::idle;
+      hal::safe_throw(hal::io_error(this));
+      break;
+    case state::bus_error:
+      reset_peripheral();
+      hal::safe_throw(hal::io_error(this));
+      break;
+    default:
+      m_state = state::idle;
+      break;
+  }
+}
+}  // namespace hal::micromod::stm32f1
@@ -0,0 +1,123 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+
+#include <libhal/i2c.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include "registers.hpp"
+
+namespace hal::micromod::stm32f1 {
+/**
+ * @brief Interrupt driven I2C controller on PB6 (SCL) & PB7 (SDA)
+ *
+ * Each transaction is run by a state machine in the I2C event & error
+ * interrupts, whose service routines must call `handle_event()` and
+ * `handle_error()`. Supports standard (up to 100kHz) and fast mode (up to
+ * 400kHz), write, read and write-then-read with a repeated start.
+ *
+ * If the bus makes no progress for longer than the clock stretch timeout, for
+ * example because a device holds SCL low, the transaction is aborted, the
+ * peripheral is reset and `hal::timed_out` is thrown. The same applies to the
+ * STOP of the previous transaction, which must go out before the next starts.
+ *
+ * Only one instance of this driver may exist per I2C peripheral.
+ */
+class i2c final : public hal::i2c
+{
+public:
+  /**
+   * @brief Construct a new i2c object
+   *
+   * The peripheral & GPIO port clocks are enabled, and SCL & SDA are set up
+   * as open drain alternate function outputs.
+   *
+   * @param p_i2c - I2C peripheral registers
+   * @param p_rcc - reset & clock control registers
+   * @param p_port - registers of GPIO port B, which holds SCL & SDA
+   * @param p_clock - steady clock used to detect a stalled bus
+   * @param p_bus_clock - frequency of the APB1 bus clocking the peripheral
+   * @param p_clock_stretch_timeout - maximum time the bus may go without an
+   * event before the transaction is aborted.
+   * @param p_settings - initial bus settings
+   */
+  i2c(i2c_reg_t& p_i2c,
+      rcc_reg_t& p_rcc,
+      gpio_reg_t& p_port,
+      hal::steady_clock& p_clock,
+      hal::hertz p_bus_clock,
+      hal::time_duration p_clock_stretch_timeout,
+      settings const& p_settings);
+
+  i2c(i2c const&) = delete;
+  i2c& operator=(i2c const&) = delete;
+  i2c(i2c&&) = delete;
+  i2c& operator=(i2c&&) = delete;
+  ~i2c() override;
+
+  /// Called from the I2C event interrupt service routine
+  void handle_event();
+  /// Called from the I2C error interrupt service routine
+  void handle_error();
+
+private:
+  enum class state : std::uint8_t
+  {
+    idle,
+    write,
+    read,
+    finished,
+    address_nack,
+    data_nack,
+    bus_error,
+  };
+
+  void driver_configure(settings const& p_settings) override;
+  void driver_transaction(
+    hal::byte p_address,
+    std::span<hal::byte const> p_data_out,
+    std::span<hal::byte> p_data_in,
+    hal::function_ref<hal::timeout_function> p_timeout) override;
+
+  void setup_peripheral();
+  void finish(state p_state);
+  void reset_peripheral();
+
+  void set(std::uint32_t p_mask);
+  void clear(std::uint32_t p_mask);
+  void clear_address_flag();
+  void enable_buffer_interrupt();
+  void disable_buffer_interrupt();
+
+  i2c_reg_t* m_i2c;
+  hal::steady_clock* m_clock;
+  hal::hertz m_bus_clock;
+  hal::u64 m_stretch_timeout_ticks;
+  settings m_settings{};
+  std::span<hal::byte const> m_data_out{};
+  std::span<hal::byte> m_data_in{};
+  std::size_t m_index = 0;
+  hal::byte m_address = 0;
+  bool m_address_phase = false;
+  std::atomic<state> m_state = state::idle;
+  /// Incremented on every interrupt so the caller can detect a stalled bus
+  std::atomic<std::uint32_t> m_events = 0;
+};
+}  // namespace hal::micromod::stm32f1
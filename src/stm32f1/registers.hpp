@@ -0,0 +1,425 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <libhal/units.hpp>
+
+/**
+ * @brief Register maps for the STM32F1 peripherals driven directly by the
+ * board library.
+ *
+ * Only the peripherals that libhal-arm-mcu does not already provide drivers
+ * for, or that the board needs to drive in a way the libhal-arm-mcu drivers do
+ * not support (DMA, timers, ...), are described here. See RM0008 for the
+ * meaning of each register.
+ */
+namespace hal::micromod::stm32f1 {
+using reg_t = std::uint32_t volatile;
+
+struct rcc_reg_t
+{
+  reg_t cr;
+  reg_t cfgr;
+  reg_t cir;
+  reg_t apb2rstr;
+  reg_t apb1rstr;
+  reg_t ahbenr;
+  reg_t apb2enr;
+  reg_t apb1enr;
+  reg_t bdcr;
+  reg_t csr;
+};
+
+struct gpio_reg_t
+{
+  reg_t crl;
+  reg_t crh;
+  reg_t idr;
+  reg_t odr;
+  reg_t bsrr;
+  reg_t brr;
+  reg_t lckr;
+};
+
+struct dma_channel_reg_t
+{
+  reg_t ccr;
+  reg_t cndtr;
+  reg_t cpar;
+  reg_t cmar;
+  reg_t reserved;
+};
+
+struct dma_reg_t
+{
+  reg_t isr;
+  reg_t ifcr;
+  dma_channel_reg_t channel[7];
+};
+
+struct i2c_reg_t
+{
+  reg_t cr1;
+  reg_t cr2;
+  reg_t oar1;
+  reg_t oar2;
+  reg_t dr;
+  reg_t sr1;
+  reg_t sr2;
+  reg_t ccr;
+  reg_t trise;
+};
+
+struct usart_reg_t
+{
+  reg_t sr;
+  reg_t dr;
+  reg_t brr;
+  reg_t cr1;
+  reg_t cr2;
+  reg_t cr3;
+  reg_t gtpr;
+};
+
+struct timer_reg_t
+{
+  reg_t cr1;
+  reg_t cr2;
+  reg_t smcr;
+  reg_t dier;
+  reg_t sr;
+  reg_t egr;
+  reg_t ccmr1;
+  reg_t ccmr2;
+  reg_t ccer;
+  reg_t cnt;
+  reg_t psc;
+  reg_t arr;
+  reg_t rcr;
+  reg_t ccr1;
+  reg_t ccr2;
+  reg_t ccr3;
+  reg_t ccr4;
+  reg_t bdtr;
+  reg_t dcr;
+  reg_t dmar;
+};
+
+struct adc_reg_t
+{
+  reg_t sr;
+  reg_t cr1;
+  reg_t cr2;
+  reg_t smpr1;
+  reg_t smpr2;
+  reg_t jofr[4];
+  reg_t htr;
+  reg_t ltr;
+  reg_t sqr1;
+  reg_t sqr2;
+  reg_t sqr3;
+  reg_t jsqr;
+  reg_t jdr[4];
+  reg_t dr;
+};
+
+struct can_mailbox_reg_t
+{
+  reg_t tir;
+  reg_t tdtr;
+  reg_t tdlr;
+  reg_t tdhr;
+};
+
+struct can_fifo_reg_t
+{
+  reg_t rir;
+  reg_t rdtr;
+  reg_t rdlr;
+  reg_t rdhr;
+};
+
+/// bxCAN registers up to the receive FIFO mailboxes
+struct can_reg_t
+{
+  reg_t mcr;
+  reg_t msr;
+  reg_t tsr;
+  reg_t rf0r;
+  reg_t rf1r;
+  reg_t ier;
+  reg_t esr;
+  reg_t btr;
+  reg_t reserved[88];
+  can_mailbox_reg_t transmit[3];
+  can_fifo_reg_t receive[2];
+};
+
+inline auto* rcc = reinterpret_cast<rcc_reg_t*>(0x4002'1000);
+inline auto* dma1 = reinterpret_cast<dma_reg_t*>(0x4002'0000);
+inline auto* i2c1 = reinterpret_cast<i2c_reg_t*>(0x4000'5400);
+inline auto* usart1 = reinterpret_cast<usart_reg_t*>(0x4001'3800);
+inline auto* timer1 = reinterpret_cast<timer_reg_t*>(0x4001'2C00);
+inline auto* timer2 = reinterpret_cast<timer_reg_t*>(0x4000'0000);
+inline auto* timer3 = reinterpret_cast<timer_reg_t*>(0x4000'0400);
+inline auto* timer4 = reinterpret_cast<timer_reg_t*>(0x4000'0800);
+inline auto* can1 = reinterpret_cast<can_reg_t*>(0x4000'6400);
+inline auto* adc1 = reinterpret_cast<adc_reg_t*>(0x4001'2400);
+inline auto* adc2 = reinterpret_cast<adc_reg_t*>(0x4001'2800);
+
+/**
+ * @brief Get the GPIO register block for a port
+ *
+ * @param p_port - port letter 'A' to 'E'
+ * @return gpio_reg_t* - register block of the port
+ */
+inline gpio_reg_t* gpio(char p_port)
+{
+  constexpr std::uintptr_t gpio_a_address = 0x4001'0800;
+  constexpr std::uintptr_t gpio_stride = 0x400;
+  return reinterpret_cast<gpio_reg_t*>(
+    gpio_a_address + (static_cast<std::uintptr_t>(p_port - 'A') * gpio_stride));
+}
+
+/// Bit positions of the RCC enable registers
+namespace rcc_enable {
+// AHBENR
+constexpr std::uint32_t dma1 = 1 << 0;
+// APB2ENR, the clocks of ports B to E follow port A's
+constexpr std::uint32_t gpio_a = 1 << 2;
+constexpr std::uint32_t gpio_b = 1 << 3;
+constexpr std::uint32_t adc1 = 1 << 9;
+constexpr std::uint32_t adc2 = 1 << 10;
+constexpr std::uint32_t timer1 = 1 << 11;
+// APB1ENR
+constexpr std::uint32_t timer2 = 1 << 0;
+constexpr std::uint32_t timer3 = 1 << 1;
+constexpr std::uint32_t timer4 = 1 << 2;
+constexpr std::uint32_t i2c1 = 1 << 21;
+}  // namespace rcc_enable
+
+/// Bit positions of a DMA channel's CCR register
+namespace dma_ccr {
+constexpr std::uint32_t enable = 1 << 0;
+constexpr std::uint32_t transfer_complete_interrupt = 1 << 1;
+constexpr std::uint32_t half_transfer_interrupt = 1 << 2;
+constexpr std::uint32_t transfer_error_interrupt = 1 << 3;
+constexpr std::uint32_t memory_to_peripheral = 1 << 4;
+constexpr std::uint32_t circular = 1 << 5;
+constexpr std::uint32_t peripheral_increment = 1 << 6;
+constexpr std::uint32_t memory_increment = 1 << 7;
+constexpr std::uint32_t peripheral_16_bit = 0b01 << 8;
+constexpr std::uint32_t peripheral_32_bit = 0b10 << 8;
+constexpr std::uint32_t memory_16_bit = 0b01 << 10;
+constexpr std::uint32_t memory_32_bit = 0b10 << 10;
+constexpr std::uint32_t priority_high = 0b10 << 12;
+constexpr std::uint32_t priority_very_high = 0b11 << 12;
+}  // namespace dma_ccr
+
+/**
+ * @brief DMA ISR/IFCR flag for a channel
+ *
+ * @param p_channel - DMA channel number starting at 1
+ * @param p_flag - 0 = global, 1 = transfer complete, 2 = half transfer,
+ * 3 = transfer error
+ * @return constexpr std::uint32_t - flag mask
+ */
+constexpr std::uint32_t dma_flag(std::uint32_t p_channel, std::uint32_t p_flag)
+{
+  return 1U << (((p_channel - 1) * 4) + p_flag);
+}
+
+/// Bit positions of the USART registers
+namespace usart_bits {
+// CR3
+constexpr std::uint32_t dma_transmit = 1 << 7;
+}  // namespace usart_bits
+
+/// Bit positions of the timer registers shared by the drivers
+namespace timer_bits {
+// CR1
+constexpr std::uint32_t counter_enable = 1 << 0;
+constexpr std::uint32_t update_disable = 1 << 1;
+constexpr std::uint32_t one_pulse = 1 << 3;
+/// Read only in the center aligned modes, set while the counter counts down
+constexpr std::uint32_t direction_down = 1 << 4;
+constexpr std::uint32_t center_aligned_1 = 0b01 << 5;
+constexpr std::uint32_t auto_reload_preload = 1 << 7;
+// CR2, TRGO pulses when the counter is enabled
+constexpr std::uint32_t master_mode_enable = 0b001 << 4;
+// SMCR, the counter is enabled by TRGI, which is ITR0 with TS = 0
+constexpr std::uint32_t slave_mode_trigger = 0b110 << 0;
+// DIER
+constexpr std::uint32_t update_interrupt = 1 << 0;
+constexpr std::uint32_t cc1_interrupt = 1 << 1;
+constexpr std::uint32_t update_dma = 1 << 8;
+constexpr std::uint32_t cc1_dma = 1 << 9;
+constexpr std::uint32_t cc3_dma = 1 << 11;
+// EGR
+constexpr std::uint32_t update_generation = 1 << 0;
+// CCMR1 & CCMR2, for the first channel of each, shifted by 8 for the second
+constexpr std::uint32_t output_compare_preload = 1 << 3;
+constexpr std::uint32_t pwm_mode_1 = 0b110 << 4;
+constexpr std::uint32_t pwm_mode_2 = 0b111 << 4;
+constexpr std::uint32_t output_compare_mask = 0xFF;
+// CCER, for channel 1, shifted by 4 for each following channel
+constexpr std::uint32_t compare_output_enable = 1 << 0;
+// BDTR, TIM1 only
+constexpr std::uint32_t main_output_enable = 1 << 15;
+// SR
+constexpr std::uint32_t update_flag = 1 << 0;
+constexpr std::uint32_t cc1_flag = 1 << 1;
+}  // namespace timer_bits
+
+/// Bit positions of the ADC registers
+namespace adc_bits {
+// SR
+constexpr std::uint32_t injected_end = 1 << 2;
+// CR1
+constexpr std::uint32_t injected_interrupt = 1 << 7;
+constexpr std::uint32_t scan = 1 << 8;
+// CR2
+constexpr std::uint32_t power_on = 1 << 0;
+constexpr std::uint32_t continuous = 1 << 1;
+constexpr std::uint32_t calibrate = 1 << 2;
+constexpr std::uint32_t reset_calibration = 1 << 3;
+constexpr std::uint32_t dma = 1 << 8;
+constexpr std::uint32_t injected_trigger_timer1_cc4 = 0b001 << 12;
+constexpr std::uint32_t injected_external_trigger = 1 << 15;
+constexpr std::uint32_t software_trigger = 0b111 << 17;
+constexpr std::uint32_t external_trigger = 1 << 20;
+constexpr std::uint32_t software_start = 1 << 22;
+constexpr std::uint32_t internal_channels = 1 << 23;
+// SMPRx
+constexpr std::uint32_t sample_time_mask = 0b111;
+/// Longest sample time, 239.5 ADC clock cycles
+constexpr std::uint32_t sample_time_239 = 0b111;
+/// 28.5 ADC clock cycles
+constexpr std::uint32_t sample_time_28 = 0b011;
+// SQR1
+constexpr std::uint32_t sequence_length(std::uint32_t p_conversions)
+{
+  return (p_conversions - 1) << 20;
+}
+// JSQR, a sequence of two converts JSQ3 then JSQ4 into JDR1 & JDR2
+constexpr std::uint32_t injected_pair(std::uint32_t p_first,
+                                      std::uint32_t p_second)
+{
+  return (1U << 20) | (p_second << 15) | (p_first << 10);
+}
+}  // namespace adc_bits
+
+/// Bit positions of the bxCAN registers
+namespace can_bits {
+// MCR
+constexpr std::uint32_t initialization_request = 1 << 0;
+constexpr std::uint32_t transmit_fifo_priority = 1 << 2;
+constexpr std::uint32_t time_triggered_mode = 1 << 7;
+// MSR
+constexpr std::uint32_t initialization_acknowledge = 1 << 0;
+// RF0R
+constexpr std::uint32_t fifo_pending_mask = 0b11;
+constexpr std::uint32_t fifo_overrun = 1 << 4;
+// IER
+constexpr std::uint32_t transmit_mailbox_empty_interrupt = 1 << 0;
+// ESR
+constexpr std::uint32_t bus_off = 1 << 2;
+constexpr std::uint32_t transmit_error_count(std::uint32_t p_esr)
+{
+  return (p_esr >> 16) & 0xFF;
+}
+constexpr std::uint32_t receive_error_count(std::uint32_t p_esr)
+{
+  return (p_esr >> 24) & 0xFF;
+}
+// BTR
+constexpr std::uint32_t prescaler(std::uint32_t p_btr)
+{
+  return (p_btr & 0x3FF) + 1;
+}
+/// Synchronization segment + time segment 1 + time segment 2
+constexpr std::uint32_t quanta_per_bit(std::uint32_t p_btr)
+{
+  return 1 + (((p_btr >> 16) & 0xF) + 1) + (((p_btr >> 20) & 0x7) + 1);
+}
+// TIxR & RIxR
+constexpr std::uint32_t transmit_request = 1 << 0;
+constexpr std::uint32_t remote_request = 1 << 1;
+constexpr std::uint32_t extended_identifier = 1 << 2;
+// TDTxR & RDTxR
+constexpr std::uint32_t data_length_mask = 0xF;
+/// Bit time counter captured at the start of frame, in time triggered mode
+constexpr std::uint16_t capture_time(std::uint32_t p_dtr)
+{
+  return static_cast<std::uint16_t>(p_dtr >> 16);
+}
+
+/// TSR request completed flag of a mailbox, writing it clears its status
+constexpr std::uint32_t request_completed(std::size_t p_mailbox)
+{
+  return 1U << (p_mailbox * 8);
+}
+
+/// TSR flag set when a mailbox's request completed by a transmission
+constexpr std::uint32_t transmission_ok(std::size_t p_mailbox)
+{
+  return 1U << ((p_mailbox * 8) + 1);
+}
+
+/// TSR flag requesting that a mailbox be aborted
+constexpr std::uint32_t abort_request(std::size_t p_mailbox)
+{
+  return 1U << ((p_mailbox * 8) + 7);
+}
+}  // namespace can_bits
+
+/**
+ * @brief Get the frequency of the APB1 or APB2 bus
+ *
+ * @param p_ahb_frequency - frequency of the AHB bus (the cpu clock)
+ * @param p_apb2 - true for APB2, false for APB1
+ * @return hal::hertz - frequency of the APB bus
+ */
+inline hal::hertz apb_clock_frequency(hal::hertz p_ahb_frequency, bool p_apb2)
+{
+  auto const ppre = (rcc->cfgr >> (p_apb2 ? 11 : 8)) & 0b111;
+  if (ppre < 0b100) {
+    return p_ahb_frequency;
+  }
+  return p_ahb_frequency / static_cast<float>(1U << (ppre - 0b011));
+}
+
+/**
+ * @brief Get the input clock frequency of the timers on the APB1 or APB2 bus
+ *
+ * When the APB prescaler is not 1, the timer clock runs at twice the APB clock.
+ *
+ * @param p_ahb_frequency - frequency of the AHB bus (the cpu clock)
+ * @param p_apb2 - true for timer1 (APB2), false for timer2 to timer4 (APB1)
+ * @return hal::hertz - frequency of the timer kernel clock
+ */
+inline hal::hertz timer_clock_frequency(hal::hertz p_ahb_frequency,
+                                        bool p_apb2)
+{
+  auto const apb_frequency = apb_clock_frequency(p_ahb_frequency, p_apb2);
+  if (apb_frequency == p_ahb_frequency) {
+    return p_ahb_frequency;
+  }
+  return apb_frequency * 2.0f;
+}
+}  // namespace hal::micromod::stm32f1
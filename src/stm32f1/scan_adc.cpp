@@ -0,0 +1,185 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "scan_adc.hpp"
+
+#include <array>
+
+#include <libhal-arm-mcu/interrupt.hpp>
+#include <libhal-arm-mcu/stm32f1/interrupt.hpp>
+
+#include "registers.hpp"
+
+namespace hal::micromod::stm32f1 {
+namespace {
+constexpr std::uint32_t adc_channel = 1;
+constexpr hal::cortex_m::irq_t dma1_channel1_irq = 11;
+/// ADC channels of a frame, in analog_channel order
+constexpr std::array<std::uint32_t, analog_channels> scan_group{ 8, 9, 17 };
+/// ADC clock cycles of a conversion, sampling for 239.5 then converting
+constexpr float conversion_cycles = 239.5f + 12.5f;
+/// Fastest clock the ADC runs at
+constexpr hal::hertz maximum_adc_clock = 14'000'000.0f;
+
+scan_adc* active_driver = nullptr;
+
+void dma1_channel1_handler()
+{
+  if (active_driver != nullptr) {
+    active_driver->handle_interrupt();
+  }
+}
+
+dma_channel_reg_t& channel()
+{
+  return dma1->channel[adc_channel - 1];
+}
+
+/// ADCPRE value giving the fastest ADC clock the ADC supports, /2 to /8
+std::uint32_t adc_prescaler(hal::hertz p_cpu_frequency)
+{
+  auto const apb2 = apb_clock_frequency(p_cpu_frequency, true);
+  std::uint32_t prescaler = 0;
+  while (prescaler < 0b11 &&
+         apb2 / static_cast<float>(2 * (prescaler + 1)) > maximum_adc_clock) {
+    prescaler++;
+  }
+  return prescaler;
+}
+
+hal::hertz scan_frame_rate(hal::hertz p_cpu_frequency)
+{
+  auto const divider = 2 * (adc_prescaler(p_cpu_frequency) + 1);
+  auto const adc_clock =
+    apb_clock_frequency(p_cpu_frequency, true) / static_cast<float>(divider);
+  return adc_clock / (conversion_cycles * static_cast<float>(analog_channels));
+}
+
+void sample_time(std::uint32_t p_channel, std::uint32_t p_time)
+{
+  auto& smpr = p_channel < 10 ? adc1->smpr2 : adc1->smpr1;
+  auto const shift = (p_channel % 10) * 3;
+  smpr = (smpr & ~(adc_bits::sample_time_mask << shift)) | (p_time << shift);
+}
+
+/// Clock an ADC & the analog input pins, ADC1 & ADC2 share the prescaler
+void enable_adc_clock(std::uint32_t p_adc, hal::hertz p_cpu_frequency)
+{
+  rcc->apb2enr = rcc->apb2enr | p_adc | rcc_enable::gpio_b;
+  constexpr std::uint32_t adc_prescaler_shift = 14;
+  rcc->cfgr = (rcc->cfgr & ~(0b11U << adc_prescaler_shift)) |
+              (adc_prescaler(p_cpu_frequency) << adc_prescaler_shift);
+  // PB0 & PB1 as analog inputs
+  gpio('B')->crl = gpio('B')->crl & ~0xFFU;
+}
+
+/// Power an ADC up & calibrate it, leaving it on with p_cr2 set
+void calibrate(adc_reg_t& p_adc,
+               hal::hertz p_cpu_frequency,
+               std::uint32_t p_cr2)
+{
+  p_adc.cr2 = adc_bits::power_on | p_cr2;
+  // Wait out the 1us power up time, each read takes at least one APB2 cycle
+  auto const power_up_reads =
+    static_cast<std::uint32_t>(p_cpu_frequency / 1'000'000.0f);
+  for (std::uint32_t i = 0; i < power_up_reads; i++) {
+    static_cast<void>(p_adc.sr);
+  }
+  p_adc.cr2 = p_adc.cr2 | adc_bits::reset_calibration;
+  while (p_adc.cr2 & adc_bits::reset_calibration) {
+    continue;
+  }
+  p_adc.cr2 = p_adc.cr2 | adc_bits::calibrate;
+  while (p_adc.cr2 & adc_bits::calibrate) {
+    continue;
+  }
+}
+}  // namespace
+
+scan_adc::scan_adc(hal::hertz p_cpu_frequency, std::span<hal::u16> p_buffer)
+  : analog_stream(p_buffer, scan_frame_rate(p_cpu_frequency))
+{
+  rcc->ahbenr = rcc->ahbenr | rcc_enable::dma1;
+  enable_adc_clock(rcc_enable::adc1, p_cpu_frequency);
+  calibrate(*adc1, p_cpu_frequency, adc_bits::internal_channels);
+
+  std::uint32_t sequence = 0;
+  for (std::size_t i = 0; i < scan_group.size(); i++) {
+    // The reference needs 17.1us of sampling, the longest time covers it
+    sample_time(scan_group[i], adc_bits::sample_time_239);
+    sequence |= scan_group[i] << (5 * i);
+  }
+  adc1->sqr1 = adc_bits::sequence_length(scan_group.size());
+  adc1->sqr3 = sequence;
+  adc1->cr1 = adc_bits::scan;
+
+  auto const samples = buffer();
+  channel().ccr = 0;
+  channel().cpar = reinterpret_cast<std::uintptr_t>(&adc1->dr);
+  channel().cmar = reinterpret_cast<std::uintptr_t>(samples.data());
+  channel().cndtr = static_cast<std::uint32_t>(samples.size());
+  dma1->ifcr = dma_flag(adc_channel, 0);
+  channel().ccr = dma_ccr::circular | dma_ccr::memory_increment |
+                  dma_ccr::peripheral_16_bit | dma_ccr::memory_16_bit |
+                  dma_ccr::half_transfer_interrupt |
+                  dma_ccr::transfer_complete_interrupt | dma_ccr::enable;
+
+  active_driver = this;
+  hal::stm32f1::initialize_interrupts();
+  hal::cortex_m::enable_interrupt(dma1_channel1_irq, dma1_channel1_handler);
+
+  adc1->cr2 = adc_bits::power_on | adc_bits::continuous | adc_bits::dma |
+              adc_bits::software_trigger | adc_bits::external_trigger |
+              adc_bits::internal_channels;
+  adc1->cr2 = adc1->cr2 | adc_bits::software_start;
+}
+
+scan_adc::~scan_adc()
+{
+  adc1->cr2 = 0;
+  hal::cortex_m::disable_interrupt(dma1_channel1_irq);
+  channel().ccr = 0;
+  active_driver = nullptr;
+}
+
+std::size_t scan_adc::written()
+{
+  return buffer().size() - channel().cndtr;
+}
+
+void scan_adc::handle_interrupt()
+{
+  auto const half_flag = dma_flag(adc_channel, 2);
+  auto const full_flag = dma_flag(adc_channel, 1);
+  auto const status = dma1->isr & (half_flag | full_flag);
+  dma1->ifcr = status;
+  if (status == (half_flag | full_flag)) {
+    // Both halves completed since the last interrupt, the one not being
+    // written completed last
+    auto const latest = written() < buffer().size() / 2 ? 1U : 0U;
+    block_complete(1 - latest);
+    block_complete(latest);
+  } else if (status == half_flag) {
+    block_complete(0);
+  } else if (status == full_flag) {
+    block_complete(1);
+  }
+}
+
+void power_on_adc2(hal::hertz p_cpu_frequency)
+{
+  enable_adc_clock(rcc_enable::adc2, p_cpu_frequency);
+  calibrate(*adc2, p_cpu_frequency, 0);
+}
+}  // namespace hal::micromod::stm32f1
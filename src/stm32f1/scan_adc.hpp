@@ -0,0 +1,73 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <span>
+
+#include <libhal-micromod/analog_stream.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::micromod::stm32f1 {
+/**
+ * @brief ADC1 converting every MicroMod analog input in scan mode, with DMA
+ * writing the frames into the stream's double buffer
+ *
+ * ADC1 converts the scan group continuously, each input sampled for 239.5 ADC
+ * clock cycles, so frames come at a fixed rate set by the ADC clock alone. DMA1
+ * channel 1 (ADC1) copies each conversion into the buffer in circular mode and
+ * raises its half & full transfer interrupts as blocks complete.
+ *
+ * A0 is PB0 (ADC12_IN8) & A1 is PB1 (ADC12_IN9). BATT_VIN/3 is not routed to
+ * an ADC pin on the v4 & v5 boards, so the battery slot of each frame samples
+ * the internal 1.2V reference (ADC12_IN17) instead.
+ *
+ * Only one instance of this driver may exist as it owns ADC1 & DMA1 channel 1.
+ */
+class scan_adc final : public hal::micromod::analog_stream
+{
+public:
+  /**
+   * @brief Construct a new scan adc object & start converting
+   *
+   * @param p_cpu_frequency - frequency of the cpu & AHB bus
+   * @param p_buffer - two blocks of whole frames, at most 65535 samples, must
+   * outlive the driver
+   */
+  scan_adc(hal::hertz p_cpu_frequency, std::span<hal::u16> p_buffer);
+
+  scan_adc(scan_adc const&) = delete;
+  scan_adc& operator=(scan_adc const&) = delete;
+  scan_adc(scan_adc&&) = delete;
+  scan_adc& operator=(scan_adc&&) = delete;
+  ~scan_adc() override;
+
+  /// Called from the DMA1 channel 1 interrupt service routine
+  void handle_interrupt();
+
+private:
+  std::size_t written() override;
+};
+
+/**
+ * @brief Power ADC2 up & calibrate it, for the injected conversions of a
+ * center_aligned_pwm
+ *
+ * Sets the ADC clock prescaler ADC2 shares with ADC1, which a scan_adc sets
+ * the same way, & makes PB0 & PB1 analog inputs.
+ *
+ * @param p_cpu_frequency - frequency of the cpu & AHB bus
+ */
+void power_on_adc2(hal::hertz p_cpu_frequency);
+}  // namespace hal::micromod::stm32f1
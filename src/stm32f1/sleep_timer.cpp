@@ -0,0 +1,112 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sleep_timer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <libhal-arm-mcu/interrupt.hpp>
+#include <libhal-arm-mcu/stm32f1/interrupt.hpp>
+
+#include "registers.hpp"
+
+namespace hal::micromod::stm32f1 {
+namespace {
+constexpr hal::cortex_m::irq_t timer4_irq = 30;
+constexpr hal::hertz tick_frequency = 1'000'000.0f;
+
+sleep_timer* active_driver = nullptr;
+
+void timer4_handler()
+{
+  if (active_driver != nullptr) {
+    active_driver->handle_interrupt();
+  }
+}
+}  // namespace
+
+sleep_timer::sleep_timer(hal::hertz p_cpu_frequency,
+                         hal::callback<void(void)> p_on_period)
+  : m_on_period(p_on_period)
+{
+  rcc->apb1enr = rcc->apb1enr | rcc_enable::timer4;
+
+  auto const timer_clock = timer_clock_frequency(p_cpu_frequency, false);
+  auto const prescaler = std::clamp<std::uint32_t>(
+    static_cast<std::uint32_t>(timer_clock / tick_frequency), 1, 65536);
+  // The APB1 timer clock is the cpu clock divided by a power of 2 and doubled,
+  // so this is an integer.
+  m_cycles_per_tick = static_cast<hal::u64>(std::lround(
+    static_cast<float>(prescaler) * (p_cpu_frequency / timer_clock)));
+
+  timer4->cr1 = 0;
+  timer4->dier = 0;
+  timer4->psc = prescaler - 1;
+  timer4->arr = 0xFFFF;
+  // Load the prescaler
+  timer4->egr = timer_bits::update_generation;
+  timer4->sr = 0;
+  timer4->dier = timer_bits::update_interrupt;
+  timer4->cr1 = timer_bits::counter_enable;
+
+  active_driver = this;
+  hal::stm32f1::initialize_interrupts();
+  hal::cortex_m::enable_interrupt(timer4_irq, timer4_handler);
+}
+
+sleep_timer::~sleep_timer()
+{
+  hal::cortex_m::disable_interrupt(timer4_irq);
+  timer4->cr1 = 0;
+  timer4->dier = 0;
+  rcc->apb1enr = rcc->apb1enr & ~rcc_enable::timer4;
+  active_driver = nullptr;
+}
+
+std::uint32_t sleep_timer::start()
+{
+  auto const start = static_cast<std::uint16_t>(timer4->cnt);
+  timer4->ccr1 = static_cast<std::uint16_t>(start + maximum_sleep_ticks);
+  // SR flags are cleared by writing 0, writing 1 leaves them unchanged
+  timer4->sr = ~timer_bits::cc1_flag;
+  timer4->dier = timer_bits::update_interrupt | timer_bits::cc1_interrupt;
+  return start;
+}
+
+hal::u64 sleep_timer::stop(std::uint32_t p_start)
+{
+  auto const now = static_cast<std::uint16_t>(timer4->cnt);
+  auto const elapsed = static_cast<std::uint16_t>(now - p_start);
+  timer4->dier = timer_bits::update_interrupt;
+  return elapsed * m_cycles_per_tick;
+}
+
+hal::u64 sleep_timer::resolution() const
+{
+  return m_cycles_per_tick;
+}
+
+void sleep_timer::handle_interrupt()
+{
+  auto const status = timer4->sr;
+  // SR flags are cleared by writing 0, writing 1 leaves them unchanged. The
+  // compare interrupt only exists to wake the core, the sleep is accounted for
+  // by stop().
+  timer4->sr = ~status;
+  if (status & timer_bits::update_flag) {
+    m_on_period();
+  }
+}
+}  // namespace hal::micromod::stm32f1
@@ -0,0 +1,90 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include <libhal/functional.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::micromod::stm32f1 {
+/**
+ * @brief Measures the time the core spends asleep with TIM4
+ *
+ * TIM4 is clocked from APB1, which keeps running while the core waits for an
+ * interrupt. It counts freely at 1MHz, and a compare interrupt wakes the core
+ * before the 16-bit counter can wrap, so a sleep is never ambiguous.
+ *
+ * The update interrupt, raised each time the counter wraps (every 65.536ms),
+ * doubles as a periodic interrupt for keeping the 64-bit extension of the
+ * uptime clock up to date.
+ *
+ * See hal::micromod::compensated_clock. Only one instance of this driver may
+ * exist as it owns TIM4.
+ */
+class sleep_timer
+{
+public:
+  /// Longest sleep in timer ticks before the compare interrupt wakes the core
+  static constexpr std::uint16_t maximum_sleep_ticks = 60'000;
+
+  /**
+   * @brief Construct a new sleep timer object
+   *
+   * @param p_cpu_frequency - frequency of the cpu & AHB bus
+   * @param p_on_period - called from the update interrupt each time the
+   * counter wraps
+   */
+  sleep_timer(hal::hertz p_cpu_frequency,
+              hal::callback<void(void)> p_on_period);
+
+  sleep_timer(sleep_timer const&) = delete;
+  sleep_timer& operator=(sleep_timer const&) = delete;
+  sleep_timer(sleep_timer&&) = delete;
+  sleep_timer& operator=(sleep_timer&&) = delete;
+  ~sleep_timer();
+
+  /**
+   * @brief Start measuring a sleep
+   *
+   * Arms the compare interrupt to bound the sleep.
+   *
+   * @return std::uint32_t - counter value to pass to stop()
+   */
+  std::uint32_t start();
+
+  /**
+   * @brief Stop measuring a sleep
+   *
+   * @param p_start - value returned by start()
+   * @return hal::u64 - cpu cycles elapsed since start()
+   */
+  hal::u64 stop(std::uint32_t p_start);
+
+  /**
+   * @brief Get the resolution of the measurements
+   *
+   * @return hal::u64 - cpu cycles per timer tick
+   */
+  [[nodiscard]] hal::u64 resolution() const;
+
+  /// Called from the TIM4 interrupt service routine
+  void handle_interrupt();
+
+private:
+  hal::callback<void(void)> m_on_period;
+  hal::u64 m_cycles_per_tick = 1;
+};
+}  // namespace hal::micromod::stm32f1
@@ -0,0 +1,162 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "timer_pwm.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hal::micromod::stm32f1 {
+namespace {
+constexpr std::uint32_t maximum_prescaler = 65536;
+/// Longest period whose 100% compare value still fits in the 16-bit CCR
+constexpr std::uint32_t maximum_period = 65535;
+constexpr std::uint32_t minimum_period = 2;
+/// CNF/MODE nibble of a 50MHz alternate function push-pull output
+constexpr std::uint32_t alternate_push_pull = 0b1011;
+}  // namespace
+
+pwm_timer::pwm_timer(timer_reg_t& p_timer,
+                     hal::hertz p_clock_frequency,
+                     bool p_advanced)
+  : m_timer(&p_timer)
+  , m_clock_frequency(p_clock_frequency)
+{
+  m_timer->cr1 = 0;
+  m_timer->dier = 0;
+  m_timer->ccmr1 = 0;
+  m_timer->ccmr2 = 0;
+  m_timer->ccer = 0;
+  m_timer->cnt = 0;
+  frequency(default_frequency);
+  // Load the preloaded registers now rather than at the end of a period
+  m_timer->egr = timer_bits::update_generation;
+  m_timer->sr = 0;
+  if (p_advanced) {
+    m_timer->bdtr = timer_bits::main_output_enable;
+  }
+  m_timer->cr1 = timer_bits::auto_reload_preload | timer_bits::counter_enable;
+}
+
+pwm_timer::~pwm_timer()
+{
+  m_timer->cr1 = 0;
+  m_timer->ccer = 0;
+}
+
+void pwm_timer::enable(std::uint8_t p_channel)
+{
+  auto const index = p_channel - 1U;
+  auto& ccmr = index < 2 ? m_timer->ccmr1 : m_timer->ccmr2;
+  auto const shift = (index % 2) * 8;
+  m_duty_cycles[index] = 0.0f;
+  compare(p_channel) = 0;
+  ccmr = (ccmr & ~(timer_bits::output_compare_mask << shift)) |
+         ((timer_bits::pwm_mode_1 | timer_bits::output_compare_preload)
+          << shift);
+  m_timer->ccer =
+    m_timer->ccer | (timer_bits::compare_output_enable << (index * 4));
+}
+
+void pwm_timer::frequency(hal::hertz p_frequency)
+{
+  auto const ticks = m_clock_frequency / p_frequency;
+  auto const prescaler = std::clamp<float>(
+    std::ceil(ticks / static_cast<float>(maximum_period)),
+    1.0f,
+    static_cast<float>(maximum_prescaler));
+  m_prescaler = static_cast<std::uint32_t>(prescaler);
+  m_period = static_cast<std::uint32_t>(
+    std::clamp<float>(std::round(ticks / prescaler),
+                      static_cast<float>(minimum_period),
+                      static_cast<float>(maximum_period)));
+
+  // Hold the new values in the preload registers until all are written, so the
+  // period & compare values change together.
+  m_timer->cr1 = m_timer->cr1 | timer_bits::update_disable;
+  m_timer->psc = m_prescaler - 1;
+  m_timer->arr = m_period - 1;
+  for (std::uint8_t channel = 1; channel <= channels; channel++) {
+    compare(channel) = compare_value(m_duty_cycles[channel - 1U]);
+  }
+  m_timer->cr1 = m_timer->cr1 & ~timer_bits::update_disable;
+}
+
+hal::hertz pwm_timer::frequency() const
+{
+  return m_clock_frequency / static_cast<float>(m_prescaler * m_period);
+}
+
+std::uint32_t pwm_timer::period() const
+{
+  return m_period;
+}
+
+void pwm_timer::duty_cycle(std::uint8_t p_channel, float p_duty_cycle)
+{
+  auto const duty_cycle = std::clamp(p_duty_cycle, 0.0f, 1.0f);
+  m_duty_cycles[p_channel - 1U] = duty_cycle;
+  // A single preloaded register, which the update event loads whole
+  compare(p_channel) = compare_value(duty_cycle);
+}
+
+reg_t& pwm_timer::compare(std::uint8_t p_channel)
+{
+  switch (p_channel) {
+    case 1:
+      return m_timer->ccr1;
+    case 2:
+      return m_timer->ccr2;
+    case 3:
+      return m_timer->ccr3;
+    default:
+      return m_timer->ccr4;
+  }
+}
+
+std::uint32_t pwm_timer::compare_value(float p_duty_cycle) const
+{
+  // In PWM mode 1 the output is high while the counter is below the compare
+  // value, so a compare value of the period holds it high.
+  return static_cast<std::uint32_t>(
+    std::lround(p_duty_cycle * static_cast<float>(m_period)));
+}
+
+timer_pwm::timer_pwm(pwm_timer& p_timer, std::uint8_t p_channel)
+  : m_timer(&p_timer)
+  , m_channel(p_channel)
+{
+  m_timer->enable(m_channel);
+}
+
+void timer_pwm::driver_frequency(hal::hertz p_frequency)
+{
+  m_timer->frequency(p_frequency);
+}
+
+void timer_pwm::driver_duty_cycle(float p_duty_cycle)
+{
+  m_timer->duty_cycle(m_channel, p_duty_cycle);
+}
+
+void connect_timer_output(char p_port, std::uint8_t p_pin)
+{
+  auto const port = static_cast<std::uint32_t>(p_port - 'A');
+  rcc->apb2enr = rcc->apb2enr | (rcc_enable::gpio_a << port);
+  auto* const gpio_port = gpio(p_port);
+  auto& config = p_pin < 8 ? gpio_port->crl : gpio_port->crh;
+  auto const shift = (p_pin % 8U) * 4;
+  config = (config & ~(0xFU << shift)) | (alternate_push_pull << shift);
+}
+}  // namespace hal::micromod::stm32f1
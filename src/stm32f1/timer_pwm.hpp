@@ -0,0 +1,147 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <libhal/pwm.hpp>
+#include <libhal/units.hpp>
+
+#include "registers.hpp"
+
+namespace hal::micromod::stm32f1 {
+/**
+ * @brief Timer generating edge aligned PWM on its channels
+ *
+ * Every channel of a timer counts with the same counter, so they share one
+ * frequency: changing it through any channel changes it for all of them, and
+ * the compare value of each is rescaled to keep its duty cycle.
+ *
+ * The prescaler, auto-reload & compare registers are all preloaded, so a new
+ * frequency or duty cycle takes effect at the update event ending the current
+ * period, at most one period after it is written. A period is never cut short
+ * & no runt pulse is ever output. Updates are disabled while a frequency
+ * change writes several registers, so they all take effect in the same period.
+ *
+ * Only the timer's registers are touched: its clock must be on & its output
+ * pins connected, see connect_timer_output(). Only one instance may exist per
+ * timer, as it owns the timer.
+ */
+class pwm_timer
+{
+public:
+  static constexpr std::uint8_t channels = 4;
+  static constexpr hal::hertz default_frequency = 1'000.0f;
+
+  /**
+   * @brief Construct a new pwm timer object & start counting
+   *
+   * Runs at the default frequency, with every channel's output off.
+   *
+   * @param p_timer - registers of the timer, must outlive the object
+   * @param p_clock_frequency - timer kernel clock, see timer_clock_frequency()
+   * @param p_advanced - true for TIM1, whose outputs are also gated by the
+   * main output enable
+   */
+  pwm_timer(timer_reg_t& p_timer,
+            hal::hertz p_clock_frequency,
+            bool p_advanced);
+
+  pwm_timer(pwm_timer const&) = delete;
+  pwm_timer& operator=(pwm_timer const&) = delete;
+  pwm_timer(pwm_timer&&) = delete;
+  pwm_timer& operator=(pwm_timer&&) = delete;
+  ~pwm_timer();
+
+  /**
+   * @brief Output PWM on a channel, starting at a 0% duty cycle
+   *
+   * @param p_channel - timer channel, 1 to 4
+   */
+  void enable(std::uint8_t p_channel);
+
+  /**
+   * @brief Change the frequency of every channel
+   *
+   * Takes the smallest prescaler that fits the period into the 16-bit counter,
+   * which gives the finest duty cycle resolution. Frequencies outside of
+   * clock / 65536 / 65535 to clock / 2 are limited to that range.
+   *
+   * @param p_frequency - PWM frequency
+   */
+  void frequency(hal::hertz p_frequency);
+
+  /// Frequency the counter actually runs at, after rounding
+  [[nodiscard]] hal::hertz frequency() const;
+
+  /// Counter ticks per period, the number of duty cycle steps
+  [[nodiscard]] std::uint32_t period() const;
+
+  /**
+   * @brief Change the duty cycle of a channel
+   *
+   * @param p_channel - timer channel, 1 to 4
+   * @param p_duty_cycle - high time over the period, limited to 0 to 1
+   */
+  void duty_cycle(std::uint8_t p_channel, float p_duty_cycle);
+
+private:
+  [[nodiscard]] reg_t& compare(std::uint8_t p_channel);
+  [[nodiscard]] std::uint32_t compare_value(float p_duty_cycle) const;
+
+  timer_reg_t* m_timer;
+  hal::hertz m_clock_frequency;
+  std::uint32_t m_prescaler = 1;
+  std::uint32_t m_period = 2;
+  std::array<float, channels> m_duty_cycles{};
+};
+
+/**
+ * @brief One channel of a pwm_timer
+ *
+ * Setting the frequency changes it for every channel of the timer.
+ */
+class timer_pwm final : public hal::pwm
+{
+public:
+  /**
+   * @brief Construct a new timer pwm object & enable the channel's output
+   *
+   * @param p_timer - timer of the channel, must outlive the pwm
+   * @param p_channel - timer channel, 1 to 4
+   */
+  timer_pwm(pwm_timer& p_timer, std::uint8_t p_channel);
+
+private:
+  void driver_frequency(hal::hertz p_frequency) override;
+  void driver_duty_cycle(float p_duty_cycle) override;
+
+  pwm_timer* m_timer;
+  std::uint8_t m_channel;
+};
+
+/**
+ * @brief Connect a pin to the timer channel output it is an alternate
+ * function of
+ *
+ * Turns the port's clock on & makes the pin a 50MHz alternate function
+ * push-pull output.
+ *
+ * @param p_port - port letter, 'A' to 'E'
+ * @param p_pin - pin number, 0 to 15
+ */
+void connect_timer_output(char p_port, std::uint8_t p_pin);
+}  // namespace hal::micromod::stm32f1
@@ -0,0 +1,370 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/timer_wheel.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <mutex>
+
+namespace hal::micromod {
+namespace {
+constexpr hal::u64 slot_mask = timer_wheel::slots_per_level - 1;
+
+constexpr hal::u64 level_shift(std::size_t p_level)
+{
+  return p_level * timer_wheel::slot_bits;
+}
+}  // namespace
+
+timeout::timeout(hal::callback<void(void)> p_handler)
+  : m_handler(p_handler)
+{
+}
+
+timeout::~timeout()
+{
+  if (m_wheel != nullptr) {
+    m_wheel->cancel(*this);
+  }
+}
+
+bool timeout::is_pending() const
+{
+  return m_wheel != nullptr;
+}
+
+timer_wheel::timer_wheel(hal::steady_clock& p_clock,
+                         hal::timer& p_timer,
+                         hal::basic_lock& p_lock,
+                         hal::time_duration p_resolution,
+                         hal::time_duration p_maximum_delay)
+  : m_clock(&p_clock)
+  , m_timer(&p_timer)
+  , m_lock(&p_lock)
+  , m_resolution(std::max(p_resolution, hal::time_duration(1)))
+  , m_maximum_delay_ticks(0)
+  , m_clock_ticks_per_tick(1)
+{
+  auto const ticks_per_tick = static_cast<double>(m_resolution.count()) *
+                              static_cast<double>(m_clock->frequency()) / 1e9;
+  m_clock_ticks_per_tick =
+    std::max(static_cast<hal::u64>(ticks_per_tick), hal::u64{ 1 });
+  m_maximum_delay_ticks =
+    std::max(to_clock_ticks(p_maximum_delay), m_clock_ticks_per_tick);
+  m_current = ticks_from(m_clock->uptime());
+}
+
+timer_wheel::~timer_wheel()
+{
+  std::lock_guard lock(*m_lock);
+  m_timer->cancel();
+  for (auto* head : m_lists) {
+    for (auto* node = head; node != nullptr; node = node->m_next) {
+      node->m_wheel = nullptr;
+    }
+  }
+}
+
+hal::u64 timer_wheel::to_clock_ticks(hal::time_duration p_duration) const
+{
+  auto const resolution = static_cast<hal::u64>(m_resolution.count());
+  auto const duration = static_cast<hal::u64>(
+    std::max<hal::time_duration::rep>(p_duration.count(), 0));
+  return (duration / resolution) * m_clock_ticks_per_tick +
+         ((duration % resolution) * m_clock_ticks_per_tick) / resolution;
+}
+
+hal::time_duration timer_wheel::to_duration(hal::u64 p_clock_ticks) const
+{
+  auto const resolution = static_cast<hal::u64>(m_resolution.count());
+  auto const nanoseconds =
+    (p_clock_ticks / m_clock_ticks_per_tick) * resolution +
+    ((p_clock_ticks % m_clock_ticks_per_tick) * resolution) /
+      m_clock_ticks_per_tick;
+  return hal::time_duration(nanoseconds);
+}
+
+hal::u64 timer_wheel::ticks_from(hal::u64 p_clock_ticks) const
+{
+  return p_clock_ticks / m_clock_ticks_per_tick;
+}
+
+void timer_wheel::schedule(timeout& p_timeout, hal::time_duration p_delay)
+{
+  std::lock_guard lock(*m_lock);
+  if (p_timeout.m_wheel != nullptr) {
+    remove(p_timeout);
+  }
+
+  // Round up to the first tick at or after the deadline, so the timeout never
+  // expires early.
+  auto const deadline = m_clock->uptime() + to_clock_ticks(p_delay);
+  auto const expiry =
+    (deadline + m_clock_ticks_per_tick - 1) / m_clock_ticks_per_tick;
+  p_timeout.m_expiry = std::max(expiry, m_current + 1);
+  p_timeout.m_wheel = this;
+  insert(p_timeout);
+
+  if (m_run_depth == 0 && p_timeout.m_expiry < m_armed) {
+    arm();
+  }
+}
+
+void timer_wheel::reschedule(timeout& p_timeout, hal::time_duration p_period)
+{
+  std::lock_guard lock(*m_lock);
+  if (p_timeout.m_wheel != nullptr) {
+    remove(p_timeout);
+  }
+
+  auto const resolution = m_resolution.count();
+  auto const period = std::max<hal::time_duration::rep>(p_period.count(), 1);
+  auto const period_ticks =
+    static_cast<hal::u64>((period + resolution - 1) / resolution);
+  // The wheel's current tick is stale while a handler runs, so catch up from
+  // the clock
+  auto const now = std::max(m_current, ticks_from(m_clock->uptime()));
+  p_timeout.m_expiry = std::max(p_timeout.m_expiry + period_ticks, now + 1);
+  p_timeout.m_wheel = this;
+  insert(p_timeout);
+
+  if (m_run_depth == 0 && p_timeout.m_expiry < m_armed) {
+    arm();
+  }
+}
+
+void timer_wheel::cancel(timeout& p_timeout)
+{
+  std::lock_guard lock(*m_lock);
+  // A pending timeout may belong to a different wheel
+  if (p_timeout.m_wheel == this) {
+    remove(p_timeout);
+  }
+}
+
+hal::time_duration timer_wheel::resolution() const
+{
+  return m_resolution;
+}
+
+hal::time_duration timer_wheel::time_until_next_event()
+{
+  std::lock_guard lock(*m_lock);
+  auto const event = next_event();
+  if (event == never) {
+    return hal::time_duration::max();
+  }
+  auto const event_clock_ticks = event * m_clock_ticks_per_tick;
+  auto const now = m_clock->uptime();
+  if (event_clock_ticks <= now) {
+    return hal::time_duration(0);
+  }
+  return to_duration(event_clock_ticks - now);
+}
+
+void timer_wheel::insert(timeout& p_timeout)
+{
+  auto const expiry = p_timeout.m_expiry;
+  auto const difference = expiry ^ m_current;
+  std::size_t level = 0;
+  if (expiry > m_current) {
+    // Place the timeout in the level of the highest bit where the expiry
+    // differs from the current tick.
+    level = static_cast<std::size_t>(std::bit_width(difference) - 1) /
+            slot_bits;
+  }
+
+  if (level >= levels) {
+    push(overflow_list, p_timeout);
+    return;
+  }
+
+  auto const slot = (expiry >> level_shift(level)) & slot_mask;
+  push(static_cast<std::uint16_t>((level * slots_per_level) + slot),
+       p_timeout);
+}
+
+void timer_wheel::push(std::uint16_t p_list, timeout& p_timeout)
+{
+  auto*& head = m_lists[p_list];
+  p_timeout.m_list = p_list;
+  p_timeout.m_previous = nullptr;
+  p_timeout.m_next = head;
+  if (head != nullptr) {
+    head->m_previous = &p_timeout;
+  }
+  head = &p_timeout;
+
+  if (p_list < overflow_list) {
+    m_occupied[p_list / slots_per_level] |= hal::u64{ 1 }
+                                           << (p_list % slots_per_level);
+  }
+}
+
+void timer_wheel::remove(timeout& p_timeout)
+{
+  auto const list = p_timeout.m_list;
+  if (p_timeout.m_previous != nullptr) {
+    p_timeout.m_previous->m_next = p_timeout.m_next;
+  } else {
+    m_lists[list] = p_timeout.m_next;
+  }
+  if (p_timeout.m_next != nullptr) {
+    p_timeout.m_next->m_previous = p_timeout.m_previous;
+  }
+
+  if (list < overflow_list && m_lists[list] == nullptr) {
+    m_occupied[list / slots_per_level] &=
+      ~(hal::u64{ 1 } << (list % slots_per_level));
+  }
+
+  p_timeout.m_next = nullptr;
+  p_timeout.m_previous = nullptr;
+  p_timeout.m_wheel = nullptr;
+}
+
+hal::u64 timer_wheel::next_event() const
+{
+  if (m_lists[expired_list] != nullptr) {
+    return m_current;
+  }
+
+  auto event = never;
+  for (std::size_t level = 0; level < levels; level++) {
+    auto const shift = level_shift(level);
+    auto const current_slot = (m_current >> shift) & slot_mask;
+    // Every timeout in a level expires in a later slot of the current window
+    // of that level, the slot is processed when the current tick reaches the
+    // start of the slot.
+    auto const later_slots = ~((hal::u64{ 2 } << current_slot) - 1);
+    auto const occupied = m_occupied[level] & later_slots;
+    if (occupied == 0) {
+      continue;
+    }
+    auto const slot = static_cast<hal::u64>(std::countr_zero(occupied));
+    auto const window_shift = shift + slot_bits;
+    auto const window = (m_current >> window_shift) << window_shift;
+    event = std::min(event, window | (slot << shift));
+  }
+
+  if (m_lists[overflow_list] != nullptr) {
+    auto const top_shift = level_shift(levels);
+    event = std::min(event, ((m_current >> top_shift) + 1) << top_shift);
+  }
+
+  return event;
+}
+
+void timer_wheel::move_list(std::uint16_t p_list)
+{
+  auto* node = m_lists[p_list];
+  m_lists[p_list] = nullptr;
+  if (p_list < overflow_list) {
+    m_occupied[p_list / slots_per_level] &=
+      ~(hal::u64{ 1 } << (p_list % slots_per_level));
+  }
+
+  while (node != nullptr) {
+    auto* next = node->m_next;
+    if (node->m_expiry <= m_current) {
+      push(expired_list, *node);
+    } else {
+      insert(*node);
+    }
+    node = next;
+  }
+}
+
+void timer_wheel::process(hal::u64 p_tick)
+{
+  m_current = p_tick;
+
+  if (m_lists[overflow_list] != nullptr &&
+      (p_tick & ((hal::u64{ 1 } << level_shift(levels)) - 1)) == 0) {
+    move_list(overflow_list);
+  }
+
+  // Cascade from the top, so timeouts moved down a level are cascaded again if
+  // the lower level's slot is also reached on this tick.
+  for (std::size_t level = levels - 1; level > 0; level--) {
+    auto const shift = level_shift(level);
+    if ((p_tick & ((hal::u64{ 1 } << shift) - 1)) != 0) {
+      continue;
+    }
+    auto const slot = (p_tick >> shift) & slot_mask;
+    auto const list =
+      static_cast<std::uint16_t>((level * slots_per_level) + slot);
+    if (m_lists[list] != nullptr) {
+      move_list(list);
+    }
+  }
+
+  auto const list = static_cast<std::uint16_t>(p_tick & slot_mask);
+  if (m_lists[list] != nullptr) {
+    move_list(list);
+  }
+}
+
+void timer_wheel::run()
+{
+  std::unique_lock lock(*m_lock);
+  m_run_depth++;
+
+  while (true) {
+    auto const now = ticks_from(m_clock->uptime());
+    auto const event = next_event();
+    if (event > now) {
+      // Nothing is due before now, so skipping to it misses no slots
+      m_current = std::max(m_current, now);
+      break;
+    }
+
+    if (event > m_current) {
+      process(event);
+    }
+
+    while (m_lists[expired_list] != nullptr) {
+      auto& expired = *m_lists[expired_list];
+      remove(expired);
+      // Release the lock so the handler can schedule timeouts
+      lock.unlock();
+      expired.m_handler();
+      lock.lock();
+    }
+  }
+
+  m_run_depth--;
+  if (m_run_depth == 0) {
+    arm();
+  }
+}
+
+void timer_wheel::arm()
+{
+  auto const event = next_event();
+  if (event == never) {
+    m_armed = never;
+    m_timer->cancel();
+    return;
+  }
+
+  auto const now = m_clock->uptime();
+  auto const event_clock_ticks = event * m_clock_ticks_per_tick;
+  auto delay = event_clock_ticks > now ? event_clock_ticks - now : 0;
+  delay = std::min(delay, m_maximum_delay_ticks);
+  m_armed = ticks_from(now + delay);
+  m_timer->schedule([this]() { run(); }, to_duration(delay));
+}
+}  // namespace hal::micromod
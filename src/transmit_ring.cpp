@@ -0,0 +1,156 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/transmit_ring.hpp>
+
+#include <algorithm>
+#include <mutex>
+
+namespace hal::micromod {
+transmit_ring::transmit_ring(std::span<hal::byte> p_buffer,
+                             hal::basic_lock& p_lock,
+                             overflow_policy p_policy)
+  : m_buffer(p_buffer)
+  , m_lock(&p_lock)
+  , m_policy(p_policy)
+{
+}
+
+void transmit_ring::policy(overflow_policy p_policy)
+{
+  std::lock_guard lock(*m_lock);
+  m_policy = p_policy;
+}
+
+overflow_policy transmit_ring::policy() const
+{
+  return m_policy;
+}
+
+std::size_t transmit_ring::write(std::span<hal::byte const> p_data)
+{
+  std::size_t handled = 0;
+
+  if (m_policy == overflow_policy::drop_oldest &&
+      p_data.size() > m_buffer.size()) {
+    // Only the newest bytes could ever be kept
+    handled = p_data.size() - m_buffer.size();
+    std::lock_guard lock(*m_lock);
+    m_statistics.dropped += handled;
+  }
+
+  while (handled < p_data.size()) {
+    auto const remaining = p_data.subspan(handled);
+    auto const space = reserve(remaining.size());
+    if (space.empty()) {
+      if (m_policy == overflow_policy::block) {
+        break;
+      }
+      // Full of bytes that cannot be dropped
+      std::lock_guard lock(*m_lock);
+      m_statistics.dropped += remaining.size();
+      handled = p_data.size();
+      break;
+    }
+    std::copy_n(remaining.begin(), space.size(), space.begin());
+    commit(space.size());
+    handled += space.size();
+  }
+
+  return handled;
+}
+
+std::span<hal::byte> transmit_ring::reserve(std::size_t p_size)
+{
+  std::lock_guard lock(*m_lock);
+  auto const capacity = m_buffer.size();
+  auto free = capacity - m_size;
+
+  // Dropping bytes queued behind a claim would not make room until the claim
+  // is released
+  if (m_policy == overflow_policy::drop_oldest && not m_claimed &&
+      free < p_size) {
+    auto const dropped = std::min(m_unsent_size, p_size - free);
+    if (dropped > 0) {
+      drop(dropped);
+      free = capacity - m_size;
+    }
+  }
+
+  auto const head = (m_tail + m_size) % std::max<std::size_t>(capacity, 1);
+  auto const length = std::min({ p_size, free, capacity - head });
+  return m_buffer.subspan(head, length);
+}
+
+void transmit_ring::commit(std::size_t p_size)
+{
+  std::lock_guard lock(*m_lock);
+  m_size += p_size;
+  m_unsent_size += p_size;
+  m_statistics.written += p_size;
+  m_statistics.peak = std::max(m_statistics.peak, m_size);
+}
+
+void transmit_ring::drop(std::size_t p_size)
+{
+  m_unsent = (m_unsent + p_size) % m_buffer.size();
+  m_unsent_size -= p_size;
+  m_statistics.dropped += p_size;
+  m_tail = m_unsent;
+  m_size -= p_size;
+}
+
+std::span<hal::byte const> transmit_ring::claim()
+{
+  std::lock_guard lock(*m_lock);
+  if (m_claimed || m_unsent_size == 0) {
+    return {};
+  }
+
+  auto const length = std::min(m_unsent_size, m_buffer.size() - m_unsent);
+  auto const start = m_unsent;
+  m_unsent = (m_unsent + length) % m_buffer.size();
+  m_unsent_size -= length;
+  m_claimed = true;
+  return m_buffer.subspan(start, length);
+}
+
+void transmit_ring::release()
+{
+  std::lock_guard lock(*m_lock);
+  if (not m_claimed) {
+    return;
+  }
+  m_claimed = false;
+  m_tail = m_unsent;
+  m_size = m_unsent_size;
+}
+
+std::size_t transmit_ring::size()
+{
+  std::lock_guard lock(*m_lock);
+  return m_size;
+}
+
+std::size_t transmit_ring::capacity() const
+{
+  return m_buffer.size();
+}
+
+transmit_statistics transmit_ring::statistics()
+{
+  std::lock_guard lock(*m_lock);
+  return m_statistics;
+}
+}  // namespace hal::micromod
@@ -0,0 +1,48 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+
+#if not defined(__arm__)
+#include <thread>
+#endif
+
+namespace hal::micromod {
+/**
+ * @brief Wait for an interrupt, unless the flag is already set
+ *
+ * Interrupts are masked while the flag is checked, so an interrupt setting it
+ * cannot slip in between the check and the WFI. WFI still wakes on an
+ * interrupt that is pending while masked. On the host, where interrupts are
+ * played by threads or register models, this only yields.
+ *
+ * @param p_flag - flag set by the interrupt being waited for
+ */
+inline void wait_for_interrupt_unless(std::atomic<bool> const& p_flag)
+{
+#if defined(__arm__)
+  asm volatile("cpsid i" ::: "memory");
+  if (not p_flag) {
+    asm volatile("wfi" ::: "memory");
+  }
+  asm volatile("cpsie i" ::: "memory");
+#else
+  if (not p_flag) {
+    std::this_thread::yield();
+  }
+#endif
+}
+}  // namespace hal::micromod
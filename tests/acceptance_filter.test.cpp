@@ -0,0 +1,181 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lpc40/acceptance_filter.hpp"
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+using lpc40::can_filter_settings;
+
+/// Mask with a random number of random bits set, often most of them
+hal::u32 random_mask(std::mt19937& p_random, hal::u32 p_id_mask)
+{
+  hal::u32 clear = 0;
+  auto const bits = p_random() % 12;
+  for (hal::u32 i = 0; i < bits; i++) {
+    clear |= 1U << (p_random() % 29);
+  }
+  return p_id_mask & ~clear;
+}
+
+/// Filters of random kinds & values, some disabled, some never matching
+can_filter_settings random_filters(std::mt19937& p_random)
+{
+  can_filter_settings settings{};
+  auto const enabled = [&p_random]() { return p_random() % 3 == 0; };
+  for (std::size_t i = 0; i < lpc40::can_filter_count; i++) {
+    if (enabled()) {
+      settings.identifiers[i] = static_cast<hal::u16>(p_random() % 0x900);
+    }
+    if (enabled()) {
+      settings.masks[i] = { .id = static_cast<hal::u16>(p_random() % 0x900),
+                            .mask = static_cast<hal::u16>(
+                              random_mask(p_random, 0xFFFF)) };
+    }
+    if (enabled()) {
+      auto const start = static_cast<hal::u16>(p_random() % 0x900);
+      settings.ranges[i] = {
+        .id_1 = start,
+        .id_2 = static_cast<hal::u16>(start + p_random() % 64 - 16),
+      };
+    }
+    if (enabled()) {
+      settings.extended_identifiers[i] = p_random() & 0x3FFF'FFFF;
+    }
+    if (enabled()) {
+      settings.extended_masks[i] = { .id = static_cast<hal::u32>(p_random()) &
+                                           0x3FFF'FFFF,
+                                     .mask = random_mask(p_random,
+                                                         0x3FFF'FFFF) };
+    }
+    if (enabled()) {
+      auto const start = static_cast<hal::u32>(p_random()) & 0x1FFF'FFFF;
+      settings.extended_ranges[i] = {
+        .id_1 = start,
+        .id_2 = start + static_cast<hal::u32>(p_random() % 4096),
+      };
+    }
+  }
+  return settings;
+}
+
+/// Extended identifiers near those the filters name, & some anywhere
+std::vector<hal::u32> extended_candidates(can_filter_settings const& p_settings,
+                                          std::mt19937& p_random)
+{
+  std::vector<hal::u32> ids;
+  auto const near = [&ids, &p_random](hal::u32 p_id) {
+    for (hal::u32 offset = 0; offset < 3; offset++) {
+      ids.push_back((p_id + offset - 1) & 0x1FFF'FFFF);
+    }
+    ids.push_back((p_id ^ (1U << (p_random() % 29))) & 0x1FFF'FFFF);
+  };
+  for (std::size_t i = 0; i < lpc40::can_filter_count; i++) {
+    if (auto const id = p_settings.extended_identifiers[i]) {
+      near(*id);
+    }
+    if (auto const mask = p_settings.extended_masks[i]) {
+      // Vary the bits the mask ignores
+      for (int j = 0; j < 8; j++) {
+        near((mask->id & mask->mask) | (p_random() & ~mask->mask));
+      }
+    }
+    if (auto const range = p_settings.extended_ranges[i]) {
+      near(range->id_1);
+      near(range->id_2);
+    }
+  }
+  for (int i = 0; i < 64; i++) {
+    ids.push_back(p_random() & 0x1FFF'FFFF);
+  }
+  return ids;
+}
+
+struct comparison
+{
+  std::size_t messages = 0;
+  /// Accepted by the table, but not by the filters, of an inexact table
+  std::size_t widened = 0;
+  bool matches = true;
+};
+
+/// Compare the table with the filters for a message on each controller
+void compare(comparison& p_result,
+             can_filter_settings const& p_settings,
+             hal::can_message const& p_message)
+{
+  for (std::uint8_t controller = 0; controller < 2; controller++) {
+    std::array<std::uint32_t, lpc40::acceptance_filter_words> table{};
+    auto const layout =
+      lpc40::build_acceptance_filter(p_settings, controller, table);
+    auto const table_accepts = lpc40::acceptance_filter_accepts(
+      table, layout, controller, p_message);
+    auto const filters_accept = lpc40::filters_accept(p_settings, p_message);
+    // The other controller's entries never match
+    auto const other_accepts = lpc40::acceptance_filter_accepts(
+      table, layout, controller ^ 1, p_message);
+
+    p_result.messages++;
+    if (layout.exact) {
+      p_result.matches &= table_accepts == filters_accept;
+    } else {
+      p_result.matches &= table_accepts || not filters_accept;
+      p_result.widened += table_accepts && not filters_accept;
+    }
+    p_result.matches &= not other_accepts;
+  }
+}
+}  // namespace
+
+void acceptance_filter_test()
+{
+  using namespace boost::ut;
+
+  "acceptance_filter matches filters_accept on random filters"_test = []() {
+    std::mt19937 random(40);
+    comparison result;
+    for (int set = 0; set < 200 && result.matches; set++) {
+      auto const settings = random_filters(random);
+      for (hal::u32 id = 0; id <= 0x7FF; id++) {
+        compare(result, settings, { .id = id });
+      }
+      for (auto const id : extended_candidates(settings, random)) {
+        compare(result, settings, { .id = id, .extended = true });
+      }
+    }
+
+    expect(result.matches);
+    // The random masks exercised the widened tables too
+    expect(result.widened > 0);
+  };
+
+  "acceptance_filter accepts nothing without filters"_test = []() {
+    can_filter_settings const settings{};
+    std::array<std::uint32_t, lpc40::acceptance_filter_words> table{};
+    auto const layout = lpc40::build_acceptance_filter(settings, 0, table);
+
+    expect(layout.end == 0);
+    expect(not lpc40::acceptance_filter_accepts(table, layout, 0, {}));
+    expect(not lpc40::acceptance_filter_accepts(
+      table, layout, 0, { .id = 0, .extended = true }));
+  };
+}
+}  // namespace hal::micromod
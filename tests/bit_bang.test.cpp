@@ -0,0 +1,485 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "stm32f1/bit_bang.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <libhal/error.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+using namespace hal::micromod::stm32f1;
+
+/// Line of the model, in place of a port & pin
+struct model_line
+{
+  char port;
+  std::uint8_t pin;
+};
+
+constexpr model_line sck{ .port = 'K', .pin = 0 };
+constexpr model_line copi{ .port = 'O', .pin = 0 };
+constexpr model_line cipo{ .port = 'I', .pin = 0 };
+constexpr model_line sda{ .port = 'D', .pin = 0 };
+constexpr model_line scl{ .port = 'C', .pin = 0 };
+constexpr hal::hertz cpu_frequency = 64'000'000.0f;
+/// Half period of the 1MHz bus clock used by the tests
+constexpr std::uint32_t half_period = 32;
+
+struct edge
+{
+  std::uint32_t cycle;
+  char line;
+  bool level;
+};
+
+/**
+ * @brief SPI bus model, records every edge the engine writes
+ *
+ * The cycle counter advances by one each time it is read, so the engine's
+ * waits complete, & an edge is stamped with the cycle it was written in. CIPO
+ * reads COPI back.
+ */
+struct spi_io
+{
+  static inline std::uint32_t cycles = 0;
+  static inline std::vector<edge> edges;
+  static inline std::array<bool, 128> levels{};
+
+  static void reset()
+  {
+    cycles = 0;
+    edges.clear();
+    levels = {};
+  }
+
+  template<auto line>
+  struct pin_t
+  {
+    static void high()
+    {
+      level(true);
+    }
+
+    static void low()
+    {
+      level(false);
+    }
+
+    static void level(bool p_high)
+    {
+      if (levels[line.port] != p_high) {
+        edges.push_back(
+          { .cycle = cycles, .line = line.port, .level = p_high });
+      }
+      levels[line.port] = p_high;
+    }
+
+    static bool level()
+    {
+      return line.port == cipo.port ? levels[copi.port] : levels[line.port];
+    }
+  };
+
+  static std::uint32_t cycle_count()
+  {
+    return cycles++;
+  }
+};
+
+/// Bytes a device sampling COPI on the given edge of SCK receives
+std::vector<hal::byte> spi_received(bool p_sample_on_rising)
+{
+  std::vector<hal::byte> received;
+  bool copi_level = false;
+  std::size_t bits = 0;
+  for (auto const& edge : spi_io::edges) {
+    if (edge.line == copi.port) {
+      copi_level = edge.level;
+    } else if (edge.line == sck.port && edge.level == p_sample_on_rising) {
+      if (bits++ % 8 == 0) {
+        received.push_back(0);
+      }
+      received.back() =
+        static_cast<hal::byte>((received.back() << 1) | copi_level);
+    }
+  }
+  return received;
+}
+
+/**
+ * @brief I2C target at address 0x42 with a small register file
+ *
+ * The first byte written after the address sets the register pointer, the
+ * bytes after it are written from the pointer on, & reads continue from the
+ * pointer. Runs on the edges of the bus as the controller makes them.
+ */
+struct i2c_device
+{
+  enum class phase : std::uint8_t
+  {
+    idle,
+    receive,
+    transmit,
+  };
+
+  static constexpr hal::byte address = 0x42;
+
+  std::array<hal::byte, 16> memory{};
+  std::size_t pointer = 0;
+  /// SCL reads held low after each acknowledged address
+  std::uint32_t stretch_reads = 0;
+  std::uint32_t stretching = 0;
+  std::size_t starts = 0;
+  std::size_t stops = 0;
+  bool sda_released = true;
+
+  void start()
+  {
+    m_phase = phase::receive;
+    m_addressing = true;
+    m_bits = 0;
+    m_shift = 0;
+    sda_released = true;
+    starts++;
+  }
+
+  void stop()
+  {
+    m_phase = phase::idle;
+    sda_released = true;
+    stops++;
+  }
+
+  void rising(bool p_sda)
+  {
+    if (m_phase == phase::receive && m_bits < 8) {
+      m_shift = static_cast<hal::byte>((m_shift << 1) | p_sda);
+      m_bits++;
+    } else if (m_phase == phase::transmit && m_bits == 9) {
+      m_acknowledged = not p_sda;
+    }
+  }
+
+  void falling()
+  {
+    if (m_phase == phase::receive) {
+      receive_falling();
+    } else if (m_phase == phase::transmit) {
+      transmit_falling();
+    }
+  }
+
+private:
+  void receive_falling()
+  {
+    if (m_bits == 8) {
+      if (m_addressing) {
+        m_matched = (m_shift >> 1) == address;
+        m_reading = (m_shift & 1) != 0;
+        sda_released = not m_matched;
+      } else {
+        if (m_pointer_next) {
+          pointer = m_shift;
+        } else {
+          memory[pointer++ % memory.size()] = m_shift;
+        }
+        m_pointer_next = false;
+        sda_released = false;
+      }
+      m_bits = 9;
+    } else if (m_bits == 9) {
+      sda_released = true;
+      if (m_addressing && not m_matched) {
+        m_phase = phase::idle;
+        return;
+      }
+      if (m_addressing) {
+        stretching = stretch_reads;
+        m_pointer_next = not m_reading;
+      }
+      if (m_addressing && m_reading) {
+        m_phase = phase::transmit;
+        load();
+      } else {
+        m_bits = 0;
+        m_shift = 0;
+      }
+      m_addressing = false;
+    }
+  }
+
+  void transmit_falling()
+  {
+    if (m_bits < 8) {
+      drive();
+    } else if (m_bits == 8) {
+      // Released for the controller's acknowledge
+      sda_released = true;
+      m_bits = 9;
+    } else if (m_acknowledged) {
+      load();
+    } else {
+      sda_released = true;
+      m_phase = phase::idle;
+    }
+  }
+
+  void load()
+  {
+    m_shift = memory[pointer++ % memory.size()];
+    m_bits = 0;
+    drive();
+  }
+
+  void drive()
+  {
+    sda_released = ((m_shift >> (7 - m_bits)) & 1) != 0;
+    m_bits++;
+  }
+
+  phase m_phase = phase::idle;
+  hal::byte m_shift = 0;
+  std::uint32_t m_bits = 0;
+  bool m_addressing = false;
+  bool m_matched = false;
+  bool m_reading = false;
+  bool m_pointer_next = false;
+  bool m_acknowledged = false;
+};
+
+/**
+ * @brief Open drain I2C bus model of the controller & an i2c_device
+ *
+ * A line is low while either side pulls it low. The device sees every change
+ * the controller makes to the bus.
+ */
+struct i2c_io
+{
+  static inline std::uint32_t cycles = 0;
+  static inline std::vector<edge> edges;
+  static inline bool sda_released = true;
+  static inline bool scl_released = true;
+  static inline i2c_device device{};
+
+  static void reset()
+  {
+    cycles = 0;
+    edges.clear();
+    sda_released = true;
+    scl_released = true;
+    device = {};
+  }
+
+  static bool sda_level()
+  {
+    return sda_released && device.sda_released;
+  }
+
+  template<auto line>
+  struct pin_t
+  {
+    static void high()
+    {
+      level(true);
+    }
+
+    static void low()
+    {
+      level(false);
+    }
+
+    static void level(bool p_high)
+    {
+      auto const sda_before = sda_level();
+      auto const scl_before = scl_released;
+      if (line.port == sda.port) {
+        sda_released = p_high;
+      } else {
+        scl_released = p_high;
+      }
+      auto const sda_after = sda_level();
+      if (scl_before != scl_released) {
+        edges.push_back(
+          { .cycle = cycles, .line = scl.port, .level = scl_released });
+      }
+
+      if (scl_before && scl_released && sda_before && not sda_after) {
+        device.start();
+      } else if (scl_before && scl_released && not sda_before && sda_after) {
+        device.stop();
+      } else if (not scl_before && scl_released) {
+        device.rising(sda_after);
+      } else if (scl_before && not scl_released) {
+        device.falling();
+      }
+    }
+
+    static bool level()
+    {
+      if (line.port == sda.port) {
+        return sda_level();
+      }
+      if (scl_released && device.stretching > 0) {
+        device.stretching--;
+        return false;
+      }
+      return scl_released;
+    }
+  };
+
+  static std::uint32_t cycle_count()
+  {
+    return cycles++;
+  }
+};
+
+void no_timeout()
+{
+}
+}  // namespace
+
+void bit_bang_test()
+{
+  using namespace boost::ut;
+
+  "fast_bit_bang_spi emits every clock mode"_test = []() {
+    for (auto const idles_high : { false, true }) {
+      for (auto const trailing : { false, true }) {
+        spi_io::reset();
+        fast_bit_bang_spi<sck, copi, cipo, spi_io> driver(
+          cpu_frequency,
+          {
+            .clock_rate = 1'000'000.0f,
+            .clock_idles_high = idles_high,
+            .data_valid_on_trailing_edge = trailing,
+          });
+        spi_io::edges.clear();
+        std::array<hal::byte, 5> const out{ 0xA5, 0x00, 0xFF, 0x3C, 0x81 };
+        std::array<hal::byte, 5> in{};
+
+        driver.transfer(out, in);
+
+        auto const sample_on_rising = idles_high == trailing;
+        auto const received = spi_received(sample_on_rising);
+        expect(std::ranges::equal(received, out));
+        expect(in == out);
+        expect(spi_io::levels[sck.port] == idles_high);
+
+        // Every clock edge a half period after the one before
+        std::vector<std::uint32_t> clock_edges;
+        for (auto const& edge : spi_io::edges) {
+          if (edge.line == sck.port) {
+            clock_edges.push_back(edge.cycle);
+          }
+        }
+        expect(clock_edges.size() == out.size() * 16);
+        for (std::size_t i = 1; i < clock_edges.size(); i++) {
+          expect(clock_edges[i] - clock_edges[i - 1] == half_period);
+        }
+      }
+    }
+  };
+
+  "fast_bit_bang_spi sends the filler"_test = []() {
+    spi_io::reset();
+    fast_bit_bang_spi<sck, copi, cipo, spi_io> driver(
+      cpu_frequency, { .clock_rate = 1'000'000.0f });
+    spi_io::edges.clear();
+    std::array<hal::byte, 3> in{};
+
+    driver.transfer({}, in, 0x00);
+
+    expect(spi_received(true) == std::vector<hal::byte>(3, 0x00));
+    expect(in == std::array<hal::byte, 3>{});
+  };
+
+  "fast_bit_bang_i2c writes then reads with a repeated start"_test = []() {
+    i2c_io::reset();
+    for (std::size_t i = 0; i < i2c_io::device.memory.size(); i++) {
+      i2c_io::device.memory[i] = static_cast<hal::byte>(0xC0 + i);
+    }
+    fast_bit_bang_i2c<sda, scl, i2c_io> driver(cpu_frequency,
+                                              { .clock_rate = 1'000'000.0f });
+    std::array<hal::byte, 1> const out{ 3 };
+    std::array<hal::byte, 4> in{};
+
+    driver.transaction(i2c_device::address, out, in, no_timeout);
+
+    expect(in == std::array<hal::byte, 4>{ 0xC3, 0xC4, 0xC5, 0xC6 });
+    expect(i2c_io::device.starts == 2);
+    expect(i2c_io::device.stops == 1);
+    expect(i2c_io::sda_level() && i2c_io::scl_released);
+  };
+
+  "fast_bit_bang_i2c writes"_test = []() {
+    i2c_io::reset();
+    fast_bit_bang_i2c<sda, scl, i2c_io> driver(cpu_frequency,
+                                              { .clock_rate = 1'000'000.0f });
+    std::array<hal::byte, 4> const out{ 5, 0x11, 0x22, 0x33 };
+
+    driver.transaction(i2c_device::address, out, {}, no_timeout);
+
+    expect(i2c_io::device.memory[5] == 0x11);
+    expect(i2c_io::device.memory[6] == 0x22);
+    expect(i2c_io::device.memory[7] == 0x33);
+    expect(i2c_io::device.stops == 1);
+  };
+
+  "fast_bit_bang_i2c reports a missing device"_test = []() {
+    i2c_io::reset();
+    fast_bit_bang_i2c<sda, scl, i2c_io> driver(cpu_frequency,
+                                              { .clock_rate = 1'000'000.0f });
+    std::array<hal::byte, 1> const out{ 0 };
+
+    expect(throws<hal::no_such_device>([&]() {
+      driver.transaction(0x10, out, {}, no_timeout);
+    }));
+    expect(i2c_io::device.stops == 1);
+  };
+
+  "fast_bit_bang_i2c waits out clock stretching"_test = []() {
+    i2c_io::reset();
+    i2c_io::device.memory[0] = 0x5A;
+    i2c_io::device.stretch_reads = 100;
+    fast_bit_bang_i2c<sda, scl, i2c_io> driver(cpu_frequency,
+                                              { .clock_rate = 1'000'000.0f });
+    std::array<hal::byte, 1> in{};
+    std::size_t timeout_calls = 0;
+
+    driver.transaction(
+      i2c_device::address, {}, in, [&timeout_calls]() { timeout_calls++; });
+
+    expect(in[0] == 0x5A);
+    expect(timeout_calls == 100);
+
+    // The high period is measured from when the clock was released
+    bool high = false;
+    std::uint32_t rose = 0;
+    for (auto const& edge : i2c_io::edges) {
+      if (edge.level) {
+        rose = edge.cycle;
+      } else if (high) {
+        expect(edge.cycle - rose >= half_period);
+      }
+      high = edge.level;
+    }
+  };
+}
+}  // namespace hal::micromod
@@ -0,0 +1,359 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/can_capture.hpp>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+constexpr hal::hertz clock_frequency = 12'000'000.0f;
+constexpr hal::u64 ticks_per_microsecond = 12;
+/// Bit time of a 500kbit/s bus
+constexpr hal::u64 bit_time = 2;
+/// Byte time of a 1Mbit/s 8N1 serial port
+constexpr hal::u64 byte_time = 10;
+
+class model_clock : public hal::steady_clock
+{
+public:
+  hal::u64 now = 0;
+
+private:
+  hal::hertz driver_frequency() override
+  {
+    return clock_frequency;
+  }
+
+  hal::u64 driver_uptime() override
+  {
+    return now;
+  }
+};
+
+/// Calls the receive handler for each message the test plays
+class model_interrupt : public hal::can_interrupt
+{
+public:
+  void receive(hal::can_message const& p_message)
+  {
+    if (m_handler) {
+      (*m_handler)(on_receive_tag{}, p_message);
+    }
+  }
+
+private:
+  void driver_on_receive(optional_receive_handler const& p_handler) override
+  {
+    m_handler = p_handler;
+  }
+
+  optional_receive_handler m_handler;
+};
+
+/// Collects the bytes written
+class model_serial : public hal::serial
+{
+public:
+  std::vector<hal::byte> written;
+
+private:
+  void driver_configure(settings const&) override
+  {
+  }
+
+  write_t driver_write(std::span<hal::byte const> p_data) override
+  {
+    written.insert(written.end(), p_data.begin(), p_data.end());
+    return { .data = p_data };
+  }
+
+  read_t driver_read(std::span<hal::byte> p_data) override
+  {
+    return { .data = p_data.first(0), .available = 0, .capacity = 0 };
+  }
+
+  void driver_flush() override
+  {
+  }
+};
+
+struct decoded_record
+{
+  hal::u32 sequence;
+  hal::u64 microseconds;
+  hal::can_message message;
+};
+
+struct decoded_capture
+{
+  std::vector<decoded_record> records;
+  /// Dropped count of each batch
+  std::vector<hal::u64> dropped;
+};
+
+class reader
+{
+public:
+  explicit reader(std::vector<hal::byte> p_payload)
+    : m_payload(std::move(p_payload))
+  {
+  }
+
+  bool done() const
+  {
+    return m_index >= m_payload.size();
+  }
+
+  hal::byte byte()
+  {
+    return m_payload.at(m_index++);
+  }
+
+  hal::u64 varint()
+  {
+    hal::u64 value = 0;
+    for (unsigned shift = 0;; shift += 7) {
+      auto const next = byte();
+      value |= hal::u64{ next & 0x7FU } << shift;
+      if (next < 0x80) {
+        return value;
+      }
+    }
+  }
+
+private:
+  std::vector<hal::byte> m_payload;
+  std::size_t m_index = 0;
+};
+
+std::vector<hal::byte> cobs_decode(std::span<hal::byte const> p_frame)
+{
+  std::vector<hal::byte> output;
+  std::size_t index = 0;
+  while (index < p_frame.size()) {
+    auto const code = p_frame[index];
+    output.insert(output.end(),
+                  p_frame.begin() + index + 1,
+                  p_frame.begin() + index + code);
+    index += code;
+    if (code < 0xFF && index < p_frame.size()) {
+      output.push_back(0);
+    }
+  }
+  return output;
+}
+
+/// Decode binary batches as tools/can_capture_decoder.py does
+decoded_capture decode_binary(std::span<hal::byte const> p_stream)
+{
+  decoded_capture capture;
+  std::size_t start = 0;
+  for (std::size_t end = 0; end < p_stream.size(); end++) {
+    if (p_stream[end] != 0) {
+      continue;
+    }
+    reader batch(cobs_decode(p_stream.subspan(start, end - start)));
+    start = end + 1;
+
+    auto sequence = static_cast<hal::u32>(batch.varint());
+    capture.dropped.push_back(batch.varint());
+    auto microseconds = batch.varint();
+    while (not batch.done()) {
+      auto const flags = batch.byte();
+      hal::can_message message{};
+      message.length = flags & 0xF;
+      message.extended = (flags & (1U << 4)) != 0;
+      message.remote_request = (flags & (1U << 5)) != 0;
+      auto const id_length = message.extended ? 4U : 2U;
+      for (unsigned i = 0; i < id_length; i++) {
+        message.id |= hal::u32{ batch.byte() } << (8 * i);
+      }
+      if (not message.remote_request) {
+        for (unsigned i = 0; i < message.length; i++) {
+          message.payload[i] = batch.byte();
+        }
+      }
+      microseconds += batch.varint();
+      capture.records.push_back({ .sequence = sequence++,
+                                  .microseconds = microseconds,
+                                  .message = message });
+    }
+  }
+  return capture;
+}
+
+bool same_message(hal::can_message const& p_left,
+                  hal::can_message const& p_right)
+{
+  auto const length = p_left.remote_request ? 0 : p_left.length;
+  return p_left.id == p_right.id && p_left.length == p_right.length &&
+         p_left.extended == p_right.extended &&
+         p_left.remote_request == p_right.remote_request &&
+         std::equal(p_left.payload.begin(),
+                    p_left.payload.begin() + length,
+                    p_right.payload.begin());
+}
+
+hal::can_message random_message(std::mt19937& p_random)
+{
+  hal::can_message message{};
+  message.extended = p_random() % 4 == 0;
+  message.remote_request = p_random() % 8 == 0;
+  message.id = p_random() & (message.extended ? 0x1FFF'FFFFU : 0x7FFU);
+  message.length = static_cast<hal::u8>(p_random() % 9);
+  for (auto& byte : message.payload) {
+    byte = static_cast<hal::byte>(p_random());
+  }
+  return message;
+}
+
+/// Bits on the bus for a message without stuff bits, with the interframe space
+hal::u64 frame_bits(hal::can_message const& p_message)
+{
+  auto const header = p_message.extended ? 67U : 47U;
+  return header + (p_message.remote_request ? 0U : 8U * p_message.length);
+}
+
+struct played_message
+{
+  hal::u64 ticks;
+  hal::can_message message;
+};
+}  // namespace
+
+void can_capture_test()
+{
+  using namespace boost::ut;
+
+  "can_capture keeps up with a fully loaded bus"_test = []() {
+    model_clock clock;
+    model_interrupt interrupt;
+    model_serial serial;
+    std::array<can_capture_record, 128> buffer{};
+    can_capture capture(interrupt, clock, buffer);
+    std::mt19937 random(500);
+
+    // One second of back to back messages at 500kbit/s, received by the
+    // interrupt between drains. Each drain blocks the main loop while the
+    // serial port sends its output at 1Mbit/s, plus 20us of overhead.
+    std::vector<played_message> played;
+    hal::u64 bus_time = 0;
+    hal::u64 loop_time = 0;
+    std::size_t next = 0;
+    while (bus_time < 1'000'000 || next < played.size()) {
+      while (bus_time <= loop_time && bus_time < 1'000'000) {
+        auto const message = random_message(random);
+        bus_time += frame_bits(message) * bit_time;
+        played.push_back({ bus_time * ticks_per_microsecond, message });
+      }
+      for (; next < played.size() && played[next].ticks <=
+                                       loop_time * ticks_per_microsecond;
+           next++) {
+        clock.now = played[next].ticks;
+        interrupt.receive(played[next].message);
+      }
+      auto const before = serial.written.size();
+      capture.drain(serial, can_capture_format::binary);
+      loop_time += (serial.written.size() - before) * byte_time + 20;
+    }
+
+    auto const statistics = capture.statistics();
+    expect(statistics.received == played.size());
+    expect(statistics.dropped == 0);
+    expect(statistics.peak < buffer.size() - 1);
+    // Sent within the second plus the last drain
+    expect(serial.written.size() * byte_time < 1'010'000);
+
+    auto const decoded = decode_binary(serial.written);
+    expect(decoded.records.size() == played.size());
+    tick_converter const to_time(clock_frequency);
+    bool matches = decoded.records.size() == played.size();
+    for (std::size_t i = 0; matches && i < played.size(); i++) {
+      auto const& record = decoded.records[i];
+      matches = record.sequence == i &&
+                record.microseconds == to_time.microseconds(played[i].ticks) &&
+                same_message(record.message, played[i].message);
+    }
+    expect(matches);
+    for (auto const dropped : decoded.dropped) {
+      expect(dropped == 0);
+    }
+  };
+
+  "can_capture reports messages dropped while the ring is full"_test = []() {
+    model_clock clock;
+    model_interrupt interrupt;
+    model_serial serial;
+    // Holds 3 records
+    std::array<can_capture_record, 4> buffer{};
+    can_capture capture(interrupt, clock, buffer);
+
+    for (hal::u32 id = 0; id < 10; id++) {
+      clock.now += 100 * ticks_per_microsecond;
+      interrupt.receive({ .id = id, .length = 1, .payload = { 0xAA } });
+    }
+    expect(capture.drain(serial, can_capture_format::binary) == 3);
+    clock.now += 100 * ticks_per_microsecond;
+    interrupt.receive({ .id = 10 });
+    expect(capture.drain(serial, can_capture_format::binary) == 1);
+
+    auto const statistics = capture.statistics();
+    expect(statistics.received == 11);
+    expect(statistics.dropped == 7);
+    expect(statistics.peak == 3);
+
+    auto const decoded = decode_binary(serial.written);
+    expect(decoded.records.size() == 4);
+    expect(decoded.records.back().sequence == 10);
+    expect(decoded.records.back().microseconds == 1100);
+    expect(decoded.dropped == std::vector<hal::u64>{ 7, 7 });
+  };
+
+  "can_capture writes candump lines"_test = []() {
+    model_clock clock;
+    model_interrupt interrupt;
+    model_serial serial;
+    std::array<can_capture_record, 3> buffer{};
+    can_capture capture(interrupt, clock, buffer);
+
+    clock.now = 12'345'678 * ticks_per_microsecond;
+    interrupt.receive(
+      { .id = 0x123, .length = 4, .payload = { 0xDE, 0xAD, 0xBE, 0xEF } });
+    clock.now += 5;
+    interrupt.receive({ .id = 0x1ABCDEF, .length = 0, .extended = true });
+    // Dropped, the ring is full
+    interrupt.receive({ .id = 0x7FF });
+    capture.drain(serial, can_capture_format::candump);
+    clock.now = 3'600'000'001 * ticks_per_microsecond;
+    interrupt.receive({ .id = 0x7FF, .length = 2, .remote_request = true });
+    capture.drain(serial, can_capture_format::candump);
+
+    auto const text = std::string(serial.written.begin(), serial.written.end());
+    expect(text == "(0000000012.345678) can0 123#DEADBEEF\n"
+                   "(0000000012.345678) can0 01ABCDEF#\n"
+                   "# dropped 1\n"
+                   "(0000003600.000001) can0 7FF#R\n");
+  };
+}
+}  // namespace hal::micromod
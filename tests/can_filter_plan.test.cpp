@@ -0,0 +1,398 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/can_filter_plan.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+constexpr hal::u32 standard_id_mask = 0x7FF;
+constexpr hal::u32 extended_id_mask = 0x1FFF'FFFF;
+
+bool matches(hal::u32 p_id, hal::u32 p_filter_id, hal::u32 p_mask)
+{
+  return ((p_id ^ p_filter_id) & p_mask) == 0;
+}
+
+bool overlap(hal::u32 p_id_a,
+             hal::u32 p_mask_a,
+             hal::u32 p_id_b,
+             hal::u32 p_mask_b)
+{
+  return ((p_id_a ^ p_id_b) & p_mask_a & p_mask_b) == 0;
+}
+
+bool wanted(std::span<can_id_range const> p_wanted,
+            hal::u32 p_id,
+            bool p_extended)
+{
+  return std::ranges::any_of(p_wanted, [&](auto const& p_range) {
+    return p_range.extended == p_extended && p_range.first <= p_id &&
+           p_id <= p_range.last;
+  });
+}
+
+bool accepts(can_filter_plan const& p_plan, hal::u32 p_id, bool p_extended)
+{
+  if (not p_extended) {
+    return std::ranges::any_of(p_plan.identifiers,
+                               [&](auto const& p_id_filter) {
+                                 return p_id_filter && *p_id_filter == p_id;
+                               }) ||
+           std::ranges::any_of(p_plan.masks, [&](auto const& p_mask) {
+             return p_mask && matches(p_id, p_mask->id, p_mask->mask);
+           });
+  }
+  return std::ranges::any_of(p_plan.extended_identifiers,
+                             [&](auto const& p_id_filter) {
+                               return p_id_filter && *p_id_filter == p_id;
+                             }) ||
+         std::ranges::any_of(p_plan.extended_masks, [&](auto const& p_mask) {
+           return p_mask && matches(p_id, p_mask->id, p_mask->mask);
+         });
+}
+
+/// Every identifier a mask filter accepts, by walking its don't care bits
+std::vector<hal::u32> accepted_ids(hal::u32 p_id,
+                                   hal::u32 p_mask,
+                                   hal::u32 p_id_mask)
+{
+  std::vector<hal::u32> result;
+  auto const free = ~p_mask & p_id_mask;
+  auto const base = p_id & p_mask & p_id_mask;
+  for (hal::u32 bits = free;; bits = (bits - 1) & free) {
+    result.push_back(base | bits);
+    if (bits == 0) {
+      break;
+    }
+  }
+  return result;
+}
+
+template<class value_t>
+std::size_t used(
+  std::array<std::optional<value_t>, can_filter_slots> const& p_filters)
+{
+  return static_cast<std::size_t>(std::ranges::count_if(
+    p_filters, [](auto const& p_filter) { return p_filter.has_value(); }));
+}
+
+std::size_t divide_rounding_up(std::size_t p_value, std::size_t p_divisor)
+{
+  return (p_value + p_divisor - 1) / p_divisor;
+}
+
+/// Banks the filters of a plan take, by the budget's bank sizes
+std::size_t banks(can_filter_plan const& p_plan,
+                  can_filter_budget const& p_budget)
+{
+  return divide_rounding_up(used(p_plan.identifiers),
+                            p_budget.identifiers_per_bank) +
+         divide_rounding_up(used(p_plan.masks), p_budget.masks_per_bank) +
+         divide_rounding_up(used(p_plan.extended_identifiers),
+                            p_budget.extended_identifiers_per_bank) +
+         divide_rounding_up(used(p_plan.extended_masks),
+                            p_budget.extended_masks_per_bank);
+}
+
+bool within_budget(can_filter_plan const& p_plan,
+                   can_filter_budget const& p_budget)
+{
+  return used(p_plan.identifiers) <= p_budget.identifiers &&
+         used(p_plan.masks) <= p_budget.masks &&
+         used(p_plan.extended_identifiers) <= p_budget.extended_identifiers &&
+         used(p_plan.extended_masks) <= p_budget.extended_masks &&
+         banks(p_plan, p_budget) == p_plan.banks &&
+         p_plan.banks <= p_budget.banks;
+}
+
+/// Budgets of the STM32F1 & LPC40 boards, & tight ones forcing merges
+can_filter_budget random_budget(std::mt19937& p_random)
+{
+  switch (p_random() % 4) {
+    case 0:
+      return {};
+    case 1:
+      return { .banks = 32 };
+    default:
+      return { .identifiers = p_random() % 4,
+               .masks = 1 + p_random() % 4,
+               .extended_identifiers = p_random() % 3,
+               .extended_masks = 1 + p_random() % 3,
+               .banks = 2 + p_random() % 5 };
+  }
+}
+
+/// Single identifiers & short ranges, of one frame format
+std::vector<can_id_range> random_ranges(std::mt19937& p_random,
+                                        hal::u32 p_base,
+                                        hal::u32 p_span,
+                                        bool p_extended,
+                                        std::size_t p_most = 14,
+                                        hal::u32 p_longest = 48)
+{
+  std::vector<can_id_range> result(1 + p_random() % p_most);
+  for (auto& range : result) {
+    auto const first = static_cast<hal::u32>(p_base + (p_random() % p_span));
+    auto const length =
+      static_cast<hal::u32>(p_random() % 3 == 0 ? p_random() % p_longest : 0);
+    range = { .first = first,
+              .last = std::min(first + length, p_base + p_span - 1),
+              .extended = p_extended };
+  }
+  return result;
+}
+
+struct unwanted_counts
+{
+  /// Unwanted identifiers accepted by each mask filter
+  std::array<hal::u32, can_filter_slots> masks{};
+  /// Unwanted identifiers accepted by any filter
+  hal::u64 total = 0;
+  /// Two mask filters accept a common identifier
+  bool overlapping = false;
+};
+
+template<class pair_t>
+unwanted_counts count_unwanted(
+  std::array<std::optional<pair_t>, can_filter_slots> const& p_masks,
+  std::span<can_id_range const> p_wanted,
+  bool p_extended)
+{
+  auto const id_mask = p_extended ? extended_id_mask : standard_id_mask;
+  unwanted_counts counts{};
+  std::vector<hal::u32> all;
+  for (std::size_t i = 0; i < can_filter_slots; i++) {
+    if (not p_masks[i]) {
+      continue;
+    }
+    auto const& mask = *p_masks[i];
+    for (auto const id : accepted_ids(mask.id, mask.mask, id_mask)) {
+      if (not wanted(p_wanted, id, p_extended)) {
+        counts.masks[i]++;
+        all.push_back(id);
+      }
+    }
+    for (std::size_t j = 0; j < i; j++) {
+      if (p_masks[j] &&
+          overlap(mask.id, mask.mask, p_masks[j]->id, p_masks[j]->mask)) {
+        counts.overlapping = true;
+      }
+    }
+  }
+  std::ranges::sort(all);
+  counts.total = static_cast<hal::u64>(
+    std::distance(all.begin(), std::ranges::unique(all).begin()));
+  return counts;
+}
+}  // namespace
+
+void can_filter_plan_test()
+{
+  using namespace boost::ut;
+
+  "plan_can_filters() accepts every wanted standard id"_test = []() {
+    std::mt19937 random(14);
+    std::size_t planned = 0;
+    for (int i = 0; i < 300; i++) {
+      // Some with more patterns than the planner holds, which it merges as
+      // the ranges are added
+      auto const large = i % 4 == 0;
+      auto const wanted_ranges = random_ranges(
+        random, 0, 0x800, false, large ? 120 : 14, large ? 400 : 48);
+      auto const budget = random_budget(random);
+      auto const plan = plan_can_filters(wanted_ranges, budget);
+      if (not plan.fits) {
+        continue;
+      }
+      planned++;
+
+      hal::u64 unwanted = 0;
+      for (hal::u32 id = 0; id <= standard_id_mask; id++) {
+        auto const accepted = accepts(plan, id, false);
+        auto const asked = wanted(wanted_ranges, id, false);
+        expect(accepted || not asked) << "id:" << id;
+        unwanted += accepted && not asked ? 1 : 0;
+      }
+      auto const counts = count_unwanted(plan.masks, wanted_ranges, false);
+      expect(counts.masks == plan.mask_false_positives);
+      expect(counts.total == unwanted);
+      // An upper bound, exact unless mask filters overlap
+      expect(unwanted <= plan.false_positives);
+      expect(counts.overlapping || unwanted == plan.false_positives);
+      expect(within_budget(plan, budget));
+    }
+    expect(planned > 200U);
+  };
+
+  "plan_can_filters() accepts every wanted extended id"_test = []() {
+    std::mt19937 random(29);
+    std::size_t planned = 0;
+    for (int i = 0; i < 200; i++) {
+      // Standard & extended ids share the budget & banks
+      auto wanted_ranges = random_ranges(random, 0, 0x800, false);
+      auto const base = static_cast<hal::u32>((random() % 0x1FFF) << 16);
+      auto const extended = random_ranges(random, base, 0x1'0000, true);
+      wanted_ranges.insert(
+        wanted_ranges.end(), extended.begin(), extended.end());
+      auto const budget = random_budget(random);
+      auto const plan = plan_can_filters(wanted_ranges, budget);
+      if (not plan.fits) {
+        continue;
+      }
+      planned++;
+
+      for (auto const& range : extended) {
+        for (auto id = range.first; id <= range.last; id++) {
+          expect(accepts(plan, id, true)) << "id:" << id;
+        }
+      }
+      auto const standard =
+        count_unwanted(plan.masks, wanted_ranges, false);
+      auto const counts =
+        count_unwanted(plan.extended_masks, wanted_ranges, true);
+      expect(counts.masks == plan.extended_mask_false_positives);
+      auto const unwanted = standard.total + counts.total;
+      expect(unwanted <= plan.false_positives);
+      expect(standard.overlapping || counts.overlapping ||
+             unwanted == plan.false_positives);
+      expect(within_budget(plan, budget));
+    }
+    expect(planned > 100U);
+  };
+
+  "plan_can_filters() counts overlapping masks as an upper bound"_test = []() {
+    // Merged to two mask filters sharing identifiers 0x120 to 0x127
+    std::array wanted_ranges{
+      can_id_range{ .first = 0x187, .last = 0x187 },
+      can_id_range{ .first = 0x435, .last = 0x435 },
+      can_id_range{ .first = 0x36E, .last = 0x391 },
+      can_id_range{ .first = 0x122, .last = 0x13E },
+      can_id_range{ .first = 0x720, .last = 0x720 },
+      can_id_range{ .first = 0x1C3, .last = 0x1D6 },
+      can_id_range{ .first = 0x0E5, .last = 0x0E5 },
+      can_id_range{ .first = 0x0A6, .last = 0x0A6 },
+    };
+    can_filter_budget const budget{ .identifiers = 2, .masks = 2, .banks = 3 };
+    auto const plan = plan_can_filters(wanted_ranges, budget);
+
+    expect(plan.fits);
+    auto const counts = count_unwanted(plan.masks, wanted_ranges, false);
+    expect(counts.overlapping);
+    expect(counts.masks == plan.mask_false_positives);
+    expect(counts.total < plan.false_positives);
+    expect(plan.false_positives ==
+           hal::u64{ plan.mask_false_positives[0] } +
+             plan.mask_false_positives[1]);
+    for (auto const& range : wanted_ranges) {
+      for (auto id = range.first; id <= range.last; id++) {
+        expect(accepts(plan, id, false)) << "id:" << id;
+      }
+    }
+  };
+
+  "merge_exact() & merge_closest() keep count of false positives"_test =
+    []() {
+      std::array const wanted_ranges{
+        can_id_range{ .first = 0x100, .last = 0x100 },
+        can_id_range{ .first = 0x103, .last = 0x103 },
+        can_id_range{ .first = 0x400, .last = 0x400 },
+      };
+      detail::can_pattern_list list;
+      list.items[list.size++] = { .id = 0x200, .mask = 0x7FE, .unwanted = 1 };
+      list.items[list.size++] = { .id = 0x202, .mask = 0x7FE, .unwanted = 2 };
+      list.items[list.size++] = { .id = 0x201, .mask = 0x7FF };
+      list.items[list.size++] = { .id = 0x206, .mask = 0x7FE };
+
+      // Disjoint patterns add up, & the covered one is dropped
+      detail::merge_exact(list);
+      expect(list.size == 2U);
+      expect(list.items[0].id == 0x200U);
+      expect(list.items[0].mask == 0x7FCU);
+      expect(list.items[0].unwanted == 3U);
+
+      list.size = 0;
+      list.items[list.size++] = { .id = 0x100, .mask = 0x7FF };
+      list.items[list.size++] = { .id = 0x103, .mask = 0x7FF };
+      list.items[list.size++] = { .id = 0x400, .mask = 0x7FF };
+      expect(detail::merge_closest(list, wanted_ranges));
+      expect(list.size == 2U);
+      expect(list.items[0].id == 0x100U);
+      expect(list.items[0].mask == 0x7FCU);
+      expect(list.items[0].unwanted == 2U);
+      expect(list.items[1].id == 0x400U);
+      expect(not detail::merge_closest(list, wanted_ranges, true));
+    };
+
+  "plan_can_filters() fills banks within the budget"_test = []() {
+    // More single ids than identifier & mask filters, so some are merged
+    std::vector<can_id_range> singles;
+    for (hal::u32 i = 0; i < 20; i++) {
+      singles.push_back({ .first = 0x100 + (i * 3), .last = 0x100 + (i * 3) });
+    }
+    can_filter_budget const stm32f1{};
+    auto const plan = plan_can_filters(singles, stm32f1);
+    expect(plan.fits);
+    expect(within_budget(plan, stm32f1));
+    expect(plan.false_positives > 0U);
+
+    can_filter_budget const lpc40{ .banks = 32 };
+    auto const roomy = plan_can_filters(singles, lpc40);
+    expect(roomy.fits);
+    expect(within_budget(roomy, lpc40));
+
+    can_filter_budget const one_bank{ .banks = 1 };
+    auto const tight = plan_can_filters(singles, one_bank);
+    expect(tight.fits);
+    expect(tight.banks == 1U);
+    expect(within_budget(tight, one_bank));
+    for (auto const& range : singles) {
+      expect(accepts(tight, range.first, false));
+    }
+  };
+
+  "plan_can_filters() does not fit what the budget cannot hold"_test = []() {
+    std::array const standard{ can_id_range{ .first = 0x100, .last = 0x10F } };
+    std::array const extended{ can_id_range{
+      .first = 0x18FE'F100, .last = 0x18FE'F1FF, .extended = true } };
+
+    expect(not plan_can_filters(standard, { .identifiers = 0, .masks = 0 })
+                 .fits);
+    expect(not plan_can_filters(
+                 extended, { .extended_identifiers = 0, .extended_masks = 0 })
+                 .fits);
+    expect(not plan_can_filters(standard, { .banks = 0 }).fits);
+    expect(plan_can_filters(standard, { .banks = 1 }).fits);
+
+    // More disjoint ranges than the planner holds
+    std::vector<can_id_range> many;
+    for (hal::u32 i = 0; i < 129; i++) {
+      many.push_back({ .first = i * 4, .last = i * 4 });
+    }
+    expect(not plan_can_filters(many).fits);
+    many.pop_back();
+    expect(plan_can_filters(many).fits);
+  };
+}
+}  // namespace hal::micromod
@@ -0,0 +1,168 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/can_timestamp.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+/// Bits the 16-bit capture counts before wrapping
+constexpr hal::u64 capture_period = 1 << 16;
+
+struct bus_model
+{
+  explicit bus_model(hal::u32 p_ticks_per_bit, hal::u32 p_seed)
+    : ticks_per_bit(p_ticks_per_bit)
+    , random(p_seed)
+  {
+    // Neither the counter nor the bit edges line up with the uptime
+    capture_offset = static_cast<hal::u16>(random());
+    start = 1'000'000 + (random() % ticks_per_bit);
+  }
+
+  /// A message whose start of frame is the given bits after the previous
+  struct arrival
+  {
+    hal::u64 start_of_frame;
+    hal::u64 now;
+    hal::u16 capture;
+    hal::can_message message;
+  };
+
+  arrival next(hal::u64 p_gap_bits, hal::u64 p_excess_ticks)
+  {
+    bits += p_gap_bits;
+    hal::can_message message{
+      .id = static_cast<hal::u32>(random() % 0x800),
+      .length = static_cast<hal::u8>(random() % 9),
+      .extended = random() % 2 == 0,
+    };
+    auto const start_of_frame = start + (bits * ticks_per_bit);
+    auto const shortest =
+      hal::u64{ can_minimum_frame_bits(message) } * ticks_per_bit;
+    return {
+      .start_of_frame = start_of_frame,
+      .now = start_of_frame + shortest + p_excess_ticks,
+      .capture = static_cast<hal::u16>(capture_offset + bits),
+      .message = message,
+    };
+  }
+
+  hal::u32 ticks_per_bit;
+  std::mt19937 random;
+  hal::u16 capture_offset;
+  /// Uptime at bit 0
+  hal::u64 start;
+  hal::u64 bits = 0;
+};
+}  // namespace
+
+void can_timestamp_test()
+{
+  using namespace boost::ut;
+
+  "can_timestamp_extender removes the interrupt latency jitter"_test = []() {
+    for (hal::u32 const ticks_per_bit : { 1U, 144U, 2'000U }) {
+      bus_model bus(ticks_per_bit, ticks_per_bit);
+      can_timestamp_extender extender(ticks_per_bit);
+      std::uniform_int_distribution<hal::u64> gap(50, 3 * capture_period);
+      // Stuff bits & interrupt latency, up to 20,000 bits late
+      std::uniform_int_distribution<hal::u64> excess(0,
+                                                     20'000 * ticks_per_bit);
+
+      // Each timestamp is late by the least lateness seen so far
+      auto least = std::numeric_limits<hal::u64>::max();
+      for (int i = 0; i < 20'000; i++) {
+        auto const late = excess(bus.random);
+        auto const arrival = bus.next(gap(bus.random), late);
+        least = std::min(least, late);
+        auto const start_of_frame =
+          extender.extend(arrival.now, arrival.capture, arrival.message);
+        expect(start_of_frame == arrival.start_of_frame + least);
+      }
+    }
+  };
+
+  "can_timestamp_extender counts exact wraps of the capture"_test = []() {
+    constexpr hal::u32 ticks_per_bit = 144;
+    bus_model bus(ticks_per_bit, 1);
+    can_timestamp_extender extender(ticks_per_bit);
+
+    auto first = bus.next(0, 0);
+    expect(extender.extend(first.now, first.capture, first.message) ==
+           first.start_of_frame);
+    // Gaps the capture alone can not tell apart, the latency is as large as
+    // the extender handles
+    constexpr std::array<hal::u64, 8> gaps{
+      capture_period,     capture_period - 1,      capture_period + 1,
+      2 * capture_period, 40 * capture_period + 7, 47,
+      capture_period / 2, (capture_period / 2) + 1,
+    };
+    for (auto const gap : gaps) {
+      for (hal::u64 const late : { hal::u64{ 0 }, hal::u64{ 32'000 } }) {
+        auto const arrival = bus.next(gap, late * ticks_per_bit);
+        expect(extender.extend(arrival.now, arrival.capture, arrival.message) ==
+               arrival.start_of_frame);
+      }
+    }
+  };
+
+  "can_timestamp_extender catches up with an early message"_test = []() {
+    constexpr hal::u32 ticks_per_bit = 144;
+    bus_model bus(ticks_per_bit, 2);
+    can_timestamp_extender extender(ticks_per_bit);
+
+    // The first message comes 500 bits late, the timestamps stay late until
+    // a message arrives on time
+    constexpr hal::u64 late = 500 * ticks_per_bit;
+    for (int i = 0; i < 10; i++) {
+      auto const arrival = bus.next(1'000, late);
+      expect(extender.extend(arrival.now, arrival.capture, arrival.message) ==
+             arrival.start_of_frame + late);
+    }
+    for (int i = 0; i < 10; i++) {
+      auto const arrival = bus.next(1'000, i == 0 ? 0 : late);
+      expect(extender.extend(arrival.now, arrival.capture, arrival.message) ==
+             arrival.start_of_frame);
+    }
+  };
+
+  "can_timestamp_extender starts over after a reset"_test = []() {
+    bus_model bus(144, 3);
+    can_timestamp_extender extender(144);
+    auto arrival = bus.next(0, 0);
+    expect(extender.extend(arrival.now, arrival.capture, arrival.message) ==
+           arrival.start_of_frame);
+
+    // Half the bit rate, and the counter restarted
+    bus_model slower(288, 4);
+    slower.start = arrival.now + 10'000;
+    extender.reset(288);
+    constexpr hal::u64 late = 100;
+    arrival = slower.next(0, late);
+    expect(extender.extend(arrival.now, arrival.capture, arrival.message) ==
+           arrival.start_of_frame + late);
+    arrival = slower.next(5 * capture_period, 0);
+    expect(extender.extend(arrival.now, arrival.capture, arrival.message) ==
+           arrival.start_of_frame);
+  };
+}
+}  // namespace hal::micromod
@@ -0,0 +1,276 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/can_transmit_queue.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+class model_clock : public hal::steady_clock
+{
+public:
+  hal::u64 now = 0;
+
+private:
+  hal::hertz driver_frequency() override
+  {
+    return 1'000'000.0f;
+  }
+
+  hal::u64 driver_uptime() override
+  {
+    return now;
+  }
+};
+
+class null_lock : public hal::basic_lock
+{
+private:
+  void os_lock() override
+  {
+  }
+
+  void os_unlock() override
+  {
+  }
+};
+
+/**
+ * @brief bxCAN like controller, sending the loaded mailbox with the lowest
+ * identifier whenever the bus is free
+ *
+ * As on hardware, the next frame is chosen as soon as the bus is free, before
+ * the transmit interrupt of the last one runs. An abort of a mailbox that is
+ * not on the bus takes it out of arbitration at once, a mailbox already on
+ * the bus is sent despite the abort.
+ */
+class model_controller : public can_transmit_queue
+{
+public:
+  model_controller(std::span<can_queued_message> p_storage,
+                   model_clock& p_clock,
+                   null_lock& p_lock)
+    : can_transmit_queue(p_storage, p_clock, p_lock)
+  {
+  }
+
+  /// Run the pending transmit interrupts
+  void run_interrupts()
+  {
+    while (not m_interrupts.empty()) {
+      auto const [mailbox, transmitted] = m_interrupts.front();
+      m_interrupts.erase(m_interrupts.begin());
+      mailbox_complete(mailbox, transmitted);
+    }
+  }
+
+  /// Start sending the most urgent loaded mailbox, if the bus is free
+  std::optional<hal::can_message> start_frame()
+  {
+    if (m_on_bus) {
+      return std::nullopt;
+    }
+    for (std::size_t mailbox = 0; mailbox < m_loaded.size(); mailbox++) {
+      if (m_loaded[mailbox] &&
+          (not m_on_bus || can_arbitration_key(*m_loaded[mailbox]) <
+                             can_arbitration_key(*m_loaded[*m_on_bus]))) {
+        m_on_bus = mailbox;
+      }
+    }
+    if (not m_on_bus) {
+      return std::nullopt;
+    }
+    return m_loaded[*m_on_bus];
+  }
+
+  /// Finish sending the frame on the bus, its interrupt is left pending
+  void end_frame()
+  {
+    if (not m_on_bus) {
+      return;
+    }
+    m_loaded[*m_on_bus].reset();
+    m_interrupts.push_back({ *m_on_bus, true });
+    m_on_bus.reset();
+  }
+
+  [[nodiscard]] bool busy() const
+  {
+    return m_on_bus.has_value();
+  }
+
+  std::size_t aborts = 0;
+
+private:
+  void load_mailbox(std::size_t p_mailbox,
+                    hal::can_message const& p_message) override
+  {
+    m_loaded[p_mailbox] = p_message;
+  }
+
+  void abort_mailbox(std::size_t p_mailbox) override
+  {
+    aborts++;
+    if (m_on_bus != p_mailbox) {
+      m_loaded[p_mailbox].reset();
+      m_interrupts.push_back({ p_mailbox, false });
+    }
+  }
+
+  std::array<std::optional<hal::can_message>, can_mailbox_count> m_loaded{};
+  std::optional<std::size_t> m_on_bus;
+  std::vector<std::pair<std::size_t, bool>> m_interrupts;
+};
+
+/// Push number of a message, carried in its payload
+hal::u32 push_number(hal::can_message const& p_message)
+{
+  return p_message.payload[0] | (p_message.payload[1] << 8U) |
+         (p_message.payload[2] << 16U);
+}
+
+hal::can_message numbered(hal::can_message p_message, hal::u32 p_number)
+{
+  p_message.length = 3;
+  p_message.payload[0] = static_cast<hal::byte>(p_number);
+  p_message.payload[1] = static_cast<hal::byte>(p_number >> 8);
+  p_message.payload[2] = static_cast<hal::byte>(p_number >> 16);
+  return p_message;
+}
+}  // namespace
+
+void can_transmit_queue_test()
+{
+  using namespace boost::ut;
+
+  "can_transmit_queue preempts less urgent mailboxes"_test = []() {
+    model_clock clock;
+    null_lock lock;
+    std::array<can_queued_message, 8> storage{};
+    model_controller controller(storage, clock, lock);
+
+    for (hal::u32 id = 0x700; id < 0x704; id++) {
+      expect(controller.push({ .id = id }));
+    }
+    // 0x700 goes out, 0x701 & 0x702 wait in mailboxes, 0x703 in the queue
+    expect(controller.start_frame()->id == 0x700);
+    clock.now = 50;
+    expect(controller.push({ .id = 0x010 }));
+    // Including 0x700, which is sent despite the abort
+    expect(controller.aborts == 3);
+    controller.run_interrupts();
+
+    // Each frame takes 100us
+    std::vector<hal::u32> sent;
+    for (clock.now = 100;; clock.now += 100) {
+      controller.end_frame();
+      auto const message = controller.start_frame();
+      controller.run_interrupts();
+      if (not message) {
+        break;
+      }
+      sent.push_back(message->id);
+    }
+
+    // Held back only by the frame already on the bus
+    expect(sent == std::vector<hal::u32>{ 0x010, 0x701, 0x702, 0x703 });
+    auto const statistics = controller.statistics();
+    expect(statistics.preempted == 2);
+    expect(statistics.sent == 5);
+    expect(statistics.depth == 0);
+    expect(statistics.peak_depth == 5);
+    expect(statistics.total_latency == 100 + 150 + 300 + 400 + 500);
+    expect(statistics.worst_latency == 500);
+    expect(statistics.worst_latency_id == 0x703);
+  };
+
+  "can_transmit_queue never inverts priorities"_test = []() {
+    model_clock clock;
+    null_lock lock;
+    std::array<can_queued_message, 32> storage{};
+    model_controller controller(storage, clock, lock);
+    std::mt19937 random(15);
+
+    // Pushed but not yet sent, in push order
+    std::vector<hal::can_message> pending;
+    hal::u32 pushes = 0;
+    std::size_t inversions = 0;
+    std::size_t out_of_order = 0;
+    hal::u64 frame_end = 0;
+    std::optional<hal::can_message> on_bus;
+
+    for (clock.now = 0; clock.now < 2'000'000; clock.now++) {
+      // Bursts from a few identifiers, some shared & some extended
+      if (random() % 64 == 0) {
+        for (auto burst = random() % 6; burst > 0; burst--) {
+          hal::can_message message{
+            .id = static_cast<hal::u32>(0x100 + random() % 16 * 0x40),
+          };
+          if (random() % 5 == 0) {
+            message.extended = true;
+            message.id = (message.id << 18) | (random() % 4);
+          }
+          message = numbered(message, pushes);
+          if (controller.push(message)) {
+            pending.push_back(message);
+            pushes++;
+          }
+        }
+      }
+      controller.run_interrupts();
+
+      if (on_bus && clock.now >= frame_end) {
+        controller.end_frame();
+        on_bus.reset();
+      }
+      if (controller.busy()) {
+        continue;
+      }
+      on_bus = controller.start_frame();
+      if (not on_bus) {
+        continue;
+      }
+      frame_end = clock.now + 50 + random() % 80;
+
+      auto const key = can_arbitration_key(*on_bus);
+      auto const number = push_number(*on_bus);
+      for (auto const& message : pending) {
+        auto const other = can_arbitration_key(message);
+        inversions += other < key;
+        out_of_order += other == key && push_number(message) < number;
+      }
+      std::erase_if(pending, [number](hal::can_message const& p_message) {
+        return push_number(p_message) == number;
+      });
+    }
+
+    expect(pushes > 10'000);
+    expect(inversions == 0);
+    expect(out_of_order == 0);
+    auto const statistics = controller.statistics();
+    expect(statistics.preempted > 0);
+    expect(statistics.sent + statistics.depth == pushes);
+    expect(statistics.depth == pending.size() + (on_bus ? 1 : 0));
+  };
+}
+}  // namespace hal::micromod
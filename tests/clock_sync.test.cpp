@@ -0,0 +1,164 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/clock_sync.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+constexpr hal::u32 sync_id = 0x080;
+
+class model_clock : public hal::steady_clock
+{
+private:
+  hal::hertz driver_frequency() override
+  {
+    return 1'000'000.0f;
+  }
+
+  hal::u64 driver_uptime() override
+  {
+    return 0;
+  }
+};
+
+/// Holds the messages sent, as a transmit queue the test empties
+class model_transceiver : public hal::can_transceiver
+{
+public:
+  std::vector<hal::can_message> queued;
+
+private:
+  hal::u32 driver_baud_rate() override
+  {
+    return 500'000;
+  }
+
+  void driver_send(hal::can_message const& p_message) override
+  {
+    queued.push_back(p_message);
+  }
+
+  std::span<hal::can_message const> driver_receive_buffer() override
+  {
+    return {};
+  }
+
+  std::size_t driver_receive_cursor() override
+  {
+    return 0;
+  }
+};
+
+hal::u64 follow_up_time(hal::can_message const& p_message)
+{
+  hal::u64 time = 0;
+  for (std::size_t i = 0; i < 7; i++) {
+    time |= hal::u64{ p_message.payload[i + 1] } << (8 * i);
+  }
+  return time;
+}
+}  // namespace
+
+void clock_sync_test()
+{
+  using namespace boost::ut;
+
+  "clock_sync_master sends the time SYNC went out"_test = []() {
+    model_clock clock;
+    model_transceiver transceiver;
+    clock_sync_master master(transceiver, clock, sync_id);
+
+    master.sync();
+    expect(transceiver.queued.size() == 1);
+    auto const sync = transceiver.queued.back();
+    expect(sync.length == 1 && sync.payload[0] == 0x10);
+
+    // Nothing until SYNC was sent, other messages are not SYNC
+    master.poll();
+    expect(transceiver.queued.size() == 1);
+    master.transmitted({ .id = 0x081, .length = 1, .payload = { 0x10 } },
+                       1'000);
+    master.transmitted({ .id = sync_id, .length = 8, .payload = { 0x10 } },
+                       1'000);
+    master.poll();
+    expect(transceiver.queued.size() == 1);
+
+    // Microseconds at the start of frame, in nanoseconds
+    master.transmitted(sync, 123'456);
+    master.poll();
+    expect(transceiver.queued.size() == 2);
+    auto const follow_up = transceiver.queued.back();
+    expect(follow_up.id == sync_id && follow_up.length == 8);
+    expect(follow_up.payload[0] == 0x20);
+    expect(follow_up_time(follow_up) == 123'456'000);
+
+    // Only once
+    master.poll();
+    expect(transceiver.queued.size() == 2);
+  };
+
+  "clock_sync_master forgets a SYNC not sent in time"_test = []() {
+    model_clock clock;
+    model_transceiver transceiver;
+    clock_sync_master master(transceiver, clock, 0x1234'5678);
+
+    master.sync();
+    auto const first = transceiver.queued.back();
+    expect(first.extended);
+    master.sync();
+    auto const second = transceiver.queued.back();
+    expect(second.payload[0] == 0x11);
+
+    // The first SYNC going out late gets no FOLLOW_UP
+    master.transmitted(first, 10);
+    master.poll();
+    expect(transceiver.queued.size() == 2);
+
+    master.transmitted(second, 20);
+    master.poll();
+    expect(transceiver.queued.size() == 3);
+    expect(transceiver.queued.back().payload[0] == 0x21);
+    expect(follow_up_time(transceiver.queued.back()) == 20'000);
+  };
+
+  "clock_sync_master sequence numbers wrap"_test = []() {
+    model_clock clock;
+    model_transceiver transceiver;
+    clock_sync_master master(transceiver, clock, sync_id);
+
+    for (hal::u64 i = 0; i < 40; i++) {
+      master.sync();
+      auto const sync = transceiver.queued.back();
+      expect(sync.payload[0] == (0x10 | (i & 0xF)));
+      if (i % 3 != 0) {
+        master.transmitted(sync, i);
+      }
+      master.poll();
+      if (i % 3 != 0) {
+        expect(transceiver.queued.back().payload[0] == (0x20 | (i & 0xF)));
+        expect(follow_up_time(transceiver.queued.back()) == i * 1'000);
+      } else {
+        // Not reported sent, though earlier SYNCs with its sequence number
+        // were
+        expect(transceiver.queued.back().payload[0] == sync.payload[0]);
+      }
+    }
+  };
+}
+}  // namespace hal::micromod
@@ -0,0 +1,355 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/dac_stream.hpp>
+
+#include <algorithm>
+#include <csignal>
+#include <cstddef>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+constexpr std::size_t block_size = 8;
+
+/**
+ * @brief Plays the buffer one sample per step, the way the DMA does
+ *
+ * Step t plays sample t % block_size of block t / block_size, from the half of
+ * the buffer that block is in. The last sample of a block calls
+ * block_started(), as the DMA's terminal count interrupt does.
+ */
+class model_stream final : public dac_stream
+{
+public:
+  model_stream(std::span<hal::u32> p_buffer, hal::u32 p_sample_mask)
+    : dac_stream(p_buffer, 48'000.0f, p_sample_mask)
+  {
+  }
+
+  void play(std::size_t p_samples)
+  {
+    auto const samples = buffer();
+    for (std::size_t i = 0; i < p_samples; i++) {
+      auto const block = m_step / block_size;
+      played.push_back(
+        samples[((block % 2) * block_size) + (m_step % block_size)]);
+      m_step++;
+      if (m_step % block_size == 0) {
+        block_started();
+        underruns.push_back(statistics().underruns);
+      }
+    }
+  }
+
+  /// Play up to the next block boundary
+  void finish_block()
+  {
+    play(block_size - (m_step % block_size));
+  }
+
+  std::vector<hal::u32> played;
+  /// Underruns counted once each block started, from block 1
+  std::vector<hal::u32> underruns;
+
+private:
+  std::size_t m_step = 0;
+};
+
+std::vector<hal::u16> ramp(hal::u16 p_first, std::size_t p_size)
+{
+  std::vector<hal::u16> samples(p_size);
+  for (std::size_t i = 0; i < p_size; i++) {
+    samples[i] = static_cast<hal::u16>(p_first + i);
+  }
+  return samples;
+}
+
+/// Block p_block of the samples played
+std::vector<hal::u32> block(model_stream const& p_stream, std::size_t p_block)
+{
+  auto const start = p_stream.played.begin() + (p_block * block_size);
+  return { start, start + block_size };
+}
+
+std::vector<hal::u32> words(std::vector<hal::u16> const& p_samples)
+{
+  return { p_samples.begin(), p_samples.end() };
+}
+
+/**
+ * @brief Calls block_started() from within write(), as the DMA interrupt can
+ *
+ * Each block of the buffer spans two pages. With the second page of a block
+ * write protected, write() faults halfway through copying into the block &
+ * the fault handler starts the block before letting the copy go on.
+ */
+class interrupted_stream final : public dac_stream
+{
+public:
+  interrupted_stream(std::span<hal::u32> p_buffer, std::size_t p_page_size)
+    : dac_stream(p_buffer, 48'000.0f, dac_full_scale)
+    , m_page_size(p_page_size)
+  {
+  }
+
+  using dac_stream::block_started;
+
+  /// Start block p_block on the first write into its second page
+  void interrupt_in(std::size_t p_block)
+  {
+    auto const second_page = buffer()
+                               .subspan((p_block % 2) * block_samples())
+                               .subspan(m_page_size / sizeof(hal::u32));
+    m_protected = second_page.data();
+    active = this;
+    struct sigaction action{};
+    action.sa_sigaction = &interrupted_stream::handle_fault;
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, &m_previous_action);
+    mprotect(m_protected, m_page_size, PROT_READ);
+  }
+
+  int interrupts = 0;
+
+private:
+  static void handle_fault(int, siginfo_t*, void*)
+  {
+    mprotect(active->m_protected, active->m_page_size, PROT_READ | PROT_WRITE);
+    sigaction(SIGSEGV, &active->m_previous_action, nullptr);
+    active->interrupts++;
+    active->block_started();
+  }
+
+  static inline interrupted_stream* active = nullptr;
+  std::size_t m_page_size;
+  void* m_protected = nullptr;
+  struct sigaction m_previous_action{};
+};
+}  // namespace
+
+void dac_stream_test()
+{
+  using namespace boost::ut;
+
+  "written blocks play from the next block boundary"_test = []() {
+    std::vector<hal::u32> buffer(2 * block_size, 100);
+    model_stream stream(buffer, dac_full_scale);
+    expect(stream.block_samples() == block_size);
+    expect(stream.writable() == block_size);
+
+    std::vector<std::vector<hal::u16>> written;
+    for (std::size_t i = 1; i <= 6; i++) {
+      auto const& samples = written.emplace_back(
+        ramp(static_cast<hal::u16>(i * 1'000), block_size));
+      // Split across calls, while the block before plays
+      expect(stream.write(std::span(samples).first(3)) == 3);
+      stream.play(block_size / 2);
+      expect(stream.writable() == block_size - 3);
+      expect(stream.write(std::span(samples).subspan(3)) == block_size - 3);
+      expect(stream.writable() == 0);
+      stream.finish_block();
+      expect(stream.statistics().played == i);
+    }
+    stream.finish_block();
+    // Nothing was written for block 7
+    expect(stream.underruns == std::vector<hal::u32>{ 0, 0, 0, 0, 0, 0, 1 });
+
+    // Block 0 is the buffer's initial contents
+    expect(block(stream, 0) == std::vector<hal::u32>(block_size, 100));
+    for (std::size_t i = 1; i <= 6; i++) {
+      expect(block(stream, i) == words(written[i - 1]));
+    }
+  };
+
+  "write queues no further than the next block"_test = []() {
+    std::vector<hal::u32> buffer(2 * block_size);
+    model_stream stream(buffer, dac_full_scale);
+    auto const samples = ramp(1, 3 * block_size);
+
+    expect(stream.write(samples) == block_size);
+    expect(stream.write(samples) == 0);
+    stream.play(block_size - 1);
+    expect(stream.writable() == 0);
+    // Writable once the next block starts playing
+    stream.play(1);
+    expect(stream.writable() == block_size);
+    expect(stream.write(std::span(samples).subspan(block_size)) ==
+           block_size);
+    stream.play(2 * block_size);
+    expect(block(stream, 1) == words(ramp(1, block_size)));
+    expect(block(stream, 2) == words(ramp(1 + block_size, block_size)));
+    expect(stream.underruns == std::vector<hal::u32>{ 0, 0, 1 });
+  };
+
+  "an incomplete block plays as the last sample held"_test = []() {
+    std::vector<hal::u32> buffer(2 * block_size);
+    model_stream stream(buffer, dac_full_scale);
+    auto const first = ramp(10, block_size);
+    expect(stream.write(first) == block_size);
+    stream.finish_block();
+
+    // Half of block 2 when block 1 ends
+    expect(stream.write(ramp(500, block_size / 2)) == block_size / 2);
+    stream.finish_block();
+    expect(stream.statistics().underruns == 1);
+    // The half block is lost, writing starts over in block 3
+    expect(stream.writable() == block_size);
+    auto const third = ramp(900, block_size);
+    expect(stream.write(third) == block_size);
+    stream.finish_block();
+    stream.finish_block();
+
+    expect(block(stream, 1) == words(first));
+    expect(block(stream, 2) == std::vector<hal::u32>(block_size, first.back()));
+    expect(block(stream, 3) == words(third));
+    expect(stream.statistics().played == 4);
+    expect(stream.underruns == std::vector<hal::u32>{ 0, 1, 1, 2 });
+  };
+
+  "each block started empty is an underrun"_test = []() {
+    std::vector<hal::u32> buffer(2 * block_size, 7);
+    buffer[block_size - 1] = 42;
+    model_stream stream(buffer, dac_full_scale);
+    stream.play(5 * block_size);
+    expect(stream.statistics().played == 5);
+    expect(stream.statistics().underruns == 5);
+    for (std::size_t i = 1; i < 5; i++) {
+      expect(block(stream, i) == std::vector<hal::u32>(block_size, 42));
+    }
+
+    auto const samples = ramp(3, block_size);
+    expect(stream.write(samples) == block_size);
+    stream.finish_block();
+    stream.play(block_size);
+    expect(block(stream, 6) == words(samples));
+    expect(stream.underruns == std::vector<hal::u32>{ 1, 2, 3, 4, 5, 5, 6 });
+  };
+
+  "samples copied as their block starts go to the next block"_test = []() {
+    auto const page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    auto const block_words = 2 * page_size / sizeof(hal::u32);
+    // Page aligned, so that half of a block can be write protected
+    auto* memory = mmap(nullptr,
+                        4 * page_size,
+                        PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS,
+                        -1,
+                        0);
+    expect(memory != MAP_FAILED);
+    std::span buffer(static_cast<hal::u32*>(memory), 2 * block_words);
+    interrupted_stream stream(buffer, page_size);
+
+    auto const first = ramp(0, block_words);
+    expect(stream.write(first) == block_words);
+    stream.block_started();
+    auto const second = ramp(0x4000, block_words);
+    expect(stream.write(second) == block_words);
+    stream.block_started();
+
+    // Block 3 starts while its second half is copied
+    stream.interrupt_in(3);
+    auto const third = ramp(0x8000, block_words);
+    expect(stream.write(third) == block_words);
+    expect(stream.interrupts == 1);
+    expect(stream.statistics().underruns == 1U);
+
+    // The playing block holds the last sample of block 2 throughout, & the
+    // samples go into block 4
+    auto const playing = buffer.subspan(block_words, block_words);
+    auto const queued = buffer.first(block_words);
+    expect(std::ranges::all_of(playing, [&](auto p_word) {
+      return p_word == second.back();
+    }));
+    expect(std::ranges::equal(queued, words(third)));
+    expect(stream.writable() == 0U);
+
+    // Block 4 plays as written
+    stream.block_started();
+    expect(stream.statistics().underruns == 1U);
+    expect(stream.writable() == block_words);
+    munmap(memory, 4 * page_size);
+  };
+
+  "samples are masked to the bits the dac takes"_test = []() {
+    std::vector<hal::u32> buffer(2 * block_size);
+    model_stream stream(buffer, 0xFFC0);
+    std::vector<hal::u16> const samples(block_size, 0xABCD);
+    expect(stream.write(samples) == block_size);
+    stream.play(2 * block_size);
+    expect(block(stream, 1) == std::vector<hal::u32>(block_size, 0xABC0));
+  };
+
+  "writes at random moments play in order or hold whole blocks"_test = []() {
+    std::mt19937 random(5);
+    hal::u32 total_underruns = 0;
+    hal::u32 total_lost = 0;
+    for (int round = 0; round < 20; round++) {
+      std::vector<hal::u32> buffer(2 * block_size);
+      model_stream stream(buffer, dac_full_scale);
+      // Counts up from 1, so no written sample repeats the one before it
+      hal::u16 next = 1;
+      for (int i = 0; i < 400; i++) {
+        auto const count = static_cast<std::size_t>(random() % 12);
+        auto const queued = stream.write(ramp(next, count));
+        expect(queued <= count);
+        next = static_cast<hal::u16>(next + queued);
+        // Slower than the writer in the early rounds, faster in the late ones
+        stream.play(static_cast<std::size_t>(random() % (1 + round)));
+      }
+      stream.finish_block();
+
+      auto const blocks = stream.played.size() / block_size;
+      expect(stream.statistics().played == blocks);
+      hal::u32 underruns = 0;
+      hal::u32 holds = 0;
+      hal::u32 last = 0;
+      for (std::size_t i = 1; i < blocks; i++) {
+        auto const played = block(stream, i);
+        auto const previous = block(stream, i - 1).back();
+        auto const hold = played == std::vector<hal::u32>(block_size, previous);
+        if (hold) {
+          underruns++;
+          holds++;
+        }
+        expect(stream.underruns[i - 1] == underruns);
+        if (hold) {
+          continue;
+        }
+        // Otherwise the samples accepted after the last ones played, less
+        // the incomplete blocks the holds since then took
+        expect(played == words(ramp(static_cast<hal::u16>(played.front()),
+                                    block_size)));
+        auto const lost = played.front() - last - 1;
+        expect(lost == 0 || lost < holds * block_size);
+        total_lost += lost;
+        last = played.back();
+        holds = 0;
+      }
+      total_underruns += underruns;
+    }
+    // The rounds reached both an underrun & a lost incomplete block
+    expect(total_underruns > 0);
+    expect(total_lost > 0);
+  };
+}
+}  // namespace hal::micromod
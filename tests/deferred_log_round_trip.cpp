@@ -0,0 +1,110 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Logs each case as a deferred log frame & as text formatted by snprintf(), for
+// deferred_log_round_trip.py to decode the frames with the ELF file of this
+// program and compare.
+
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+
+#include <libhal-micromod/deferred_log.hpp>
+
+namespace {
+/// Writes to a file
+class file_serial final : public hal::serial
+{
+public:
+  explicit file_serial(std::FILE* p_file)
+    : m_file(p_file)
+  {
+  }
+
+private:
+  void driver_configure(settings const&) override
+  {
+  }
+
+  write_t driver_write(std::span<hal::byte const> p_data) override
+  {
+    std::fwrite(p_data.data(), 1, p_data.size(), m_file);
+    return { .data = p_data };
+  }
+
+  read_t driver_read(std::span<hal::byte> p_data) override
+  {
+    return { .data = p_data.first(0), .available = 0, .capacity = 0 };
+  }
+
+  void driver_flush() override
+  {
+  }
+
+  std::FILE* m_file;
+};
+
+enum class state : std::uint8_t
+{
+  idle = 3,
+};
+}  // namespace
+
+#define ROUND_TRIP(p_format, ...)                                              \
+  do {                                                                         \
+    LIBHAL_MICROMOD_LOG(frames, p_format __VA_OPT__(, ) __VA_ARGS__);          \
+    std::snprintf(                                                             \
+      buffer.data(), buffer.size(), p_format __VA_OPT__(, ) __VA_ARGS__);      \
+    std::fprintf(text, "%s\n", buffer.data());                                 \
+  } while (false)
+
+int main(int p_argc, char** p_argv)
+{
+  if (p_argc != 3) {
+    std::fprintf(stderr, "usage: %s <frame file> <text file>\n", p_argv[0]);
+    return 2;
+  }
+  auto* const frame_file = std::fopen(p_argv[1], "wb");
+  auto* const text = std::fopen(p_argv[2], "w");
+  if (frame_file == nullptr || text == nullptr) {
+    std::perror("fopen");
+    return 2;
+  }
+  file_serial frames(frame_file);
+  std::array<char, 128> buffer{};
+
+  ROUND_TRIP("no arguments");
+  ROUND_TRIP("100%% of %d", 7);
+  ROUND_TRIP("signed %d %d %i %+d |%-6d| |%6d|", 0, -1, 123456, 5, -42, 42);
+  ROUND_TRIP("limits %d %d", INT32_MIN, INT32_MAX);
+  ROUND_TRIP("64-bit %" PRId64 " %" PRIu64, INT64_MIN, UINT64_MAX);
+  ROUND_TRIP("unsigned %u %lu %zu", 4000000000u, 1UL << 31, std::size_t{ 77 });
+  ROUND_TRIP("hex %x %X %#x %08X %o", 0xbeefu, 0xbeefu, 255u, 0xABCu, 8u);
+  ROUND_TRIP("bytes %02hhX %hhu %hhd", std::uint8_t{ 0x0F }, 250, -5);
+  ROUND_TRIP("char %c|%3c", 'A', 'z');
+  ROUND_TRIP("enum %u", static_cast<unsigned>(state::idle));
+  ROUND_TRIP("float %f %.2f %e %g %G", 1.5f, -3.25f, 1024.0f, 0.125f, 1e-6f);
+  ROUND_TRIP("hex float %a %A %a", 1.0f, 0.5f, 0.0f);
+  ROUND_TRIP("pointer %p", reinterpret_cast<void*>(0x1234));
+  ROUND_TRIP("string %s, %8s, %-4s|, %.3s", "micromod", "can", "ok", "length");
+  ROUND_TRIP("empty string '%s'", "");
+  ROUND_TRIP("mixed %s=%d (%u%%) %c", "speed", -30, 97u, 'k');
+
+  std::fclose(frame_file);
+  std::fclose(text);
+  return 0;
+}
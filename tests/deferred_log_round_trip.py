@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+#
+# Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Check that deferred log frames decode to the text snprintf formats.
+
+Runs the deferred_log_round_trip program, which writes the same messages as
+LIBHAL_MICROMOD_LOG() frames & as snprintf text, decodes the frames with
+deferred_log_decoder.py & the program's ELF file, and compares the lines.
+
+    deferred_log_round_trip.py <program> <deferred_log_decoder.py>
+"""
+
+import difflib
+import pathlib
+import subprocess
+import sys
+import tempfile
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__.splitlines()[-1].strip())
+    program, decoder = sys.argv[1:]
+
+    with tempfile.TemporaryDirectory() as directory:
+        frames = pathlib.Path(directory, "frames.bin")
+        text = pathlib.Path(directory, "text.txt")
+        subprocess.run([program, frames, text], check=True)
+        decoded = subprocess.run(
+            [sys.executable, decoder, program, frames], check=True,
+            capture_output=True, text=True).stdout
+        expected = text.read_text()
+
+    if decoded != expected:
+        sys.stdout.writelines(difflib.unified_diff(
+            expected.splitlines(keepends=True),
+            decoded.splitlines(keepends=True), "snprintf", "decoded"))
+        sys.exit(1)
+    print(f"{len(expected.splitlines())} messages match")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,314 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "stm32f1/dma_spi.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <libhal/error.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+using namespace hal::micromod::stm32f1;
+
+constexpr std::uint8_t sck_pin = 5;
+constexpr std::uint8_t copi_pin = 6;
+constexpr std::uint8_t cipo_pin = 7;
+constexpr hal::hertz timer_clock = 64'000'000.0f;
+constexpr std::size_t buffer_bits = dma_spi::half_bytes * 8 * 2;
+
+/// Low 32 bits of an address, all the DMA registers hold on the host
+std::uint32_t dma_address(void const volatile* p_address)
+{
+  return static_cast<std::uint32_t>(
+    reinterpret_cast<std::uintptr_t>(p_address));
+}
+
+/**
+ * @brief DMA1, TIM3 & port model, played out as the driver reads the uptime
+ *
+ * While TIM3 counts, each read of the uptime plays one half of the waveform
+ * buffer through the port & raises the sample channel's interrupt, so a whole
+ * transfer runs within the driver's wait loop. The DMA registers only hold the
+ * low 32 bits of the buffers' addresses on the host, the upper bits are those
+ * of the driver owning the buffers. CIPO reads COPI back, & the bits COPI
+ * holds at each sampling edge of SCK are what a device receives.
+ */
+class dma_model : public hal::steady_clock
+{
+public:
+  dma_reg_t dma{};
+  timer_reg_t timer{};
+  gpio_reg_t port{};
+  /// The DMA never gets going, as if misconfigured
+  bool stalled = false;
+  /// Devices sample on the rising edge of SCK, otherwise on the falling edge
+  bool sample_on_rising = true;
+  std::vector<hal::byte> received;
+  std::size_t rising_edges = 0;
+
+  void driver(dma_spi& p_driver)
+  {
+    m_driver = &p_driver;
+  }
+
+private:
+  hal::hertz driver_frequency() override
+  {
+    return 1'000'000.0f;
+  }
+
+  hal::u64 driver_uptime() override
+  {
+    if (not stalled && (timer.cr1 & timer_bits::counter_enable) != 0) {
+      play_half();
+    }
+    return m_uptime++;
+  }
+
+  template<class T>
+  T* buffer(std::uint32_t p_address) const
+  {
+    auto const owner = static_cast<std::uint64_t>(
+      reinterpret_cast<std::uintptr_t>(m_driver));
+    auto address = (owner & ~std::uint64_t{ 0xFFFF'FFFF }) | p_address;
+    if (address < owner) {
+      address += std::uint64_t{ 1 } << 32;
+    }
+    return reinterpret_cast<T*>(static_cast<std::uintptr_t>(address));
+  }
+
+  [[nodiscard]] bool enabled(dma_channel_reg_t const& p_channel,
+                             reg_t const& p_peripheral) const
+  {
+    return (p_channel.ccr & dma_ccr::enable) != 0 &&
+           p_channel.cndtr == buffer_bits &&
+           p_channel.cpar == dma_address(&p_peripheral);
+  }
+
+  void write_bsrr(std::uint32_t p_word)
+  {
+    auto const before = (port.odr >> sck_pin) & 1U;
+    // Set takes priority over reset
+    port.odr = (port.odr & ~(p_word >> 16)) | (p_word & 0xFFFF);
+    auto const after = (port.odr >> sck_pin) & 1U;
+    if (before == after) {
+      return;
+    }
+    rising_edges += after;
+    if ((after == 1) == sample_on_rising) {
+      auto const bit = (port.odr >> copi_pin) & 1U;
+      if (m_device_bits++ % 8 == 0) {
+        received.push_back(0);
+      }
+      received.back() = static_cast<hal::byte>((received.back() << 1) | bit);
+    }
+  }
+
+  void play_half()
+  {
+    auto& lead = dma.channel[2];
+    auto& trail = dma.channel[1];
+    auto& sample = dma.channel[5];
+    if (not enabled(lead, port.bsrr) || not enabled(trail, port.bsrr) ||
+        not enabled(sample, port.idr)) {
+      return;
+    }
+    auto const* lead_words = buffer<std::uint32_t const>(lead.cmar);
+    auto const* trail_words = buffer<std::uint32_t const>(trail.cmar);
+    auto* samples = buffer<std::uint16_t>(sample.cmar);
+
+    for (std::size_t i = 0; i < buffer_bits / 2; i++, m_bit++) {
+      auto const index = m_bit % buffer_bits;
+      write_bsrr(lead_words[index]);
+      write_bsrr(trail_words[index]);
+      auto const copi = (port.odr >> copi_pin) & 1U;
+      port.idr = (port.odr & ~(1U << cipo_pin)) | (copi << cipo_pin);
+      samples[index] = static_cast<std::uint16_t>(port.idr);
+    }
+
+    // Half transfer completes the first half, transfer complete the second
+    auto const flag = m_bit % buffer_bits == 0 ? 1U : 2U;
+    dma.isr = dma.isr | dma_flag(6, 0) | dma_flag(6, flag);
+    dma.ifcr = 0;
+    m_driver->handle_interrupt();
+    clear_flags();
+  }
+
+  /// Clearing a channel's global flag clears all four of its flags
+  void clear_flags()
+  {
+    auto cleared = static_cast<std::uint32_t>(dma.ifcr);
+    for (std::uint32_t channel = 1; channel <= 7; channel++) {
+      if ((cleared & dma_flag(channel, 0)) != 0) {
+        cleared = cleared | dma_flag(channel, 1) | dma_flag(channel, 2) |
+                  dma_flag(channel, 3);
+      }
+    }
+    dma.isr = dma.isr & ~cleared;
+  }
+
+  dma_spi* m_driver = nullptr;
+  hal::u64 m_uptime = 0;
+  std::size_t m_bit = 0;
+  std::size_t m_device_bits = 0;
+};
+
+std::vector<hal::byte> pattern(std::size_t p_size)
+{
+  std::vector<hal::byte> data(p_size);
+  for (std::size_t i = 0; i < p_size; i++) {
+    data[i] = static_cast<hal::byte>((i * 37) + 0x5A);
+  }
+  return data;
+}
+}  // namespace
+
+void dma_spi_test()
+{
+  using namespace boost::ut;
+  constexpr dma_spi::pins pins{
+    .sck = sck_pin,
+    .copi = copi_pin,
+    .cipo = cipo_pin,
+  };
+
+  "dma_spi transfers full duplex"_test = [&]() {
+    dma_model model;
+    dma_spi driver(
+      model.dma, model.timer, model.port, pins, model, timer_clock, {});
+    model.driver(driver);
+    // Longer than the double buffer, so halves are refilled
+    auto const out = pattern(45);
+    std::vector<hal::byte> in(out.size());
+
+    driver.transfer(out, in);
+
+    expect(in == out);
+    expect(model.received == out);
+    expect(model.rising_edges == out.size() * 8);
+    expect(((model.port.odr >> sck_pin) & 1U) == 0);
+    expect(model.timer.cr1 == 0);
+  };
+
+  "dma_spi reads send the filler"_test = [&]() {
+    dma_model model;
+    dma_spi driver(
+      model.dma, model.timer, model.port, pins, model, timer_clock, {});
+    model.driver(driver);
+    std::vector<hal::byte> in(12, 0x55);
+
+    driver.transfer({}, in, 0x00);
+
+    expect(in == std::vector<hal::byte>(12, 0x00));
+    expect(model.received == std::vector<hal::byte>(12, 0x00));
+  };
+
+  "dma_spi clocks the longer of the two buffers"_test = [&]() {
+    dma_model model;
+    dma_spi driver(
+      model.dma, model.timer, model.port, pins, model, timer_clock, {});
+    model.driver(driver);
+    auto const out = pattern(3);
+    std::array<hal::byte, 20> in{};
+
+    driver.transfer(out, in, 0xA5);
+
+    expect(std::equal(out.begin(), out.end(), in.begin()));
+    expect(in[3] == 0xA5 && in.back() == 0xA5);
+    expect(model.received.size() == in.size());
+  };
+
+  "dma_spi runs every clock mode"_test = [&]() {
+    for (auto const idles_high : { false, true }) {
+      for (auto const trailing : { false, true }) {
+        dma_model model;
+        model.sample_on_rising = idles_high == trailing;
+        dma_spi::settings const settings{
+          .clock_rate = 1'000'000.0f,
+          .clock_idles_high = idles_high,
+          .data_valid_on_trailing_edge = trailing,
+        };
+        dma_spi driver(model.dma,
+                       model.timer,
+                       model.port,
+                       pins,
+                       model,
+                       timer_clock,
+                       settings);
+        model.driver(driver);
+        auto const out = pattern(17);
+        std::vector<hal::byte> in(out.size());
+
+        driver.transfer(out, in);
+
+        expect(in == out);
+        expect(model.received == out);
+        expect(((model.port.odr >> sck_pin) & 1U) == (idles_high ? 1U : 0U));
+      }
+    }
+  };
+
+  "dma_spi paces the bits with timer 3"_test = [&]() {
+    dma_model model;
+    model.stalled = true;
+    dma_spi driver(model.dma,
+                   model.timer,
+                   model.port,
+                   pins,
+                   model,
+                   timer_clock,
+                   { .clock_rate = 1'000'000.0f });
+    model.driver(driver);
+    std::array<hal::byte, 1> out{ 0x42 };
+    auto const transfer = [&]() { driver.transfer(out, {}); };
+
+    expect(throws<hal::timed_out>(transfer));
+    // Programmed before the transfer timed out
+    expect(model.timer.psc == 0);
+    expect(model.timer.arr == 63);
+    expect(model.timer.ccr3 == 32);
+    expect(model.timer.ccr1 == 48);
+
+    driver.configure({ .clock_rate = 100.0f });
+    expect(throws<hal::timed_out>(transfer));
+    // 640000 ticks per bit, split by the prescaler
+    expect(model.timer.psc == 9);
+    expect(model.timer.arr == 63'999);
+  };
+
+  "dma_spi times out when the dma never completes"_test = [&]() {
+    dma_model model;
+    model.stalled = true;
+    dma_spi driver(
+      model.dma, model.timer, model.port, pins, model, timer_clock, {});
+    model.driver(driver);
+    auto const out = pattern(4);
+
+    expect(throws<hal::timed_out>([&]() { driver.transfer(out, {}); }));
+    expect(model.timer.cr1 == 0);
+    expect(model.dma.channel[5].ccr == 0);
+
+    // The next transfer starts from scratch
+    model.stalled = false;
+    std::vector<hal::byte> in(out.size());
+    driver.transfer(out, in);
+    expect(in == out);
+  };
+}
+}  // namespace hal::micromod
@@ -0,0 +1,299 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/dsp.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+constexpr std::array<dsp_kernel, 2> kernels{ dsp_kernel::scalar,
+                                             dsp_kernel::dual_mac };
+
+/// Divide by 2^p_shift rounding to nearest, half up, & saturate to q15
+q15 reference_narrow(std::int64_t p_value, int p_shift)
+{
+  auto const scale = static_cast<double>(std::int64_t{ 1 } << p_shift);
+  auto const rounded = std::floor((static_cast<double>(p_value) / scale) + 0.5);
+  return static_cast<q15>(std::clamp(rounded, -32768.0, 32767.0));
+}
+
+/// Input sample n, zero before the first
+q15 at(std::vector<q15> const& p_input, std::ptrdiff_t p_n)
+{
+  return p_n < 0 ? q15{ 0 } : p_input[static_cast<std::size_t>(p_n)];
+}
+
+std::vector<q15> reference_fir(std::vector<q15> const& p_taps,
+                               std::vector<q15> const& p_input)
+{
+  std::vector<q15> output(p_input.size());
+  for (std::size_t n = 0; n < p_input.size(); n++) {
+    std::int64_t sum = 0;
+    for (std::size_t k = 0; k < p_taps.size(); k++) {
+      sum += std::int64_t{ p_taps[k] } *
+             at(p_input, static_cast<std::ptrdiff_t>(n - k));
+    }
+    output[n] = reference_narrow(sum, 15);
+  }
+  return output;
+}
+
+std::vector<q15> reference_biquads(
+  std::vector<biquad_coefficients> const& p_stages,
+  std::vector<q15> p_signal)
+{
+  for (auto const& stage : p_stages) {
+    std::vector<q15> output(p_signal.size());
+    for (std::size_t n = 0; n < p_signal.size(); n++) {
+      auto const i = static_cast<std::ptrdiff_t>(n);
+      auto const y = [&output](std::ptrdiff_t p_n) {
+        return p_n < 0 ? std::int64_t{ 0 }
+                       : std::int64_t{ output[static_cast<std::size_t>(p_n)] };
+      };
+      auto const sum = (std::int64_t{ stage.b0 } * at(p_signal, i)) +
+                       (std::int64_t{ stage.b1 } * at(p_signal, i - 1)) +
+                       (std::int64_t{ stage.b2 } * at(p_signal, i - 2)) -
+                       (std::int64_t{ stage.a1 } * y(i - 1)) -
+                       (std::int64_t{ stage.a2 } * y(i - 2));
+      output[n] = reference_narrow(sum, 14);
+    }
+    p_signal = output;
+  }
+  return p_signal;
+}
+
+std::vector<q15> reference_average(std::size_t p_window,
+                                   std::vector<q15> const& p_input)
+{
+  std::vector<q15> output(p_input.size());
+  auto const shift = std::countr_zero(p_window);
+  for (std::size_t n = 0; n < p_input.size(); n++) {
+    std::int64_t sum = 0;
+    for (std::size_t k = 0; k < p_window; k++) {
+      sum += at(p_input, static_cast<std::ptrdiff_t>(n - k));
+    }
+    output[n] = reference_narrow(sum, shift);
+  }
+  return output;
+}
+
+/// order moving sums of R samples, kept at every R-th input
+std::vector<q15> reference_cic(std::size_t p_order,
+                               std::size_t p_ratio,
+                               std::vector<q15> const& p_input)
+{
+  std::vector<std::int64_t> signal(p_input.begin(), p_input.end());
+  for (std::size_t stage = 0; stage < p_order; stage++) {
+    std::vector<std::int64_t> sums(signal.size());
+    for (std::size_t n = 0; n < signal.size(); n++) {
+      for (std::size_t k = 0; k < p_ratio && k <= n; k++) {
+        sums[n] += signal[n - k];
+      }
+    }
+    signal = sums;
+  }
+  std::vector<q15> output;
+  auto const shift = static_cast<int>(p_order) * std::countr_zero(p_ratio);
+  for (auto n = p_ratio - 1; n < signal.size(); n += p_ratio) {
+    output.push_back(reference_narrow(signal[n], shift));
+  }
+  return output;
+}
+
+std::vector<q15> random_signal(std::mt19937& p_random, std::size_t p_size)
+{
+  std::uniform_int_distribution<int> sample(-32768, 32767);
+  std::vector<q15> signal(p_size);
+  for (auto& value : signal) {
+    // Runs at full scale to reach the saturation
+    value = p_random() % 8 == 0 ? q15{ -32768 }
+                                : static_cast<q15>(sample(p_random));
+  }
+  return signal;
+}
+
+/// Feeds p_input in random length blocks, in place every other block
+template<class process_t>
+std::vector<q15> in_blocks(std::mt19937& p_random,
+                           std::vector<q15> const& p_input,
+                           process_t p_process)
+{
+  std::vector<q15> output(p_input.size());
+  std::size_t done = 0;
+  bool in_place = false;
+  while (done < p_input.size()) {
+    auto const size =
+      std::min<std::size_t>(p_random() % 70, p_input.size() - done);
+    auto const input = std::span(p_input).subspan(done, size);
+    auto const block = std::span(output).subspan(done, size);
+    if (in_place) {
+      std::ranges::copy(input, block.begin());
+      p_process(std::span<q15 const>(block), block);
+    } else {
+      p_process(input, block);
+    }
+    in_place = not in_place;
+    done += size;
+  }
+  return output;
+}
+}  // namespace
+
+void dsp_test()
+{
+  using namespace boost::ut;
+
+  "fir_filter matches the reference convolution"_test = []() {
+    std::mt19937 random(1);
+    for (std::size_t const taps : { 1, 2, 7, 8, 31, 64 }) {
+      std::vector<q15> coefficients = random_signal(random, taps);
+      auto const input = random_signal(random, 600);
+      auto const expected = reference_fir(coefficients, input);
+      for (auto const kernel : kernels) {
+        // Room for 16 samples a pass, so long blocks take several
+        std::vector<q15> state(taps - 1 + 16);
+        fir_filter filter(coefficients, state);
+        auto const output =
+          in_blocks(random, input, [&](auto p_input, auto p_output) {
+            filter.process(p_input, p_output, kernel);
+          });
+        expect(output == expected);
+
+        filter.reset();
+        std::vector<q15> again(input.size());
+        filter.process(input, again, kernel);
+        expect(again == expected);
+      }
+    }
+  };
+
+  "biquad_cascade matches the reference recursion"_test = []() {
+    std::mt19937 random(2);
+    std::vector<std::vector<biquad_coefficients>> const cascades{
+      {},
+      // The dsp_benchmark's Butterworth low pass
+      {
+        { .b0 = 312, .b1 = 624, .b2 = 312, .a1 = -24243, .a2 = 9107 },
+        { .b0 = 359, .b1 = 717, .b2 = 359, .a1 = -27869, .a2 = 12919 },
+      },
+      // Extremes of the coefficients, saturating
+      {
+        { .b0 = -32768, .b1 = 32767, .b2 = -32768, .a1 = 32767, .a2 = -32768 },
+      },
+    };
+    for (auto const& stages : cascades) {
+      auto const input = random_signal(random, 500);
+      auto const expected = reference_biquads(stages, input);
+      for (auto const kernel : kernels) {
+        std::vector<biquad_state> state(stages.size());
+        biquad_cascade cascade(stages, state);
+        auto const output =
+          in_blocks(random, input, [&](auto p_input, auto p_output) {
+            cascade.process(p_input, p_output, kernel);
+          });
+        expect(output == expected);
+      }
+    }
+
+    // Random stages, random coefficients
+    for (int i = 0; i < 20; i++) {
+      std::vector<biquad_coefficients> stages(1 + (random() % 3));
+      for (auto& stage : stages) {
+        auto const values = random_signal(random, 5);
+        stage = { values[0], values[1], values[2], values[3], values[4] };
+      }
+      auto const input = random_signal(random, 200);
+      auto const expected = reference_biquads(stages, input);
+      for (auto const kernel : kernels) {
+        std::vector<biquad_state> state(stages.size());
+        biquad_cascade cascade(stages, state);
+        std::vector<q15> output(input.size());
+        cascade.process(input, output, kernel);
+        expect(output == expected);
+      }
+    }
+  };
+
+  "moving_average matches the reference mean"_test = []() {
+    std::mt19937 random(3);
+    for (std::size_t const size : { 1, 2, 16, 40, 256 }) {
+      std::vector<q15> window(size);
+      moving_average average(window);
+      // The largest power of two that fits
+      auto const used = std::bit_floor(size);
+      auto const input = random_signal(random, 1'000);
+      auto const output =
+        in_blocks(random, input, [&](auto p_input, auto p_output) {
+          average.process(p_input, p_output);
+        });
+      expect(output == reference_average(used, input));
+    }
+  };
+
+  "cic_decimator matches the reference moving sums"_test = []() {
+    std::mt19937 random(4);
+    for (std::size_t order = 1; order <= cic_decimator::maximum_order;
+         order++) {
+      for (std::size_t const ratio : { 1, 2, 4, 8, 16 }) {
+        if (order * std::countr_zero(ratio) > 16) {
+          continue;
+        }
+        auto const input = random_signal(random, 1'024);
+        auto const expected = reference_cic(order, ratio, input);
+        cic_decimator decimator(order, ratio);
+        std::vector<q15> output(expected.size());
+        std::size_t written = 0;
+        for (std::size_t done = 0; done < input.size();) {
+          auto const size =
+            std::min<std::size_t>(random() % 50, input.size() - done);
+          written += decimator.process(std::span(input).subspan(done, size),
+                                       std::span(output).subspan(written));
+          done += size;
+        }
+        expect(written == expected.size());
+        expect(output == expected);
+      }
+    }
+  };
+
+  "cic_decimator limits the ratio to 16 bits of growth"_test = []() {
+    for (std::size_t order = 1; order <= cic_decimator::maximum_order;
+         order++) {
+      auto const limit = std::size_t{ 1 } << (16 / order);
+      for (std::size_t const ratio : { limit, 2 * limit, 1'000 * limit }) {
+        // Full scale input, the most the integrators grow by
+        std::vector<q15> const input(4 * 2 * limit * order, -32768);
+        cic_decimator decimator(order, ratio);
+        std::vector<q15> output(input.size());
+        auto const written = decimator.process(input, output);
+        expect(written == input.size() / limit);
+        // Settled after order outputs
+        expect(std::all_of(output.begin() + order,
+                           output.begin() + written,
+                           [](q15 p_sample) { return p_sample == -32768; }));
+      }
+    }
+  };
+}
+}  // namespace hal::micromod
@@ -0,0 +1,648 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "stm32f1/i2c.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <libhal/error.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+using namespace hal::micromod::stm32f1;
+using namespace std::chrono_literals;
+
+constexpr hal::hertz bus_clock = 36'000'000.0f;
+constexpr hal::byte device_address = 0x42;
+/// DR while empty for the driver to write, outside of the range of a byte
+constexpr std::uint32_t no_byte = 0x100;
+/// Receive buffer contents the driver has not yet read into
+constexpr hal::byte unread = 0xFF;
+
+constexpr std::uint32_t peripheral_enable = 1 << 0;
+constexpr std::uint32_t start = 1 << 8;
+constexpr std::uint32_t stop = 1 << 9;
+constexpr std::uint32_t ack = 1 << 10;
+constexpr std::uint32_t pos = 1 << 11;
+constexpr std::uint32_t error_interrupt = 1 << 8;
+constexpr std::uint32_t event_interrupt = 1 << 9;
+constexpr std::uint32_t buffer_interrupt = 1 << 10;
+constexpr std::uint32_t start_bit = 1 << 0;
+constexpr std::uint32_t address_sent = 1 << 1;
+constexpr std::uint32_t byte_transfer_finished = 1 << 2;
+constexpr std::uint32_t receive_not_empty = 1 << 6;
+constexpr std::uint32_t transmit_empty = 1 << 7;
+constexpr std::uint32_t bus_error = 1 << 8;
+constexpr std::uint32_t arbitration_lost = 1 << 9;
+constexpr std::uint32_t acknowledge_failure = 1 << 10;
+
+/**
+ * @brief I2C1 & bus model, played out as the driver reads the uptime
+ *
+ * Reads of the uptime take turns to raise the event interrupt, while an
+ * enabled event flag is set, & to move the bus on by a START, a STOP or a
+ * byte. SB, ADDR & BTF hold the bus as SCL is stretched. What goes over the
+ * bus is logged as the device sees it, e.g. "S W42+ 01- P" for a START, the
+ * write address ACKed, a data byte NACKed & a STOP.
+ *
+ * Writes of DR are seen as it no longer holding `no_byte`. Reads of DR are
+ * seen as bytes of the receive buffer no longer holding `unread`, & those
+ * bytes are then set to what each read returns on the hardware: DR, then the
+ * byte moved into DR from the shift register. The (N)ACK of a received byte
+ * is the ACK bit when the byte ends, or with POS set, when the byte before it
+ * (or the address) ended, see RM0008 26.3.3.
+ */
+class i2c_model : public hal::steady_clock
+{
+public:
+  i2c_reg_t i2c{};
+  rcc_reg_t rcc{};
+  gpio_reg_t port{};
+  /// Bytes the device sends when read
+  std::vector<hal::byte> device_data;
+  /// Bytes the device was written
+  std::vector<hal::byte> received;
+  /// The device NACKs the written byte at this index of `received`
+  std::optional<std::size_t> nack_at;
+  /// SCL is held low once this many bytes went over the bus
+  std::optional<std::size_t> hold_at;
+  /// `error_flag` is raised once this many bytes went over the bus
+  std::optional<std::size_t> error_at;
+  std::uint32_t error_flag = 0;
+  /// Buffer the driver reads into
+  std::span<hal::byte> receive_buffer;
+  std::size_t bytes = 0;
+  std::string bus;
+  std::vector<std::string> faults;
+
+  void driver(stm32f1::i2c& p_driver)
+  {
+    m_driver = &p_driver;
+  }
+
+  /// Let go of SCL & forget the transfer in progress
+  void release()
+  {
+    hold_at.reset();
+    m_phase = phase::idle;
+    m_start_bit = false;
+    m_address_sent = false;
+    m_reading = false;
+    m_starting = false;
+  }
+
+private:
+  enum class phase : std::uint8_t
+  {
+    idle,
+    start,
+    address,
+    transmit,
+    receive,
+    nacked,
+  };
+
+  hal::hertz driver_frequency() override
+  {
+    return 1'000'000.0f;
+  }
+
+  hal::u64 driver_uptime() override
+  {
+    step();
+    return m_uptime++;
+  }
+
+  void log(char const* p_text)
+  {
+    bus += p_text;
+    bus += ' ';
+  }
+
+  void log(char p_prefix, hal::byte p_byte, bool p_ack)
+  {
+    std::array<char, 8> text{};
+    auto* end = text.data();
+    if (p_prefix != 0) {
+      *end++ = p_prefix;
+    }
+    std::snprintf(end, 4, "%02X%c", p_byte, p_ack ? '+' : '-');
+    log(text.data());
+  }
+
+  void fault(char const* p_text)
+  {
+    faults.emplace_back(p_text);
+  }
+
+  [[nodiscard]] std::uint32_t pending_events() const
+  {
+    std::uint32_t flags = 0;
+    if (m_start_bit) {
+      flags |= start_bit;
+    }
+    if (m_address_sent) {
+      flags |= address_sent;
+    }
+    if (m_phase == phase::transmit && not m_dr) {
+      flags |= transmit_empty;
+      if (not m_shift && m_byte_done) {
+        flags |= byte_transfer_finished;
+      }
+    }
+    if (m_reading && m_dr) {
+      flags |= receive_not_empty;
+      if (m_shift) {
+        flags |= byte_transfer_finished;
+      }
+    }
+
+    if ((i2c.cr2 & event_interrupt) == 0) {
+      return 0;
+    }
+    auto const buffer = (i2c.cr2 & buffer_interrupt) != 0;
+    if ((flags & (start_bit | address_sent | byte_transfer_finished)) != 0 ||
+        (buffer && (flags & (transmit_empty | receive_not_empty)) != 0)) {
+      return flags;
+    }
+    return 0;
+  }
+
+  void step()
+  {
+    if ((i2c.cr1 & (start | stop)) == (start | stop)) {
+      fault("START requested before the STOP went out");
+    }
+    if (m_driver == nullptr || (hold_at && bytes >= *hold_at)) {
+      return;
+    }
+    if (error_at && bytes >= *error_at && m_phase != phase::idle) {
+      error_at.reset();
+      // Arbitration lost & bus errors leave the bus to the other controller
+      m_phase = phase::idle;
+      m_reading = false;
+      raise_error(error_flag);
+      return;
+    }
+    // The bus runs on between interrupts, except where SCL is stretched
+    auto const flags = pending_events();
+    if (flags != 0 && not m_raised) {
+      m_raised = true;
+      raise_event(flags);
+      return;
+    }
+    m_raised = false;
+    advance();
+  }
+
+  void raise_error(std::uint32_t p_flags)
+  {
+    if ((i2c.cr2 & error_interrupt) == 0) {
+      fault("error interrupt disabled");
+      return;
+    }
+    i2c.sr1 = p_flags;
+    m_driver->handle_error();
+  }
+
+  void raise_event(std::uint32_t p_flags)
+  {
+    i2c.sr1 = p_flags;
+    i2c.dr = m_reading ? m_dr.value_or(0) : no_byte;
+    auto const ack_before = (i2c.cr1 & ack) != 0;
+    m_driver->handle_event();
+
+    if (p_flags & start_bit) {
+      if (i2c.dr == no_byte) {
+        fault("address not written after SB");
+        return;
+      }
+      m_start_bit = false;
+      m_address = static_cast<hal::byte>(i2c.dr);
+      m_phase = phase::address;
+      return;
+    }
+
+    if (p_flags & address_sent) {
+      // The driver reads SR2 after SR1, which clears ADDR
+      m_address_sent = false;
+      m_reading = (m_address & 1) != 0;
+      m_phase = m_reading ? phase::receive : phase::transmit;
+      m_ack_latch = ack_before;
+      m_reads = 0;
+      return;
+    }
+
+    if (m_phase == phase::transmit && i2c.dr != no_byte) {
+      if (m_dr) {
+        fault("DR written while full");
+      }
+      m_dr = static_cast<hal::byte>(i2c.dr);
+      m_byte_done = false;
+    }
+
+    if (m_reading) {
+      for (; m_reads < receive_buffer.size() &&
+             receive_buffer[m_reads] != unread;
+           m_reads++) {
+        if (not m_dr) {
+          fault("DR read while empty");
+          continue;
+        }
+        receive_buffer[m_reads] = *m_dr;
+        m_dr = m_shift;
+        m_shift.reset();
+      }
+    }
+  }
+
+  void start_condition()
+  {
+    // The START takes a step to go out, with the flags of the last byte set
+    if (not m_starting) {
+      m_starting = true;
+      return;
+    }
+    m_starting = false;
+    i2c.cr1 = i2c.cr1 & ~start;
+    log("S");
+    m_phase = phase::start;
+    m_start_bit = true;
+    m_reading = false;
+    m_dr.reset();
+    m_shift.reset();
+    m_byte_done = false;
+    m_sent = 0;
+  }
+
+  void stop_condition()
+  {
+    i2c.cr1 = i2c.cr1 & ~stop;
+    log("P");
+    m_phase = phase::idle;
+  }
+
+  void advance()
+  {
+    auto const control = i2c.cr1;
+    switch (m_phase) {
+      case phase::idle:
+      case phase::nacked:
+        if (control & start) {
+          start_condition();
+        } else if (control & stop) {
+          stop_condition();
+        }
+        break;
+      case phase::start:
+        break;
+      case phase::address: {
+        bytes++;
+        auto const acked = (m_address >> 1) == device_address;
+        log((m_address & 1) ? 'R' : 'W',
+            static_cast<hal::byte>(m_address >> 1),
+            acked);
+        if (acked) {
+          m_address_sent = true;
+          m_phase = phase::start;
+        } else {
+          m_phase = phase::nacked;
+          raise_error(acknowledge_failure);
+        }
+        break;
+      }
+      case phase::transmit:
+        if (m_shift) {
+          bytes++;
+          auto const acked = not(nack_at && received.size() == *nack_at);
+          received.push_back(*m_shift);
+          log(0, *m_shift, acked);
+          m_shift.reset();
+          m_byte_done = true;
+          if (not acked) {
+            m_phase = phase::nacked;
+            raise_error(acknowledge_failure);
+          }
+        } else if (control & start) {
+          start_condition();
+        } else if (control & stop) {
+          stop_condition();
+        } else if (m_dr) {
+          m_shift = m_dr;
+          m_dr.reset();
+        }
+        break;
+      case phase::receive: {
+        if (m_dr && m_shift) {
+          // BTF, SCL is stretched until DR is read
+          break;
+        }
+        bytes++;
+        hal::byte value = 0xEE;
+        if (m_sent < device_data.size()) {
+          value = device_data[m_sent++];
+        } else {
+          fault("read past the end of the device's data");
+        }
+        auto const ack_now = (control & ack) != 0;
+        auto const acked = (control & pos) ? m_ack_latch : ack_now;
+        m_ack_latch = ack_now;
+        log(0, value, acked);
+        (m_dr ? m_shift : m_dr) = value;
+        if (not acked) {
+          m_phase = phase::nacked;
+        }
+        if (control & stop) {
+          if (acked) {
+            fault("STOP after an ACKed byte");
+          }
+          stop_condition();
+        }
+        break;
+      }
+    }
+  }
+
+  stm32f1::i2c* m_driver = nullptr;
+  phase m_phase = phase::idle;
+  bool m_start_bit = false;
+  bool m_address_sent = false;
+  bool m_reading = false;
+  bool m_byte_done = false;
+  bool m_ack_latch = false;
+  bool m_raised = false;
+  bool m_starting = false;
+  hal::byte m_address = 0;
+  std::optional<hal::byte> m_dr;
+  std::optional<hal::byte> m_shift;
+  std::size_t m_reads = 0;
+  std::size_t m_sent = 0;
+  hal::u64 m_uptime = 0;
+};
+
+void no_timeout()
+{
+}
+
+/// Bytes the device sends, none of which are `unread`
+std::vector<hal::byte> device_bytes(std::size_t p_count)
+{
+  std::vector<hal::byte> result(p_count);
+  for (std::size_t i = 0; i < p_count; i++) {
+    result[i] = static_cast<hal::byte>(0x10 + i);
+  }
+  return result;
+}
+
+/// The bus log of a read of the given number of bytes, after its START
+std::string read_log(std::size_t p_count)
+{
+  std::string result = "R42+ ";
+  for (std::size_t i = 0; i < p_count; i++) {
+    std::array<char, 8> text{};
+    std::snprintf(text.data(),
+                  text.size(),
+                  "%02X%c ",
+                  static_cast<unsigned>(0x10 + i),
+                  i + 1 == p_count ? '-' : '+');
+    result += text.data();
+  }
+  return result + "P ";
+}
+
+struct fixture
+{
+  i2c_model model{};
+  stm32f1::i2c driver;
+
+  explicit fixture(hal::time_duration p_timeout = 1ms,
+                   hal::hertz p_clock_rate = 100'000.0f)
+    : driver(model.i2c,
+             model.rcc,
+             model.port,
+             model,
+             bus_clock,
+             p_timeout,
+             { .clock_rate = p_clock_rate })
+  {
+    model.driver(driver);
+  }
+
+  std::vector<hal::byte> read(std::size_t p_count)
+  {
+    model.device_data = device_bytes(p_count);
+    std::vector<hal::byte> in(p_count, unread);
+    model.receive_buffer = in;
+    driver.transaction(device_address, {}, in, no_timeout);
+    return in;
+  }
+
+  /// Runs the bus until the STOP, which goes out after a transaction returns
+  void settle()
+  {
+    for (int i = 0; i < 8; i++) {
+      model.uptime();
+    }
+  }
+};
+}  // namespace
+
+void i2c_test()
+{
+  using namespace boost::ut;
+
+  "i2c::i2c(...) clocks & configures the peripheral"_test = []() {
+    fixture standard;
+    expect((standard.model.rcc.apb2enr & rcc_enable::gpio_b) != 0U);
+    expect((standard.model.rcc.apb1enr & rcc_enable::i2c1) != 0U);
+    expect(standard.model.port.crl == 0xFF00'0000U);
+    expect((standard.model.i2c.cr2 & 0x3F) == 36U);
+    expect(standard.model.i2c.ccr == 180U);
+    expect(standard.model.i2c.trise == 37U);
+    expect(standard.model.i2c.cr1 == peripheral_enable);
+
+    fixture fast(1ms, 400'000.0f);
+    expect(fast.model.i2c.ccr == ((1U << 15) | 30U));
+    expect(fast.model.i2c.trise == 11U);
+
+    expect(throws<hal::operation_not_supported>(
+      [&]() { fast.driver.configure({ .clock_rate = 1'000'000.0f }); }));
+  };
+
+  "i2c::transaction() reads 1, 2, 3 & N bytes"_test = []() {
+    // Each length places the NACK & STOP differently
+    for (std::size_t count : { 1, 2, 3, 4, 5, 9 }) {
+      fixture bus;
+      auto const in = bus.read(count);
+      bus.settle();
+
+      expect(in == device_bytes(count)) << "count:" << count;
+      expect(bus.model.bus == "S " + read_log(count))
+        << "count:" << count;
+      expect(bus.model.faults.empty()) << "count:" << count;
+      expect((bus.model.i2c.cr2 & buffer_interrupt) == 0U);
+    }
+  };
+
+  "i2c::transaction() reads back to back"_test = []() {
+    fixture bus;
+    for (std::size_t count : { 3, 1, 2, 6 }) {
+      expect(bus.read(count) == device_bytes(count));
+      bus.model.bus.clear();
+      bus.model.device_data.clear();
+    }
+    bus.settle();
+    expect(bus.model.faults.empty());
+  };
+
+  "i2c::transaction() writes then reads with a repeated start"_test = []() {
+    fixture bus;
+    bus.model.device_data = device_bytes(3);
+    std::array<hal::byte const, 2> out{ 0xA0, 0x05 };
+    std::vector<hal::byte> in(3, unread);
+    bus.model.receive_buffer = in;
+
+    bus.driver.transaction(device_address, out, in, no_timeout);
+    bus.settle();
+
+    expect(bus.model.received == std::vector<hal::byte>{ 0xA0, 0x05 });
+    expect(in == device_bytes(3));
+    expect(bus.model.bus == "S W42+ A0+ 05+ S " + read_log(3));
+    expect(bus.model.faults.empty());
+  };
+
+  "i2c::transaction() writes & probes"_test = []() {
+    fixture bus;
+    std::array<hal::byte const, 3> out{ 0x01, 0x02, 0x03 };
+
+    bus.driver.transaction(device_address, out, {}, no_timeout);
+    bus.driver.transaction(device_address, {}, {}, no_timeout);
+    bus.settle();
+
+    expect(bus.model.received ==
+           std::vector<hal::byte>{ 0x01, 0x02, 0x03 });
+    expect(bus.model.bus == "S W42+ 01+ 02+ 03+ P S W42+ P ");
+    expect(bus.model.faults.empty());
+  };
+
+  "i2c::transaction() throws no_such_device on an address NACK"_test = []() {
+    fixture bus;
+    std::array<hal::byte const, 1> out{ 0x01 };
+
+    expect(throws<hal::no_such_device>(
+      [&]() { bus.driver.transaction(0x10, out, {}, no_timeout); }));
+    bus.settle();
+    expect(bus.model.bus == "S W10- P ");
+
+    // The bus is usable afterwards
+    bus.model.bus.clear();
+    expect(bus.read(2) == device_bytes(2));
+    bus.settle();
+    expect(bus.model.bus == "S " + read_log(2));
+    expect(bus.model.faults.empty());
+  };
+
+  "i2c::transaction() throws io_error on a data NACK"_test = []() {
+    fixture bus;
+    bus.model.nack_at = 1;
+    std::array<hal::byte const, 3> out{ 0x01, 0x02, 0x03 };
+
+    expect(throws<hal::io_error>(
+      [&]() { bus.driver.transaction(device_address, out, {}, no_timeout); }));
+    bus.settle();
+    expect(bus.model.bus == "S W42+ 01+ 02- P ");
+
+    bus.model.bus.clear();
+    bus.model.nack_at.reset();
+    bus.driver.transaction(device_address, out, {}, no_timeout);
+    bus.settle();
+    expect(bus.model.bus == "S W42+ 01+ 02+ 03+ P ");
+    expect(bus.model.faults.empty());
+  };
+
+  "i2c::transaction() resets the peripheral on bus errors"_test = []() {
+    for (auto const flag : { arbitration_lost, bus_error }) {
+      fixture bus;
+      // After the first byte of a read, while ACK is set
+      bus.model.error_at = 2;
+      bus.model.error_flag = flag;
+
+      expect(throws<hal::io_error>([&]() { bus.read(4); })) << "flag:" << flag;
+      expect(bus.model.i2c.cr1 == peripheral_enable);
+      expect((bus.model.i2c.cr2 & buffer_interrupt) == 0U);
+
+      bus.model.bus.clear();
+      expect(bus.read(4) == device_bytes(4));
+      bus.settle();
+      expect(bus.model.bus == "S " + read_log(4));
+      expect(bus.model.faults.empty());
+    }
+  };
+
+  "i2c::transaction() times out on a held clock"_test = []() {
+    fixture bus(1ms);
+    // SCL is held low after the address
+    bus.model.hold_at = 1;
+    std::array<hal::byte const, 2> out{ 0x01, 0x02 };
+
+    auto const before = bus.model.uptime();
+    expect(throws<hal::timed_out>(
+      [&]() { bus.driver.transaction(device_address, out, {}, no_timeout); }));
+    auto const waited = bus.model.uptime() - before;
+    expect(waited > 1000U);
+    expect(waited < 1100U);
+    expect(bus.model.i2c.cr1 == peripheral_enable);
+
+    bus.model.release();
+    bus.model.bus.clear();
+    bus.driver.transaction(device_address, out, {}, no_timeout);
+    bus.settle();
+    expect(bus.model.bus == "S W42+ 01+ 02+ P ");
+    expect(bus.model.faults.empty());
+  };
+
+  "i2c::transaction() times out on a STOP that never goes out"_test = []() {
+    fixture bus(1ms);
+    std::array<hal::byte const, 1> out{ 0x01 };
+    bus.driver.transaction(device_address, out, {}, no_timeout);
+    // SCL is held low before the STOP of the last transaction
+    bus.model.hold_at = bus.model.bytes;
+    expect((bus.model.i2c.cr1 & stop) != 0U);
+
+    auto const before = bus.model.uptime();
+    expect(throws<hal::timed_out>(
+      [&]() { bus.driver.transaction(device_address, out, {}, no_timeout); }));
+    auto const waited = bus.model.uptime() - before;
+    expect(waited > 1000U);
+    expect(waited < 1100U);
+    expect(bus.model.i2c.cr1 == peripheral_enable);
+    expect(bus.model.bus == "S W42+ 01+ ");
+
+    bus.model.release();
+    bus.model.bus.clear();
+    bus.driver.transaction(device_address, out, {}, no_timeout);
+    bus.settle();
+    expect(bus.model.bus == "S W42+ 01+ P ");
+    expect(bus.model.faults.empty());
+  };
+}
+}  // namespace hal::micromod
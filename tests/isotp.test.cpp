@@ -0,0 +1,479 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/can_statistics.hpp>
+#include <libhal-micromod/isotp.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+using namespace std::chrono_literals;
+
+constexpr hal::hertz clock_frequency = 1'000'000.0f;
+/// Bit time of a 500kbit/s bus in microseconds
+constexpr hal::u64 bit_time = 2;
+/// Microseconds the simulation advances by when no frame was sent
+constexpr hal::u64 idle_time = 10;
+/// Microseconds a transfer may take before the simulation gives up
+constexpr hal::u64 simulation_limit = 5'000'000;
+
+class model_clock : public hal::steady_clock
+{
+public:
+  hal::u64 now = 0;
+
+private:
+  hal::hertz driver_frequency() override
+  {
+    return clock_frequency;
+  }
+
+  hal::u64 driver_uptime() override
+  {
+    return now;
+  }
+};
+
+struct bus_frame
+{
+  /// Microseconds at the start of the frame
+  hal::u64 start;
+  hal::can_message message;
+};
+
+class model_node;
+
+/// Bus with two nodes, a frame reaches the other node as soon as it ends
+class model_bus
+{
+public:
+  void attach(model_node& p_node)
+  {
+    m_nodes.push_back(&p_node);
+  }
+
+  void send(model_node const& p_sender, hal::can_message const& p_message);
+
+  model_clock clock;
+  /// Every frame sent, including the lost ones
+  std::vector<bus_frame> frames;
+  /// Frames it returns true for never reach the other node
+  std::function<bool(bus_frame const&)> lose;
+
+private:
+  std::vector<model_node*> m_nodes;
+};
+
+class model_node final
+  : public hal::can_transceiver
+  , public hal::can_interrupt
+{
+public:
+  explicit model_node(model_bus& p_bus)
+    : m_bus(&p_bus)
+  {
+    m_bus->attach(*this);
+  }
+
+  void deliver(hal::can_message const& p_message)
+  {
+    if (m_handler) {
+      (*m_handler)(on_receive_tag{}, p_message);
+    }
+  }
+
+private:
+  hal::u32 driver_baud_rate() override
+  {
+    return 500'000;
+  }
+
+  void driver_send(hal::can_message const& p_message) override
+  {
+    m_bus->send(*this, p_message);
+  }
+
+  std::span<hal::can_message const> driver_receive_buffer() override
+  {
+    return {};
+  }
+
+  std::size_t driver_receive_cursor() override
+  {
+    return 0;
+  }
+
+  void driver_on_receive(optional_receive_handler const& p_handler) override
+  {
+    m_handler = p_handler;
+  }
+
+  model_bus* m_bus;
+  optional_receive_handler m_handler;
+};
+
+void model_bus::send(model_node const& p_sender,
+                     hal::can_message const& p_message)
+{
+  frames.push_back({ .start = clock.now, .message = p_message });
+  clock.now += can_frame_bits(p_message) * bit_time;
+  if (lose && lose(frames.back())) {
+    return;
+  }
+  for (auto* node : m_nodes) {
+    if (node != &p_sender) {
+      node->deliver(p_message);
+    }
+  }
+}
+
+/// Node A sends to node B over one channel, node B answers over the other
+struct channel_pair
+{
+  explicit channel_pair(isotp_settings const& p_a_settings = {},
+                        isotp_settings const& p_b_settings = {},
+                        bool p_extended = false)
+    : a(
+        {
+          .transmit_id = p_extended ? 0x18DA'00F1U : 0x7E0U,
+          .receive_id = p_extended ? 0x18DA'F100U : 0x7E8U,
+          .extended = p_extended,
+        },
+        p_a_settings)
+    , b(
+        {
+          .transmit_id = p_extended ? 0x18DA'F100U : 0x7E8U,
+          .receive_id = p_extended ? 0x18DA'00F1U : 0x7E0U,
+          .extended = p_extended,
+        },
+        p_b_settings)
+  {
+  }
+
+  /// Polls both routers until no transfer is busy
+  void run()
+  {
+    auto const busy = [](isotp_channel const& p_channel) {
+      return p_channel.transmit_status() == isotp_status::busy ||
+             p_channel.receive_status() == isotp_status::busy;
+    };
+    while ((busy(a) || busy(b)) && bus.clock.now < simulation_limit) {
+      auto const before = bus.clock.now;
+      router_a.poll();
+      router_b.poll();
+      if (bus.clock.now == before) {
+        bus.clock.now += idle_time;
+      }
+    }
+  }
+
+  /// Frames sent with the given identifier
+  std::vector<bus_frame> sent_by(isotp_channel const& p_channel) const
+  {
+    std::vector<bus_frame> sent;
+    std::ranges::copy_if(
+      bus.frames, std::back_inserter(sent), [&](bus_frame const& p_frame) {
+        return p_frame.message.id == p_channel.address().transmit_id;
+      });
+    return sent;
+  }
+
+  model_bus bus;
+  model_node node_a{ bus };
+  model_node node_b{ bus };
+  isotp_channel a;
+  isotp_channel b;
+  std::array<isotp_channel*, 1> a_channels{ &a };
+  std::array<isotp_channel*, 1> b_channels{ &b };
+  std::array<hal::can_message, 8> a_ring{};
+  std::array<hal::can_message, 8> b_ring{};
+  isotp_router router_a{ node_a, node_a, bus.clock, a_channels, a_ring };
+  isotp_router router_b{ node_b, node_b, bus.clock, b_channels, b_ring };
+};
+
+std::vector<hal::byte> pattern(std::size_t p_size)
+{
+  std::vector<hal::byte> bytes(p_size);
+  for (std::size_t i = 0; i < bytes.size(); i++) {
+    bytes[i] = static_cast<hal::byte>((i * 31) + (i >> 8) + 7);
+  }
+  return bytes;
+}
+
+/// Protocol control information of a frame
+hal::u8 frame_type(bus_frame const& p_frame)
+{
+  return p_frame.message.payload[0] >> 4;
+}
+
+/// Consecutive frames a message of the given length is split into
+std::size_t consecutive_frames(std::size_t p_size)
+{
+  auto const first_frame_data = p_size <= 0xFFF ? 6 : 2;
+  return (p_size - first_frame_data + 6) / 7;
+}
+}  // namespace
+
+void isotp_test()
+{
+  using namespace boost::ut;
+
+  "isotp sends short messages in one frame"_test = []() {
+    for (std::size_t size = 1; size <= 7; size++) {
+      for (bool const padded : { true, false }) {
+        isotp_settings settings{};
+        if (not padded) {
+          settings.padding = std::nullopt;
+        }
+        channel_pair pair(settings, settings);
+        std::vector<hal::byte> buffer(7);
+        auto const data = pattern(size);
+        pair.b.receive(buffer);
+        expect(pair.a.send(data));
+        pair.run();
+
+        expect(pair.a.transmit_status() == isotp_status::complete);
+        expect(pair.b.receive_status() == isotp_status::complete);
+        expect(std::ranges::equal(pair.b.received(), data));
+        expect(pair.bus.frames.size() == 1);
+        auto const& frame = pair.bus.frames.front().message;
+        expect(frame.payload[0] == size);
+        if (padded) {
+          expect(frame.length == 8);
+          expect(std::all_of(&frame.payload[size + 1],
+                             frame.payload.end(),
+                             [](hal::byte p_byte) { return p_byte == 0xCC; }));
+        } else {
+          expect(frame.length == size + 1);
+        }
+      }
+    }
+  };
+
+  "isotp sends long messages in consecutive frames"_test = []() {
+    for (std::size_t const size : { 8, 13, 62, 4095, 4096, 5000 }) {
+      channel_pair pair;
+      std::vector<hal::byte> buffer(size);
+      auto const data = pattern(size);
+      pair.b.receive(buffer);
+      expect(pair.a.send(data));
+      pair.run();
+
+      expect(pair.a.transmit_status() == isotp_status::complete);
+      expect(pair.b.receive_status() == isotp_status::complete);
+      expect(std::ranges::equal(pair.b.received(), data));
+
+      auto const from_a = pair.sent_by(pair.a);
+      auto const from_b = pair.sent_by(pair.b);
+      expect(from_a.size() == 1 + consecutive_frames(size));
+      expect(frame_type(from_a.front()) == 1);
+      if (size > 0xFFF) {
+        // The 32-bit escape sequence
+        expect(from_a.front().message.payload[1] == 0);
+      }
+      // One flow control frame without a block size
+      expect(from_b.size() == 1);
+      expect(frame_type(from_b.front()) == 3);
+      for (std::size_t i = 1; i < from_a.size(); i++) {
+        expect(from_a[i].message.payload[0] == (0x20 | (i & 0xF)));
+      }
+    }
+  };
+
+  "isotp honors the receiver's block size & separation time"_test = []() {
+    constexpr std::size_t size = 100;
+    constexpr hal::u8 block_size = 4;
+    constexpr hal::u64 separation = 500;
+    channel_pair pair(
+      {}, { .block_size = block_size, .separation_time = 500us });
+    std::vector<hal::byte> buffer(size);
+    auto const data = pattern(size);
+    pair.b.receive(buffer);
+    expect(pair.a.send(data));
+    pair.run();
+
+    expect(pair.b.receive_status() == isotp_status::complete);
+    expect(std::ranges::equal(pair.b.received(), data));
+
+    // 14 consecutive frames, flow control after the first frame & after each
+    // full block but the last
+    expect(pair.sent_by(pair.a).size() == 1 + 14);
+    expect(pair.sent_by(pair.b).size() == 1 + 3);
+
+    std::size_t in_block = 0;
+    bus_frame const* previous = nullptr;
+    for (auto const& frame : pair.bus.frames) {
+      if (frame.message.id == pair.b.address().transmit_id) {
+        in_block = 0;
+        previous = nullptr;
+        continue;
+      }
+      if (frame_type(frame) != 2) {
+        continue;
+      }
+      expect(++in_block <= block_size);
+      if (previous) {
+        auto const gap = frame.start - previous->start;
+        expect(gap >= separation);
+        expect(gap <= separation + idle_time);
+      }
+      previous = &frame;
+    }
+  };
+
+  "isotp moves messages both ways at once"_test = []() {
+    channel_pair pair({ .block_size = 8 }, { .block_size = 0 });
+    std::vector<hal::byte> a_buffer(4100);
+    std::vector<hal::byte> b_buffer(1500);
+    auto const a_data = pattern(1500);
+    auto const b_data = pattern(4100);
+    pair.a.receive(a_buffer);
+    pair.b.receive(b_buffer);
+    expect(pair.a.send(a_data));
+    expect(pair.b.send(b_data));
+    pair.run();
+
+    expect(pair.a.transmit_status() == isotp_status::complete);
+    expect(pair.b.transmit_status() == isotp_status::complete);
+    expect(std::ranges::equal(pair.b.received(), a_data));
+    expect(std::ranges::equal(pair.a.received(), b_data));
+    expect(pair.router_a.statistics().dropped == 0);
+    expect(pair.router_b.statistics().dropped == 0);
+  };
+
+  "isotp uses extended identifiers"_test = []() {
+    channel_pair pair({}, {}, true);
+    std::vector<hal::byte> buffer(300);
+    auto const data = pattern(300);
+    pair.b.receive(buffer);
+    expect(pair.a.send(data));
+    pair.run();
+
+    expect(std::ranges::equal(pair.b.received(), data));
+    expect(std::ranges::all_of(pair.bus.frames, [](bus_frame const& p_frame) {
+      return p_frame.message.extended;
+    }));
+  };
+
+  "isotp reports an overflow when the receiver's buffer is too small"_test =
+    []() {
+      channel_pair pair;
+      std::vector<hal::byte> buffer(50);
+      auto const data = pattern(100);
+      pair.b.receive(buffer);
+      expect(pair.a.send(data));
+      pair.run();
+
+      expect(pair.a.transmit_status() == isotp_status::overflow);
+      expect(pair.b.receive_status() == isotp_status::overflow);
+      expect(pair.b.received().empty());
+      // Only the first frame was sent
+      expect(pair.sent_by(pair.a).size() == 1);
+
+      channel_pair single;
+      std::vector<hal::byte> small(3);
+      auto const short_data = pattern(5);
+      single.b.receive(small);
+      expect(single.a.send(short_data));
+      single.run();
+      expect(single.b.receive_status() == isotp_status::overflow);
+      expect(single.b.received().empty());
+    };
+
+  "isotp refuses a message until the last one was taken"_test = []() {
+    channel_pair pair;
+    std::vector<hal::byte> buffer(100);
+    auto const first = pattern(100);
+    pair.b.receive(buffer);
+    expect(pair.a.send(first));
+    pair.run();
+    expect(pair.a.transmit_status() == isotp_status::complete);
+
+    auto const second = pattern(20);
+    expect(pair.a.send(second));
+    pair.run();
+    expect(pair.a.transmit_status() == isotp_status::overflow);
+    expect(std::ranges::equal(pair.b.received(), first));
+
+    pair.b.receive(buffer);
+    expect(pair.a.send(second));
+    pair.run();
+    expect(pair.a.transmit_status() == isotp_status::complete);
+    expect(std::ranges::equal(pair.b.received(), second));
+  };
+
+  "isotp reports a lost consecutive frame"_test = []() {
+    channel_pair pair;
+    std::vector<hal::byte> buffer(100);
+    auto const data = pattern(100);
+    pair.b.receive(buffer);
+    std::size_t consecutive = 0;
+    pair.bus.lose = [&consecutive](bus_frame const& p_frame) {
+      return frame_type(p_frame) == 2 && ++consecutive == 3;
+    };
+    expect(pair.a.send(data));
+    pair.run();
+
+    expect(pair.b.receive_status() == isotp_status::protocol_error);
+    expect(pair.b.received().empty());
+  };
+
+  "isotp times out without flow control"_test = []() {
+    channel_pair pair;
+    std::vector<hal::byte> buffer(100);
+    auto const data = pattern(100);
+    pair.b.receive(buffer);
+    pair.bus.lose = [&pair](bus_frame const& p_frame) {
+      return p_frame.message.id == pair.b.address().transmit_id;
+    };
+    expect(pair.a.send(data));
+    pair.run();
+
+    expect(pair.a.transmit_status() == isotp_status::timed_out);
+    expect(pair.b.receive_status() == isotp_status::timed_out);
+    expect(pair.sent_by(pair.a).size() == 1);
+    // Both ends give up after the 1s timeout
+    auto const timeout = hal::u64{ 1'000'000 };
+    expect(pair.bus.clock.now >= timeout);
+    expect(pair.bus.clock.now <= timeout + 1'000);
+  };
+
+  "isotp times out when the sender stops"_test = []() {
+    channel_pair pair;
+    std::vector<hal::byte> buffer(100);
+    auto const data = pattern(100);
+    pair.b.receive(buffer);
+    std::size_t consecutive = 0;
+    pair.bus.lose = [&consecutive](bus_frame const& p_frame) {
+      return frame_type(p_frame) == 2 && ++consecutive >= 5;
+    };
+    expect(pair.a.send(data));
+    pair.run();
+
+    expect(pair.a.transmit_status() == isotp_status::complete);
+    expect(pair.b.receive_status() == isotp_status::timed_out);
+  };
+}
+}  // namespace hal::micromod
@@ -0,0 +1,54 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+namespace hal::micromod {
+extern void acceptance_filter_test();
+extern void bit_bang_test();
+extern void can_capture_test();
+extern void can_filter_plan_test();
+extern void can_timestamp_test();
+extern void can_transmit_queue_test();
+extern void clock_sync_test();
+extern void dac_stream_test();
+extern void dma_spi_test();
+extern void dsp_test();
+extern void i2c_test();
+extern void isotp_test();
+extern void pwm_group_test();
+extern void tick_converter_test();
+extern void timer_pwm_test();
+extern void timer_wheel_test();
+extern void transmit_ring_test();
+}  // namespace hal::micromod
+
+int main()
+{
+  hal::micromod::acceptance_filter_test();
+  hal::micromod::bit_bang_test();
+  hal::micromod::can_capture_test();
+  hal::micromod::can_filter_plan_test();
+  hal::micromod::can_timestamp_test();
+  hal::micromod::can_transmit_queue_test();
+  hal::micromod::clock_sync_test();
+  hal::micromod::dac_stream_test();
+  hal::micromod::dma_spi_test();
+  hal::micromod::dsp_test();
+  hal::micromod::i2c_test();
+  hal::micromod::isotp_test();
+  hal::micromod::pwm_group_test();
+  hal::micromod::tick_converter_test();
+  hal::micromod::timer_pwm_test();
+  hal::micromod::timer_wheel_test();
+  hal::micromod::transmit_ring_test();
+}
@@ -0,0 +1,406 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "stm32f1/center_aligned_pwm.hpp"
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <libhal-micromod/micromod.hpp>
+#include <libhal/error.hpp>
+#include <libhal/lock.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+using namespace hal::micromod::stm32f1;
+
+constexpr hal::hertz timer_clock = 64'000'000.0f;
+/// Half a period at the default 20kHz
+constexpr hal::u32 default_top = 1'600;
+constexpr hal::u32 guard = center_aligned_pwm::guard_clocks;
+
+/**
+ * @brief TIM1, TIM2 & ADC2 counting in lockstep, clock by clock
+ *
+ * The counters run as the test says, & for lock_clocks each time the driver
+ * takes the lock, as the cpu would run on. Each update event loads the
+ * preloaded registers & is recorded with the values loaded. At the top the
+ * injected sequence converts, if triggered by TIM1 channel 4.
+ */
+class model_timers final : public hal::basic_lock
+{
+public:
+  struct update_event
+  {
+    /// The underflow at 0 starting a period, otherwise the top
+    bool underflow = false;
+    std::array<hal::u32, 2> prescalers{};
+    std::array<hal::u32, 2> tops{};
+    /// TIM1 channel 1 & TIM2 channel 2
+    std::array<hal::u32, 2> compares{};
+
+    bool operator==(update_event const&) const = default;
+  };
+
+  timer_reg_t master{};
+  timer_reg_t slave{};
+  adc_reg_t adc{};
+  hal::u32 lock_clocks = 3;
+  std::vector<update_event> updates;
+  hal::u32 conversions = 0;
+
+  void run(hal::u32 p_clocks)
+  {
+    for (hal::u32 i = 0; i < p_clocks; i++) {
+      tick();
+    }
+  }
+
+  /// Run until the counter is at p_count, counting down or up
+  void run_to(hal::u32 p_count, bool p_down)
+  {
+    do {
+      tick();
+    } while (master.cnt != p_count || down() != p_down);
+  }
+
+  [[nodiscard]] bool down() const
+  {
+    return (master.cr1 & timer_bits::direction_down) != 0;
+  }
+
+  /// Values the outputs run on now
+  [[nodiscard]] update_event const& active() const
+  {
+    return m_active;
+  }
+
+private:
+  void os_lock() override
+  {
+    run(lock_clocks);
+  }
+
+  void os_unlock() override
+  {
+  }
+
+  void tick()
+  {
+    if ((master.cr1 & timer_bits::counter_enable) == 0) {
+      m_started = false;
+      return;
+    }
+    if (not m_started) {
+      // The update generated before the counter was enabled
+      m_started = true;
+      m_counter = 0;
+      m_up = true;
+      m_ticks = 0;
+      load(false);
+    }
+    if (++m_ticks < m_active.prescalers[0]) {
+      return;
+    }
+    m_ticks = 0;
+    if (m_up) {
+      if (++m_counter == m_active.tops[0]) {
+        m_up = false;
+        convert();
+        load(false);
+        updates.push_back(m_active);
+      }
+    } else if (--m_counter == 0) {
+      m_up = true;
+      load(true);
+      updates.push_back(m_active);
+    }
+    for (auto* timer : { &master, &slave }) {
+      timer->cnt = m_counter;
+      timer->cr1 = m_up ? timer->cr1 & ~timer_bits::direction_down
+                        : timer->cr1 | timer_bits::direction_down;
+    }
+  }
+
+  void load(bool p_underflow)
+  {
+    m_active = {
+      .underflow = p_underflow,
+      .prescalers = { master.psc + 1, slave.psc + 1 },
+      .tops = { master.arr, slave.arr },
+      .compares = { master.ccr1, slave.ccr2 },
+    };
+  }
+
+  void convert()
+  {
+    if ((adc.cr2 & adc_bits::injected_external_trigger) == 0 ||
+        master.ccr4 != m_active.tops[0]) {
+      return;
+    }
+    // A bit above the 12 results, which the driver masks off
+    adc.jdr[0] = 0x1000 | (conversions & 0xFFF);
+    adc.jdr[1] = 4095 - (conversions & 0xFFF);
+    adc.sr = adc.sr | adc_bits::injected_end;
+    conversions++;
+  }
+
+  update_event m_active{};
+  hal::u32 m_counter = 0;
+  hal::u32 m_ticks = 0;
+  bool m_up = true;
+  bool m_started = false;
+};
+
+/// Compare value of a duty cycle of p_steps / p_top, high above it
+hal::u32 compare(hal::u32 p_steps, hal::u32 p_top)
+{
+  return p_steps == 0 ? p_top + 1 : p_top - p_steps;
+}
+
+float duty(hal::u32 p_steps, hal::u32 p_top)
+{
+  return static_cast<float>(p_steps) / static_cast<float>(p_top);
+}
+}  // namespace
+
+void pwm_group_test()
+{
+  using namespace boost::ut;
+
+  "starts both timers in lockstep at the default frequency, outputs low"_test =
+    []() {
+      model_timers model;
+      center_aligned_pwm pwm(
+        model.master, model.slave, model.adc, timer_clock, model);
+      constexpr auto mode =
+        timer_bits::pwm_mode_2 | timer_bits::output_compare_preload;
+
+      expect(pwm.frequency() == 20'000.0f);
+      expect(model.master.psc == 0 && model.slave.psc == 0);
+      expect(model.master.arr == default_top);
+      expect(model.slave.arr == default_top);
+      expect(model.master.ccr1 == default_top + 1);
+      expect(model.slave.ccr2 == default_top + 1);
+      expect(model.master.ccr4 == default_top);
+      expect(model.master.ccmr1 == mode);
+      expect(model.slave.ccmr1 == mode << 8);
+      expect(model.master.ccer == timer_bits::compare_output_enable);
+      expect(model.slave.ccer == timer_bits::compare_output_enable << 4);
+      expect(model.master.bdtr == timer_bits::main_output_enable);
+      expect(model.master.cr2 == timer_bits::master_mode_enable);
+      expect(model.slave.smcr == timer_bits::slave_mode_trigger);
+      expect(model.master.cr1 ==
+             (timer_bits::center_aligned_1 | timer_bits::auto_reload_preload |
+              timer_bits::counter_enable));
+      // Started by TIM1's trigger output
+      expect((model.slave.cr1 & timer_bits::counter_enable) == 0);
+      expect(model.adc.jsqr == adc_bits::injected_pair(8, 9));
+
+      model.run(2 * default_top);
+      expect(model.updates.size() == 2);
+      expect(not model.updates[0].underflow);
+      expect(model.updates[1].underflow);
+      expect(model.updates[1].compares ==
+             std::array{ default_top + 1, default_top + 1 });
+    };
+
+  "commits wait for the counter to count down, clear of both ends"_test =
+    []() {
+      model_timers model;
+      center_aligned_pwm pwm(
+        model.master, model.slave, model.adc, timer_clock, model);
+      auto const in_window = [&model]() {
+        return model.down() && model.master.cnt >= guard &&
+               model.master.cnt <= default_top - guard;
+      };
+
+      // Counting down mid period, written at once
+      model.run_to(800, true);
+      pwm.duty_cycles({ 0.5f, 0.5f });
+      expect(in_window());
+      expect(model.master.cnt == 800 - model.lock_clocks);
+      expect(pwm.statistics().waits == 0);
+
+      // Counting up, the next update event would be the top
+      model.run_to(800, false);
+      pwm.duty_cycles({ 0.25f, 0.5f });
+      expect(in_window());
+      // As soon as the counter is clear of the top
+      expect(model.master.cnt + model.lock_clocks > default_top - guard);
+      expect(pwm.statistics().waits == 1);
+
+      // Counting down but too close to the underflow to be sure of making it
+      model.run_to(guard - 1, true);
+      auto const updates = model.updates.size();
+      pwm.duty_cycles({ 0.75f, 0.5f });
+      expect(in_window());
+      // Through the underflow & the top
+      expect(model.updates.size() == updates + 2);
+      expect(pwm.statistics().waits == 2);
+
+      // Just past the top
+      model.run_to(default_top - 1, true);
+      pwm.duty_cycles({ 1.0f, 0.5f });
+      expect(in_window());
+      expect(pwm.statistics().waits == 3);
+      expect(pwm.statistics().commits == 4);
+    };
+
+  "a period runs on one set of values, from the underflow after a commit"_test =
+    []() {
+      std::mt19937 random(11);
+      model_timers model;
+      center_aligned_pwm pwm(
+        model.master, model.slave, model.adc, timer_clock, model);
+
+      struct commit
+      {
+        /// Update events before the commit returned
+        std::size_t updates;
+        std::array<hal::u32, 2> compares;
+      };
+      std::vector<commit> commits;
+      for (int i = 0; i < 300; i++) {
+        model.run(static_cast<hal::u32>(random() % (3 * default_top)));
+        auto const first = static_cast<hal::u32>(random() % (default_top + 1));
+        auto const second =
+          static_cast<hal::u32>(random() % (default_top + 1));
+        pwm.duty_cycles(
+          { duty(first, default_top), duty(second, default_top) });
+        commits.push_back({ .updates = model.updates.size(),
+                            .compares = { compare(first, default_top),
+                                          compare(second, default_top) } });
+      }
+      model.run(4 * default_top);
+
+      auto const& updates = model.updates;
+      for (std::size_t i = 1; i < updates.size(); i++) {
+        // The top loads nothing new, so both halves of a pulse match
+        if (not updates[i].underflow) {
+          expect(updates[i].compares == updates[i - 1].compares);
+        }
+        expect(updates[i].tops == std::array{ default_top, default_top });
+      }
+      std::size_t reached = 0;
+      for (std::size_t i = 0; i < commits.size(); i++) {
+        auto next = commits[i].updates;
+        while (not updates[next].underflow) {
+          next++;
+        }
+        // Unless overwritten by the next commit before the underflow
+        if (i + 1 == commits.size() || commits[i + 1].updates > next) {
+          expect(updates[next].compares == commits[i].compares);
+          reached++;
+        }
+      }
+      expect(reached > commits.size() / 2);
+    };
+
+  "a new frequency starts at an underflow with the duty cycles kept"_test =
+    []() {
+      model_timers model;
+      center_aligned_pwm pwm(
+        model.master, model.slave, model.adc, timer_clock, model);
+      pwm.duty_cycles({ duty(400, default_top), duty(1'200, default_top) });
+      model.run(3 * default_top);
+
+      pwm.frequency(10'000.0f);
+      expect(pwm.frequency() == 10'000.0f);
+      auto const updates = model.updates.size();
+      model.run(6 * 2 * default_top);
+      auto first = updates;
+      while (model.updates[first].tops[0] != 2 * default_top) {
+        expect(model.updates[first].tops[0] == default_top);
+        first++;
+      }
+      expect(model.updates[first].underflow);
+      for (auto i = first; i < model.updates.size(); i++) {
+        expect(model.updates[i].tops ==
+               std::array{ 2 * default_top, 2 * default_top });
+        expect(model.updates[i].compares == std::array<hal::u32, 2>{
+                                              2'400, 800 });
+      }
+      expect(model.master.ccr4 == 2 * default_top);
+
+      // 320000 clocks a half period, too many for a 16-bit top
+      pwm.frequency(100.0f);
+      expect(model.master.psc == 4 && model.slave.psc == 4);
+      expect(model.master.arr == 64'000 && model.slave.arr == 64'000);
+      expect(model.master.ccr4 == 64'000);
+      expect(model.master.ccr1 == 48'000);
+      expect(model.slave.ccr2 == 16'000);
+      expect(pwm.statistics().commits == 3);
+    };
+
+  "a control loop in the center sample handler drives the next period"_test =
+    []() {
+      model_timers model;
+      center_aligned_pwm pwm(
+        model.master, model.slave, model.adc, timer_clock, model);
+      std::vector<pwm_center_sample> samples;
+      // Update events seen when each commit returned
+      std::vector<std::size_t> committed;
+      pwm.on_center_sample([&](pwm_center_sample const& p_sample) {
+        samples.push_back(p_sample);
+        auto const steps = (p_sample.period * 37) % default_top;
+        pwm.duty_cycles(
+          { duty(steps, default_top), duty(default_top - steps, default_top) });
+        committed.push_back(model.updates.size());
+      });
+
+      // Nothing converted yet
+      pwm.handle_interrupt();
+      expect(samples.empty());
+      for (int i = 0; i < 40 * 16; i++) {
+        // The ADC interrupt is taken within 100 clocks of the conversion
+        model.run(100);
+        pwm.handle_interrupt();
+      }
+
+      expect(samples.size() == model.conversions);
+      expect(pwm.statistics().samples == model.conversions);
+      expect(samples.size() >= 19);
+      for (hal::u32 i = 0; i < samples.size(); i++) {
+        expect(samples[i].period == i);
+        expect(samples[i].a0 == (i & 0xFFF));
+        expect(samples[i].a1 == 4095 - (i & 0xFFF));
+        // Converted at the top, committed before the underflow ending the
+        // same period, which loads the loop's output
+        auto const underflow = committed[i];
+        if (underflow < model.updates.size()) {
+          auto const steps = (i * 37) % default_top;
+          expect(model.updates[underflow].underflow);
+          expect(model.updates[underflow].compares ==
+                 std::array{ compare(steps, default_top),
+                             compare(default_top - steps, default_top) });
+        }
+      }
+    };
+
+  "synchronized_pwm() & pwm0() or pwm1() exclude each other"_test = []() {
+    expect(nothrow([]() { static_cast<void>(v1::pwm0()); }));
+    expect(throws<hal::device_or_resource_busy>(
+      []() { static_cast<void>(v1::synchronized_pwm()); }));
+    // Still available to the outputs
+    expect(nothrow([]() { static_cast<void>(v1::pwm1()); }));
+    expect(throws<hal::device_or_resource_busy>(
+      []() { static_cast<void>(v1::synchronized_pwm()); }));
+  };
+}
+}  // namespace hal::micromod
@@ -0,0 +1,62 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/tick_converter.hpp>
+
+#include <array>
+#include <cstdint>
+#include <random>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+void tick_converter_test()
+{
+  using namespace boost::ut;
+
+  "tick_converter matches exact division"_test = []() {
+    std::mt19937_64 random(9);
+    bool matches = true;
+    for (hal::u64 const frequency :
+         { 1'000'000, 12'000'000, 32'768, 48'000'000, 72'000'000, 96'000'000,
+           120'000'000, 7 }) {
+      tick_converter const to_time(static_cast<hal::hertz>(frequency));
+      for (int i = 0; i < 10'000; i++) {
+        // Up to a year of ticks, some of them whole microseconds
+        auto ticks = random() % (frequency * 31'536'000);
+        if (i % 2 == 0) {
+          ticks -= ticks % frequency;
+        }
+        auto const exact = static_cast<unsigned __int128>(ticks);
+        matches = matches &&
+                  to_time.microseconds(ticks) ==
+                    static_cast<hal::u64>(exact * 1'000'000 / frequency) &&
+                  to_time.nanoseconds(ticks) ==
+                    static_cast<hal::u64>(exact * 1'000'000'000 / frequency);
+      }
+    }
+    expect(matches);
+  };
+
+  "tick_converter keeps whole units"_test = []() {
+    tick_converter const to_time(12'000'000.0f);
+
+    expect(to_time.microseconds(12) == 1);
+    expect(to_time.microseconds(11) == 0);
+    expect(to_time.microseconds(12'345'678 * 12) == 12'345'678);
+    expect(to_time.nanoseconds(3) == 250);
+    expect(to_time.duration(12'000) == std::chrono::milliseconds(1));
+  };
+}
+}  // namespace hal::micromod
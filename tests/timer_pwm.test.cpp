@@ -0,0 +1,224 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "stm32f1/timer_pwm.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+using namespace hal::micromod::stm32f1;
+
+constexpr hal::hertz timer_clock = 72'000'000.0f;
+/// Register contents left by whatever owned the timer before
+constexpr std::uint32_t stale = 0xFFFF;
+constexpr std::uint32_t channel_mode =
+  timer_bits::pwm_mode_1 | timer_bits::output_compare_preload;
+
+timer_reg_t stale_timer()
+{
+  timer_reg_t timer{};
+  timer.cr1 = stale;
+  timer.dier = stale;
+  timer.ccmr1 = stale;
+  timer.ccmr2 = stale;
+  timer.ccer = stale;
+  timer.cnt = stale;
+  timer.bdtr = stale;
+  timer.ccr1 = stale;
+  timer.ccr2 = stale;
+  timer.ccr3 = stale;
+  timer.ccr4 = stale;
+  return timer;
+}
+
+/// Counter ticks of a period, as the timer counts them
+std::uint32_t ticks(timer_reg_t const& p_timer)
+{
+  return (p_timer.psc + 1) * (p_timer.arr + 1);
+}
+}  // namespace
+
+void timer_pwm_test()
+{
+  using namespace boost::ut;
+
+  "starts counting at the default frequency with every output off"_test =
+    []() {
+      auto timer = stale_timer();
+      {
+        pwm_timer pwm(timer, timer_clock, true);
+        // 72000 ticks, the smallest prescaler fitting them in 16 bits is 2
+        expect(timer.psc == 1);
+        expect(timer.arr == 35'999);
+        expect(pwm.period() == 36'000);
+        expect(pwm.frequency() == 1'000.0f);
+        expect(timer.cr1 == (timer_bits::auto_reload_preload |
+                             timer_bits::counter_enable));
+        expect(timer.dier == 0);
+        expect(timer.ccmr1 == 0);
+        expect(timer.ccmr2 == 0);
+        expect(timer.ccer == 0);
+        expect(timer.cnt == 0);
+        expect(timer.egr == timer_bits::update_generation);
+        expect(timer.sr == 0);
+        expect(timer.bdtr == timer_bits::main_output_enable);
+      }
+      expect(timer.cr1 == 0);
+      expect(timer.ccer == 0);
+
+      // Only TIM1 has the main output enable
+      auto general = stale_timer();
+      pwm_timer pwm(general, timer_clock, false);
+      expect(general.bdtr == stale);
+    };
+
+  "enable selects preloaded pwm mode 1 at a 0% duty cycle"_test = []() {
+    auto timer = stale_timer();
+    pwm_timer pwm(timer, timer_clock, false);
+    pwm.enable(2);
+    expect(timer.ccmr1 == channel_mode << 8);
+    expect(timer.ccer == 1U << 4);
+    expect(timer.ccr2 == 0);
+
+    pwm.enable(1);
+    pwm.enable(4);
+    expect(timer.ccmr1 == (channel_mode | (channel_mode << 8)));
+    expect(timer.ccmr2 == channel_mode << 8);
+    expect(timer.ccer == ((1U << 0) | (1U << 4) | (1U << 12)));
+    expect(timer.ccr1 == 0);
+    expect(timer.ccr4 == 0);
+    // Not enabled, but the constructor clears every compare value
+    expect(timer.ccr3 == 0);
+  };
+
+  "duty cycles set the compare value, limited to 0% to 100%"_test = []() {
+    auto timer = stale_timer();
+    pwm_timer pwm(timer, timer_clock, false);
+    pwm.enable(1);
+    pwm.enable(3);
+
+    pwm.duty_cycle(1, 0.25f);
+    expect(timer.ccr1 == 9'000);
+    pwm.duty_cycle(3, 1.0f);
+    expect(timer.ccr3 == 36'000);
+    pwm.duty_cycle(3, 1.5f);
+    expect(timer.ccr3 == 36'000);
+    pwm.duty_cycle(1, -0.5f);
+    expect(timer.ccr1 == 0);
+    // Rounded to the nearest tick
+    pwm.duty_cycle(1, 1.0f / 3.0f);
+    expect(timer.ccr1 == 12'000);
+    pwm.duty_cycle(1, 0.5f / 36'000.0f);
+    expect(timer.ccr1 == 1);
+  };
+
+  "frequency takes the smallest prescaler & the nearest period"_test = []() {
+    auto timer = stale_timer();
+    pwm_timer pwm(timer, timer_clock, false);
+
+    pwm.frequency(20'000.0f);
+    expect(timer.psc == 0);
+    expect(timer.arr == 3'599);
+
+    // Half the clock, the fastest with two duty cycle steps
+    pwm.frequency(36'000'000.0f);
+    expect(timer.psc == 0);
+    expect(timer.arr == 1);
+    pwm.frequency(100'000'000.0f);
+    expect(timer.psc == 0);
+    expect(timer.arr == 1);
+
+    // 72e6 / 65535 = 1098.6, so a prescaler of 1099
+    pwm.frequency(1.0f);
+    expect(timer.psc == 1'098);
+    expect(timer.arr == 65'513);
+    // The slowest the 16-bit prescaler & counter reach
+    pwm.frequency(0.001f);
+    expect(timer.psc == 65'535);
+    expect(timer.arr == 65'534);
+    expect(pwm.frequency() == timer_clock / 65'536.0f / 65'535.0f);
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> exponent(0.0f, 7.5f);
+    for (int i = 0; i < 1'000; i++) {
+      auto const frequency = std::pow(10.0f, exponent(random));
+      pwm.frequency(frequency);
+      auto const prescaler = timer.psc + 1;
+      auto const wanted = timer_clock / frequency;
+      expect(timer.arr + 1 >= 2 && timer.arr + 1 <= 65'535);
+      // A prescaler one smaller would not fit the period
+      expect(prescaler == 1 ||
+             wanted / static_cast<float>(prescaler - 1) > 65'535.0f);
+      // Within half a prescaled tick of the period asked for
+      expect(std::abs(static_cast<float>(ticks(timer)) - wanted) <=
+             (static_cast<float>(prescaler) / 2.0f) + (wanted * 1e-6f));
+      expect(pwm.period() == timer.arr + 1);
+    }
+  };
+
+  "frequency rescales every channel's compare value & clears UDIS"_test =
+    []() {
+      auto timer = stale_timer();
+      pwm_timer pwm(timer, timer_clock, true);
+      for (std::uint8_t channel = 1; channel <= 4; channel++) {
+        pwm.enable(channel);
+      }
+      pwm.duty_cycle(1, 0.1f);
+      pwm.duty_cycle(2, 0.25f);
+      pwm.duty_cycle(3, 0.5f);
+      pwm.duty_cycle(4, 1.0f);
+      expect(timer.ccr1 == 3'600);
+
+      // Bits of CR1 that are not the driver's are kept
+      timer.cr1 = timer.cr1 | timer_bits::one_pulse;
+      pwm.frequency(20'000.0f);
+      expect(timer.ccr1 == 360);
+      expect(timer.ccr2 == 900);
+      expect(timer.ccr3 == 1'800);
+      expect(timer.ccr4 == 3'600);
+      // Updates are enabled again once every register is written
+      expect(timer.cr1 == (timer_bits::auto_reload_preload |
+                           timer_bits::one_pulse | timer_bits::counter_enable));
+
+      pwm.frequency(1.0f);
+      expect(timer.ccr1 == 6'551);
+      expect(timer.ccr4 == 65'514);
+      expect((timer.cr1 & timer_bits::update_disable) == 0);
+    };
+
+  "timer_pwm drives its own channel & the timer's frequency"_test = []() {
+    auto timer = stale_timer();
+    pwm_timer shared(timer, timer_clock, false);
+    timer_pwm first(shared, 1);
+    timer_pwm second(shared, 2);
+    expect(timer.ccer == ((1U << 0) | (1U << 4)));
+
+    first.duty_cycle(0.5f);
+    second.duty_cycle(0.75f);
+    expect(timer.ccr1 == 18'000);
+    expect(timer.ccr2 == 27'000);
+
+    // Through either channel, for both
+    second.frequency(10'000.0f);
+    expect(timer.arr == 7'199);
+    expect(timer.ccr1 == 3'600);
+    expect(timer.ccr2 == 5'400);
+  };
+}
+}  // namespace hal::micromod
@@ -0,0 +1,274 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/timer_wheel.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+using namespace std::chrono_literals;
+
+/// 1MHz clock the test sets by hand
+class model_clock : public hal::steady_clock
+{
+public:
+  hal::u64 now = 0;
+
+private:
+  hal::hertz driver_frequency() override
+  {
+    return 1'000'000.0f;
+  }
+
+  hal::u64 driver_uptime() override
+  {
+    return now;
+  }
+};
+
+/// One shot timer fired by the test once the clock reaches its deadline
+class model_timer : public hal::timer
+{
+public:
+  explicit model_timer(model_clock& p_clock)
+    : m_clock(&p_clock)
+  {
+  }
+
+  std::optional<hal::u64> deadline;
+  hal::callback<void(void)> callback = []() {};
+  std::size_t schedules = 0;
+
+private:
+  bool driver_is_running() override
+  {
+    return deadline.has_value();
+  }
+
+  void driver_cancel() override
+  {
+    deadline.reset();
+  }
+
+  void driver_schedule(hal::callback<void(void)> p_callback,
+                       hal::time_duration p_delay) override
+  {
+    callback = p_callback;
+    deadline = m_clock->now + static_cast<hal::u64>((p_delay.count() + 999) /
+                                                    1000);
+    schedules++;
+  }
+
+  model_clock* m_clock;
+};
+
+class null_lock : public hal::basic_lock
+{
+private:
+  void os_lock() override
+  {
+  }
+
+  void os_unlock() override
+  {
+  }
+};
+
+/**
+ * @brief Timer wheel on the model clock & timer, with 1ms ticks
+ *
+ * The timer interrupt can be made late by `latency` clock ticks.
+ */
+struct wheel_model
+{
+  model_clock clock;
+  model_timer timer{ clock };
+  null_lock lock;
+  timer_wheel wheel{ clock, timer, lock, 1ms, 100ms };
+  hal::u64 latency = 0;
+
+  /// Fire the timer each time it is due, up to the given uptime
+  void run_until(hal::u64 p_uptime)
+  {
+    while (timer.deadline && *timer.deadline + latency <= p_uptime) {
+      clock.now = std::max(clock.now, *timer.deadline + latency);
+      timer.deadline.reset();
+      auto const callback = timer.callback;
+      callback();
+    }
+    clock.now = std::max(clock.now, p_uptime);
+  }
+};
+
+/// Clock ticks of a delay at 1MHz
+constexpr hal::u64 ticks(hal::time_duration p_delay)
+{
+  return static_cast<hal::u64>(p_delay.count() / 1000);
+}
+}  // namespace
+
+void timer_wheel_test()
+{
+  using namespace boost::ut;
+
+  "timer_wheel cascades timeouts down every level"_test = []() {
+    wheel_model model;
+    // Within the first level, on level boundaries, in each higher level &
+    // beyond the top level's range of 64^4 ticks.
+    std::vector<hal::time_duration> const delays{
+      1ms,     2ms,      63ms,     64ms,       65ms,       4095ms,
+      4096ms,  4097ms,   5000ms,   262'143ms,  262'144ms,  300'001ms,
+      16'777'215ms, 16'777'216ms, 17'000'000ms,
+    };
+    std::vector<std::optional<hal::u64>> expired(delays.size());
+    std::vector<std::unique_ptr<timeout>> timeouts;
+    for (std::size_t i = 0; i < delays.size(); i++) {
+      timeouts.push_back(std::make_unique<timeout>(
+        [&model, &expired, i]() { expired[i] = model.clock.now; }));
+      model.wheel.schedule(*timeouts[i], delays[i]);
+    }
+
+    model.run_until(ticks(17'000'001ms));
+
+    for (std::size_t i = 0; i < delays.size(); i++) {
+      expect(expired[i] == ticks(delays[i]));
+      expect(not timeouts[i]->is_pending());
+    }
+    // Nothing left to wake up for
+    expect(not model.timer.deadline.has_value());
+  };
+
+  "timer_wheel rounds up to the next tick"_test = []() {
+    wheel_model model;
+    model.clock.now = 400;
+    std::optional<hal::u64> expired;
+    timeout timeout([&]() { expired = model.clock.now; });
+
+    model.wheel.schedule(timeout, 1500us);
+    model.run_until(ticks(10ms));
+
+    // Due at 1.9ms, the first tick at or after it
+    expect(expired == ticks(2ms));
+  };
+
+  "timer_wheel cancels timeouts"_test = []() {
+    wheel_model model;
+    std::size_t first = 0;
+    std::size_t second = 0;
+    timeout first_timeout([&first]() { first++; });
+    timeout second_timeout([&second]() { second++; });
+    std::optional<std::size_t> destroyed_calls;
+
+    model.wheel.schedule(first_timeout, 10ms);
+    model.wheel.schedule(second_timeout, 5000ms);
+    {
+      std::size_t calls = 0;
+      timeout destroyed([&calls]() { calls++; });
+      model.wheel.schedule(destroyed, 20ms);
+      // Destroying a pending timeout cancels it
+    }
+    model.wheel.cancel(second_timeout);
+    expect(not second_timeout.is_pending());
+    // Cancelling a timeout that is not pending does nothing
+    model.wheel.cancel(second_timeout);
+
+    model.run_until(ticks(6000ms));
+
+    expect(first == 1);
+    expect(second == 0);
+    expect(not model.timer.deadline.has_value());
+    expect(model.wheel.time_until_next_event() ==
+           hal::time_duration::max());
+  };
+
+  "timer_wheel moves a pending timeout when scheduled again"_test = []() {
+    wheel_model model;
+    std::vector<hal::u64> expired;
+    timeout timeout([&]() { expired.push_back(model.clock.now); });
+
+    model.wheel.schedule(timeout, 3000ms);
+    model.wheel.schedule(timeout, 70ms);
+    model.run_until(ticks(4000ms));
+
+    expect(expired == std::vector<hal::u64>{ ticks(70ms) });
+  };
+
+  "timer_wheel reschedules without drifting"_test = []() {
+    wheel_model model;
+    // Every timer interrupt comes 3ms late
+    model.latency = ticks(3ms);
+    std::vector<hal::u64> expired;
+    timeout periodic([&]() {
+      expired.push_back(model.clock.now);
+      if (expired.size() < 5) {
+        model.wheel.reschedule(periodic, 10ms);
+      }
+    });
+
+    model.wheel.schedule(periodic, 10ms);
+    model.run_until(ticks(100ms));
+
+    // The handlers run late, their period does not
+    expect(expired == std::vector<hal::u64>{ ticks(13ms),
+                                             ticks(23ms),
+                                             ticks(33ms),
+                                             ticks(43ms),
+                                             ticks(53ms) });
+  };
+
+  "timer_wheel catches up a timeout that fell behind"_test = []() {
+    wheel_model model;
+    std::vector<hal::u64> expired;
+    timeout periodic([&]() {
+      expired.push_back(model.clock.now);
+      if (expired.size() == 1) {
+        // The handler is busy for longer than two periods
+        model.clock.now += ticks(25ms);
+      }
+      if (expired.size() < 3) {
+        model.wheel.reschedule(periodic, 10ms);
+      }
+    });
+
+    model.wheel.schedule(periodic, 10ms);
+    model.run_until(ticks(100ms));
+
+    // Due at 20ms, expired once on the next tick after the handler returned
+    // rather than in a burst, then a period from there
+    expect(expired == std::vector<hal::u64>{ ticks(10ms),
+                                             ticks(36ms),
+                                             ticks(46ms) });
+  };
+
+  "timer_wheel handlers may schedule timeouts"_test = []() {
+    wheel_model model;
+    std::optional<hal::u64> second_expired;
+    timeout second([&]() { second_expired = model.clock.now; });
+    timeout first([&]() { model.wheel.schedule(second, 150ms); });
+
+    model.wheel.schedule(first, 5ms);
+    model.run_until(ticks(1000ms));
+
+    expect(second_expired == ticks(155ms));
+  };
+}
+}  // namespace hal::micromod
@@ -0,0 +1,257 @@
+// Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-micromod/transmit_ring.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal::micromod {
+namespace {
+class null_lock : public hal::basic_lock
+{
+private:
+  void os_lock() override
+  {
+  }
+
+  void os_unlock() override
+  {
+  }
+};
+
+/**
+ * @brief Byte by byte model of the ring & its overflow policies
+ *
+ * Bytes take the ring's positions in the order they are accepted, so the
+ * model knows where the next claim must stop at the end of the buffer.
+ */
+struct ring_model
+{
+  std::size_t capacity;
+  overflow_policy policy;
+  std::deque<hal::byte> pending{};
+  std::size_t claimed = 0;
+  transmit_statistics statistics{};
+
+  std::size_t free() const
+  {
+    return capacity - claimed - pending.size();
+  }
+
+  std::size_t write(std::span<hal::byte const> p_data)
+  {
+    if (policy == overflow_policy::block) {
+      auto const accepted = std::min(free(), p_data.size());
+      accept(p_data.first(accepted));
+      return accepted;
+    }
+
+    auto data = p_data;
+    if (policy == overflow_policy::drop_oldest) {
+      if (data.size() > capacity) {
+        statistics.dropped += data.size() - capacity;
+        data = data.last(capacity);
+      }
+      // Dropping pending bytes only makes room when no claim sits before them
+      if (claimed == 0 && data.size() > free()) {
+        auto const dropped = std::min(pending.size(), data.size() - free());
+        pending.erase(pending.begin(), pending.begin() + dropped);
+        statistics.dropped += dropped;
+      }
+    }
+
+    auto const accepted = std::min(free(), data.size());
+    accept(data.first(accepted));
+    statistics.dropped += data.size() - accepted;
+    return p_data.size();
+  }
+
+  void accept(std::span<hal::byte const> p_data)
+  {
+    pending.insert(pending.end(), p_data.begin(), p_data.end());
+    statistics.written += p_data.size();
+    statistics.peak = std::max(statistics.peak, claimed + pending.size());
+  }
+
+  /// Position of the first pending byte in the buffer
+  std::size_t unsent() const
+  {
+    return (statistics.written - pending.size()) % capacity;
+  }
+};
+
+std::vector<hal::byte> sequence(std::size_t p_size, hal::byte p_first)
+{
+  std::vector<hal::byte> data(p_size);
+  for (auto& byte : data) {
+    byte = p_first++;
+  }
+  return data;
+}
+
+std::vector<hal::byte> to_vector(std::span<hal::byte const> p_data)
+{
+  return { p_data.begin(), p_data.end() };
+}
+}  // namespace
+
+void transmit_ring_test()
+{
+  using namespace boost::ut;
+
+  "transmit_ring block accepts only what fits"_test = []() {
+    std::array<hal::byte, 8> buffer{};
+    null_lock lock;
+    transmit_ring ring(buffer, lock, overflow_policy::block);
+    auto const data = sequence(12, 0);
+
+    expect(ring.write(data) == 8);
+    expect(ring.write(data) == 0);
+    expect(to_vector(ring.claim()) == sequence(8, 0));
+    ring.release();
+    expect(ring.write(std::span(data).subspan(8)) == 4);
+
+    auto const statistics = ring.statistics();
+    expect(statistics.written == 12);
+    expect(statistics.dropped == 0);
+    expect(statistics.peak == 8);
+  };
+
+  "transmit_ring drop_newest keeps the oldest bytes"_test = []() {
+    std::array<hal::byte, 8> buffer{};
+    null_lock lock;
+    transmit_ring ring(buffer, lock, overflow_policy::drop_newest);
+
+    expect(ring.write(sequence(12, 0)) == 12);
+    expect(to_vector(ring.claim()) == sequence(8, 0));
+    expect(ring.statistics().dropped == 4);
+  };
+
+  "transmit_ring drop_oldest keeps the newest bytes"_test = []() {
+    std::array<hal::byte, 8> buffer{};
+    null_lock lock;
+    transmit_ring ring(buffer, lock, overflow_policy::drop_oldest);
+
+    expect(ring.write(sequence(6, 0)) == 6);
+    expect(ring.write(sequence(4, 6)) == 4);
+    // Dropped 0 & 1, the rest wraps around the end of the buffer
+    expect(to_vector(ring.claim()) == sequence(6, 2));
+    ring.release();
+    expect(to_vector(ring.claim()) == sequence(2, 8));
+    ring.release();
+
+    expect(ring.write(sequence(20, 0)) == 20);
+    expect(ring.size() == 8);
+    expect(ring.statistics().dropped == 14);
+  };
+
+  "transmit_ring drop_oldest never drops claimed bytes"_test = []() {
+    std::array<hal::byte, 8> buffer{};
+    null_lock lock;
+    transmit_ring ring(buffer, lock, overflow_policy::drop_oldest);
+
+    ring.write(sequence(4, 0));
+    auto const claim = ring.claim();
+    ring.write(sequence(4, 4));
+    // No room can be made while the claim is outstanding, so the new bytes
+    // are dropped rather than both the pending & the new bytes
+    expect(ring.write(sequence(2, 8)) == 2);
+
+    expect(to_vector(claim) == sequence(4, 0));
+    ring.release();
+    expect(to_vector(ring.claim()) == sequence(4, 4));
+    expect(ring.statistics().dropped == 2);
+  };
+
+  "transmit_ring reserves space in place"_test = []() {
+    std::array<hal::byte, 8> buffer{};
+    null_lock lock;
+    transmit_ring ring(buffer, lock, overflow_policy::block);
+
+    auto space = ring.reserve(5);
+    expect(space.size() == 5);
+    expect(space.data() == buffer.data());
+    // Nothing is transmitted before it is committed
+    expect(ring.claim().empty());
+    // Reserving again returns the same space
+    expect(ring.reserve(5).data() == space.data());
+    std::ranges::copy(sequence(5, 0), space.begin());
+    ring.commit(3);
+
+    expect(to_vector(ring.claim()) == sequence(3, 0));
+    ring.release();
+    // The space at the end of the buffer stops short of wrapping
+    expect(ring.reserve(8).size() == 5);
+  };
+
+  "transmit_ring matches the policy model"_test = []() {
+    constexpr std::size_t capacity = 37;
+    std::array<hal::byte, capacity> buffer{};
+    null_lock lock;
+    std::mt19937 random(2025);
+
+    for (auto const policy : { overflow_policy::block,
+                               overflow_policy::drop_newest,
+                               overflow_policy::drop_oldest }) {
+      transmit_ring ring(buffer, lock, policy);
+      ring_model model{ .capacity = capacity, .policy = policy };
+      std::vector<hal::byte> claim;
+      hal::byte next = 0;
+      bool matches = true;
+
+      for (int step = 0; step < 20'000 && matches; step++) {
+        auto const action = random() % 8;
+        if (action < 4) {
+          auto const data = sequence(random() % (capacity + 10), next);
+          next += static_cast<hal::byte>(data.size());
+          matches = ring.write(data) == model.write(data);
+        } else if (action < 6) {
+          auto const claimed = ring.claim();
+          if (not claim.empty() || model.pending.empty()) {
+            matches = claimed.empty();
+            continue;
+          }
+          auto const length =
+            std::min(model.pending.size(), capacity - model.unsent());
+          claim.assign(model.pending.begin(), model.pending.begin() + length);
+          model.pending.erase(model.pending.begin(),
+                              model.pending.begin() + length);
+          model.claimed = length;
+          matches = to_vector(claimed) == claim;
+        } else {
+          ring.release();
+          claim.clear();
+          model.claimed = 0;
+        }
+
+        auto const statistics = ring.statistics();
+        auto const held = model.claimed + model.pending.size();
+        matches = matches && ring.size() == held &&
+                  statistics.written == model.statistics.written &&
+                  statistics.dropped == model.statistics.dropped &&
+                  statistics.peak == model.statistics.peak;
+      }
+
+      expect(matches);
+    }
+  };
+}
+}  // namespace hal::micromod
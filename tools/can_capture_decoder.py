@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+#
+# Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Convert can_capture binary batches into a candump log.
+
+Reads batches written by `can_capture::drain()` with
+`can_capture_format::binary` from a file, a serial device already configured
+with `stty`, or stdin, and writes candump log lines that canplayer can replay:
+
+    stty -F /dev/ttyUSB0 2000000 raw
+    can_capture_decoder.py /dev/ttyUSB0 > capture.log
+    canplayer -I capture.log vcan0=can0
+
+Dropped messages are reported as `# dropped N` comment lines where they were
+lost, and the totals are printed to stderr when the input ends.
+"""
+
+import argparse
+import sys
+
+
+def cobs_decode(frame):
+    output = bytearray()
+    index = 0
+    while index < len(frame):
+        code = frame[index]
+        if code == 0 or index + code > len(frame) + 1:
+            raise ValueError("invalid COBS code")
+        output += frame[index + 1:index + code]
+        index += code
+        if code < 0xFF and index < len(frame):
+            output.append(0)
+    return bytes(output)
+
+
+class Reader:
+    def __init__(self, payload):
+        self.payload = payload
+        self.index = 0
+
+    def remaining(self):
+        return len(self.payload) - self.index
+
+    def bytes(self, length):
+        if self.index + length > len(self.payload):
+            raise ValueError("batch is too short")
+        value = self.payload[self.index:self.index + length]
+        self.index += length
+        return value
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            (byte,) = self.bytes(1)
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if byte < 0x80:
+                return value
+
+
+def decode_batch(payload):
+    """Return the first sequence number and the records of a batch."""
+    reader = Reader(payload)
+    sequence = reader.varint()
+    reader.varint()  # Dropped so far, the sequence numbers show where
+    time = reader.varint()
+    records = []
+    while reader.remaining():
+        (flags,) = reader.bytes(1)
+        length = flags & 0x0F
+        extended = bool(flags & 0x10)
+        remote = bool(flags & 0x20)
+        identifier = int.from_bytes(reader.bytes(4 if extended else 2),
+                                    "little")
+        data = b"" if remote else reader.bytes(length)
+        time += reader.varint()
+        records.append((time, identifier, extended, remote, data))
+    return sequence, records
+
+
+def candump_line(record):
+    time, identifier, extended, remote, data = record
+    name = f"{identifier:08X}" if extended else f"{identifier:03X}"
+    body = "R" if remote else data.hex().upper()
+    return f"({time // 1_000_000:010d}.{time % 1_000_000:06d}) can0 " \
+           f"{name}#{body}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", nargs="?", default="-",
+                        help="file or serial device to read, default stdin")
+    arguments = parser.parse_args()
+
+    source = (sys.stdin.buffer if arguments.input == "-"
+              else open(arguments.input, "rb", buffering=0))
+
+    expected = None
+    received = 0
+    dropped = 0
+    bad = 0
+    frame = bytearray()
+    while True:
+        data = source.read1(4096) if hasattr(source, "read1") else \
+            source.read(4096)
+        if not data:
+            break
+        for byte in data:
+            if byte != 0:
+                frame.append(byte)
+                continue
+            if not frame:
+                continue
+            try:
+                sequence, records = decode_batch(cobs_decode(frame))
+            except ValueError as error:
+                bad += 1
+                print(f"# bad batch: {error}", flush=True)
+                frame.clear()
+                continue
+            frame.clear()
+
+            if expected is None:
+                expected = sequence
+            if sequence != expected:
+                gap = (sequence - expected) & 0xFFFFFFFF
+                dropped += gap
+                print(f"# dropped {gap}")
+            for record in records:
+                print(candump_line(record))
+            received += len(records)
+            expected = (sequence + len(records)) & 0xFFFFFFFF
+        sys.stdout.flush()
+
+    print(f"{received} messages, {dropped} dropped, {bad} bad batches",
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+#
+# Copyright 2024 - 2025 Khalil Estell and the libhal contributors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Decode LIBHAL_MICROMOD_LOG() frames back into text.
+
+The format strings are read from the `.micromod_log` section of the
+application's ELF file. Frames are read from a file, a serial device already
+configured with `stty`, or stdin:
+
+    stty -F /dev/ttyUSB0 115200 raw
+    deferred_log_decoder.py app.elf /dev/ttyUSB0
+
+    ./app | deferred_log_decoder.py app
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SECTION = ".micromod_log"
+
+CONVERSION = re.compile(
+    r"%(?P<flags>[-+ #0]*)(?P<width>[0-9]*)(?P<precision>\.[0-9]*)?"
+    r"(?P<length>hh|h|ll|l|j|z|t|L)?(?P<conversion>[diuxXopcfFeEgGaAs%])")
+
+
+def read_section(path):
+    """Return the contents of the log section of an ELF file."""
+    with open(path, "rb") as elf:
+        data = elf.read()
+
+    if data[:4] != b"\x7fELF":
+        sys.exit(f"{path} is not an ELF file")
+    is_64_bit = data[4] == 2
+    endian = "<" if data[5] == 1 else ">"
+
+    if is_64_bit:
+        (offset,) = struct.unpack_from(endian + "Q", data, 0x28)
+        entry_size, count, names_index = struct.unpack_from(
+            endian + "HHH", data, 0x3A)
+        header = endian + "IIQQQQIIQQ"
+    else:
+        (offset,) = struct.unpack_from(endian + "I", data, 0x20)
+        entry_size, count, names_index = struct.unpack_from(
+            endian + "HHH", data, 0x2E)
+        header = endian + "IIIIIIIIII"
+
+    sections = [struct.unpack_from(header, data, offset + i * entry_size)
+                for i in range(count)]
+    names = sections[names_index]
+    for section in sections:
+        name_start = names[4] + section[0]
+        name = data[name_start:data.index(b"\0", name_start)].decode()
+        if name == SECTION:
+            return data[section[4]:section[4] + section[5]]
+
+    sys.exit(f"{path} has no {SECTION} section, is LIBHAL_MICROMOD_LOG used?")
+
+
+def cobs_decode(frame):
+    output = bytearray()
+    index = 0
+    while index < len(frame):
+        code = frame[index]
+        if code == 0 or index + code > len(frame) + 1:
+            raise ValueError("invalid COBS code")
+        output += frame[index + 1:index + code]
+        index += code
+        if code < 0xFF and index < len(frame):
+            output.append(0)
+    return bytes(output)
+
+
+class Reader:
+    def __init__(self, payload):
+        self.payload = payload
+        self.index = 0
+
+    def byte(self):
+        if self.index >= len(self.payload):
+            raise ValueError("frame is too short")
+        value = self.payload[self.index]
+        self.index += 1
+        return value
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            byte = self.byte()
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if byte < 0x80:
+                return value
+
+    def bytes(self, length):
+        if self.index + length > len(self.payload):
+            raise ValueError("frame is too short")
+        value = self.payload[self.index:self.index + length]
+        self.index += length
+        return value
+
+
+def format_message(strings, payload):
+    reader = Reader(payload)
+    identifier = reader.varint()
+    if identifier >= len(strings):
+        raise ValueError(f"unknown format string {identifier}")
+    end = strings.index(b"\0", identifier)
+    fmt = strings[identifier:end].decode(errors="replace")
+
+    def convert(match):
+        conversion = match["conversion"]
+        spec = "%" + match["flags"] + match["width"] + (match["precision"] or "")
+        if conversion == "%":
+            return "%"
+        if match["length"] == "hh" and conversion in "diuxXo":
+            value = reader.byte()
+            if conversion in "di":
+                return (spec + "d") % (value - 256 if value > 127 else value)
+            return (spec + conversion.replace("u", "d")) % value
+        if conversion in "di":
+            value = reader.varint()
+            return (spec + "d") % ((value >> 1) ^ -(value & 1))
+        if conversion in "uxXo":
+            return (spec + conversion.replace("u", "d")) % reader.varint()
+        if conversion == "p":
+            return (spec + "s") % hex(reader.varint())
+        if conversion == "c":
+            return (spec + "c") % reader.byte()
+        if conversion == "s":
+            text = reader.bytes(reader.varint())
+            return (spec + "s") % text.decode(errors="replace")
+        (value,) = struct.unpack("<f", reader.bytes(4))
+        if conversion in "aA":
+            # Drop the trailing zeros of the mantissa, as printf does
+            mantissa, exponent = value.hex().split("p")
+            text = mantissa.rstrip("0").rstrip(".") + "p" + exponent
+            return text.upper() if conversion == "A" else text
+        return (spec + conversion) % value
+
+    text = CONVERSION.sub(convert, fmt)
+    if reader.index != len(payload):
+        raise ValueError("frame is too long")
+    return text
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="application ELF file")
+    parser.add_argument("input", nargs="?", default="-",
+                        help="file or serial device to read, default stdin")
+    arguments = parser.parse_args()
+
+    strings = read_section(arguments.elf)
+    source = (sys.stdin.buffer if arguments.input == "-"
+              else open(arguments.input, "rb", buffering=0))
+
+    frame = bytearray()
+    while True:
+        data = source.read1(256) if hasattr(source, "read1") else \
+            source.read(256)
+        if not data:
+            break
+        for byte in data:
+            if byte != 0:
+                frame.append(byte)
+                continue
+            if frame:
+                try:
+                    message = format_message(strings, cobs_decode(frame))
+                except ValueError as error:
+                    message = f"<bad frame {bytes(frame).hex()}: {error}>"
+                # One frame per line, unless the format string ends one
+                print(message, end="" if message.endswith("\n") else "\n",
+                      flush=True)
+            frame.clear()
+
+
+if __name__ == "__main__":
+    main()